@@ -21,6 +21,15 @@ which is a subclass of the Qt framework's QMainWindow class.  The TUIO servers
 stay up for the duration of the program run, but the output can be shut ON/OFF
 at runtime through the Network menu.
 
+When the TouchHooks2Tuio program has created the shared-memory pointer event
+ring (see CreatePointerEventRing()), the pointer events are written into that
+ring instead: each record holds the pointer id, the event type, the full 
+32-bit pixel coordinates and the input timestamp from GetPointerInfo().  Only
+the first event after the consumer has gone idle posts a single 
+UWM_CUSTOM_POINTERRING message, and it is posted to the consumer's window 
+rather than broadcast to every top-level window on the desktop.  The old 
+HWND_BROADCAST messages are still used when no ring is available.
+
 Note that backwards compatibility to the older Windows 7 touch has not been
 implemented here.  This class only works for Windows 8 touch messages.
 *******************************************************************************/
@@ -57,6 +66,9 @@ static void attachGlobalMouseHook();
 static void processPointerDownFrame( LPMSG );
 static void processPointerUpdateFrame( LPMSG );
 static void processPointerUpFrame( LPMSG );
+static void attachPointerEventRing();
+static void detachPointerEventRing();
+static bool pushPointerEvent( LPMSG, UINT32 );
 static void processTouchFrame( LPMSG );
 static bool removeTouchHook();
 static bool removeMouseHook();
@@ -68,6 +80,7 @@ extern HMODULE  g_this;
 extern HHOOK    g_globalTouchHook;
 extern HHOOK    g_globalMouseHook;
 extern DWORD    g_consoleId;
+extern HWND     g_pointerRingWindow;
 
 bool s_isWriteConsoleAttached( false );
 bool s_isMouseHookInitialized( false );
@@ -77,15 +90,22 @@ const int char_buffer_size( 256 );
 char  s_buf[char_buffer_size] = "";
 DWORD s_ccount( 0 );
 
+// Per-process view of the shared pointer event ring (not in the shared segment).
+HANDLE s_pointerRingMapping( 0 );
+TouchHookPointerRing * s_pointerRing( 0 );
+HWND s_pointerRingWindow( 0 );
+
 const UINT UWM_CUSTOM_POINTERDOWN   = RegisterWindowMessage( (LPCTSTR)"UWM_CUSTOM_POINTERDOWN_MSG-C20773FF-A3AD-14d4-A30B-133027716D94" );
 const UINT UWM_CUSTOM_POINTERUPDATE = RegisterWindowMessage( (LPCTSTR)"UWM_CUSTOM_POINTERUPDATE_MSG-B20673FE-D3AD-31d4-A05B-164027715D94" );
 const UINT UWM_CUSTOM_POINTERUP     = RegisterWindowMessage( (LPCTSTR)"UWM_CUSTOM_POINTERUP_MSG-A20473FF-D3AC-17d4-A77B-167028716993" );
+const UINT UWM_CUSTOM_POINTERRING   = RegisterWindowMessage( (LPCTSTR)"UWM_CUSTOM_POINTERRING_MSG-D20873FF-A3AE-19d4-A11B-177027716D95" );
 const UINT UWM_CUSTOM_TOUCH         = RegisterWindowMessage( (LPCTSTR)"UWM_CUSTOM_TOUCH_MSG-E257E26FF-D3AF-71d4-A42B-157027716D92" );
 const UINT UWM_CUSTOM_TIMER         = RegisterWindowMessage( (LPCTSTR)"UWM_CUSTOM_TIMER_MSG-F20773FF-D34D-18d4-A89B-137027716D98" );
 
 TOUCHHOOK_API unsigned int UwmCustomPointerDown()   { return UWM_CUSTOM_POINTERDOWN; }
 TOUCHHOOK_API unsigned int UwmCustomPointerUpdate() { return UWM_CUSTOM_POINTERUPDATE; }
 TOUCHHOOK_API unsigned int UwmCustomPointerUp()     { return UWM_CUSTOM_POINTERUP; }
+TOUCHHOOK_API unsigned int UwmCustomPointerRing()   { return UWM_CUSTOM_POINTERRING; }
 TOUCHHOOK_API unsigned int UwmCustomTouch()         { return UWM_CUSTOM_TOUCH; }
 TOUCHHOOK_API unsigned int UwmCustomTimer()         { return UWM_CUSTOM_TIMER; }
 
@@ -168,22 +188,148 @@ LRESULT CALLBACK LowLevelMouseProc( int nCode, WPARAM wParam, LPARAM lParam )
 
 static void processPointerDownFrame( LPMSG msg )
 {
+    if( pushPointerEvent( msg, TOUCHHOOK_POINTER_DOWN ) ) { return; }
+
     BOOL ok = PostMessage( HWND_BROADCAST, UWM_CUSTOM_POINTERDOWN, msg->wParam, msg->lParam );
     //printPostMessageInfo( "UWM_CUSTOM_POINTERDOWN", msg, ok );
 }
 
 static void processPointerUpdateFrame( LPMSG msg )
 {
+    if( pushPointerEvent( msg, TOUCHHOOK_POINTER_UPDATE ) ) { return; }
+
     BOOL ok = PostMessage( HWND_BROADCAST, UWM_CUSTOM_POINTERUPDATE, msg->wParam, msg->lParam );
     //printPostMessageInfo( "UWM_CUSTOM_POINTERUPDATE", msg, ok );
 }
 
 static void processPointerUpFrame( LPMSG msg )
 {
+    if( pushPointerEvent( msg, TOUCHHOOK_POINTER_UP ) ) { return; }
+
     BOOL ok = PostMessage( HWND_BROADCAST, UWM_CUSTOM_POINTERUP, msg->wParam, msg->lParam );
     //printPostMessageInfo( "UWM_CUSTOM_POINTERUP", msg, ok );
 }
 
+/**
+ * Writes the pointer event into the shared-memory ring.  Returns false only
+ * if there is no ring, in which case the caller falls back on broadcasting
+ * the old custom message.  If the ring is full the event is dropped (the
+ * ring counts it) rather than broadcast, so events never arrive out of order.
+ */
+static bool pushPointerEvent( LPMSG msg, UINT32 eventType )
+{
+    attachPointerEventRing();
+
+    if( s_pointerRing == 0 ) {
+        return false;
+    }
+    TouchHookPointerEvent event;
+    POINTER_INFO info;
+    event.pointerId = GET_POINTERID_WPARAM( msg->wParam );
+    event.eventType = eventType;
+
+    if( GetPointerInfo( event.pointerId, &info ) ) {
+        event.frameId = info.frameId;
+        event.x = info.ptPixelLocation.x;
+        event.y = info.ptPixelLocation.y;
+        event.pointerType = (UINT32)info.pointerType;
+        event.timestamp = (INT64)info.PerformanceCount;
+    }
+    else {
+        POINTS p = MAKEPOINTS( msg->lParam );
+        event.frameId = 0;
+        event.x = p.x;
+        event.y = p.y;
+        event.pointerType = 0;
+        event.timestamp = 0;
+    }
+    if( event.timestamp == 0 ) {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter( &now );
+        event.timestamp = now.QuadPart;
+    }
+    if( s_pointerRing->tryPush( event ) && s_pointerRing->claimWakeup() ) {
+        PostMessage( s_pointerRingWindow, UWM_CUSTOM_POINTERRING, 0, 0 );
+    }
+    return true;
+}
+
+/**
+ * Opens (or re-opens) this process's view of the pointer event ring whenever
+ * the consumer window registered by TouchHooks2Tuio has changed.  This is a
+ * single comparison for every event after the first one.
+ */
+static void attachPointerEventRing()
+{
+    if( s_pointerRingWindow == g_pointerRingWindow ) {
+        return;
+    }
+    detachPointerEventRing();
+    s_pointerRingWindow = g_pointerRingWindow;
+
+    if( s_pointerRingWindow != 0 ) {
+        s_pointerRingMapping = OpenFileMappingA( FILE_MAP_ALL_ACCESS, FALSE, TOUCHHOOK_POINTER_RING_NAME );
+
+        if( s_pointerRingMapping != 0 ) {
+            s_pointerRing = (TouchHookPointerRing *)MapViewOfFile( s_pointerRingMapping, FILE_MAP_ALL_ACCESS, 
+                                                                   0, 0, sizeof( TouchHookPointerRing ) );
+            if( s_pointerRing != 0 && !s_pointerRing->isInitialized() ) {
+                detachPointerEventRing();
+            }
+        }
+    }
+}
+
+static void detachPointerEventRing()
+{
+    if( s_pointerRing != 0 ) {
+        UnmapViewOfFile( s_pointerRing );
+        s_pointerRing = 0;
+    }
+    if( s_pointerRingMapping != 0 ) {
+        CloseHandle( s_pointerRingMapping );
+        s_pointerRingMapping = 0;
+    }
+}
+
+/**
+ * Called by the TouchHooks2Tuio program (the consumer) to create and 
+ * initialize the shared-memory ring.  The consumerWindow receives a single
+ * UWM_CUSTOM_POINTERRING message whenever new events arrive in an empty ring.
+ * Returns 0 if the ring could not be created.
+ */
+TOUCHHOOK_API TouchHookPointerRing * CreatePointerEventRing( HWND consumerWindow )
+{
+    ClosePointerEventRing();
+
+    s_pointerRingMapping = CreateFileMappingA( INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, 
+                                               0, sizeof( TouchHookPointerRing ), 
+                                               TOUCHHOOK_POINTER_RING_NAME );
+    if( s_pointerRingMapping == 0 ) {
+        return 0;
+    }
+    s_pointerRing = (TouchHookPointerRing *)MapViewOfFile( s_pointerRingMapping, FILE_MAP_ALL_ACCESS, 
+                                                           0, 0, sizeof( TouchHookPointerRing ) );
+    if( s_pointerRing == 0 || !s_pointerRing->initialize() ) {
+        detachPointerEventRing();
+        return 0;
+    }
+    s_pointerRingWindow = consumerWindow;
+    g_pointerRingWindow = consumerWindow;
+    return s_pointerRing;
+}
+
+/**
+ * Tells the hooked processes to stop using the ring (they detach on their
+ * next pointer event) and releases the consumer's view of it.
+ */
+TOUCHHOOK_API void ClosePointerEventRing()
+{
+    g_pointerRingWindow = 0;
+    s_pointerRingWindow = 0;
+    detachPointerEventRing();
+}
+
 /**
  * Windows 7 touch is not supported.
  */
@@ -36,6 +36,7 @@ Windows emulated mouse events (generated by touches):  LLMHF_INJECTED
 #define WINVER 0x0602
 #define WIN32_LEAN_AND_MEAN  // Exclude rarely-used stuff from Windows headers.
 #include <Windows.h>
+#include "SharedRingBuffer.h"
 
 // The following ifdef block is the standard way of creating macros which make
 // exporting from a DLL simpler. All files within this DLL are compiled with 
@@ -50,13 +51,54 @@ Windows emulated mouse events (generated by touches):  LLMHF_INJECTED
 #define TOUCHHOOK_API __declspec(dllimport)
 #endif
 
+// Event types stored in TouchHookPointerEvent::eventType.
+#define TOUCHHOOK_POINTER_DOWN    1
+#define TOUCHHOOK_POINTER_UPDATE  2
+#define TOUCHHOOK_POINTER_UP      3
+
+#define TOUCHHOOK_POINTER_RING_CAPACITY 4096
+#define TOUCHHOOK_POINTER_RING_NAME "Local\\TouchHooks2Tuio-PointerEventRing-C30773FF-B3AD-1Ad4"
+
+/**
+ * One pointer event as written by the hook into the shared-memory ring.
+ * Fixed-width fields only, so 32-bit and 64-bit processes agree on layout.
+ * The coordinates are full 32-bit screen pixels (not the 16-bit POINTS
+ * packed into lParam), and the timestamp is the QueryPerformanceCounter
+ * value at which Windows generated the input.  pointerType is the
+ * POINTER_INFO.pointerType (PT_TOUCH, PT_PEN, ...), or 0 if unknown.
+ */
+struct TouchHookPointerEvent
+{
+    UINT32 pointerId;
+    UINT32 eventType;
+    UINT32 frameId;
+    INT32  x;
+    INT32  y;
+    UINT32 pointerType;
+    INT64  timestamp;
+};
+
+/**
+ * The ring shared between all hooked processes (producers) and the
+ * TouchHooks2Tuio program (the single consumer).  Declared as a struct so
+ * that it can be forward declared.
+ */
+struct TouchHookPointerRing :
+    public TUIO::SharedRingBuffer<TouchHookPointerEvent, TOUCHHOOK_POINTER_RING_CAPACITY>
+{
+};
+
 // Public API
 TOUCHHOOK_API unsigned int UwmCustomPointerDown();
 TOUCHHOOK_API unsigned int UwmCustomPointerUpdate();
 TOUCHHOOK_API unsigned int UwmCustomPointerUp();
+TOUCHHOOK_API unsigned int UwmCustomPointerRing();
 TOUCHHOOK_API unsigned int UwmCustomTouch();
 TOUCHHOOK_API unsigned int UwmCustomTimer();
 
+TOUCHHOOK_API TouchHookPointerRing * CreatePointerEventRing( HWND consumerWindow );
+TOUCHHOOK_API void ClosePointerEventRing();
+
 TOUCHHOOK_API void SetConsoleId( DWORD consoleId );
 TOUCHHOOK_API bool InstallGlobalTouchHook();
 TOUCHHOOK_API bool RemoveGlobalTouchHook();
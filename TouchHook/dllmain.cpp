@@ -29,6 +29,7 @@ HMODULE  g_this( 0 );
 HHOOK    g_globalTouchHook( 0 );
 HHOOK    g_globalMouseHook( 0 );
 DWORD    g_consoleId( 0 );
+HWND     g_pointerRingWindow( 0 );
 #pragma data_seg()
 #pragma comment(linker, "/SECTION:.SHARED,RWS")
 
@@ -42,12 +42,14 @@ CREATED: 6/17/2015
 using hooksCore::TouchHooks2Tuio;
 
 TouchHooks2Tuio::TouchHooks2Tuio() :
-  useGlobalTouchHook_( false )
+  useGlobalTouchHook_( false ),
+  pointerEventRing_( 0 )
 {
 }
 
 TouchHooks2Tuio::~TouchHooks2Tuio()
 {
+    closePointerEventRing();
 }
 
 void TouchHooks2Tuio::initializeConsolePidForDebugging( int consolePid )
@@ -87,6 +89,11 @@ unsigned int TouchHooks2Tuio::getUwmCustomPointerUp()
     return UwmCustomPointerUp();
 }
 
+unsigned int TouchHooks2Tuio::getUwmCustomPointerRing()
+{
+    return UwmCustomPointerRing();
+}
+
 unsigned int TouchHooks2Tuio::getUwmCustomTouched()
 {
     return UwmCustomTouch();
@@ -96,3 +103,27 @@ unsigned int TouchHooks2Tuio::getUwmCustomTimer()
 {
     return UwmCustomTimer();
 }
+
+/**
+ * Creates the shared-memory ring that the hook DLL writes pointer events
+ * into.  The consumerWindow (the HWND of the main window) is sent a single
+ * wakeup message whenever events arrive in an empty ring.
+ */
+bool TouchHooks2Tuio::openPointerEventRing( void * consumerWindow )
+{
+    pointerEventRing_ = CreatePointerEventRing( (HWND)consumerWindow );
+    return (pointerEventRing_ != 0);
+}
+
+void TouchHooks2Tuio::closePointerEventRing()
+{
+    if( pointerEventRing_ != 0 ) {
+        ClosePointerEventRing();
+        pointerEventRing_ = 0;
+    }
+}
+
+TouchHookPointerRing * TouchHooks2Tuio::pointerEventRing()
+{
+    return pointerEventRing_;
+}
@@ -43,6 +43,7 @@ CREATED: 6/17/2015
 #include <string>
 
 namespace hooksGui { class GuiTextWriter; }
+struct TouchHookPointerRing;
 
 namespace hooksCore
 {
@@ -62,11 +63,17 @@ namespace hooksCore
         unsigned int getUwmCustomPointerDown();
         unsigned int getUwmCustomPointerUpdate();
         unsigned int getUwmCustomPointerUp();
+        unsigned int getUwmCustomPointerRing();
         unsigned int getUwmCustomTouched();
         unsigned int getUwmCustomTimer();
 
+        bool openPointerEventRing( void * consumerWindow );
+        void closePointerEventRing();
+        TouchHookPointerRing * pointerEventRing();
+
     private:
         bool useGlobalTouchHook_;
+        TouchHookPointerRing * pointerEventRing_;
 
     };
 }
@@ -35,20 +35,53 @@ PURPOSE: Converts custom Windows 8 touch messages into TUIO cursor messages
 */
 #include "hooksCore/TouchMessageListener.h"
 #include "hooksCore/TouchHooks2Tuio.h"
+#include "TouchHook.h"
 #include "TuioCursorServer.h"
+#include "TuioCursorOutputThread.h"
+#include "TouchPipeline.h"
+#include "MotionPredictor.h"
+#include "UdpFanOutSender.h"
+#include "FlashXmlTcpServer.h"
+#include "WebSocketSender.h"
+#include "CursorSnapshotWriter.h"
+#include "PointerEventLog.h"
 #include <QApplication>
+#include <QDir>
 #include <QDesktopWidget>
 #include <QTimer>
+#include <algorithm>
 #include <iostream>
 
 using hooksCore::TouchMessageListener;
 
 const unsigned int TouchMessageListener::TIMER_CALL_TIME = 100,
-                   TouchMessageListener::MAX_CURSOR_IDLE_TIME = 300;
+                   TouchMessageListener::MAX_CURSOR_IDLE_TIME = 300,
+                   TouchMessageListener::STALLED_RING_TIMEOUT = 1000,
+                   TouchMessageListener::POINTER_EVENT_BATCH_SIZE = 64,
+                   TouchMessageListener::FRAME_STATS_TIME = 1000,
+                   TouchMessageListener::TUIO_SET_MESSAGE_SIZE = 56;  // a 2Dcur set in a bundle
+
+const int TouchMessageListener::COALESCE_UNTIL_DRAINED = 0,
+          TouchMessageListener::COALESCING_OFF = -1;
 
 TouchMessageListener::TouchMessageListener() :
-  cursorMap_(),
+  webSocketSender_(),
+  snapshotWriter_(),
   tuioCursorServer_( 0 ),
+  pipeline_(),
+  outputThreadCpu_( TUIO::TuioCursorOutputThread::ANY_CPU ),
+  outputThreadPriority_( 1 ),
+  tuioUdpChannelOneFrameRate_( 0 ),
+  tuioUdpChannelTwoFrameRate_( 0 ),
+  flashXmlChannelFrameRate_( 0 ),
+  tuioUdpChannelOneProfile_( "1.1" ),
+  tuioUdpChannelTwoProfile_( "1.1" ),
+  useWebSocketChannel_( false ),
+  webSocketChannelPort_( 3335 ),
+  webSocketDeflate_( false ),
+  webSocketChannelFrameRate_( 0 ),
+  useSharedMemoryChannel_( false ),
+  sharedMemoryName_( CURSOR_SNAPSHOT_DEFAULT_NAME ),
   host_( "127.0.0.1" ),
   serverUdpPortOne_( 3333 ), 
   serverUdpPortTwo_( 3334 ), 
@@ -56,11 +89,47 @@ TouchMessageListener::TouchMessageListener() :
   useTuioUdpChannelOne_( true ),
   useTuioUdpChannelTwo_( true ),
   useFlashXmlTcpChannel_( true ),
+  udpEndpoints_(),
+  udpEndpointIndices_(),
   uwmCustomPointerdown_( 0 ),
   uwmCustomPointerUpdate_( 0 ),
   uwmCustomPointerUp_( 0 ),
+  uwmCustomPointerRing_( 0 ),
   uwmCustomTouch_( 0 ),
+  pointerEventRing_( 0 ),
+  pointerEventRingStalledSince_( -1 ),
+  pointerEventRingStalledPosition_( 0 ),
+  pointerEventRecorder_(),
+  pointerEventRecordingPath_(),
   timer_( new QTimer( this ) ),
+  frameTimer_( new QTimer( this ) ),
+  expiryTimer_( new QTimer( this ) ),
+  timerStarted_( false ),
+  frameCoalescingTime_( COALESCE_UNTIL_DRAINED ),
+  idleExpiryPrecision_( TUIO::TouchPipeline::DEFAULT_EXPIRY_PRECISION ),
+  motionPrediction_( "none" ),
+  predictionHorizon_( TUIO::MotionPredictor::DEFAULT_HORIZON ),
+  deadBand_( 0 ),
+  settleTime_( TUIO::TouchPipeline::DEFAULT_SETTLE_TIME ),
+  quantization_( 0 ),
+  pointerEventsPerSecond_( 0 ),
+  framesPerSecond_( 0 ),
+  timerWakeupsPerSecond_( 0 ),
+  suppressedUpdatesPerSecond_( 0 ),
+  frameStatsTime_( 0 ),
+  timerWakeups_( 0 ),
+  statsTimerWakeups_( 0 ),
+  statsEventCount_( 0 ),
+  statsFrameCount_( 0 ),
+  statsSuppressedCount_( 0 ),
+  udpStatsSyscalls_( 0 ),
+  udpStatsFrames_( 0 ),
+  udpSyscallsPerFrame_( 0.0 ),
+  inputLatencyAverage_( 0.0 ),
+  inputLatencyMax_( 0.0 ),
+  predictionError_( 0.0 ),
+  predictionLag_( 0.0 ),
+  predictionOffset_( 0.0 ),
   screenOffsetX_( 0 ),
   screenOffsetY_( 0 ),
   screenWidth_( 1920 ),
@@ -72,10 +141,23 @@ TouchMessageListener::TouchMessageListener() :
                          screenRect_.y(), 
                          screenRect_.width(), 
                          screenRect_.height() );
+
+    frameTimer_->setSingleShot( true );
+    connect( frameTimer_, SIGNAL( timeout() ), this, SLOT( commitCoalescedFrame() ) );
+
+    // Coarse timers may fire 5% early, which would cost an extra wakeup.
+    timer_->setTimerType( Qt::PreciseTimer );
+    expiryTimer_->setTimerType( Qt::PreciseTimer );
+    expiryTimer_->setSingleShot( true );
+    connect( expiryTimer_, SIGNAL( timeout() ), this, SLOT( expireIdleCursors() ) );
 }
 
 TouchMessageListener::~TouchMessageListener()
 {
+    stopPointerEventRecording();
+    pipeline_.reset(); // sends what is still queued
+    delete expiryTimer_;
+    delete frameTimer_;
     delete timer_;
 }
 
@@ -90,22 +172,212 @@ void TouchMessageListener::setServerInfo( const QString & host,
     serverFlashTcpPort_ = flashXmlPort;
 }
 
+/**
+ * Adds a TUIO UDP destination besides channels one and two.  Takes effect
+ * when initializeTuioServers() creates the TuioCursorServer.
+ */
+void TouchMessageListener::addUdpEndpoint( const QString & host, int port, bool enabled, int frameRate,
+                                           const QString & profile )
+{
+    UdpEndpoint endpoint;
+    endpoint.host = host;
+    endpoint.port = port;
+    endpoint.enabled = enabled;
+    endpoint.frameRate = frameRate;
+    endpoint.profile = profile;
+    udpEndpoints_.push_back( endpoint );
+}
+
+void TouchMessageListener::clearUdpEndpoints()
+{
+    udpEndpoints_.clear();
+}
+
+int TouchMessageListener::udpEndpointCount()
+{
+    return (int)udpEndpoints_.size();
+}
+
+QString TouchMessageListener::udpEndpointHost( int i )
+{
+    return udpEndpoints_[i].host;
+}
+
+int TouchMessageListener::udpEndpointPort( int i )
+{
+    return udpEndpoints_[i].port;
+}
+
+bool TouchMessageListener::useUdpEndpoint( int i )
+{
+    return udpEndpoints_[i].enabled;
+}
+
+int TouchMessageListener::udpEndpointFrameRate( int i )
+{
+    return udpEndpoints_[i].frameRate;
+}
+
+QString TouchMessageListener::udpEndpointProfile( int i )
+{
+    return udpEndpoints_[i].profile;
+}
+
+/**
+ * Takes effect when initializeTuioServers() starts the output thread.
+ * A cpu of -1 lets the thread run on any CPU; priority goes from -2 to 2.
+ */
+void TouchMessageListener::setOutputThreadSettings( int cpu, int priority )
+{
+    outputThreadCpu_ = cpu;
+    outputThreadPriority_ = priority;
+}
+
+int TouchMessageListener::outputThreadCpu()
+{
+    return outputThreadCpu_;
+}
+
+int TouchMessageListener::outputThreadPriority()
+{
+    return outputThreadPriority_;
+}
+
+/**
+ * Frames per second sent on each channel, 0 for every frame.  Slower
+ * channels get the latest cursor positions at each tick; adds and removes
+ * are sent at once.  Takes effect when initializeTuioServers() creates the
+ * TuioCursorServer.
+ */
+void TouchMessageListener::setOutputFrameRates( int udpChannelOne, int udpChannelTwo, int flashXml )
+{
+    tuioUdpChannelOneFrameRate_ = udpChannelOne;
+    tuioUdpChannelTwoFrameRate_ = udpChannelTwo;
+    flashXmlChannelFrameRate_ = flashXml;
+}
+
+int TouchMessageListener::tuioUdpChannelOneFrameRate()
+{
+    return tuioUdpChannelOneFrameRate_;
+}
+
+int TouchMessageListener::tuioUdpChannelTwoFrameRate()
+{
+    return tuioUdpChannelTwoFrameRate_;
+}
+
+int TouchMessageListener::flashXmlChannelFrameRate()
+{
+    return flashXmlChannelFrameRate_;
+}
+
+/**
+ * The TUIO version sent on UDP channels one and two, "1.1" (/tuio/2Dcur)
+ * or "2.0" (/tuio2/frm, /tuio2/ptr, /tuio2/alv).  Takes effect when
+ * initializeTuioServers() creates the TuioCursorServer.
+ */
+void TouchMessageListener::setOutputProfiles( const QString & udpChannelOne, const QString & udpChannelTwo )
+{
+    tuioUdpChannelOneProfile_ = udpChannelOne;
+    tuioUdpChannelTwoProfile_ = udpChannelTwo;
+}
+
+QString TouchMessageListener::tuioUdpChannelOneProfile()
+{
+    return tuioUdpChannelOneProfile_;
+}
+
+QString TouchMessageListener::tuioUdpChannelTwoProfile()
+{
+    return tuioUdpChannelTwoProfile_;
+}
+
+/**
+ * The WebSocket channel, for browsers: the TUIO 1.1 bundles of UDP
+ * channel one in binary messages, compressed with permessage-deflate for
+ * the clients that ask if deflate is true.  Takes effect when
+ * initializeTuioServers() creates the TuioCursorServer.
+ */
+void TouchMessageListener::setWebSocketChannel( bool use, int port, bool deflate, int frameRate )
+{
+    useWebSocketChannel_ = use;
+    webSocketChannelPort_ = port;
+    webSocketDeflate_ = deflate;
+    webSocketChannelFrameRate_ = frameRate;
+}
+
+bool TouchMessageListener::useWebSocketChannel()
+{
+    return useWebSocketChannel_;
+}
+
+int TouchMessageListener::webSocketChannelPort()
+{
+    return webSocketChannelPort_;
+}
+
+bool TouchMessageListener::webSocketDeflate()
+{
+    return webSocketDeflate_;
+}
+
+int TouchMessageListener::webSocketChannelFrameRate()
+{
+    return webSocketChannelFrameRate_;
+}
+
+/**
+ * The shared-memory channel, for programs on this machine: every frame's
+ * cursor table in a CursorSnapshot that CursorSnapshotReader opens by
+ * name.  Takes effect when initializeTuioServers() creates the
+ * TuioCursorServer.
+ */
+void TouchMessageListener::setSharedMemoryChannel( bool use, const QString & name )
+{
+    useSharedMemoryChannel_ = use;
+    sharedMemoryName_ = name;
+}
+
+bool TouchMessageListener::useSharedMemoryChannel()
+{
+    return useSharedMemoryChannel_;
+}
+
+QString TouchMessageListener::sharedMemoryName()
+{
+    return sharedMemoryName_;
+}
+
 void TouchMessageListener::useTuioUdpChannelOne( bool b )
 {
     useTuioUdpChannelOne_ = b;
-    tuioCursorServer_->useFirstUdpSender( useTuioUdpChannelOne_ );
+    useTuioSenders();
 }
 
 void TouchMessageListener::useTuioUdpChannelTwo( bool b )
 {
     useTuioUdpChannelTwo_ = b;
-    tuioCursorServer_->useSecondUdpSender( useTuioUdpChannelTwo_ );
+    useTuioSenders();
 }
 
 void TouchMessageListener::useFlashXmlTcpChannel( bool b )
 {
     useFlashXmlTcpChannel_ = b;
-    tuioCursorServer_->useFlashXmlTcpSender( useFlashXmlTcpChannel_ );
+    useTuioSenders();
+}
+
+/**
+ * The TuioCursorServer belongs to the output thread once it is running,
+ * so channel changes are queued like everything else.
+ */
+void TouchMessageListener::useTuioSenders()
+{
+    if( !pipeline_ ) {
+        return; // initializeTuioServers() applies them
+    }
+    pipeline_->outputThread().useSenders( useTuioUdpChannelOne_, 
+                                          useTuioUdpChannelTwo_, 
+                                          useFlashXmlTcpChannel_ );
 }
 
 QString TouchMessageListener::host()
@@ -154,12 +426,227 @@ void TouchMessageListener::initializeTuioServers()
     tuioCursorServer_->useFirstUdpSender( useTuioUdpChannelOne_ );
     tuioCursorServer_->useSecondUdpSender( useTuioUdpChannelTwo_ );
     tuioCursorServer_->useFlashXmlTcpSender( useFlashXmlTcpChannel_ );
+    tuioCursorServer_->setUdpEndpointFrameRate( TUIO::TuioCursorServer::FIRST_UDP_ENDPOINT,
+                                                tuioUdpChannelOneFrameRate_ );
+    tuioCursorServer_->setUdpEndpointFrameRate( TUIO::TuioCursorServer::SECOND_UDP_ENDPOINT,
+                                                tuioUdpChannelTwoFrameRate_ );
+    tuioCursorServer_->setFlashXmlFrameRate( flashXmlChannelFrameRate_ );
+
+    TUIO::TuioCursorServer::Profile profile = TUIO::TuioCursorServer::TUIO_1_1;
+    TUIO::TuioCursorServer::parseProfile( tuioUdpChannelOneProfile_.toStdString(), profile );
+    tuioCursorServer_->setUdpEndpointProfile( TUIO::TuioCursorServer::FIRST_UDP_ENDPOINT, profile );
+    profile = TUIO::TuioCursorServer::TUIO_1_1;
+    TUIO::TuioCursorServer::parseProfile( tuioUdpChannelTwoProfile_.toStdString(), profile );
+    tuioCursorServer_->setUdpEndpointProfile( TUIO::TuioCursorServer::SECOND_UDP_ENDPOINT, profile );
+    tuioCursorServer_->setSourceDimensions( screenWidth_, screenHeight_ );
+
+    if( useWebSocketChannel_ ) {
+        webSocketSender_.reset( new TUIO::WebSocketSender( webSocketChannelPort_, webSocketDeflate_ ) );
+        tuioCursorServer_->addOscSender( webSocketSender_.get(), webSocketChannelFrameRate_ );
+    }
+    if( useSharedMemoryChannel_ ) {
+        snapshotWriter_.reset( new TUIO::CursorSnapshotWriter( sharedMemoryName_.toStdString().c_str() ) );
+
+        if( snapshotWriter_->isOpen() ) {
+            tuioCursorServer_->setCursorSnapshotWriter( snapshotWriter_.get() );
+        }
+    }
+
+    TUIO::MotionPredictor::Model model = TUIO::MotionPredictor::NONE;
+    TUIO::MotionPredictor::parseModel( motionPrediction_.toStdString(), model );
+    tuioCursorServer_->getMotionPredictor().setModel( model );
+    tuioCursorServer_->getMotionPredictor().setHorizon( predictionHorizon_ );
+
+    // Channels one and two are the server's first two UDP endpoints; all
+    // of them are sent to with one batched send per bundle.
+    udpEndpointIndices_.clear();
+
+    for( size_t i = 0; i < udpEndpoints_.size(); ++i ) {
+        std::string endpointHost = udpEndpoints_[i].host.toStdString();
+        udpEndpointIndices_.push_back( tuioCursorServer_->addUdpEndpoint( endpointHost.c_str(),
+                                                                          udpEndpoints_[i].port,
+                                                                          udpEndpoints_[i].enabled ) );
+        tuioCursorServer_->setUdpEndpointFrameRate( udpEndpointIndices_.back(), udpEndpoints_[i].frameRate );
+
+        profile = TUIO::TuioCursorServer::TUIO_1_1;
+        TUIO::TuioCursorServer::parseProfile( udpEndpoints_[i].profile.toStdString(), profile );
+        tuioCursorServer_->setUdpEndpointProfile( udpEndpointIndices_.back(), profile );
+    }
+    pipeline_.reset( new TUIO::TouchPipeline( tuioCursorServer_.get() ) );
+    pipeline_->setScreenDimensions( screenOffsetX_, screenOffsetY_, screenWidth_, screenHeight_ );
+    pipeline_->setMirroredMonitors( mirroredMonitors_ );
+    pipeline_->setMaxIdleTime( MAX_CURSOR_IDLE_TIME );
+    pipeline_->setExpiryPrecision( idleExpiryPrecision_ );
+    pipeline_->setDeadBand( (float)deadBand_ );
+    pipeline_->setSettleTime( settleTime_ );
+    pipeline_->setQuantization( quantization_ );
+
+    // The event timestamps are QueryPerformanceCounter ticks, the clock TuioTime
+    // reads, so frames can be stamped with the time of their input.
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency( &frequency );
+    pipeline_->setTimestampFrequency( frequency.QuadPart );
+    pipeline_->startOutputThread( outputThreadCpu_, outputThreadPriority_ );
+}
+
+/**
+ * Sets how long pointer events are collected before they are sent out as
+ * a single TUIO frame: a number of milliseconds, COALESCE_UNTIL_DRAINED (0)
+ * to send once the pending input has been processed, or COALESCING_OFF (-1)
+ * to send one frame per pointer event.
+ */
+void TouchMessageListener::setFrameCoalescingTime( int milliseconds )
+{
+    frameCoalescingTime_ = std::max( milliseconds, COALESCING_OFF );
+}
+
+int TouchMessageListener::frameCoalescingTime()
+{
+    return frameCoalescingTime_;
+}
+
+/**
+ * How closely, in milliseconds, a cursor whose pointer went quiet is removed
+ * after MAX_CURSOR_IDLE_TIME.  Idle deadlines within this step share one
+ * timer wakeup.
+ */
+void TouchMessageListener::setIdleExpiryPrecision( int milliseconds )
+{
+    idleExpiryPrecision_ = std::max( milliseconds, 1 );
+
+    if( pipeline_ ) {
+        pipeline_->setExpiryPrecision( idleExpiryPrecision_ );
+    }
+}
+
+int TouchMessageListener::idleExpiryPrecision()
+{
+    return idleExpiryPrecision_;
+}
+
+/**
+ * Sends the cursors where the MotionPredictor model (none, velocity, 
+ * acceleration or kalman) expects them to be horizon milliseconds after 
+ * their input.  Takes effect when initializeTuioServers() creates the 
+ * TuioCursorServer.
+ */
+void TouchMessageListener::setMotionPrediction( const QString & model, int horizon )
+{
+    motionPrediction_ = model;
+    predictionHorizon_ = horizon;
+}
+
+QString TouchMessageListener::motionPrediction()
+{
+    return motionPrediction_;
+}
+
+int TouchMessageListener::predictionHorizon()
+{
+    return predictionHorizon_;
+}
+
+/**
+ * Holds back cursor updates within deadBand pixels of the position last 
+ * sent until they have waited settleTime milliseconds, and rounds positions 
+ * to quantization steps across the screen (see TouchPipeline.h).  0 turns 
+ * the dead band and the quantization off.
+ */
+void TouchMessageListener::setUpdateFilter( int deadBand, int settleTime, int quantization )
+{
+    deadBand_ = std::max( deadBand, 0 );
+    settleTime_ = std::max( settleTime, 1 );
+    quantization_ = std::max( quantization, 0 );
+
+    if( pipeline_ ) {
+        pipeline_->setDeadBand( (float)deadBand_ );
+        pipeline_->setSettleTime( settleTime_ );
+        pipeline_->setQuantization( quantization_ );
+    }
+}
+
+int TouchMessageListener::deadBand()
+{
+    return deadBand_;
+}
+
+int TouchMessageListener::settleTime()
+{
+    return settleTime_;
+}
+
+int TouchMessageListener::quantization()
+{
+    return quantization_;
 }
 
+/**
+ * Enables the housekeeping timer (see processTimer()).  It is started by
+ * the first pointer event, not here, so it does not run while nobody
+ * touches the screen.
+ */
 void TouchMessageListener::startTimer()
 {
     connect( timer_, SIGNAL( timeout() ), this, SLOT( processTimer() ) );
-    timer_->start( TIMER_CALL_TIME );
+    timerStarted_ = true;
+}
+
+/**
+ * Starts the housekeeping timer, or makes it run at least every interval
+ * milliseconds.  The frame stats start over when it was stopped.
+ */
+void TouchMessageListener::startHousekeeping( unsigned int interval )
+{
+    if( !timerStarted_ || !pipeline_ ) {
+        return;
+    }
+    if( !timer_->isActive() ) {
+        frameStatsTime_ = TUIO::TuioTime::getSessionTime().getTotalMilliseconds();
+        statsEventCount_ = pipeline_->eventCount();
+        statsFrameCount_ = pipeline_->frameCount();
+        statsSuppressedCount_ = pipeline_->suppressedCount() - pipeline_->settledCount();
+        statsTimerWakeups_ = timerWakeups_;
+        timer_->start( (int)interval );
+    }
+    else if( timer_->interval() > (int)interval ) {
+        timer_->start( (int)interval );
+    }
+}
+
+/**
+ * Writes every pointer event that comes in, before it is processed, to a
+ * binary log (see PointerEventLog.h) that PointerReplay can play back.
+ * The screen geometry in the log is the one set at this point.
+ */
+bool TouchMessageListener::startPointerEventRecording( const QString & path )
+{
+    stopPointerEventRecording();
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency( &frequency );
+
+    TUIO::PointerEventLogHeader header = TUIO::PointerEventLogHeader();
+    header.ticksPerSecond = frequency.QuadPart;
+    header.screenX = screenOffsetX_;
+    header.screenY = screenOffsetY_;
+    header.screenWidth = screenWidth_;
+    header.screenHeight = screenHeight_;
+    header.mirroredMonitors = mirroredMonitors_ ? 1 : 0;
+
+    std::unique_ptr<TUIO::PointerEventRecorder> recorder( new TUIO::PointerEventRecorder() );
+    std::string fileName = QDir::toNativeSeparators( path ).toStdString();
+
+    if( !recorder->open( fileName.c_str(), header ) ) {
+        return false;
+    }
+    pointerEventRecorder_ = std::move( recorder );
+    pointerEventRecordingPath_ = path;
+    return true;
+}
+
+void TouchMessageListener::stopPointerEventRecording()
+{
+    pointerEventRecorder_.reset(); // writes what is still buffered
 }
 
 void TouchMessageListener::setScreenDimensions( int x, int y, int width, int height )
@@ -168,6 +655,10 @@ void TouchMessageListener::setScreenDimensions( int x, int y, int width, int hei
     screenOffsetY_ = y;
     screenWidth_ = width;
     screenHeight_ = height;
+
+    if( pipeline_ ) {
+        pipeline_->setScreenDimensions( x, y, width, height );
+    }
 }
 
 void TouchMessageListener::setCustomMessageToListenFor( std::shared_ptr<hooksCore::TouchHooks2Tuio> touchHooks2Tuio )
@@ -175,22 +666,37 @@ void TouchMessageListener::setCustomMessageToListenFor( std::shared_ptr<hooksCor
     uwmCustomPointerdown_ = touchHooks2Tuio->getUwmCustomPointerDown();
     uwmCustomPointerUpdate_ = touchHooks2Tuio->getUwmCustomPointerUpdate();
     uwmCustomPointerUp_ = touchHooks2Tuio->getUwmCustomPointerUp();
+    uwmCustomPointerRing_ = touchHooks2Tuio->getUwmCustomPointerRing();
     uwmCustomTouch_ = touchHooks2Tuio->getUwmCustomTouched();
 }
 
+/**
+ * With a ring set, the hook DLL writes pointer events into shared memory
+ * and only posts a uwmCustomPointerRing_ message to wake this listener up.
+ */
+void TouchMessageListener::setPointerEventRing( TouchHookPointerRing * pointerEventRing )
+{
+    pointerEventRing_ = pointerEventRing;
+    pointerEventRingStalledSince_ = -1;
+    drainPointerEventRing();
+}
+
 bool TouchMessageListener::processWindowsGenericMessage( void * message )
 {
     bool retValue = true;
     const MSG * msg = reinterpret_cast<MSG *>(message);
 
     if( msg->message == uwmCustomPointerdown_ ) {
-        processPointerDown( msg );
+        processPointerMsg( TOUCHHOOK_POINTER_DOWN, msg );
     }
     else if( msg->message == uwmCustomPointerUpdate_ ) {
-        processPointerUpdate( msg );
+        processPointerMsg( TOUCHHOOK_POINTER_UPDATE, msg );
     }
     else if( msg->message == uwmCustomPointerUp_ ) {
-        processPointerUp( msg );
+        processPointerMsg( TOUCHHOOK_POINTER_UP, msg );
+    }
+    else if( msg->message == uwmCustomPointerRing_ ) {
+        drainPointerEventRing();
     }
     else if( msg->message == uwmCustomTouch_ ) {
         processTouch( msg );
@@ -202,74 +708,193 @@ bool TouchMessageListener::processWindowsGenericMessage( void * message )
 }
 
 /**
- * For Windows 8 touch WM_POINTERDOWN message.
+ * For the Windows 8 touch WM_POINTERDOWN, WM_POINTERUPDATE and WM_POINTERUP
+ * messages.  They carry no input frame or high-resolution time, so they are
+ * stamped with the time they are received.
  */
-void TouchMessageListener::processPointerDown( const MSG * msg )
+void TouchMessageListener::processPointerMsg( int eventType, const MSG * msg )
 {
-    UINT32 id = GET_POINTERID_WPARAM( msg->wParam );
     POINTS p = MAKEPOINTS( msg->lParam );
-    float x = scaledX( p.x ),
-          y = scaledY( p.y );
+    LARGE_INTEGER now;
+    QueryPerformanceCounter( &now );
+    POINTER_INPUT_TYPE pointerType;
 
-    tuioCursorServer_->initFrame( TUIO::TuioTime::getSessionTime() );
-    cursorMap_[id] = tuioCursorServer_->addTuioCursor( x, y );
-    tuioCursorServer_->commitFrame();
+    TUIO::PointerEvent event;
+    event.id = GET_POINTERID_WPARAM( msg->wParam );
+    event.type = eventType;
+    event.pointerType = GetPointerType( event.id, &pointerType ) ? (int)pointerType : TUIO::POINTER_INPUT_UNKNOWN;
+    event.x = p.x;
+    event.y = p.y;
+    event.timestamp = now.QuadPart;
+    processPointerEvent( event, 0 );
+}
 
-    //printPointerDownMsg( id, p.x, p.y );
-    //printPointerDownScaledMsg( id, x, y );
-    //printTuioCursor( cursorMap_[id] );
+/**
+ * With COALESCE_UNTIL_DRAINED the zero-time timer fires once the event loop
+ * has gone through the window messages that are already queued up.
+ */
+void TouchMessageListener::scheduleFrameCommit()
+{
+    if( frameCoalescingTime_ == COALESCING_OFF ) {
+        commitCoalescedFrame();
+    }
+    else if( !frameTimer_->isActive() ) {
+        frameTimer_->start( frameCoalescingTime_ );
+    }
 }
 
-float TouchMessageListener::scaledX( int x )
+/**
+ * Sends the open frame.  Moves the pipeline had to hold back for the next
+ * frame are sent from a timer a little later.
+ */
+void TouchMessageListener::commitCoalescedFrame()
 {
-    int mirroredX = x + screenOffsetX_,
-        sideBySideX = (x - screenWidth_) + screenOffsetX_,
-        screenX = mirroredMonitors_ ? mirroredX : sideBySideX,
-        screenWidth = screenWidth_ + screenOffsetX_;
+    frameTimer_->stop();
+
+    if( !pipeline_ ) {
+        return;
+    }
+    pipeline_->commitFrame();
 
-    return (float)screenX / screenWidth;
+    if( pipeline_->hasPendingMoves() ) {
+        frameTimer_->start( std::max( frameCoalescingTime_, 1 ) );
+    }
+    if( pipeline_->outputThread().backlogSize() > 0 ) {
+        startHousekeeping( TIMER_CALL_TIME );
+    }
 }
 
-float TouchMessageListener::scaledY( int y )
+/**
+ * The expiry timer is armed for the earliest idle deadline.  While cursors
+ * are down, idle deadlines only ever move later, so a running timer is left
+ * alone; it arms itself again when it fires.  Only a position the dead band
+ * holds back can bring the next deadline forward.
+ */
+void TouchMessageListener::scheduleIdleExpiry()
+{
+    if( pipeline_->cursorCount() == 0 ) {
+        expiryTimer_->stop();
+        return;
+    }
+    if( expiryTimer_->isActive() && !pipeline_->hasHeldMoves() ) {
+        return;
+    }
+    long deadline = pipeline_->nextExpiryTime(),
+         now = TUIO::TuioTime::getSessionTime().getTotalMilliseconds();
+    int interval = (int)std::max( deadline - now, 0L );
+
+    if( !expiryTimer_->isActive() || expiryTimer_->remainingTime() > interval ) {
+        expiryTimer_->start( interval );
+    }
+}
+
+void TouchMessageListener::expireIdleCursors()
 {
-    int screenY = y + screenOffsetY_,
-        screenHeight = screenHeight_ + screenOffsetY_;
+    ++timerWakeups_;
 
-    return (float)screenY / screenHeight;
+    if( pipeline_->expireIdleCursors( TUIO::TuioTime::getSessionTime() ) > 0 ) {
+        scheduleFrameCommit();
+    }
+    scheduleIdleExpiry();
 }
 
 /**
- * For Windows 8 touch WM_POINTERUPDATE message.
+ * Processes everything waiting in the shared-memory ring in batches, then
+ * arms the ring's wakeup flag so that the next event written by the hook
+ * posts one uwmCustomPointerRing_ message.  The ring is drained once more
+ * after arming, since an event may have slipped in just before.
  */
-void TouchMessageListener::processPointerUpdate( const MSG * msg )
+void TouchMessageListener::drainPointerEventRing()
 {
-    UINT32 id = GET_POINTERID_WPARAM( msg->wParam );
-    POINTS p = MAKEPOINTS( msg->lParam );   
-    float x = scaledX( p.x ),
-          y = scaledY( p.y );
+    if( pointerEventRing_ == 0 ) {
+        return;
+    }
+    TouchHookPointerEvent events[POINTER_EVENT_BATCH_SIZE];
+    bool wakeupArmed = false;
 
-    tuioCursorServer_->initFrame( TUIO::TuioTime::getSessionTime() );
-    tuioCursorServer_->updateTuioCursor( cursorMap_[id], x, y );
-    tuioCursorServer_->commitFrame();
+    for( ;; ) {
+        unsigned int count = pointerEventRing_->tryPopBatch( events, POINTER_EVENT_BATCH_SIZE );
 
-    //printPointerUpdateMsg( id, p.x, p.y );
-    //printPointerUpdateScaledMsg( id, x, y );
-    //printTuioCursor( cursorMap_[id] );
+        if( count == 0 ) {
+            if( wakeupArmed ) {
+                break;
+            }
+            pointerEventRing_->armWakeup();
+            wakeupArmed = true;
+        }
+        for( unsigned int i = 0; i < count; ++i ) {
+            processPointerEvent( events[i] );
+        }
+    }
+    if( frameCoalescingTime_ == COALESCE_UNTIL_DRAINED ) {
+        commitCoalescedFrame();
+    }
+    if( pointerEventRing_->isStalled() ) {
+        startHousekeeping( TIMER_CALL_TIME );
+    }
+}
+
+void TouchMessageListener::processPointerEvent( const TouchHookPointerEvent & ringEvent )
+{
+    TUIO::PointerEvent event;
+    event.id = ringEvent.pointerId;
+    event.type = ringEvent.eventType;
+    event.pointerType = ringEvent.pointerType;
+    event.x = ringEvent.x;
+    event.y = ringEvent.y;
+    event.timestamp = ringEvent.timestamp;
+    processPointerEvent( event, ringEvent.frameId );
 }
 
 /**
- * For Windows 8 touch WM_POINTERUP message.
+ * Every event is recorded, if recording is on, before it is processed.
  */
-void TouchMessageListener::processPointerUp( const MSG * msg )
+void TouchMessageListener::processPointerEvent( const TUIO::PointerEvent & event, UINT32 frameId )
 {
-    UINT32 id = GET_POINTERID_WPARAM( msg->wParam );
+    if( pointerEventRecorder_ ) {
+        pointerEventRecorder_->record( (TUIO::PointerEventType)event.type, event.id, frameId,
+                                       event.x, event.y, event.timestamp, event.pointerType );
+    }
+    if( !pipeline_ ) {
+        return;
+    }
+    startHousekeeping( FRAME_STATS_TIME );
 
-    tuioCursorServer_->initFrame( TUIO::TuioTime::getSessionTime() );
-    tuioCursorServer_->removeTuioCursor( cursorMap_[id] );
-    tuioCursorServer_->commitFrame();
-    cursorMap_.erase( cursorMap_.find( id ) );
+    if( pipeline_->process( event ) ) {
+        scheduleFrameCommit();
+    }
+    scheduleIdleExpiry();
+}
+
+/**
+ * A hooked process that dies between claiming a ring cell and filling it
+ * would block the ring for good.  If the ring has been stalled at the same
+ * position for STALLED_RING_TIMEOUT, that cell is skipped (and counted as
+ * dropped).  A producer that was only slow loses its record, not the
+ * cell: the ring refuses a publish to a skipped cell.
+ */
+void TouchMessageListener::checkForStalledPointerEventRing()
+{
+    if( pointerEventRing_ == 0 ) {
+        return;
+    }
+    if( !pointerEventRing_->isStalled() ) {
+        pointerEventRingStalledSince_ = -1;
+    }
+    else {
+        long now = TUIO::TuioTime::getSessionTime().getTotalMilliseconds();
+        unsigned int position = pointerEventRing_->headPosition();
 
-    //printPointerUpMsg( id );
+        if( pointerEventRingStalledSince_ < 0 || position != pointerEventRingStalledPosition_ ) {
+            pointerEventRingStalledSince_ = now;
+            pointerEventRingStalledPosition_ = position;
+        }
+        else if( now - pointerEventRingStalledSince_ >= (long)STALLED_RING_TIMEOUT ) {
+            pointerEventRing_->skipStalledCell( position );
+            pointerEventRingStalledSince_ = -1;
+        }
+    }
+    drainPointerEventRing();
 }
 
 /**
@@ -280,32 +905,80 @@ void TouchMessageListener::processTouch( const MSG * msg )
     //std::cout << "TouchMessageListener: processTouch() called...\n";
 }
 
+/**
+ * Housekeeping: the stalled ring check, the output backlog and the frame
+ * stats.  Idle cursors have a timer of their own (expireIdleCursors()).
+ * The timer runs every TIMER_CALL_TIME while the ring is stalled or records
+ * are backlogged, once per FRAME_STATS_TIME while fingers are down or the
+ * stats have yet to report that touching stopped, and not at all otherwise.
+ */
 void TouchMessageListener::processTimer()
 {
-    bool frameOpen = false;
-    std::map<DWORD, TUIO::TuioCursor *>::iterator iter = cursorMap_.begin();
+    ++timerWakeups_;
+    checkForStalledPointerEventRing();
+    pipeline_->outputThread().flushBacklog();
+    updateFrameStats();
 
-    while( iter != cursorMap_.end() ) {
-        long delta = TUIO::TuioTime::getSessionTime().getTotalMilliseconds()
-                   - iter->second->getTuioTime().getTotalMilliseconds();
-        //std::cout << "delta = " << delta << "\n";
+    bool urgent = pointerEventRingStalledSince_ >= 0 || pipeline_->outputThread().backlogSize() > 0,
+         busy = pipeline_->cursorCount() > 0 || pointerEventsPerSecond_ > 0;
 
-        if( delta > MAX_CURSOR_IDLE_TIME ) {
-            if( !frameOpen ) {
-                tuioCursorServer_->initFrame( TUIO::TuioTime::getSessionTime() );
-                frameOpen = true;
-            }
-            tuioCursorServer_->removeTuioCursor( iter->second );
-            std::map<DWORD, TUIO::TuioCursor*>::iterator tmp = iter++;
-            cursorMap_.erase( tmp );
-            //std::cout << "Removed cursor due to time limit\n";
-        }
-        else  {
-            ++iter;
+    if( urgent || busy ) {
+        int interval = urgent ? TIMER_CALL_TIME : FRAME_STATS_TIME;
+
+        if( timer_->interval() != interval ) {
+            timer_->setInterval( interval );
         }
     }
-    if( frameOpen ) {
-        tuioCursorServer_->commitFrame();
+    else {
+        timer_->stop();
+    }
+}
+
+/**
+ * Once per FRAME_STATS_TIME, works out how many pointer events came in and
+ * how many frames went out, and reports it while there is touch activity.
+ */
+void TouchMessageListener::updateFrameStats()
+{
+    long now = TUIO::TuioTime::getSessionTime().getTotalMilliseconds(),
+         elapsed = now - frameStatsTime_;
+
+    if( elapsed < (long)FRAME_STATS_TIME ) {
+        return;
+    }
+    bool wasActive = pointerEventsPerSecond_ > 0;
+    unsigned long eventCount = pipeline_->eventCount(),
+                  frameCount = pipeline_->frameCount();
+    pointerEventsPerSecond_ = (unsigned int)((eventCount - statsEventCount_) * 1000L / elapsed);
+    framesPerSecond_ = (unsigned int)((frameCount - statsFrameCount_) * 1000L / elapsed);
+    timerWakeupsPerSecond_ = (unsigned int)((timerWakeups_ - statsTimerWakeups_) * 1000L / elapsed);
+    statsEventCount_ = eventCount;
+    statsFrameCount_ = frameCount;
+    statsTimerWakeups_ = timerWakeups_;
+
+    unsigned long suppressedCount = pipeline_->suppressedCount() - pipeline_->settledCount();
+    suppressedUpdatesPerSecond_ = (unsigned int)((suppressedCount - statsSuppressedCount_) * 1000L / elapsed);
+    statsSuppressedCount_ = suppressedCount;
+    frameStatsTime_ = now;
+
+    unsigned long syscalls = tuioCursorServer_->getUdpSender()->getSyscallCount(),
+                  frames = pipeline_->outputThread().framesSent();
+    udpSyscallsPerFrame_ = frames > udpStatsFrames_ 
+                         ? (double)(syscalls - udpStatsSyscalls_) / (frames - udpStatsFrames_) : 0.0;
+    udpStatsSyscalls_ = syscalls;
+    udpStatsFrames_ = frames;
+
+    TUIO::TouchPipeline::LatencyStats latency = pipeline_->takeLatencyStats();
+    inputLatencyAverage_ = latency.frames > 0 ? latency.totalMicroseconds / 1000.0 / latency.frames : 0.0;
+    inputLatencyMax_ = latency.maxMicroseconds / 1000.0;
+
+    TUIO::MotionPredictor::Stats prediction = tuioCursorServer_->getMotionPredictor().takeStats();
+    predictionError_ = prediction.averageError * screenWidth_;
+    predictionLag_ = prediction.averageLag * screenWidth_;
+    predictionOffset_ = prediction.averageOffset * screenWidth_;
+
+    if( wasActive || pointerEventsPerSecond_ > 0 ) {
+        emit frameStatsChanged( frameStatsStatus() );
     }
 }
 
@@ -325,10 +998,205 @@ QString TouchMessageListener::serverInfo()
            + tuioUdpServerOneStatus()
            + tuioUdpServerTwoStatus()
            + flashXmlTcpServerStatus()
+           + webSocketServerStatus()
+           + sharedMemoryServerStatus()
+           + udpEndpointServersStatus()
            + "\n"
            + tuioUdpChannelOneStatus() + "\n"
            + tuioUdpChannelTwoStatus() + "\n"
-           + flashXmlChannelStatus() + "\n";
+           + flashXmlChannelStatus() + "\n"
+           + pointerEventRingStatus() + "\n"
+           + frameCoalescingStatus() + "\n"
+           + idleExpiryStatus() + "\n"
+           + motionPredictionStatus() + "\n"
+           + updateFilterStatus() + "\n"
+           + outputThreadStatus() + "\n"
+           + pointerEventRecordingStatus() + "\n";
+}
+
+QString TouchMessageListener::idleExpiryStatus()
+{
+    return "Idle cursor expiry: after " + QString::number( MAX_CURSOR_IDLE_TIME ) + " ms, within "
+           + QString::number( idleExpiryPrecision_ ) + " ms (no timer while no finger is down)";
+}
+
+QString TouchMessageListener::motionPredictionStatus()
+{
+    if( motionPrediction_ == "none" ) {
+        return "Motion prediction: OFF";
+    }
+    return "Motion prediction: " + motionPrediction_ + " model, " 
+           + QString::number( predictionHorizon_ ) + " ms ahead of the input";
+}
+
+QString TouchMessageListener::updateFilterStatus()
+{
+    if( deadBand_ == 0 && quantization_ == 0 ) {
+        return "Cursor update filter: OFF (every update sent)";
+    }
+    return "Cursor update filter: dead band " + QString::number( deadBand_ ) + " px, settled after "
+           + QString::number( settleTime_ ) + " ms, "
+           + (quantization_ > 0 ? "positions rounded to 1/" + QString::number( quantization_ ) 
+                                : QString( "no quantization" ));
+}
+
+QString TouchMessageListener::frameCoalescingStatus()
+{
+    if( frameCoalescingTime_ == COALESCING_OFF ) {
+        return "Frame coalescing: OFF (one TUIO frame per pointer event)";
+    }
+    if( frameCoalescingTime_ == COALESCE_UNTIL_DRAINED ) {
+        return "Frame coalescing: one TUIO frame per burst of queued pointer events";
+    }
+    return "Frame coalescing: one TUIO frame every " 
+           + QString::number( frameCoalescingTime_ ) + " ms";
+}
+
+/**
+ * Without coalescing, every pointer event would be encoded as its own frame
+ * and sent as one packet on each channel that is turned on.  Each update
+ * the dead band suppressed also saved a set message on every channel.
+ */
+QString TouchMessageListener::frameStatsStatus()
+{
+    unsigned int channels = (useTuioUdpChannelOne_ ? 1 : 0) 
+                          + (useTuioUdpChannelTwo_ ? 1 : 0) 
+                          + (useFlashXmlTcpChannel_ ? 1 : 0),
+                 savedEncodes = pointerEventsPerSecond_ > framesPerSecond_ 
+                              ? pointerEventsPerSecond_ - framesPerSecond_ : 0;
+
+    for( size_t i = 0; i < udpEndpoints_.size(); ++i ) {
+        channels += udpEndpoints_[i].enabled ? 1 : 0;
+    }
+
+    return QString::number( pointerEventsPerSecond_ ) + " pointer events/s sent as "
+           + QString::number( framesPerSecond_ ) + " frames/s; saved "
+           + QString::number( savedEncodes ) + " encodes/s and "
+           + QString::number( savedEncodes * channels ) + " packets/s; output queue depth "
+           + QString::number( pipeline_->outputThread().queueDepth() ) + " (max "
+           + QString::number( pipeline_->outputThread().maxQueueDepth() ) + "), "
+           + QString::number( pipeline_->outputThread().droppedCount() ) + " updates folded; "
+           + QString::number( timerWakeupsPerSecond_ ) + " timer wakeups/s; input to frame "
+           + QString::number( inputLatencyAverage_, 'f', 2 ) + " ms (max "
+           + QString::number( inputLatencyMax_, 'f', 2 ) + " ms); "
+           + (motionPrediction_ == "none" ? QString() 
+              : "predicted " + QString::number( predictionOffset_, 'f', 1 ) + " px ahead, "
+                + QString::number( predictionError_, 'f', 1 ) + " px off (raw "
+                + QString::number( predictionLag_, 'f', 1 ) + " px behind); ")
+           + (deadBand_ == 0 && quantization_ == 0 ? QString()
+              : "suppressed " + QString::number( suppressedUpdatesPerSecond_ ) + " updates/s ("
+                + QString::number( suppressedUpdatesPerSecond_ * TUIO_SET_MESSAGE_SIZE * channels / 1024.0, 'f', 1 )
+                + " KB/s); ")
+           + udpSendStatus() + "; " + flashXmlClientsStatus()
+           + (webSocketSender_ ? "; " + webSocketClientsStatus() : QString())
+           + (snapshotWriter_ && snapshotWriter_->isOpen() ? "; " + sharedMemoryStatus() : QString());
+}
+
+/**
+ * Frames published to shared memory, and how many of them woke up a
+ * reader that was waiting.
+ */
+QString TouchMessageListener::sharedMemoryStatus()
+{
+    return "shared memory " + QString::number( snapshotWriter_->getFramesPublished() ) + " frames, "
+           + QString::number( snapshotWriter_->getWakeups() ) + " reader wakeups"
+           + (snapshotWriter_->getCursorsLeftOut() > 0
+              ? ", " + QString::number( snapshotWriter_->getCursorsLeftOut() ) + " cursors left out"
+              : QString());
+}
+
+/**
+ * The lag and dropped frame count of every Flash XML client.  Frames are
+ * only dropped for a client that cannot keep up.
+ */
+QString TouchMessageListener::flashXmlClientsStatus()
+{
+    std::vector<FlashXmlTcpServer::ClientStats> clients = tuioCursorServer_->getFlashXmlTcpSender()->getClientStats();
+    QString msg = "Flash XML " + QString::number( clients.size() ) + " clients";
+
+    for( size_t i = 0; i < clients.size(); ++i ) {
+        msg += ", " + QString::fromStdString( clients[i].address ) + " lag "
+             + QString::number( clients[i].lagMilliseconds ) + " ms (max "
+             + QString::number( clients[i].maxLagMilliseconds ) + "), "
+             + QString::number( clients[i].framesDropped ) + " dropped";
+    }
+    return msg;
+}
+
+/**
+ * The lag, dropped messages and bytes sent of every WebSocket client, which
+ * like the Flash XML clients only lose messages of their own.
+ */
+QString TouchMessageListener::webSocketClientsStatus()
+{
+    std::vector<TUIO::WebSocketSender::ClientStats> clients = webSocketSender_->getClientStats();
+    QString msg = "WebSocket " + QString::number( clients.size() ) + " clients";
+
+    for( size_t i = 0; i < clients.size(); ++i ) {
+        msg += ", " + QString::fromStdString( clients[i].address ) + (clients[i].deflate ? " (deflate)" : "")
+             + " lag " + QString::number( clients[i].lagMilliseconds ) + " ms (max "
+             + QString::number( clients[i].maxLagMilliseconds ) + "), "
+             + QString::number( clients[i].framesDropped ) + " dropped, "
+             + QString::number( clients[i].bytesSent / 1024 ) + " KB sent";
+    }
+    return msg;
+}
+
+/**
+ * UDP system calls per frame over the last stats period, and the error
+ * count of every UDP endpoint that has had a failed send.
+ */
+QString TouchMessageListener::udpSendStatus()
+{
+    const TUIO::UdpFanOutSender * sender = tuioCursorServer_->getUdpSender();
+    QString msg = "UDP " + QString::number( udpSyscallsPerFrame_, 'f', 2 ) + " send calls/frame ("
+                + (TUIO::UdpFanOutSender::usesBatchedSend() ? "sendmmsg" : "sendto") + ")";
+
+    for( int i = 0; i < sender->getEndpointCount(); ++i ) {
+        if( sender->getEndpointErrorCount( i ) > 0 ) {
+            msg += ", " + QString::fromStdString( sender->getEndpointHost( i ) ) + ":"
+                 + QString::number( sender->getEndpointPort( i ) ) + " "
+                 + QString::number( sender->getEndpointErrorCount( i ) ) + " errors (last "
+                 + QString::number( sender->getEndpointLastError( i ) ) + ")";
+        }
+    }
+    return msg;
+}
+
+QString TouchMessageListener::outputThreadStatus()
+{
+    const TUIO::TuioCursorOutputThread & outputThread = pipeline_->outputThread();
+
+    if( !outputThread.isRunning() ) {
+        return "TUIO output thread: not running (sending from the GUI thread)";
+    }
+    QString cpu = outputThreadCpu_ < 0 ? QString( "any CPU" ) 
+                                       : "CPU " + QString::number( outputThreadCpu_ );
+    QString msg = "TUIO output thread: running on " + cpu
+                + (outputThreadCpu_ >= 0 && !outputThread.cpuAffinitySet() ? " (not set)" : "")
+                + ", priority " + QString::number( outputThreadPriority_ )
+                + (outputThreadPriority_ != 0 && !outputThread.prioritySet() ? " (not set)" : "");
+    return msg;
+}
+
+QString TouchMessageListener::pointerEventRecordingStatus()
+{
+    if( !pointerEventRecorder_ ) {
+        return "Pointer event recording: OFF";
+    }
+    return "Pointer event recording: ON, to " + pointerEventRecordingPath_ + " ("
+           + QString::number( pointerEventRecorder_->recordCount() ) + " events)";
+}
+
+QString TouchMessageListener::pointerEventRingStatus()
+{
+    if( pointerEventRing_ == 0 ) {
+        return "Pointer events: window messages (shared-memory ring not available)";
+    }
+    return "Pointer events: shared-memory ring of "
+           + QString::number( TOUCHHOOK_POINTER_RING_CAPACITY ) + " slots ("
+           + QString::number( pointerEventRing_->pushedCount() ) + " received, "
+           + QString::number( pointerEventRing_->droppedCount() ) + " dropped)";
 }
 
 QString TouchMessageListener::tuioUdpServerOneStatus()
@@ -355,6 +1223,43 @@ QString TouchMessageListener::flashXmlTcpServerStatus()
            + (ok ? ": Server started ok.\n" : ": Server failed to start.\n" );
 }
 
+QString TouchMessageListener::webSocketServerStatus()
+{
+    if( !useWebSocketChannel_ ) {
+        return QString();
+    }
+    bool ok = webSocketSender_ && webSocketSender_->isRunning();
+    return "WebSocket channel on port "
+           + QString::number( webSocketChannelPort_ )
+           + (webSocketSender_ && webSocketSender_->deflateEnabled() ? " (permessage-deflate)" : "")
+           + (ok ? ": Server started ok.\n" : ": Server failed to start.\n" );
+}
+
+QString TouchMessageListener::sharedMemoryServerStatus()
+{
+    if( !useSharedMemoryChannel_ ) {
+        return QString();
+    }
+    bool ok = snapshotWriter_ && snapshotWriter_->isOpen();
+    return "Shared memory channel " + sharedMemoryName_
+           + (ok ? ": Created ok.\n" : ": Could not be created.\n" );
+}
+
+QString TouchMessageListener::udpEndpointServersStatus()
+{
+    QString msg;
+
+    for( size_t i = 0; i < udpEndpoints_.size(); ++i ) {
+        int index = i < udpEndpointIndices_.size() ? udpEndpointIndices_[i] : -1;
+        bool ok = index >= 0 && tuioCursorServer_->isUdpEndpointRunning( index );
+        msg += "TUIO UDP endpoint " + udpEndpoints_[i].host + ":"
+             + QString::number( udpEndpoints_[i].port )
+             + (udpEndpoints_[i].enabled ? "" : " (disabled)")
+             + (ok ? ": Server started ok.\n" : ": Server failed to start.\n" );
+    }
+    return msg;
+}
+
 QString TouchMessageListener::tuioUdpChannelOneStatus()
 {
     QString msg = "Network menu: TUIO UDP channel 1 is ";
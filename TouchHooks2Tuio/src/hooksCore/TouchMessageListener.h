@@ -5,6 +5,10 @@ PURPOSE: Converts custom Windows 8 touch messages into TUIO cursor messages
          that are sent out by UDP or TCP servers.  Windows 7 is not supported.
          The custom messages are defined in the TouchHook.cpp file of the 
          TouchHook project.
+
+         This class only adapts window messages, the hook's shared-memory
+         ring and the Qt timers to the platform-neutral TUIO::TouchPipeline,
+         which does the cursor bookkeeping and frame building.
 *******************************************************************************/
 /*
  TouchHooks2Tuio - Windows 8 Touch to TUIO Bridge
@@ -39,13 +43,20 @@ PURPOSE: Converts custom Windows 8 touch messages into TUIO cursor messages
 #include <QObject>
 #include <QString>
 #include <memory>
-#include <map>
+#include <vector>
 #include <Windows.h>
 
 namespace hooksCore { class TouchHooks2Tuio; }
 namespace TUIO { class TuioCursorServer; }
+namespace TUIO { class TouchPipeline; }
+namespace TUIO { class WebSocketSender; }
+namespace TUIO { class CursorSnapshotWriter; }
+namespace TUIO { struct PointerEvent; }
 namespace TUIO{ class TuioCursor; }
+namespace TUIO { class PointerEventRecorder; }
 class QTimer;
+struct TouchHookPointerRing;
+struct TouchHookPointerEvent;
 
 namespace hooksCore
 {
@@ -55,19 +66,66 @@ namespace hooksCore
 
     public:
         static const unsigned int TIMER_CALL_TIME,
-                                  MAX_CURSOR_IDLE_TIME;
+                                  MAX_CURSOR_IDLE_TIME,
+                                  STALLED_RING_TIMEOUT,
+                                  POINTER_EVENT_BATCH_SIZE,
+                                  FRAME_STATS_TIME,
+                                  TUIO_SET_MESSAGE_SIZE;
+        static const int COALESCE_UNTIL_DRAINED,
+                         COALESCING_OFF;
 
         TouchMessageListener();
         virtual ~TouchMessageListener();
         
         void setServerInfo( const QString & host, int udpPortOne, int udpPortTwo, int flashXmlPort );
+        void addUdpEndpoint( const QString & host, int port, bool enabled, int frameRate = 0,
+                             const QString & profile = "1.1" );
+        void clearUdpEndpoints();
+        int udpEndpointCount();
+        QString udpEndpointHost( int i );
+        int udpEndpointPort( int i );
+        bool useUdpEndpoint( int i );
+        int udpEndpointFrameRate( int i );
+        QString udpEndpointProfile( int i );
+        void setOutputThreadSettings( int cpu, int priority );
+        int outputThreadCpu();
+        int outputThreadPriority();
+        void setOutputFrameRates( int udpChannelOne, int udpChannelTwo, int flashXml );
+        int tuioUdpChannelOneFrameRate();
+        int tuioUdpChannelTwoFrameRate();
+        int flashXmlChannelFrameRate();
+        void setOutputProfiles( const QString & udpChannelOne, const QString & udpChannelTwo );
+        QString tuioUdpChannelOneProfile();
+        QString tuioUdpChannelTwoProfile();
+        void setWebSocketChannel( bool use, int port, bool deflate, int frameRate );
+        bool useWebSocketChannel();
+        int webSocketChannelPort();
+        bool webSocketDeflate();
+        int webSocketChannelFrameRate();
+        void setSharedMemoryChannel( bool use, const QString & name );
+        bool useSharedMemoryChannel();
+        QString sharedMemoryName();
         void initializeTuioServers();
         void setScreenDimensions( int x, int y, int width, int height );
         QString screenInfo();
         QString serverInfo();
         void setCustomMessageToListenFor( std::shared_ptr<hooksCore::TouchHooks2Tuio> touchHooks2Tuio );
+        void setFrameCoalescingTime( int milliseconds );
+        int frameCoalescingTime();
+        void setIdleExpiryPrecision( int milliseconds );
+        int idleExpiryPrecision();
+        void setMotionPrediction( const QString & model, int horizon );
+        QString motionPrediction();
+        int predictionHorizon();
+        void setUpdateFilter( int deadBand, int settleTime, int quantization );
+        int deadBand();
+        int settleTime();
+        int quantization();
+        void setPointerEventRing( TouchHookPointerRing * pointerEventRing );
         bool processWindowsGenericMessage( void * message );
         void startTimer();
+        bool startPointerEventRecording( const QString & path );
+        void stopPointerEventRecording();
 
         QString host();
         int tuioUdpChannelOnePort();
@@ -85,6 +143,21 @@ namespace hooksCore
         QString tuioUdpServerOneStatus();
         QString tuioUdpServerTwoStatus();
         QString flashXmlTcpServerStatus();
+        QString webSocketServerStatus();
+        QString sharedMemoryServerStatus();
+        QString udpEndpointServersStatus();
+        QString udpSendStatus();
+        QString flashXmlClientsStatus();
+        QString webSocketClientsStatus();
+        QString sharedMemoryStatus();
+        QString pointerEventRingStatus();
+        QString frameCoalescingStatus();
+        QString idleExpiryStatus();
+        QString motionPredictionStatus();
+        QString updateFilterStatus();
+        QString frameStatsStatus();
+        QString outputThreadStatus();
+        QString pointerEventRecordingStatus();
 
         void useTuioUdpChannelOne( bool b );
         void useTuioUdpChannelTwo( bool b );
@@ -92,14 +165,36 @@ namespace hooksCore
 
     public slots:
         void processTimer();
+        void expireIdleCursors();
+        void commitCoalescedFrame();
+
+    signals:
+        void frameStatsChanged( const QString & message );
 
     private:
-        void processPointerDown( const MSG * msg );
-        float scaledX( int x );
-        float scaledY( int y );
-        void processPointerUpdate( const MSG * msg );
-        void processPointerUp( const MSG * msg );
+        /**
+         * An extra TUIO UDP destination from the XML settings.
+         */
+        struct UdpEndpoint
+        {
+            QString host;
+            int port;
+            bool enabled;
+            int frameRate;     // 0 sends every frame
+            QString profile;   // TUIO "1.1" or "2.0"
+        };
+
+        void processPointerMsg( int eventType, const MSG * msg );
         void processTouch( const MSG * msg );
+        void drainPointerEventRing();
+        void processPointerEvent( const TouchHookPointerEvent & ringEvent );
+        void processPointerEvent( const TUIO::PointerEvent & event, UINT32 frameId );
+        void checkForStalledPointerEventRing();
+        void useTuioSenders();
+        void scheduleFrameCommit();
+        void scheduleIdleExpiry();
+        void startHousekeeping( unsigned int interval );
+        void updateFrameStats();
 
         void printPointerDownMsg( unsigned int id, int x, int y );
         void printPointerDownScaledMsg( unsigned int id, float x, float y );
@@ -109,8 +204,23 @@ namespace hooksCore
 
         void printTuioCursor( TUIO::TuioCursor * tuioCursor );
 
-        std::map<DWORD, TUIO::TuioCursor *> cursorMap_;
+        std::unique_ptr<TUIO::WebSocketSender> webSocketSender_;   // outlives the server that sends to it
+        std::unique_ptr<TUIO::CursorSnapshotWriter> snapshotWriter_;   // the same
         std::shared_ptr<TUIO::TuioCursorServer> tuioCursorServer_;
+        std::unique_ptr<TUIO::TouchPipeline> pipeline_;
+        int outputThreadCpu_,
+            outputThreadPriority_,
+            tuioUdpChannelOneFrameRate_,
+            tuioUdpChannelTwoFrameRate_,
+            flashXmlChannelFrameRate_;
+        QString tuioUdpChannelOneProfile_,
+                tuioUdpChannelTwoProfile_;
+        bool useWebSocketChannel_;
+        int webSocketChannelPort_;
+        bool webSocketDeflate_;
+        int webSocketChannelFrameRate_;
+        bool useSharedMemoryChannel_;
+        QString sharedMemoryName_;
         QString host_;
         int serverUdpPortOne_,
             serverUdpPortTwo_,
@@ -118,11 +228,47 @@ namespace hooksCore
         bool useTuioUdpChannelOne_,
              useTuioUdpChannelTwo_,
              useFlashXmlTcpChannel_;
+        std::vector<UdpEndpoint> udpEndpoints_;
+        std::vector<int> udpEndpointIndices_;
         unsigned int uwmCustomPointerdown_,
                      uwmCustomPointerUpdate_,
                      uwmCustomPointerUp_,
+                     uwmCustomPointerRing_,
                      uwmCustomTouch_;
-        QTimer * timer_;
+        TouchHookPointerRing * pointerEventRing_;
+        long pointerEventRingStalledSince_;         // session ms, or -1 if not stalled
+        unsigned int pointerEventRingStalledPosition_;
+        std::unique_ptr<TUIO::PointerEventRecorder> pointerEventRecorder_;
+        QString pointerEventRecordingPath_;
+        QTimer * timer_,
+               * frameTimer_,
+               * expiryTimer_;
+        bool timerStarted_;
+        int frameCoalescingTime_,
+            idleExpiryPrecision_;
+        QString motionPrediction_;
+        int predictionHorizon_,
+            deadBand_,
+            settleTime_,
+            quantization_;
+        unsigned int pointerEventsPerSecond_,
+                     framesPerSecond_,
+                     timerWakeupsPerSecond_,
+                     suppressedUpdatesPerSecond_;
+        long frameStatsTime_;
+        unsigned long timerWakeups_,
+                      statsTimerWakeups_,
+                      statsEventCount_,
+                      statsFrameCount_,
+                      statsSuppressedCount_,
+                      udpStatsSyscalls_,
+                      udpStatsFrames_;
+        double udpSyscallsPerFrame_,
+               inputLatencyAverage_,      // milliseconds from input to frame
+               inputLatencyMax_,
+               predictionError_,          // pixels
+               predictionLag_,
+               predictionOffset_;
         int screenOffsetX_,
             screenOffsetY_,
             screenWidth_,
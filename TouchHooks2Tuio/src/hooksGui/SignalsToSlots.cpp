@@ -67,6 +67,7 @@ void SignalsToSlots::makeConnections()
     connectHooksMenu();
     connectNetworkMenu();
     connectLocalServer();
+    connectTouchMessageListener();
 }
 
 void SignalsToSlots::connectFileMenu()
@@ -110,3 +111,11 @@ void SignalsToSlots::connectLocalServer()
              mainWindow_,
              SLOT( removeGlobalTouchHook() ) );
 }
+
+void SignalsToSlots::connectTouchMessageListener()
+{
+    connect( touchMessageListener_,
+             SIGNAL( frameStatsChanged( const QString & ) ),
+             ui_->statusbar,
+             SLOT( showMessage( const QString & ) ) );
+}
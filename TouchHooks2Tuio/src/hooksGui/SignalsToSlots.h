@@ -66,6 +66,7 @@ namespace hooksGui
         void connectHooksMenu();
         void connectNetworkMenu();
         void connectLocalServer();
+        void connectTouchMessageListener();
 
         hooksGui::TouchHooksMainWindow * mainWindow_;
         hooksCore::TouchHooks2Tuio * touchHooks2Tuio_;
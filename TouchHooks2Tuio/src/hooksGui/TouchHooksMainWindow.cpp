@@ -84,6 +84,16 @@ void TouchHooksMainWindow::setTuioChannelsOnOrOff()
     xmlSettings_->setTuioChannelsOnOrOff( this );
 }
 
+void TouchHooksMainWindow::updateFrameSettings()
+{
+    xmlSettings_->updateFrameSettings( this );
+}
+
+void TouchHooksMainWindow::updateOutputThreadSettings()
+{
+    xmlSettings_->updateOutputThreadSettings( this );
+}
+
 std::shared_ptr<hooksCore::TouchMessageListener> TouchHooksMainWindow::touchMessageListener()
 {
     return touchMessageListener_;
@@ -122,11 +132,28 @@ void TouchHooksMainWindow::initializeCustomMessagesForHook()
     touchMessageListener_->setCustomMessageToListenFor( touchHooks2Tuio_ );
 }
 
+/**
+ * If the shared-memory ring can't be created, the hook DLL falls back to
+ * broadcasting one window message per pointer event.
+ */
+void TouchHooksMainWindow::initializePointerEventRing()
+{
+    touchHooks2Tuio_->openPointerEventRing( (void *)winId() );
+    touchMessageListener_->setPointerEventRing( touchHooks2Tuio_->pointerEventRing() );
+}
+
 void TouchHooksMainWindow::initializeTuioServers()
 {
     touchMessageListener_->initializeTuioServers();
 }
 
+void TouchHooksMainWindow::startPointerEventRecording( const QString & path )
+{
+    if( !touchMessageListener_->startPointerEventRecording( path ) ) {
+        writeToGuiTextArea( "Pointer event recording: could not create " + path );
+    }
+}
+
 void TouchHooksMainWindow::useTuioUdpChannelOne( bool b )
 {
     touchMessageListener_->useTuioUdpChannelOne( b );
@@ -68,8 +68,12 @@ namespace hooksGui
         void setNetworkMenuCheckboxes( bool udpChannelOne, bool udpChannelTwo, bool flashXml );
         void initializeConsolePidForDebugging( int consolePid );
         void initializeCustomMessagesForHook();
+        void initializePointerEventRing();
         void initializeTuioServers();
+        void startPointerEventRecording( const QString & path );
         void setTuioChannelsOnOrOff();
+        void updateFrameSettings();
+        void updateOutputThreadSettings();
         void writeScreenInfo();
         void writeServerInfo();
         void writeToGuiTextArea( const QString & message );
@@ -126,6 +126,15 @@ void XmlParamsReader::storeParams( QDomElement element,
     else if( tag == "network" ) {
         storeNetworkParams( childNode, validator );
     }
+    else if( tag == "frames" ) {
+        storeFramesParams( childNode, validator );
+    }
+    else if( tag == "output" ) {
+        storeOutputParams( childNode, validator );
+    }
+    else if( tag == "udpendpoints" ) {
+        storeUdpEndpointsParams( childNode, validator );
+    }
     else { 
         if( tag.size() == 0 ) { tag = "NO VALUE GIVEN"; }
         QString msg( "Unrecognized XML tag found." );
@@ -215,6 +224,202 @@ void XmlParamsReader::storeNetworkParams( QDomNode & node,
     }
 }
 
+void XmlParamsReader::storeFramesParams( QDomNode & node, 
+                                         hooksXml::XmlParamsValidator * validator )
+{
+    while( !node.isNull() ) {
+        if( node.isElement() ) {
+            QDomElement subelement = node.toElement();
+            QString tag = subelement.tagName().trimmed(),
+                    text = subelement.text().trimmed();
+            debugPrintLn( "        XML tag: " + tag + " = " + text );
+            tag = tag.toLower();
+
+            try {
+                if( tag == "framecoalescingtime" ) {
+                    validator->setFrameCoalescingTime( text );
+                }
+                else if( tag == "idleexpiryprecision" ) {
+                    validator->setIdleExpiryPrecision( text );
+                }
+                else if( tag == "motionprediction" ) {
+                    validator->setMotionPrediction( text );
+                }
+                else if( tag == "predictionhorizon" ) {
+                    validator->setPredictionHorizon( text );
+                }
+                else if( tag == "deadband" ) {
+                    validator->setDeadBand( text );
+                }
+                else if( tag == "settletime" ) {
+                    validator->setSettleTime( text );
+                }
+                else if( tag == "quantization" ) {
+                    validator->setQuantization( text );
+                }
+                else { 
+                    if( tag.size() == 0 ) { tag = "NO VALUE GIVEN"; }
+                    QString msg( "Unrecognized XML tag found." );
+                    UnknownXmlTagException e( msg, "XmlParamsReader::storeFramesParams()",
+                                              tag, xmlFile_ );
+                    unknownXmlTagExceptions_.push_back( e );
+                }
+            }
+            catch( ValidatorException e ) {
+                validatorExceptions_.push_back( e );
+            }
+        }
+        node = node.nextSibling();
+    }
+}
+
+void XmlParamsReader::storeOutputParams( QDomNode & node, 
+                                         hooksXml::XmlParamsValidator * validator )
+{
+    while( !node.isNull() ) {
+        if( node.isElement() ) {
+            QDomElement subelement = node.toElement();
+            QString tag = subelement.tagName().trimmed(),
+                    text = subelement.text().trimmed();
+            debugPrintLn( "        XML tag: " + tag + " = " + text );
+            tag = tag.toLower();
+
+            try {
+                if( tag == "outputthreadcpu" ) {
+                    validator->setOutputThreadCpu( text );
+                }
+                else if( tag == "outputthreadpriority" ) {
+                    validator->setOutputThreadPriority( text );
+                }
+                else if( tag == "tuioudpchanneloneframerate" ) {
+                    validator->setTuioUdpChannelOneFrameRate( text );
+                }
+                else if( tag == "tuioudpchanneltwoframerate" ) {
+                    validator->setTuioUdpChannelTwoFrameRate( text );
+                }
+                else if( tag == "flashxmlchannelframerate" ) {
+                    validator->setFlashXmlChannelFrameRate( text );
+                }
+                else if( tag == "tuioudpchanneloneprofile" ) {
+                    validator->setTuioUdpChannelOneProfile( text );
+                }
+                else if( tag == "tuioudpchanneltwoprofile" ) {
+                    validator->setTuioUdpChannelTwoProfile( text );
+                }
+                else if( tag == "usewebsocketchannel" ) {
+                    validator->useWebSocketChannel( text );
+                }
+                else if( tag == "websocketchannelport" ) {
+                    validator->setWebSocketChannelPort( text );
+                }
+                else if( tag == "websocketdeflate" ) {
+                    validator->useWebSocketDeflate( text );
+                }
+                else if( tag == "websocketchannelframerate" ) {
+                    validator->setWebSocketChannelFrameRate( text );
+                }
+                else if( tag == "usesharedmemorychannel" ) {
+                    validator->useSharedMemoryChannel( text );
+                }
+                else if( tag == "sharedmemoryname" ) {
+                    validator->setSharedMemoryName( text );
+                }
+                else { 
+                    if( tag.size() == 0 ) { tag = "NO VALUE GIVEN"; }
+                    QString msg( "Unrecognized XML tag found." );
+                    UnknownXmlTagException e( msg, "XmlParamsReader::storeOutputParams()",
+                                              tag, xmlFile_ );
+                    unknownXmlTagExceptions_.push_back( e );
+                }
+            }
+            catch( ValidatorException e ) {
+                validatorExceptions_.push_back( e );
+            }
+        }
+        node = node.nextSibling();
+    }
+}
+
+void XmlParamsReader::storeUdpEndpointsParams( QDomNode & node, 
+                                               hooksXml::XmlParamsValidator * validator )
+{
+    while( !node.isNull() ) {
+        if( node.isElement() ) {
+            QDomElement subelement = node.toElement();
+            QString tag = subelement.tagName().trimmed();
+            QDomNode childNode = subelement.firstChild();
+            debugPrintLn( "        XML tag: " + tag );
+            tag = tag.toLower();
+
+            if( tag == "udpendpoint" ) {
+                storeUdpEndpointParams( childNode, validator );
+            }
+            else { 
+                if( tag.size() == 0 ) { tag = "NO VALUE GIVEN"; }
+                QString msg( "Unrecognized XML tag found." );
+                UnknownXmlTagException e( msg, "XmlParamsReader::storeUdpEndpointsParams()",
+                                          tag, xmlFile_ );
+                unknownXmlTagExceptions_.push_back( e );
+            }
+        }
+        node = node.nextSibling();
+    }
+}
+
+/**
+ * One <udpEndpoint> element, with <host>, <port> and (optionally) <enabled>
+ * <frameRate> and <profile>.
+ */
+void XmlParamsReader::storeUdpEndpointParams( QDomNode & node, 
+                                              hooksXml::XmlParamsValidator * validator )
+{
+    QString host,
+            port,
+            enabled,
+            frameRate,
+            profile;
+
+    while( !node.isNull() ) {
+        if( node.isElement() ) {
+            QDomElement subelement = node.toElement();
+            QString tag = subelement.tagName().trimmed(),
+                    text = subelement.text().trimmed();
+            debugPrintLn( "            XML tag: " + tag + " = " + text );
+            tag = tag.toLower();
+
+            if( tag == "host" ) {
+                host = text;
+            }
+            else if( tag == "port" ) {
+                port = text;
+            }
+            else if( tag == "enabled" ) {
+                enabled = text;
+            }
+            else if( tag == "framerate" ) {
+                frameRate = text;
+            }
+            else if( tag == "profile" ) {
+                profile = text;
+            }
+            else { 
+                if( tag.size() == 0 ) { tag = "NO VALUE GIVEN"; }
+                QString msg( "Unrecognized XML tag found." );
+                UnknownXmlTagException e( msg, "XmlParamsReader::storeUdpEndpointParams()",
+                                          tag, xmlFile_ );
+                unknownXmlTagExceptions_.push_back( e );
+            }
+        }
+        node = node.nextSibling();
+    }
+    try {
+        validator->addUdpEndpoint( host, port, enabled, frameRate, profile );
+    }
+    catch( ValidatorException e ) {
+        validatorExceptions_.push_back( e );
+    }
+}
+
 bool XmlParamsReader::hasUnknownXmlTagExceptions()
 {
     return (unknownXmlTagExceptions_.size() > 0);
@@ -63,6 +63,10 @@ namespace hooksXml
         void storeParams( QDomElement element, hooksXml::XmlParamsValidator * validator );
         void storeHooksParams( QDomNode & node, hooksXml::XmlParamsValidator * validator );
         void storeNetworkParams( QDomNode & node, hooksXml::XmlParamsValidator * validator );
+        void storeFramesParams( QDomNode & node, hooksXml::XmlParamsValidator * validator );
+        void storeOutputParams( QDomNode & node, hooksXml::XmlParamsValidator * validator );
+        void storeUdpEndpointsParams( QDomNode & node, hooksXml::XmlParamsValidator * validator );
+        void storeUdpEndpointParams( QDomNode & node, hooksXml::XmlParamsValidator * validator );
         void debugPrintLn( const QString & msg );
 
         std::vector<hooksExceptions::UnknownXmlTagException> unknownXmlTagExceptions_;
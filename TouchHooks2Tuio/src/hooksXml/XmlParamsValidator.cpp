@@ -56,6 +56,27 @@ void XmlParamsValidator::initialize()
     useTuioUdpChannelOne_ = true;
     useTuioUdpChannelTwo_ = true;
     useFlashXmlChannel_ = true; 
+    frameCoalescingTime_ = 0;
+    idleExpiryPrecision_ = 10;
+    motionPrediction_ = "none";
+    predictionHorizon_ = 16;
+    deadBand_ = 0;
+    settleTime_ = 50;
+    quantization_ = 0;
+    outputThreadCpu_ = -1;
+    outputThreadPriority_ = 1;
+    tuioUdpChannelOneFrameRate_ = 0;
+    tuioUdpChannelTwoFrameRate_ = 0;
+    flashXmlChannelFrameRate_ = 0;
+    tuioUdpChannelOneProfile_ = "1.1";
+    tuioUdpChannelTwoProfile_ = "1.1";
+    useWebSocketChannel_ = false;
+    webSocketChannelPort_ = 3335;
+    useWebSocketDeflate_ = false;
+    webSocketChannelFrameRate_ = 0;
+    useSharedMemoryChannel_ = false;
+    sharedMemoryName_ = "TouchHooks2TuioCursors";
+    udpEndpoints_.clear();
 }
 
 void XmlParamsValidator::setXmlConfigFilename( const QString & filename )
@@ -211,6 +232,474 @@ void XmlParamsValidator::useFlashXmlChannel( const QString & s )
     }
 }
 
+/**
+ * Milliseconds to collect pointer events into one TUIO frame; 0 sends a 
+ * frame per burst of queued events, -1 turns coalescing off.
+ */
+void XmlParamsValidator::setFrameCoalescingTime( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < -1 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setFrameCoalescingTime()",
+                                  "frameCoalescingTime",
+                                  s,
+                                  "-1 (off), 0 (per burst) or a positive integer",
+                                  xmlConfigFilename_ );
+    }
+    frameCoalescingTime_ = n;
+}
+
+/**
+ * How closely, in milliseconds, a cursor whose pointer went quiet is 
+ * removed after the idle time; idle deadlines within this step share one
+ * timer wakeup.
+ */
+void XmlParamsValidator::setIdleExpiryPrecision( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 1 || n > 1000 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setIdleExpiryPrecision()",
+                                  "idleExpiryPrecision",
+                                  s,
+                                  "an integer from 1 to 1000",
+                                  xmlConfigFilename_ );
+    }
+    idleExpiryPrecision_ = n;
+}
+
+/**
+ * The model used to send cursors ahead of the input: none, velocity, 
+ * acceleration or kalman.
+ */
+void XmlParamsValidator::setMotionPrediction( const QString & s )
+{
+    QString model = s.trimmed().toLower();
+
+    if( model != "none" && model != "velocity" && model != "acceleration" && model != "kalman" ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setMotionPrediction()",
+                                  "motionPrediction",
+                                  s,
+                                  "none, velocity, acceleration or kalman",
+                                  xmlConfigFilename_ );
+    }
+    motionPrediction_ = model;
+}
+
+/**
+ * How many milliseconds ahead of the input the cursors are predicted.
+ */
+void XmlParamsValidator::setPredictionHorizon( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 0 || n > 100 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setPredictionHorizon()",
+                                  "predictionHorizon",
+                                  s,
+                                  "an integer from 0 to 100",
+                                  xmlConfigFilename_ );
+    }
+    predictionHorizon_ = n;
+}
+
+/**
+ * Cursor updates within this many pixels of the position last sent are held
+ * back; 0 sends every update.
+ */
+void XmlParamsValidator::setDeadBand( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 0 || n > 50 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setDeadBand()",
+                                  "deadBand",
+                                  s,
+                                  "an integer from 0 to 50",
+                                  xmlConfigFilename_ );
+    }
+    deadBand_ = n;
+}
+
+/**
+ * How many milliseconds a held cursor position waits before it is sent
+ * anyway.
+ */
+void XmlParamsValidator::setSettleTime( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 1 || n > 1000 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setSettleTime()",
+                                  "settleTime",
+                                  s,
+                                  "an integer from 1 to 1000",
+                                  xmlConfigFilename_ );
+    }
+    settleTime_ = n;
+}
+
+/**
+ * The number of grid steps across the screen cursor positions are rounded
+ * to; 0 keeps them as they are.
+ */
+void XmlParamsValidator::setQuantization( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 0 || n > 65536 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setQuantization()",
+                                  "quantization",
+                                  s,
+                                  "an integer from 0 to 65536",
+                                  xmlConfigFilename_ );
+    }
+    quantization_ = n;
+}
+
+/**
+ * The CPU the TUIO output thread is pinned to; -1 lets it run on any CPU.
+ */
+void XmlParamsValidator::setOutputThreadCpu( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < -1 || n > 63 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setOutputThreadCpu()",
+                                  "outputThreadCpu",
+                                  s,
+                                  "-1 (any CPU) or a CPU number from 0 to 63",
+                                  xmlConfigFilename_ );
+    }
+    outputThreadCpu_ = n;
+}
+
+/**
+ * Thread priority of the TUIO output thread, from -2 (lowest) to 2 (highest).
+ */
+void XmlParamsValidator::setOutputThreadPriority( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < -2 || n > 2 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setOutputThreadPriority()",
+                                  "outputThreadPriority",
+                                  s,
+                                  "an integer from -2 to 2",
+                                  xmlConfigFilename_ );
+    }
+    outputThreadPriority_ = n;
+}
+
+/**
+ * Frames per second sent on TUIO UDP channel one; 0 sends every frame.
+ * Between frames only the latest cursor positions are kept, and cursors
+ * coming and going are always sent at once.
+ */
+void XmlParamsValidator::setTuioUdpChannelOneFrameRate( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 0 || n > 1000 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setTuioUdpChannelOneFrameRate()",
+                                  "tuioUdpChannelOneFrameRate",
+                                  s,
+                                  "0 (every frame) or an integer up to 1000",
+                                  xmlConfigFilename_ );
+    }
+    tuioUdpChannelOneFrameRate_ = n;
+}
+
+/**
+ * Frames per second sent on TUIO UDP channel two; 0 sends every frame.
+ */
+void XmlParamsValidator::setTuioUdpChannelTwoFrameRate( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 0 || n > 1000 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setTuioUdpChannelTwoFrameRate()",
+                                  "tuioUdpChannelTwoFrameRate",
+                                  s,
+                                  "0 (every frame) or an integer up to 1000",
+                                  xmlConfigFilename_ );
+    }
+    tuioUdpChannelTwoFrameRate_ = n;
+}
+
+/**
+ * Frames per second sent to the Flash XML clients; 0 sends every frame.
+ */
+void XmlParamsValidator::setFlashXmlChannelFrameRate( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 0 || n > 1000 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setFlashXmlChannelFrameRate()",
+                                  "flashXmlChannelFrameRate",
+                                  s,
+                                  "0 (every frame) or an integer up to 1000",
+                                  xmlConfigFilename_ );
+    }
+    flashXmlChannelFrameRate_ = n;
+}
+
+/**
+ * The TUIO version sent on UDP channel one: 1.1 (/tuio/2Dcur) or 2.0
+ * (/tuio2/frm, /tuio2/ptr, /tuio2/alv).
+ */
+void XmlParamsValidator::setTuioUdpChannelOneProfile( const QString & s )
+{
+    QString profile = s.trimmed();
+
+    if( profile != "1.1" && profile != "2.0" ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setTuioUdpChannelOneProfile()",
+                                  "tuioUdpChannelOneProfile",
+                                  s,
+                                  "1.1 or 2.0",
+                                  xmlConfigFilename_ );
+    }
+    tuioUdpChannelOneProfile_ = profile;
+}
+
+/**
+ * The TUIO version sent on UDP channel two: 1.1 or 2.0.
+ */
+void XmlParamsValidator::setTuioUdpChannelTwoProfile( const QString & s )
+{
+    QString profile = s.trimmed();
+
+    if( profile != "1.1" && profile != "2.0" ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setTuioUdpChannelTwoProfile()",
+                                  "tuioUdpChannelTwoProfile",
+                                  s,
+                                  "1.1 or 2.0",
+                                  xmlConfigFilename_ );
+    }
+    tuioUdpChannelTwoProfile_ = profile;
+}
+
+/**
+ * The WebSocket channel sends the TUIO 1.1 bundles to browsers.
+ */
+void XmlParamsValidator::useWebSocketChannel( const QString & s )
+{
+    QString b = s.trimmed().toLower();
+
+    if( b == "true" ) {
+        useWebSocketChannel_ = true;
+    }
+    else if( b == "false" ) {
+        useWebSocketChannel_ = false;
+    }
+    else {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::useWebSocketChannel()",
+                                  "useWebSocketChannel",
+                                  s,
+                                  "true or false",
+                                  xmlConfigFilename_ );
+    }
+}
+
+void XmlParamsValidator::setWebSocketChannelPort( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 1 || n > 65535 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setWebSocketChannelPort()",
+                                  "webSocketChannelPort",
+                                  s,
+                                  "an integer from 1 to 65535",
+                                  xmlConfigFilename_ );
+    }
+    webSocketChannelPort_ = n;
+}
+
+/**
+ * Whether permessage-deflate is offered to the WebSocket clients.
+ */
+void XmlParamsValidator::useWebSocketDeflate( const QString & s )
+{
+    QString b = s.trimmed().toLower();
+
+    if( b == "true" ) {
+        useWebSocketDeflate_ = true;
+    }
+    else if( b == "false" ) {
+        useWebSocketDeflate_ = false;
+    }
+    else {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::useWebSocketDeflate()",
+                                  "webSocketDeflate",
+                                  s,
+                                  "true or false",
+                                  xmlConfigFilename_ );
+    }
+}
+
+/**
+ * Frames per second sent to the WebSocket clients; 0 sends every frame.
+ */
+void XmlParamsValidator::setWebSocketChannelFrameRate( const QString & s )
+{
+    bool ok = false;
+    int n = s.toInt( &ok );
+
+    if( !ok || n < 0 || n > 1000 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setWebSocketChannelFrameRate()",
+                                  "webSocketChannelFrameRate",
+                                  s,
+                                  "0 (every frame) or an integer up to 1000",
+                                  xmlConfigFilename_ );
+    }
+    webSocketChannelFrameRate_ = n;
+}
+
+/**
+ * The shared-memory channel publishes the cursor table for programs on the
+ * same machine.
+ */
+void XmlParamsValidator::useSharedMemoryChannel( const QString & s )
+{
+    QString b = s.trimmed().toLower();
+
+    if( b == "true" ) {
+        useSharedMemoryChannel_ = true;
+    }
+    else if( b == "false" ) {
+        useSharedMemoryChannel_ = false;
+    }
+    else {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::useSharedMemoryChannel()",
+                                  "useSharedMemoryChannel",
+                                  s,
+                                  "true or false",
+                                  xmlConfigFilename_ );
+    }
+}
+
+/**
+ * The name the readers open the shared memory by.  It becomes part of a
+ * file mapping or POSIX shared memory name, so no slashes or spaces.
+ */
+void XmlParamsValidator::setSharedMemoryName( const QString & s )
+{
+    QString name = s.trimmed();
+    bool ok = name.size() > 0 && name.size() <= 200;
+
+    for( int i = 0; ok && i < name.size(); ++i ) {
+        QChar c = name.at( i );
+        ok = (c.isLetterOrNumber() && c.unicode() < 128) || c == '_' || c == '-' || c == '.';
+    }
+    if( !ok ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::setSharedMemoryName()",
+                                  "sharedMemoryName",
+                                  s,
+                                  "up to 200 letters, digits, '_', '-' or '.'",
+                                  xmlConfigFilename_ );
+    }
+    sharedMemoryName_ = name;
+}
+
+/**
+ * An extra TUIO UDP destination from a <udpEndpoint> element.  The enabled
+ * flag may be left empty, which means true, and so may the frame rate,
+ * which means every frame, and the profile, which means TUIO 1.1.
+ */
+void XmlParamsValidator::addUdpEndpoint( const QString & host, const QString & port, const QString & enabled,
+                                         const QString & frameRate, const QString & profile )
+{
+    UdpEndpoint endpoint;
+    bool ok = false,
+         frameRateOk = true;
+    QString b = enabled.trimmed().toLower();
+
+    endpoint.host = host.trimmed();
+    endpoint.port = port.trimmed().toInt( &ok );
+    endpoint.enabled = (b != "false");
+    endpoint.frameRate = 0;
+
+    if( frameRate.trimmed().size() > 0 ) {
+        endpoint.frameRate = frameRate.trimmed().toInt( &frameRateOk );
+    }
+    endpoint.profile = profile.trimmed().size() > 0 ? profile.trimmed() : QString( "1.1" );
+
+    if( endpoint.host.size() < 1 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::addUdpEndpoint()",
+                                  "udpEndpoint host",
+                                  host,
+                                  "valid IP address such as 192.168.1.20",
+                                  xmlConfigFilename_ );
+    }
+    if( !ok || endpoint.port < 1 || endpoint.port > 65535 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::addUdpEndpoint()",
+                                  "udpEndpoint port",
+                                  port,
+                                  "an integer from 1 to 65535",
+                                  xmlConfigFilename_ );
+    }
+    if( b != "" && b != "true" && b != "false" ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::addUdpEndpoint()",
+                                  "udpEndpoint enabled",
+                                  enabled,
+                                  "true or false",
+                                  xmlConfigFilename_ );
+    }
+    if( !frameRateOk || endpoint.frameRate < 0 || endpoint.frameRate > 1000 ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::addUdpEndpoint()",
+                                  "udpEndpoint frameRate",
+                                  frameRate,
+                                  "0 (every frame) or an integer up to 1000",
+                                  xmlConfigFilename_ );
+    }
+    if( endpoint.profile != "1.1" && endpoint.profile != "2.0" ) {
+        throw ValidatorException( "Invalid startup setting detected.",
+                                  "XmlParamsValidator::addUdpEndpoint()",
+                                  "udpEndpoint profile",
+                                  profile,
+                                  "1.1 or 2.0",
+                                  xmlConfigFilename_ );
+    }
+    udpEndpoints_.push_back( endpoint );
+}
+
 // getters
 bool XmlParamsValidator::useGlobalHook() { return useGlobalHook_; }
 QString XmlParamsValidator::getLocalHost() { return localHost_; }
@@ -220,6 +709,27 @@ int XmlParamsValidator::getFlashXmlChannelPort()   { return flashXmlChannelPort_
 bool XmlParamsValidator::useTuioUdpChannelOne() { return useTuioUdpChannelOne_; }
 bool XmlParamsValidator::useTuioUdpChannelTwo() { return useTuioUdpChannelTwo_; }
 bool XmlParamsValidator::useFlashXmlChannel()   { return useFlashXmlChannel_; }
+int XmlParamsValidator::getFrameCoalescingTime() { return frameCoalescingTime_; }
+int XmlParamsValidator::getIdleExpiryPrecision() { return idleExpiryPrecision_; }
+QString XmlParamsValidator::getMotionPrediction() { return motionPrediction_; }
+int XmlParamsValidator::getPredictionHorizon() { return predictionHorizon_; }
+int XmlParamsValidator::getDeadBand() { return deadBand_; }
+int XmlParamsValidator::getSettleTime() { return settleTime_; }
+int XmlParamsValidator::getQuantization() { return quantization_; }
+int XmlParamsValidator::getOutputThreadCpu() { return outputThreadCpu_; }
+int XmlParamsValidator::getOutputThreadPriority() { return outputThreadPriority_; }
+int XmlParamsValidator::getTuioUdpChannelOneFrameRate() { return tuioUdpChannelOneFrameRate_; }
+int XmlParamsValidator::getTuioUdpChannelTwoFrameRate() { return tuioUdpChannelTwoFrameRate_; }
+int XmlParamsValidator::getFlashXmlChannelFrameRate()   { return flashXmlChannelFrameRate_; }
+QString XmlParamsValidator::getTuioUdpChannelOneProfile() { return tuioUdpChannelOneProfile_; }
+QString XmlParamsValidator::getTuioUdpChannelTwoProfile() { return tuioUdpChannelTwoProfile_; }
+bool XmlParamsValidator::useWebSocketChannel()        { return useWebSocketChannel_; }
+int XmlParamsValidator::getWebSocketChannelPort()     { return webSocketChannelPort_; }
+bool XmlParamsValidator::useWebSocketDeflate()        { return useWebSocketDeflate_; }
+int XmlParamsValidator::getWebSocketChannelFrameRate() { return webSocketChannelFrameRate_; }
+bool XmlParamsValidator::useSharedMemoryChannel()     { return useSharedMemoryChannel_; }
+QString XmlParamsValidator::getSharedMemoryName()     { return sharedMemoryName_; }
+std::vector<XmlParamsValidator::UdpEndpoint> XmlParamsValidator::getUdpEndpoints() { return udpEndpoints_; }
 
 // unchecked setters
 void XmlParamsValidator::useGlobalHook( bool b )   { useGlobalHook_ = b; }
@@ -230,3 +740,24 @@ void XmlParamsValidator::setFlashXmlChannelPort( int port )   { flashXmlChannelP
 void XmlParamsValidator::useTuioUdpChannelOne( bool b ) { useTuioUdpChannelOne_ = b; }
 void XmlParamsValidator::useTuioUdpChannelTwo( bool b ) { useTuioUdpChannelTwo_ = b; }
 void XmlParamsValidator::useFlashXmlChannel( bool b )   { useFlashXmlChannel_ = b; }
+void XmlParamsValidator::setFrameCoalescingTime( int milliseconds ) { frameCoalescingTime_ = milliseconds; }
+void XmlParamsValidator::setIdleExpiryPrecision( int milliseconds ) { idleExpiryPrecision_ = milliseconds; }
+void XmlParamsValidator::setMotionPrediction( const std::string & model ) { motionPrediction_ = model.c_str(); }
+void XmlParamsValidator::setPredictionHorizon( int milliseconds ) { predictionHorizon_ = milliseconds; }
+void XmlParamsValidator::setDeadBand( int pixels ) { deadBand_ = pixels; }
+void XmlParamsValidator::setSettleTime( int milliseconds ) { settleTime_ = milliseconds; }
+void XmlParamsValidator::setQuantization( int steps ) { quantization_ = steps; }
+void XmlParamsValidator::setOutputThreadCpu( int cpu ) { outputThreadCpu_ = cpu; }
+void XmlParamsValidator::setOutputThreadPriority( int priority ) { outputThreadPriority_ = priority; }
+void XmlParamsValidator::setTuioUdpChannelOneFrameRate( int framesPerSecond ) { tuioUdpChannelOneFrameRate_ = framesPerSecond; }
+void XmlParamsValidator::setTuioUdpChannelTwoFrameRate( int framesPerSecond ) { tuioUdpChannelTwoFrameRate_ = framesPerSecond; }
+void XmlParamsValidator::setFlashXmlChannelFrameRate( int framesPerSecond )   { flashXmlChannelFrameRate_ = framesPerSecond; }
+void XmlParamsValidator::setTuioUdpChannelOneProfile( const std::string & profile ) { tuioUdpChannelOneProfile_ = profile.c_str(); }
+void XmlParamsValidator::setTuioUdpChannelTwoProfile( const std::string & profile ) { tuioUdpChannelTwoProfile_ = profile.c_str(); }
+void XmlParamsValidator::useWebSocketChannel( bool b )                   { useWebSocketChannel_ = b; }
+void XmlParamsValidator::setWebSocketChannelPort( int port )             { webSocketChannelPort_ = port; }
+void XmlParamsValidator::useWebSocketDeflate( bool b )                   { useWebSocketDeflate_ = b; }
+void XmlParamsValidator::setWebSocketChannelFrameRate( int framesPerSecond ) { webSocketChannelFrameRate_ = framesPerSecond; }
+void XmlParamsValidator::useSharedMemoryChannel( bool b )                { useSharedMemoryChannel_ = b; }
+void XmlParamsValidator::setSharedMemoryName( const std::string & name ) { sharedMemoryName_ = name.c_str(); }
+void XmlParamsValidator::setUdpEndpoints( const std::vector<UdpEndpoint> & endpoints ) { udpEndpoints_ = endpoints; }
@@ -34,12 +34,25 @@ PURPOSE: Basic validation of values from an XML configuration file.
 #define HOOKSXML_XMLPARAMSVALIDATOR_H
 
 #include <QString>
+#include <vector>
 
 namespace hooksXml
 {
     class XmlParamsValidator
     {
     public:
+        /**
+         * An extra TUIO UDP destination, besides UDP channels one and two.
+         */
+        struct UdpEndpoint
+        {
+            QString host;
+            int port;
+            bool enabled;
+            int frameRate;
+            QString profile;
+        };
+
         XmlParamsValidator();
         virtual ~XmlParamsValidator();
 
@@ -56,6 +69,28 @@ namespace hooksXml
         void useTuioUdpChannelOne( const QString & s );
         void useTuioUdpChannelTwo( const QString & s );
         void useFlashXmlChannel( const QString & s );
+        void setFrameCoalescingTime( const QString & s );
+        void setIdleExpiryPrecision( const QString & s );
+        void setMotionPrediction( const QString & s );
+        void setPredictionHorizon( const QString & s );
+        void setDeadBand( const QString & s );
+        void setSettleTime( const QString & s );
+        void setQuantization( const QString & s );
+        void setOutputThreadCpu( const QString & s );
+        void setOutputThreadPriority( const QString & s );
+        void setTuioUdpChannelOneFrameRate( const QString & s );
+        void setTuioUdpChannelTwoFrameRate( const QString & s );
+        void setFlashXmlChannelFrameRate( const QString & s );
+        void setTuioUdpChannelOneProfile( const QString & s );
+        void setTuioUdpChannelTwoProfile( const QString & s );
+        void useWebSocketChannel( const QString & s );
+        void setWebSocketChannelPort( const QString & s );
+        void useWebSocketDeflate( const QString & s );
+        void setWebSocketChannelFrameRate( const QString & s );
+        void useSharedMemoryChannel( const QString & s );
+        void setSharedMemoryName( const QString & s );
+        void addUdpEndpoint( const QString & host, const QString & port, const QString & enabled,
+                             const QString & frameRate, const QString & profile );
 
         // getters
         bool useGlobalHook();
@@ -66,6 +101,27 @@ namespace hooksXml
         bool useTuioUdpChannelOne();
         bool useTuioUdpChannelTwo();
         bool useFlashXmlChannel();
+        int getFrameCoalescingTime();
+        int getIdleExpiryPrecision();
+        QString getMotionPrediction();
+        int getPredictionHorizon();
+        int getDeadBand();
+        int getSettleTime();
+        int getQuantization();
+        int getOutputThreadCpu();
+        int getOutputThreadPriority();
+        int getTuioUdpChannelOneFrameRate();
+        int getTuioUdpChannelTwoFrameRate();
+        int getFlashXmlChannelFrameRate();
+        QString getTuioUdpChannelOneProfile();
+        QString getTuioUdpChannelTwoProfile();
+        bool useWebSocketChannel();
+        int getWebSocketChannelPort();
+        bool useWebSocketDeflate();
+        int getWebSocketChannelFrameRate();
+        bool useSharedMemoryChannel();
+        QString getSharedMemoryName();
+        std::vector<UdpEndpoint> getUdpEndpoints();
 
         // unchecked setters
         void useGlobalHook( bool b );
@@ -76,6 +132,27 @@ namespace hooksXml
         void useTuioUdpChannelOne( bool b );
         void useTuioUdpChannelTwo( bool b );
         void useFlashXmlChannel( bool b );
+        void setFrameCoalescingTime( int milliseconds );
+        void setIdleExpiryPrecision( int milliseconds );
+        void setMotionPrediction( const std::string & model );
+        void setPredictionHorizon( int milliseconds );
+        void setDeadBand( int pixels );
+        void setSettleTime( int milliseconds );
+        void setQuantization( int steps );
+        void setOutputThreadCpu( int cpu );
+        void setOutputThreadPriority( int priority );
+        void setTuioUdpChannelOneFrameRate( int framesPerSecond );
+        void setTuioUdpChannelTwoFrameRate( int framesPerSecond );
+        void setFlashXmlChannelFrameRate( int framesPerSecond );
+        void setTuioUdpChannelOneProfile( const std::string & profile );
+        void setTuioUdpChannelTwoProfile( const std::string & profile );
+        void useWebSocketChannel( bool b );
+        void setWebSocketChannelPort( int port );
+        void useWebSocketDeflate( bool b );
+        void setWebSocketChannelFrameRate( int framesPerSecond );
+        void useSharedMemoryChannel( bool b );
+        void setSharedMemoryName( const std::string & name );
+        void setUdpEndpoints( const std::vector<UdpEndpoint> & endpoints );
 
     private:
         QString xmlConfigFilename_;
@@ -87,6 +164,27 @@ namespace hooksXml
         bool useTuioUdpChannelOne_,
              useTuioUdpChannelTwo_,
              useFlashXmlChannel_;
+        int frameCoalescingTime_,
+            idleExpiryPrecision_,
+            predictionHorizon_,
+            deadBand_,
+            settleTime_,
+            quantization_,
+            outputThreadCpu_,
+            outputThreadPriority_,
+            tuioUdpChannelOneFrameRate_,
+            tuioUdpChannelTwoFrameRate_,
+            flashXmlChannelFrameRate_;
+        QString motionPrediction_,
+                tuioUdpChannelOneProfile_,
+                tuioUdpChannelTwoProfile_;
+        bool useWebSocketChannel_,
+             useWebSocketDeflate_;
+        int webSocketChannelPort_,
+            webSocketChannelFrameRate_;
+        bool useSharedMemoryChannel_;
+        QString sharedMemoryName_;
+        std::vector<UdpEndpoint> udpEndpoints_;
     };
 }
 
@@ -76,6 +76,9 @@ QString XmlParamsWriter::getSettingsAsXml( hooksXml::XmlParamsValidator * valida
     QString xml( "<TouchHooks2Tuio>\n\n" );
     xml.append( getHooksXml( validator ) );
     xml.append( getNetworkXml( validator ) );
+    xml.append( getFramesXml( validator ) );
+    xml.append( getOutputXml( validator ) );
+    xml.append( getUdpEndpointsXml( validator ) );
     xml.append( "</TouchHooks2Tuio>\n" );
     return xml;
 }
@@ -102,6 +105,58 @@ QString XmlParamsWriter::getNetworkXml( hooksXml::XmlParamsValidator * validator
     return xml;
 }
 
+QString XmlParamsWriter::getFramesXml( hooksXml::XmlParamsValidator * validator )
+{
+    QString xml( "    <Frames>\n" );
+    xml.append( createXmlFromInt( "frameCoalescingTime", validator->getFrameCoalescingTime() ) );
+    xml.append( createXmlFromInt( "idleExpiryPrecision", validator->getIdleExpiryPrecision() ) );
+    xml.append( createXmlFromString( "motionPrediction", validator->getMotionPrediction() ) );
+    xml.append( createXmlFromInt( "predictionHorizon", validator->getPredictionHorizon() ) );
+    xml.append( createXmlFromInt( "deadBand", validator->getDeadBand() ) );
+    xml.append( createXmlFromInt( "settleTime", validator->getSettleTime() ) );
+    xml.append( createXmlFromInt( "quantization", validator->getQuantization() ) );
+    xml.append( "    </Frames>\n\n" );
+    return xml;
+}
+
+QString XmlParamsWriter::getOutputXml( hooksXml::XmlParamsValidator * validator )
+{
+    QString xml( "    <Output>\n" );
+    xml.append( createXmlFromInt( "outputThreadCpu", validator->getOutputThreadCpu() ) );
+    xml.append( createXmlFromInt( "outputThreadPriority", validator->getOutputThreadPriority() ) );
+    xml.append( createXmlFromInt( "tuioUdpChannelOneFrameRate", validator->getTuioUdpChannelOneFrameRate() ) );
+    xml.append( createXmlFromInt( "tuioUdpChannelTwoFrameRate", validator->getTuioUdpChannelTwoFrameRate() ) );
+    xml.append( createXmlFromInt( "flashXmlChannelFrameRate", validator->getFlashXmlChannelFrameRate() ) );
+    xml.append( createXmlFromString( "tuioUdpChannelOneProfile", validator->getTuioUdpChannelOneProfile() ) );
+    xml.append( createXmlFromString( "tuioUdpChannelTwoProfile", validator->getTuioUdpChannelTwoProfile() ) );
+    xml.append( createXmlFromBool( "useWebSocketChannel", validator->useWebSocketChannel() ) );
+    xml.append( createXmlFromInt( "webSocketChannelPort", validator->getWebSocketChannelPort() ) );
+    xml.append( createXmlFromBool( "webSocketDeflate", validator->useWebSocketDeflate() ) );
+    xml.append( createXmlFromInt( "webSocketChannelFrameRate", validator->getWebSocketChannelFrameRate() ) );
+    xml.append( createXmlFromBool( "useSharedMemoryChannel", validator->useSharedMemoryChannel() ) );
+    xml.append( createXmlFromString( "sharedMemoryName", validator->getSharedMemoryName() ) );
+    xml.append( "    </Output>\n\n" );
+    return xml;
+}
+
+QString XmlParamsWriter::getUdpEndpointsXml( hooksXml::XmlParamsValidator * validator )
+{
+    std::vector<hooksXml::XmlParamsValidator::UdpEndpoint> endpoints = validator->getUdpEndpoints();
+    QString xml( "    <UdpEndpoints>\n" );
+
+    for( size_t i = 0; i < endpoints.size(); ++i ) {
+        xml.append( "        <udpEndpoint>\n" );
+        xml.append( "    " + createXmlFromString( "host", endpoints[i].host ) );
+        xml.append( "    " + createXmlFromInt( "port", endpoints[i].port ) );
+        xml.append( "    " + createXmlFromBool( "enabled", endpoints[i].enabled ) );
+        xml.append( "    " + createXmlFromInt( "frameRate", endpoints[i].frameRate ) );
+        xml.append( "    " + createXmlFromString( "profile", endpoints[i].profile ) );
+        xml.append( "        </udpEndpoint>\n" );
+    }
+    xml.append( "    </UdpEndpoints>\n\n" );
+    return xml;
+}
+
 QString XmlParamsWriter::createXmlFromBool( QString tag, bool b )
 {
     return createXmlFromString( tag, (b ? "true" : "false") );
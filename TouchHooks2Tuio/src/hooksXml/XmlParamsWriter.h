@@ -56,6 +56,9 @@ namespace hooksXml
         QString getSettingsAsXml( hooksXml::XmlParamsValidator * validator );
         QString getHooksXml( hooksXml::XmlParamsValidator * validator );
         QString getNetworkXml( hooksXml::XmlParamsValidator * validator );
+        QString getFramesXml( hooksXml::XmlParamsValidator * validator );
+        QString getOutputXml( hooksXml::XmlParamsValidator * validator );
+        QString getUdpEndpointsXml( hooksXml::XmlParamsValidator * validator );
         QString createXmlFromBool( QString tag, bool b );
         QString createXmlFromInt( QString tag, int n );
         QString createXmlFromDouble( QString tag, double n );
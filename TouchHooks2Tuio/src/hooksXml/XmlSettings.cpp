@@ -79,6 +79,14 @@ void XmlSettings::updateServerHostAndPorts( hooksGui::TouchHooksMainWindow * mai
                                          validator_->getTuioUdpChannelOnePort(),
                                          validator_->getTuioUdpChannelTwoPort(),
                                          validator_->getFlashXmlChannelPort() );
+
+    std::vector<hooksXml::XmlParamsValidator::UdpEndpoint> endpoints = validator_->getUdpEndpoints();
+    touchMessageListener->clearUdpEndpoints();
+
+    for( size_t i = 0; i < endpoints.size(); ++i ) {
+        touchMessageListener->addUdpEndpoint( endpoints[i].host, endpoints[i].port, endpoints[i].enabled,
+                                              endpoints[i].frameRate, endpoints[i].profile );
+    }
 }
 
 void XmlSettings::setTuioChannelsOnOrOff( hooksGui::TouchHooksMainWindow * mainWindow )
@@ -95,6 +103,40 @@ void XmlSettings::setTuioChannelsOnOrOff( hooksGui::TouchHooksMainWindow * mainW
                                           validator_->useFlashXmlChannel() );
 }
 
+void XmlSettings::updateFrameSettings( hooksGui::TouchHooksMainWindow * mainWindow )
+{
+    std::shared_ptr<hooksCore::TouchMessageListener>
+    touchMessageListener = mainWindow->touchMessageListener();
+
+    touchMessageListener->setFrameCoalescingTime( validator_->getFrameCoalescingTime() );
+    touchMessageListener->setIdleExpiryPrecision( validator_->getIdleExpiryPrecision() );
+    touchMessageListener->setMotionPrediction( validator_->getMotionPrediction(),
+                                               validator_->getPredictionHorizon() );
+    touchMessageListener->setUpdateFilter( validator_->getDeadBand(),
+                                           validator_->getSettleTime(),
+                                           validator_->getQuantization() );
+}
+
+void XmlSettings::updateOutputThreadSettings( hooksGui::TouchHooksMainWindow * mainWindow )
+{
+    std::shared_ptr<hooksCore::TouchMessageListener>
+    touchMessageListener = mainWindow->touchMessageListener();
+
+    touchMessageListener->setOutputThreadSettings( validator_->getOutputThreadCpu(),
+                                                   validator_->getOutputThreadPriority() );
+    touchMessageListener->setOutputFrameRates( validator_->getTuioUdpChannelOneFrameRate(),
+                                               validator_->getTuioUdpChannelTwoFrameRate(),
+                                               validator_->getFlashXmlChannelFrameRate() );
+    touchMessageListener->setOutputProfiles( validator_->getTuioUdpChannelOneProfile(),
+                                             validator_->getTuioUdpChannelTwoProfile() );
+    touchMessageListener->setWebSocketChannel( validator_->useWebSocketChannel(),
+                                               validator_->getWebSocketChannelPort(),
+                                               validator_->useWebSocketDeflate(),
+                                               validator_->getWebSocketChannelFrameRate() );
+    touchMessageListener->setSharedMemoryChannel( validator_->useSharedMemoryChannel(),
+                                                  validator_->getSharedMemoryName() );
+}
+
 void XmlSettings::initializeGlobalTouchHook( hooksGui::TouchHooksMainWindow * mainWindow )
 {
     if( validator_->useGlobalHook() ) {
@@ -121,6 +163,39 @@ void XmlSettings::saveSettingsToXmlFile( hooksGui::TouchHooksMainWindow * mainWi
     validator_->useTuioUdpChannelOne( touchMessageListener->useTuioUdpChannelOne() );
     validator_->useTuioUdpChannelTwo( touchMessageListener->useTuioUdpChannelTwo() );
     validator_->useFlashXmlChannel( touchMessageListener->useFlashXmlTcpChannel() );
+    validator_->setFrameCoalescingTime( touchMessageListener->frameCoalescingTime() );
+    validator_->setIdleExpiryPrecision( touchMessageListener->idleExpiryPrecision() );
+    validator_->setMotionPrediction( touchMessageListener->motionPrediction().toStdString() );
+    validator_->setPredictionHorizon( touchMessageListener->predictionHorizon() );
+    validator_->setDeadBand( touchMessageListener->deadBand() );
+    validator_->setSettleTime( touchMessageListener->settleTime() );
+    validator_->setQuantization( touchMessageListener->quantization() );
+    validator_->setOutputThreadCpu( touchMessageListener->outputThreadCpu() );
+    validator_->setOutputThreadPriority( touchMessageListener->outputThreadPriority() );
+    validator_->setTuioUdpChannelOneFrameRate( touchMessageListener->tuioUdpChannelOneFrameRate() );
+    validator_->setTuioUdpChannelTwoFrameRate( touchMessageListener->tuioUdpChannelTwoFrameRate() );
+    validator_->setFlashXmlChannelFrameRate( touchMessageListener->flashXmlChannelFrameRate() );
+    validator_->setTuioUdpChannelOneProfile( touchMessageListener->tuioUdpChannelOneProfile().toStdString() );
+    validator_->setTuioUdpChannelTwoProfile( touchMessageListener->tuioUdpChannelTwoProfile().toStdString() );
+    validator_->useWebSocketChannel( touchMessageListener->useWebSocketChannel() );
+    validator_->setWebSocketChannelPort( touchMessageListener->webSocketChannelPort() );
+    validator_->useWebSocketDeflate( touchMessageListener->webSocketDeflate() );
+    validator_->setWebSocketChannelFrameRate( touchMessageListener->webSocketChannelFrameRate() );
+    validator_->useSharedMemoryChannel( touchMessageListener->useSharedMemoryChannel() );
+    validator_->setSharedMemoryName( touchMessageListener->sharedMemoryName().toStdString() );
+
+    std::vector<hooksXml::XmlParamsValidator::UdpEndpoint> endpoints;
+
+    for( int i = 0; i < touchMessageListener->udpEndpointCount(); ++i ) {
+        hooksXml::XmlParamsValidator::UdpEndpoint endpoint;
+        endpoint.host = touchMessageListener->udpEndpointHost( i );
+        endpoint.port = touchMessageListener->udpEndpointPort( i );
+        endpoint.enabled = touchMessageListener->useUdpEndpoint( i );
+        endpoint.frameRate = touchMessageListener->udpEndpointFrameRate( i );
+        endpoint.profile = touchMessageListener->udpEndpointProfile( i );
+        endpoints.push_back( endpoint );
+    }
+    validator_->setUdpEndpoints( endpoints );
 
     useValidatorToUpdateXmlFile();
 }
@@ -57,6 +57,8 @@ namespace hooksXml
         void readXmlConfigFile();
         void updateServerHostAndPorts( hooksGui::TouchHooksMainWindow * mainWindow );
         void setTuioChannelsOnOrOff( hooksGui::TouchHooksMainWindow * mainWindow );
+        void updateFrameSettings( hooksGui::TouchHooksMainWindow * mainWindow );
+        void updateOutputThreadSettings( hooksGui::TouchHooksMainWindow * mainWindow );
         void initializeGlobalTouchHook( hooksGui::TouchHooksMainWindow * mainWindow );
         void saveSettingsToXmlFile( hooksGui::TouchHooksMainWindow * mainWindow );
 
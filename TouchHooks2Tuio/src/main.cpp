@@ -50,7 +50,9 @@ CREATED: 6/16/2015
 #include <Windows.h>
 
 // function prototypes
+QString cmdLineValue( int, char * [], const QString & );
 QString localServerName( int, char * [] );
+QString pointerEventRecordingPath( int, char * [] );
 void processBooleanCmdLineArgs( int, char * [], std::shared_ptr<hooksXml::XmlSettings>  );
 void processBooleanArg( const QString &, std::shared_ptr<hooksXml::XmlSettings> );
 
@@ -63,9 +65,16 @@ int main( int argc, char * argv [] )
     processBooleanCmdLineArgs( argc, argv, mainWindow.xmlSettings() );
 
     mainWindow.updateServerHostAndPorts();
+    mainWindow.updateFrameSettings();
+    mainWindow.updateOutputThreadSettings();
     mainWindow.initializeConsolePidForDebugging( (int)GetCurrentProcessId() );
     mainWindow.initializeCustomMessagesForHook();
+    mainWindow.initializePointerEventRing();
     mainWindow.initializeTuioServers();
+
+    if( !pointerEventRecordingPath( argc, argv ).isEmpty() ) {
+        mainWindow.startPointerEventRecording( pointerEventRecordingPath( argc, argv ) );
+    }
     mainWindow.setTuioChannelsOnOrOff();
     mainWindow.initializeLocalServer( localServerName( argc, argv ) );
     mainWindow.writeScreenInfo();
@@ -78,24 +87,43 @@ int main( int argc, char * argv [] )
 }
 
 /*******************************************************************************
-If a command line arg of the form localServerName=someName is found, 
-then someName will be returned.  Otherwise, returns an empty string.
+If a command line arg of the form key=someValue is found (the key is given
+with its '=' and matched without regard to case), then someValue will be
+returned.  Otherwise, returns an empty string.
 *******************************************************************************/
-QString localServerName( int argc, char * argv[] )
+QString cmdLineValue( int argc, char * argv[], const QString & key )
 {
-    QString name = "";
-    QString key = "localServerName=";
+    QString value = "";
 
     for( int i = 1; i < argc; ++i ) {
         QString arg( argv[i] );
         int numCharsInValue = arg.size() - key.size();
 
         if( numCharsInValue > 0 && arg.startsWith( key, Qt::CaseInsensitive )  ) {
-            name = arg.right( numCharsInValue );
+            value = arg.right( numCharsInValue );
             break;
         }
     }
-    return name;
+    return value;
+}
+
+/*******************************************************************************
+If a command line arg of the form localServerName=someName is found, 
+then someName will be returned.  Otherwise, returns an empty string.
+*******************************************************************************/
+QString localServerName( int argc, char * argv[] )
+{
+    return cmdLineValue( argc, argv, "localServerName=" );
+}
+
+/*******************************************************************************
+If a command line arg of the form recordPointerEvents=someFile is found, every
+pointer event is recorded to someFile for lib/TUIO_CPP/PointerReplay to play
+back.  Otherwise, returns an empty string.
+*******************************************************************************/
+QString pointerEventRecordingPath( int argc, char * argv[] )
+{
+    return cmdLineValue( argc, argv, "recordPointerEvents=" );
 }
 
 /*******************************************************************************
@@ -0,0 +1,157 @@
+/*******************************************************************************
+BenchSupport
+
+PURPOSE: The helpers every bench and check program of the Makefile uses: a
+         wall clock, expect(), OscSenders that count or keep what they are
+         given, an OscReceiver without networking and, on request, a global
+         operator new that counts.
+
+NOTES:
+Each bench and check is one source file, so everything here is static or
+inline and the header is included once per program.
+
+expect() writes the name of a failed check to stderr and counts it in
+errors; a program prints "OK" or "FAILED" at the end and exits with a
+non-zero status if errors is not 0, which is what "make check" looks at.
+
+A program that counts heap allocations defines BENCH_COUNT_ALLOCATIONS
+before it includes this header.  The global operator new and delete are
+then replaced: heapAllocations counts the calls to operator new and
+heapBytes the bytes still allocated.  Both are atomic, so allocations made
+by other threads (TuioCursorOutputThread, say) are counted too.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_BENCHSUPPORT_H
+#define INCLUDED_BENCHSUPPORT_H
+
+#include "OscReceiver.h"
+#include "UdpSender.h"
+#include <sys/time.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+inline double seconds()
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static unsigned int errors = 0;
+
+inline void expect( const char * name, bool ok )
+{
+    if( !ok ) {
+        fprintf( stderr, "%s: failed\n", name );
+        ++errors;
+    }
+}
+
+inline void expect( const char * name, const std::string & actual, const std::string & expected )
+{
+    if( actual != expected ) {
+        fprintf( stderr, "%s: expected \"%s\", got \"%s\"\n", name, expected.c_str(), actual.c_str() );
+        ++errors;
+    }
+}
+
+/**
+ * Counts the bundles it is given instead of sending them.
+ */
+class SinkSender : public TUIO::OscSender
+{
+public:
+    SinkSender() : packets( 0 ), bytes( 0 )
+    {
+        buffer_size = MAX_UDP_SIZE;
+        local = true;
+    }
+
+    bool sendOscPacket( osc::OutboundPacketStream * bundle )
+    {
+        ++packets;
+        bytes += bundle->Size();
+        return true;
+    }
+
+    bool isConnected() { return true; }
+
+    std::atomic<unsigned long long> packets,
+                                   bytes;
+};
+
+/**
+ * Keeps a copy of every bundle it is given.
+ */
+class CapturingSender : public TUIO::OscSender
+{
+public:
+    CapturingSender() { buffer_size = 64 * 1024; local = true; }
+
+    bool sendOscPacket( osc::OutboundPacketStream * bundle )
+    {
+        packets.push_back( std::string( bundle->Data(), bundle->Size() ) );
+        return true;
+    }
+    bool isConnected() { return true; }
+
+    std::vector<std::string> packets;
+};
+
+/**
+ * Hands packets to its clients through OscReceiver.
+ */
+class LoopbackReceiver : public TUIO::OscReceiver
+{
+public:
+    void connect( bool lock = false ) { connected = true; }
+    void disconnect() { connected = false; }
+
+    void send( const char * data, unsigned long size )
+    {
+        ProcessPacket( data, (int)size, IpEndpointName() );
+    }
+    void send( const std::string & packet ) { send( packet.data(), packet.size() ); }
+    void send( const osc::OutboundPacketStream & packet ) { send( packet.Data(), packet.Size() ); }
+};
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+// Each block starts with its size; 16 bytes keep malloc's alignment.
+static const size_t HEAP_HEADER_SIZE = 16;
+static std::atomic<unsigned long long> heapAllocations( 0 );
+static std::atomic<long long> heapBytes( 0 );
+
+void * operator new( size_t size )
+{
+    char * p = (char *)malloc( size + HEAP_HEADER_SIZE );
+
+    if( p == NULL ) {
+        throw std::bad_alloc();
+    }
+    *(size_t *)p = size;
+    ++heapAllocations;
+    heapBytes += (long long)size;
+    return p + HEAP_HEADER_SIZE;
+}
+
+void operator delete( void * p ) noexcept
+{
+    if( p != NULL ) {
+        char * block = (char *)p - HEAP_HEADER_SIZE;
+        heapBytes -= (long long)*(size_t *)block;
+        free( block );
+    }
+}
+
+void operator delete( void * p, size_t ) noexcept
+{
+    operator delete( p );
+}
+#endif
+
+#endif /* INCLUDED_BENCHSUPPORT_H */
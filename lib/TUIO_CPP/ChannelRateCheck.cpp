@@ -0,0 +1,219 @@
+/*******************************************************************************
+ChannelRateCheck
+
+PURPOSE: Checks that TuioCursorServer sends rate limited channels the latest
+         cursor state at their own frame rate without losing or reordering
+         adds and removes, and counts what each channel is sent.
+
+NOTES:
+Four OscSenders are added to the server, which decode and write down every
+bundle they get: one that gets every frame, two limited to 60 frames per
+second and one to 10.  The UDP and Flash XML channels are turned off.  The
+server is driven directly with frame times from a counter, and
+sendHeldFrames() is called whenever nextHeldFrameTime() comes up, as
+TuioCursorOutputThread does.
+
+The checks: a tap shorter than a tick (add and remove 2 ms apart, in the
+middle of a tick) reaches every channel as an add and a remove, in order and
+with the move that was held back for the other cursor; a cursor that moves
+between ticks and is then removed reaches the limited channels with that
+move before the alive message without it; then one cursor moves
+every 4 ms (250 Hz input) for SECONDS seconds, and each channel must end up
+with its last position after the input stops, at about its frame rate.  The
+two 60 Hz channels must get the same bundles, which are encoded once.
+
+Usage: ChannelRateCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TuioCursorServer.h"
+#include "osc/OscReceivedElements.h"
+#include <vector>
+
+using namespace TUIO;
+
+static const int SECONDS = 4,
+                 INPUT_INTERVAL = 4000; // microseconds
+
+/**
+ * Writes each bundle down as "alive 0 1; set 0 0.25; " with fseq left out,
+ * and keeps the last x position set for session 0.
+ */
+class RecordingSender : public OscSender
+{
+public:
+    RecordingSender() : bytes( 0 ), lastX( -1.0f )
+    {
+        buffer_size = MAX_UDP_SIZE;
+        local = true;
+    }
+
+    bool sendOscPacket( osc::OutboundPacketStream * bundle )
+    {
+        osc::ReceivedBundle received( osc::ReceivedPacket( bundle->Data(), (osc::int32)bundle->Size() ) );
+        std::string packet;
+        char buffer[32];
+
+        for( osc::ReceivedBundle::const_iterator i = received.ElementsBegin(); i != received.ElementsEnd(); ++i ) {
+            osc::ReceivedMessage message( *i );
+            osc::ReceivedMessage::const_iterator arg = message.ArgumentsBegin();
+            std::string command = (arg++)->AsString();
+
+            if( command == "alive" ) {
+                packet += "alive";
+
+                for( ; arg != message.ArgumentsEnd(); ++arg ) {
+                    snprintf( buffer, sizeof( buffer ), " %d", (int)arg->AsInt32() );
+                    packet += buffer;
+                }
+                packet += "; ";
+            }
+            else if( command == "set" ) {
+                int id = (int)(arg++)->AsInt32();
+                float x = (arg++)->AsFloat();
+                snprintf( buffer, sizeof( buffer ), "set %d %.2f; ", id, x );
+                packet += buffer;
+
+                if( id == 0 ) {
+                    lastX = x;
+                }
+            }
+        }
+        packets.push_back( packet );
+        bytes += bundle->Size();
+        return true;
+    }
+
+    bool isConnected() { return true; }
+
+    std::string take()
+    {
+        std::string s;
+
+        for( size_t i = 0; i < packets.size(); ++i ) {
+            s += "[" + packets[i] + "]";
+        }
+        packets.clear();
+        return s;
+    }
+
+    std::vector<std::string> packets;
+    unsigned long bytes;
+    float lastX;
+};
+
+static long clockMicroSeconds = 1000000;
+
+static TuioTime now()
+{
+    return TuioTime( clockMicroSeconds / 1000000, clockMicroSeconds % 1000000 );
+}
+
+static void sendHeldFrames( TuioCursorServer & server )
+{
+    long heldFrameTime = server.nextHeldFrameTime();
+
+    if( heldFrameTime >= 0 && heldFrameTime <= now().getTotalMilliseconds() ) {
+        server.sendHeldFrames( now() );
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    RecordingSender everyFrame,
+                    sixty,
+                    sixtyToo,
+                    ten;
+    TuioCursorServer server;
+    server.useFirstUdpSender( false );
+    server.useSecondUdpSender( false );
+    server.useFlashXmlTcpSender( false );
+    server.addOscSender( &everyFrame );
+    server.addOscSender( &sixty, 60 );
+    server.addOscSender( &sixtyToo, 60 );
+    server.addOscSender( &ten, 10 );
+    everyFrame.take(); // the empty bundles of the server's own start
+    sixty.take();
+    sixtyToo.take();
+    ten.take();
+
+    server.initFrame( now() );
+    server.addTuioCursor( 9, 0.1f, 0.1f );
+    server.commitFrame();
+    clockMicroSeconds += 4000;
+    server.initFrame( now() );
+    server.updateTuioCursor( 9, 0.2f, 0.2f );
+    server.commitFrame();
+    clockMicroSeconds += 4000;
+    server.initFrame( now() );
+    server.addTuioCursor( 1, 0.5f, 0.5f );
+    server.commitFrame();
+    clockMicroSeconds += 2000;
+    server.initFrame( now() );
+    server.removeTuioCursor( 1 );
+    server.commitFrame();
+
+    expect( "tap: every frame", everyFrame.take(), "[alive 0; set 0 0.10; ][alive 0; set 0 0.20; ]"
+                                                   "[alive 0 1; set 1 0.50; ][alive 0; ]" );
+    expect( "tap: 10 Hz", ten.take(), "[alive 0; set 0 0.10; ][alive 0 1; set 0 0.20; set 1 0.50; ][alive 0; ]" );
+    std::string sixtyTap = sixty.take();
+    expect( "tap: 60 Hz", sixtyTap, "[alive 0; set 0 0.10; ][alive 0 1; set 0 0.20; set 1 0.50; ][alive 0; ]" );
+    expect( "tap: 60 Hz shared", sixtyToo.take() == sixtyTap );
+
+    clockMicroSeconds += 2000;
+    server.initFrame( now() );
+    server.addTuioCursor( 2, 0.5f, 0.5f );
+    server.commitFrame();
+    clockMicroSeconds += 2000;
+    server.initFrame( now() );
+    server.updateTuioCursor( 2, 0.7f, 0.5f );
+    server.commitFrame();
+    clockMicroSeconds += 1000;
+    server.initFrame( now() );
+    server.removeTuioCursor( 2 );
+    server.commitFrame();
+
+    expect( "held move: every frame", everyFrame.take(), "[alive 0 2; set 2 0.50; ][alive 0 2; set 2 0.70; ][alive 0; ]" );
+    expect( "held move: 10 Hz", ten.take(), "[alive 0 2; set 2 0.50; ][set 2 0.70; alive 0; ]" );
+    std::string sixtyHeld = sixty.take();
+    expect( "held move: 60 Hz", sixtyHeld, "[alive 0 2; set 2 0.50; ][set 2 0.70; alive 0; ]" );
+    expect( "held move: 60 Hz shared", sixtyToo.take() == sixtyHeld );
+
+    float x = 0.0f;
+    long start = clockMicroSeconds;
+
+    while( clockMicroSeconds < start + SECONDS * 1000000L ) {
+        clockMicroSeconds += INPUT_INTERVAL;
+        x = (float)((clockMicroSeconds - start) % 1000000) / 1000000;
+        server.initFrame( now() );
+        server.updateTuioCursor( 9, x, 0.5f );
+        server.commitFrame();
+        sendHeldFrames( server );
+    }
+    size_t everyFrameCount = everyFrame.packets.size(),
+           sixtyCount = sixty.packets.size(),
+           tenCount = ten.packets.size();
+    expect( "coalesce: 60 Hz shared", sixty.packets == sixtyToo.packets );
+
+    // The input stops; the held back positions go out at the next ticks.
+    for( int i = 0; i < 200; ++i ) {
+        clockMicroSeconds += 1000;
+        sendHeldFrames( server );
+    }
+    expect( "coalesce: nothing held", server.nextHeldFrameTime() < 0 );
+    expect( "coalesce: last position, every frame", everyFrame.lastX == x );
+    expect( "coalesce: last position, 60 Hz", sixty.lastX == x && sixtyToo.lastX == x );
+    expect( "coalesce: last position, 10 Hz", ten.lastX == x );
+    expect( "coalesce: 60 Hz rate", sixtyCount >= 59 * SECONDS && sixtyCount <= 60 * SECONDS + 1 );
+    expect( "coalesce: 10 Hz rate", tenCount >= 9 * SECONDS && tenCount <= 10 * SECONDS + 1 );
+
+    printf( "%d s of one cursor moving at %d Hz:\n", SECONDS, 1000000 / INPUT_INTERVAL );
+    printf( "every frame  %6lu bundles  %8lu bytes\n", (unsigned long)everyFrameCount, everyFrame.bytes );
+    printf( "60 Hz        %6lu bundles  %8lu bytes\n", (unsigned long)sixtyCount, sixty.bytes );
+    printf( "10 Hz        %6lu bundles  %8lu bytes\n", (unsigned long)tenCount, ten.bytes );
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/*******************************************************************************
+CursorSnapshotBench
+
+PURPOSE: Measures how long a frame of the shared-memory cursor snapshot
+         takes to become visible to a reader in another process.
+
+NOTES:
+The writer publishes LATENCY_FRAMES frames of LATENCY_CURSORS cursors, one
+every FRAME_INTERVAL microseconds, to a reader in a child process (fork()),
+which takes the time from the publish time in the frame to the moment its
+copy is complete, on the same steady clock, and sends the latencies back
+through a pipe.  It is run with a reader that spins on hasNewFrame() and
+one that sleeps in waitForFrame(); the same timestamps sent over UDP on
+localhost to a blocking recv() are the baseline.  The shared memory names
+have the process ID in them, so runs do not get in each other's way.
+
+CursorSnapshotCheck checks the writer and reader.
+
+Usage: CursorSnapshotBench (Linux)
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "CursorSnapshotWriter.h"
+#include "CursorSnapshotReader.h"
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace TUIO;
+
+static const int LATENCY_FRAMES = 5000,
+                 LATENCY_CURSORS = 10,
+                 FRAME_INTERVAL = 200,      // microseconds
+                 LATENCY_PORT = 3399;
+
+static long long steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static std::string snapshotName( const char * test )
+{
+    char name[64];
+    snprintf( name, sizeof( name ), "CursorSnapshotTest%s%d", test, (int)getpid() );
+    return name;
+}
+
+/**
+ * The child's side: latencies in nanoseconds go back through the pipe.
+ */
+static void readSnapshots( const char * name, bool spin, int pipeFd )
+{
+    CursorSnapshotReader reader;
+    CursorSnapshotFrame frame;
+    std::vector<double> latencies;
+
+    for( int attempt = 0; attempt < 1000 && !reader.open( name ); ++attempt ) {
+        usleep( 1000 );
+    }
+    while( reader.isWriterOpen() ) {
+        if( spin ) {
+            if( !reader.hasNewFrame() ) {
+                continue;
+            }
+        }
+        else if( !reader.waitForFrame( 100 ) ) {
+            continue;
+        }
+        if( reader.read( frame ) && frame.frame != 0 ) {
+            latencies.push_back( (double)(steadyNanoseconds() - frame.publishTime) );
+        }
+    }
+    write( pipeFd, latencies.data(), latencies.size() * sizeof( double ) );
+}
+
+static std::vector<double> collect( int pipeFd, pid_t child )
+{
+    std::vector<double> latencies;
+    double buffer[1024];
+    ssize_t n;
+
+    while( (n = read( pipeFd, buffer, sizeof( buffer ) )) > 0 ) {
+        latencies.insert( latencies.end(), buffer, buffer + n / sizeof( double ) );
+    }
+    close( pipeFd );
+    waitpid( child, NULL, 0 );
+    std::sort( latencies.begin(), latencies.end() );
+    return latencies;
+}
+
+/**
+ * Publishes LATENCY_FRAMES frames to a reader in a child process, which
+ * spins or waits.
+ *
+ * @return the latencies in nanoseconds, sorted.
+ */
+static std::vector<double> measureSnapshot( bool spin, unsigned long & wakeups )
+{
+    std::string name = snapshotName( spin ? "Spin" : "Wait" );
+    CursorSnapshotWriter * writer = new CursorSnapshotWriter( name.c_str() );
+    int fds[2];
+
+    if( pipe( fds ) != 0 ) {
+        return std::vector<double>();
+    }
+    pid_t child = fork();
+
+    if( child == 0 ) {
+        close( fds[0] );
+        readSnapshots( name.c_str(), spin, fds[1] );
+        _exit( 0 );
+    }
+    close( fds[1] );
+    usleep( 100000 ); // for the child to open and start waiting
+
+    std::vector<TuioCursor *> cursors;
+
+    for( int i = 0; i < LATENCY_CURSORS; ++i ) {
+        cursors.push_back( new TuioCursor( TuioTime( 0, 0 ), i, i, 0.0f, 0.0f ) );
+    }
+    for( int n = 1; n <= LATENCY_FRAMES; ++n ) {
+        writer->beginFrame( n, TuioTime( 0, 0 ) );
+
+        for( int i = 0; i < LATENCY_CURSORS; ++i ) {
+            writer->addCursor( cursors[i], (float)i / LATENCY_CURSORS, 0.5f, true );
+        }
+        writer->endFrame();
+        usleep( FRAME_INTERVAL );
+    }
+    wakeups = writer->getWakeups();
+    delete writer;
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        delete cursors[i];
+    }
+    return collect( fds[0], child );
+}
+
+
+static double percentile( const std::vector<double> & sorted, double p )
+{
+    if( sorted.empty() ) {
+        return 0.0;
+    }
+    size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min( i, sorted.size() - 1 )];
+}
+
+static void receiveUdp( int pipeFd )
+{
+    int s = socket( AF_INET, SOCK_DGRAM, 0 );
+    sockaddr_in address = sockaddr_in();
+    address.sin_family = AF_INET;
+    address.sin_port = htons( LATENCY_PORT );
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    bind( s, (sockaddr *)&address, sizeof( address ) );
+    timeval timeout = { 1, 0 }; // in case the last datagram is lost
+    setsockopt( s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout ) );
+    std::vector<double> latencies;
+    long long sent;
+
+    while( recv( s, &sent, sizeof( sent ), 0 ) == sizeof( sent ) && sent != 0 ) {
+        latencies.push_back( (double)(steadyNanoseconds() - sent) );
+    }
+    close( s );
+    write( pipeFd, latencies.data(), latencies.size() * sizeof( double ) );
+}
+
+static void printLatencies( const char * name, const std::vector<double> & sorted )
+{
+    printf( "%-14s %8.0f %8.0f %8.0f %8.0f %9.0f %7lu\n", name,
+            percentile( sorted, 0.5 ), percentile( sorted, 0.9 ), percentile( sorted, 0.99 ),
+            percentile( sorted, 0.999 ), sorted.empty() ? 0.0 : sorted.back(), (unsigned long)sorted.size() );
+}
+
+static std::vector<double> measureUdp()
+{
+    int fds[2];
+
+    if( pipe( fds ) != 0 ) {
+        return std::vector<double>();
+    }
+    pid_t child = fork();
+
+    if( child == 0 ) {
+        close( fds[0] );
+        receiveUdp( fds[1] );
+        _exit( 0 );
+    }
+    close( fds[1] );
+    usleep( 100000 );
+
+    int s = socket( AF_INET, SOCK_DGRAM, 0 );
+    sockaddr_in address = sockaddr_in();
+    address.sin_family = AF_INET;
+    address.sin_port = htons( LATENCY_PORT );
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    for( int n = 1; n <= LATENCY_FRAMES; ++n ) {
+        long long now = steadyNanoseconds();
+        sendto( s, &now, sizeof( now ), 0, (sockaddr *)&address, sizeof( address ) );
+        usleep( FRAME_INTERVAL );
+    }
+    long long end = 0;
+    sendto( s, &end, sizeof( end ), 0, (sockaddr *)&address, sizeof( address ) );
+    close( s );
+    return collect( fds[0], child );
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned long spinWakeups = 0,
+                  waitWakeups = 0;
+    std::vector<double> spin = measureSnapshot( true, spinWakeups ),
+                        waiting = measureSnapshot( false, waitWakeups ),
+                        udp = measureUdp();
+
+    printf( "writer -> reader in another process, %d frames of %d cursors, one every %d us (ns):\n",
+            LATENCY_FRAMES, LATENCY_CURSORS, FRAME_INTERVAL );
+    printf( "               %8s %8s %8s %8s %9s %7s\n", "p50", "p90", "p99", "p99.9", "max", "frames" );
+    printLatencies( "spin poll", spin );
+    printLatencies( "futex wait", waiting );
+    printLatencies( "UDP loopback", udp );
+    return 0;
+}
@@ -0,0 +1,387 @@
+/*******************************************************************************
+CursorSnapshotCheck
+
+PURPOSE: Checks the shared-memory cursor snapshot (CursorSnapshotWriter and
+         CursorSnapshotReader).
+
+NOTES:
+First a TuioCursorServer publishes a few frames to a CursorSnapshotWriter,
+and a reader must get every cursor with its position, speed, state and the
+frame it last changed in; a frame that changes nothing is not published,
+and a removed cursor is gone from the next one.
+
+Then the main thread publishes TORN_FRAMES frames, each with a cursor
+count and positions made from the frame ID and a microsecond or so apart
+(a writer that never stops would starve the reader), while a reader thread
+reads them; every frame read must agree with its own frame ID.  The
+retries are the reads that raced a write.
+
+A reader in a child process is killed while it waits for a frame: the
+writer must still wake it for the next frame, but once it has not checked
+in for CursorSnapshot::WAITER_TIMEOUT the writer must stop.
+
+Last, the writer publishes LATENCY_FRAMES frames, one every FRAME_INTERVAL
+microseconds, to a reader in a child process that spins on hasNewFrame(),
+then to one that sleeps in waitForFrame(): both must get most frames, and
+the writer must wake the waiting reader only.  The shared memory names have
+the process ID in them, so runs do not get in each other's way.
+
+CursorSnapshotBench measures the latencies.
+
+Usage: CursorSnapshotCheck (Linux)
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "CursorSnapshotWriter.h"
+#include "CursorSnapshotReader.h"
+#include "TuioCursorServer.h"
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace TUIO;
+
+static const int LATENCY_FRAMES = 5000,
+                 LATENCY_CURSORS = 10,
+                 FRAME_INTERVAL = 200,      // microseconds
+                 TORN_FRAMES = 500000;
+
+static long long steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static std::string snapshotName( const char * test )
+{
+    char name[64];
+    snprintf( name, sizeof( name ), "CursorSnapshotTest%s%d", test, (int)getpid() );
+    return name;
+}
+
+/**
+ * The child's side: latencies in nanoseconds go back through the pipe.
+ */
+static void readSnapshots( const char * name, bool spin, int pipeFd )
+{
+    CursorSnapshotReader reader;
+    CursorSnapshotFrame frame;
+    std::vector<double> latencies;
+
+    for( int attempt = 0; attempt < 1000 && !reader.open( name ); ++attempt ) {
+        usleep( 1000 );
+    }
+    while( reader.isWriterOpen() ) {
+        if( spin ) {
+            if( !reader.hasNewFrame() ) {
+                continue;
+            }
+        }
+        else if( !reader.waitForFrame( 100 ) ) {
+            continue;
+        }
+        if( reader.read( frame ) && frame.frame != 0 ) {
+            latencies.push_back( (double)(steadyNanoseconds() - frame.publishTime) );
+        }
+    }
+    write( pipeFd, latencies.data(), latencies.size() * sizeof( double ) );
+}
+
+static std::vector<double> collect( int pipeFd, pid_t child )
+{
+    std::vector<double> latencies;
+    double buffer[1024];
+    ssize_t n;
+
+    while( (n = read( pipeFd, buffer, sizeof( buffer ) )) > 0 ) {
+        latencies.insert( latencies.end(), buffer, buffer + n / sizeof( double ) );
+    }
+    close( pipeFd );
+    waitpid( child, NULL, 0 );
+    std::sort( latencies.begin(), latencies.end() );
+    return latencies;
+}
+
+/**
+ * Publishes LATENCY_FRAMES frames to a reader in a child process, which
+ * spins or waits.
+ *
+ * @return the latencies in nanoseconds, sorted.
+ */
+static std::vector<double> measureSnapshot( bool spin, unsigned long & wakeups )
+{
+    std::string name = snapshotName( spin ? "Spin" : "Wait" );
+    CursorSnapshotWriter * writer = new CursorSnapshotWriter( name.c_str() );
+    int fds[2];
+
+    if( pipe( fds ) != 0 ) {
+        return std::vector<double>();
+    }
+    pid_t child = fork();
+
+    if( child == 0 ) {
+        close( fds[0] );
+        readSnapshots( name.c_str(), spin, fds[1] );
+        _exit( 0 );
+    }
+    close( fds[1] );
+    usleep( 100000 ); // for the child to open and start waiting
+
+    std::vector<TuioCursor *> cursors;
+
+    for( int i = 0; i < LATENCY_CURSORS; ++i ) {
+        cursors.push_back( new TuioCursor( TuioTime( 0, 0 ), i, i, 0.0f, 0.0f ) );
+    }
+    for( int n = 1; n <= LATENCY_FRAMES; ++n ) {
+        writer->beginFrame( n, TuioTime( 0, 0 ) );
+
+        for( int i = 0; i < LATENCY_CURSORS; ++i ) {
+            writer->addCursor( cursors[i], (float)i / LATENCY_CURSORS, 0.5f, true );
+        }
+        writer->endFrame();
+        usleep( FRAME_INTERVAL );
+    }
+    wakeups = writer->getWakeups();
+    delete writer;
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        delete cursors[i];
+    }
+    return collect( fds[0], child );
+}
+
+static bool near( float a, float b )
+{
+    return std::fabs( a - b ) < 0.0001f;
+}
+
+static const CursorSnapshotSlot * findSlot( const CursorSnapshotFrame & frame, long sessionId )
+{
+    for( unsigned int i = 0; i < frame.count; ++i ) {
+        if( frame.cursors[i].sessionId == (snapshot_uint32_t)sessionId ) {
+            return &frame.cursors[i];
+        }
+    }
+    return NULL;
+}
+
+static void checkServer()
+{
+    std::string name = snapshotName( "Server" );
+    CursorSnapshotWriter * writer = new CursorSnapshotWriter( name.c_str() );
+    expect( "server: writer open", writer->isOpen() );
+
+    TuioCursorServer server;
+    server.useFirstUdpSender( false );
+    server.useSecondUdpSender( false );
+    server.useFlashXmlTcpSender( false );
+    server.setCursorSnapshotWriter( writer );
+
+    CursorSnapshotReader reader;
+    CursorSnapshotFrame frame;
+    expect( "server: reader open", reader.open( name.c_str() ) );
+    expect( "server: no such snapshot", !CursorSnapshotReader().open( "CursorSnapshotCheckMissing" ) );
+    reader.read( frame );
+    expect( "server: empty at first", frame.count == 0 && !reader.hasNewFrame() );
+
+    server.initFrame( TuioTime( 1, 0 ) );
+    TuioCursor * first = server.addTuioCursor( 7, 0.1f, 0.2f );
+    server.commitFrame();
+    expect( "server: first frame published", reader.hasNewFrame() );
+    expect( "server: first frame read", reader.read( frame ) && !reader.hasNewFrame() );
+    snapshot_uint32_t firstFrame = frame.frame;
+    expect( "server: one cursor", frame.count == 1 );
+    expect( "server: frame time", frame.frameTime == 1000000 );
+    const CursorSnapshotSlot * slot = findSlot( frame, first->getSessionID() );
+    expect( "server: added cursor", slot != NULL && slot->cursorId == first->getCursorID()
+                                    && near( slot->x, 0.1f ) && near( slot->y, 0.2f )
+                                    && slot->state == TUIO_ADDED && slot->frame == firstFrame );
+
+    server.initFrame( TuioTime( 1, 10000 ) );
+    TuioCursor * second = server.addTuioCursor( 8, 0.5f, 0.5f );
+    server.commitFrame();
+    reader.read( frame );
+    expect( "server: two cursors", frame.count == 2 && frame.frame != firstFrame );
+    slot = findSlot( frame, first->getSessionID() );
+    expect( "server: unchanged cursor keeps its frame", slot != NULL && slot->frame == firstFrame );
+    slot = findSlot( frame, second->getSessionID() );
+    expect( "server: new cursor has the new frame", slot != NULL && slot->frame == frame.frame );
+
+    server.initFrame( TuioTime( 1, 20000 ) );
+    server.updateTuioCursor( 7, 0.2f, 0.2f );
+    server.commitFrame();
+    reader.read( frame );
+    slot = findSlot( frame, first->getSessionID() );
+    expect( "server: moved cursor", slot != NULL && near( slot->x, 0.2f ) && slot->frame == frame.frame
+                                    && near( slot->xSpeed, first->getXSpeed() ) && slot->xSpeed > 0.0f
+                                    && near( slot->motionSpeed, first->getMotionSpeed() )
+                                    && near( slot->motionAccel, first->getMotionAccel() )
+                                    && slot->state == (snapshot_uint32_t)first->getTuioState() );
+
+    server.initFrame( TuioTime( 1, 30000 ) );
+    server.commitFrame();
+    expect( "server: empty frame not published", !reader.hasNewFrame() );
+
+    long secondSession = second->getSessionID();
+    server.initFrame( TuioTime( 1, 40000 ) );
+    server.removeTuioCursor( 8 );
+    server.commitFrame();
+    reader.read( frame );
+    expect( "server: removed cursor gone", frame.count == 1 && findSlot( frame, secondSession ) == NULL );
+
+    expect( "server: writer counts", writer->getFramesPublished() == 4 && writer->getWakeups() == 0 );
+    expect( "server: writer open to reader", reader.isWriterOpen() );
+    server.setCursorSnapshotWriter( NULL );
+    delete writer;
+    expect( "server: writer closed", !reader.isWriterOpen() );
+}
+
+/**
+ * The frame ID decides the count and each cursor's position, so a frame
+ * put together from two writes shows.
+ */
+static float tornX( snapshot_uint32_t frame, unsigned int i )
+{
+    return (float)((frame + i) % 1000) / 1000.0f;
+}
+
+static void checkTornReads()
+{
+    std::string name = snapshotName( "Torn" );
+    CursorSnapshotWriter writer( name.c_str() );
+    std::vector<TuioCursor *> cursors;
+
+    for( int i = 0; i < 64; ++i ) {
+        cursors.push_back( new TuioCursor( TuioTime( 0, 0 ), i, i, 0.0f, 0.0f ) );
+    }
+    std::atomic<bool> done( false );
+    unsigned long framesRead = 0,
+                  torn = 0,
+                  retries = 0;
+
+    std::thread readerThread( [&]() {
+        CursorSnapshotReader reader;
+        CursorSnapshotFrame frame;
+
+        if( !reader.open( name.c_str() ) ) {
+            ++torn;
+            return;
+        }
+        while( !done.load() ) {
+            if( !reader.hasNewFrame() || !reader.read( frame ) || frame.frame == 0 ) {
+                continue;
+            }
+            bool ok = frame.count == (frame.frame % 64) + 1;
+
+            for( unsigned int i = 0; ok && i < frame.count; ++i ) {
+                ok = frame.cursors[i].x == tornX( frame.frame, i ) && frame.cursors[i].frame == frame.frame;
+            }
+            if( !ok ) {
+                ++torn;
+            }
+        }
+        framesRead = reader.getFramesRead();
+        retries = reader.getRetries();
+    } );
+
+    for( int n = 1; n <= TORN_FRAMES; ++n ) {
+        writer.beginFrame( n, TuioTime( 0, 0 ) );
+
+        for( unsigned int i = 0; i <= (unsigned int)n % 64; ++i ) {
+            writer.addCursor( cursors[i], tornX( n, i ), 0.5f, true );
+        }
+        writer.endFrame();
+
+        for( long long until = steadyNanoseconds() + 1000; steadyNanoseconds() < until; ) {
+        }
+    }
+    done = true;
+    readerThread.join();
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        delete cursors[i];
+    }
+    expect( "torn: frames read", framesRead > 0 );
+    expect( "torn: every frame read whole", torn == 0 );
+    printf( "%d frames of 1 to 64 cursors, 1 us apart: %lu read, %lu retries, %lu torn\n",
+            TORN_FRAMES, framesRead, retries, torn );
+}
+
+static void publishFrame( CursorSnapshotWriter & writer, long frame, TuioCursor * tcur )
+{
+    writer.beginFrame( frame, TuioTime( 0, 0 ) );
+    writer.addCursor( tcur, 0.5f, 0.5f, true );
+    writer.endFrame();
+}
+
+static void checkDeadWaiter()
+{
+    std::string name = snapshotName( "Dead" );
+    CursorSnapshotWriter writer( name.c_str() );
+    TuioCursor cursor( TuioTime( 0, 0 ), 1, 1, 0.5f, 0.5f );
+    pid_t child = fork();
+
+    if( child == 0 ) {
+        CursorSnapshotReader reader;
+        CursorSnapshotFrame empty;
+
+        // the frame there when it opens counts as new
+        if( reader.open( name.c_str() ) && reader.read( empty ) ) {
+            reader.waitForFrame( 60000 );
+        }
+        _exit( 0 );
+    }
+    usleep( 200000 ); // for the child to start waiting
+    kill( child, SIGKILL );
+    waitpid( child, NULL, 0 );
+
+    long frame = 1;
+    publishFrame( writer, frame++, &cursor );
+    expect( "dead waiter: woken at first", writer.getWakeups() == 1 );
+
+    long long until = steadyNanoseconds() + (CursorSnapshot::WAITER_TIMEOUT + 2 * CursorSnapshot::WAIT_SLICE) * 1000000LL;
+
+    while( steadyNanoseconds() < until ) {
+        publishFrame( writer, frame++, &cursor );
+        usleep( 10000 );
+    }
+    unsigned long wakeups = writer.getWakeups();
+
+    for( int i = 0; i < 10; ++i ) {
+        publishFrame( writer, frame++, &cursor );
+    }
+    expect( "dead waiter: no longer woken", writer.getWakeups() == wakeups );
+    printf( "reader killed while waiting: %lu wake-ups in %ld frames\n", writer.getWakeups(), frame - 1 );
+}
+
+static void checkLatencyReaders()
+{
+    unsigned long spinWakeups = 0,
+                  waitWakeups = 0;
+    std::vector<double> spin = measureSnapshot( true, spinWakeups ),
+                        waiting = measureSnapshot( false, waitWakeups );
+    expect( "latency: spinning reader got frames", spin.size() >= LATENCY_FRAMES / 2 );
+    expect( "latency: spinning reader never woken", spinWakeups == 0 );
+    expect( "latency: waiting reader got frames", waiting.size() >= LATENCY_FRAMES / 2 );
+    expect( "latency: waiting reader woken", waitWakeups > 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+    checkServer();
+    checkTornReads();
+    checkDeadWaiter();
+    checkLatencyReaders();
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
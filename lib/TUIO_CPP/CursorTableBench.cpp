@@ -0,0 +1,181 @@
+/*******************************************************************************
+CursorTableBench
+
+PURPOSE: Compares the two ways of driving a TuioCursorManager: by TuioCursor
+         pointer (cursor list) and by the caller's own id (cursor table).
+
+NOTES:
+For each contact count from 1 to 256, contacts are put down, moved for a
+number of frames and lifted again in a scrambled order, the way several
+fingers leave a touch screen.  The list path keeps its own id-to-cursor
+std::map, as TouchMessageListener used to, since a caller of that path has
+to.  Timings are per pointer event; heap allocations per event are counted
+as BenchSupport.h does.
+
+CursorTableCheck checks the table path.
+
+Usage: CursorTableBench [rounds] [frames per round]
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "TuioCursorManager.h"
+#include <map>
+
+using namespace TUIO;
+
+struct BenchResult
+{
+    double nsPerEvent,
+           allocationsPerEvent;
+};
+
+/**
+ * Windows pointer ids are not small or contiguous, so neither are these.
+ */
+static unsigned int pointerId( unsigned int i )
+{
+    return 1000 + i * 7919;
+}
+
+/**
+ * Removal order: a stride that is coprime with the contact count.
+ */
+static unsigned int liftOrder( unsigned int i, unsigned int contacts )
+{
+    unsigned int stride = 1;
+
+    for( unsigned int s = contacts / 2 + 1; s < contacts; ++s ) {
+        unsigned int a = s, b = contacts;
+
+        while( b != 0 ) { unsigned int t = a % b; a = b; b = t; }
+
+        if( a == 1 ) {
+            stride = s;
+            break;
+        }
+    }
+    return (i * stride) % contacts;
+}
+
+class FrameClock
+{
+public:
+    FrameClock() : micros_( 0 ) {}
+
+    TuioTime next()
+    {
+        micros_ += 1000;
+        return TuioTime( micros_ / 1000000, micros_ % 1000000 );
+    }
+
+private:
+    long micros_;
+};
+
+static BenchResult runListPath( unsigned int contacts, unsigned int rounds, unsigned int frames )
+{
+    TuioCursorManager manager;
+    std::map<unsigned int, TuioCursor *> cursorMap;
+    FrameClock clock;
+    unsigned long long events = 0,
+                       allocationsBefore = heapAllocations;
+    double start = seconds();
+
+    for( unsigned int r = 0; r < rounds; ++r ) {
+        manager.initFrame( clock.next() );
+
+        for( unsigned int i = 0; i < contacts; ++i ) {
+            cursorMap[pointerId( i )] = manager.addTuioCursor( 0.001f * i, 0.5f );
+        }
+        manager.commitFrame();
+
+        for( unsigned int f = 1; f <= frames; ++f ) {
+            manager.initFrame( clock.next() );
+
+            for( unsigned int i = 0; i < contacts; ++i ) {
+                manager.updateTuioCursor( cursorMap[pointerId( i )], 0.001f * i, 0.5f + 0.001f * f );
+            }
+            manager.commitFrame();
+        }
+        manager.initFrame( clock.next() );
+
+        for( unsigned int i = 0; i < contacts; ++i ) {
+            std::map<unsigned int, TuioCursor *>::iterator iter
+                = cursorMap.find( pointerId( liftOrder( i, contacts ) ) );
+            manager.removeTuioCursor( iter->second );
+            cursorMap.erase( iter );
+        }
+        manager.commitFrame();
+        events += (unsigned long long)contacts * (frames + 2);
+    }
+    double elapsed = seconds() - start;
+    BenchResult result;
+    result.nsPerEvent = elapsed * 1e9 / events;
+    result.allocationsPerEvent = (double)(heapAllocations - allocationsBefore) / events;
+    return result;
+}
+
+static BenchResult runTablePath( unsigned int contacts, unsigned int rounds, unsigned int frames )
+{
+    TuioCursorManager manager;
+    FrameClock clock;
+    unsigned long long events = 0,
+                       allocationsBefore = heapAllocations;
+    double start = seconds();
+
+    for( unsigned int r = 0; r < rounds; ++r ) {
+        manager.initFrame( clock.next() );
+
+        for( unsigned int i = 0; i < contacts; ++i ) {
+            manager.addTuioCursor( (int)pointerId( i ), 0.001f * i, 0.5f );
+        }
+        manager.commitFrame();
+
+        for( unsigned int f = 1; f <= frames; ++f ) {
+            manager.initFrame( clock.next() );
+
+            for( unsigned int i = 0; i < contacts; ++i ) {
+                manager.updateTuioCursor( (int)pointerId( i ), 0.001f * i, 0.5f + 0.001f * f );
+            }
+            manager.commitFrame();
+        }
+        manager.initFrame( clock.next() );
+
+        for( unsigned int i = 0; i < contacts; ++i ) {
+            manager.removeTuioCursor( (int)pointerId( liftOrder( i, contacts ) ) );
+        }
+        manager.commitFrame();
+        events += (unsigned long long)contacts * (frames + 2);
+    }
+    double elapsed = seconds() - start;
+    BenchResult result;
+    result.nsPerEvent = elapsed * 1e9 / events;
+    result.allocationsPerEvent = (double)(heapAllocations - allocationsBefore) / events;
+    return result;
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int rounds = argc > 1 ? (unsigned int)atoi( argv[1] ) : 2000,
+                 frames = argc > 2 ? (unsigned int)atoi( argv[2] ) : 8;
+
+    if( rounds == 0 ) {
+        fprintf( stderr, "usage: %s [rounds] [frames per round]\n", argv[0] );
+        return 2;
+    }
+    printf( "%8s %14s %14s %14s %14s\n", "contacts", "list ns/event", "table ns/event",
+            "list allocs", "table allocs" );
+
+    for( unsigned int contacts = 1; contacts <= TuioCursorTable::CAPACITY; contacts *= 2 ) {
+        unsigned int scaledRounds = rounds / contacts > 0 ? rounds / contacts : 1;
+        BenchResult list = runListPath( contacts, scaledRounds, frames ),
+                    table = runTablePath( contacts, scaledRounds, frames );
+
+        printf( "%8u %14.1f %14.1f %14.2f %14.2f\n", contacts,
+                list.nsPerEvent, table.nsPerEvent,
+                list.allocationsPerEvent, table.allocationsPerEvent );
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*******************************************************************************
+CursorTableCheck
+
+PURPOSE: Checks driving a TuioCursorManager by the caller's own id (cursor
+         table).
+
+NOTES:
+For each contact count from 1 to 256, contacts are put down, moved for a
+few frames and lifted again in a scrambled order, the way several fingers
+leave a touch screen, a few rounds over.  Every contact must get its own
+cursor ID below the contact count, lookups must return the right cursor
+after every frame, and nothing may be left over at the end.
+
+CursorTableBench measures the table path against the cursor list.
+
+Usage: CursorTableCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TuioCursorManager.h"
+#include <vector>
+
+using namespace TUIO;
+
+static const unsigned int ROUNDS = 3,
+                          FRAMES = 4;
+
+/**
+ * Windows pointer ids are not small or contiguous, so neither are these.
+ */
+static unsigned int pointerId( unsigned int i )
+{
+    return 1000 + i * 7919;
+}
+
+/**
+ * Removal order: a stride that is coprime with the contact count.
+ */
+static unsigned int liftOrder( unsigned int i, unsigned int contacts )
+{
+    unsigned int stride = 1;
+
+    for( unsigned int s = contacts / 2 + 1; s < contacts; ++s ) {
+        unsigned int a = s, b = contacts;
+
+        while( b != 0 ) { unsigned int t = a % b; a = b; b = t; }
+
+        if( a == 1 ) {
+            stride = s;
+            break;
+        }
+    }
+    return (i * stride) % contacts;
+}
+
+class FrameClock
+{
+public:
+    FrameClock() : micros_( 0 ) {}
+
+    TuioTime next()
+    {
+        micros_ += 1000;
+        return TuioTime( micros_ / 1000000, micros_ % 1000000 );
+    }
+
+private:
+    long micros_;
+};
+
+/**
+ * @return true if every contact has its own cursor ID below the contact
+ * count and is at its position.
+ */
+static bool lookupsMatch( TuioCursorManager & manager, unsigned int contacts, float y )
+{
+    std::vector<bool> cursorIdUsed( contacts );
+
+    for( unsigned int i = 0; i < contacts; ++i ) {
+        TuioCursor * tcur = manager.getTuioCursorFromMap( pointerId( i ) );
+
+        if( tcur == NULL || tcur->getCursorID() < 0 || tcur->getCursorID() >= (int)contacts
+         || cursorIdUsed[tcur->getCursorID()] || tcur->getX() != 0.001f * i || tcur->getY() != y ) {
+            fprintf( stderr, "%u contacts: bad cursor for pointer %u\n", contacts, pointerId( i ) );
+            return false;
+        }
+        cursorIdUsed[tcur->getCursorID()] = true;
+    }
+    return true;
+}
+
+static void checkTablePath( unsigned int contacts )
+{
+    TuioCursorManager manager;
+    FrameClock clock;
+    bool added = true,
+         updated = true;
+
+    for( unsigned int r = 0; r < ROUNDS; ++r ) {
+        manager.initFrame( clock.next() );
+
+        for( unsigned int i = 0; i < contacts; ++i ) {
+            manager.addTuioCursor( (int)pointerId( i ), 0.001f * i, 0.5f );
+        }
+        manager.commitFrame();
+        added = lookupsMatch( manager, contacts, 0.5f ) && added;
+
+        for( unsigned int f = 1; f <= FRAMES; ++f ) {
+            manager.initFrame( clock.next() );
+
+            for( unsigned int i = 0; i < contacts; ++i ) {
+                manager.updateTuioCursor( (int)pointerId( i ), 0.001f * i, 0.5f + 0.001f * f );
+            }
+            manager.commitFrame();
+            updated = lookupsMatch( manager, contacts, 0.5f + 0.001f * f ) && updated;
+        }
+        manager.initFrame( clock.next() );
+
+        for( unsigned int i = 0; i < contacts; ++i ) {
+            manager.removeTuioCursor( (int)pointerId( liftOrder( i, contacts ) ) );
+        }
+        manager.commitFrame();
+    }
+    expect( "table path: added", added );
+    expect( "table path: updated", updated );
+    expect( "table path: nothing left", manager.getTuioCursorsFromMap().empty()
+                                        && manager.getTuioCursors().empty() );
+}
+
+int main( int argc, char * argv[] )
+{
+    for( unsigned int contacts = 1; contacts <= TuioCursorTable::CAPACITY; contacts *= 2 ) {
+        checkTablePath( contacts );
+    }
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
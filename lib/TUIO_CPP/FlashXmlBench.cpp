@@ -0,0 +1,191 @@
+/*******************************************************************************
+FlashXmlBench
+
+PURPOSE: Compares the FlashXmlEncoder used by TuioCursorServer with the
+         std::stringstream encoder it replaced.
+
+NOTES:
+The old encoder is copied here as it was in TuioCursorServer, including the
+copy ofxTCPClient::send made to append the NUL character.  For 1 to 100
+moving cursors, frames are encoded with both, timed, and their heap
+allocations counted as BenchSupport.h does.
+
+FlashXmlCheck checks the frames FlashXmlEncoder writes.
+
+Usage: FlashXmlBench [frames]
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "FlashXmlEncoder.h"
+#include "TuioCursor.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace TUIO;
+
+static const int PORT = 3000;
+
+/**
+ * The encoder TuioCursorServer used before FlashXmlEncoder.
+ */
+class OldFlashXmlEncoder
+{
+public:
+    OldFlashXmlEncoder() : flashXmlTcpPortStr_( int2Str( PORT ) ) {}
+
+    std::string encode( const std::vector<TuioCursor *> & cursors, TuioTime frameTime, long frame )
+    {
+        std::string setBlobsMsg;
+        std::string aliveBlobsMsg;
+
+        for( size_t i = 0; i < cursors.size(); ++i ) {
+            addFlashXml2DcurProfile( setBlobsMsg, cursors[i] );
+            aliveBlobsMsg += "<ARGUMENT TYPE=\"i\" VALUE=\"" + int2Str( cursors[i]->getSessionID() ) + "\"/>";
+        }
+        std::stringstream message;
+        message << "<OSCPACKET ADDRESS=\"127.0.0.1\" PORT=\"" << flashXmlTcpPortStr_
+                << "\" TIME=\"" << (frameTime.getTotalMilliseconds() / 1000.0f) << "\">"
+                << setBlobsMsg
+                << "<MESSAGE NAME=\"/tuio/2Dcur\">"
+                   "<ARGUMENT TYPE=\"s\" VALUE=\"alive\"/>"
+                << aliveBlobsMsg
+                << "</MESSAGE>"
+                   "<MESSAGE NAME=\"/tuio/2Dcur\">"
+                   "<ARGUMENT TYPE=\"s\" VALUE=\"fseq\"/>"
+                   "<ARGUMENT TYPE=\"i\" VALUE=\"" << frame << "\"/>"
+                   "</MESSAGE>"
+                   "</OSCPACKET>";
+
+        std::string msg = message.str();
+        std::string sent = msg; // ofxTCPClient::send( string ) took its own copy
+        sent += (char)0;        // for Flash
+        return sent;
+    }
+
+private:
+    void addFlashXml2DcurProfile( std::string & blobMessage, TuioCursor * tcur )
+    {
+        std::stringstream ss;
+        ss << "<MESSAGE NAME=\"/tuio/2Dcur\">"
+              "<ARGUMENT TYPE=\"s\" VALUE=\"set\"/>"
+              "<ARGUMENT TYPE=\"i\" VALUE=\"" << (int)tcur->getSessionID() << "\"/>"
+              "<ARGUMENT TYPE=\"f\" VALUE=\"" << tcur->getX() << "\"/>"
+              "<ARGUMENT TYPE=\"f\" VALUE=\"" << tcur->getY() << "\"/>"
+              "<ARGUMENT TYPE=\"f\" VALUE=\"" << tcur->getXSpeed() << "\"/>"
+              "<ARGUMENT TYPE=\"f\" VALUE=\"" << tcur->getYSpeed() << "\"/>"
+              "<ARGUMENT TYPE=\"f\" VALUE=\"" << tcur->getMotionAccel() << "\"/>"
+              "</MESSAGE>";
+        blobMessage += ss.str();
+    }
+
+    static std::string int2Str( int n )
+    {
+        std::stringstream out;
+        out << n;
+        return out.str();
+    }
+
+    std::string flashXmlTcpPortStr_;
+};
+
+static void encodeNew( FlashXmlEncoder & encoder, const std::vector<TuioCursor *> & cursors,
+                       TuioTime frameTime, long frame )
+{
+    encoder.beginPacket( frameTime.getTotalMilliseconds() );
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        TuioCursor * tcur = cursors[i];
+        encoder.addSetMessage( tcur->getSessionID(), tcur->getX(), tcur->getY(),
+                               tcur->getXSpeed(), tcur->getYSpeed(), tcur->getMotionAccel() );
+    }
+    encoder.beginAliveMessage();
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        encoder.addAliveId( cursors[i]->getSessionID() );
+    }
+    encoder.endAliveMessage();
+    encoder.addFseqMessage( frame );
+    encoder.endPacket();
+}
+
+/**
+ * Moves every cursor in frame f.
+ */
+static void moveCursors( const std::vector<TuioCursor *> & cursors, unsigned int f, TuioTime frameTime )
+{
+    for( unsigned int i = 0; i < cursors.size(); ++i ) {
+        float x = 0.01f * i + 0.001f * (f % 100),
+              y = 0.5f + 0.0003f * ((f * (i + 1)) % 1000);
+        cursors[i]->update( frameTime, x, y );
+    }
+}
+
+static TuioTime frameTimeAt( unsigned int f )
+{
+    return TuioTime( f / 60, (f % 60) * 16667 );
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int frames = argc > 1 ? (unsigned int)atoi( argv[1] ) : 20000;
+
+    if( frames == 0 ) {
+        fprintf( stderr, "usage: %s [frames]\n", argv[0] );
+        return 2;
+    }
+    unsigned int counts[] = { 1, 2, 5, 10, 20, 50, 100 };
+
+    printf( "%8s %14s %14s %14s %14s %12s\n", "cursors", "old ns/frame", "new ns/frame",
+            "old allocs", "new allocs", "bytes" );
+
+    for( unsigned int c = 0; c < sizeof( counts ) / sizeof( counts[0] ); ++c ) {
+        unsigned int cursorCount = counts[c],
+                     scaledFrames = frames / cursorCount > 0 ? frames / cursorCount : 1;
+        std::vector<TuioCursor *> cursors;
+
+        for( unsigned int i = 0; i < cursorCount; ++i ) {
+            cursors.push_back( new TuioCursor( TuioTime( 0, 0 ), 1000 + i, i, 0.01f * i, 0.5f ) );
+            cursors.back()->setPathDepth( 0 );
+        }
+        OldFlashXmlEncoder oldEncoder;
+        FlashXmlEncoder newEncoder( PORT );
+        double oldTime = 0.0,
+               newTime = 0.0;
+        unsigned long long oldAllocations = 0,
+                           newAllocations = 0;
+        size_t bytes = 0;
+
+        for( unsigned int f = 1; f <= scaledFrames; ++f ) {
+            TuioTime frameTime = frameTimeAt( f );
+            moveCursors( cursors, f, frameTime );
+
+            unsigned long long before = heapAllocations;
+            double start = seconds();
+            std::string oldFrame = oldEncoder.encode( cursors, frameTime, f );
+            oldTime += seconds() - start;
+            oldAllocations += heapAllocations - before;
+
+            before = heapAllocations;
+            start = seconds();
+            encodeNew( newEncoder, cursors, frameTime, f );
+            newTime += seconds() - start;
+
+            if( f > 1 ) { // the first frame may grow the buffer
+                newAllocations += heapAllocations - before;
+            }
+            bytes = newEncoder.size();
+        }
+        printf( "%8u %14.1f %14.1f %14.2f %14.2f %12u\n", cursorCount,
+                oldTime * 1e9 / scaledFrames, newTime * 1e9 / scaledFrames,
+                (double)oldAllocations / scaledFrames, (double)newAllocations / scaledFrames,
+                (unsigned int)bytes );
+
+        for( unsigned int i = 0; i < cursorCount; ++i ) {
+            delete cursors[i];
+        }
+    }
+    return 0;
+}
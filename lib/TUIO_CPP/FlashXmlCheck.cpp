@@ -0,0 +1,219 @@
+/*******************************************************************************
+FlashXmlCheck
+
+PURPOSE: Checks that FlashXmlEncoder writes the frames TuioCursorServer
+         wrote before it, without allocating.
+
+NOTES:
+For 1 to 100 moving cursors, FRAMES frames are encoded and each is compared
+with the frame expected from the cursors, written with %g as the old
+std::stringstream encoder did.  With the attribute values blanked out the
+XML must be identical, strings and integers must match exactly, and floats
+must agree to within the 6 significant digits the old encoder wrote.  After the first frame, which may grow its buffer, the
+new encoder may not allocate (counted as BenchSupport.h does).
+
+FlashXmlBench times both encoders.
+
+Usage: FlashXmlCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "FlashXmlEncoder.h"
+#include "TuioCursor.h"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace TUIO;
+
+static const int PORT = 3000;
+static const unsigned int FRAMES = 200;
+
+static void encodeNew( FlashXmlEncoder & encoder, const std::vector<TuioCursor *> & cursors,
+                       TuioTime frameTime, long frame )
+{
+    encoder.beginPacket( frameTime.getTotalMilliseconds() );
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        TuioCursor * tcur = cursors[i];
+        encoder.addSetMessage( tcur->getSessionID(), tcur->getX(), tcur->getY(),
+                               tcur->getXSpeed(), tcur->getYSpeed(), tcur->getMotionAccel() );
+    }
+    encoder.beginAliveMessage();
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        encoder.addAliveId( cursors[i]->getSessionID() );
+    }
+    encoder.endAliveMessage();
+    encoder.addFseqMessage( frame );
+    encoder.endPacket();
+}
+
+/**
+ * Moves every cursor in frame f.
+ */
+static void moveCursors( const std::vector<TuioCursor *> & cursors, unsigned int f, TuioTime frameTime )
+{
+    for( unsigned int i = 0; i < cursors.size(); ++i ) {
+        float x = 0.01f * i + 0.001f * (f % 100),
+              y = 0.5f + 0.0003f * ((f * (i + 1)) % 1000);
+        cursors[i]->update( frameTime, x, y );
+    }
+}
+
+static TuioTime frameTimeAt( unsigned int f )
+{
+    return TuioTime( f / 60, (f % 60) * 16667 );
+}
+
+/**
+ * The frame the old encoder wrote for the cursors, NUL included.
+ */
+static std::string expectedFrame( const std::vector<TuioCursor *> & cursors, TuioTime frameTime, long frame )
+{
+    char value[64];
+    snprintf( value, sizeof( value ), "%g", frameTime.getTotalMilliseconds() / 1000.0f );
+    std::string xml = "<OSCPACKET ADDRESS=\"127.0.0.1\" PORT=\"3000\" TIME=\"" + std::string( value ) + "\">";
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        TuioCursor * tcur = cursors[i];
+        float args[] = { tcur->getX(), tcur->getY(), tcur->getXSpeed(), tcur->getYSpeed(), tcur->getMotionAccel() };
+
+        snprintf( value, sizeof( value ), "%d", (int)tcur->getSessionID() );
+        xml += "<MESSAGE NAME=\"/tuio/2Dcur\"><ARGUMENT TYPE=\"s\" VALUE=\"set\"/>"
+               "<ARGUMENT TYPE=\"i\" VALUE=\"" + std::string( value ) + "\"/>";
+
+        for( unsigned int a = 0; a < 5; ++a ) {
+            snprintf( value, sizeof( value ), "%g", args[a] );
+            xml += "<ARGUMENT TYPE=\"f\" VALUE=\"" + std::string( value ) + "\"/>";
+        }
+        xml += "</MESSAGE>";
+    }
+    xml += "<MESSAGE NAME=\"/tuio/2Dcur\"><ARGUMENT TYPE=\"s\" VALUE=\"alive\"/>";
+
+    for( size_t i = 0; i < cursors.size(); ++i ) {
+        snprintf( value, sizeof( value ), "%d", (int)cursors[i]->getSessionID() );
+        xml += "<ARGUMENT TYPE=\"i\" VALUE=\"" + std::string( value ) + "\"/>";
+    }
+    snprintf( value, sizeof( value ), "%ld", frame );
+    xml += "</MESSAGE><MESSAGE NAME=\"/tuio/2Dcur\"><ARGUMENT TYPE=\"s\" VALUE=\"fseq\"/>"
+           "<ARGUMENT TYPE=\"i\" VALUE=\"" + std::string( value ) + "\"/></MESSAGE></OSCPACKET>";
+    xml += (char)0; // for Flash
+    return xml;
+}
+
+/**
+ * Splits a packet into its skeleton (with every attribute value blanked)
+ * and the list of values.
+ */
+static void split( const char * xml, size_t size, std::string & skeleton, std::vector<std::string> & values )
+{
+    skeleton.clear();
+    values.clear();
+    size_t i = 0;
+
+    while( i < size ) {
+        if( xml[i] == '"' ) {
+            size_t end = i + 1;
+
+            while( end < size && xml[end] != '"' ) {
+                ++end;
+            }
+            values.push_back( std::string( xml + i + 1, end - i - 1 ) );
+            skeleton += "\"\"";
+            i = end + 1;
+        }
+        else {
+            skeleton += xml[i++];
+        }
+    }
+}
+
+static bool sameValue( const std::string & a, const std::string & b )
+{
+    if( a == b ) {
+        return true;
+    }
+    char * endA = 0,
+         * endB = 0;
+    double x = strtod( a.c_str(), &endA ),
+           y = strtod( b.c_str(), &endB );
+
+    if( *endA != '\0' || *endB != '\0' || a.empty() || b.empty() ) {
+        return false;
+    }
+    double magnitude = fabs( x ) > 1.0 ? fabs( x ) : 1.0;
+    return fabs( x - y ) <= 1e-5 * magnitude;
+}
+
+static bool sameFrame( const std::string & expected, const FlashXmlEncoder & encoder, unsigned int cursors )
+{
+    std::string expectedSkeleton, newSkeleton;
+    std::vector<std::string> expectedValues, newValues;
+
+    split( expected.data(), expected.size(), expectedSkeleton, expectedValues );
+    split( encoder.data(), encoder.size(), newSkeleton, newValues );
+
+    if( expectedSkeleton != newSkeleton || expectedValues.size() != newValues.size() ) {
+        fprintf( stderr, "%u cursors: frames differ in structure\n", cursors );
+        return false;
+    }
+    for( size_t i = 0; i < expectedValues.size(); ++i ) {
+        if( !sameValue( expectedValues[i], newValues[i] ) ) {
+            fprintf( stderr, "%u cursors: value %u differs: \"%s\" and \"%s\"\n", cursors,
+                     (unsigned int)i, expectedValues[i].c_str(), newValues[i].c_str() );
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkFrames( unsigned int cursorCount )
+{
+    std::vector<TuioCursor *> cursors;
+
+    for( unsigned int i = 0; i < cursorCount; ++i ) {
+        cursors.push_back( new TuioCursor( TuioTime( 0, 0 ), 1000 + i, i, 0.01f * i, 0.5f ) );
+        cursors.back()->setPathDepth( 0 );
+    }
+    FlashXmlEncoder newEncoder( PORT );
+    unsigned long long newAllocations = 0;
+    bool same = true;
+
+    for( unsigned int f = 1; f <= FRAMES && same; ++f ) {
+        TuioTime frameTime = frameTimeAt( f );
+        moveCursors( cursors, f, frameTime );
+        std::string expected = expectedFrame( cursors, frameTime, f );
+
+        unsigned long long before = heapAllocations;
+        encodeNew( newEncoder, cursors, frameTime, f );
+
+        if( f > 1 ) { // the first frame may grow the buffer
+            newAllocations += heapAllocations - before;
+        }
+        same = sameFrame( expected, newEncoder, cursorCount );
+    }
+    for( unsigned int i = 0; i < cursorCount; ++i ) {
+        delete cursors[i];
+    }
+    char name[64];
+    snprintf( name, sizeof( name ), "%u cursors: same frames", cursorCount );
+    expect( name, same );
+    snprintf( name, sizeof( name ), "%u cursors: no allocations", cursorCount );
+    expect( name, newAllocations == 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int counts[] = { 1, 2, 5, 10, 20, 50, 100 };
+
+    for( unsigned int c = 0; c < sizeof( counts ) / sizeof( counts[0] ); ++c ) {
+        checkFrames( counts[c] );
+    }
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+/*******************************************************************************
+FlashXmlServerCheck
+
+PURPOSE: Checks that FlashXmlTcpServer never blocks the sending thread on a
+         client that stops reading, and that every client still gets whole
+         frames ending with the newest one.
+
+NOTES:
+Two clients connect to the server on localhost.  One reads every frame as
+it arrives; the other has a small receive buffer and reads nothing.  Frames
+of about 2 KB (a frame of 10 or so cursors) are then sent, each tagged with
+its number at both ends and followed by the NUL character.  Frames go on
+being sent after the number asked for until the stalled client has had
+some dropped, so the checks hold for any number of frames.
+
+The checks are:
+ - no sendtoAll() call takes longer than MAX_SEND_MILLISECONDS,
+ - the reading client gets every frame, in order, with nothing dropped,
+ - frames are dropped for the stalled client, its queue stays within
+   MAX_QUEUED_FRAMES and a full frame is requested,
+ - once the stalled client starts reading it gets only whole frames, in
+   order, and the last one is the newest frame sent,
+ - a client that disconnects is removed.
+
+Usage: FlashXmlServerCheck [frames]   (at least this many are sent)
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "FlashXmlTcpServer.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+static const double MAX_SEND_MILLISECONDS = 50.0;
+static const unsigned int FRAME_PADDING = 2000,
+                          MAX_FRAMES = 1000000;
+
+static int connectClient( int port, int receiveBuffer )
+{
+    int s = ::socket( AF_INET, SOCK_STREAM, 0 );
+
+    if( receiveBuffer > 0 ) {
+        setsockopt( s, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof( receiveBuffer ) );
+    }
+    struct sockaddr_in address = sockaddr_in();
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = htons( (unsigned short)port );
+
+    if( connect( s, (struct sockaddr *)&address, sizeof( address ) ) != 0 ) {
+        close( s );
+        return -1;
+    }
+    return s;
+}
+
+static bool waitForClients( FlashXmlTcpServer & server, int count )
+{
+    for( int i = 0; i < 200; ++i ) {
+        if( server.getClientCount() == count ) {
+            return true;
+        }
+        usleep( 10000 );
+    }
+    return false;
+}
+
+/**
+ * The clients are listed in the order they connected.
+ */
+static bool stalledClientDropped( FlashXmlTcpServer & server )
+{
+    std::vector<FlashXmlTcpServer::ClientStats> stats = server.getClientStats();
+    return stats.size() == 2 && stats[1].framesDropped > 0;
+}
+
+static void makeFrame( std::string & frame, unsigned int n )
+{
+    char tag[32];
+    snprintf( tag, sizeof( tag ), "<F %u>", n );
+    frame = tag;
+    frame.append( FRAME_PADDING, 'x' );
+    snprintf( tag, sizeof( tag ), "</F %u>", n );
+    frame += tag;
+}
+
+/**
+ * Splits a byte stream into NUL-terminated frames and checks each one.
+ */
+class FrameChecker
+{
+public:
+    FrameChecker() : frames( 0 ), last( -1 ), gaps( 0 ), broken( 0 ) {}
+
+    void add( const char * data, size_t size )
+    {
+        for( size_t i = 0; i < size; ++i ) {
+            if( data[i] != '\0' ) {
+                pending_ += data[i];
+                continue;
+            }
+            unsigned int begin = 0,
+                         end = 0;
+            int chars = 0;
+            size_t endTag = pending_.rfind( "</F" );
+
+            if( sscanf( pending_.c_str(), "<F %u>%n", &begin, &chars ) != 1
+                || endTag == std::string::npos
+                || sscanf( pending_.c_str() + endTag, "</F %u>", &end ) != 1
+                || begin != end
+                || pending_.size() != (size_t)chars + FRAME_PADDING + chars + 1 ) {
+                ++broken;
+            }
+            else {
+                if( (long)begin != last + 1 ) {
+                    ++gaps;
+                }
+                if( (long)begin <= last ) {
+                    ++broken; // out of order
+                }
+                last = (long)begin;
+            }
+            ++frames;
+            pending_.clear();
+        }
+    }
+
+    bool hasPartialFrame() const { return !pending_.empty(); }
+
+    std::atomic<unsigned long> frames;
+    std::atomic<long> last;
+    unsigned long gaps,
+                  broken;
+
+private:
+    std::string pending_;
+};
+
+static void readUntilClosed( int s, FrameChecker * checker )
+{
+    char buffer[65536];
+
+    for( ;; ) {
+        long n = (long)recv( s, buffer, sizeof( buffer ), 0 );
+
+        if( n <= 0 ) {
+            return;
+        }
+        checker->add( buffer, (size_t)n );
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int minFrames = argc > 1 ? (unsigned int)atoi( argv[1] ) : 5000,
+                 frames = 0;
+
+    if( minFrames == 0 ) {
+        fprintf( stderr, "usage: %s [frames]\n", argv[0] );
+        return 2;
+    }
+    FlashXmlTcpServer server;
+
+    if( !server.setup( 0 ) ) {
+        fprintf( stderr, "could not start the server\n" );
+        return 1;
+    }
+    int fast = connectClient( server.getPort(), 0 ),
+        stalled = connectClient( server.getPort(), 4096 );
+
+    if( fast < 0 || stalled < 0 || !waitForClients( server, 2 ) ) {
+        fprintf( stderr, "the clients could not connect\n" );
+        return 1;
+    }
+    FrameChecker fastFrames;
+    std::thread reader( readUntilClosed, fast, &fastFrames );
+
+    std::string frame;
+    double maxSend = 0.0,
+           totalSend = 0.0;
+    bool fullFrameRequested = false;
+
+    for( ; frames < MAX_FRAMES; ++frames ) {
+        if( frames >= minFrames && stalledClientDropped( server ) ) {
+            break;
+        }
+        makeFrame( frame, frames );
+        double start = seconds();
+        server.sendtoAll( frame );
+        double elapsed = seconds() - start;
+        totalSend += elapsed;
+
+        if( elapsed > maxSend ) {
+            maxSend = elapsed;
+        }
+        fullFrameRequested = server.fullFrameRequested() || fullFrameRequested;
+
+        // Let the reading client keep up, as a client on a real network would.
+        while( fastFrames.last.load() + 4 < (long)frames ) {
+            std::this_thread::yield();
+        }
+    }
+    double deadline = seconds() + 5.0;
+
+    while( fastFrames.frames.load() < frames && seconds() < deadline ) {
+        usleep( 1000 );
+    }
+    std::vector<FlashXmlTcpServer::ClientStats> stats = server.getClientStats();
+
+    printf( "frames: %u of %u bytes\n", frames, (unsigned int)frame.size() + 1 );
+    printf( "sendtoAll: %.1f us average, %.3f ms longest\n",
+            totalSend * 1e6 / frames, maxSend * 1e3 );
+
+    for( size_t i = 0; i < stats.size(); ++i ) {
+        printf( "client %s: %lu sent, %lu dropped, %u queued, lag %ld ms (longest %ld ms)\n",
+                stats[i].address.c_str(), stats[i].framesSent, stats[i].framesDropped,
+                stats[i].queuedFrames, stats[i].lagMilliseconds, stats[i].maxLagMilliseconds );
+    }
+    expect( "sendtoAll: never blocks", maxSend * 1e3 <= MAX_SEND_MILLISECONDS );
+
+    if( fastFrames.frames.load() != frames || fastFrames.gaps != 0 || fastFrames.broken != 0 ) {
+        fprintf( stderr, "reading client: %lu of %u frames, %lu gaps, %lu broken\n",
+                 fastFrames.frames.load(), frames, fastFrames.gaps, fastFrames.broken );
+        ++errors;
+    }
+    unsigned long dropped = 0;
+    expect( "two clients", stats.size() == 2 );
+
+    if( stats.size() == 2 ) {
+        dropped = stats[1].framesDropped;
+
+        expect( "reading client: nothing dropped", stats[0].framesDropped == 0 && stats[0].framesSent == frames );
+        expect( "stalled client: dropped and queued", dropped > 0
+                && stats[1].queuedFrames <= FlashXmlTcpServer::MAX_QUEUED_FRAMES );
+        expect( "stalled client: full frame requested", fullFrameRequested );
+    }
+
+    // The stalled client now reads what was kept for it.
+    FrameChecker stalledFrames;
+    char buffer[65536];
+    struct pollfd readable;
+    readable.fd = stalled;
+    readable.events = POLLIN;
+
+    while( poll( &readable, 1, 500 ) > 0 ) {
+        long n = (long)recv( stalled, buffer, sizeof( buffer ), 0 );
+
+        if( n <= 0 ) {
+            break;
+        }
+        stalledFrames.add( buffer, (size_t)n );
+    }
+    printf( "stalled client: read %lu frames, the last was %ld\n",
+            stalledFrames.frames.load(), stalledFrames.last.load() );
+
+    expect( "stalled client: whole frames", stalledFrames.broken == 0 && !stalledFrames.hasPartialFrame() );
+    expect( "stalled client: newest frame", stalledFrames.last.load() == (long)frames - 1 );
+    expect( "stalled client: read or dropped", stalledFrames.frames.load() + dropped == frames );
+
+    // A client that goes away is removed.
+    close( stalled );
+    server.sendtoAll( frame );
+
+    for( int i = 0; i < 200 && server.getClientCount() != 1; ++i ) {
+        usleep( 10000 );
+        server.sendtoAll( frame );
+    }
+    expect( "closed client removed", server.getClientCount() == 1 );
+    shutdown( fast, SHUT_RDWR );
+    reader.join();
+    close( fast );
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
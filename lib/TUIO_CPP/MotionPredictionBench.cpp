@@ -0,0 +1,70 @@
+/*******************************************************************************
+MotionPredictionBench
+
+PURPOSE: Measures what a MotionPredictor prediction costs.
+
+NOTES:
+TIMED_CURSORS moving cursors are updated and predicted TIMED_FRAMES times,
+at 120 frames a second of TuioTime, with each model.
+
+MotionPredictionCheck checks the models and prints how far off they are.
+
+Usage: MotionPredictionBench
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "MotionPredictor.h"
+#include "TuioCursor.h"
+#include <chrono>
+#include <vector>
+
+using namespace TUIO;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int TIMED_CURSORS = 10,
+                 TIMED_FRAMES = 200000,
+                 SAMPLES_PER_SECOND = 120;
+
+/**
+ * Nanoseconds per update() of a moving cursor, with TIMED_CURSORS down.
+ */
+static double timeUpdates( MotionPredictor::Model model )
+{
+    MotionPredictor predictor;
+    predictor.setModel( model );
+    std::vector<TuioCursor> cursors;
+
+    for( int i = 0; i < TIMED_CURSORS; ++i ) {
+        cursors.push_back( TuioCursor( TuioTime( 1, 0 ), i, i, 0.1f * i, 0.5f ) );
+    }
+    Clock::time_point start = Clock::now();
+
+    for( int f = 1; f <= TIMED_FRAMES; ++f ) {
+        long microseconds = (long)f * 1000000 / SAMPLES_PER_SECOND;
+        TuioTime time( 1 + microseconds / 1000000, microseconds % 1000000 );
+
+        for( int i = 0; i < TIMED_CURSORS; ++i ) {
+            cursors[i].update( time, 0.1f * i + 0.01f * (f % 50), 0.5f );
+            predictor.update( &cursors[i] );
+        }
+        predictor.forgetUnseen();
+    }
+    double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+    return seconds * 1e9 / ((double)TIMED_FRAMES * TIMED_CURSORS);
+}
+
+int main( int argc, char * argv[] )
+{
+    const MotionPredictor::Model models[] = { MotionPredictor::NONE,
+                                              MotionPredictor::CONSTANT_VELOCITY,
+                                              MotionPredictor::CONSTANT_ACCELERATION,
+                                              MotionPredictor::KALMAN };
+    printf( "cursor update and prediction, %d cursors down:\n", TIMED_CURSORS );
+
+    for( int m = 0; m < 4; ++m ) {
+        printf( "%-14s %8.1f ns\n", MotionPredictor::modelName( models[m] ), timeUpdates( models[m] ) );
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+/*******************************************************************************
+MotionPredictionCheck
+
+PURPOSE: Checks the MotionPredictor models on synthetic finger paths and in
+         TuioCursorServer's output, and prints how far off they are.
+
+NOTES:
+Each path is sampled at 120 Hz for SECONDS seconds, on a 1920 x 1080 screen,
+and every model predicts HORIZON ms ahead along it.  The predictor's own
+stats are printed in pixels: the average error of its predictions, the lag
+of the raw positions (see MotionPredictor.h) and the average offset of the
+predictions.  The checks:
+
+- a straight line at constant speed is predicted exactly by the velocity
+  and acceleration models, and the Kalman filter gets close;
+- on a path that speeds up, the acceleration model beats the velocity one;
+- on a circle with the pixel rounding and a pixel of jitter of a real
+  digitizer, every model beats sending the raw position, and the Kalman
+  filter beats the velocity model;
+- TuioCursorServer sends the predicted position (clamped to the screen)
+  and the measured speed, and forgets a cursor once it is removed.
+
+MotionPredictionBench measures what a prediction costs.
+
+Usage: MotionPredictionCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "MotionPredictor.h"
+#include "TuioCursor.h"
+#include "TuioCursorServer.h"
+#include "osc/OscReceivedElements.h"
+#include <cmath>
+
+using namespace TUIO;
+
+static const int SECONDS = 4,
+                 SAMPLES_PER_SECOND = 120,
+                 HORIZON = 16,
+                 SCREEN_WIDTH = 1920,
+                 SCREEN_HEIGHT = 1080;
+
+enum Path { LINE, SPEEDING_UP, JITTERY_CIRCLE };
+
+static const char * pathName( Path path )
+{
+    switch( path ) {
+        case LINE:        return "line";
+        case SPEEDING_UP: return "speeding up";
+        default:          return "jittery circle";
+    }
+}
+
+/**
+ * The position on the path at t seconds, in TUIO units.
+ */
+static void pathPosition( Path path, double t, int sample, float & x, float & y )
+{
+    if( path == LINE ) {
+        x = (float)(0.2 + 0.15 * t);
+        y = (float)(0.3 + 0.05 * t);
+    }
+    else if( path == SPEEDING_UP ) {
+        x = (float)(0.1 + 0.04 * t * t);
+        y = 0.5f;
+    }
+    else {
+        // One turn a second, 200 pixels around, rounded to pixels, with a
+        // pixel of jitter either way.
+        int jitterX = (int)((sample * 7919u) % 3) - 1,
+            jitterY = (int)((sample * 104729u) % 3) - 1;
+        double px = 960 + 200 * cos( 2 * M_PI * t ) + jitterX,
+               py = 540 + 200 * sin( 2 * M_PI * t ) + jitterY;
+        x = (float)(floor( px + 0.5 ) / SCREEN_WIDTH);
+        y = (float)(floor( py + 0.5 ) / SCREEN_HEIGHT);
+    }
+}
+
+static MotionPredictor::Stats run( Path path, MotionPredictor::Model model )
+{
+    MotionPredictor predictor;
+    predictor.setModel( model );
+    predictor.setHorizon( HORIZON );
+    float x, y;
+    pathPosition( path, 0.0, 0, x, y );
+    TuioCursor cursor( TuioTime( 1, 0 ), 1, 0, x, y );
+    predictor.update( &cursor );
+
+    for( int i = 1; i <= SECONDS * SAMPLES_PER_SECOND; ++i ) {
+        long microseconds = (long)i * 1000000 / SAMPLES_PER_SECOND;
+        pathPosition( path, microseconds / 1e6, i, x, y );
+        cursor.update( TuioTime( 1 + microseconds / 1000000, microseconds % 1000000 ), x, y );
+        predictor.update( &cursor );
+    }
+    return predictor.takeStats();
+}
+
+static double pixels( double tuioUnits )
+{
+    return tuioUnits * SCREEN_WIDTH;
+}
+
+static void checkPaths()
+{
+    const Path paths[] = { LINE, SPEEDING_UP, JITTERY_CIRCLE };
+    const MotionPredictor::Model models[] = { MotionPredictor::CONSTANT_VELOCITY,
+                                              MotionPredictor::CONSTANT_ACCELERATION,
+                                              MotionPredictor::KALMAN };
+    double error[3][3],
+           lag[3];
+
+    printf( "%d ms ahead at %d Hz, in pixels:\n", HORIZON, SAMPLES_PER_SECOND );
+    printf( "%-16s %-14s %8s %8s %8s\n", "path", "model", "error", "lag", "offset" );
+
+    for( int p = 0; p < 3; ++p ) {
+        for( int m = 0; m < 3; ++m ) {
+            MotionPredictor::Stats stats = run( paths[p], models[m] );
+            printf( "%-16s %-14s %8.3f %8.3f %8.3f\n", pathName( paths[p] ),
+                    MotionPredictor::modelName( models[m] ), pixels( stats.averageError ),
+                    pixels( stats.averageLag ), pixels( stats.averageOffset ) );
+            error[p][m] = stats.averageError;
+            lag[p] = stats.averageLag;
+            expect( "every prediction checked", stats.checked + HORIZON * SAMPLES_PER_SECOND / 1000 + 1 >= stats.predictions );
+        }
+    }
+    // The first position of a cursor is sent as it is, which adds its lag
+    // divided by the number of predictions to the average error.
+    expect( "line: velocity exact", pixels( error[LINE][0] - lag[LINE] / (SECONDS * SAMPLES_PER_SECOND) ) < 0.001 );
+    expect( "line: acceleration exact", pixels( error[LINE][1] - lag[LINE] / (SECONDS * SAMPLES_PER_SECOND) ) < 0.001 );
+    expect( "line: kalman close", error[LINE][2] < lag[LINE] / 10 );
+    expect( "speeding up: acceleration beats velocity", error[SPEEDING_UP][1] < error[SPEEDING_UP][0] );
+    expect( "circle: velocity beats raw", error[JITTERY_CIRCLE][0] < lag[JITTERY_CIRCLE] );
+    expect( "circle: acceleration beats raw", error[JITTERY_CIRCLE][1] < lag[JITTERY_CIRCLE] );
+    expect( "circle: kalman beats raw", error[JITTERY_CIRCLE][2] < lag[JITTERY_CIRCLE] );
+    expect( "circle: kalman beats velocity", error[JITTERY_CIRCLE][2] < error[JITTERY_CIRCLE][0] );
+}
+
+/**
+ * Keeps the x position last sent for each session ID.
+ */
+class RecordingSender : public OscSender
+{
+public:
+    RecordingSender()
+    {
+        buffer_size = MAX_UDP_SIZE;
+        local = true;
+
+        for( int i = 0; i < 4; ++i ) {
+            x[i] = xSpeed[i] = -1.0f;
+        }
+    }
+
+    bool sendOscPacket( osc::OutboundPacketStream * bundle )
+    {
+        osc::ReceivedBundle received( osc::ReceivedPacket( bundle->Data(), (osc::int32)bundle->Size() ) );
+
+        for( osc::ReceivedBundle::const_iterator i = received.ElementsBegin(); i != received.ElementsEnd(); ++i ) {
+            osc::ReceivedMessage message( *i );
+            osc::ReceivedMessage::const_iterator arg = message.ArgumentsBegin();
+
+            if( std::string( (arg++)->AsString() ) == "set" ) {
+                int id = (int)(arg++)->AsInt32();
+                float sentX = (arg++)->AsFloat();
+                ++arg; // y
+                float sentXSpeed = (arg++)->AsFloat();
+
+                if( id >= 0 && id < 4 ) {
+                    x[id] = sentX;
+                    xSpeed[id] = sentXSpeed;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool isConnected() { return true; }
+
+    float x[4],
+          xSpeed[4];
+};
+
+static void checkServer()
+{
+    RecordingSender sender;
+    TuioCursorServer server;
+    server.useFirstUdpSender( false );
+    server.useSecondUdpSender( false );
+    server.useFlashXmlTcpSender( false );
+    server.addOscSender( &sender );
+    server.getMotionPredictor().setModel( MotionPredictor::CONSTANT_VELOCITY );
+    server.getMotionPredictor().setHorizon( 20 );
+
+    server.initFrame( TuioTime( 1, 0 ) );
+    server.addTuioCursor( 7, 0.5f, 0.5f );
+    server.addTuioCursor( 8, 0.99f, 0.5f );
+    server.commitFrame();
+    expect( "server: new cursor sent where it is", sender.x[0] == 0.5f && sender.x[1] == 0.99f );
+
+    server.initFrame( TuioTime( 1, 10000 ) );
+    server.updateTuioCursor( 7, 0.505f, 0.5f );      // 0.5 a second
+    server.updateTuioCursor( 8, 0.995f, 0.5f );
+    server.commitFrame();
+    expect( "server: predicted position sent", fabs( sender.x[0] - 0.515f ) < 1e-5f );
+    expect( "server: measured speed sent", fabs( sender.xSpeed[0] - 0.5f ) < 1e-3f );
+    expect( "server: clamped to the screen", sender.x[1] == 1.0f );
+    expect( "server: both cursors known", server.getMotionPredictor().cursorCount() == 2 );
+
+    server.initFrame( TuioTime( 1, 20000 ) );
+    server.removeTuioCursor( 8 );
+    server.commitFrame();
+    expect( "server: removed cursor forgotten", server.getMotionPredictor().cursorCount() == 1 );
+
+    server.getMotionPredictor().setModel( MotionPredictor::NONE );
+    server.initFrame( TuioTime( 1, 30000 ) );
+    server.updateTuioCursor( 7, 0.51f, 0.5f );
+    server.commitFrame();
+    expect( "server: raw position sent with prediction off", sender.x[0] == 0.51f );
+}
+
+int main( int argc, char * argv[] )
+{
+    checkPaths();
+    checkServer();
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/*******************************************************************************
+OscTemplateBench
+
+PURPOSE: Measures writing messages with the templates of OscFixedMessage.h
+         against OutboundPacketStream's operator<<.
+
+NOTES:
+Each kind of message is written MESSAGES times both ways, then a bundle of
+FRAME_CURSORS cursors (alive, a set each, fseq) FRAMES times.
+
+OscTemplateCheck checks that both ways write the same bytes.
+
+Usage: OscTemplateBench
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "osc/OscFixedMessage.h"
+#include "osc/OscOutboundPacketStream.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int MESSAGES = 2000000,
+                 FRAMES = 20000,
+                 FRAME_CURSORS = 100,
+                 BUFFER_SIZE = 64 * 1024;
+
+struct Timing
+{
+    double streamNs,
+           templateNs;
+};
+
+template <int INT_COUNT, int FLOAT_COUNT>
+static Timing timeFixed( const char * address, const char * command )
+{
+    osc::FixedMessageTemplate<INT_COUNT, FLOAT_COUNT> message( address, command );
+    std::vector<char> buffer( BUFFER_SIZE );
+    osc::OutboundPacketStream packet( &buffer[0], BUFFER_SIZE );
+    const int perBundle = BUFFER_SIZE / 128;
+    osc::int32 ints[2] = { 17, 3 };
+    float floats[11];
+    Timing timing;
+
+    for( int i = 0; i < 11; ++i ) {
+        floats[i] = 0.1f * i;
+    }
+    Clock::time_point start = Clock::now();
+
+    for( int n = 0; n < MESSAGES; ++n ) {
+        if( n % perBundle == 0 ) {
+            packet.Clear();
+        }
+        packet << osc::BeginMessage( address ) << command;
+
+        for( int i = 0; i < INT_COUNT; ++i ) {
+            packet << ints[i];
+        }
+        for( int i = 0; i < FLOAT_COUNT; ++i ) {
+            packet << floats[i];
+        }
+        packet << osc::EndMessage;
+        floats[0] += 1.0f;
+    }
+    timing.streamNs = std::chrono::duration<double>( Clock::now() - start ).count() * 1e9 / MESSAGES;
+    start = Clock::now();
+
+    for( int n = 0; n < MESSAGES; ++n ) {
+        if( n % perBundle == 0 ) {
+            packet.Clear();
+        }
+        message.Write( packet, ints, floats );
+        floats[0] += 1.0f;
+    }
+    timing.templateNs = std::chrono::duration<double>( Clock::now() - start ).count() * 1e9 / MESSAGES;
+    return timing;
+}
+
+/**
+ * A bundle of FRAME_CURSORS cursors the way TuioCursorServer builds it.
+ */
+static Timing timeFrame()
+{
+    osc::Int32ListMessageTemplate alive( "/tuio/2Dcur", "alive" );
+    osc::FixedMessageTemplate<1, 5> set( "/tuio/2Dcur", "set" );
+    osc::FixedMessageTemplate<1, 0> fseq( "/tuio/2Dcur", "fseq" );
+    std::vector<char> buffer( BUFFER_SIZE );
+    osc::OutboundPacketStream packet( &buffer[0], BUFFER_SIZE );
+    float values[5] = { 0.5f, 0.5f, 0.01f, 0.02f, 0.1f };
+    Timing timing;
+
+    Clock::time_point start = Clock::now();
+
+    for( int f = 0; f < FRAMES; ++f ) {
+        packet.Clear();
+        packet << osc::BeginBundleImmediate << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+        for( int i = 0; i < FRAME_CURSORS; ++i ) {
+            packet << (osc::int32)i;
+        }
+        packet << osc::EndMessage;
+
+        for( int i = 0; i < FRAME_CURSORS; ++i ) {
+            packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)i << values[0] << values[1]
+                   << values[2] << values[3] << values[4] << osc::EndMessage;
+        }
+        packet << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)f << osc::EndMessage << osc::EndBundle;
+        values[0] += 0.001f;
+    }
+    timing.streamNs = std::chrono::duration<double>( Clock::now() - start ).count() * 1e9 / FRAMES;
+    start = Clock::now();
+
+    for( int f = 0; f < FRAMES; ++f ) {
+        packet.Clear();
+        packet << osc::BeginBundleImmediate;
+        char * ids = alive.Write( packet, FRAME_CURSORS );
+
+        for( int i = 0; i < FRAME_CURSORS; ++i ) {
+            osc::FixedMessageStoreUInt32( ids + i * 4, (osc::uint32)i );
+        }
+        for( osc::int32 i = 0; i < FRAME_CURSORS; ++i ) {
+            set.Write( packet, &i, values );
+        }
+        osc::int32 frame = f;
+        fseq.Write( packet, &frame, NULL );
+        packet << osc::EndBundle;
+        values[0] += 0.001f;
+    }
+    timing.templateNs = std::chrono::duration<double>( Clock::now() - start ).count() * 1e9 / FRAMES;
+    return timing;
+}
+
+int main( int argc, char * argv[] )
+{
+    printf( "nanoseconds per message written:\n" );
+    printf( "%-16s %12s %12s %8s\n", "", "operator<<", "template", "speedup" );
+    Timing timings[4] = { timeFixed<2, 8>( "/tuio/2Dobj", "set" ), timeFixed<1, 5>( "/tuio/2Dcur", "set" ),
+                          timeFixed<1, 11>( "/tuio/2Dblb", "set" ), timeFixed<1, 0>( "/tuio/2Dcur", "fseq" ) };
+    const char * names[4] = { "/tuio/2Dobj set", "/tuio/2Dcur set", "/tuio/2Dblb set", "/tuio/2Dcur fseq" };
+
+    for( int i = 0; i < 4; ++i ) {
+        printf( "%-16s %12.1f %12.1f %7.1fx\n", names[i], timings[i].streamNs, timings[i].templateNs,
+                timings[i].streamNs / timings[i].templateNs );
+    }
+    Timing frame = timeFrame();
+    printf( "bundle of %d cursors %8.1f us %9.1f us %7.1fx\n", FRAME_CURSORS, frame.streamNs / 1000,
+            frame.templateNs / 1000, frame.streamNs / frame.templateNs );
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*******************************************************************************
+OscTemplateCheck
+
+PURPOSE: Checks that the message templates of OscFixedMessage.h write the
+         very bytes OutboundPacketStream's operator<< writes, in TuioServer
+         and TuioCursorServer too.
+
+NOTES:
+The checks:
+
+- set and fseq messages of each profile, written by template and by
+  operator<<, alone and inside a bundle, with negative IDs, -0, infinity,
+  NaN and denormal floats, are the same bytes;
+- alive messages of 0 to 40 IDs, through every type tag padding, are the
+  same bytes;
+- every bundle TuioServer (objects, cursors and blobs, with a source name
+  and inverted axes) and TuioCursorServer send over a few hundred frames
+  of adds, moves and removes, is the same bytes as the bundle encoded again
+  with operator<< from its decoded messages;
+- a template that does not fit the buffer throws OutOfBufferMemoryException
+  as operator<< does.
+
+OscTemplateBench measures both ways of writing.
+
+Usage: OscTemplateCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TuioServer.h"
+#include "TuioCursorServer.h"
+#include "osc/OscFixedMessage.h"
+#include "osc/OscOutboundPacketStream.h"
+#include "osc/OscReceivedElements.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace TUIO;
+
+static const int BUFFER_SIZE = 64 * 1024;
+
+static bool samePacket( const osc::OutboundPacketStream & a, const osc::OutboundPacketStream & b )
+{
+    return a.Size() == b.Size() && memcmp( a.Data(), b.Data(), a.Size() ) == 0;
+}
+
+static const float ODD_FLOATS[] = { 0.5f, -0.0f, 1e-40f, std::numeric_limits<float>::infinity(),
+                                    std::numeric_limits<float>::quiet_NaN(), -123.25f, 0.0f, 3.4e38f,
+                                    -1e-20f, 1.0f, 0.999f };
+
+template <int INT_COUNT, int FLOAT_COUNT>
+static void checkFixed( const char * address, const char * command, bool inBundle )
+{
+    static const osc::int32 IDS[] = { 0, -1, 12345, 0x7fffffff, -0x7fffffff - 1 };
+    osc::FixedMessageTemplate<INT_COUNT, FLOAT_COUNT> message( address, command );
+    char bufferA[512], bufferB[512];
+    osc::OutboundPacketStream a( bufferA, sizeof( bufferA ) ),
+                              b( bufferB, sizeof( bufferB ) );
+    bool same = true;
+
+    for( int n = 0; n < 5; ++n ) {
+        osc::int32 ints[2];
+        float floats[11];
+        a.Clear();
+        b.Clear();
+
+        if( inBundle ) {
+            a << osc::BeginBundleImmediate;
+            b << osc::BeginBundleImmediate;
+        }
+        a << osc::BeginMessage( address ) << command;
+
+        for( int i = 0; i < INT_COUNT; ++i ) {
+            ints[i] = IDS[(n + i) % 5];
+            a << ints[i];
+        }
+        for( int i = 0; i < FLOAT_COUNT; ++i ) {
+            floats[i] = ODD_FLOATS[(n + i) % 11];
+            a << floats[i];
+        }
+        a << osc::EndMessage;
+        message.Write( b, ints, floats );
+
+        if( inBundle ) {
+            a << osc::EndBundle;
+            b << osc::EndBundle;
+        }
+        same = same && samePacket( a, b ) && b.IsReady();
+    }
+    std::string name = std::string( address ) + " " + command + (inBundle ? " in a bundle" : "");
+    expect( name.c_str(), same );
+}
+
+static void checkAlive()
+{
+    osc::Int32ListMessageTemplate alive( "/tuio/2Dcur", "alive" );
+    char bufferA[1024], bufferB[1024];
+    osc::OutboundPacketStream a( bufferA, sizeof( bufferA ) ),
+                              b( bufferB, sizeof( bufferB ) );
+    bool same = true;
+
+    for( int count = 0; count <= 40; ++count ) {
+        a.Clear();
+        b.Clear();
+        a << osc::BeginBundleImmediate << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+        b << osc::BeginBundleImmediate;
+        char * ids = alive.Write( b, count );
+
+        for( int i = 0; i < count; ++i ) {
+            a << (osc::int32)(i * 1000 - 7);
+            osc::FixedMessageStoreUInt32( ids + i * 4, (osc::uint32)(i * 1000 - 7) );
+        }
+        a << osc::EndMessage << osc::EndBundle;
+        b << osc::EndBundle;
+        same = same && samePacket( a, b );
+    }
+    expect( "alive, 0 to 40 IDs", same );
+}
+
+static void checkOverflow()
+{
+    osc::FixedMessageTemplate<1, 5> set( "/tuio/2Dcur", "set" );
+    char buffer[64];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    osc::int32 id = 1;
+    float values[5] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    bool thrown = false;
+    packet << osc::BeginBundleImmediate;
+
+    try {
+        set.Write( packet, &id, values );
+        set.Write( packet, &id, values );
+    }
+    catch( osc::OutOfBufferMemoryException & ) {
+        thrown = true;
+    }
+    expect( "overflow: thrown", thrown );
+}
+
+/**
+ * Encodes the bundle again with operator<<, from its decoded messages.
+ */
+static void reencode( const char * data, unsigned long size, osc::OutboundPacketStream & out )
+{
+    osc::ReceivedBundle bundle( osc::ReceivedPacket( data, (osc::int32)size ) );
+    out << osc::BeginBundle( bundle.TimeTag() );
+
+    for( osc::ReceivedBundle::const_iterator i = bundle.ElementsBegin(); i != bundle.ElementsEnd(); ++i ) {
+        osc::ReceivedMessage message( *i );
+        out << osc::BeginMessage( message.AddressPattern() );
+
+        for( osc::ReceivedMessage::const_iterator arg = message.ArgumentsBegin(); arg != message.ArgumentsEnd(); ++arg ) {
+            if( arg->IsString() ) {
+                out << arg->AsStringUnchecked();
+            }
+            else if( arg->IsInt32() ) {
+                out << arg->AsInt32Unchecked();
+            }
+            else {
+                out << arg->AsFloat();
+            }
+        }
+        out << osc::EndMessage;
+    }
+    out << osc::EndBundle;
+}
+
+/**
+ * Checks every bundle it is given against its re-encoding.
+ */
+class CheckingSender : public OscSender
+{
+public:
+    CheckingSender() : packets( 0 ), mismatches( 0 ), buffer_( BUFFER_SIZE )
+    {
+        buffer_size = MAX_UDP_SIZE;
+        local = true;
+    }
+
+    bool sendOscPacket( osc::OutboundPacketStream * bundle )
+    {
+        osc::OutboundPacketStream again( &buffer_[0], BUFFER_SIZE );
+        reencode( bundle->Data(), bundle->Size(), again );
+        ++packets;
+
+        if( !samePacket( *bundle, again ) ) {
+            ++mismatches;
+        }
+        return true;
+    }
+
+    bool isConnected() { return true; }
+
+    unsigned long packets,
+                  mismatches;
+
+private:
+    std::vector<char> buffer_;
+};
+
+static float coordinate( int entity, int frame, int axis )
+{
+    return 0.05f + 0.9f * (float)((entity * 53 + frame * (axis + 2) * 7) % 1000) / 1000.0f;
+}
+
+static void checkTuioServer()
+{
+    CheckingSender sender;
+    {
+        TuioServer server( &sender );
+        server.setSourceName( "bench" );
+        server.setInvertXpos( true );
+        server.setInvertYpos( true );
+        std::vector<TuioCursor *> cursors;
+        std::vector<TuioObject *> objects;
+        std::vector<TuioBlob *> blobs;
+
+        for( int f = 0; f < 300; ++f ) {
+            server.initFrame( TuioTime( 1 + f / 100, (f % 100) * 10000 ) );
+
+            if( f % 50 < 10 ) {
+                int n = (int)cursors.size();
+                cursors.push_back( server.addTuioCursor( coordinate( n, f, 0 ), coordinate( n, f, 1 ) ) );
+                objects.push_back( server.addTuioObject( n % 5, coordinate( n, f, 1 ), coordinate( n, f, 0 ), 0.1f * n ) );
+                blobs.push_back( server.addTuioBlob( coordinate( n, f, 0 ), coordinate( n, f, 2 ), 0.2f, 0.1f, 0.05f,
+                                                     0.005f ) );
+            }
+            else if( f % 50 >= 40 && !cursors.empty() ) {
+                server.removeTuioCursor( cursors.back() );
+                server.removeTuioObject( objects.back() );
+                server.removeTuioBlob( blobs.back() );
+                cursors.pop_back();
+                objects.pop_back();
+                blobs.pop_back();
+            }
+            for( size_t i = 0; i < cursors.size(); ++i ) {
+                if( (f + i) % 3 != 0 ) {
+                    server.updateTuioCursor( cursors[i], coordinate( (int)i, f, 0 ), coordinate( (int)i, f, 1 ) );
+                    server.updateTuioObject( objects[i], coordinate( (int)i, f, 1 ), coordinate( (int)i, f, 0 ),
+                                             0.01f * f );
+                    server.updateTuioBlob( blobs[i], coordinate( (int)i, f, 0 ), coordinate( (int)i, f, 2 ), 0.2f,
+                                           0.1f + 0.001f * f, 0.05f, 0.005f );
+                }
+            }
+            server.commitFrame();
+        }
+    }
+    expect( "TuioServer: same bytes", sender.packets > 900 && sender.mismatches == 0 );
+}
+
+static void checkTuioCursorServer()
+{
+    CheckingSender sender;
+    {
+        TuioCursorServer server( "127.0.0.1", 3333, 3334, 0 );
+        server.useFirstUdpSender( false );
+        server.useSecondUdpSender( false );
+        server.useFlashXmlTcpSender( false );
+        server.addOscSender( &sender );
+        server.setSourceName( "bench" );
+        int live = 0;
+
+        for( int f = 0; f < 300; ++f ) {
+            server.initFrame( TuioTime( 1 + f / 100, (f % 100) * 10000 ) );
+
+            if( f % 50 < 10 ) {
+                server.addTuioCursor( live, coordinate( live, f, 0 ), coordinate( live, f, 1 ) );
+                ++live;
+            }
+            else if( f % 50 >= 40 && live > 0 ) {
+                server.removeTuioCursor( --live );
+            }
+            for( int i = 0; i < live; ++i ) {
+                if( (f + i) % 3 != 0 ) {
+                    server.updateTuioCursor( i, coordinate( i, f, 0 ), coordinate( i, f, 1 ) );
+                }
+            }
+            server.commitFrame();
+        }
+    }
+    expect( "TuioCursorServer: same bytes", sender.packets > 250 && sender.mismatches == 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+    for( int inBundle = 0; inBundle < 2; ++inBundle ) {
+        checkFixed<1, 5>( "/tuio/2Dcur", "set", inBundle != 0 );
+        checkFixed<2, 8>( "/tuio/2Dobj", "set", inBundle != 0 );
+        checkFixed<1, 11>( "/tuio/2Dblb", "set", inBundle != 0 );
+        checkFixed<1, 0>( "/tuio/2Dcur", "fseq", inBundle != 0 );
+    }
+    checkAlive();
+    checkOverflow();
+    checkTuioServer();
+    checkTuioCursorServer();
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
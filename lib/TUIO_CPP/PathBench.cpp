@@ -0,0 +1,165 @@
+/*******************************************************************************
+PathBench
+
+PURPOSE: Measures the memory and update cost of TuioContainer paths for
+         long-lived cursors.
+
+NOTES:
+A number of TuioCursors are updated as if fingers were held down for a long
+time at a high sample rate (by default 10 cursors, 240 Hz, 5 minutes).  This
+is done for several path depths, and once with an unbounded std::list of
+TuioPoints standing in for the old path.  For each run the heap still in use
+at the end, the allocations made by updates after the first, and the time per
+update are printed.  Every 4th update the path is also walked, the way a
+simulator or demo draws it, through the TuioPath view and, for comparison,
+through a getPath() copy.
+
+Heap use is tracked as BenchSupport.h does.
+
+PathCheck checks that TuioPath keeps the right points.
+
+Usage: PathBench [cursors] [updates per cursor]
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "TuioCursor.h"
+#include <list>
+#include <vector>
+
+using namespace TUIO;
+
+static const unsigned int DRAW_INTERVAL = 4;
+static const int UNBOUNDED_LIST = -1;
+
+static float xAt( unsigned int cursor, unsigned int update )
+{
+    return (float)((cursor * 7 + update) % 1000) / 1000.0f;
+}
+
+static TuioTime timeAt( unsigned int update )
+{
+    long micros = (long)update * 4167; // 240 Hz
+    return TuioTime( micros / 1000000, micros % 1000000 );
+}
+
+// What the draws add up, so that they are not optimized away.
+static volatile double drawSum = 0.0;
+
+struct PathResult
+{
+    long long bytes;
+    unsigned long long steadyAllocations;
+    double nsPerUpdate,
+           nsPerViewDraw,
+           nsPerCopyDraw;
+};
+
+static PathResult run( unsigned int cursors, unsigned int updates, int depth )
+{
+    PathResult result = PathResult();
+    long long bytesBefore = heapBytes;
+    std::vector<TuioCursor *> cursorList;
+    std::vector<std::list<TuioPoint> > oldPaths( depth == UNBOUNDED_LIST ? cursors : 0 );
+    double viewSum = 0.0,
+           copySum = 0.0;
+
+    for( unsigned int c = 0; c < cursors; ++c ) {
+        TuioCursor * tcur = new TuioCursor( timeAt( 0 ), c, c, xAt( c, 0 ), 0.5f );
+        tcur->setPathDepth( depth == UNBOUNDED_LIST ? 0 : (unsigned int)depth );
+        cursorList.push_back( tcur );
+
+        if( depth == UNBOUNDED_LIST ) {
+            oldPaths[c].push_back( TuioPoint( timeAt( 0 ), xAt( c, 0 ), 0.5f ) );
+        }
+    }
+    double updateTime = 0.0,
+           viewTime = 0.0,
+           copyTime = 0.0;
+    unsigned int draws = 0;
+
+    for( unsigned int u = 1; u <= updates; ++u ) {
+        unsigned long long allocationsBefore = heapAllocations;
+        double start = seconds();
+
+        for( unsigned int c = 0; c < cursors; ++c ) {
+            cursorList[c]->update( timeAt( u ), xAt( c, u ), 0.5f );
+
+            if( depth == UNBOUNDED_LIST ) {
+                oldPaths[c].push_back( TuioPoint( timeAt( u ), xAt( c, u ), 0.5f ) );
+            }
+        }
+        updateTime += seconds() - start;
+
+        if( u > 1 ) { // the first update allocates the rings
+            result.steadyAllocations += heapAllocations - allocationsBefore;
+        }
+
+        if( u % DRAW_INTERVAL == 0 && depth != UNBOUNDED_LIST ) {
+            start = seconds();
+
+            for( unsigned int c = 0; c < cursors; ++c ) {
+                const TuioPath & path = cursorList[c]->getTuioPath();
+
+                for( TuioPath::const_iterator point = path.begin(); point != path.end(); ++point ) {
+                    viewSum += point->getX();
+                }
+            }
+            viewTime += seconds() - start;
+            start = seconds();
+
+            for( unsigned int c = 0; c < cursors; ++c ) {
+                std::list<TuioPoint> path = cursorList[c]->getPath();
+
+                for( std::list<TuioPoint>::iterator point = path.begin(); point != path.end(); ++point ) {
+                    copySum += point->getX();
+                }
+            }
+            copyTime += seconds() - start;
+            ++draws;
+        }
+    }
+    result.bytes = heapBytes - bytesBefore;
+    result.nsPerUpdate = updateTime * 1e9 / ((double)updates * cursors);
+    result.nsPerViewDraw = draws > 0 ? viewTime * 1e9 / ((double)draws * cursors) : 0.0;
+    result.nsPerCopyDraw = draws > 0 ? copyTime * 1e9 / ((double)draws * cursors) : 0.0;
+
+    drawSum = drawSum + viewSum + copySum;
+
+    for( unsigned int c = 0; c < cursors; ++c ) {
+        delete cursorList[c];
+    }
+    return result;
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int cursors = argc > 1 ? (unsigned int)atoi( argv[1] ) : 10,
+                 updates = argc > 2 ? (unsigned int)atoi( argv[2] ) : 240 * 60 * 5;
+
+    if( cursors == 0 || updates == 0 ) {
+        fprintf( stderr, "usage: %s [cursors] [updates per cursor]\n", argv[0] );
+        return 2;
+    }
+    int depths[] = { UNBOUNDED_LIST, 0, 16, TuioPath::DEFAULT_DEPTH, 1024 };
+
+    printf( "cursors: %u, updates per cursor: %u\n", cursors, updates );
+    printf( "%10s %14s %14s %14s %14s %14s\n", "depth", "heap bytes", "steady allocs",
+            "ns/update", "ns/view draw", "ns/copy draw" );
+
+    for( unsigned int i = 0; i < sizeof( depths ) / sizeof( depths[0] ); ++i ) {
+        PathResult result = run( cursors, updates, depths[i] );
+
+        if( depths[i] == UNBOUNDED_LIST ) {
+            printf( "%10s %14lld %14llu %14.1f %14s %14s\n", "old list", result.bytes,
+                    result.steadyAllocations, result.nsPerUpdate, "-", "-" );
+        }
+        else {
+            printf( "%10d %14lld %14llu %14.1f %14.1f %14.1f\n", depths[i], result.bytes,
+                    result.steadyAllocations, result.nsPerUpdate,
+                    result.nsPerViewDraw, result.nsPerCopyDraw );
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*******************************************************************************
+PathCheck
+
+PURPOSE: Checks that TuioPath keeps the right points of a long-lived cursor
+         without allocating once it is full.
+
+NOTES:
+For several path depths, cursors are updated as if fingers were held down
+at 240 Hz, for fewer updates than the depth and for many more.  Every path
+must then hold the last depth points in order, the TuioPath view and a
+getPath() copy must see the same points, and no update after the first may
+allocate (counted as BenchSupport.h does).
+
+PathBench measures the memory and update cost.
+
+Usage: PathCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "TuioCursor.h"
+#include <list>
+#include <vector>
+
+using namespace TUIO;
+
+static const unsigned int CURSORS = 4;
+
+static float xAt( unsigned int cursor, unsigned int update )
+{
+    return (float)((cursor * 7 + update) % 1000) / 1000.0f;
+}
+
+static TuioTime timeAt( unsigned int update )
+{
+    long micros = (long)update * 4167; // 240 Hz
+    return TuioTime( micros / 1000000, micros % 1000000 );
+}
+
+static void checkPaths( unsigned int depth, unsigned int updates )
+{
+    std::vector<TuioCursor *> cursorList;
+
+    for( unsigned int c = 0; c < CURSORS; ++c ) {
+        TuioCursor * tcur = new TuioCursor( timeAt( 0 ), c, c, xAt( c, 0 ), 0.5f );
+        tcur->setPathDepth( depth );
+        cursorList.push_back( tcur );
+    }
+    unsigned long long steadyAllocations = 0;
+
+    for( unsigned int u = 1; u <= updates; ++u ) {
+        unsigned long long allocationsBefore = heapAllocations;
+
+        for( unsigned int c = 0; c < CURSORS; ++c ) {
+            cursorList[c]->update( timeAt( u ), xAt( c, u ), 0.5f );
+        }
+        if( u > 1 ) { // the first update allocates the rings
+            steadyAllocations += heapAllocations - allocationsBefore;
+        }
+    }
+    unsigned int expected = depth < updates + 1 ? depth : updates + 1;
+    bool points = true,
+         sameAsCopy = true;
+
+    for( unsigned int c = 0; c < CURSORS; ++c ) {
+        const TuioPath & path = cursorList[c]->getTuioPath();
+        std::list<TuioPoint> copy = cursorList[c]->getPath();
+
+        if( path.size() != expected || copy.size() != path.size() ) {
+            fprintf( stderr, "depth %u: cursor %u has %u points\n", depth, c, path.size() );
+            points = false;
+            continue;
+        }
+        std::list<TuioPoint>::iterator copied = copy.begin();
+
+        for( unsigned int i = 0; i < path.size(); ++i, ++copied ) {
+            points = points && path[i].getX() == xAt( c, updates + 1 - expected + i );
+            sameAsCopy = sameAsCopy && copied->getX() == path[i].getX()
+                         && copied->getTuioTime() == path[i].getTuioTime();
+        }
+    }
+    for( unsigned int c = 0; c < CURSORS; ++c ) {
+        delete cursorList[c];
+    }
+    char name[64];
+    snprintf( name, sizeof( name ), "depth %u, %u updates: points", depth, updates );
+    expect( name, points );
+    snprintf( name, sizeof( name ), "depth %u, %u updates: view and copy", depth, updates );
+    expect( name, sameAsCopy );
+    snprintf( name, sizeof( name ), "depth %u, %u updates: no allocations", depth, updates );
+    expect( name, steadyAllocations == 0 );
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int depths[] = { 0, 1, 16, TuioPath::DEFAULT_DEPTH, 1024 };
+
+    for( unsigned int i = 0; i < sizeof( depths ) / sizeof( depths[0] ); ++i ) {
+        checkPaths( depths[i], 10 );
+        checkPaths( depths[i], 5000 );
+    }
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+/*******************************************************************************
+PointerReplay
+
+PURPOSE: Replays a pointer event log recorded by TouchHooks2Tuio through a
+         TuioCursorServer, at the recorded speed, N times faster or as fast
+         as possible, and reports throughput and per-frame latency as JSON.
+
+NOTES:
+The log is mapped into memory, so events cost no I/O during the run.  The
+events go through the same TouchPipeline as in TouchHooks2Tuio, set up with
+the screen geometry stored in the log.  Events of one input frame (the same
+frame id, or the same timestamp if the hook did not know the frame) are
+followed by one commitFrame(), and the pipeline's clock returns the
+recorded time, so the TUIO output of two runs is the same whatever the
+speed.
+
+Latency is measured per frame until commitFrame() returns, that is until
+every bundle has been handed to the senders.  It starts when the frame is
+started, or, if the frame was due (its recorded time divided by the speed)
+while the previous one was still being sent, when it was due, so the wait
+counts as latency.
+
+By default bundles are sent to the TUIO UDP ports 3333 and 3334 on
+localhost and to Flash XML clients on port 3000.  With --sink the UDP
+channels and the Flash XML channel are turned off and the bundles go to a
+sender that only counts them.
+
+With --predict MODEL MS the cursors are sent MS milliseconds ahead of the
+input by the MotionPredictor model named (velocity, acceleration or
+kalman), and the JSON gets the predictor's stats in pixels: how far the
+predictions were from where the input was MS milliseconds later, against
+how far the raw positions were (the lag they make up for), and how far the
+predictions were from the raw positions.  The latency shows what the
+prediction costs.
+
+--generate writes a synthetic log instead: FINGERS pointers moving in
+circles at 120 input frames per second for SECONDS seconds, every finger
+lifted and put down again every second or so.
+
+Usage: PointerReplay LOG [1|N|max] [--loops N] [--sink] [--host HOST] [--predict MODEL MS]
+       PointerReplay LOG --generate FINGERS SECONDS
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "PointerEventLog.h"
+#include "TouchPipeline.h"
+#include "TuioCursorServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TUIO;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int64_t GENERATED_TICKS_PER_SECOND = 10000000; // as QueryPerformanceCounter
+static const int GENERATED_FRAMES_PER_SECOND = 120;
+
+static TuioTime recordedFrameTime;
+
+/**
+ * The pipeline's clock: frames are stamped with the recorded time.
+ */
+static TuioTime recordedClock()
+{
+    return recordedFrameTime;
+}
+
+static bool sameFrame( const PointerEventRecord & a, const PointerEventRecord & b )
+{
+    return a.frameId != 0 ? a.frameId == b.frameId : a.timestamp == b.timestamp;
+}
+
+static double percentile( const std::vector<double> & sorted, double p )
+{
+    if( sorted.empty() ) {
+        return 0.0;
+    }
+    size_t i = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min( i, sorted.size() - 1 )];
+}
+
+static int generate( const char * path, int fingers, int seconds )
+{
+    PointerEventLogHeader header = PointerEventLogHeader();
+    header.ticksPerSecond = GENERATED_TICKS_PER_SECOND;
+    header.screenWidth = 1920;
+    header.screenHeight = 1080;
+    header.mirroredMonitors = 1;
+    PointerEventRecorder recorder;
+
+    if( !recorder.open( path, header ) ) {
+        fprintf( stderr, "cannot create %s\n", path );
+        return 1;
+    }
+    int frames = seconds * GENERATED_FRAMES_PER_SECOND;
+    std::vector<bool> down( fingers, false );
+
+    for( int f = 0; f < frames; ++f ) {
+        int64_t timestamp = (int64_t)f * GENERATED_TICKS_PER_SECOND / GENERATED_FRAMES_PER_SECOND;
+
+        for( int i = 0; i < fingers; ++i ) {
+            double angle = 2.0 * M_PI * (f + 7 * i) / GENERATED_FRAMES_PER_SECOND;
+            int x = (int)(200 + 150 * i + 100 * cos( angle )),
+                y = (int)(540 + 100 * sin( angle )),
+                phase = (f + 13 * i) % (GENERATED_FRAMES_PER_SECOND + 6);
+            unsigned int id = (unsigned int)(i + 1);
+
+            if( phase >= GENERATED_FRAMES_PER_SECOND ) { // lifted for a few frames
+                if( down[i] ) {
+                    recorder.record( POINTER_UP, id, (unsigned int)f + 1, x, y, timestamp );
+                    down[i] = false;
+                }
+            }
+            else {
+                recorder.record( down[i] ? POINTER_UPDATE : POINTER_DOWN, id, (unsigned int)f + 1, x, y, timestamp );
+                down[i] = true;
+            }
+        }
+    }
+    for( int i = 0; i < fingers; ++i ) {
+        if( down[i] ) {
+            int64_t timestamp = (int64_t)frames * GENERATED_TICKS_PER_SECOND / GENERATED_FRAMES_PER_SECOND;
+            recorder.record( POINTER_UP, (unsigned int)(i + 1), (unsigned int)frames + 1, 0, 0, timestamp );
+        }
+    }
+    unsigned long count = recorder.recordCount();
+    recorder.close();
+    printf( "%s: %lu events of %d fingers over %d seconds\n", path, count, fingers, seconds );
+    return 0;
+}
+
+int main( int argc, char * argv[] )
+{
+    if( argc < 2 ) {
+        fprintf( stderr, "usage: %s LOG [1|N|max] [--loops N] [--sink] [--host HOST] [--predict MODEL MS]\n"
+                         "       %s LOG --generate FINGERS SECONDS\n", argv[0], argv[0] );
+        return 2;
+    }
+    const char * path = argv[1],
+               * host = "127.0.0.1",
+               * speedName = "1";
+    double speed = 1.0; // 0 is max speed
+    int loops = 1;
+    bool sink = false;
+    MotionPredictor::Model predictionModel = MotionPredictor::NONE;
+    unsigned int predictionHorizon = MotionPredictor::DEFAULT_HORIZON;
+
+    for( int i = 2; i < argc; ++i ) {
+        std::string arg = argv[i];
+
+        if( arg == "--generate" && i + 2 < argc ) {
+            return generate( path, atoi( argv[i + 1] ), atoi( argv[i + 2] ) );
+        }
+        else if( arg == "--loops" && i + 1 < argc ) {
+            loops = std::max( atoi( argv[++i] ), 1 );
+        }
+        else if( arg == "--host" && i + 1 < argc ) {
+            host = argv[++i];
+        }
+        else if( arg == "--sink" ) {
+            sink = true;
+        }
+        else if( arg == "--predict" && i + 2 < argc ) {
+            if( !MotionPredictor::parseModel( argv[++i], predictionModel ) ) {
+                fprintf( stderr, "unknown prediction model %s\n", argv[i] );
+                return 2;
+            }
+            predictionHorizon = (unsigned int)std::max( atoi( argv[++i] ), 0 );
+        }
+        else if( arg == "max" ) {
+            speed = 0.0;
+            speedName = argv[i];
+        }
+        else if( atof( arg.c_str() ) > 0.0 ) {
+            speed = atof( arg.c_str() );
+            speedName = argv[i];
+        }
+        else {
+            fprintf( stderr, "unknown argument %s\n", arg.c_str() );
+            return 2;
+        }
+    }
+    PointerEventLog log;
+
+    if( !log.open( path ) ) {
+        fprintf( stderr, "%s\n", log.error().c_str() );
+        return 1;
+    }
+    if( log.size() == 0 ) {
+        fprintf( stderr, "%s has no events\n", path );
+        return 1;
+    }
+    SinkSender sinkSender;
+    TuioCursorServer server( host, 3333, 3334, 3000 );
+
+    if( sink ) {
+        server.useFirstUdpSender( false );
+        server.useSecondUdpSender( false );
+        server.useFlashXmlTcpSender( false );
+        server.addOscSender( &sinkSender );
+    }
+    server.getMotionPredictor().setModel( predictionModel );
+    server.getMotionPredictor().setHorizon( predictionHorizon );
+    TouchPipeline pipeline( &server );
+    pipeline.setScreenDimensions( log.header().screenX, log.header().screenY,
+                                  log.header().screenWidth, log.header().screenHeight );
+    pipeline.setMirroredMonitors( log.header().mirroredMonitors != 0 );
+    pipeline.setClock( &recordedClock );
+    const int64_t firstTicks = log[0].timestamp,
+                  loopTicks = log[log.size() - 1].timestamp - firstTicks + log.header().ticksPerSecond / 100;
+    std::vector<double> latencies;
+    unsigned long events = 0;
+    int64_t frameMicroSeconds = -1;
+    Clock::time_point start = Clock::now();
+
+    for( int loop = 0; loop < loops; ++loop ) {
+        size_t i = 0;
+
+        while( i < log.size() ) {
+            const PointerEventRecord & first = log[i];
+            int64_t ticks = first.timestamp - firstTicks + loop * loopTicks;
+            Clock::time_point due = Clock::now();
+
+            if( speed > 0.0 ) {
+                Clock::time_point scheduled = start + std::chrono::nanoseconds( (int64_t)(log.seconds( ticks ) / speed * 1e9) );
+
+                if( scheduled > due ) {
+                    std::this_thread::sleep_until( scheduled );
+                    due = Clock::now(); // the replayer's own wakeup delay is not counted
+                }
+                else {
+                    due = scheduled; // behind schedule: the wait is counted
+                }
+            }
+            // Frames must be at least a microsecond apart, or their updates are ignored.
+            frameMicroSeconds = std::max( (int64_t)(log.seconds( ticks ) * 1e6), frameMicroSeconds + 1 );
+            recordedFrameTime = TuioTime( (long)(frameMicroSeconds / 1000000), (long)(frameMicroSeconds % 1000000) );
+
+            for( ; i < log.size() && sameFrame( first, log[i] ); ++i ) {
+                const PointerEventRecord & record = log[i];
+                PointerEvent event;
+                event.id = record.pointerId;
+                event.type = (int)record.eventType;
+                event.pointerType = (int)record.pointerType;
+                event.x = record.x;
+                event.y = record.y;
+                event.timestamp = record.timestamp;
+                pipeline.process( event );
+                ++events;
+            }
+            pipeline.commitFrame();
+            latencies.push_back( std::chrono::duration<double, std::micro>( Clock::now() - due ).count() );
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>( Clock::now() - start ).count(),
+           recordedSeconds = log.seconds( loopTicks ) * loops;
+    std::sort( latencies.begin(), latencies.end() );
+
+    printf( "{\n  \"log\": \"%s\",\n  \"speed\": \"%s\",\n  \"loops\": %d,\n  \"sink\": %s,\n"
+            "  \"events\": %lu,\n  \"frames\": %u,\n  \"recorded_seconds\": %.3f,\n  \"wall_seconds\": %.3f,\n"
+            "  \"events_per_second\": %.0f,\n  \"frames_per_second\": %.0f,\n",
+            path, speedName, loops, sink ? "true" : "false",
+            events, (unsigned int)latencies.size(), recordedSeconds, wallSeconds,
+            events / wallSeconds, latencies.size() / wallSeconds );
+    printf( "  \"latency_us\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}",
+            percentile( latencies, 0.5 ), percentile( latencies, 0.9 ), percentile( latencies, 0.99 ),
+            percentile( latencies, 0.999 ), latencies.empty() ? 0.0 : latencies.back() );
+
+    if( sink ) {
+        printf( ",\n  \"packets\": %llu,\n  \"bytes\": %llu", sinkSender.packets.load(), sinkSender.bytes.load() );
+    }
+    if( predictionModel != MotionPredictor::NONE ) {
+        MotionPredictor::Stats stats = server.getMotionPredictor().takeStats();
+        double width = log.header().screenWidth;
+
+        printf( ",\n  \"prediction\": {\"model\": \"%s\", \"horizon_ms\": %u, \"predictions\": %lu, \"checked\": %lu,\n"
+                "                 \"error_px\": %.2f, \"lag_px\": %.2f, \"offset_px\": %.2f, \"max_offset_px\": %.2f}",
+                MotionPredictor::modelName( predictionModel ), server.getMotionPredictor().horizon(),
+                stats.predictions, stats.checked, stats.averageError * width, stats.averageLag * width,
+                stats.averageOffset * width, stats.maxOffset * width );
+    }
+    printf( "\n}\n" );
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+RingBufferBench
+
+PURPOSE: Measures the SharedRingBuffer used between the TouchHook DLL and
+         TouchHooks2Tuio, on Linux, with real processes.
+
+NOTES:
+A SharedRingBuffer is placed in an anonymous shared mapping, and several
+child processes are forked to act as hooked processes pushing records into
+it, while the parent process consumes them in batches, just like
+TouchMessageListener does.  Producers retry when the ring is full, so drops
+only count the retries.  RingBufferCheck checks that the records arrive
+in order and that a stalled producer is skipped.
+
+Usage: RingBufferBench [producers] [records per producer]
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "SharedRingBuffer.h"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <sched.h>
+#include <vector>
+
+struct BenchRecord
+{
+    ring_uint32_t producer,
+                  sequence;
+};
+
+typedef TUIO::SharedRingBuffer<BenchRecord, 4096> BenchRing;
+
+static const unsigned int BATCH_SIZE = 64;
+
+static void produce( BenchRing * ring, unsigned int producer, unsigned int records )
+{
+    BenchRecord record;
+    record.producer = producer;
+
+    for( unsigned int i = 0; i < records; ++i ) {
+        record.sequence = i;
+
+        while( !ring->tryPush( record ) ) {
+            sched_yield();
+        }
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int producers = argc > 1 ? (unsigned int)atoi( argv[1] ) : 4,
+                 records = argc > 2 ? (unsigned int)atoi( argv[2] ) : 1000000;
+
+    if( producers == 0 || records == 0 ) {
+        fprintf( stderr, "usage: %s [producers] [records per producer]\n", argv[0] );
+        return 2;
+    }
+    void * memory = mmap( NULL, sizeof( BenchRing ), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if( memory == MAP_FAILED ) {
+        perror( "mmap" );
+        return 1;
+    }
+    BenchRing * ring = (BenchRing *)memory;
+
+    if( !ring->initialize() ) {
+        fprintf( stderr, "ring atomics are not lock-free\n" );
+        return 1;
+    }
+    double start = seconds();
+    std::vector<pid_t> children;
+
+    for( unsigned int p = 0; p < producers; ++p ) {
+        pid_t pid = fork();
+
+        if( pid == 0 ) {
+            produce( ring, p, records );
+            _exit( 0 );
+        }
+        else if( pid < 0 ) {
+            perror( "fork" );
+            return 1;
+        }
+        children.push_back( pid );
+    }
+    unsigned long long total = (unsigned long long)producers * records,
+                       received = 0;
+    BenchRecord batch[BATCH_SIZE];
+
+    while( received < total ) {
+        unsigned int count = ring->tryPopBatch( batch, BATCH_SIZE );
+
+        if( count == 0 ) {
+            if( ring->isStalled() ) {
+                sched_yield();
+            }
+            continue;
+        }
+        received += count;
+    }
+    double elapsed = seconds() - start;
+
+    for( size_t i = 0; i < children.size(); ++i ) {
+        int status = 0;
+        waitpid( children[i], &status, 0 );
+    }
+    printf( "producers: %u, records: %llu, full-ring retries: %u\n",
+            producers, total, ring->droppedCount() );
+    printf( "%.0f records/s, %.1f ns/record\n",
+            total / elapsed, elapsed * 1e9 / total );
+
+    munmap( memory, sizeof( BenchRing ) );
+    return 0;
+}
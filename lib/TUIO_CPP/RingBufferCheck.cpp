@@ -0,0 +1,314 @@
+/*******************************************************************************
+RingBufferCheck
+
+PURPOSE: Checks the SharedRingBuffer used between the TouchHook DLL and
+         TouchHooks2Tuio, on Linux, alone and with real processes.
+
+NOTES:
+First a small ring is driven from this process alone: it refuses to pop
+when empty and to push when full (and counts the drop), gives the records
+back in order through several wraps, by one and in batches, hands the
+wakeup to one producer only and does not skip a cell that is not stalled.
+
+Then a SharedRingBuffer is placed in an anonymous shared mapping, and
+PRODUCERS child processes are forked to act as hooked processes pushing
+records into it, while this process consumes them in batches, just like
+TouchMessageListener does.  Every record carries its producer id and a
+sequence number, so nothing may be lost or duplicated and each producer's
+records must arrive in order.  Producers retry when the ring is full.
+
+Last, one producer is stopped (SIGSTOP) over and over until it is caught
+between claiming a cell and publishing it, as a hooked process that dies
+there would be.  The consumer skips the stalled cell, the producer is let
+go, and its late publish must be refused: the ring must go on delivering
+its records in order instead of getting stuck on that cell.
+
+RingBufferBench measures the throughput.
+
+Usage: RingBufferCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "SharedRingBuffer.h"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sched.h>
+#include <vector>
+
+struct CheckRecord
+{
+    ring_uint32_t producer,
+                  sequence;
+};
+
+typedef TUIO::SharedRingBuffer<CheckRecord, 16> SmallRing;
+typedef TUIO::SharedRingBuffer<CheckRecord, 4096> ProcessRing;
+
+static const unsigned int BATCH_SIZE = 64,
+                          PRODUCERS = 4,
+                          RECORDS = 200000;
+
+// A long record, so that a stop often lands between claim and publish.
+struct StallRecord
+{
+    ring_uint32_t sequence;
+    char payload[252];
+};
+
+typedef TUIO::SharedRingBuffer<StallRecord, 4096> StallRing;
+
+static const unsigned int STALL_ATTEMPTS = 20000,
+                          STALL_RECORDS_AFTER = 100000;
+
+static CheckRecord record( ring_uint32_t sequence )
+{
+    CheckRecord r;
+    r.producer = 0;
+    r.sequence = sequence;
+    return r;
+}
+
+static void checkOneProcess()
+{
+    SmallRing * ring = new SmallRing();
+    CheckRecord popped,
+                batch[SmallRing::CAPACITY];
+
+    expect( "one process: initialize", ring->initialize() && ring->isInitialized() );
+    expect( "one process: empty pop", !ring->tryPop( popped ) && ring->tryPopBatch( batch, 4 ) == 0 );
+    expect( "one process: not stalled when empty", !ring->isStalled() );
+
+    for( ring_uint32_t i = 0; i < SmallRing::CAPACITY; ++i ) {
+        expect( "one process: push", ring->tryPush( record( i ) ) );
+    }
+    expect( "one process: full", !ring->tryPush( record( 99 ) ) && ring->droppedCount() == 1 );
+    expect( "one process: size", ring->size() == SmallRing::CAPACITY
+                                 && ring->pushedCount() == SmallRing::CAPACITY );
+    expect( "one process: pop", ring->tryPop( popped ) && popped.sequence == 0 );
+    expect( "one process: batch", ring->tryPopBatch( batch, 4 ) == 4 && batch[0].sequence == 1
+                                  && batch[3].sequence == 4 );
+    expect( "one process: rest", ring->tryPopBatch( batch, SmallRing::CAPACITY ) == SmallRing::CAPACITY - 5
+                                 && batch[0].sequence == 5 && ring->size() == 0 );
+
+    // Pushes and pops a few at a time, so the positions wrap many times.
+    ring_uint32_t next = SmallRing::CAPACITY,
+                  expected = next;
+    bool inOrder = true;
+
+    for( int round = 0; round < 100; ++round ) {
+        for( int i = 0; i < 1 + round % 11 && ring->tryPush( record( next ) ); ++i ) {
+            ++next;
+        }
+        unsigned int count = ring->tryPopBatch( batch, 1 + round % 5 );
+
+        for( unsigned int i = 0; i < count; ++i ) {
+            inOrder = inOrder && batch[i].sequence == expected++;
+        }
+    }
+    while( ring->tryPop( popped ) ) {
+        inOrder = inOrder && popped.sequence == expected++;
+    }
+    expect( "one process: wrap", inOrder && expected == next && ring->size() == 0 );
+
+    ring->armWakeup();
+    expect( "one process: one wakeup", ring->claimWakeup() && !ring->claimWakeup() );
+    expect( "one process: no wakeup unarmed", !ring->claimWakeup() );
+
+    ring->tryPush( record( next ) );
+    expect( "one process: no skip of a published cell", !ring->skipStalledCell( ring->headPosition() )
+                                                        && ring->tryPop( popped ) && popped.sequence == next );
+    expect( "one process: no skip of an empty cell", !ring->skipStalledCell( ring->headPosition() ) );
+    delete ring;
+}
+
+static void produce( ProcessRing * ring, unsigned int producer, unsigned int records )
+{
+    CheckRecord r;
+    r.producer = producer;
+
+    for( unsigned int i = 0; i < records; ++i ) {
+        r.sequence = i;
+
+        while( !ring->tryPush( r ) ) {
+            sched_yield();
+        }
+    }
+}
+
+static void checkProducers()
+{
+    void * memory = mmap( NULL, sizeof( ProcessRing ), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if( memory == MAP_FAILED ) {
+        perror( "mmap" );
+        ++errors;
+        return;
+    }
+    ProcessRing * ring = (ProcessRing *)memory;
+
+    if( !ring->initialize() ) {
+        expect( "producers: ring atomics are lock-free", false );
+        munmap( memory, sizeof( ProcessRing ) );
+        return;
+    }
+    std::vector<pid_t> children;
+
+    for( unsigned int p = 0; p < PRODUCERS; ++p ) {
+        pid_t pid = fork();
+
+        if( pid == 0 ) {
+            produce( ring, p, RECORDS );
+            _exit( 0 );
+        }
+        children.push_back( pid );
+    }
+    std::vector<unsigned int> expected( PRODUCERS, 0 );
+    unsigned long long total = (unsigned long long)PRODUCERS * RECORDS,
+                       received = 0;
+    unsigned int outOfOrder = 0;
+    CheckRecord batch[BATCH_SIZE];
+
+    while( received < total ) {
+        unsigned int count = ring->tryPopBatch( batch, BATCH_SIZE );
+
+        if( count == 0 ) {
+            sched_yield();
+            continue;
+        }
+        for( unsigned int i = 0; i < count; ++i ) {
+            const CheckRecord & r = batch[i];
+
+            if( r.producer >= PRODUCERS || r.sequence != expected[r.producer] ) {
+                if( outOfOrder++ < 10 ) {
+                    fprintf( stderr, "producers: out of order: producer %u sequence %u\n", r.producer, r.sequence );
+                }
+                if( r.producer >= PRODUCERS ) {
+                    continue;
+                }
+            }
+            expected[r.producer] = r.sequence + 1;
+        }
+        received += count;
+    }
+    bool exited = true;
+
+    for( size_t i = 0; i < children.size(); ++i ) {
+        int status = 0;
+        waitpid( children[i], &status, 0 );
+        exited = exited && WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+    }
+    expect( "producers: in order", outOfOrder == 0 );
+    expect( "producers: exited", exited );
+    expect( "producers: all popped", ring->size() == 0 && ring->pushedCount() == total );
+    munmap( memory, sizeof( ProcessRing ) );
+}
+
+static void produceForever( StallRing * ring )
+{
+    StallRecord r = StallRecord();
+
+    for( ;; ) {
+        // a record refused for a skipped cell is pushed again
+        if( ring->tryPush( r ) ) {
+            ++r.sequence;
+        }
+        else {
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * Pops what is there, checking the sequence numbers only go up.
+ */
+static unsigned int drainStallRing( StallRing * ring, long long & last, unsigned int & outOfOrder )
+{
+    StallRecord batch[BATCH_SIZE];
+    unsigned int total = 0,
+                 count;
+
+    while( (count = ring->tryPopBatch( batch, BATCH_SIZE )) > 0 ) {
+        for( unsigned int i = 0; i < count; ++i ) {
+            if( (long long)batch[i].sequence <= last && outOfOrder++ < 10 ) {
+                fprintf( stderr, "stall: sequence %u after %lld\n", batch[i].sequence, last );
+            }
+            last = batch[i].sequence;
+        }
+        total += count;
+    }
+    return total;
+}
+
+static void checkStalledProducer()
+{
+    void * memory = mmap( NULL, sizeof( StallRing ), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if( memory == MAP_FAILED ) {
+        perror( "mmap" );
+        ++errors;
+        return;
+    }
+    StallRing * ring = (StallRing *)memory;
+    ring->initialize();
+    pid_t pid = fork();
+
+    if( pid == 0 ) {
+        produceForever( ring );
+    }
+    unsigned int outOfOrder = 0,
+                 attempt = 0;
+    long long last = -1;
+    bool caught = false;
+    int status = 0;
+
+    for( ; attempt < STALL_ATTEMPTS && !caught; ++attempt ) {
+        usleep( 20 + attempt % 80 );
+        kill( pid, SIGSTOP );
+        waitpid( pid, &status, WUNTRACED );
+        drainStallRing( ring, last, outOfOrder );
+        caught = ring->isStalled();
+
+        if( !caught ) {
+            kill( pid, SIGCONT );
+        }
+    }
+    if( caught ) {
+        ring_uint32_t pos = ring->headPosition();
+        unsigned int dropped = ring->droppedCount();
+
+        expect( "stall: no skip of another position", !ring->skipStalledCell( pos + 1 ) );
+        expect( "stall: skipped", ring->skipStalledCell( pos ) && ring->droppedCount() == dropped + 1 );
+        kill( pid, SIGCONT );
+
+        unsigned int received = 0;
+        double deadline = seconds() + 5.0;
+
+        while( received < STALL_RECORDS_AFTER && seconds() < deadline ) {
+            received += drainStallRing( ring, last, outOfOrder );
+        }
+        expect( "stall: records after the skip", received >= STALL_RECORDS_AFTER );
+        expect( "stall: late publish refused", ring->droppedCount() >= dropped + 2 );
+        printf( "stalled producer caught after %u stops\n", attempt );
+    }
+    else {
+        printf( "stalled producer not caught in %u stops; skip not checked\n", attempt );
+    }
+    expect( "stall: in order", outOfOrder == 0 );
+    kill( pid, SIGKILL );
+    waitpid( pid, &status, 0 );
+    munmap( memory, sizeof( StallRing ) );
+}
+
+int main( int argc, char * argv[] )
+{
+    checkOneProcess();
+    checkProducers();
+    checkStalledProducer();
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
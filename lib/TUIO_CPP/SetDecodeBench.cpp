@@ -0,0 +1,245 @@
+/*******************************************************************************
+SetDecodeBench
+
+PURPOSE: Measures decoding the /tuio/2Dobj, /tuio/2Dcur and /tuio/2Dblb set
+         messages with osc::FixedMessage and with ReceivedMessage, per
+         message and in TuioClient per frame.
+
+NOTES:
+Each kind of set message is decoded DECODES times both ways, then FRAMES
+frames of 100 and 1000 moving cursors are run through a client fed through
+the LoopbackReceiver of BenchSupport.h (OscReceiver, which decodes the set
+messages itself) and one fed through the old path (a ReceivedMessage for
+every bundle element, handed to processOSC).
+
+SetDecodeCheck checks that both decode alike.
+
+Usage: SetDecodeBench
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TuioClient.h"
+#include "TuioListener.h"
+#include "osc/OscFixedMessage.h"
+#include "osc/OscOutboundPacketStream.h"
+#include <chrono>
+#include <list>
+#include <vector>
+
+using namespace TUIO;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int DECODES = 2000000,
+                 FRAMES = 2000,
+                 BUFFER_SIZE = 128 * 1024;
+
+/**
+ * Hands every message to its clients as a ReceivedMessage, the way
+ * OscReceiver did before the set messages were decoded apart.
+ */
+class GenericReceiver : public OscReceiver
+{
+public:
+    void connect( bool lock = false ) { connected = true; }
+    void disconnect() { connected = false; }
+
+    void send( const osc::OutboundPacketStream & packet )
+    {
+        osc::ReceivedBundle bundle( osc::ReceivedPacket( packet.Data(), (osc::int32)packet.Size() ) );
+
+        for( osc::ReceivedBundle::const_iterator i = bundle.ElementsBegin(); i != bundle.ElementsEnd(); ++i ) {
+            osc::ReceivedMessage message( *i );
+
+            for( std::list<TuioClient *>::iterator client = clientList.begin(); client != clientList.end(); ++client ) {
+                (*client)->processOSC( message );
+            }
+        }
+    }
+};
+
+class NullListener : public TuioListener
+{
+public:
+    NullListener() : refreshes( 0 ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioCursor( TuioCursor * ) {}
+    void updateTuioCursor( TuioCursor * ) {}
+    void removeTuioCursor( TuioCursor * ) {}
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+    void refresh( TuioTime ) { ++refreshes; }
+
+    unsigned long refreshes;
+};
+
+/**
+ * A float of frame f and field i that changes every frame and covers signs,
+ * fractions and large values.  It is never 0: TuioClient works a speed of 0
+ * out from the session time, which differs between two clients.
+ */
+static float field( int f, int i )
+{
+    return ((f * 131 + i * 17) % 2001 - 1000 + 0.5f) / (i % 3 == 0 ? 1000.0f : 7.0f);
+}
+
+static const char * const ADDRESSES[] = { "/tuio/2Dobj", "/tuio/2Dcur", "/tuio/2Dblb" };
+static const int INT_COUNTS[] = { 2, 1, 1 },
+                 FLOAT_COUNTS[] = { 8, 5, 11 };
+
+static void encodeSet( osc::OutboundPacketStream & packet, int profile, int s_id, int f )
+{
+    packet << osc::BeginMessage( ADDRESSES[profile] ) << "set" << (osc::int32)s_id;
+
+    if( INT_COUNTS[profile] == 2 ) {
+        packet << (osc::int32)(s_id % 7 - 3);
+    }
+    for( int i = 0; i < FLOAT_COUNTS[profile]; ++i ) {
+        packet << field( f, i );
+    }
+    packet << osc::EndMessage;
+}
+
+template <int INT_COUNT, int FLOAT_COUNT>
+static bool decodeSum( const char * data, unsigned long size, const char * address, osc::int32 & id, float & sum )
+{
+    osc::FixedMessage<INT_COUNT, FLOAT_COUNT> set;
+
+    if( !set.Decode( data, size, address, "set" ) ) {
+        return false;
+    }
+    id = set.ints[0];
+
+    for( int i = 0; i < FLOAT_COUNT; ++i ) {
+        sum += set.floats[i];
+    }
+    return true;
+}
+
+/**
+ * Nanoseconds per set message decoded through ReceivedMessage, and through
+ * FixedMessage.
+ */
+static void timeDecode( int profile, double & genericNs, double & fixedNs )
+{
+    char buffer[1024];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    encodeSet( packet, profile, 42, 3 );
+    const char * data = packet.Data();
+    unsigned long size = packet.Size();
+    const int ints = INT_COUNTS[profile],
+              floats = FLOAT_COUNTS[profile];
+    volatile float sink = 0.0f;
+
+    Clock::time_point start = Clock::now();
+
+    for( int n = 0; n < DECODES; ++n ) {
+        osc::ReceivedMessage message( osc::ReceivedPacket( data, (osc::int32)size ) );
+        osc::ReceivedMessageArgumentStream args = message.ArgumentStream();
+        const char * command;
+        osc::int32 id = 0;
+        float value,
+              sum = 0.0f;
+        args >> command;
+
+        for( int i = 0; i < ints; ++i ) {
+            args >> id;
+        }
+        for( int i = 0; i < floats; ++i ) {
+            args >> value;
+            sum += value;
+        }
+        sink = sink + sum + (float)id;
+    }
+    genericNs = std::chrono::duration<double>( Clock::now() - start ).count() * 1e9 / DECODES;
+
+    start = Clock::now();
+
+    for( int n = 0; n < DECODES; ++n ) {
+        float sum = 0.0f;
+        osc::int32 id = 0;
+
+        switch( profile ) {
+            case 0:  decodeSum<2, 8>( data, size, ADDRESSES[0], id, sum ); break;
+            case 1:  decodeSum<1, 5>( data, size, ADDRESSES[1], id, sum ); break;
+            default: decodeSum<1, 11>( data, size, ADDRESSES[2], id, sum );
+        }
+        sink = sink + sum + (float)id;
+    }
+    fixedNs = std::chrono::duration<double>( Clock::now() - start ).count() * 1e9 / DECODES;
+}
+
+/**
+ * Microseconds per frame of moving cursors (only /tuio/2Dcur) in a client.
+ */
+template <class Receiver>
+static double timeFrames( int cursors )
+{
+    Receiver receiver;
+    TuioClient client( &receiver );
+    NullListener listener;
+    client.addTuioListener( &listener );
+    client.connect();
+    std::vector<char> buffer( BUFFER_SIZE );
+    osc::OutboundPacketStream packet( &buffer[0], BUFFER_SIZE );
+    std::vector<osc::OutboundPacketStream *> frames;
+    std::vector<std::vector<char> > frameBuffers( 2, std::vector<char>( BUFFER_SIZE ) );
+
+    // two frames, sent in turn, so that every cursor moves every frame
+    for( int f = 0; f < 2; ++f ) {
+        frames.push_back( new osc::OutboundPacketStream( &frameBuffers[f][0], BUFFER_SIZE ) );
+        osc::OutboundPacketStream & frame = *frames.back();
+        frame << osc::BeginBundleImmediate << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+        for( int s = 1; s <= cursors; ++s ) {
+            frame << (osc::int32)s;
+        }
+        frame << osc::EndMessage;
+
+        for( int s = 1; s <= cursors; ++s ) {
+            encodeSet( frame, 1, s, f + s );
+        }
+        frame << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)-1 << osc::EndMessage << osc::EndBundle;
+    }
+    receiver.send( *frames[0] );
+    Clock::time_point start = Clock::now();
+
+    for( int f = 1; f <= FRAMES; ++f ) {
+        receiver.send( *frames[f % 2] );
+    }
+    double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+    client.disconnect();
+
+    for( size_t i = 0; i < frames.size(); ++i ) {
+        delete frames[i];
+    }
+    return seconds * 1e6 / FRAMES;
+}
+
+int main( int argc, char * argv[] )
+{
+    printf( "nanoseconds per set message decoded:\n" );
+    printf( "%-12s %12s %12s %8s\n", "", "generic", "fixed", "speedup" );
+
+    for( int profile = 0; profile < 3; ++profile ) {
+        double genericNs, fixedNs;
+        timeDecode( profile, genericNs, fixedNs );
+        printf( "%-12s %12.1f %12.1f %7.1fx\n", ADDRESSES[profile], genericNs, fixedNs, genericNs / fixedNs );
+    }
+
+    printf( "%d frames of moving cursors through TuioClient, microseconds per frame:\n", FRAMES );
+    printf( "%8s %12s %12s %8s\n", "cursors", "generic", "fixed", "speedup" );
+    const int counts[] = { 100, 1000 };
+
+    for( int i = 0; i < 2; ++i ) {
+        double genericUs = timeFrames<GenericReceiver>( counts[i] ),
+               fixedUs = timeFrames<LoopbackReceiver>( counts[i] );
+        printf( "%8d %12.1f %12.1f %7.1fx\n", counts[i], genericUs, fixedUs, genericUs / fixedUs );
+    }
+    return 0;
+}
@@ -0,0 +1,337 @@
+/*******************************************************************************
+SetDecodeCheck
+
+PURPOSE: Checks that osc::FixedMessage decodes the /tuio/2Dobj, /tuio/2Dcur
+         and /tuio/2Dblb set messages exactly as ReceivedMessage does.
+
+NOTES:
+The checks:
+
+- every field of a set message of each profile decodes to the same bits as
+  through ReceivedMessageArgumentStream, negative IDs and odd floats
+  included;
+- messages of another shape are refused: cut short, an argument more, an
+  int where a float belongs, another command or address, and bytes after
+  the last argument;
+- two TuioClients, one fed through the LoopbackReceiver of BenchSupport.h
+  (OscReceiver, which now decodes the set messages itself) and one through the old path (a ReceivedMessage for
+  every bundle element, handed to processOSC), end up with the same
+  objects, cursors and blobs frame after frame;
+- a set message with an extra argument still reaches the client through
+  the old path.
+
+SetDecodeBench measures both paths.
+
+Usage: SetDecodeCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TuioClient.h"
+#include "TuioListener.h"
+#include "osc/OscFixedMessage.h"
+#include "osc/OscOutboundPacketStream.h"
+#include <cstring>
+#include <list>
+#include <vector>
+
+using namespace TUIO;
+
+static const int BUFFER_SIZE = 128 * 1024;
+
+/**
+ * Hands every message to its clients as a ReceivedMessage, the way
+ * OscReceiver did before the set messages were decoded apart.
+ */
+class GenericReceiver : public OscReceiver
+{
+public:
+    void connect( bool lock = false ) { connected = true; }
+    void disconnect() { connected = false; }
+
+    void send( const osc::OutboundPacketStream & packet )
+    {
+        osc::ReceivedBundle bundle( osc::ReceivedPacket( packet.Data(), (osc::int32)packet.Size() ) );
+
+        for( osc::ReceivedBundle::const_iterator i = bundle.ElementsBegin(); i != bundle.ElementsEnd(); ++i ) {
+            osc::ReceivedMessage message( *i );
+
+            for( std::list<TuioClient *>::iterator client = clientList.begin(); client != clientList.end(); ++client ) {
+                (*client)->processOSC( message );
+            }
+        }
+    }
+};
+
+class NullListener : public TuioListener
+{
+public:
+    NullListener() : refreshes( 0 ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioCursor( TuioCursor * ) {}
+    void updateTuioCursor( TuioCursor * ) {}
+    void removeTuioCursor( TuioCursor * ) {}
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+    void refresh( TuioTime ) { ++refreshes; }
+
+    unsigned long refreshes;
+};
+
+static bool sameBits( float a, float b )
+{
+    return memcmp( &a, &b, sizeof( float ) ) == 0;
+}
+
+/**
+ * A float of frame f and field i that changes every frame and covers signs,
+ * fractions and large values.  It is never 0: TuioClient works a speed of 0
+ * out from the session time, which differs between two clients.
+ */
+static float field( int f, int i )
+{
+    return ((f * 131 + i * 17) % 2001 - 1000 + 0.5f) / (i % 3 == 0 ? 1000.0f : 7.0f);
+}
+
+static const char * const ADDRESSES[] = { "/tuio/2Dobj", "/tuio/2Dcur", "/tuio/2Dblb" };
+static const int INT_COUNTS[] = { 2, 1, 1 },
+                 FLOAT_COUNTS[] = { 8, 5, 11 };
+
+static void encodeSet( osc::OutboundPacketStream & packet, int profile, int s_id, int f )
+{
+    packet << osc::BeginMessage( ADDRESSES[profile] ) << "set" << (osc::int32)s_id;
+
+    if( INT_COUNTS[profile] == 2 ) {
+        packet << (osc::int32)(s_id % 7 - 3);
+    }
+    for( int i = 0; i < FLOAT_COUNTS[profile]; ++i ) {
+        packet << field( f, i );
+    }
+    packet << osc::EndMessage;
+}
+
+/**
+ * Decodes the message both ways and compares every field.
+ */
+template <int INT_COUNT, int FLOAT_COUNT>
+static bool decodesAlike( const char * data, unsigned long size, const char * address )
+{
+    osc::FixedMessage<INT_COUNT, FLOAT_COUNT> fixed;
+
+    if( !fixed.Decode( data, size, address, "set" ) ) {
+        return false;
+    }
+    osc::ReceivedMessage message( osc::ReceivedPacket( data, (osc::int32)size ) );
+    osc::ReceivedMessageArgumentStream args = message.ArgumentStream();
+    const char * command;
+    args >> command;
+    bool alike = strcmp( command, "set" ) == 0;
+
+    for( int i = 0; i < INT_COUNT; ++i ) {
+        osc::int32 value;
+        args >> value;
+        alike = alike && value == fixed.ints[i];
+    }
+    for( int i = 0; i < FLOAT_COUNT; ++i ) {
+        float value;
+        args >> value;
+        alike = alike && sameBits( value, fixed.floats[i] );
+    }
+    return alike && args.Eos();
+}
+
+static bool decodesAlike( int profile, const char * data, unsigned long size )
+{
+    switch( profile ) {
+        case 0:  return decodesAlike<2, 8>( data, size, ADDRESSES[0] );
+        case 1:  return decodesAlike<1, 5>( data, size, ADDRESSES[1] );
+        default: return decodesAlike<1, 11>( data, size, ADDRESSES[2] );
+    }
+}
+
+static bool cursorShape( const osc::OutboundPacketStream & packet )
+{
+    osc::FixedMessage<1, 5> set;
+    return set.Decode( packet.Data(), packet.Size(), "/tuio/2Dcur", "set" );
+}
+
+static void runDecodeChecks()
+{
+    char buffer[1024];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    const int ids[] = { 0, 1, 7, -5, 0x7fffffff };
+
+    for( int profile = 0; profile < 3; ++profile ) {
+        bool alike = true;
+
+        for( int f = 0; f < 50; ++f ) {
+            packet.Clear();
+            encodeSet( packet, profile, ids[f % 5], f );
+            alike = alike && decodesAlike( profile, packet.Data(), packet.Size() );
+        }
+        expect( ADDRESSES[profile], alike );
+
+        packet.Clear();
+        encodeSet( packet, profile, 1, 0 );
+        expect( "cut short: refused", !decodesAlike( profile, packet.Data(), packet.Size() - 4 ) );
+    }
+    expect( "size of the shape", osc::FixedMessage<1, 5>::Size( "/tuio/2Dcur", "set" ) == 12 + 12 + 4 + 24 );
+
+    packet.Clear();
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)1 << 0.1f << 0.2f << 0.0f << 0.0f << 0.0f
+           << osc::EndMessage;
+    expect( "cursor: accepted", cursorShape( packet ) );
+
+    packet.Clear();
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)1 << 0.1f << 0.2f << 0.0f << 0.0f << 0.0f
+           << 0.0f << osc::EndMessage;
+    expect( "extra argument: refused", !cursorShape( packet ) );
+
+    packet.Clear();
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)1 << 0.1f << (osc::int32)2 << 0.0f << 0.0f
+           << 0.0f << osc::EndMessage;
+    expect( "int for a float: refused", !cursorShape( packet ) );
+
+    packet.Clear();
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "sets" << (osc::int32)1 << 0.1f << 0.2f << 0.0f << 0.0f << 0.0f
+           << osc::EndMessage;
+    expect( "other command: refused", !cursorShape( packet ) );
+
+    packet.Clear();
+    packet << osc::BeginMessage( "/tuio/2Dcux" ) << "set" << (osc::int32)1 << 0.1f << 0.2f << 0.0f << 0.0f << 0.0f
+           << osc::EndMessage;
+    expect( "other address: refused", !cursorShape( packet ) );
+
+    packet.Clear();
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)1 << 0.1f << 0.2f << 0.0f << 0.0f << 0.0f
+           << osc::EndMessage;
+    char padded[256];
+    memcpy( padded, packet.Data(), packet.Size() );
+    memset( padded + packet.Size(), 0, 4 );
+    osc::FixedMessage<1, 5> set;
+    expect( "trailing bytes: refused", !set.Decode( padded, packet.Size() + 4, "/tuio/2Dcur", "set" ) );
+}
+
+/**
+ * Encodes a bundle the way TuioServer sends it for each of the three
+ * profiles: alive, a set per entity, fseq.
+ */
+static const osc::OutboundPacketStream & encodeFrame( osc::OutboundPacketStream & packet, int entities, int f,
+                                                      bool extraArgument = false )
+{
+    packet.Clear();
+    packet << osc::BeginBundleImmediate;
+
+    for( int profile = 0; profile < 3; ++profile ) {
+        packet << osc::BeginMessage( ADDRESSES[profile] ) << "alive";
+
+        for( int s = 1; s <= entities; ++s ) {
+            packet << (osc::int32)s;
+        }
+        packet << osc::EndMessage;
+
+        for( int s = 1; s <= entities; ++s ) {
+            if( extraArgument && profile == 1 && s == 1 ) {
+                packet << osc::BeginMessage( ADDRESSES[1] ) << "set" << (osc::int32)s;
+
+                for( int i = 0; i < 6; ++i ) {
+                    packet << 0.25f;
+                }
+                packet << osc::EndMessage;
+            }
+            else {
+                encodeSet( packet, profile, s, f + s );
+            }
+        }
+        packet << osc::BeginMessage( ADDRESSES[profile] ) << "fseq" << (osc::int32)(f + 1) << osc::EndMessage;
+    }
+    packet << osc::EndBundle;
+    return packet;
+}
+
+static bool sameContainer( TuioContainer * a, TuioContainer * b )
+{
+    return a->getSessionID() == b->getSessionID() && sameBits( a->getX(), b->getX() ) && sameBits( a->getY(), b->getY() )
+           && sameBits( a->getXSpeed(), b->getXSpeed() ) && sameBits( a->getYSpeed(), b->getYSpeed() )
+           && sameBits( a->getMotionAccel(), b->getMotionAccel() );
+}
+
+static bool sameState( TuioClient & a, TuioClient & b )
+{
+    std::list<TuioObject *> objectsA = a.getTuioObjects(), objectsB = b.getTuioObjects();
+    std::list<TuioCursor *> cursorsA = a.getTuioCursors(), cursorsB = b.getTuioCursors();
+    std::list<TuioBlob *> blobsA = a.getTuioBlobs(), blobsB = b.getTuioBlobs();
+
+    if( objectsA.size() != objectsB.size() || cursorsA.size() != cursorsB.size() || blobsA.size() != blobsB.size() ) {
+        return false;
+    }
+    for( std::list<TuioObject *>::iterator i = objectsA.begin(), j = objectsB.begin(); i != objectsA.end(); ++i, ++j ) {
+        if( !sameContainer( *i, *j ) || (*i)->getSymbolID() != (*j)->getSymbolID()
+            || !sameBits( (*i)->getAngle(), (*j)->getAngle() )
+            || !sameBits( (*i)->getRotationSpeed(), (*j)->getRotationSpeed() )
+            || !sameBits( (*i)->getRotationAccel(), (*j)->getRotationAccel() ) ) {
+            return false;
+        }
+    }
+    for( std::list<TuioCursor *>::iterator i = cursorsA.begin(), j = cursorsB.begin(); i != cursorsA.end(); ++i, ++j ) {
+        if( !sameContainer( *i, *j ) || (*i)->getCursorID() != (*j)->getCursorID() ) {
+            return false;
+        }
+    }
+    for( std::list<TuioBlob *>::iterator i = blobsA.begin(), j = blobsB.begin(); i != blobsA.end(); ++i, ++j ) {
+        if( !sameContainer( *i, *j ) || (*i)->getBlobID() != (*j)->getBlobID()
+            || !sameBits( (*i)->getAngle(), (*j)->getAngle() ) || !sameBits( (*i)->getWidth(), (*j)->getWidth() )
+            || !sameBits( (*i)->getHeight(), (*j)->getHeight() ) || !sameBits( (*i)->getArea(), (*j)->getArea() ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void runClientChecks()
+{
+    LoopbackReceiver fastReceiver;
+    GenericReceiver genericReceiver;
+    TuioClient fast( &fastReceiver ),
+               generic( &genericReceiver );
+    NullListener fastListener, genericListener;
+    fast.addTuioListener( &fastListener );
+    generic.addTuioListener( &genericListener );
+    fast.connect();
+    generic.connect();
+    std::vector<char> buffer( BUFFER_SIZE );
+    osc::OutboundPacketStream packet( &buffer[0], BUFFER_SIZE );
+    bool alike = true;
+
+    for( int f = 0; f < 20; ++f ) {
+        fastReceiver.send( encodeFrame( packet, 10, f ) );
+        genericReceiver.send( packet );
+        alike = alike && sameState( fast, generic );
+    }
+    expect( "clients: same state", alike && fast.getTuioCursors().size() == 10 && fast.getTuioObjects().size() == 10
+                                   && fast.getTuioBlobs().size() == 10 );
+    expect( "clients: every frame", fastListener.refreshes == genericListener.refreshes
+                                    && fastListener.refreshes == 20 * 3 );
+
+    fastReceiver.send( encodeFrame( packet, 10, 20, true ) );
+    TuioCursor * tcur = fast.getTuioCursor( 1 );
+    expect( "extra argument: old path", tcur != NULL && tcur->getX() == 0.25f && tcur->getXSpeed() == 0.25f );
+
+    fast.disconnect();
+    generic.disconnect();
+}
+
+int main( int argc, char * argv[] )
+{
+    runDecodeChecks();
+    runClientChecks();
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
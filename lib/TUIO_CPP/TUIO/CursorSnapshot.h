@@ -0,0 +1,295 @@
+/*******************************************************************************
+CursorSnapshot
+
+PURPOSE: The cursor table of the latest frame, laid out for named shared
+         memory and guarded by a seqlock, so that programs on the same host
+         can read the cursors without going through the network, OSC
+         decoding or TuioClient.
+
+NOTES:
+One writer (CursorSnapshotWriter, in the TuioCursorServer's sending thread)
+and any number of readers (CursorSnapshotReader, in other processes).  The
+writer makes the sequence number odd, rewrites the frame and its slots and
+makes it even again.  A reader copies the frame out between two loads of the
+sequence and keeps the copy only if both loads saw the same even number,
+so readers never block the writer and never take a lock; a reader that
+raced the writer just copies again.  Nothing is queued: a reader that reads
+less often than frames are published sees the latest frame, not every one.
+
+Each slot is one cursor: session and cursor ID, position, velocity, motion
+speed and acceleration, TUIO state and the frame in which it last changed.
+Cursors that are not in the frame have been removed.
+
+Reading costs no system call.  A reader that has nothing else to do can
+wait: it counts itself in waiters_ and sleeps (on the sequence number, a
+futex, on Linux; on a named auto-reset event on Windows), and the writer
+only makes the wake-up call when waiters_ is not zero.  A waiting reader
+wakes at least every WAIT_SLICE milliseconds and checks in (waiterSeen_),
+so that a reader killed while it was counted does not leave the writer
+making a wake-up call for every frame from then on: once no reader has
+checked in for WAITER_TIMEOUT milliseconds, the writer takes waiters_ back
+to zero.
+
+Like SharedRingBuffer, the class has no constructor and only fixed-width
+fields, so 32-bit and 64-bit processes agree on its layout, and it must be
+initialized once by the writer (see initialize()).
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_CURSORSNAPSHOT_H
+#define INCLUDED_CURSORSNAPSHOT_H
+
+#include <atomic>
+#include <cstring>
+
+#ifdef _MSC_VER
+typedef unsigned __int32 snapshot_uint32_t;
+typedef __int32 snapshot_int32_t;
+typedef __int64 snapshot_int64_t;
+#else
+#include <stdint.h>
+typedef uint32_t snapshot_uint32_t;
+typedef int32_t snapshot_int32_t;
+typedef int64_t snapshot_int64_t;
+#endif
+
+#define CURSOR_SNAPSHOT_MAGIC 0x54484353  // "THCS"
+#define CURSOR_SNAPSHOT_CACHE_LINE 64
+#define CURSOR_SNAPSHOT_DEFAULT_NAME "TouchHooks2TuioCursors"
+#define CURSOR_SNAPSHOT_EVENT_SUFFIX "Frame"  // Windows: the wake-up event is named after the mapping
+
+namespace TUIO
+{
+    /**
+     * One cursor of a snapshot.
+     */
+    struct CursorSnapshotSlot
+    {
+        snapshot_uint32_t sessionId;
+        snapshot_int32_t cursorId;
+        snapshot_uint32_t state;        // TUIO_ADDED, TUIO_ACCELERATING, ... (TuioContainer.h)
+        snapshot_uint32_t frame;        // the frame in which it last changed
+        float x,                        // 0 to 1 across the screen
+              y;
+        float xSpeed,                   // screen widths (heights) per second
+              ySpeed;
+        float motionSpeed,
+              motionAccel;
+    };
+
+    /**
+     * A reader's copy of one frame.
+     */
+    struct CursorSnapshotFrame
+    {
+        enum { CAPACITY = 256 };
+
+        snapshot_uint32_t sequence;     // even; changes with every frame published
+        snapshot_uint32_t frame;        // the TUIO frame ID
+        snapshot_int64_t frameTime;     // the frame's TuioTime, microseconds since the session start
+        snapshot_int64_t publishTime;   // steady clock nanoseconds when it was published
+        snapshot_uint32_t count;
+        CursorSnapshotSlot cursors[CAPACITY];
+    };
+
+    /**
+     * <p><code>
+     * void * memory = ...map sizeof(CursorSnapshot) bytes...;<br/>
+     * CursorSnapshot * snapshot = (CursorSnapshot *)memory;<br/>
+     * snapshot->initialize(); // the writer only<br/>
+     * ...<br/>
+     * CursorSnapshotSlot * slots = snapshot->beginWrite(); // the writer<br/>
+     * ...fill in slots...<br/>
+     * snapshot->endWrite( frame, frameTime, publishTime, count );<br/>
+     * ...<br/>
+     * CursorSnapshotFrame copy;<br/>
+     * while( !snapshot->tryRead( copy ) ) {} // any reader<br/>
+     * </code></p>
+     */
+    class CursorSnapshot
+    {
+    public:
+        enum { CAPACITY = CursorSnapshotFrame::CAPACITY,
+               WAIT_SLICE = 100,            // milliseconds
+               WAITER_TIMEOUT = 1000 };
+
+        /**
+         * Empties the snapshot.  Called by the writer when it creates the
+         * memory block.  The sequence number goes on from where it was, so a
+         * reader still attached from an earlier writer does not mistake the
+         * new frames for ones it has seen.  Returns false if the atomics
+         * used here would not be lock-free, in which case the snapshot cannot
+         * be shared between processes.
+         */
+        bool initialize()
+        {
+            if( !sequence_.is_lock_free() || !waiterSeen_.is_lock_free() ) {
+                return false;
+            }
+            magic_.store( 0, std::memory_order_relaxed );
+            capacity_ = CAPACITY;
+            slotSize_ = sizeof( CursorSnapshotSlot );
+            sequence_.store( (sequence_.load( std::memory_order_relaxed ) + 2) & ~1u, std::memory_order_relaxed );
+            frame_ = 0;
+            frameTime_ = 0;
+            publishTime_ = 0;
+            count_ = 0;
+            writerOpen_.store( 1, std::memory_order_relaxed );
+            magic_.store( CURSOR_SNAPSHOT_MAGIC, std::memory_order_release );
+            return true;
+        }
+
+        /**
+         * Returns true if the snapshot was initialized with the layout this
+         * process was compiled with.
+         */
+        bool isInitialized() const
+        {
+            return magic_.load( std::memory_order_acquire ) == CURSOR_SNAPSHOT_MAGIC
+                && capacity_ == CAPACITY
+                && slotSize_ == sizeof( CursorSnapshotSlot );
+        }
+
+        /**
+         * Writer side.  Makes the sequence number odd and returns the slots
+         * to fill in.  Readers retry until endWrite().
+         */
+        CursorSnapshotSlot * beginWrite()
+        {
+            sequence_.store( sequence_.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+            // the odd number must be seen before any of the new slots
+            std::atomic_thread_fence( std::memory_order_release );
+            return slots_;
+        }
+
+        /**
+         * Writer side.  Publishes the frame.
+         *
+         * @param   publishTime  steady clock nanoseconds, the clock the
+         *                       readers check in by.
+         * @return  true if a reader is waiting and has to be woken up.
+         */
+        bool endWrite( snapshot_uint32_t frame, snapshot_int64_t frameTime, snapshot_int64_t publishTime,
+                       snapshot_uint32_t count )
+        {
+            frame_ = frame;
+            frameTime_ = frameTime;
+            publishTime_ = publishTime;
+            count_ = count;
+            // seq_cst pairs with addWaiter(): either the reader sees the new
+            // number before it sleeps, or the writer sees the reader waiting
+            sequence_.store( sequence_.load( std::memory_order_relaxed ) + 1, std::memory_order_seq_cst );
+            snapshot_uint32_t waiters = waiters_.load( std::memory_order_seq_cst );
+
+            // the readers counted died waiting; one that counts itself in
+            // meanwhile makes the exchange fail
+            if( waiters != 0
+             && publishTime - waiterSeen_.load( std::memory_order_seq_cst ) > (snapshot_int64_t)WAITER_TIMEOUT * 1000000
+             && waiters_.compare_exchange_strong( waiters, 0, std::memory_order_seq_cst ) ) {
+                return false;
+            }
+            return waiters != 0;
+        }
+
+        /**
+         * Writer side.  Tells the readers no more frames will come.
+         */
+        void close()
+        {
+            writerOpen_.store( 0, std::memory_order_release );
+        }
+
+        /**
+         * Reader side.  Copies the frame; false if the writer was writing
+         * it meanwhile, in which case the copy is not to be used.
+         */
+        bool tryRead( CursorSnapshotFrame & copy ) const
+        {
+            snapshot_uint32_t before = sequence_.load( std::memory_order_acquire );
+
+            if( before & 1 ) {
+                return false;
+            }
+            copy.sequence = before;
+            copy.frame = frame_;
+            copy.frameTime = frameTime_;
+            copy.publishTime = publishTime_;
+            copy.count = count_ <= CAPACITY ? count_ : CAPACITY;
+            std::memcpy( copy.cursors, slots_, copy.count * sizeof( CursorSnapshotSlot ) );
+            // the copy must be done before the sequence number is checked again
+            std::atomic_thread_fence( std::memory_order_acquire );
+            return sequence_.load( std::memory_order_relaxed ) == before;
+        }
+
+        /**
+         * The sequence number: odd while a frame is being written, and
+         * changed by every frame.
+         */
+        snapshot_uint32_t sequence() const
+        {
+            return sequence_.load( std::memory_order_acquire );
+        }
+
+        bool isWriterOpen() const
+        {
+            return writerOpen_.load( std::memory_order_acquire ) != 0;
+        }
+
+        /**
+         * Reader side.  Counts a reader in or out of waiting on the sequence
+         * number.  A reader must check the sequence number again after
+         * counting itself in, since a frame may have been published just
+         * before, and must checkIn() at least every WAIT_SLICE
+         * milliseconds while it waits.
+         *
+         * @param   now  steady clock nanoseconds.
+         */
+        void addWaiter( snapshot_int64_t now )
+        {
+            // checked in first: the writer that sees the count sees the time
+            waiterSeen_.store( now, std::memory_order_seq_cst );
+            waiters_.fetch_add( 1, std::memory_order_seq_cst );
+        }
+
+        void checkIn( snapshot_int64_t now ) { waiterSeen_.store( now, std::memory_order_seq_cst ); }
+
+        /**
+         * @return  the number of readers still waiting.  The count never
+         *          goes below zero, in case the writer took it back to zero
+         *          while this reader was held up for WAITER_TIMEOUT.
+         */
+        snapshot_uint32_t removeWaiter()
+        {
+            snapshot_uint32_t waiters = waiters_.load( std::memory_order_relaxed );
+
+            while( waiters != 0 && !waiters_.compare_exchange_weak( waiters, waiters - 1, std::memory_order_relaxed ) ) {
+            }
+            return waiters != 0 ? waiters - 1 : 0;
+        }
+
+        /**
+         * The 32-bit word readers sleep on and the writer wakes them by.
+         */
+        void * sequenceAddress() { return &sequence_; }
+
+    private:
+        std::atomic<snapshot_uint32_t> magic_;
+        snapshot_uint32_t capacity_;
+        snapshot_uint32_t slotSize_;
+        std::atomic<snapshot_uint32_t> writerOpen_;
+        char pad0_[CURSOR_SNAPSHOT_CACHE_LINE - 4 * sizeof( snapshot_uint32_t )];
+
+        std::atomic<snapshot_uint32_t> sequence_;
+        std::atomic<snapshot_uint32_t> waiters_;
+        snapshot_uint32_t frame_;
+        snapshot_uint32_t count_;
+        snapshot_int64_t frameTime_;
+        snapshot_int64_t publishTime_;
+        std::atomic<snapshot_int64_t> waiterSeen_;
+        char pad1_[CURSOR_SNAPSHOT_CACHE_LINE - 4 * sizeof( snapshot_uint32_t ) - 3 * sizeof( snapshot_int64_t )];
+
+        CursorSnapshotSlot slots_[CAPACITY];
+    };
+}
+
+#endif /* INCLUDED_CURSORSNAPSHOT_H */
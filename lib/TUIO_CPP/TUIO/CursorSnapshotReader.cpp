@@ -0,0 +1,244 @@
+/*******************************************************************************
+CursorSnapshotReader
+
+PURPOSE: Opens a CursorSnapshot published by a CursorSnapshotWriter in
+         another process and reads its frames.  See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "CursorSnapshotReader.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+#include <chrono>
+#include <thread>
+
+using namespace TUIO;
+
+static snapshot_int64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+CursorSnapshotReader::CursorSnapshotReader() :
+  snapshot_( NULL ),
+#ifdef WIN32
+  mapping_( NULL ),
+  frameEvent_( NULL ),
+#endif
+  lastSequence_( 0 ),
+  framesRead_( 0 ),
+  retries_( 0 )
+{
+}
+
+CursorSnapshotReader::~CursorSnapshotReader()
+{
+    close();
+}
+
+bool CursorSnapshotReader::open( const char * name /*= CURSOR_SNAPSHOT_DEFAULT_NAME*/ )
+{
+    close();
+
+    void * memory = NULL;
+#ifdef WIN32
+    std::string mappingName = std::string( "Local\\" ) + name;
+    HANDLE mapping = OpenFileMappingA( FILE_MAP_ALL_ACCESS, FALSE, mappingName.c_str() );
+
+    if( mapping != NULL ) {
+        memory = MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof( CursorSnapshot ) );
+
+        if( memory == NULL ) {
+            CloseHandle( mapping );
+        }
+        else {
+            mapping_ = mapping;
+            // without it, waitForFrame() polls
+            frameEvent_ = OpenEventA( SYNCHRONIZE | EVENT_MODIFY_STATE, FALSE,
+                                      (mappingName + CURSOR_SNAPSHOT_EVENT_SUFFIX).c_str() );
+        }
+    }
+#else
+    // read-write: a waiting reader counts itself in the snapshot
+    std::string objectName = std::string( "/" ) + name;
+    int fd = shm_open( objectName.c_str(), O_RDWR, 0 );
+
+    if( fd >= 0 ) {
+        struct stat status;
+
+        if( fstat( fd, &status ) == 0 && status.st_size >= (off_t)sizeof( CursorSnapshot ) ) {
+            memory = mmap( NULL, sizeof( CursorSnapshot ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+            if( memory == MAP_FAILED ) {
+                memory = NULL;
+            }
+        }
+        ::close( fd );
+    }
+#endif
+    if( memory == NULL ) {
+        return false;
+    }
+    snapshot_ = (CursorSnapshot *)memory;
+
+    if( !snapshot_->isInitialized() ) {
+        close();
+        return false;
+    }
+    // the frame already there counts as new
+    lastSequence_ = snapshot_->sequence() - 2;
+    return true;
+}
+
+void CursorSnapshotReader::close()
+{
+    if( snapshot_ == NULL ) {
+        return;
+    }
+#ifdef WIN32
+    UnmapViewOfFile( (void *)snapshot_ );
+    CloseHandle( (HANDLE)mapping_ );
+    mapping_ = NULL;
+
+    if( frameEvent_ != NULL ) {
+        CloseHandle( (HANDLE)frameEvent_ );
+        frameEvent_ = NULL;
+    }
+#else
+    munmap( (void *)snapshot_, sizeof( CursorSnapshot ) );
+#endif
+    snapshot_ = NULL;
+}
+
+bool CursorSnapshotReader::isWriterOpen() const
+{
+    return snapshot_ != NULL && snapshot_->isWriterOpen();
+}
+
+bool CursorSnapshotReader::hasNewFrame() const
+{
+    return snapshot_ != NULL && snapshot_->sequence() != lastSequence_;
+}
+
+/**
+ * A torn copy is taken again at once; the writer's critical section is a
+ * copy of the cursors, so spinning is cheaper than sleeping.  Only a
+ * writer that died in the middle of a frame makes it yield for long.
+ */
+bool CursorSnapshotReader::read( CursorSnapshotFrame & frame )
+{
+    if( snapshot_ == NULL ) {
+        return false;
+    }
+    for( int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt ) {
+        if( snapshot_->tryRead( frame ) ) {
+            lastSequence_ = frame.sequence;
+            ++framesRead_;
+            return true;
+        }
+        ++retries_;
+
+        if( attempt >= 64 ) {
+            std::this_thread::yield();
+        }
+    }
+    return false;
+}
+
+/**
+ * A reader that can be woken counts itself in for the whole wait and
+ * checks in before every slice of it; one that cannot polls.
+ */
+bool CursorSnapshotReader::waitForFrame( int timeoutMilliseconds )
+{
+    if( snapshot_ == NULL ) {
+        return false;
+    }
+    if( hasNewFrame() ) {
+        return true;
+    }
+    snapshot_int64_t now = steadyNanoseconds(),
+                     deadline = now + (snapshot_int64_t)timeoutMilliseconds * 1000000;
+    bool counted = canBeWoken();
+
+    if( counted ) {
+        snapshot_->addWaiter( now );
+    }
+    for( ;; ) {
+        // checked after addWaiter(), or a frame published just before
+        // would not wake us
+        snapshot_uint32_t sequence = snapshot_->sequence();
+
+        if( sequence != lastSequence_ ) {
+            break;
+        }
+        now = steadyNanoseconds();
+
+        if( now >= deadline ) {
+            break;
+        }
+        if( counted ) {
+            snapshot_->checkIn( now );
+        }
+        snapshot_int64_t slice = (snapshot_int64_t)CursorSnapshot::WAIT_SLICE * 1000000;
+        sleep( sequence, deadline - now < slice ? deadline - now : slice );
+    }
+    if( counted ) {
+#ifdef WIN32
+        // the auto-reset event woke only one of the readers waiting
+        if( snapshot_->removeWaiter() != 0 && hasNewFrame() ) {
+            SetEvent( (HANDLE)frameEvent_ );
+        }
+#else
+        snapshot_->removeWaiter();
+#endif
+    }
+    return hasNewFrame();
+}
+
+bool CursorSnapshotReader::canBeWoken() const
+{
+#if defined __linux__
+    return true;
+#elif defined WIN32
+    return frameEvent_ != NULL;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Returns early when woken, or at once if the sequence number is no longer
+ * the one seen.
+ */
+void CursorSnapshotReader::sleep( snapshot_uint32_t sequence, snapshot_int64_t nanoseconds )
+{
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = (time_t)(nanoseconds / 1000000000);
+    timeout.tv_nsec = (long)(nanoseconds % 1000000000);
+    syscall( SYS_futex, snapshot_->sequenceAddress(), FUTEX_WAIT, sequence, &timeout, NULL, 0 );
+#else
+#ifdef WIN32
+    if( frameEvent_ != NULL ) {
+        // a whole millisecond more, so the caller never spins on a zero timeout
+        WaitForSingleObject( (HANDLE)frameEvent_, (DWORD)(nanoseconds / 1000000 + 1) );
+        return;
+    }
+#endif
+    std::this_thread::sleep_for( std::chrono::nanoseconds( nanoseconds < 1000000 ? nanoseconds : 1000000 ) );
+#endif
+}
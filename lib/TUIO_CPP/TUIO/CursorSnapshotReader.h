@@ -0,0 +1,115 @@
+/*******************************************************************************
+CursorSnapshotReader
+
+PURPOSE: Opens a CursorSnapshot published by a CursorSnapshotWriter in
+         another process and reads its frames.
+
+NOTES:
+For a program on the same host as TouchHooks2Tuio that wants the cursors
+with as little delay as possible: no sockets, no OSC and no TuioClient,
+only the TUIO headers it includes.  A reader either polls (hasNewFrame()
+and read() make no system call) or blocks in waitForFrame(), which sleeps
+on a futex on Linux, or on the writer's event on Windows, and wakes when
+the next frame is published.  Elsewhere waitForFrame() checks once a
+millisecond.  A waiting reader also wakes every CursorSnapshot::WAIT_SLICE
+milliseconds to check in with the writer (see CursorSnapshot).
+
+The Windows event is auto-reset, so a frame wakes one reader; that reader
+sets the event again if others are still waiting.  One that was woken but
+had already read the frame does not, so with several readers an odd one
+may see a frame up to WAIT_SLICE late.
+
+read() retries while the writer is writing the frame, which takes a few
+microseconds at most; getRetries() counts how often it had to.  If the
+writer has gone (isWriterOpen() false), close() and open() again to follow
+the next one.
+
+A CursorSnapshotReader is for one thread.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_CURSORSNAPSHOTREADER_H
+#define INCLUDED_CURSORSNAPSHOTREADER_H
+
+#include "LibExport.h"
+#include "CursorSnapshot.h"
+#include <string>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * CursorSnapshotReader reader;<br/>
+     * CursorSnapshotFrame frame;<br/>
+     * if( reader.open() ) {<br/>
+     * &nbsp;&nbsp;while( reader.waitForFrame( 100 ) && reader.read( frame ) ) {<br/>
+     * &nbsp;&nbsp;&nbsp;&nbsp;...frame.cursors[0] to frame.cursors[frame.count - 1]...<br/>
+     * &nbsp;&nbsp;}<br/>
+     * }<br/>
+     * </code></p>
+     */
+    class LIBDECL CursorSnapshotReader
+    {
+    public:
+        enum { MAX_READ_ATTEMPTS = 100000 };
+
+        CursorSnapshotReader();
+        ~CursorSnapshotReader();
+
+        /**
+         * Maps the writer's memory.
+         *
+         * @return  false if there is no writer of that name, or it was built
+         *          with another layout.
+         */
+        bool open( const char * name = CURSOR_SNAPSHOT_DEFAULT_NAME );
+        void close();
+        bool isOpen() const { return snapshot_ != NULL; }
+
+        /**
+         * @return  false once the writer has been deleted.
+         */
+        bool isWriterOpen() const;
+
+        /**
+         * @return  true if a frame has been published since the last read().
+         */
+        bool hasNewFrame() const;
+
+        /**
+         * Copies the latest frame, new or not.
+         *
+         * @return  false if the reader is not open, or the writer stopped in
+         *          the middle of a frame and never finished it.
+         */
+        bool read( CursorSnapshotFrame & frame );
+
+        /**
+         * Waits until hasNewFrame() or the time is up.
+         *
+         * @return  hasNewFrame().
+         */
+        bool waitForFrame( int timeoutMilliseconds );
+
+        unsigned long getFramesRead() const { return framesRead_; }
+        unsigned long getRetries() const { return retries_; }
+
+    private:
+        CursorSnapshotReader( const CursorSnapshotReader & );
+        CursorSnapshotReader & operator=( const CursorSnapshotReader & );
+
+        bool canBeWoken() const;
+        void sleep( snapshot_uint32_t sequence, snapshot_int64_t nanoseconds );
+
+        CursorSnapshot * snapshot_;
+#ifdef WIN32
+        void * mapping_,
+             * frameEvent_;
+#endif
+        snapshot_uint32_t lastSequence_;
+        unsigned long framesRead_,
+                      retries_;
+    };
+}
+
+#endif /* INCLUDED_CURSORSNAPSHOTREADER_H */
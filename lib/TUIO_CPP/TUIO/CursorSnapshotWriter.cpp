@@ -0,0 +1,188 @@
+/*******************************************************************************
+CursorSnapshotWriter
+
+PURPOSE: Creates the named shared memory for a CursorSnapshot and publishes
+         each frame of the TuioCursorServer into it.  See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "CursorSnapshotWriter.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#endif
+#include <chrono>
+
+using namespace TUIO;
+
+CursorSnapshotWriter::CursorSnapshotWriter( const char * name /*= CURSOR_SNAPSHOT_DEFAULT_NAME*/ ) :
+  name_( name ),
+  snapshot_( NULL ),
+#ifdef WIN32
+  mapping_( NULL ),
+  frameEvent_( NULL ),
+#endif
+  slots_( NULL ),
+  count_( 0 ),
+  frame_( 0 ),
+  frameTime_( 0 ),
+  nextKnown_( 0 ),
+  framesPublished_( 0 ),
+  wakeups_( 0 ),
+  cursorsLeftOut_( 0 )
+{
+    void * memory = NULL;
+#ifdef WIN32
+    std::string mappingName = "Local\\" + name_;
+    HANDLE mapping = CreateFileMappingA( INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, 0,
+                                         sizeof( CursorSnapshot ), mappingName.c_str() );
+    if( mapping != NULL ) {
+        memory = MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof( CursorSnapshot ) );
+
+        if( memory == NULL ) {
+            CloseHandle( mapping );
+        }
+        else {
+            mapping_ = mapping;
+            // auto-reset: each SetEvent() wakes one reader, which passes it on
+            frameEvent_ = CreateEventA( NULL, FALSE, FALSE, (mappingName + CURSOR_SNAPSHOT_EVENT_SUFFIX).c_str() );
+        }
+    }
+#else
+    std::string objectName = "/" + name_;
+    int fd = shm_open( objectName.c_str(), O_CREAT | O_RDWR, 0600 );
+
+    if( fd >= 0 ) {
+        if( ftruncate( fd, sizeof( CursorSnapshot ) ) == 0 ) {
+            memory = mmap( NULL, sizeof( CursorSnapshot ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+            if( memory == MAP_FAILED ) {
+                memory = NULL;
+            }
+        }
+        close( fd );
+    }
+#endif
+    if( memory != NULL ) {
+        snapshot_ = (CursorSnapshot *)memory;
+
+        if( !snapshot_->initialize() ) {
+            snapshot_->close();
+            snapshot_ = NULL;
+        }
+    }
+    known_.reserve( CursorSnapshot::CAPACITY );
+    writing_.reserve( CursorSnapshot::CAPACITY );
+}
+
+CursorSnapshotWriter::~CursorSnapshotWriter()
+{
+    if( snapshot_ != NULL ) {
+        snapshot_->close();
+    }
+#ifdef WIN32
+    if( mapping_ != NULL ) {
+        UnmapViewOfFile( (void *)snapshot_ );
+        CloseHandle( (HANDLE)mapping_ );
+    }
+    if( frameEvent_ != NULL ) {
+        CloseHandle( (HANDLE)frameEvent_ );
+    }
+#else
+    if( snapshot_ != NULL ) {
+        munmap( (void *)snapshot_, sizeof( CursorSnapshot ) );
+        shm_unlink( ("/" + name_).c_str() );
+    }
+#endif
+}
+
+void CursorSnapshotWriter::beginFrame( long frame, TuioTime frameTime )
+{
+    if( snapshot_ == NULL ) {
+        return;
+    }
+    slots_ = snapshot_->beginWrite();
+    count_ = 0;
+    frame_ = (snapshot_uint32_t)frame;
+    frameTime_ = frameTime.getTotalMicroseconds();
+    writing_.clear();
+}
+
+void CursorSnapshotWriter::addCursor( const TuioCursor * tcur, float x, float y, bool changed )
+{
+    if( slots_ == NULL ) {
+        return;
+    }
+    if( count_ == CursorSnapshot::CAPACITY ) {
+        ++cursorsLeftOut_;
+        return;
+    }
+    Known known;
+    known.sessionId = tcur->getSessionID();
+    known.frame = changed ? frame_ : lastChangedFrame( known.sessionId );
+    writing_.push_back( known );
+
+    CursorSnapshotSlot & slot = slots_[count_++];
+    slot.sessionId = (snapshot_uint32_t)known.sessionId;
+    slot.cursorId = tcur->getCursorID();
+    slot.state = (snapshot_uint32_t)tcur->getTuioState();
+    slot.frame = known.frame;
+    slot.x = x;
+    slot.y = y;
+    slot.xSpeed = tcur->getXSpeed();
+    slot.ySpeed = tcur->getYSpeed();
+    slot.motionSpeed = tcur->getMotionSpeed();
+    slot.motionAccel = tcur->getMotionAccel();
+}
+
+void CursorSnapshotWriter::endFrame()
+{
+    if( slots_ == NULL ) {
+        return;
+    }
+    snapshot_int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+    if( snapshot_->endWrite( frame_, frameTime_, now, count_ ) ) {
+#ifdef __linux__
+        // not FUTEX_PRIVATE_FLAG: the readers are other processes
+        syscall( SYS_futex, snapshot_->sequenceAddress(), FUTEX_WAKE, INT_MAX, NULL, NULL, 0 );
+#elif defined WIN32
+        if( frameEvent_ != NULL ) {
+            SetEvent( (HANDLE)frameEvent_ );
+        }
+#endif
+        ++wakeups_;
+    }
+    slots_ = NULL;
+    known_.swap( writing_ );
+    nextKnown_ = 0;
+    ++framesPublished_;
+}
+
+/**
+ * The cursors mostly come in the order they came in the last frame, so
+ * the search starts after the one found last.
+ */
+snapshot_uint32_t CursorSnapshotWriter::lastChangedFrame( long sessionId )
+{
+    for( size_t n = 0; n < known_.size(); ++n ) {
+        size_t i = (nextKnown_ + n) % known_.size();
+
+        if( known_[i].sessionId == sessionId ) {
+            nextKnown_ = i + 1;
+            return known_[i].frame;
+        }
+    }
+    return frame_;
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+CursorSnapshotWriter
+
+PURPOSE: Creates the named shared memory for a CursorSnapshot and publishes
+         each frame of the TuioCursorServer into it.
+
+NOTES:
+The memory is a POSIX shared memory object ("/" and the name) or, on
+Windows, a paging-file mapping in the session namespace ("Local\" and the
+name).  The writer creates it (or takes over one left behind by a writer
+that crashed) and removes the name when it is deleted; readers still
+attached see isWriterOpen() turn false and can open the next one.
+
+A frame is written in place between beginFrame() and endFrame(), one
+cursor at a time, so publishing costs a copy of each cursor and, only when
+a reader is waiting for the frame, one wake-up call: a futex wake on Linux,
+SetEvent() on an auto-reset event named after the mapping on Windows (and
+nothing elsewhere, where readers poll).  Cursors beyond
+CursorSnapshot::CAPACITY are left out and counted.
+
+Everything but the counters is for the server's sending thread only.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_CURSORSNAPSHOTWRITER_H
+#define INCLUDED_CURSORSNAPSHOTWRITER_H
+
+#include "LibExport.h"
+#include "CursorSnapshot.h"
+#include "TuioCursor.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * CursorSnapshotWriter * writer = new CursorSnapshotWriter();<br/>
+     * tuioCursorServer->setCursorSnapshotWriter( writer );<br/>
+     * </code></p>
+     */
+    class LIBDECL CursorSnapshotWriter
+    {
+    public:
+        /**
+         * Creates and maps the memory; see isOpen().
+         */
+        CursorSnapshotWriter( const char * name = CURSOR_SNAPSHOT_DEFAULT_NAME );
+
+        /**
+         * Tells the readers the writer is gone and removes the name.
+         */
+        ~CursorSnapshotWriter();
+
+        /**
+         * @return  false if the memory could not be created or mapped, in
+         *          which case nothing is published.
+         */
+        bool isOpen() const { return snapshot_ != NULL; }
+        const std::string & getName() const { return name_; }
+
+        /**
+         * Starts writing a frame.  Every cursor in the frame must then be
+         * added, changed or not, before endFrame().
+         */
+        void beginFrame( long frame, TuioTime frameTime );
+
+        /**
+         * @param  x, y     the position to publish (predicted, if prediction
+         *                  is on, as sent on the other channels).
+         * @param  changed  the cursor changed in this frame.
+         */
+        void addCursor( const TuioCursor * tcur, float x, float y, bool changed );
+
+        /**
+         * Publishes the frame and wakes up the readers waiting for it.
+         */
+        void endFrame();
+
+        unsigned long getFramesPublished() const { return framesPublished_; }
+        unsigned long getWakeups() const { return wakeups_; }
+        unsigned long getCursorsLeftOut() const { return cursorsLeftOut_; }
+
+    private:
+        // The frame each cursor of the last frame last changed in.
+        struct Known
+        {
+            long sessionId;
+            snapshot_uint32_t frame;
+        };
+
+        CursorSnapshotWriter( const CursorSnapshotWriter & );
+        CursorSnapshotWriter & operator=( const CursorSnapshotWriter & );
+
+        snapshot_uint32_t lastChangedFrame( long sessionId );
+
+        std::string name_;
+        CursorSnapshot * snapshot_;
+#ifdef WIN32
+        void * mapping_,
+             * frameEvent_;
+#endif
+
+        CursorSnapshotSlot * slots_;      // of the frame being written
+        snapshot_uint32_t count_,
+                          frame_;
+        snapshot_int64_t frameTime_;
+        std::vector<Known> known_,        // the last frame's cursors
+                           writing_;      // this frame's
+        size_t nextKnown_;                // where to look first
+
+        std::atomic<unsigned long> framesPublished_,
+                                   wakeups_,
+                                   cursorsLeftOut_;
+    };
+}
+
+#endif /* INCLUDED_CURSORSNAPSHOTWRITER_H */
@@ -0,0 +1,198 @@
+/*******************************************************************************
+FlashXmlEncoder
+
+PURPOSE: Writes TUIO /tuio/2Dcur frames as Flash XML into one reusable
+         buffer.  See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "FlashXmlEncoder.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace TUIO;
+
+static const long long POWERS_OF_TEN[] = { 1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL,
+                                           1000000LL, 10000000LL, 100000000LL, 1000000000LL };
+
+// Beyond this, value * 10^decimals no longer fits in a long long.
+static const double MAX_FIXED_POINT_VALUE = 1e9;
+
+FlashXmlEncoder::FlashXmlEncoder( int port, std::size_t capacity /*= DEFAULT_CAPACITY*/ ) :
+  buffer_( capacity > 0 ? capacity : 1 ),
+  size_( 0 ),
+  portLength_( 0 ),
+  decimals_( DEFAULT_PRECISION ),
+  fixed_( false )
+{
+    setPort( port );
+}
+
+void FlashXmlEncoder::setPort( int port )
+{
+    portLength_ = (std::size_t)sprintf( port_, "%d", port );
+}
+
+void FlashXmlEncoder::setFloatPrecision( int decimals, bool fixed /*= false*/ )
+{
+    decimals_ = decimals < 0 ? 0 : (decimals > MAX_PRECISION ? MAX_PRECISION : decimals);
+    fixed_ = fixed;
+}
+
+void FlashXmlEncoder::beginPacket( long frameTimeMilliseconds )
+{
+    size_ = 0;
+    appendLiteral( "<OSCPACKET ADDRESS=\"127.0.0.1\" PORT=\"" );
+    append( port_, portLength_ );
+    appendLiteral( "\" TIME=\"" );
+    appendFloat( frameTimeMilliseconds / 1000.0, 3, true );
+    appendLiteral( "\">" );
+}
+
+void FlashXmlEncoder::addSetMessage( long sessionId, float x, float y, float xSpeed, float ySpeed, float motionAccel )
+{
+    bool trim = !fixed_;
+
+    appendLiteral( "<MESSAGE NAME=\"/tuio/2Dcur\">"
+                   "<ARGUMENT TYPE=\"s\" VALUE=\"set\"/>"
+                   "<ARGUMENT TYPE=\"i\" VALUE=\"" );
+    appendInt( sessionId );
+    appendLiteral( "\"/><ARGUMENT TYPE=\"f\" VALUE=\"" );
+    appendFloat( x, decimals_, trim );
+    appendLiteral( "\"/><ARGUMENT TYPE=\"f\" VALUE=\"" );
+    appendFloat( y, decimals_, trim );
+    appendLiteral( "\"/><ARGUMENT TYPE=\"f\" VALUE=\"" );
+    appendFloat( xSpeed, decimals_, trim );
+    appendLiteral( "\"/><ARGUMENT TYPE=\"f\" VALUE=\"" );
+    appendFloat( ySpeed, decimals_, trim );
+    appendLiteral( "\"/><ARGUMENT TYPE=\"f\" VALUE=\"" );
+    appendFloat( motionAccel, decimals_, trim );
+    appendLiteral( "\"/></MESSAGE>" );
+}
+
+void FlashXmlEncoder::beginAliveMessage()
+{
+    appendLiteral( "<MESSAGE NAME=\"/tuio/2Dcur\">"
+                   "<ARGUMENT TYPE=\"s\" VALUE=\"alive\"/>" );
+}
+
+void FlashXmlEncoder::addAliveId( long sessionId )
+{
+    appendLiteral( "<ARGUMENT TYPE=\"i\" VALUE=\"" );
+    appendInt( sessionId );
+    appendLiteral( "\"/>" );
+}
+
+void FlashXmlEncoder::endAliveMessage()
+{
+    appendLiteral( "</MESSAGE>" );
+}
+
+void FlashXmlEncoder::addFseqMessage( long frameId )
+{
+    appendLiteral( "<MESSAGE NAME=\"/tuio/2Dcur\">"
+                   "<ARGUMENT TYPE=\"s\" VALUE=\"fseq\"/>"
+                   "<ARGUMENT TYPE=\"i\" VALUE=\"" );
+    appendInt( frameId );
+    appendLiteral( "\"/></MESSAGE>" );
+}
+
+void FlashXmlEncoder::endPacket()
+{
+    appendLiteral( "</OSCPACKET>" );
+    reserve( 1 );
+    buffer_[size_++] = '\0';
+}
+
+void FlashXmlEncoder::reserve( std::size_t n )
+{
+    if( size_ + n > buffer_.size() ) {
+        std::size_t capacity = buffer_.size() * 2;
+
+        while( capacity < size_ + n ) {
+            capacity *= 2;
+        }
+        buffer_.resize( capacity );
+    }
+}
+
+void FlashXmlEncoder::append( const char * s, std::size_t n )
+{
+    reserve( n );
+    memcpy( &buffer_[size_], s, n );
+    size_ += n;
+}
+
+void FlashXmlEncoder::appendInt( long n )
+{
+    char digits[24];
+    int i = sizeof( digits );
+    unsigned long long u = n < 0 ? 0ULL - (unsigned long long)n : (unsigned long long)n;
+
+    do {
+        digits[--i] = (char)('0' + u % 10);
+        u /= 10;
+    } while( u != 0 );
+
+    if( n < 0 ) {
+        digits[--i] = '-';
+    }
+    append( digits + i, sizeof( digits ) - i );
+}
+
+/**
+ * Rounds to the given number of decimal places and writes the integer and
+ * fraction parts with integer arithmetic.
+ */
+void FlashXmlEncoder::appendFloat( double f, int decimals, bool trim )
+{
+    if( f != f || f - f != 0.0 ) { // NaN or infinity
+        appendLiteral( "0" );
+        return;
+    }
+    if( f >= MAX_FIXED_POINT_VALUE || f <= -MAX_FIXED_POINT_VALUE ) {
+        char text[32];
+        int n = sprintf( text, "%g", f );
+        append( text, (std::size_t)n );
+        return;
+    }
+    long long scale = POWERS_OF_TEN[decimals],
+              scaled = (long long)floor( fabs( f ) * scale + 0.5 );
+
+    if( scaled == 0 ) {
+        appendLiteral( "0" );
+
+        if( !trim && decimals > 0 ) {
+            reserve( decimals + 1 );
+            buffer_[size_++] = '.';
+            memset( &buffer_[size_], '0', decimals );
+            size_ += decimals;
+        }
+        return;
+    }
+    if( f < 0 ) {
+        appendLiteral( "-" );
+    }
+    appendInt( (long)(scaled / scale) );
+
+    long long fraction = scaled % scale;
+    int digits = decimals;
+
+    if( trim ) {
+        while( digits > 0 && fraction % 10 == 0 ) {
+            fraction /= 10;
+            --digits;
+        }
+    }
+    if( digits > 0 ) {
+        reserve( digits + 1 );
+        buffer_[size_] = '.';
+
+        for( int i = digits; i > 0; --i ) {
+            buffer_[size_ + i] = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        size_ += digits + 1;
+    }
+}
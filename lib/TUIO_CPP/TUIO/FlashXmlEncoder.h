@@ -0,0 +1,106 @@
+/*******************************************************************************
+FlashXmlEncoder
+
+PURPOSE: Writes TUIO /tuio/2Dcur frames as Flash XML (the <OSCPACKET> format
+         that Flash and some other TUIO clients read over TCP) into one
+         reusable buffer.
+
+NOTES:
+The XML skeleton is fixed, so a frame is written by copying string literals
+and formatting the numbers straight into the buffer.  The buffer is made
+once, big enough for a typical frame, and is only ever grown (never
+shrunk), so once the largest frame has been seen no more heap memory is
+used.  The finished packet ends with the NUL character that Flash needs
+after each message, so it can be handed to the socket as it is.
+
+Floats are written in fixed-point notation with a given number of decimal
+places (6 by default).  Trailing zeros are trimmed unless fixed precision
+is asked for.  Numbers too big for fixed-point notation fall back to
+printf's %g.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_FLASHXMLENCODER_H
+#define INCLUDED_FLASHXMLENCODER_H
+
+#include "LibExport.h"
+#include <cstddef>
+#include <vector>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * FlashXmlEncoder encoder( 3000 );<br/>
+     * encoder.beginPacket( frameTimeInMilliseconds );<br/>
+     * encoder.addSetMessage( sessionId, x, y, xSpeed, ySpeed, motionAccel );<br/>
+     * encoder.beginAliveMessage();<br/>
+     * encoder.addAliveId( sessionId );<br/>
+     * encoder.endAliveMessage();<br/>
+     * encoder.addFseqMessage( frameId );<br/>
+     * encoder.endPacket();<br/>
+     * socket.send( encoder.data(), encoder.size() );<br/>
+     * </code></p>
+     */
+    class LIBDECL FlashXmlEncoder
+    {
+    public:
+        enum { DEFAULT_CAPACITY = 16 * 1024,
+               DEFAULT_PRECISION = 6,
+               MAX_PRECISION = 9 };
+
+        /**
+         * @param  port      the port written in the PORT attribute of each packet.
+         * @param  capacity  the starting size of the buffer in bytes.
+         */
+        FlashXmlEncoder( int port, std::size_t capacity = DEFAULT_CAPACITY );
+
+        void setPort( int port );
+
+        /**
+         * @param  decimals  digits written after the decimal point, 0 to MAX_PRECISION.
+         * @param  fixed     if true, trailing zeros are kept.
+         */
+        void setFloatPrecision( int decimals, bool fixed = false );
+
+        /**
+         * Clears the buffer and writes the <OSCPACKET> start tag.
+         */
+        void beginPacket( long frameTimeMilliseconds );
+        void addSetMessage( long sessionId, float x, float y, float xSpeed, float ySpeed, float motionAccel );
+        void beginAliveMessage();
+        void addAliveId( long sessionId );
+        void endAliveMessage();
+        void addFseqMessage( long frameId );
+
+        /**
+         * Writes the </OSCPACKET> end tag and the NUL terminator.
+         */
+        void endPacket();
+
+        /**
+         * The finished packet, including the NUL terminator.
+         */
+        const char * data() const { return &buffer_[0]; }
+        std::size_t size() const { return size_; }
+        std::size_t capacity() const { return buffer_.size(); }
+
+    private:
+        template<std::size_t N>
+        void appendLiteral( const char (&s)[N] ) { append( s, N - 1 ); }
+
+        void append( const char * s, std::size_t n );
+        void appendInt( long n );
+        void appendFloat( double f, int decimals, bool trim );
+        void reserve( std::size_t n );
+
+        std::vector<char> buffer_;
+        std::size_t size_;
+        char port_[12];
+        std::size_t portLength_;
+        int decimals_;
+        bool fixed_;
+    };
+}
+
+#endif /* INCLUDED_FLASHXMLENCODER_H */
@@ -1,65 +1,641 @@
 /*******************************************************************************
 FlashXmlTcpServer
 
-PURPOSE: Wrapper class for ofxTCPServer class, which was borrowed from 
-         the ofxNetwork module of openFrameworks.  
-         
-NOTES: 
-I had orignally planned to use the TcpSender class of the TUIO_CPP library, 
-which is in the lib/TUIO_CPP/TUIO directory.  However, for unclear reasons, 
-the TcpSender would not intialize (kept getting a return value of false from 
-the isConnected() function).  As I was using ofxTCPServer in another project, 
-I decided to just use that instead.
-
-The ofxTCPServer class along with a few related classes and their support 
-libraries can be found in lib/ofxTCPServer_v0.8.4_VS2013.  These classes were
-extracted from openFrameworks version 0.8.4 (http://openframeworks.cc/download).
-This version of openFrameworks was built for Visual Studio 2012 Express Edition.
-When I first built tried to use ofxTCPServer with Visual Studio 2013 Community 
-Edition, it would compile, but the static libraries it needed (POCO and OpenSSL)
-would not link due to differences in the version of the C/C++ compiler for 
-Visual Studio 2012 and 2013 (Microsoft C/C++ compiler 11.0 versus 12.0).  
-To get around this problem, I had to download the POCO project from
-http://pocoproject.org/index.html and the OpenSSL project from 
-http://www.openssl.org/source, and then build both of them with Visual Studio
-2013 Community Edtion (with C/C++ compiler version 12.0).  These static
-libraries can be found in the lib/ofxTCPServer_v0.8.4_VS2013/libs directory, so
-you should not need to build them.  I did not include the rest of openFrameworks
-version 0.8.4 because there are several other static libraries that would all
-have the same problem (they would work with Visual Studio 2012, but not with
-Visual Studio 2013).
-
-Unfortunately, the POCO and OpenSSL libraries take up a lot of space (over 
-400 MB combined), so if somebody else wants to fix up the TcpSender class 
-of TUIO_CPP and use that instead, that would greatly reduce the size of the
-libraries needed for building.
+PURPOSE: A small TCP server that sends Flash XML frames to every connected
+         client without ever blocking the sender.  See the header file.
 
 J.R.Weber <joe.weber77@gmail.com>
 *******************************************************************************/
 #include "FlashXmlTcpServer.h"
-#include <ofxTCPServer.h>
+#include "ip/NetworkingUtils.h"
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+#if defined( __linux__ ) && !defined( TUIO_NO_EPOLL )
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define TUIO_USE_EPOLL
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef WIN32
+typedef SOCKET SocketHandle;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static void closeSocket( SocketHandle s ) { closesocket( s ); }
+static const int SEND_FLAGS = 0;
+
+static void setNonBlocking( SocketHandle s )
+{
+    u_long on = 1;
+    ioctlsocket( s, FIONBIO, &on );
+}
+#else
+typedef int SocketHandle;
+static const SocketHandle NO_SOCKET = -1;
+static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+static void closeSocket( SocketHandle s ) { close( s ); }
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL; // a closed client must not raise SIGPIPE
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+static void setNonBlocking( SocketHandle s )
+{
+    fcntl( s, F_SETFL, fcntl( s, F_GETFL, 0 ) | O_NONBLOCK );
+}
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static long millisecondsSince( Clock::time_point then, Clock::time_point now )
+{
+    return (long)std::chrono::duration_cast<std::chrono::milliseconds>( now - then ).count();
+}
+
+/**
+ * A frame waiting to be sent to one client.  The bytes are shared by every
+ * client that queued the same frame.
+ */
+struct QueuedFrame
+{
+    std::shared_ptr< std::vector<char> > bytes;
+    size_t offset;
+    Clock::time_point queued;
+};
+
+struct Client
+{
+    SocketHandle socket;
+    std::string address;
+    std::deque<QueuedFrame> queue;
+    unsigned long framesSent,
+                  framesDropped;
+    long maxLagMilliseconds;
+    bool closed;
+};
+
+/**
+ * The sockets, the clients and the event loop, kept here so the header file
+ * does not need the platform's socket headers.
+ */
+class FlashXmlTcpServer::Implementation
+{
+public:
+    Implementation() :
+      networkInitializer_(),
+      listener_( NO_SOCKET ),
+      wake_( NO_SOCKET ),
+#ifdef TUIO_USE_EPOLL
+      poll_( -1 ),
+#else
+      wakeSender_( NO_SOCKET ),
+#endif
+      port_( 0 ),
+      running_( false ),
+      fullFrameRequested_( false )
+    {
+    }
+
+    ~Implementation()
+    {
+        stop();
+    }
+
+    bool start( int port );
+    void stop();
+    bool isRunning() const { return running_.load(); }
+    int port() const { return port_; }
+
+    bool sendToAll( const char * data, size_t size );
+
+    int clientCount();
+    std::vector<ClientStats> clientStats();
+    bool takeFullFrameRequest() { return fullFrameRequested_.exchange( false ); }
+
+private:
+    void run();
+    void acceptClients();
+    void readFromClient( Client * client );
+    void writeQueue( Client * client, Clock::time_point now );
+    void enqueue( Client * client, const std::shared_ptr< std::vector<char> > & bytes,
+                  size_t offset, Clock::time_point now );
+    void watchForWrites( Client * client, bool on );
+    void removeClosedClients();
+    void wakeUp();
+    void drainWakeUps();
+
+    OscNetworkInitializer networkInitializer_;
+    SocketHandle listener_,
+                 wake_;
+#ifdef TUIO_USE_EPOLL
+    int poll_;
+#else
+    SocketHandle wakeSender_;
+#endif
+    int port_;
+    std::atomic<bool> running_,
+                      fullFrameRequested_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<Client *> clients_;
+};
+
+bool FlashXmlTcpServer::Implementation::start( int port )
+{
+    listener_ = ::socket( AF_INET, SOCK_STREAM, 0 );
+
+    if( listener_ == NO_SOCKET ) {
+        return false;
+    }
+    int on = 1;
+    setsockopt( listener_, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof( on ) );
+
+    struct sockaddr_in address;
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_ANY );
+    address.sin_port = htons( (unsigned short)port );
+    socklen_t length = sizeof( address );
+
+    if( bind( listener_, (struct sockaddr *)&address, sizeof( address ) ) != 0
+        || listen( listener_, SOMAXCONN ) != 0
+        || getsockname( listener_, (struct sockaddr *)&address, &length ) != 0 ) {
+        closeSocket( listener_ );
+        listener_ = NO_SOCKET;
+        return false;
+    }
+    port_ = ntohs( address.sin_port );
+    setNonBlocking( listener_ );
+
+#ifdef TUIO_USE_EPOLL
+    poll_ = epoll_create1( EPOLL_CLOEXEC );
+    wake_ = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ) );
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; // the listener
+    epoll_ctl( poll_, EPOLL_CTL_ADD, listener_, &event );
+    event.data.ptr = this; // the wake-up event
+    epoll_ctl( poll_, EPOLL_CTL_ADD, wake_, &event );
+#else
+    // select() can only wait on sockets, so the loop is woken up by a
+    // datagram sent to a UDP socket bound to localhost.
+    wake_ = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    wakeSender_ = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    length = sizeof( address );
+    bind( wake_, (struct sockaddr *)&address, sizeof( address ) );
+    getsockname( wake_, (struct sockaddr *)&address, &length );
+    connect( wakeSender_, (struct sockaddr *)&address, sizeof( address ) );
+    setNonBlocking( wake_ );
+    setNonBlocking( wakeSender_ );
+#endif
+    running_.store( true );
+    thread_ = std::thread( &Implementation::run, this );
+    return true;
+}
+
+void FlashXmlTcpServer::Implementation::stop()
+{
+    if( running_.exchange( false ) ) {
+        wakeUp();
+        thread_.join();
+    }
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        closeSocket( clients_[i]->socket );
+        delete clients_[i];
+    }
+    clients_.clear();
+
+    if( listener_ != NO_SOCKET ) {
+        closeSocket( listener_ );
+        listener_ = NO_SOCKET;
+    }
+#ifdef TUIO_USE_EPOLL
+    if( wake_ != NO_SOCKET ) {
+        close( wake_ );
+        wake_ = NO_SOCKET;
+    }
+    if( poll_ >= 0 ) {
+        close( poll_ );
+        poll_ = -1;
+    }
+#else
+    if( wake_ != NO_SOCKET ) {
+        closeSocket( wake_ );
+        wake_ = NO_SOCKET;
+    }
+    if( wakeSender_ != NO_SOCKET ) {
+        closeSocket( wakeSender_ );
+        wakeSender_ = NO_SOCKET;
+    }
+#endif
+}
+
+void FlashXmlTcpServer::Implementation::wakeUp()
+{
+#ifdef TUIO_USE_EPOLL
+    uint64_t one = 1;
+    ssize_t written = write( wake_, &one, sizeof( one ) );
+    (void)written; // a full counter means the loop is already awake
+#else
+    char byte = 0;
+    send( wakeSender_, &byte, 1, 0 );
+#endif
+}
+
+void FlashXmlTcpServer::Implementation::drainWakeUps()
+{
+#ifdef TUIO_USE_EPOLL
+    uint64_t count;
+    ssize_t n = read( wake_, &count, sizeof( count ) );
+    (void)n;
+#else
+    char buffer[64];
+
+    while( recv( wake_, buffer, sizeof( buffer ), 0 ) > 0 ) {
+    }
+#endif
+}
+
+void FlashXmlTcpServer::Implementation::run()
+{
+#ifdef TUIO_USE_EPOLL
+    const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+
+    while( running_.load() ) {
+        int count = epoll_wait( poll_, events, MAX_EVENTS, -1 );
+
+        if( count < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            break;
+        }
+        std::lock_guard<std::mutex> lock( mutex_ );
+        Clock::time_point now = Clock::now();
+
+        for( int i = 0; i < count; ++i ) {
+            void * source = events[i].data.ptr;
+
+            if( source == NULL ) {
+                acceptClients();
+            }
+            else if( source == this ) {
+                drainWakeUps();
+            }
+            else {
+                Client * client = (Client *)source;
+
+                if( events[i].events & (EPOLLERR | EPOLLHUP) ) {
+                    client->closed = true;
+                }
+                if( !client->closed && (events[i].events & EPOLLIN) ) {
+                    readFromClient( client );
+                }
+                if( !client->closed && (events[i].events & EPOLLOUT) ) {
+                    writeQueue( client, now );
+                }
+            }
+        }
+        removeClosedClients();
+    }
+#else
+    while( running_.load() ) {
+        fd_set readable,
+               writable;
+        FD_ZERO( &readable );
+        FD_ZERO( &writable );
+        SocketHandle highest = listener_ > wake_ ? listener_ : wake_;
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            FD_SET( listener_, &readable );
+            FD_SET( wake_, &readable );
+
+            for( size_t i = 0; i < clients_.size(); ++i ) {
+                SocketHandle s = clients_[i]->socket;
+                FD_SET( s, &readable );
+
+                if( !clients_[i]->queue.empty() ) {
+                    FD_SET( s, &writable );
+                }
+                if( s > highest ) {
+                    highest = s;
+                }
+            }
+        }
+        if( select( (int)highest + 1, &readable, &writable, NULL, NULL ) < 0 ) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock( mutex_ );
+        Clock::time_point now = Clock::now();
+
+        if( FD_ISSET( wake_, &readable ) ) {
+            drainWakeUps();
+        }
+        if( FD_ISSET( listener_, &readable ) ) {
+            acceptClients();
+        }
+        for( size_t i = 0; i < clients_.size(); ++i ) {
+            Client * client = clients_[i];
+
+            if( FD_ISSET( client->socket, &readable ) ) {
+                readFromClient( client );
+            }
+            if( !client->closed && FD_ISSET( client->socket, &writable ) ) {
+                writeQueue( client, now );
+            }
+        }
+        removeClosedClients();
+    }
+#endif
+}
+
+void FlashXmlTcpServer::Implementation::acceptClients()
+{
+    for( ;; ) {
+        struct sockaddr_in address;
+        socklen_t length = sizeof( address );
+        SocketHandle s = accept( listener_, (struct sockaddr *)&address, &length );
+
+        if( s == NO_SOCKET ) {
+            return;
+        }
+        setNonBlocking( s );
+        int on = 1;
+        setsockopt( s, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof( on ) );
+
+        Client * client = new Client();
+        client->socket = s;
+        client->address = inet_ntoa( address.sin_addr );
+        client->framesSent = 0;
+        client->framesDropped = 0;
+        client->maxLagMilliseconds = 0;
+        client->closed = false;
+        clients_.push_back( client );
+
+#ifdef TUIO_USE_EPOLL
+        struct epoll_event event;
+        memset( &event, 0, sizeof( event ) );
+        event.events = EPOLLIN;
+        event.data.ptr = client;
+        epoll_ctl( poll_, EPOLL_CTL_ADD, s, &event );
+#endif
+    }
+}
+
+void FlashXmlTcpServer::Implementation::readFromClient( Client * client )
+{
+    // Flash clients only send their policy file request, which is ignored as
+    // it was by ofxTCPServer; reading tells us when a client has gone away.
+    char buffer[1024];
+
+    for( ;; ) {
+        int n = (int)recv( client->socket, buffer, sizeof( buffer ), 0 );
+
+        if( n > 0 ) {
+            continue;
+        }
+        if( n == 0 || !wouldBlock() ) {
+            client->closed = true;
+        }
+        return;
+    }
+}
+
+void FlashXmlTcpServer::Implementation::writeQueue( Client * client, Clock::time_point now )
+{
+    while( !client->queue.empty() ) {
+        QueuedFrame & frame = client->queue.front();
+        const std::vector<char> & bytes = *frame.bytes;
+        int n = (int)send( client->socket, &bytes[frame.offset], (int)(bytes.size() - frame.offset), SEND_FLAGS );
+
+        if( n < 0 ) {
+            if( !wouldBlock() ) {
+                client->closed = true;
+            }
+            return;
+        }
+        frame.offset += (size_t)n;
+
+        if( frame.offset < bytes.size() ) {
+            return;
+        }
+        long lag = millisecondsSince( frame.queued, now );
+
+        if( lag > client->maxLagMilliseconds ) {
+            client->maxLagMilliseconds = lag;
+        }
+        ++client->framesSent;
+        client->queue.pop_front();
+    }
+    watchForWrites( client, false );
+}
+
+void FlashXmlTcpServer::Implementation::enqueue( Client * client, const std::shared_ptr< std::vector<char> > & bytes,
+                                                 size_t offset, Clock::time_point now )
+{
+    if( client->queue.size() >= MAX_QUEUED_FRAMES ) {
+        // Keep a frame that is partly written, drop the rest: the newest
+        // frame describes every cursor the client needs to know about.
+        size_t keep = client->queue.front().offset > 0 ? 1 : 0;
+        client->framesDropped += client->queue.size() - keep;
+        client->queue.resize( keep );
+        fullFrameRequested_.store( true );
+    }
+    QueuedFrame frame;
+    frame.bytes = bytes;
+    frame.offset = offset;
+    frame.queued = now;
+    client->queue.push_back( frame );
+    watchForWrites( client, true );
+}
+
+void FlashXmlTcpServer::Implementation::watchForWrites( Client * client, bool on )
+{
+#ifdef TUIO_USE_EPOLL
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ) );
+    event.events = on ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.ptr = client;
+    epoll_ctl( poll_, EPOLL_CTL_MOD, client->socket, &event );
+#else
+    if( on && client->queue.size() == 1 ) {
+        wakeUp(); // select() has to be called again with this socket in the write set
+    }
+#endif
+}
+
+void FlashXmlTcpServer::Implementation::removeClosedClients()
+{
+    size_t kept = 0;
+
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        Client * client = clients_[i];
+
+        if( client->closed ) {
+#ifdef TUIO_USE_EPOLL
+            epoll_ctl( poll_, EPOLL_CTL_DEL, client->socket, NULL );
+#endif
+            closeSocket( client->socket );
+            delete client;
+        }
+        else {
+            clients_[kept++] = client;
+        }
+    }
+    clients_.resize( kept );
+}
+
+bool FlashXmlTcpServer::Implementation::sendToAll( const char * data, size_t size )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+
+    if( clients_.empty() || size == 0 ) {
+        return false;
+    }
+    Clock::time_point now = Clock::now();
+    std::shared_ptr< std::vector<char> > bytes; // only copied if some client needs it
+    bool closed = false;
+
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        Client * client = clients_[i];
+        size_t offset = 0;
+
+        if( client->closed ) {
+            continue;
+        }
+        if( client->queue.empty() ) {
+            int n = (int)send( client->socket, data, (int)size, SEND_FLAGS );
+
+            if( n < 0 && !wouldBlock() ) {
+                client->closed = true;
+                closed = true;
+                continue;
+            }
+            offset = n > 0 ? (size_t)n : 0;
+
+            if( offset == size ) {
+                ++client->framesSent;
+                continue;
+            }
+        }
+        if( !bytes ) {
+            bytes = std::make_shared< std::vector<char> >( data, data + size );
+        }
+        enqueue( client, bytes, offset, now );
+    }
+    if( closed ) {
+        wakeUp(); // only the event loop deletes clients
+    }
+    return true;
+}
+
+int FlashXmlTcpServer::Implementation::clientCount()
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    return (int)clients_.size();
+}
+
+std::vector<FlashXmlTcpServer::ClientStats> FlashXmlTcpServer::Implementation::clientStats()
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    Clock::time_point now = Clock::now();
+    std::vector<ClientStats> stats( clients_.size() );
+
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        const Client * client = clients_[i];
+        stats[i].address = client->address;
+        stats[i].framesSent = client->framesSent;
+        stats[i].framesDropped = client->framesDropped;
+        stats[i].queuedFrames = (unsigned int)client->queue.size();
+        stats[i].lagMilliseconds = client->queue.empty() ? 0 : millisecondsSince( client->queue.front().queued, now );
+        stats[i].maxLagMilliseconds = client->maxLagMilliseconds > stats[i].lagMilliseconds
+                                      ? client->maxLagMilliseconds : stats[i].lagMilliseconds;
+    }
+    return stats;
+}
 
 FlashXmlTcpServer::FlashXmlTcpServer() :
-  tcpServer_( new ofxTCPServer() )
+  impl_( new Implementation() )
 {
 }
 
 FlashXmlTcpServer::~FlashXmlTcpServer()
 {
-    delete tcpServer_;
+    delete impl_;
 }
 
 bool FlashXmlTcpServer::setup( int port )
 {
-    return tcpServer_->setup( port );
+    if( impl_->isRunning() ) {
+        impl_->stop();
+    }
+    bool ok = impl_->start( port );
+
+    if( !ok ) {
+        std::cout << "could not listen for Flash XML clients on TCP port " << port << std::endl;
+    }
+    return ok;
 }
 
 bool FlashXmlTcpServer::isConnected()
 {
-    return tcpServer_->isConnected();
+    return impl_->isRunning();
+}
+
+int FlashXmlTcpServer::getPort()
+{
+    return impl_->isRunning() ? impl_->port() : 0;
 }
 
 bool FlashXmlTcpServer::sendtoAll( const std::string & message )
 {
-    return tcpServer_->sendToAll( message );
+    std::string terminated = message;
+    terminated += (char)0; // for Flash
+    return impl_->sendToAll( terminated.data(), terminated.size() );
+}
+
+bool FlashXmlTcpServer::sendtoAll( const char * data, int size )
+{
+    return size > 0 && impl_->sendToAll( data, (size_t)size );
+}
+
+int FlashXmlTcpServer::getClientCount()
+{
+    return impl_->clientCount();
+}
+
+std::vector<FlashXmlTcpServer::ClientStats> FlashXmlTcpServer::getClientStats()
+{
+    return impl_->clientStats();
+}
+
+bool FlashXmlTcpServer::fullFrameRequested()
+{
+    return impl_->takeFullFrameRequest();
 }
@@ -1,38 +1,32 @@
 /*******************************************************************************
 FlashXmlTcpServer
 
-PURPOSE: Wrapper class for ofxTCPServer class, which was borrowed from 
-         the ofxNetwork module of openFrameworks.  
-         
-NOTES: 
-I had orignally planned to use the TcpSender class of the TUIO_CPP library, 
-which is in the lib/TUIO_CPP/TUIO directory.  However, for unclear reasons, 
-the TcpSender would not intialize (kept getting a return value of false from 
-the isConnected() function).  As I was using ofxTCPServer in another project, 
-I decided to just use that instead.
-
-The ofxTCPServer class along with a few related classes and their support 
-libraries can be found in lib/ofxTCPServer_v0.8.4_VS2013.  These classes were
-extracted from openFrameworks version 0.8.4 (http://openframeworks.cc/download).
-This version of openFrameworks was built for Visual Studio 2012 Express Edition.
-When I first built tried to use ofxTCPServer with Visual Studio 2013 Community 
-Edition, it would compile, but the static libraries it needed (POCO and OpenSSL)
-would not link due to differences in the version of the C/C++ compiler for 
-Visual Studio 2012 and 2013 (Microsoft C/C++ compiler 11.0 versus 12.0).  
-To get around this problem, I had to download the POCO project from
-http://pocoproject.org/index.html and the OpenSSL project from 
-http://www.openssl.org/source, and then build both of them with Visual Studio
-2013 Community Edtion (with C/C++ compiler version 12.0).  These static
-libraries can be found in the lib/ofxTCPServer_v0.8.4_VS2013/libs directory, so
-you should not need to build them.  I did not include the rest of openFrameworks
-version 0.8.4 because there are several other static libraries that would all
-have the same problem (they would work with Visual Studio 2012, but not with
-Visual Studio 2013).
-
-Unfortunately, the POCO and OpenSSL libraries take up a lot of space (over 
-400 MB combined), so if somebody else wants to fix up the TcpSender class 
-of TUIO_CPP and use that instead, that would greatly reduce the size of the
-libraries needed for building.
+PURPOSE: A small TCP server that sends Flash XML frames to every connected
+         client without ever blocking the sender.
+
+NOTES:
+This class used to wrap the ofxTCPServer class from openFrameworks, which
+held its connection lock while it made a blocking send (with a timeout) to
+each client in turn.  One Flash/AIR client that stopped reading froze the
+thread sending TUIO and every other client with it, and ofxTCPServer needed
+the POCO and OpenSSL libraries (over 400 MB) for what is only an accept loop.
+
+All sockets are now non-blocking.  sendtoAll() writes the frame straight to
+each client that is keeping up, so normally nothing is copied or queued.
+Whatever a client's socket buffer cannot take is put in that client's
+output queue, and an event loop on a thread of its own (epoll on Linux,
+select() elsewhere) accepts new clients, finishes queued writes when the
+sockets become writable and notices clients that go away.
+
+A client's queue holds at most MAX_QUEUED_FRAMES frames.  When it is full,
+the frames that have not been started are dropped and only the newest one
+is kept.  A frame that is partly written is always finished first, so a
+client never sees a broken frame.  Since a dropped frame may have carried
+the last position of a cursor, fullFrameRequested() tells the encoder to
+send every cursor in the next frame.
+
+Per-client lag (how long the oldest queued frame has waited) and the sent
+and dropped frame counts are available from getClientStats().
 
 J.R.Weber <joe.weber77@gmail.com>
 *******************************************************************************/
@@ -40,22 +34,70 @@ J.R.Weber <joe.weber77@gmail.com>
 #define INCLUDED_FLASHXMLTCPSERVER_H
 
 #include <string>
-
-class ofxTCPServer;
+#include <vector>
 
 class FlashXmlTcpServer
 {
 public:
+    enum { MAX_QUEUED_FRAMES = 8 };
+
+    struct ClientStats
+    {
+        std::string address;
+        unsigned long framesSent,
+                      framesDropped;
+        unsigned int queuedFrames;
+        long lagMilliseconds,
+             maxLagMilliseconds;
+    };
+
     FlashXmlTcpServer();
+
+    /**
+     * Stops the event loop and closes every connection.
+     */
     ~FlashXmlTcpServer();
 
+    /**
+     * Listens on the port (0 picks a free one) and starts the event loop.
+     */
     bool setup( int port );
     bool isConnected();
+
+    /**
+     * The port being listened on, or 0 before setup().
+     */
+    int getPort();
+
+    /**
+     * Sends the message followed by the NUL character Flash needs.
+     */
     bool sendtoAll( const std::string & message );
-    
+
+    /**
+     * Sends the bytes as they are; a Flash XML message must already end
+     * with its NUL character.
+     *
+     * @return  false if there are no clients.
+     */
+    bool sendtoAll( const char * data, int size );
+
+    int getClientCount();
+    std::vector<ClientStats> getClientStats();
+
+    /**
+     * Returns true, once, if a frame has been dropped for any client since
+     * the last call.
+     */
+    bool fullFrameRequested();
+
 private:
-    ofxTCPServer * tcpServer_;
-    
+    class Implementation;
+
+    FlashXmlTcpServer( const FlashXmlTcpServer & );
+    FlashXmlTcpServer & operator=( const FlashXmlTcpServer & );
+
+    Implementation * impl_;
 };
 
 #endif
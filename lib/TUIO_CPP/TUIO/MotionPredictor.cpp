@@ -0,0 +1,297 @@
+/*******************************************************************************
+MotionPredictor
+
+PURPOSE: Extrapolates each TUIO cursor a few milliseconds ahead.  See the
+         header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "MotionPredictor.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace TUIO;
+
+// Input positions about two pixels off on a 1920 pixel wide screen, and
+// little enough process noise that a pixel of jitter hardly moves the speed.
+// Tuned on the jittery circle of MotionPredictionBench.
+static const double DEFAULT_PROCESS_NOISE = 5.0,
+                    DEFAULT_MEASUREMENT_NOISE = 1e-6,
+                    INITIAL_SPEED_VARIANCE = 1.0;
+
+MotionPredictor::MotionPredictor() :
+  model_( NONE ),
+  horizon_( DEFAULT_HORIZON ),
+  processNoise_( DEFAULT_PROCESS_NOISE ),
+  measurementNoise_( DEFAULT_MEASUREMENT_NOISE ),
+  states_(),
+  predictions_( 0 ),
+  checked_( 0 ),
+  totalOffset_( 0 ),
+  maxOffset_( 0 ),
+  totalError_( 0 ),
+  totalLag_( 0 )
+{
+    states_.reserve( 32 );
+}
+
+void MotionPredictor::setModel( Model model )
+{
+    model_ = model;
+    states_.clear();
+}
+
+const char * MotionPredictor::modelName( Model model )
+{
+    switch( model ) {
+        case CONSTANT_VELOCITY:     return "velocity";
+        case CONSTANT_ACCELERATION: return "acceleration";
+        case KALMAN:                return "kalman";
+        default:                    return "none";
+    }
+}
+
+bool MotionPredictor::parseModel( const std::string & name, Model & model )
+{
+    const Model models[] = { NONE, CONSTANT_VELOCITY, CONSTANT_ACCELERATION, KALMAN };
+
+    for( size_t i = 0; i < sizeof( models ) / sizeof( models[0] ); ++i ) {
+        if( name == modelName( models[i] ) ) {
+            model = models[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void MotionPredictor::setHorizon( unsigned int milliseconds )
+{
+    horizon_ = std::min( milliseconds, (unsigned int)MAX_HORIZON );
+}
+
+void MotionPredictor::setKalmanNoise( double processNoise, double measurementNoise )
+{
+    processNoise_ = processNoise;
+    measurementNoise_ = measurementNoise;
+}
+
+int MotionPredictor::findState( long sessionId ) const
+{
+    for( size_t i = 0; i < states_.size(); ++i ) {
+        if( states_[i].sessionId == sessionId ) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void MotionPredictor::update( const TuioCursor * tcur )
+{
+    if( model_ == NONE ) {
+        return;
+    }
+    int64_t time = tcur->getTuioTime().getTotalMicroseconds();
+    int i = findState( tcur->getSessionID() );
+
+    if( i < 0 ) {
+        State state = State();
+        state.sessionId = tcur->getSessionID();
+        states_.push_back( state );
+        predict( states_.back(), tcur, time, true );
+    }
+    else if( time > states_[i].time ) {
+        predict( states_[i], tcur, time, false );
+    }
+    else {
+        states_[i].seen = true;
+    }
+}
+
+void MotionPredictor::forgetUnseen()
+{
+    for( size_t i = 0; i < states_.size(); ) {
+        if( !states_[i].seen ) {
+            states_[i] = states_.back();
+            states_.pop_back();
+        }
+        else {
+            states_[i++].seen = false;
+        }
+    }
+}
+
+void MotionPredictor::position( const TuioCursor * tcur, float & x, float & y ) const
+{
+    int i = model_ != NONE ? findState( tcur->getSessionID() ) : -1;
+
+    if( i < 0 ) {
+        x = tcur->getX();
+        y = tcur->getY();
+        return;
+    }
+    x = states_[i].predictedX;
+    y = states_[i].predictedY;
+}
+
+/**
+ * A first position is sent as it is: the cursor has no speed yet.  The
+ * acceleration needs two speeds, so the constant acceleration model works
+ * like the constant velocity one for the first move.
+ */
+void MotionPredictor::predict( State & state, const TuioCursor * tcur, int64_t time, bool first )
+{
+    float x = tcur->getX(),
+          y = tcur->getY(),
+          xSpeed = tcur->getXSpeed(),
+          ySpeed = tcur->getYSpeed();
+    double h = horizon_ / 1000.0,
+           dt = first ? 0.0 : (time - state.time) / (double)USEC_SECOND,
+           predictedX = x,
+           predictedY = y;
+
+    if( !first ) {
+        checkPending( state, time, x, y );
+    }
+    switch( model_ ) {
+        case CONSTANT_VELOCITY:
+            predictedX = x + xSpeed * h;
+            predictedY = y + ySpeed * h;
+            break;
+
+        case CONSTANT_ACCELERATION:
+            predictedX = x + xSpeed * h;
+            predictedY = y + ySpeed * h;
+
+            if( !first && state.moved ) {
+                predictedX += 0.5 * (xSpeed - state.xSpeed) / dt * h * h;
+                predictedY += 0.5 * (ySpeed - state.ySpeed) / dt * h * h;
+            }
+            break;
+
+        case KALMAN:
+            if( first ) {
+                Axis axis = { 0.0, 0.0, measurementNoise_, 0.0, INITIAL_SPEED_VARIANCE };
+                state.kalmanX = axis;
+                state.kalmanY = axis;
+                state.kalmanX.p = x;
+                state.kalmanY.p = y;
+            }
+            else {
+                kalmanUpdate( state.kalmanX, x, dt );
+                kalmanUpdate( state.kalmanY, y, dt );
+            }
+            predictedX = state.kalmanX.p + state.kalmanX.v * h;
+            predictedY = state.kalmanY.p + state.kalmanY.v * h;
+            break;
+
+        default:
+            break;
+    }
+    state.predictedX = (float)std::min( std::max( predictedX, 0.0 ), 1.0 );
+    state.predictedY = (float)std::min( std::max( predictedY, 0.0 ), 1.0 );
+    state.seen = true;
+    state.moved = !first;
+    state.time = time;
+    state.x = x;
+    state.y = y;
+    state.xSpeed = xSpeed;
+    state.ySpeed = ySpeed;
+
+    uint64_t offset = (uint64_t)(hypot( state.predictedX - x, state.predictedY - y ) * 1e6 + 0.5);
+    predictions_.fetch_add( 1, std::memory_order_relaxed );
+    totalOffset_.fetch_add( offset, std::memory_order_relaxed );
+
+    if( offset > maxOffset_.load( std::memory_order_relaxed ) ) {
+        maxOffset_.store( offset, std::memory_order_relaxed );
+    }
+    addPending( state, time + horizon_ * 1000L, x, y );
+}
+
+/**
+ * One predict and update step of a constant velocity Kalman filter, with
+ * the process noise of a white noise acceleration.
+ */
+void MotionPredictor::kalmanUpdate( Axis & axis, double z, double dt ) const
+{
+    double q = processNoise_,
+           dt2 = dt * dt;
+
+    axis.p += axis.v * dt;
+    axis.p00 += dt * (2.0 * axis.p01 + dt * axis.p11) + q * dt2 * dt / 3.0;
+    axis.p01 += dt * axis.p11 + q * dt2 / 2.0;
+    axis.p11 += q * dt;
+
+    double s = axis.p00 + measurementNoise_,
+           k0 = axis.p00 / s,
+           k1 = axis.p01 / s,
+           innovation = z - axis.p,
+           p01 = axis.p01;
+
+    axis.p += k0 * innovation;
+    axis.v += k1 * innovation;
+    axis.p00 -= k0 * axis.p00;
+    axis.p01 -= k0 * p01;
+    axis.p11 -= k1 * p01;
+}
+
+/**
+ * Compares the predictions whose target time the input has now passed with
+ * where the input was then, between the last position and this one.
+ */
+void MotionPredictor::checkPending( State & state, int64_t time, float x, float y )
+{
+    while( state.pendingCount > 0 ) {
+        const Pending & pending = state.pending[state.firstPending];
+
+        if( pending.target > time ) {
+            break;
+        }
+        float f = (float)(pending.target - state.time) / (float)(time - state.time),
+              actualX = state.x + f * (x - state.x),
+              actualY = state.y + f * (y - state.y);
+
+        totalError_.fetch_add( (uint64_t)(hypot( pending.x - actualX, pending.y - actualY ) * 1e6 + 0.5),
+                               std::memory_order_relaxed );
+        totalLag_.fetch_add( (uint64_t)(hypot( pending.rawX - actualX, pending.rawY - actualY ) * 1e6 + 0.5),
+                             std::memory_order_relaxed );
+        checked_.fetch_add( 1, std::memory_order_relaxed );
+        state.firstPending = (state.firstPending + 1) % MAX_PENDING;
+        --state.pendingCount;
+    }
+}
+
+/**
+ * If the input comes in faster than MAX_PENDING positions per horizon,
+ * the oldest prediction is never checked.
+ */
+void MotionPredictor::addPending( State & state, int64_t target, float rawX, float rawY )
+{
+    if( state.pendingCount == MAX_PENDING ) {
+        state.firstPending = (state.firstPending + 1) % MAX_PENDING;
+        --state.pendingCount;
+    }
+    Pending & pending = state.pending[(state.firstPending + state.pendingCount) % MAX_PENDING];
+    pending.target = target;
+    pending.x = state.predictedX;
+    pending.y = state.predictedY;
+    pending.rawX = rawX;
+    pending.rawY = rawY;
+    ++state.pendingCount;
+}
+
+MotionPredictor::Stats MotionPredictor::takeStats()
+{
+    Stats stats;
+    stats.predictions = predictions_.exchange( 0 );
+    stats.checked = checked_.exchange( 0 );
+
+    double totalOffset = (double)totalOffset_.exchange( 0 ),
+           totalError = (double)totalError_.exchange( 0 ),
+           totalLag = (double)totalLag_.exchange( 0 );
+
+    stats.averageOffset = stats.predictions > 0 ? totalOffset / 1e6 / stats.predictions : 0.0;
+    stats.maxOffset = maxOffset_.exchange( 0 ) / 1e6;
+    stats.averageError = stats.checked > 0 ? totalError / 1e6 / stats.checked : 0.0;
+    stats.averageLag = stats.checked > 0 ? totalLag / 1e6 / stats.checked : 0.0;
+    return stats;
+}
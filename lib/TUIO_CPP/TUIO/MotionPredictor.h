@@ -0,0 +1,201 @@
+/*******************************************************************************
+MotionPredictor
+
+PURPOSE: Extrapolates each TUIO cursor a few milliseconds ahead, so that a
+         client drawing at 60 Hz shows the finger where it is rather than
+         where it was when the digitizer saw it.
+
+NOTES:
+TuioCursorServer hands every cursor that changed in a frame to update()
+before the frame is encoded, and encodes the position() it gets back.  The
+cursor itself keeps its raw position and speed, and the speeds sent are the
+raw ones.  There are three models:
+
+CONSTANT_VELOCITY      the cursor's own speed (from its last two positions)
+                       times the horizon.
+CONSTANT_ACCELERATION  as above, plus half the change of that speed since
+                       the last update times the horizon squared.  Follows
+                       curves and stops better, but amplifies jitter.
+KALMAN                 a constant velocity Kalman filter per axis, with
+                       white noise acceleration.  Smooths the jitter out of
+                       the speed at the cost of some lag when the finger
+                       turns.  The noise can be tuned with setKalmanNoise().
+
+Predicted positions are clamped to 0..1.  A new cursor is sent where it is
+until it has moved.
+
+How well it works is measured as it goes: every prediction is kept until
+the cursor's input passes its target time, and then compared with the
+input position at that time (interpolated between the two updates either
+side of it).  takeStats() returns the average distance from the raw
+position (the offset), the average error of the predictions, and the
+average lag, which is the error of sending the raw position instead.  All
+distances are in TUIO units (the screen is 1 x 1).
+
+Cursors are kept in a flat array and looked up by session ID; there are
+rarely more than ten of them.  update(), position() and forgetUnseen() are
+called from the thread the server sends on; takeStats() can be called from
+any thread.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_MOTIONPREDICTOR_H
+#define INCLUDED_MOTIONPREDICTOR_H
+
+#include "LibExport.h"
+#include "TuioCursor.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * MotionPredictor predictor;<br/>
+     * predictor.setModel( MotionPredictor::KALMAN );<br/>
+     * predictor.setHorizon( 16 );<br/>
+     * ...<br/>
+     * // each frame, for every active cursor:<br/>
+     * predictor.update( tcur );<br/>
+     * ...<br/>
+     * predictor.forgetUnseen();<br/>
+     * predictor.position( tcur, x, y );<br/>
+     * </code></p>
+     */
+    class LIBDECL MotionPredictor
+    {
+    public:
+        enum Model { NONE,
+                     CONSTANT_VELOCITY,
+                     CONSTANT_ACCELERATION,
+                     KALMAN };
+
+        enum { DEFAULT_HORIZON = 16,
+               MAX_HORIZON = 100 };
+
+        MotionPredictor();
+
+        /**
+         * Changing the model forgets every cursor.
+         */
+        void setModel( Model model );
+        Model model() const { return model_; }
+        bool isEnabled() const { return model_ != NONE; }
+
+        /**
+         * "none", "velocity", "acceleration" or "kalman".
+         */
+        static const char * modelName( Model model );
+
+        /**
+         * @return false if the name is not one of modelName()'s.
+         */
+        static bool parseModel( const std::string & name, Model & model );
+
+        /**
+         * How far ahead to predict, in milliseconds, up to MAX_HORIZON.
+         */
+        void setHorizon( unsigned int milliseconds );
+        unsigned int horizon() const { return horizon_; }
+
+        /**
+         * @param  processNoise      the spectral density of the acceleration,
+         *                           in (TUIO units / s^2)^2 s.
+         * @param  measurementNoise  the variance of an input position, in
+         *                           TUIO units squared.
+         */
+        void setKalmanNoise( double processNoise, double measurementNoise );
+
+        /**
+         * Takes in the cursor's position if it changed since the last call,
+         * and marks the cursor as seen.
+         */
+        void update( const TuioCursor * tcur );
+
+        /**
+         * Forgets the cursors update() was not called for since the last
+         * call.
+         */
+        void forgetUnseen();
+
+        /**
+         * The predicted position of the cursor, or its own position if the
+         * predictor does not know it.
+         */
+        void position( const TuioCursor * tcur, float & x, float & y ) const;
+
+        unsigned int cursorCount() const { return (unsigned int)states_.size(); }
+
+        struct Stats
+        {
+            unsigned long predictions,    // positions predicted
+                          checked;        // of those, compared with the input since
+            double averageOffset,         // from the raw position
+                   maxOffset,
+                   averageError,          // from where the input was at the target time
+                   averageLag;            // of the raw position, from the same
+        };
+
+        /**
+         * @return the stats since the last call.
+         */
+        Stats takeStats();
+
+    private:
+        enum { MAX_PENDING = 16 };
+
+        /**
+         * A prediction waiting for the input to reach its target time.
+         */
+        struct Pending
+        {
+            int64_t target;         // microseconds
+            float x, y,             // predicted
+                  rawX, rawY;
+        };
+
+        struct Axis
+        {
+            double p, v,                 // Kalman state
+                   p00, p01, p11;        // and covariance
+        };
+
+        struct State
+        {
+            long sessionId;
+            bool seen,
+                 moved;             // has a speed of its own
+            int64_t time;           // microseconds, of the last position taken in
+            float x, y,             // that position
+                  xSpeed, ySpeed,   // the cursor's speed then
+                  predictedX, predictedY;
+            Axis kalmanX, kalmanY;
+            Pending pending[MAX_PENDING];
+            unsigned int firstPending,
+                         pendingCount;
+        };
+
+        int findState( long sessionId ) const;
+        void predict( State & state, const TuioCursor * tcur, int64_t time, bool first );
+        void kalmanUpdate( Axis & axis, double z, double dt ) const;
+        void checkPending( State & state, int64_t time, float x, float y );
+        void addPending( State & state, int64_t target, float rawX, float rawY );
+
+        Model model_;
+        unsigned int horizon_;
+        double processNoise_,
+               measurementNoise_;
+        std::vector<State> states_;
+
+        // Distances in millionths of a TUIO unit, so they can be atomic.
+        std::atomic<unsigned long> predictions_,
+                                   checked_;
+        std::atomic<uint64_t> totalOffset_,
+                              maxOffset_,
+                              totalError_,
+                              totalLag_;
+    };
+}
+
+#endif /* INCLUDED_MOTIONPREDICTOR_H */
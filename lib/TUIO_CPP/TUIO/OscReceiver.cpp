@@ -28,13 +28,23 @@ void OscReceiver::ProcessMessage( const ReceivedMessage& msg, const IpEndpointNa
 	for (std::list<TuioClient*>::iterator client=clientList.begin(); client!= clientList.end(); client++)
 		(*client)->processOSC(msg);
 }
+/**
+ * Set messages make up most of a frame; the clients decode those themselves
+ * in one pass, and only the others are parsed into a ReceivedMessage.
+ */
+bool OscReceiver::processSetMessage( const char *data, unsigned long size ) {
+	for (std::list<TuioClient*>::iterator client=clientList.begin(); client!= clientList.end(); client++)
+		if (!(*client)->processSetMessage(data,size)) return false;
+	return true;
+}
+
 void OscReceiver::ProcessBundle( const ReceivedBundle& b, const IpEndpointName& remoteEndpoint) {
 	
 	try {
 		for( ReceivedBundle::const_iterator i = b.ElementsBegin(); i != b.ElementsEnd(); ++i ){
 			if( i->IsBundle() )
 				ProcessBundle( ReceivedBundle(*i), remoteEndpoint);
-			else
+			else if( !processSetMessage( i->Contents(), (unsigned long)i->Size() ) )
 				ProcessMessage( ReceivedMessage(*i), remoteEndpoint);
 		}
 	} catch (MalformedBundleException& e) {
@@ -47,7 +57,7 @@ void OscReceiver::ProcessPacket( const char *data, int size, const IpEndpointNam
 	try {
 		ReceivedPacket p( data, size );
 		if(p.IsBundle()) ProcessBundle( ReceivedBundle(p), remoteEndpoint);
-		else ProcessMessage( ReceivedMessage(p), remoteEndpoint);
+		else if (!processSetMessage(p.Contents(),(unsigned long)p.Size())) ProcessMessage( ReceivedMessage(p), remoteEndpoint);
 	} catch (MalformedBundleException& e) {
 		std::cerr << "malformed OSC bundle: " << e.what() << std::endl;
 	}
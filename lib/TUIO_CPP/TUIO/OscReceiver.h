@@ -93,6 +93,8 @@ namespace TUIO {
 		
 		void ProcessMessage( const osc::ReceivedMessage& message, const IpEndpointName& remoteEndpoint);
 		
+		bool processSetMessage( const char *data, unsigned long size );
+		
 		std::list<TuioClient*> clientList;
 		bool connected;
 	};
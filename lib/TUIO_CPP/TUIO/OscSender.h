@@ -66,6 +66,14 @@ namespace TUIO {
 		 */
 		virtual bool isConnected () = 0;
 
+		/**
+		 * This method returns, once, if the receivers of this OscSender
+		 * have missed bundles and need every cursor in the next one
+		 *
+		 * @return true if the next bundle should carry every cursor
+		 */
+		virtual bool fullFrameRequested () { return false; };
+
 		/**
 		 * This method returns if this OscSender delivers locally
 		 *
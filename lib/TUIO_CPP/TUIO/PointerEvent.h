@@ -0,0 +1,45 @@
+/*******************************************************************************
+PointerEvent
+
+PURPOSE: The plain pointer event (down, update or up) that TouchPipeline takes
+         in, whatever it came from: a window message, the hook's shared-memory
+         ring, a recorded log or a test.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_POINTEREVENT_H
+#define INCLUDED_POINTEREVENT_H
+
+#include <stdint.h>
+
+namespace TUIO
+{
+    /**
+     * The same values as the TOUCHHOOK_POINTER_* event types of the hook.
+     */
+    enum PointerEventType { POINTER_DOWN = 1,
+                            POINTER_UPDATE = 2,
+                            POINTER_UP = 3 };
+
+    /**
+     * The same values as the Windows POINTER_INPUT_TYPE (PT_TOUCH, ...).
+     */
+    enum PointerInputType { POINTER_INPUT_UNKNOWN = 0,
+                            POINTER_INPUT_GENERIC = 1,
+                            POINTER_INPUT_TOUCH = 2,
+                            POINTER_INPUT_PEN = 3,
+                            POINTER_INPUT_MOUSE = 4,
+                            POINTER_INPUT_TOUCHPAD = 5 };
+
+    struct PointerEvent
+    {
+        unsigned int id;         // the pointer id
+        int type;                // a PointerEventType
+        int pointerType;         // a PointerInputType
+        int x,                   // screen pixels, not yet scaled
+            y;
+        int64_t timestamp;       // when the input happened, in ticks of the source's clock; 0 if unknown
+    };
+}
+
+#endif /* INCLUDED_POINTEREVENT_H */
@@ -0,0 +1,238 @@
+/*******************************************************************************
+PointerEventLog
+
+PURPOSE: Writes and reads compact binary logs of raw pointer events.  See the
+         header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "PointerEventLog.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+
+using namespace TUIO;
+
+const char PointerEventLog::MAGIC[8] = { 'T', 'U', 'I', 'O', 'P', 'T', 'R', 'S' };
+const uint32_t PointerEventLog::VERSION = 1;
+
+PointerEventRecorder::PointerEventRecorder() :
+  file_( NULL ),
+  buffer_(),
+  recordCount_( 0 )
+{
+}
+
+PointerEventRecorder::~PointerEventRecorder()
+{
+    close();
+}
+
+bool PointerEventRecorder::open( const char * path, const PointerEventLogHeader & header )
+{
+    close();
+    file_ = fopen( path, "wb" );
+
+    if( file_ == NULL ) {
+        return false;
+    }
+    PointerEventLogHeader h = header;
+    memcpy( h.magic, PointerEventLog::MAGIC, sizeof( h.magic ) );
+    h.version = PointerEventLog::VERSION;
+    h.recordSize = sizeof( PointerEventRecord );
+
+    if( fwrite( &h, sizeof( h ), 1, file_ ) != 1 ) {
+        fclose( file_ );
+        file_ = NULL;
+        return false;
+    }
+    buffer_.reserve( BUFFER_RECORDS );
+    recordCount_ = 0;
+    return true;
+}
+
+void PointerEventRecorder::close()
+{
+    if( file_ == NULL ) {
+        return;
+    }
+    flush();
+
+    if( file_ != NULL ) {
+        fclose( file_ );
+        file_ = NULL;
+    }
+}
+
+void PointerEventRecorder::record( PointerEventType type, unsigned int pointerId, unsigned int frameId,
+                                   int x, int y, int64_t timestamp, int pointerType )
+{
+    if( file_ == NULL ) {
+        return;
+    }
+    PointerEventRecord event;
+    event.timestamp = timestamp;
+    event.pointerId = pointerId;
+    event.frameId = frameId;
+    event.x = x;
+    event.y = y;
+    event.eventType = (uint32_t)type;
+    event.pointerType = (uint32_t)pointerType;
+    buffer_.push_back( event );
+    ++recordCount_;
+
+    if( buffer_.size() >= BUFFER_RECORDS ) {
+        flush();
+    }
+}
+
+bool PointerEventRecorder::flush()
+{
+    if( file_ == NULL ) {
+        return false;
+    }
+    bool written = buffer_.empty()
+                   || fwrite( &buffer_[0], sizeof( PointerEventRecord ), buffer_.size(), file_ ) == buffer_.size();
+    buffer_.clear();
+
+    if( !written || fflush( file_ ) != 0 ) {
+        fclose( file_ );
+        file_ = NULL;
+        return false;
+    }
+    return true;
+}
+
+PointerEventLog::PointerEventLog() :
+  data_( NULL ),
+  dataSize_( 0 ),
+  header_( NULL ),
+  records_( NULL ),
+  size_( 0 ),
+  error_(),
+  file_( NULL ),
+  mapping_( NULL )
+{
+}
+
+PointerEventLog::~PointerEventLog()
+{
+    close();
+}
+
+bool PointerEventLog::open( const char * path )
+{
+    close();
+
+#ifdef WIN32
+    HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                               FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    LARGE_INTEGER fileSize;
+
+    if( file == INVALID_HANDLE_VALUE ) {
+        return fail( std::string( "cannot open " ) + path );
+    }
+    file_ = file;
+
+    if( !GetFileSizeEx( file, &fileSize ) ) {
+        return fail( std::string( "cannot read the size of " ) + path );
+    }
+    dataSize_ = (std::size_t)fileSize.QuadPart;
+
+    if( dataSize_ < sizeof( PointerEventLogHeader ) ) {
+        return fail( std::string( path ) + " is too short for a pointer event log" );
+    }
+    mapping_ = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+
+    if( mapping_ == NULL ) {
+        return fail( std::string( "cannot map " ) + path );
+    }
+    data_ = (const char *)MapViewOfFile( (HANDLE)mapping_, FILE_MAP_READ, 0, 0, 0 );
+
+    if( data_ == NULL ) {
+        return fail( std::string( "cannot map " ) + path );
+    }
+#else
+    int fd = ::open( path, O_RDONLY );
+    struct stat status;
+
+    if( fd < 0 ) {
+        return fail( std::string( "cannot open " ) + path );
+    }
+    if( fstat( fd, &status ) != 0 ) {
+        ::close( fd );
+        return fail( std::string( "cannot read the size of " ) + path );
+    }
+    dataSize_ = (std::size_t)status.st_size;
+
+    if( dataSize_ < sizeof( PointerEventLogHeader ) ) {
+        ::close( fd );
+        return fail( std::string( path ) + " is too short for a pointer event log" );
+    }
+    void * data = mmap( NULL, dataSize_, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd ); // the mapping keeps the file open
+
+    if( data == MAP_FAILED ) {
+        return fail( std::string( "cannot map " ) + path );
+    }
+    data_ = (const char *)data;
+#ifdef MADV_SEQUENTIAL
+    madvise( data, dataSize_, MADV_SEQUENTIAL );
+#endif
+#endif
+    header_ = (const PointerEventLogHeader *)data_;
+
+    if( memcmp( header_->magic, MAGIC, sizeof( MAGIC ) ) != 0 ) {
+        return fail( std::string( path ) + " is not a pointer event log" );
+    }
+    if( header_->version != VERSION || header_->recordSize != sizeof( PointerEventRecord ) ) {
+        return fail( std::string( path ) + " was written by an unsupported version" );
+    }
+    if( header_->ticksPerSecond <= 0 ) {
+        return fail( std::string( path ) + " has no timestamp frequency" );
+    }
+    records_ = (const PointerEventRecord *)(data_ + sizeof( PointerEventLogHeader ));
+    size_ = (dataSize_ - sizeof( PointerEventLogHeader )) / sizeof( PointerEventRecord );
+    return true;
+}
+
+void PointerEventLog::close()
+{
+#ifdef WIN32
+    if( data_ != NULL ) {
+        UnmapViewOfFile( data_ );
+    }
+    if( mapping_ != NULL ) {
+        CloseHandle( (HANDLE)mapping_ );
+    }
+    if( file_ != NULL ) {
+        CloseHandle( (HANDLE)file_ );
+    }
+#else
+    if( data_ != NULL ) {
+        munmap( (void *)data_, dataSize_ );
+    }
+#endif
+    data_ = NULL;
+    dataSize_ = 0;
+    header_ = NULL;
+    records_ = NULL;
+    size_ = 0;
+    file_ = NULL;
+    mapping_ = NULL;
+}
+
+bool PointerEventLog::fail( const std::string & error )
+{
+    close();
+    error_ = error;
+    return false;
+}
@@ -0,0 +1,178 @@
+/*******************************************************************************
+PointerEventLog
+
+PURPOSE: Writes and reads compact binary logs of raw pointer events (down,
+         update, up), so that a touch workload recorded on a live machine can
+         be replayed later, on any platform, as often as needed.
+
+NOTES:
+A log is one PointerEventLogHeader followed by PointerEventRecords, all in
+the byte order of the recording machine (little-endian on every platform
+TouchHooks2Tuio runs on).  Every field has a fixed width, so 32-bit and
+64-bit builds read the same files.
+
+The records hold what the hook saw: the pointer id, the input frame id (0 if
+unknown), the unscaled screen coordinates and the timestamp of the input in
+ticks of a high-resolution clock.  The header says how many ticks there are
+per second and what screen geometry the coordinates were scaled against, so
+a replayer can map them to TUIO coordinates exactly as the live program did.
+
+PointerEventRecorder appends records to a memory buffer and writes it to the
+file in large blocks, so recording costs a copy per event.  PointerEventLog
+maps a whole log into memory read-only and hands out the records in place.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_POINTEREVENTLOG_H
+#define INCLUDED_POINTEREVENTLOG_H
+
+#include "LibExport.h"
+#include "PointerEvent.h"
+#include <stdint.h>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace TUIO
+{
+    struct PointerEventLogHeader
+    {
+        char magic[8];           // "TUIOPTRS"
+        uint32_t version;
+        uint32_t recordSize;     // sizeof( PointerEventRecord )
+        int64_t ticksPerSecond;  // of the record timestamps
+        int32_t screenX,
+                screenY,
+                screenWidth,
+                screenHeight;
+        uint32_t mirroredMonitors;
+        uint32_t reserved;
+    };
+
+    struct PointerEventRecord
+    {
+        int64_t timestamp;       // in ticks
+        uint32_t pointerId;
+        uint32_t frameId;        // the input frame the event belongs to, or 0
+        int32_t x,               // screen pixels, not yet scaled
+                y;
+        uint32_t eventType;      // a PointerEventType
+        uint32_t pointerType;    // a PointerInputType; 0 in older logs
+    };
+
+    /**
+     * <p><code>
+     * PointerEventRecorder recorder;<br/>
+     * recorder.open( "touches.ptrlog", header );<br/>
+     * recorder.record( POINTER_DOWN, pointerId, frameId, x, y, timestamp );<br/>
+     * ...<br/>
+     * recorder.close();<br/>
+     * </code></p>
+     */
+    class LIBDECL PointerEventRecorder
+    {
+    public:
+        enum { BUFFER_RECORDS = 4096 };
+
+        PointerEventRecorder();
+
+        /**
+         * Writes what is still buffered and closes the file.
+         */
+        ~PointerEventRecorder();
+
+        /**
+         * Creates (or truncates) the log file and writes the header.  The
+         * magic, version and recordSize fields are filled in here.
+         *
+         * @return false if the file could not be created.
+         */
+        bool open( const char * path, const PointerEventLogHeader & header );
+
+        void close();
+
+        bool isOpen() const { return file_ != NULL; }
+
+        void record( PointerEventType type, unsigned int pointerId, unsigned int frameId,
+                     int x, int y, int64_t timestamp, int pointerType = POINTER_INPUT_UNKNOWN );
+
+        /**
+         * Writes the buffered records to the file.
+         *
+         * @return false if the file could not be written; the recorder is
+         *         then closed.
+         */
+        bool flush();
+
+        unsigned long recordCount() const { return recordCount_; }
+
+    private:
+        PointerEventRecorder( const PointerEventRecorder & );
+        PointerEventRecorder & operator=( const PointerEventRecorder & );
+
+        FILE * file_;
+        std::vector<PointerEventRecord> buffer_;
+        unsigned long recordCount_;
+    };
+
+    /**
+     * <p><code>
+     * PointerEventLog log;<br/>
+     * if( log.open( "touches.ptrlog" ) ) {<br/>
+     * &nbsp;&nbsp;for( size_t i = 0; i < log.size(); ++i ) {<br/>
+     * &nbsp;&nbsp;&nbsp;&nbsp;const PointerEventRecord & event = log[i];<br/>
+     * &nbsp;&nbsp;&nbsp;&nbsp;...<br/>
+     * </code></p>
+     */
+    class LIBDECL PointerEventLog
+    {
+    public:
+        static const char MAGIC[8];
+        static const uint32_t VERSION;
+
+        PointerEventLog();
+        ~PointerEventLog();
+
+        /**
+         * Maps the log into memory.  A trailing partial record (from a
+         * recording that was cut short) is ignored.
+         *
+         * @return false if the file cannot be mapped or is not a pointer
+         *         event log; error() then says why.
+         */
+        bool open( const char * path );
+
+        void close();
+
+        const PointerEventLogHeader & header() const { return *header_; }
+        std::size_t size() const { return size_; }
+        const PointerEventRecord & operator[]( std::size_t i ) const { return records_[i]; }
+        const PointerEventRecord * begin() const { return records_; }
+        const PointerEventRecord * end() const { return records_ + size_; }
+
+        /**
+         * Converts a span of record timestamps to seconds.
+         */
+        double seconds( int64_t ticks ) const { return (double)ticks / header_->ticksPerSecond; }
+
+        const std::string & error() const { return error_; }
+
+    private:
+        PointerEventLog( const PointerEventLog & );
+        PointerEventLog & operator=( const PointerEventLog & );
+
+        bool fail( const std::string & error );
+
+        const char * data_;
+        std::size_t dataSize_;
+        const PointerEventLogHeader * header_;
+        const PointerEventRecord * records_;
+        std::size_t size_;
+        std::string error_;
+        void * file_,
+             * mapping_;
+    };
+}
+
+#endif /* INCLUDED_POINTEREVENTLOG_H */
@@ -0,0 +1,330 @@
+/*******************************************************************************
+SharedRingBuffer
+
+PURPOSE: Fixed-size, lock-free, multi-producer/single-consumer ring buffer that
+         can be placed in named shared memory (a Windows file mapping or a
+         POSIX mmap region) and used by several processes at once.
+
+NOTES:
+The TouchHook DLL is loaded into every process that receives touch input, so
+each of those processes is a producer, while the TouchHooks2Tuio program is
+the single consumer.  The queue follows Dmitry Vyukov's bounded queue: every
+cell carries a sequence number, producers claim a position with one
+compare-and-swap on the enqueue index and then publish the cell by bumping
+its sequence, and the consumer only ever touches the dequeue index.  No
+locks are taken, so a stalled consumer can never block a hooked process;
+when the ring is full the record is dropped and counted instead.
+
+The class has no constructor on purpose.  It is laid out with fixed-width
+fields only, so that 32-bit and 64-bit processes agree on its layout, and it
+must be initialized exactly once by the process that creates the shared
+memory (see initialize()).  Other processes just check isInitialized().
+
+A producer that dies between claiming a cell and publishing it will leave
+that cell unpublished, and the consumer will stop at it.  The consumer can
+detect this with isStalled() and, once the same position (headPosition())
+has stayed stalled for longer than any live producer could take, skip it
+with skipStalledCell().  The skip and the publish both compare-and-swap
+the cell's sequence number from the claimed position, so only one of them
+wins: a producer that was only slow, and publishes after its cell was
+skipped, has its record dropped and counted instead of taking the cell
+back from the ring.  (Its copy into the cell may still land on a record
+written there after the ring wrapped around, which is why the consumer
+must wait well beyond the few hundred nanoseconds a copy takes.)
+
+The wakeup flag lets the consumer sleep while the ring is empty: it calls
+armWakeup() before waiting and drains again afterwards, and the first
+producer that sees claimWakeup() return true is the one that should signal
+the consumer (one signal per burst instead of one per record).
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_SHAREDRINGBUFFER_H
+#define INCLUDED_SHAREDRINGBUFFER_H
+
+#include <atomic>
+#include <cstring>
+
+#ifdef _MSC_VER
+typedef unsigned __int32 ring_uint32_t;
+typedef __int32 ring_int32_t;
+#else
+#include <stdint.h>
+typedef uint32_t ring_uint32_t;
+typedef int32_t ring_int32_t;
+#endif
+
+#define SHARED_RING_MAGIC 0x54485242  // "THRB"
+#define SHARED_RING_CACHE_LINE 64
+
+namespace TUIO
+{
+    /**
+     * <p>A bounded, lock-free, multi-producer/single-consumer queue of
+     * trivially copyable records that lives in a single block of (usually
+     * shared) memory.  The Capacity must be a power of two.</p>
+     *
+     * <p><code>
+     * void * memory = ...map sizeof(SharedRingBuffer<Record, 4096>) bytes...;<br/>
+     * SharedRingBuffer<Record, 4096> * ring = (SharedRingBuffer<Record, 4096> *)memory;<br/>
+     * ring->initialize(); // creator only<br/>
+     * ...<br/>
+     * ring->tryPush( record );  // any producer process<br/>
+     * ...<br/>
+     * unsigned int n = ring->tryPopBatch( records, 64 ); // the consumer<br/>
+     * </code></p>
+     */
+    template<typename T, unsigned int Capacity>
+    class SharedRingBuffer
+    {
+    public:
+        static_assert( Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                       "SharedRingBuffer capacity must be a power of two" );
+
+        enum { CAPACITY = Capacity, MASK = Capacity - 1 };
+
+        /**
+         * Resets all indices and cell sequence numbers.  Must be called once,
+         * by the creator of the memory block, before any producer attaches.
+         * Returns false if the atomics used here would not be lock-free,
+         * in which case the ring cannot be shared between processes.
+         */
+        bool initialize()
+        {
+            if( !enqueuePos_.is_lock_free() ) {
+                return false;
+            }
+            magic_.store( 0, std::memory_order_relaxed );
+            capacity_ = Capacity;
+            recordSize_ = sizeof( T );
+            enqueuePos_.store( 0, std::memory_order_relaxed );
+            dequeuePos_.store( 0, std::memory_order_relaxed );
+            dropped_.store( 0, std::memory_order_relaxed );
+            pushed_.store( 0, std::memory_order_relaxed );
+            wakeupArmed_.store( 0, std::memory_order_relaxed );
+
+            for( ring_uint32_t i = 0; i < Capacity; ++i ) {
+                cells_[i].sequence.store( i, std::memory_order_relaxed );
+            }
+            magic_.store( SHARED_RING_MAGIC, std::memory_order_release );
+            return true;
+        }
+
+        /**
+         * Returns true if the ring was initialized with the same capacity
+         * and record size that this process was compiled with.
+         */
+        bool isInitialized() const
+        {
+            return magic_.load( std::memory_order_acquire ) == SHARED_RING_MAGIC
+                && capacity_ == Capacity
+                && recordSize_ == sizeof( T );
+        }
+
+        /**
+         * Producer side.  Copies the record into the next free cell.
+         * Returns false (and counts a drop) if the ring is full, or if the
+         * consumer skipped the cell before the record was published.
+         */
+        bool tryPush( const T & item )
+        {
+            Cell * cell = 0;
+            ring_uint32_t pos = enqueuePos_.load( std::memory_order_relaxed );
+
+            for( ;; ) {
+                cell = &cells_[pos & MASK];
+                ring_uint32_t seq = cell->sequence.load( std::memory_order_acquire );
+                ring_int32_t diff = (ring_int32_t)(seq - pos);
+
+                if( diff == 0 ) {
+                    if( enqueuePos_.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) ) {
+                        break;
+                    }
+                }
+                else if( diff < 0 ) {
+                    dropped_.fetch_add( 1, std::memory_order_relaxed );
+                    return false;
+                }
+                else {
+                    pos = enqueuePos_.load( std::memory_order_relaxed );
+                }
+            }
+            std::memcpy( &cell->data, &item, sizeof( T ) );
+
+            // fails only if the consumer gave up on the cell meanwhile
+            ring_uint32_t claimed = pos;
+
+            if( !cell->sequence.compare_exchange_strong( claimed, pos + 1, std::memory_order_release,
+                                                         std::memory_order_relaxed ) ) {
+                dropped_.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+            pushed_.fetch_add( 1, std::memory_order_relaxed );
+            return true;
+        }
+
+        /**
+         * Consumer side.  Moves the oldest published record into item.
+         * Returns false if nothing is ready.
+         */
+        bool tryPop( T & item )
+        {
+            ring_uint32_t pos = dequeuePos_.load( std::memory_order_relaxed );
+            Cell * cell = &cells_[pos & MASK];
+            ring_uint32_t seq = cell->sequence.load( std::memory_order_acquire );
+
+            if( (ring_int32_t)(seq - (pos + 1)) < 0 ) {
+                return false;
+            }
+            std::memcpy( &item, &cell->data, sizeof( T ) );
+            cell->sequence.store( pos + Capacity, std::memory_order_release );
+            dequeuePos_.store( pos + 1, std::memory_order_relaxed );
+            return true;
+        }
+
+        /**
+         * Consumer side.  Pops up to maxItems records in order and returns
+         * how many were copied into items.
+         */
+        unsigned int tryPopBatch( T * items, unsigned int maxItems )
+        {
+            unsigned int count = 0;
+            ring_uint32_t pos = dequeuePos_.load( std::memory_order_relaxed );
+
+            while( count < maxItems ) {
+                Cell * cell = &cells_[pos & MASK];
+                ring_uint32_t seq = cell->sequence.load( std::memory_order_acquire );
+
+                if( (ring_int32_t)(seq - (pos + 1)) < 0 ) {
+                    break;
+                }
+                std::memcpy( &items[count], &cell->data, sizeof( T ) );
+                cell->sequence.store( pos + Capacity, std::memory_order_release );
+                ++pos;
+                ++count;
+            }
+            dequeuePos_.store( pos, std::memory_order_relaxed );
+            return count;
+        }
+
+        /**
+         * Consumer side.  Returns true if a producer has claimed the next
+         * cell but not yet published it, while later cells are claimed too.
+         * A true result that persists over time means that producer died.
+         */
+        bool isStalled() const
+        {
+            ring_uint32_t pos = dequeuePos_.load( std::memory_order_relaxed );
+            ring_uint32_t seq = cells_[pos & MASK].sequence.load( std::memory_order_acquire );
+            return seq == pos && enqueuePos_.load( std::memory_order_relaxed ) != pos;
+        }
+
+        /**
+         * Consumer side.  The position of the next record to pop, which is
+         * the stalled one while isStalled() is true.
+         */
+        ring_uint32_t headPosition() const
+        {
+            return dequeuePos_.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * Consumer side.  Gives up on the unpublished cell at pos, which
+         * must be the headPosition() seen stalled (see isStalled()).
+         * Returns false, and skips nothing, if the consumer has moved on or
+         * the producer published the record after all.
+         */
+        bool skipStalledCell( ring_uint32_t pos )
+        {
+            // an unclaimed cell must stay free for the producer that claims it
+            if( dequeuePos_.load( std::memory_order_relaxed ) != pos
+                || enqueuePos_.load( std::memory_order_relaxed ) == pos ) {
+                return false;
+            }
+            ring_uint32_t claimed = pos;
+
+            if( !cells_[pos & MASK].sequence.compare_exchange_strong( claimed, pos + Capacity,
+                                                                      std::memory_order_acq_rel,
+                                                                      std::memory_order_relaxed ) ) {
+                return false;
+            }
+            dequeuePos_.store( pos + 1, std::memory_order_relaxed );
+            dropped_.fetch_add( 1, std::memory_order_relaxed );
+            return true;
+        }
+
+        /**
+         * Consumer side.  Asks the next producer to signal the consumer.
+         * Always drain the ring once more after arming, since a record may
+         * have been pushed just before the flag was set.
+         */
+        void armWakeup()
+        {
+            wakeupArmed_.store( 1, std::memory_order_seq_cst );
+        }
+
+        /**
+         * Producer side.  Returns true for exactly one producer after the
+         * consumer armed the wakeup, so only that producer signals it.
+         */
+        bool claimWakeup()
+        {
+            if( wakeupArmed_.load( std::memory_order_relaxed ) == 0 ) {
+                return false;
+            }
+            return wakeupArmed_.exchange( 0, std::memory_order_seq_cst ) != 0;
+        }
+
+        /**
+         * Returns the approximate number of records waiting in the ring.
+         */
+        unsigned int size() const
+        {
+            ring_uint32_t head = dequeuePos_.load( std::memory_order_relaxed ),
+                          tail = enqueuePos_.load( std::memory_order_relaxed );
+            return (unsigned int)(tail - head);
+        }
+
+        /**
+         * Returns the number of records dropped because the ring was full
+         * or their cell was skipped.
+         */
+        unsigned int droppedCount() const
+        {
+            return dropped_.load( std::memory_order_relaxed );
+        }
+
+        /**
+         * Returns the number of records successfully pushed.
+         */
+        unsigned int pushedCount() const
+        {
+            return pushed_.load( std::memory_order_relaxed );
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<ring_uint32_t> sequence;
+            T data;
+        };
+
+        std::atomic<ring_uint32_t> magic_;
+        ring_uint32_t capacity_;
+        ring_uint32_t recordSize_;
+        char pad0_[SHARED_RING_CACHE_LINE - 3 * sizeof( ring_uint32_t )];
+
+        std::atomic<ring_uint32_t> enqueuePos_;
+        std::atomic<ring_uint32_t> pushed_;
+        std::atomic<ring_uint32_t> dropped_;
+        char pad1_[SHARED_RING_CACHE_LINE - 3 * sizeof( ring_uint32_t )];
+
+        std::atomic<ring_uint32_t> dequeuePos_;
+        std::atomic<ring_uint32_t> wakeupArmed_;
+        char pad2_[SHARED_RING_CACHE_LINE - 2 * sizeof( ring_uint32_t )];
+
+        Cell cells_[Capacity];
+    };
+}
+
+#endif /* INCLUDED_SHAREDRINGBUFFER_H */
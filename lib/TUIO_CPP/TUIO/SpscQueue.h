@@ -0,0 +1,128 @@
+/*******************************************************************************
+SpscQueue
+
+PURPOSE: Fixed-size, lock-free, single-producer/single-consumer queue for
+         handing records from one thread to another.
+
+NOTES:
+The producer only writes the tail index and the consumer only writes the head
+index, so neither side ever waits on the other.  Each side also keeps a
+private copy of the other side's index and only reloads it when the queue
+looks full (producer) or empty (consumer), which keeps the shared cache lines
+from bouncing between cores on every record.
+
+Used by TuioCursorOutputThread to move cursor changes from the Qt GUI thread
+to the thread that encodes and sends TUIO messages.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_SPSCQUEUE_H
+#define INCLUDED_SPSCQUEUE_H
+
+#include <atomic>
+
+#define SPSC_QUEUE_CACHE_LINE 64
+
+namespace TUIO
+{
+    /**
+     * <p>A bounded, lock-free queue for exactly one producer thread and one
+     * consumer thread.  The Capacity must be a power of two.</p>
+     *
+     * <p><code>
+     * SpscQueue<Record, 1024> queue;<br/>
+     * queue.tryPush( record ); // producer thread only<br/>
+     * ...<br/>
+     * while( queue.tryPop( record ) ) { ... } // consumer thread only<br/>
+     * </code></p>
+     */
+    template<typename T, unsigned int Capacity>
+    class SpscQueue
+    {
+    public:
+        static_assert( Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                       "SpscQueue capacity must be a power of two" );
+
+        enum { CAPACITY = Capacity, MASK = Capacity - 1 };
+
+        SpscQueue() :
+          head_( 0 ),
+          cachedTail_( 0 ),
+          tail_( 0 ),
+          cachedHead_( 0 )
+        {
+        }
+
+        /**
+         * Producer side.  Returns false if the queue is full.
+         */
+        bool tryPush( const T & item )
+        {
+            unsigned int tail = tail_.load( std::memory_order_relaxed );
+
+            if( tail - cachedHead_ == Capacity ) {
+                cachedHead_ = head_.load( std::memory_order_acquire );
+
+                if( tail - cachedHead_ == Capacity ) {
+                    return false;
+                }
+            }
+            items_[tail & MASK] = item;
+            tail_.store( tail + 1, std::memory_order_release );
+            return true;
+        }
+
+        /**
+         * Consumer side.  Returns false if the queue is empty.
+         */
+        bool tryPop( T & item )
+        {
+            unsigned int head = head_.load( std::memory_order_relaxed );
+
+            if( head == cachedTail_ ) {
+                cachedTail_ = tail_.load( std::memory_order_acquire );
+
+                if( head == cachedTail_ ) {
+                    return false;
+                }
+            }
+            item = items_[head & MASK];
+            head_.store( head + 1, std::memory_order_release );
+            return true;
+        }
+
+        /**
+         * Returns the number of records waiting.  Exact when called from
+         * either end; approximate from any other thread.
+         */
+        unsigned int size() const
+        {
+            unsigned int tail = tail_.load( std::memory_order_acquire ),
+                         head = head_.load( std::memory_order_acquire );
+            return tail - head;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+    private:
+        SpscQueue( const SpscQueue & );
+        SpscQueue & operator=( const SpscQueue & );
+
+        // consumer's cache line
+        std::atomic<unsigned int> head_;
+        unsigned int cachedTail_;
+        char pad0_[SPSC_QUEUE_CACHE_LINE - 2 * sizeof( unsigned int )];
+
+        // producer's cache line
+        std::atomic<unsigned int> tail_;
+        unsigned int cachedHead_;
+        char pad1_[SPSC_QUEUE_CACHE_LINE - 2 * sizeof( unsigned int )];
+
+        T items_[Capacity];
+    };
+}
+
+#endif /* INCLUDED_SPSCQUEUE_H */
@@ -41,7 +41,6 @@ static DWORD WINAPI ClientThreadFunc( LPVOID obj )
 {
 	TcpReceiver *sender = static_cast<TcpReceiver*>(obj);
 	char data_buffer[MAX_TCP_SIZE+4];
-	char data_size[4];
 	
 #ifdef WIN32
 	SOCKET client = sender->tcp_client_list.back();
@@ -49,23 +48,32 @@ static DWORD WINAPI ClientThreadFunc( LPVOID obj )
 	int client = sender->tcp_client_list.back();
 #endif
 	
-	int bytes = 1;
-	while (bytes) {
-		bytes = recv(client, data_buffer, sizeof(data_buffer),0);
+	// TCP is a byte stream: one recv() may hold several packets or only part
+	// of one, so bytes are collected until a whole length-prefixed packet
+	// has arrived.
+	int filled = 0;
+	bool receiving = true;
+	while (receiving) {
+		int bytes = recv(client, data_buffer+filled, sizeof(data_buffer)-filled,0);
+		if (bytes<=0) break;
+		filled += bytes;
 
-		if (bytes>=4) {
-			memcpy(&data_size[0],&data_buffer[0], 4);
-#ifdef OSC_HOST_LITTLE_ENDIAN             
-			int32_t temp = *((int32_t*)data_size);
-			data_size[0] =  temp>>24;
-			data_size[1] = (temp>>16) & 255;
-			data_size[2] = (temp>>8) & 255;
-			data_size[3] = (temp) & 255;
-#endif
-			int32_t size = *((int32_t*)data_size);
-			if (size+4==bytes) {
-				sender->ProcessPacket(&data_buffer[4],(int)size,IpEndpointName());
+		int start = 0;
+		while (filled-start>=4) {
+			const unsigned char *data_size = (const unsigned char*)&data_buffer[start];
+			int32_t size = (int32_t)(((unsigned int)data_size[0]<<24) | (data_size[1]<<16) | (data_size[2]<<8) | data_size[3]);
+			if (size<0 || size>MAX_TCP_SIZE) {
+				std::cerr << "invalid TUIO/TCP packet size " << size << std::endl;
+				receiving = false;
+				break;
 			}
+			if (filled-start<size+4) break;
+			sender->ProcessPacket(&data_buffer[start+4],(int)size,IpEndpointName());
+			start += size+4;
+		}
+		if (start>0) {
+			memmove(&data_buffer[0],&data_buffer[start],filled-start);
+			filled -= start;
 		}
 	}
 	
@@ -22,134 +22,624 @@
 
 #include "TcpSender.h"
 
-#ifdef  WIN32
-#ifndef int32_t
-typedef DWORD int32_t;
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
 #endif
+#if defined( __linux__ ) && !defined( TUIO_NO_EPOLL )
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define TUIO_USE_EPOLL
 #endif
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace TUIO;
 
-#ifndef  WIN32
-static void* ClientThreadFunc( void* obj )
+#ifdef WIN32
+typedef SOCKET SocketHandle;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static void closeSocket( SocketHandle s ) { closesocket( s ); }
+
+static void setNonBlocking( SocketHandle s )
+{
+    u_long on = 1;
+    ioctlsocket( s, FIONBIO, &on );
+}
+
+/**
+ * Sends the length and the data with one call.
+ *
+ * @return  the number of bytes sent, or -1.
+ */
+static int sendGathered( SocketHandle s, const char *header, unsigned int headerSize,
+                         const char *data, unsigned int size )
+{
+    WSABUF buffers[2];
+    buffers[0].buf = (char *)header;
+    buffers[0].len = headerSize;
+    buffers[1].buf = (char *)data;
+    buffers[1].len = size;
+    DWORD sent = 0;
+
+    if( WSASend( s, buffers, 2, &sent, 0, NULL, NULL ) != 0 ) {
+        return -1;
+    }
+    return (int)sent;
+}
 #else
-static DWORD WINAPI ClientThreadFunc( LPVOID obj )
+typedef int SocketHandle;
+static const SocketHandle NO_SOCKET = -1;
+static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+static void closeSocket( SocketHandle s ) { close( s ); }
+
+static void setNonBlocking( SocketHandle s )
+{
+    fcntl( s, F_SETFL, fcntl( s, F_GETFL, 0 ) | O_NONBLOCK );
+}
+
+static int sendGathered( SocketHandle s, const char *header, unsigned int headerSize,
+                         const char *data, unsigned int size )
+{
+    struct iovec buffers[2];
+    buffers[0].iov_base = (void *)header;
+    buffers[0].iov_len = headerSize;
+    buffers[1].iov_base = (void *)data;
+    buffers[1].iov_len = size;
+
+    struct msghdr message;
+    memset( &message, 0, sizeof( message ) );
+    message.msg_iov = buffers;
+    message.msg_iovlen = 2;
+#ifdef MSG_NOSIGNAL
+    return (int)sendmsg( s, &message, MSG_NOSIGNAL ); // a closed client must not raise SIGPIPE
+#else
+    return (int)sendmsg( s, &message, 0 );
+#endif
+}
 #endif
+
+/**
+ * One connection and the bytes it has not been able to take yet.
+ */
+struct TcpConnection
 {
-    TcpSender *sender = static_cast<TcpSender*>(obj);
-    char buf[16];
+    SocketHandle socket;
+    std::vector<char> backlog;
+    size_t backlogOffset;
+    bool closed;
+};
 
-#ifdef WIN32
-    SOCKET client = sender->tcp_client_list.back();
+/**
+ * The sockets, the connections and the event loop, kept here so the header
+ * file does not need the platform's socket headers.
+ */
+class TcpSender::Implementation
+{
+public:
+    Implementation() :
+      networkInitializer_(),
+      listener_( NO_SOCKET ),
+      wake_( NO_SOCKET ),
+#ifdef TUIO_USE_EPOLL
+      poll_( -1 ),
 #else
-    int client = sender->tcp_client_list.back();
+      wakeSender_( NO_SOCKET ),
 #endif
+      port_( 0 ),
+      running_( false ),
+      clientCount_( 0 ),
+      evicted_( 0 )
+    {
+    }
+
+    ~Implementation() { stop(); }
+
+    bool listenOn( int port );
+    void addConnection( SocketHandle s );
+    bool start();
+    void stop();
+
+    int port() const { return port_; }
+    int clientCount() const { return clientCount_.load( std::memory_order_relaxed ); }
+    unsigned long evictedCount() const { return evicted_.load( std::memory_order_relaxed ); }
+
+    bool sendToAll( const char *header, unsigned int headerSize, const char *data, unsigned int size );
+
+private:
+    void run();
+    void acceptClients();
+    void readFromClient( TcpConnection *connection );
+    void writeBacklog( TcpConnection *connection );
+    void watchForWrites( TcpConnection *connection, bool on );
+    void watch( TcpConnection *connection );
+    void removeClosedConnections();
+    void wakeUp();
+    void drainWakeUps();
+
+    OscNetworkInitializer networkInitializer_;
+    SocketHandle listener_,
+                 wake_;
+#ifdef TUIO_USE_EPOLL
+    int poll_;
+#else
+    SocketHandle wakeSender_;
+#endif
+    int port_;
+    std::atomic<bool> running_;
+    std::atomic<int> clientCount_;
+    std::atomic<unsigned long> evicted_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<TcpConnection *> connections_;
+};
+
+bool TcpSender::Implementation::listenOn( int port )
+{
+    listener_ = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
 
-    int connected = 1;
-    while( connected ) {
-        connected = recv( client, buf, sizeof( buf ), 0 );
+    if( listener_ == NO_SOCKET ) {
+        std::cerr << "could not create TUIO/TCP socket" << std::endl;
+        return false;
+    }
+    int optval = 1;
+    if( setsockopt( listener_, SOL_SOCKET, SO_REUSEADDR, (const char *)&optval, sizeof( int ) ) < 0 ) {
+        std::cerr << "could not reuse TUIO/TCP socket address" << std::endl;
     }
 
-    sender->tcp_client_list.remove( client );
-    std::cout << "TUIO/TCP connection closed" << std::endl;
-    if( sender->tcp_client_list.size() == 0 ) sender->connected = false;
-    //std::cout << sender->tcp_client_list.size() << " clients left"<< std::endl;	
+    struct sockaddr_in tcp_server;
+    memset( &tcp_server, 0, sizeof( tcp_server ) );
+    tcp_server.sin_family = AF_INET;
+    tcp_server.sin_addr.s_addr = htonl( INADDR_ANY );
+    tcp_server.sin_port = htons( (unsigned short)port );
+    socklen_t len = sizeof( tcp_server );
 
-    return 0;
-};
+    if( bind( listener_, (struct sockaddr*)&tcp_server, len ) < 0 ) {
+        std::cerr << "could not bind to TUIO/TCP socket on port " << port << std::endl;
+        closeSocket( listener_ );
+        listener_ = NO_SOCKET;
+        return false;
+    }
+    if( listen( listener_, SOMAXCONN ) < 0 || getsockname( listener_, (struct sockaddr*)&tcp_server, &len ) < 0 ) {
+        std::cerr << "could not start listening to TUIO/TCP socket" << std::endl;
+        closeSocket( listener_ );
+        listener_ = NO_SOCKET;
+        return false;
+    }
+    port_ = ntohs( tcp_server.sin_port );
+    setNonBlocking( listener_ );
+    std::cout << "TUIO/TCP socket created on port " << port_ << std::endl;
+    return true;
+}
+
+/**
+ * Adds a connected socket.  Called before the event loop is started, or from
+ * the event loop itself.
+ */
+void TcpSender::Implementation::addConnection( SocketHandle s )
+{
+    TcpConnection *connection = new TcpConnection();
+    connection->socket = s;
+    connection->backlogOffset = 0;
+    connection->closed = false;
+    connections_.push_back( connection );
+    clientCount_.store( (int)connections_.size() );
+
+    int on = 1;
+    setsockopt( s, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof( on ) );
+    setNonBlocking( s );
+}
 
-#ifndef  WIN32
-static void* ServerThreadFunc( void* obj )
+bool TcpSender::Implementation::start()
+{
+#ifdef TUIO_USE_EPOLL
+    poll_ = epoll_create1( EPOLL_CLOEXEC );
+    wake_ = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    if( poll_ < 0 || wake_ < 0 ) {
+        return false;
+    }
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ) );
+    event.events = EPOLLIN;
+    event.data.ptr = this; // the wake-up event
+    epoll_ctl( poll_, EPOLL_CTL_ADD, wake_, &event );
+
+    if( listener_ != NO_SOCKET ) {
+        event.data.ptr = NULL; // the listener
+        epoll_ctl( poll_, EPOLL_CTL_ADD, listener_, &event );
+    }
+    for( size_t i = 0; i < connections_.size(); ++i ) {
+        watch( connections_[i] );
+    }
 #else
-static DWORD WINAPI ServerThreadFunc( LPVOID obj )
+    // select() can only wait on sockets, so the loop is woken up by a
+    // datagram sent to a UDP socket bound to localhost.
+    struct sockaddr_in address;
+    socklen_t length = sizeof( address );
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    wake_ = socket( AF_INET, SOCK_DGRAM, 0 );
+    wakeSender_ = socket( AF_INET, SOCK_DGRAM, 0 );
+
+    if( wake_ == NO_SOCKET || wakeSender_ == NO_SOCKET
+        || bind( wake_, (struct sockaddr *)&address, sizeof( address ) ) != 0
+        || getsockname( wake_, (struct sockaddr *)&address, &length ) != 0
+        || connect( wakeSender_, (struct sockaddr *)&address, sizeof( address ) ) != 0 ) {
+        return false;
+    }
+    setNonBlocking( wake_ );
+    setNonBlocking( wakeSender_ );
 #endif
+    running_.store( true );
+    thread_ = std::thread( &Implementation::run, this );
+    return true;
+}
+
+void TcpSender::Implementation::stop()
 {
-    TcpSender *sender = static_cast<TcpSender*>(obj);
-    struct sockaddr_in client_addr;
-    socklen_t len = sizeof( client_addr );
+    if( running_.exchange( false ) ) {
+        wakeUp();
+        thread_.join();
+    }
+    for( size_t i = 0; i < connections_.size(); ++i ) {
+        closeSocket( connections_[i]->socket );
+        delete connections_[i];
+    }
+    connections_.clear();
+    clientCount_.store( 0 );
 
-    std::cout << "TUIO/TCP socket created on port " << sender->port_no << std::endl;
-    while( sender->tcp_socket ) {
-#ifdef WIN32
-        SOCKET tcp_client = -1;
+    if( listener_ != NO_SOCKET ) {
+        closeSocket( listener_ );
+        listener_ = NO_SOCKET;
+    }
+#ifdef TUIO_USE_EPOLL
+    if( wake_ >= 0 ) {
+        close( wake_ );
+        wake_ = NO_SOCKET;
+    }
+    if( poll_ >= 0 ) {
+        close( poll_ );
+        poll_ = -1;
+    }
 #else
-        int tcp_client = -1;
+    if( wake_ != NO_SOCKET ) {
+        closeSocket( wake_ );
+        wake_ = NO_SOCKET;
+    }
+    if( wakeSender_ != NO_SOCKET ) {
+        closeSocket( wakeSender_ );
+        wakeSender_ = NO_SOCKET;
+    }
 #endif
-        tcp_client = accept( sender->tcp_socket, (struct sockaddr*)&client_addr, &len );
+}
 
-        if( tcp_client > 0 ) {
-            std::cout << "TUIO/TCP client connected from " << inet_ntoa( client_addr.sin_addr ) << "@" << client_addr.sin_port << std::endl;
-            sender->tcp_client_list.push_back( tcp_client );
-            sender->connected = true;
-            //std::cout << sender->tcp_client_list.size() << " clients connected"<< std::endl;	
+void TcpSender::Implementation::wakeUp()
+{
+#ifdef TUIO_USE_EPOLL
+    uint64_t one = 1;
+    ssize_t written = write( wake_, &one, sizeof( one ) );
+    (void)written; // a full counter means the loop is already awake
+#else
+    char byte = 0;
+    send( wakeSender_, &byte, 1, 0 );
+#endif
+}
 
-#ifndef WIN32
-            pthread_t client_thread;
-            pthread_create(&client_thread , NULL, ClientThreadFunc,obj);
+void TcpSender::Implementation::drainWakeUps()
+{
+#ifdef TUIO_USE_EPOLL
+    uint64_t count;
+    ssize_t n = read( wake_, &count, sizeof( count ) );
+    (void)n;
 #else
-            DWORD ClientThreadId;
-            HANDLE client_thread = CreateThread( 0, 0, ClientThreadFunc, obj, 0, &ClientThreadId );
+    char buffer[64];
+
+    while( recv( wake_, buffer, sizeof( buffer ), 0 ) > 0 ) {
+    }
 #endif
+}
+
+void TcpSender::Implementation::run()
+{
+#ifdef TUIO_USE_EPOLL
+    const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+
+    while( running_.load() ) {
+        int count = epoll_wait( poll_, events, MAX_EVENTS, -1 );
+
+        if( count < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            break;
+        }
+        std::lock_guard<std::mutex> lock( mutex_ );
+
+        for( int i = 0; i < count; ++i ) {
+            void *source = events[i].data.ptr;
+
+            if( source == NULL ) {
+                acceptClients();
+            }
+            else if( source == this ) {
+                drainWakeUps();
+            }
+            else {
+                TcpConnection *connection = (TcpConnection *)source;
+
+                if( events[i].events & (EPOLLERR | EPOLLHUP) ) {
+                    connection->closed = true;
+                }
+                if( !connection->closed && (events[i].events & EPOLLIN) ) {
+                    readFromClient( connection );
+                }
+                if( !connection->closed && (events[i].events & EPOLLOUT) ) {
+                    writeBacklog( connection );
+                }
+            }
         }
+        removeClosedConnections();
     }
+#else
+    while( running_.load() ) {
+        fd_set readable,
+               writable;
+        FD_ZERO( &readable );
+        FD_ZERO( &writable );
+        SocketHandle highest = wake_;
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            FD_SET( wake_, &readable );
+
+            if( listener_ != NO_SOCKET ) {
+                FD_SET( listener_, &readable );
+                highest = listener_ > highest ? listener_ : highest;
+            }
+            for( size_t i = 0; i < connections_.size(); ++i ) {
+                SocketHandle s = connections_[i]->socket;
+                FD_SET( s, &readable );
+
+                if( !connections_[i]->backlog.empty() ) {
+                    FD_SET( s, &writable );
+                }
+                highest = s > highest ? s : highest;
+            }
+        }
+        if( select( (int)highest + 1, &readable, &writable, NULL, NULL ) < 0 ) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock( mutex_ );
 
-    return 0;
-};
+        if( FD_ISSET( wake_, &readable ) ) {
+            drainWakeUps();
+        }
+        if( listener_ != NO_SOCKET && FD_ISSET( listener_, &readable ) ) {
+            acceptClients();
+        }
+        for( size_t i = 0; i < connections_.size(); ++i ) {
+            TcpConnection *connection = connections_[i];
+
+            if( FD_ISSET( connection->socket, &readable ) ) {
+                readFromClient( connection );
+            }
+            if( !connection->closed && FD_ISSET( connection->socket, &writable ) ) {
+                writeBacklog( connection );
+            }
+        }
+        removeClosedConnections();
+    }
+#endif
+}
 
-TcpSender::TcpSender()
-    :connected( false )
+void TcpSender::Implementation::acceptClients()
 {
-    local = true;
-    buffer_size = MAX_TCP_SIZE;
-    partial_previous_message = "";
+    for( ;; ) {
+        struct sockaddr_in client_addr;
+        socklen_t len = sizeof( client_addr );
+        SocketHandle tcp_client = accept( listener_, (struct sockaddr*)&client_addr, &len );
 
-    tcp_socket = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
-    if( tcp_socket < 0 ) {
-        std::cerr << "could not create TUIO/TCP socket" << std::endl;
-        return;
+        if( tcp_client == NO_SOCKET ) {
+            return;
+        }
+        addConnection( tcp_client );
+#ifdef TUIO_USE_EPOLL
+        watch( connections_.back() );
+#endif
     }
+}
 
-    struct sockaddr_in tcp_server;
-    memset( &tcp_server, 0, sizeof( tcp_server ) );
-    //unsigned long addr = inet_addr("127.0.0.1");
-    //memcpy( (char *)&tcp_server.sin_addr, &addr, sizeof(addr));
+void TcpSender::Implementation::watch( TcpConnection *connection )
+{
+#ifdef TUIO_USE_EPOLL
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ) );
+    event.events = EPOLLIN;
+    event.data.ptr = connection;
+    epoll_ctl( poll_, EPOLL_CTL_ADD, connection->socket, &event );
+#else
+    (void)connection;
+#endif
+}
 
-    tcp_server.sin_family = AF_INET;
-    tcp_server.sin_port = htons( 3333 );
-    tcp_server.sin_addr.s_addr = inet_addr( "127.0.0.1" );
+void TcpSender::Implementation::readFromClient( TcpConnection *connection )
+{
+    // Nothing is expected from a TUIO/TCP client; reading tells us when it
+    // has gone away.
+    char buffer[1024];
+
+    for( ;; ) {
+        int n = (int)recv( connection->socket, buffer, sizeof( buffer ), 0 );
 
-    int ret = connect( tcp_socket, (struct sockaddr*)&tcp_server, sizeof( tcp_server ) );
-    if( ret < 0 ) {
-        std::cerr << "could not open TUIO/TCP connection to 127.0.0.1:3333" << std::endl;
+        if( n > 0 ) {
+            continue;
+        }
+        if( n == 0 || !wouldBlock() ) {
+            connection->closed = true;
+        }
         return;
     }
-    else {
-        std::cout << "TUIO/TCP connection opened to 127.0.0.1:3333" << std::endl;
-        tcp_client_list.push_back( tcp_socket );
-        connected = true;
+}
+
+void TcpSender::Implementation::writeBacklog( TcpConnection *connection )
+{
+    size_t left = connection->backlog.size() - connection->backlogOffset;
+    int n = sendGathered( connection->socket, &connection->backlog[connection->backlogOffset],
+                          (unsigned int)left, NULL, 0 );
+    if( n < 0 ) {
+        if( !wouldBlock() ) {
+            connection->closed = true;
+        }
+        return;
+    }
+    connection->backlogOffset += (size_t)n;
 
-#ifndef WIN32
-        pthread_create(&server_thread , NULL, ClientThreadFunc,this);
+    if( connection->backlogOffset == connection->backlog.size() ) {
+        connection->backlog.clear();
+        connection->backlogOffset = 0;
+        watchForWrites( connection, false );
+    }
+}
+
+void TcpSender::Implementation::watchForWrites( TcpConnection *connection, bool on )
+{
+#ifdef TUIO_USE_EPOLL
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ) );
+    event.events = on ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.ptr = connection;
+    epoll_ctl( poll_, EPOLL_CTL_MOD, connection->socket, &event );
 #else
-        HANDLE server_thread = CreateThread( 0, 0, ClientThreadFunc, this, 0, &ServerThreadId );
+    if( on ) {
+        wakeUp(); // select() has to be called again with this socket in the write set
+    }
 #endif
+}
+
+void TcpSender::Implementation::removeClosedConnections()
+{
+    size_t kept = 0;
 
+    for( size_t i = 0; i < connections_.size(); ++i ) {
+        TcpConnection *connection = connections_[i];
+
+        if( connection->closed ) {
+#ifdef TUIO_USE_EPOLL
+            epoll_ctl( poll_, EPOLL_CTL_DEL, connection->socket, NULL );
+#endif
+            closeSocket( connection->socket );
+            delete connection;
+        }
+        else {
+            connections_[kept++] = connection;
+        }
     }
+    connections_.resize( kept );
+    clientCount_.store( (int)kept );
+}
+
+bool TcpSender::Implementation::sendToAll( const char *header, unsigned int headerSize,
+                                           const char *data, unsigned int size )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    bool closed = false;
+
+    for( size_t i = 0; i < connections_.size(); ++i ) {
+        TcpConnection *connection = connections_[i];
 
+        if( connection->closed ) {
+            continue;
+        }
+        size_t sent = 0;
+        bool idle = connection->backlog.empty();
+
+        if( idle ) {
+            int n = sendGathered( connection->socket, header, headerSize, data, size );
+
+            if( n < 0 && !wouldBlock() ) {
+                connection->closed = closed = true;
+                continue;
+            }
+            sent = n > 0 ? (size_t)n : 0;
+
+            if( sent == headerSize + size ) {
+                continue;
+            }
+        }
+        else if( connection->backlog.size() - connection->backlogOffset + headerSize + size > MAX_BACKLOG_BYTES ) {
+            // The client is not reading: let it go rather than hold the frames for it.
+            evicted_.fetch_add( 1, std::memory_order_relaxed );
+            std::cout << "TUIO/TCP client fell behind and was disconnected" << std::endl;
+            connection->closed = closed = true;
+            continue;
+        }
+        // Only what the socket did not take is copied.
+        if( sent < headerSize ) {
+            connection->backlog.insert( connection->backlog.end(), header + sent, header + headerSize );
+            sent = headerSize;
+        }
+        connection->backlog.insert( connection->backlog.end(), data + (sent - headerSize), data + size );
+
+        if( idle ) {
+            watchForWrites( connection, true );
+        }
+    }
+    if( closed ) {
+        wakeUp(); // only the event loop deletes connections
+    }
+    return !connections_.empty();
+}
+
+TcpSender::TcpSender()
+    : impl_( new Implementation() )
+{
+    local = true;
+    buffer_size = MAX_TCP_SIZE;
+    connectTo( "127.0.0.1", 3333 );
 }
 
 TcpSender::TcpSender( const char *host, int port )
-    :connected( false )
+    : impl_( new Implementation() )
 {
     if( (strcmp( host, "127.0.0.1" ) == 0) || (strcmp( host, "localhost" ) == 0) ) {
         local = true;
     }
     else local = false;
     buffer_size = MAX_TCP_SIZE;
-    partial_previous_message = "";
+    connectTo( host, port );
+}
 
-    tcp_socket = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
-    if( tcp_socket < 0 ) {
+TcpSender::TcpSender( int port )
+    : impl_( new Implementation() )
+{
+    local = false;
+    buffer_size = MAX_TCP_SIZE;
+
+    if( impl_->listenOn( port ) && !impl_->start() ) {
+        std::cerr << "could not start the TUIO/TCP event loop" << std::endl;
+    }
+}
+
+void TcpSender::connectTo( const char *host, int port )
+{
+    SocketHandle tcp_socket = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+    if( tcp_socket == NO_SOCKET ) {
         std::cerr << "could not create TUIO/TCP socket" << std::endl;
         return;
     }
@@ -162,155 +652,85 @@ TcpSender::TcpSender( const char *host, int port )
     }
     else {
         struct hostent *host_info = gethostbyname( host );
-        if( host_info == NULL ) std::cerr << "unknown host name: " << host << std::endl;
+        if( host_info == NULL ) {
+            std::cerr << "unknown host name: " << host << std::endl;
+            closeSocket( tcp_socket );
+            return;
+        }
         memcpy( (char *)&tcp_server.sin_addr, host_info->h_addr, host_info->h_length );
     }
 
     tcp_server.sin_family = AF_INET;
-    tcp_server.sin_port = htons( port );
+    tcp_server.sin_port = htons( (unsigned short)port );
 
-    int ret = connect( tcp_socket, (struct sockaddr*)&tcp_server, sizeof( tcp_server ) );
-    if( ret < 0 ) {
-#ifdef WIN32
-        closesocket( tcp_socket );
-#else
-        close(tcp_socket);
-#endif	
+    if( connect( tcp_socket, (struct sockaddr*)&tcp_server, sizeof( tcp_server ) ) < 0 ) {
+        closeSocket( tcp_socket );
         std::cerr << "could not open TUIO/TCP connection to " << host << ":" << port << std::endl;
         return;
     }
-    else {
-        std::cout << "TUIO/TCP connection opened to " << host << ":" << port << std::endl;
-        tcp_client_list.push_back( tcp_socket );
-        connected = true;
-
-#ifndef WIN32
-        pthread_create(&server_thread , NULL, ClientThreadFunc,this);
-#else
-        HANDLE server_thread = CreateThread( 0, 0, ClientThreadFunc, this, 0, &ServerThreadId );
-#endif
+    std::cout << "TUIO/TCP connection opened to " << host << ":" << port << std::endl;
+    impl_->addConnection( tcp_socket );
 
+    if( !impl_->start() ) {
+        std::cerr << "could not start the TUIO/TCP event loop" << std::endl;
     }
 }
 
-TcpSender::TcpSender( int port )
-    :connected( false )
-{
-    local = false;
-    buffer_size = MAX_TCP_SIZE;
-    port_no = port;
-    partial_previous_message = "";
-
-    tcp_socket = socket( PF_INET, SOCK_STREAM, IPPROTO_TCP );
-    if( tcp_socket < 0 ) std::cerr << "could not create TUIO/TCP socket" << std::endl;
-
-    int optval = 1;
-#ifdef  WIN32
-    int ret = setsockopt( tcp_socket, SOL_SOCKET, SO_REUSEADDR, (const char *)&optval, sizeof( int ) );
-#else
-    int ret = setsockopt(tcp_socket,SOL_SOCKET,SO_REUSEADDR, (const void *)&optval,  sizeof(int));
-#endif
-    if( ret < 0 ) {
-        std::cerr << "could not reuse TUIO/TCP socket address" << std::endl;
-        return;
-    }
-
-    struct sockaddr_in tcp_server;
-    memset( &tcp_server, 0, sizeof( tcp_server ) );
-
-    tcp_server.sin_family = AF_INET;
-    tcp_server.sin_addr.s_addr = htonl( INADDR_ANY );
-    tcp_server.sin_port = htons( port );
-
-    socklen_t len = sizeof( tcp_server );
-    ret = bind( tcp_socket, (struct sockaddr*)&tcp_server, len );
-    if( ret < 0 ) {
-        std::cerr << "could not bind to TUIO/TCP socket on port " << port << std::endl;
-        return;
-    }
-
-    ret = listen( tcp_socket, 1 );
-    if( ret < 0 ) {
-        std::cerr << "could not start listening to TUIO/TCP socket" << std::endl;
-#ifdef WIN32
-        closesocket( tcp_socket );
-#else
-        close(tcp_socket);
-#endif
-        return;
-    }
-
-#ifndef WIN32
-    pthread_create(&server_thread , NULL, ServerThreadFunc, this);
-#else
-    DWORD ServerThreadId;
-    server_thread = CreateThread( 0, 0, ServerThreadFunc, this, 0, &ServerThreadId );
-#endif
+bool TcpSender::isConnected() {
+    return impl_->clientCount() > 0;
+}
 
+int TcpSender::getPort()
+{
+    return impl_->port();
 }
 
-bool TcpSender::isConnected() {
-    return connected;
+int TcpSender::getClientCount()
+{
+    return impl_->clientCount();
 }
 
+unsigned long TcpSender::getEvictedCount()
+{
+    return impl_->evictedCount();
+}
 
 TcpSender::~TcpSender() {
-#ifdef WIN32
-    for( std::list<SOCKET>::iterator client = tcp_client_list.begin(); client != tcp_client_list.end(); client++ ) {
-        closesocket( (*client) );
-    }
-    closesocket( tcp_socket );
-    if( server_thread ) CloseHandle( server_thread );
-#else
-    for (std::list<int>::iterator client = tcp_client_list.begin(); client!=tcp_client_list.end(); client++) {
-        close((*client));
-    }
-    close(tcp_socket);
-    server_thread = 0;
-#endif		
+    delete impl_;
 }
 
+/**
+ * Sends the data to every client, preceded by its length as a 4 byte
+ * big-endian integer.
+ */
+bool TcpSender::sendFrame( const char *data, unsigned int size )
+{
+    char data_size[4];
+    data_size[0] = (char)(size >> 24);
+    data_size[1] = (char)((size >> 16) & 255);
+    data_size[2] = (char)((size >> 8) & 255);
+    data_size[3] = (char)(size & 255);
+
+    return impl_->sendToAll( data_size, 4, data, size );
+}
 
 bool TcpSender::sendOscPacket( osc::OutboundPacketStream *bundle ) {
-    if( !connected ) return false;
+    if( !isConnected() ) return false;
     if( bundle->Size() > buffer_size ) return false;
     if( bundle->Size() == 0 ) return false;
 
-#ifdef OSC_HOST_LITTLE_ENDIAN             
-    data_size[0] = bundle->Size() >> 24;
-    data_size[1] = (bundle->Size() >> 16) & 255;
-    data_size[2] = (bundle->Size() >> 8) & 255;
-    data_size[3] = (bundle->Size()) & 255;
-#else
-    *((int32_t*)data_size) = bundle->Size();
-#endif
-
-#ifdef WIN32
-    std::list<SOCKET>::iterator client;
-#else
-    std::list<int>::iterator client;
-#endif
-
-    for( client = tcp_client_list.begin(); client != tcp_client_list.end(); client++ ) {
-        //send((*client), data_size, 4,0);
-        //send((*client), bundle->Data(), bundle->Size(),0);
-        memcpy( &data_buffer[0], &data_size, 4 );
-        memcpy( &data_buffer[4], bundle->Data(), bundle->Size() );
-        send( (*client), data_buffer, 4 + bundle->Size(), 0 );
-    }
-
-    return true;
+    return sendFrame( bundle->Data(), (unsigned int)bundle->Size() );
 }
 
-bool TcpSender::sendFlashXmlMessage( std::string message ) 
+bool TcpSender::sendFlashXmlMessage( std::string message )
 {
-    if( !connected ) { 
-        return false; 
+    if( !isConnected() ) {
+        return false;
     }
     message = partial_previous_message + message;
     partial_previous_message = "";
 
-    if( message.size() == 0 ) { 
+    if( message.size() == 0 ) {
         return false;
     }
     message += (char)0; // Add null character for Flash XML.
@@ -321,27 +741,5 @@ bool TcpSender::sendFlashXmlMessage( std::string message )
         partial_previous_message = message.substr( msgSize );
         message = message.substr( 0, msgSize );
     }
-
-#ifdef OSC_HOST_LITTLE_ENDIAN        
-    data_size[0] =  msgSize >> 24;
-    data_size[1] = (msgSize >> 16) & 255;
-    data_size[2] = (msgSize >> 8) & 255;
-    data_size[3] =  msgSize & 255;
-
-#else
-    *((int32_t*)data_size) = msgSize;
-#endif
-
-#ifdef WIN32
-    std::list<SOCKET>::iterator client;
-#else
-    std::list<int>::iterator client;
-#endif
-
-    for( client = tcp_client_list.begin(); client != tcp_client_list.end(); client++ ) {
-        memcpy( &data_buffer[0], &data_size, 4 );
-        memcpy( &data_buffer[4], message.c_str(), msgSize );
-        send( (*client), data_buffer, 4 + msgSize, 0 );
-    }
-    return true;
+    return sendFrame( message.c_str(), msgSize );
 }
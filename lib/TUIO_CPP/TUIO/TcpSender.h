@@ -23,21 +23,8 @@
 #define INCLUDED_TCPSENDER_H
 
 #include "OscSender.h"
+#include <string>
 
-#ifdef WIN32
-#include <winsock.h>
-#include <io.h>
-typedef int socklen_t;
-#else
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <netdb.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#endif
-
-#include <list>
 #define MAX_TCP_SIZE 65536
 
 namespace TUIO {
@@ -45,12 +32,25 @@ namespace TUIO {
     /**
      * The TcpSender implements the TCP transport method for OSC
      *
+     * Every packet is sent as a 4 byte big-endian length followed by the
+     * OSC data.  The length is written once per packet and the two parts are
+     * handed to each connection with one gathering send (writev/WSASend), so
+     * the packet is never copied for a client that keeps up.
+     *
+     * All connections are non-blocking and are served by one event loop
+     * thread (epoll on Linux, select() elsewhere), which accepts clients,
+     * finishes writes that did not fit in a socket buffer and notices
+     * clients that go away.  A client that falls more than
+     * MAX_BACKLOG_BYTES behind is disconnected, so a stalled consumer never
+     * holds up the sending thread or the other clients.
+     *
      * @author Martin Kaltenbrunner
      * @version 1.5
      */
     class LIBDECL TcpSender : public OscSender {
 
     public:
+        enum { MAX_BACKLOG_BYTES = 256 * 1024 };
 
         /**
          * The default constructor creates a TcpSender that sends to the default TUIO port 3333 on localhost
@@ -68,12 +68,12 @@ namespace TUIO {
         /**
          * This constructor creates a TcpSender that listens to the provided port
          *
-         * @param  port	the incoming TUIO TCP port number
+         * @param  port	the incoming TUIO TCP port number, or 0 for any free port
          */
         TcpSender( int port );
 
         /**
-         * The destructor closes the socket.
+         * The destructor stops the event loop and closes every connection.
          */
         ~TcpSender();
 
@@ -97,34 +97,33 @@ namespace TUIO {
         /**
          * This method returns the connection state
          *
-         * @return true if the connection is alive
+         * @return true if at least one client is connected
          */
         bool isConnected();
 
-        int port_no;
+        /**
+         * The port being listened on, or 0 if this TcpSender connects to a host.
+         */
+        int getPort();
 
-#ifdef WIN32
-        SOCKET tcp_socket;
-        std::list<SOCKET> tcp_client_list;
-#else
-        int tcp_socket;
-        std::list<int> tcp_client_list;
-#endif
-        bool connected;
+        int getClientCount();
+
+        /**
+         * The number of clients disconnected for falling behind.
+         */
+        unsigned long getEvictedCount();
 
     private:
-        char data_size[4];
-        char data_buffer[MAX_TCP_SIZE + 4];
-        std::string partial_previous_message;
+        class Implementation;
 
+        TcpSender( const TcpSender & );
+        TcpSender & operator=( const TcpSender & );
 
-#ifdef WIN32
-        HANDLE server_thread;
-        DWORD ServerThreadId;
-#else
-        pthread_t server_thread;
-#endif
+        bool sendFrame( const char *data, unsigned int size );
+        void connectTo( const char *host, int port );
 
+        Implementation *impl_;
+        std::string partial_previous_message;
     };
 }
 #endif /* INCLUDED_TCPSENDER_H */
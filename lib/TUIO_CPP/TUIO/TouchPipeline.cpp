@@ -0,0 +1,529 @@
+/*******************************************************************************
+TouchPipeline
+
+PURPOSE: Turns pointer events into TUIO cursor frames.  See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "TouchPipeline.h"
+#include "TuioCursorOutputThread.h"
+#include "TuioCursorServer.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace TUIO;
+
+/**
+ * The TUIO 2.0 type ID for a PointerInputType.  A touch pointer is not
+ * known to be any particular finger.
+ */
+static int tuioTypeId( int pointerType )
+{
+    switch( pointerType ) {
+        case POINTER_INPUT_PEN:
+            return TuioCursorServer::TYPE_STYLUS;
+        case POINTER_INPUT_MOUSE:
+        case POINTER_INPUT_TOUCHPAD:
+            return TuioCursorServer::TYPE_MOUSE;
+    }
+    return TuioCursorServer::TYPE_UNKNOWN;
+}
+
+TouchPipeline::TouchPipeline( TuioCursorServer * tuioCursorServer ) :
+  contacts_(),
+  movedCount_( 0 ),
+  heldCount_( 0 ),
+  nextSerial_( 0 ),
+  deadlines_(),
+  maxIdleTime_( DEFAULT_MAX_IDLE_TIME ),
+  expiryPrecision_( DEFAULT_EXPIRY_PRECISION ),
+  deadBand_( 0.0f ),
+  settleTime_( DEFAULT_SETTLE_TIME ),
+  quantization_( 0 ),
+  outputThread_( new TuioCursorOutputThread( tuioCursorServer ) ),
+  clock_( &TuioTime::getSessionTime ),
+  timestampFrequency_( 0 ),
+  eventTimeKnown_( false ),
+  eventTime_(),
+  frameOpen_( false ),
+  frameFromEvent_( false ),
+  frameTime_(),
+  latency_(),
+  eventCount_( 0 ),
+  frameCount_( 0 ),
+  suppressedCount_( 0 ),
+  settledCount_( 0 ),
+  screenOffsetX_( 0 ),
+  screenOffsetY_( 0 ),
+  screenWidth_( 1920 ),
+  screenHeight_( 1080 ),
+  mirroredMonitors_( true )
+{
+    contacts_.reserve( 32 );
+    deadlines_.reserve( 128 );
+}
+
+TouchPipeline::~TouchPipeline()
+{
+    outputThread_.reset(); // sends what is still queued
+}
+
+bool TouchPipeline::startOutputThread( int cpu, int priority )
+{
+    return outputThread_->start( cpu, priority );
+}
+
+void TouchPipeline::setScreenDimensions( int x, int y, int width, int height )
+{
+    screenOffsetX_ = x;
+    screenOffsetY_ = y;
+    screenWidth_ = width;
+    screenHeight_ = height;
+}
+
+float TouchPipeline::scaledX( int x ) const
+{
+    int mirroredX = x + screenOffsetX_,
+        sideBySideX = (x - screenWidth_) + screenOffsetX_,
+        screenX = mirroredMonitors_ ? mirroredX : sideBySideX,
+        screenWidth = screenWidth_ + screenOffsetX_;
+
+    return (float)screenX / screenWidth;
+}
+
+float TouchPipeline::scaledY( int y ) const
+{
+    int screenY = y + screenOffsetY_,
+        screenHeight = screenHeight_ + screenOffsetY_;
+
+    return (float)screenY / screenHeight;
+}
+
+bool TouchPipeline::process( const PointerEvent & event )
+{
+    eventTimeKnown_ = timestampFrequency_ > 0 && event.timestamp != 0;
+
+    if( eventTimeKnown_ ) {
+        eventTime_ = TuioTime::getSessionTime( event.timestamp, timestampFrequency_ );
+    }
+    switch( event.type ) {
+        case POINTER_DOWN:
+            pointerDown( event.id, tuioTypeId( event.pointerType ), event.x, event.y );
+            return true;
+        case POINTER_UPDATE:
+            return pointerUpdate( event.id, tuioTypeId( event.pointerType ), event.x, event.y );
+        case POINTER_UP:
+            return pointerUp( event.id );
+    }
+    return false;
+}
+
+int TouchPipeline::findContact( unsigned int id ) const
+{
+    for( size_t i = 0; i < contacts_.size(); ++i ) {
+        if( contacts_[i].id == id ) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * The order of the contacts does not matter, so the last one fills the gap.
+ */
+void TouchPipeline::removeContact( int i )
+{
+    if( contacts_[i].moved ) {
+        --movedCount_;
+    }
+    if( contacts_[i].held ) {
+        --heldCount_;
+    }
+    contacts_[i] = contacts_.back();
+    contacts_.pop_back();
+}
+
+/**
+ * Cursors are added to the open frame right away, so that a pointer-up in
+ * the same burst can tell that the add has not been sent yet.  A down for
+ * a pointer that is already down (its pointer-up was lost) replaces the
+ * cursor and forgets its waiting move.
+ */
+void TouchPipeline::pointerDown( unsigned int id, int typeId, int screenX, int screenY )
+{
+    float x = quantized( scaledX( screenX ) ),
+          y = quantized( scaledY( screenY ) );
+
+    ++eventCount_;
+    openFrame();
+    outputThread_->addTuioCursor( id, x, y, typeId );
+
+    int i = findContact( id );
+
+    if( i < 0 ) {
+        contacts_.push_back( Contact() );
+        i = (int)contacts_.size() - 1;
+    }
+    else {
+        if( contacts_[i].moved ) {
+            --movedCount_;
+        }
+        if( contacts_[i].held ) {
+            --heldCount_;
+        }
+    }
+    Contact & contact = contacts_[i];
+    contact.id = id;
+    contact.serial = nextSerial_++;
+    contact.time = frameTime_;
+    contact.input = frameTime_;
+    contact.moved = false;
+    contact.held = false;
+    contact.sentX = x;
+    contact.sentY = y;
+    contact.sentMoved = false;
+    pushDeadline( deadline( contact ), id, contact.serial );
+}
+
+/**
+ * While a move is waiting anyway, a later update just replaces it: it costs
+ * no extra frame.  Otherwise an update within the dead band of the position
+ * last sent is held, or dropped if it is that position and the cursor has
+ * already been sent standing still there.
+ *
+ * @return false if the update was held or dropped.
+ */
+bool TouchPipeline::pointerUpdate( unsigned int id, int typeId, int screenX, int screenY )
+{
+    int i = findContact( id );
+
+    if( i < 0 ) {
+        pointerDown( id, typeId, screenX, screenY );
+        return true;
+    }
+    ++eventCount_;
+    Contact & contact = contacts_[i];
+    float x = quantized( scaledX( screenX ) ),
+          y = quantized( scaledY( screenY ) );
+
+    if( isFiltering() && !contact.moved ) {
+        float dx = (x - contact.sentX) * screenWidth_,
+              dy = (y - contact.sentY) * screenHeight_;
+
+        if( dx * dx + dy * dy <= deadBand_ * deadBand_ ) {
+            ++suppressedCount_;
+            contact.input = eventTimeKnown_ ? eventTime_ : clock_();
+
+            if( x == contact.sentX && y == contact.sentY && !contact.sentMoved ) {
+                if( contact.held ) {
+                    contact.held = false;
+                    --heldCount_;
+                }
+                return false;
+            }
+            hold( contact, x, y );
+
+            if( contact.input.getTotalMilliseconds() < settleDeadline( contact ) ) {
+                return false;
+            }
+            release( contact );
+            return true;
+        }
+    }
+    if( contact.held ) {
+        contact.held = false;
+        --heldCount_;
+    }
+    if( !contact.moved ) {
+        contact.moved = true;
+        ++movedCount_;
+    }
+    contact.x = x;
+    contact.y = y;
+    return true;
+}
+
+float TouchPipeline::quantized( float v ) const
+{
+    return quantization_ > 0 ? floorf( v * quantization_ + 0.5f ) / quantization_ : v;
+}
+
+/**
+ * The settle time counts from the first update held since the cursor was
+ * last sent, so a finger that keeps jittering is still sent every settle
+ * time.
+ */
+void TouchPipeline::hold( Contact & contact, float x, float y )
+{
+    if( !contact.held ) {
+        contact.held = true;
+        contact.heldSince = contact.input;
+        ++heldCount_;
+    }
+    contact.heldX = x;
+    contact.heldY = y;
+}
+
+/**
+ * Turns the held position into the waiting move.
+ */
+void TouchPipeline::release( Contact & contact )
+{
+    contact.held = false;
+    --heldCount_;
+    contact.moved = true;
+    ++movedCount_;
+    contact.x = contact.heldX;
+    contact.y = contact.heldY;
+    ++settledCount_;
+}
+
+void TouchPipeline::setDeadBand( float pixels )
+{
+    deadBand_ = std::max( pixels, 0.0f );
+}
+
+bool TouchPipeline::pointerUp( unsigned int id )
+{
+    int i = findContact( id );
+
+    if( i < 0 ) {
+        return false;
+    }
+    ++eventCount_;
+
+    if( contacts_[i].held ) {
+        release( contacts_[i] );
+    }
+    bool addedInOpenFrame = frameOpen_ && contacts_[i].time == frameTime_;
+
+    if( addedInOpenFrame || contacts_[i].moved ) {
+        commitFrame();
+    }
+    openFrame();
+    outputThread_->removeTuioCursor( id );
+    removeContact( i );
+    return true;
+}
+
+/**
+ * The latest event time, or the clock, but at least a microsecond after the
+ * last frame: timestamps of different pointers may come in out of order, and
+ * a cursor update at the time of the last frame would be ignored.
+ */
+TuioTime TouchPipeline::nextFrameTime()
+{
+    TuioTime time = eventTimeKnown_ ? eventTime_ : clock_();
+    frameFromEvent_ = eventTimeKnown_;
+
+    if( time.getTotalMicroseconds() <= frameTime_.getTotalMicroseconds() ) {
+        time = frameTime_ + 1L;
+    }
+    return time;
+}
+
+void TouchPipeline::openFrame()
+{
+    if( !frameOpen_ ) {
+        frameTime_ = nextFrameTime();
+        outputThread_->initFrame( frameTime_ );
+        frameOpen_ = true;
+    }
+}
+
+/**
+ * A cursor already stamped with the frame time (added in this frame, or in
+ * a previous frame within the same millisecond) would ignore the update,
+ * so its move is kept for the next frame.
+ */
+void TouchPipeline::commitFrame()
+{
+    if( movedCount_ > 0 ) {
+        TuioTime frameTime = frameOpen_ ? frameTime_ : nextFrameTime();
+
+        for( size_t i = 0; i < contacts_.size(); ++i ) {
+            Contact & contact = contacts_[i];
+
+            if( !contact.moved || contact.time == frameTime ) {
+                continue;
+            }
+            if( !frameOpen_ ) {
+                frameTime_ = frameTime;
+                outputThread_->initFrame( frameTime_ );
+                frameOpen_ = true;
+            }
+            outputThread_->updateTuioCursor( contact.id, contact.x, contact.y );
+            contact.sentMoved = contact.x != contact.sentX || contact.y != contact.sentY;
+            contact.sentX = contact.x;
+            contact.sentY = contact.y;
+            contact.time = frameTime_;
+            contact.moved = false;
+            --movedCount_;
+        }
+    }
+    if( frameOpen_ ) {
+        outputThread_->commitFrame();
+        frameOpen_ = false;
+        ++frameCount_;
+
+        if( frameFromEvent_ ) {
+            int64_t latency = clock_().getTotalMicroseconds() - frameTime_.getTotalMicroseconds();
+            ++latency_.frames;
+            latency_.totalMicroseconds += latency;
+            latency_.maxMicroseconds = std::max( latency_.maxMicroseconds, latency );
+        }
+    }
+}
+
+TouchPipeline::LatencyStats TouchPipeline::takeLatencyStats()
+{
+    LatencyStats stats = latency_;
+    latency_ = LatencyStats();
+    return stats;
+}
+
+void TouchPipeline::setMaxIdleTime( unsigned int milliseconds )
+{
+    maxIdleTime_ = milliseconds;
+}
+
+void TouchPipeline::setExpiryPrecision( unsigned int milliseconds )
+{
+    expiryPrecision_ = std::max( milliseconds, 1u );
+}
+
+/**
+ * The time the cursor has been idle for long enough, rounded up to the
+ * expiry precision.  Updates the dead band held back or dropped keep it
+ * alive as well.
+ */
+long TouchPipeline::deadline( const Contact & contact ) const
+{
+    long idleAt = std::max( contact.time.getTotalMilliseconds(), contact.input.getTotalMilliseconds() )
+                + (long)maxIdleTime_;
+    return (idleAt + (long)expiryPrecision_ - 1) / (long)expiryPrecision_ * (long)expiryPrecision_;
+}
+
+/**
+ * The time the held position is sent, rounded up like the idle deadlines.
+ */
+long TouchPipeline::settleDeadline( const Contact & contact ) const
+{
+    long settleAt = contact.heldSince.getTotalMilliseconds() + (long)settleTime_;
+    return (settleAt + (long)expiryPrecision_ - 1) / (long)expiryPrecision_ * (long)expiryPrecision_;
+}
+
+void TouchPipeline::pushDeadline( long milliseconds, unsigned int id, unsigned int serial )
+{
+    if( deadlines_.size() >= 2 * contacts_.size() + 64 ) {
+        compactDeadlines();
+    }
+    Deadline d;
+    d.milliseconds = milliseconds;
+    d.id = id;
+    d.serial = serial;
+    deadlines_.push_back( d );
+    std::push_heap( deadlines_.begin(), deadlines_.end(), std::greater<Deadline>() );
+}
+
+void TouchPipeline::popDeadline()
+{
+    std::pop_heap( deadlines_.begin(), deadlines_.end(), std::greater<Deadline>() );
+    deadlines_.pop_back();
+}
+
+/**
+ * Entries of removed cursors only leave the heap when they come up, so with
+ * many short touches and no expiry calls (a replay, say) they would pile up.
+ */
+void TouchPipeline::compactDeadlines()
+{
+    size_t kept = 0;
+
+    for( size_t i = 0; i < deadlines_.size(); ++i ) {
+        int c = findContact( deadlines_[i].id );
+
+        if( c >= 0 && contacts_[c].serial == deadlines_[i].serial ) {
+            deadlines_[kept++] = deadlines_[i];
+        }
+    }
+    deadlines_.resize( kept );
+    std::make_heap( deadlines_.begin(), deadlines_.end(), std::greater<Deadline>() );
+}
+
+/**
+ * Held positions are rare and there are few contacts, so their deadlines
+ * are not kept in the heap but looked up.
+ */
+long TouchPipeline::nextExpiryTime()
+{
+    long next = nextIdleDeadline();
+
+    for( size_t i = 0; heldCount_ > 0 && i < contacts_.size(); ++i ) {
+        if( contacts_[i].held ) {
+            long settleAt = settleDeadline( contacts_[i] );
+            next = next < 0 ? settleAt : std::min( next, settleAt );
+        }
+    }
+    return next;
+}
+
+/**
+ * Entries that come up first are brought up to date until the first one is
+ * a real deadline.
+ */
+long TouchPipeline::nextIdleDeadline()
+{
+    while( !deadlines_.empty() ) {
+        Deadline first = deadlines_.front();
+        int i = findContact( first.id );
+
+        if( i < 0 || contacts_[i].serial != first.serial ) {
+            popDeadline(); // the cursor is gone
+            continue;
+        }
+        long current = deadline( contacts_[i] );
+
+        if( current <= first.milliseconds ) {
+            return first.milliseconds;
+        }
+        popDeadline(); // the cursor changed since
+        pushDeadline( current, first.id, first.serial );
+    }
+    return -1;
+}
+
+/**
+ * A cursor with a move waiting is not idle; its deadline is looked at again
+ * one precision step later, by when the move has normally been committed.
+ */
+unsigned int TouchPipeline::expireIdleCursors( TuioTime now )
+{
+    unsigned int changed = 0;
+    long nowMilliseconds = now.getTotalMilliseconds(),
+         next;
+
+    for( size_t i = 0; heldCount_ > 0 && i < contacts_.size(); ++i ) {
+        if( contacts_[i].held && settleDeadline( contacts_[i] ) <= nowMilliseconds ) {
+            release( contacts_[i] );
+            ++changed;
+        }
+    }
+    while( (next = nextIdleDeadline()) >= 0 && next <= nowMilliseconds ) {
+        Deadline first = deadlines_.front();
+        int i = findContact( first.id );
+        popDeadline();
+
+        if( contacts_[i].moved ) {
+            pushDeadline( nowMilliseconds + (long)expiryPrecision_, first.id, first.serial );
+            continue;
+        }
+        eventTimeKnown_ = false; // a removal is stamped with the clock, not the last input
+        openFrame();
+        outputThread_->removeTuioCursor( first.id );
+        removeContact( i );
+        ++changed;
+    }
+    return changed;
+}
@@ -0,0 +1,330 @@
+/*******************************************************************************
+TouchPipeline
+
+PURPOSE: Turns pointer events into TUIO cursor frames: scales screen pixels
+         to TUIO coordinates, keeps track of which pointers are down, groups
+         changes into frames and removes cursors whose pointer went quiet.
+         Has no Windows or Qt dependency, so it builds, runs and can be
+         measured anywhere.
+
+NOTES:
+Events are handed to process().  A pointer-down adds the cursor to the open
+frame right away (opening one if needed), a pointer-up removes it, and of
+the updates only the latest position of each pointer is kept until
+commitFrame() sends the frame.  When commitFrame() is called is up to the
+caller: after every event, after a burst of queued events, or on a timer.
+
+Down/up ordering is kept: if a pointer that goes up was added in the open
+frame, or has a move waiting, that frame is committed first, so clients
+always see a short tap and the last position before the cursor goes away.
+An update for an unknown pointer (its down was lost) adds the cursor; an up
+for an unknown pointer is ignored.  A cursor is added with the TUIO 2.0 type
+ID of its pointer type: a pen is a stylus, a mouse or touchpad a mouse, and
+anything else, a finger included, is unknown.  A cursor already stamped with the frame
+time ignores updates, so its move is kept for the next frame.
+
+Everything goes to the TuioCursorServer through a TuioCursorOutputThread.
+Until startOutputThread() is called, that applies each call on the calling
+thread; once started, the server belongs to the output thread.
+
+Frame times come from a clock function, TuioTime::getSessionTime by default.
+With setTimestampFrequency(), a frame is stamped with the timestamp of its
+latest input event instead, so TUIO speeds follow the input rather than
+when it got processed, and the latency from input to frame can be measured
+(see takeLatencyStats()).  Frame times always go up by at least a
+microsecond, so a frame never shares its time with the one before.
+
+A cursor is idle once it has not changed for the max idle time (its pointer
+went up without an up event reaching us).  Every cursor has a deadline in a
+min-heap, rounded up to the expiry precision so that deadlines close
+together share one wakeup.  The heap is lazy: a cursor that changes keeps
+its old entry, and only when that entry comes up is it checked and pushed
+again with the new deadline.  So moving a cursor costs nothing extra, and
+the caller only needs a timer for nextExpiryTime(), which is about once per
+max idle time while fingers are down and never while none are.
+
+A resting finger on a high-rate digitizer keeps sending updates that move
+it by a pixel or not at all.  setDeadBand() holds back an update that is
+within that many pixels of the position last sent, and setQuantization()
+rounds positions to a grid first, so that a finger that only jitters inside
+one grid cell does not move at all.  A held update opens no frame and
+process() returns false for it.  So that the position still converges once
+the finger stops, a held position is sent once it has been held for the
+settle time, either with the next update of that pointer or when the caller
+calls expireIdleCursors() at nextExpiryTime().  It is sent even if it is
+where the cursor already is, to bring the cursor's speed down to 0; after
+that, updates to the same position are dropped.  Held and dropped updates
+count as input for the idle expiry.  With a dead band of 0 and no
+quantization, the default, every update is sent.
+
+The contacts, with the move each has waiting, are kept in one flat array and
+looked up by a linear search: there are rarely more than ten of them, and
+after the first few frames no event allocates memory.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_TOUCHPIPELINE_H
+#define INCLUDED_TOUCHPIPELINE_H
+
+#include "LibExport.h"
+#include "PointerEvent.h"
+#include "TuioTime.h"
+#include <memory>
+#include <vector>
+
+namespace TUIO
+{
+    class TuioCursorServer;
+    class TuioCursorOutputThread;
+
+    /**
+     * <p><code>
+     * TouchPipeline pipeline( tuioCursorServer );<br/>
+     * pipeline.setScreenDimensions( 0, 0, 1920, 1080 );<br/>
+     * ...<br/>
+     * if( pipeline.process( event ) ) {<br/>
+     * &nbsp;&nbsp;pipeline.commitFrame(); // now, or a little later<br/>
+     * }<br/>
+     * ...<br/>
+     * // when TuioTime::getSessionTime() reaches pipeline.nextExpiryTime():<br/>
+     * if( pipeline.expireIdleCursors( TuioTime::getSessionTime() ) > 0 ) {<br/>
+     * &nbsp;&nbsp;pipeline.commitFrame();<br/>
+     * }<br/>
+     * </code></p>
+     */
+    class LIBDECL TouchPipeline
+    {
+    public:
+        typedef TuioTime (*Clock)();
+
+        enum { DEFAULT_MAX_IDLE_TIME = 300,
+               DEFAULT_EXPIRY_PRECISION = 10,
+               DEFAULT_SETTLE_TIME = 50 };
+
+        /**
+         * @param  tuioCursorServer  the server the frames go to; it must
+         *                           outlive this object.
+         */
+        TouchPipeline( TuioCursorServer * tuioCursorServer );
+
+        /**
+         * Stops the output thread after it has sent everything queued.
+         */
+        ~TouchPipeline();
+
+        /**
+         * Starts sending from a thread of its own.  See
+         * TuioCursorOutputThread::start().
+         */
+        bool startOutputThread( int cpu, int priority );
+
+        TuioCursorOutputThread & outputThread() { return *outputThread_; }
+
+        void setScreenDimensions( int x, int y, int width, int height );
+        void setMirroredMonitors( bool b ) { mirroredMonitors_ = b; }
+        int screenOffsetX() const { return screenOffsetX_; }
+        int screenOffsetY() const { return screenOffsetY_; }
+        int screenWidth() const { return screenWidth_; }
+        int screenHeight() const { return screenHeight_; }
+        bool mirroredMonitors() const { return mirroredMonitors_; }
+        float scaledX( int x ) const;
+        float scaledY( int y ) const;
+
+        void setClock( Clock clock ) { clock_ = clock; }
+
+        /**
+         * Stamps frames with the event timestamps.  They must come from the
+         * clock TuioTime reads (QueryPerformanceCounter ticks on Windows,
+         * for instance).  Events with no timestamp are stamped with the
+         * clock, as are all of them if ticksPerSecond is 0, the default.
+         */
+        void setTimestampFrequency( int64_t ticksPerSecond ) { timestampFrequency_ = ticksPerSecond; }
+        int64_t timestampFrequency() const { return timestampFrequency_; }
+
+        /**
+         * The time of the open frame, or of the last one sent.
+         */
+        TuioTime frameTime() const { return frameTime_; }
+
+        /**
+         * @return true if the event changed the open frame or left a move
+         *         waiting, so a commitFrame() is due.
+         */
+        bool process( const PointerEvent & event );
+
+        /**
+         * Applies the latest position of every moved pointer and sends all
+         * changed cursors as one TUIO frame.  Moves of cursors already
+         * stamped with the frame time stay pending (see hasPendingMoves()).
+         */
+        void commitFrame();
+
+        bool isFrameOpen() const { return frameOpen_; }
+        bool hasPendingMoves() const { return movedCount_ > 0; }
+
+        /**
+         * Both in milliseconds.  They apply to deadlines set from now on.
+         */
+        void setMaxIdleTime( unsigned int milliseconds );
+        void setExpiryPrecision( unsigned int milliseconds );
+        unsigned int maxIdleTime() const { return maxIdleTime_; }
+        unsigned int expiryPrecision() const { return expiryPrecision_; }
+
+        /**
+         * Updates within this many screen pixels of the position last sent
+         * are held back.  0 turns the dead band off.
+         */
+        void setDeadBand( float pixels );
+        float deadBand() const { return deadBand_; }
+
+        /**
+         * How long, in milliseconds, a held position waits before it is
+         * sent anyway.
+         */
+        void setSettleTime( unsigned int milliseconds ) { settleTime_ = milliseconds; }
+        unsigned int settleTime() const { return settleTime_; }
+
+        /**
+         * Rounds positions to multiples of 1 / steps of the screen.  0, the
+         * default, keeps them as they are.
+         */
+        void setQuantization( unsigned int steps ) { quantization_ = steps; }
+        unsigned int quantization() const { return quantization_; }
+
+        bool isFiltering() const { return deadBand_ > 0.0f || quantization_ > 0; }
+        bool hasHeldMoves() const { return heldCount_ > 0; }
+
+        /**
+         * @return the session time, in milliseconds, at which
+         *         expireIdleCursors() should next be called, or -1 if no
+         *         cursor is down.  It may turn out that no cursor is idle
+         *         yet by then.  Unlike idle deadlines, this can move earlier
+         *         when an update is held.
+         */
+        long nextExpiryTime();
+
+        /**
+         * Sends every held position that has settled, and removes, in the
+         * open frame, every cursor that has been idle for the max idle
+         * time, rounded up to the expiry precision, and has no move
+         * waiting.
+         *
+         * @return the number of cursors settled or removed; if any were, a
+         *         commitFrame() is due.
+         */
+        unsigned int expireIdleCursors( TuioTime now );
+
+        unsigned int cursorCount() const { return (unsigned int)contacts_.size(); }
+
+        /**
+         * Pointer events processed and frames committed since construction.
+         */
+        unsigned long eventCount() const { return eventCount_; }
+        unsigned long frameCount() const { return frameCount_; }
+
+        /**
+         * Updates held back or dropped by the dead band and quantization,
+         * and held positions sent once they settled, since construction.
+         * Every suppressed update but the settled ones saved a cursor
+         * update in a frame.
+         */
+        unsigned long suppressedCount() const { return suppressedCount_; }
+        unsigned long settledCount() const { return settledCount_; }
+
+        /**
+         * How long after its latest input event each frame was committed,
+         * by the clock.  Only frames stamped with an event timestamp count.
+         */
+        struct LatencyStats
+        {
+            unsigned long frames;
+            int64_t totalMicroseconds,
+                    maxMicroseconds;
+        };
+
+        /**
+         * @return the latency of the frames committed since the last call.
+         */
+        LatencyStats takeLatencyStats();
+
+    private:
+        TouchPipeline( const TouchPipeline & );
+        TouchPipeline & operator=( const TouchPipeline & );
+
+        /**
+         * A pointer that is down, and the latest position it moved to if
+         * that has not been sent yet.
+         */
+        struct Contact
+        {
+            unsigned int id,
+                         serial;     // tells a cursor from an earlier one with the same id
+            TuioTime time,           // the frame the cursor last changed in
+                     input;          // the last update held back or dropped
+            bool moved;
+            float x, y;
+            bool held;               // the dead band holds a position back
+            TuioTime heldSince;
+            float heldX, heldY,
+                  sentX, sentY;      // the position last sent
+            bool sentMoved;          // the last update sent changed the position
+        };
+
+        struct Deadline
+        {
+            long milliseconds;
+            unsigned int id,
+                         serial;
+
+            bool operator>( const Deadline & d ) const { return milliseconds > d.milliseconds; }
+        };
+
+        int findContact( unsigned int id ) const;
+        long deadline( const Contact & contact ) const;
+        long settleDeadline( const Contact & contact ) const;
+        long nextIdleDeadline();
+        float quantized( float v ) const;
+        void hold( Contact & contact, float x, float y );
+        void release( Contact & contact );
+        void pushDeadline( long milliseconds, unsigned int id, unsigned int serial );
+        void popDeadline();
+        void compactDeadlines();
+        void removeContact( int i );
+        void pointerDown( unsigned int id, int typeId, int screenX, int screenY );
+        bool pointerUpdate( unsigned int id, int typeId, int screenX, int screenY );
+        bool pointerUp( unsigned int id );
+        TuioTime nextFrameTime();
+        void openFrame();
+
+        std::vector<Contact> contacts_;
+        unsigned int movedCount_,
+                     heldCount_,
+                     nextSerial_;
+        std::vector<Deadline> deadlines_;    // a min-heap
+        unsigned int maxIdleTime_,
+                     expiryPrecision_;
+        float deadBand_;
+        unsigned int settleTime_,
+                     quantization_;
+        std::unique_ptr<TuioCursorOutputThread> outputThread_;
+        Clock clock_;
+        int64_t timestampFrequency_;
+        bool eventTimeKnown_;
+        TuioTime eventTime_;         // of the latest event with a timestamp
+        bool frameOpen_,
+             frameFromEvent_;        // the open frame is stamped with eventTime_
+        TuioTime frameTime_;
+        LatencyStats latency_;
+        unsigned long eventCount_,
+                      frameCount_,
+                      suppressedCount_,
+                      settledCount_;
+        int screenOffsetX_,
+            screenOffsetY_,
+            screenWidth_,
+            screenHeight_;
+        bool mirroredMonitors_;
+    };
+}
+
+#endif /* INCLUDED_TOUCHPIPELINE_H */
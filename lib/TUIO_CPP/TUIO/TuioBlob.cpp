@@ -83,7 +83,7 @@ void TuioBlob::update (TuioTime ttime, float xp, float yp, float a, float w, flo
 	TuioContainer::update(ttime,xp,yp);
 	
 	TuioTime diffTime = currentTime - lastPoint.getTuioTime();
-	float dt = diffTime.getTotalMilliseconds()/1000.0f;
+	float dt = diffTime.getTotalMicroseconds()/(float)USEC_SECOND;
 	float last_angle = angle;
 	float last_rotation_speed = rotation_speed;
 	angle = a;
@@ -96,8 +96,10 @@ void TuioBlob::update (TuioTime ttime, float xp, float yp, float a, float w, flo
 	height = h;
 	area = f;
 	
-	rotation_speed = (float)da/dt;
-	rotation_accel =  (rotation_speed - last_rotation_speed)/dt;
+	if (dt>0) {
+		rotation_speed = (float)da/dt;
+		rotation_accel =  (rotation_speed - last_rotation_speed)/dt;
+	}
 	
 	if ((rotation_accel!=0) && (state==TUIO_STOPPED)) state = TUIO_ROTATING;
 }
@@ -21,6 +21,7 @@
 
 #include "TuioClient.h"
 #include "UdpReceiver.h"
+#include "osc/OscFixedMessage.h"
 
 using namespace TUIO;
 using namespace osc;
@@ -28,6 +29,7 @@ using namespace osc;
 
 TuioClient::TuioClient()
 : currentFrame	(-1)
+, tuio2Frame	(-1)
 , source_id		(0)
 , source_name	(NULL)
 , source_addr	(NULL)
@@ -39,6 +41,7 @@ TuioClient::TuioClient()
 
 TuioClient::TuioClient(int port)
 : currentFrame	(-1)
+, tuio2Frame	(-1)
 , source_id		(0)
 , source_name	(NULL)
 , source_addr	(NULL)
@@ -50,6 +53,7 @@ TuioClient::TuioClient(int port)
 
 TuioClient::TuioClient(OscReceiver *osc)
 : currentFrame	(-1)
+, tuio2Frame	(-1)
 , source_id		(0)
 , source_name	(NULL)
 , source_addr	(NULL)
@@ -69,17 +73,336 @@ TuioClient::~TuioClient() {
 	if (local_receiver) delete receiver;
 }
 
+/**
+ * The profile addresses all start with "/tuio/2D", and the TUIO 2.0 ones
+ * with "/tuio2/", so one compare of that and of the three characters after
+ * it tells them apart.
+ */
+int TuioClient::addressToken(const char *address) {
+	bool tuio2 = strncmp(address,"/tuio2/",7)==0;
+	if (!tuio2 && strncmp(address,"/tuio/2D",8)!=0) return ADDRESS_OTHER;
+	const char *profile = address+(tuio2 ? 7 : 8);
+	if (profile[0]=='\0' || profile[1]=='\0' || profile[2]=='\0' || profile[3]!='\0') return ADDRESS_OTHER;
+	
+	if (tuio2) {
+		switch (profile[0]) {
+			case 'f': if (profile[1]=='r' && profile[2]=='m') return ADDRESS_TUIO2_FRM; break;
+			case 'p': if (profile[1]=='t' && profile[2]=='r') return ADDRESS_TUIO2_PTR; break;
+			case 'a': if (profile[1]=='l' && profile[2]=='v') return ADDRESS_TUIO2_ALV; break;
+		}
+		return ADDRESS_OTHER;
+	}
+	switch (profile[0]) {
+		case 'o': if (profile[1]=='b' && profile[2]=='j') return ADDRESS_2DOBJ; break;
+		case 'c': if (profile[1]=='u' && profile[2]=='r') return ADDRESS_2DCUR; break;
+		case 'b': if (profile[1]=='l' && profile[2]=='b') return ADDRESS_2DBLB; break;
+	}
+	return ADDRESS_OTHER;
+}
+
+/**
+ * Set, alive and fseq come in every frame; source only once per bundle,
+ * if at all.
+ */
+int TuioClient::commandToken(const char *command) {
+	switch (command[0]) {
+		case 's':
+			if (command[1]=='e' && command[2]=='t' && command[3]=='\0') return COMMAND_SET;
+			if (strcmp(command+1,"ource")==0) return COMMAND_SOURCE;
+			break;
+		case 'a':
+			if (strcmp(command+1,"live")==0) return COMMAND_ALIVE;
+			break;
+		case 'f':
+			if (strcmp(command+1,"seq")==0) return COMMAND_FSEQ;
+			break;
+	}
+	return COMMAND_OTHER;
+}
+
+/**
+ * The set message of each profile has a fixed shape: the command, the int32
+ * IDs and a block of floats.  A /tuio2/ptr message has no command and comes
+ * with or without the five speeds after its six floats.
+ */
+bool TuioClient::processSetMessage(const char *message, unsigned long size) {
+	if (size<12) return false;
+	
+	if (memcmp(message,"/tuio2/ptr",11)==0) {
+		osc::FixedMessage<3,6> ptr;
+		if (ptr.Decode(message,size,"/tuio2/ptr",NULL)) {
+			setTuioCursor(ptr.ints[0],ptr.floats[0],ptr.floats[1],0.0f,0.0f,0.0f);
+			return true;
+		}
+		osc::FixedMessage<3,11> movingPtr;
+		if (!movingPtr.Decode(message,size,"/tuio2/ptr",NULL)) return false;
+		const float *f = movingPtr.floats; // x y angle shear radius press, x_vel y_vel p_vel m_acc p_acc
+		setTuioCursor(movingPtr.ints[0],f[0],f[1],f[6],f[7],f[9]);
+		return true;
+	}
+	if (strncmp(message,"/tuio/2D",8)!=0) return false;
+	
+	switch (message[8]) {
+		case 'c': {
+			osc::FixedMessage<1,5> set;
+			if (!set.Decode(message,size,"/tuio/2Dcur","set")) return false;
+			const float *f = set.floats;
+			setTuioCursor(set.ints[0],f[0],f[1],f[2],f[3],f[4]);
+			return true;
+		}
+		case 'o': {
+			osc::FixedMessage<2,8> set;
+			if (!set.Decode(message,size,"/tuio/2Dobj","set")) return false;
+			const float *f = set.floats;
+			setTuioObject(set.ints[0],set.ints[1],f[0],f[1],f[2],f[3],f[4],f[5],f[6],f[7]);
+			return true;
+		}
+		case 'b': {
+			osc::FixedMessage<1,11> set;
+			if (!set.Decode(message,size,"/tuio/2Dblb","set")) return false;
+			const float *f = set.floats;
+			setTuioBlob(set.ints[0],f[0],f[1],f[2],f[3],f[4],f[5],f[6],f[7],f[8],f[9],f[10]);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TuioClient::setTuioObject(int32 s_id, int32 c_id, float xpos, float ypos, float angle, float xspeed, float yspeed, float rspeed, float maccel, float raccel) {
+	lockObjectList();
+	TuioObject *tobj = objectIndex.find(source_id,(long)s_id);
+
+	if (tobj == NULL) {
+		
+		frameObjects.push_back(objectPool.frameCopy(TuioObject((long)s_id,(int)c_id,xpos,ypos,angle)));
+
+	} else if ( (tobj->getX()!=xpos) || (tobj->getY()!=ypos) || (tobj->getAngle()!=angle) || (tobj->getXSpeed()!=xspeed) || (tobj->getYSpeed()!=yspeed) || (tobj->getRotationSpeed()!=rspeed) || (tobj->getMotionAccel()!=maccel) || (tobj->getRotationAccel()!=raccel) ) {
+
+		TuioObject updateObject((long)s_id,tobj->getSymbolID(),xpos,ypos,angle);
+		updateObject.update(xpos,ypos,angle,xspeed,yspeed,rspeed,maccel,raccel);
+		frameObjects.push_back(objectPool.frameCopy(updateObject));
+
+	}
+	unlockObjectList();
+}
+
+void TuioClient::setTuioCursor(int32 s_id, float xpos, float ypos, float xspeed, float yspeed, float maccel) {
+	lockCursorList();
+	TuioCursor *tcur = cursorIndex.find(source_id,(long)s_id);
+	
+	if (tcur==NULL) {
+						
+		frameCursors.push_back(cursorPool.frameCopy(TuioCursor((long)s_id,-1,xpos,ypos)));
+
+	} else if ( (tcur->getX()!=xpos) || (tcur->getY()!=ypos) || (tcur->getXSpeed()!=xspeed) || (tcur->getYSpeed()!=yspeed) || (tcur->getMotionAccel()!=maccel) ) {
+
+		TuioCursor updateCursor((long)s_id,tcur->getCursorID(),xpos,ypos);
+		updateCursor.update(xpos,ypos,xspeed,yspeed,maccel);
+		frameCursors.push_back(cursorPool.frameCopy(updateCursor));
+
+	}
+	unlockCursorList();
+}
+
+void TuioClient::setTuioBlob(int32 s_id, float xpos, float ypos, float angle, float width, float height, float area, float xspeed, float yspeed, float rspeed, float maccel, float raccel) {
+	lockBlobList();
+	TuioBlob *tblb = blobIndex.find(source_id,(long)s_id);
+	
+	if (tblb==NULL) {
+		
+		frameBlobs.push_back(blobPool.frameCopy(TuioBlob((long)s_id,-1,xpos,ypos,angle,width,height,area)));
+		
+	} else if ( (tblb->getX()!=xpos) || (tblb->getY()!=ypos) || (tblb->getAngle()!=angle) || (tblb->getWidth()!=width) || (tblb->getHeight()!=height) || (tblb->getArea()!=area) || (tblb->getXSpeed()!=xspeed) || (tblb->getYSpeed()!=yspeed) || (tblb->getMotionAccel()!=maccel) ) {
+		
+		TuioBlob updateBlob((long)s_id,tblb->getBlobID(),xpos,ypos,angle,width,height,area);
+		updateBlob.update(xpos,ypos,angle,width,height,area,xspeed,yspeed,rspeed,maccel,raccel);
+		frameBlobs.push_back(blobPool.frameCopy(updateBlob));
+	}
+	unlockBlobList();
+}
+
+/**
+ * Hands the cursors of a finished frame (a /tuio/2Dcur fseq or a /tuio2/alv
+ * message) to the listeners, unless the frame came late.
+ */
+void TuioClient::commitCursorFrame(bool lateFrame) {
+	if (!lateFrame) {
+		
+		lockCursorList();
+		// find the removed cursors first
+		for (std::list<TuioCursor*>::iterator tcur=cursorList.begin(); tcur != cursorList.end(); tcur++) {
+			if (((*tcur)->getTuioSourceID()==source_id) && !cursorIndex.isAlive(*tcur)) {
+				(*tcur)->remove(currentTime);
+				frameCursors.push_back(*tcur);
+			}
+		}
+		unlockCursorList();
+		
+		for (std::vector<TuioCursor*>::iterator iter=frameCursors.begin(); iter != frameCursors.end(); iter++) {
+			TuioCursor *tcur = (*iter);
+			
+			int c_id = 0;
+			int free_size = 0;
+			TuioCursor *frameCursor = NULL;
+			switch (tcur->getTuioState()) {
+				case TUIO_REMOVED:
+		
+					frameCursor = tcur;
+					frameCursor->remove(currentTime);
+	
+					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
+						(*listener)->removeTuioCursor(frameCursor);
+
+					lockCursorList();
+					{
+						std::list<TuioCursor*>::iterator delcur;
+						if (cursorIndex.remove(source_id,frameCursor->getSessionID(),delcur)) cursorList.erase(delcur);
+					}
+
+					if (frameCursor->getCursorID()==maxCursorID[source_id]) {
+						maxCursorID[source_id] = -1;
+						cursorPool.release(frameCursor);
+						
+						if (cursorList.size()>0) {
+							std::list<TuioCursor*>::iterator clist;
+							for (clist=cursorList.begin(); clist != cursorList.end(); clist++) {
+								if ((*clist)->getTuioSourceID()==source_id) {
+									c_id = (*clist)->getCursorID();
+									if (c_id>maxCursorID[source_id]) maxCursorID[source_id]=c_id;
+								}
+							}
+
+							freeCursorBuffer.clear();
+							for (std::list<TuioCursor*>::iterator flist=freeCursorList.begin(); flist != freeCursorList.end(); flist++) {
+								TuioCursor *freeCursor = (*flist);
+								if (freeCursor->getTuioSourceID()==source_id) {
+									if (freeCursor->getCursorID()>maxCursorID[source_id]) {
+										cursorPool.release(freeCursor);
+										cursorIndex.removeFree(source_id);
+									} else freeCursorBuffer.push_back(freeCursor);
+								} else freeCursorBuffer.push_back(freeCursor);
+							}	
+							freeCursorList = freeCursorBuffer;
+
+						} else {
+							freeCursorBuffer.clear();
+							for (std::list<TuioCursor*>::iterator flist=freeCursorList.begin(); flist != freeCursorList.end(); flist++) {
+								TuioCursor *freeCursor = (*flist);
+								if (freeCursor->getTuioSourceID()==source_id) {
+									cursorPool.release(freeCursor);
+									cursorIndex.removeFree(source_id);
+								} else freeCursorBuffer.push_back(freeCursor);
+							}	
+							freeCursorList = freeCursorBuffer;
+							
+						}
+					} else if (frameCursor->getCursorID()<maxCursorID[source_id]) {
+						freeCursorList.push_back(frameCursor);
+						cursorIndex.addFree(source_id);
+					} 
+					
+					unlockCursorList();
+					break;
+				case TUIO_ADDED:
+					
+					lockCursorList();
+					c_id = (int)cursorIndex.liveCount(source_id);
+					free_size = (int)cursorIndex.freeCount(source_id);
+					
+					if ((free_size<=maxCursorID[source_id]) && (free_size>0)) {
+						std::list<TuioCursor*>::iterator closestCursor = freeCursorList.begin();
+						
+						for(std::list<TuioCursor*>::iterator iter = freeCursorList.begin();iter!= freeCursorList.end(); iter++) {
+							if (((*iter)->getTuioSourceID()==source_id) && ((*iter)->getDistance(tcur)<(*closestCursor)->getDistance(tcur))) closestCursor = iter;
+						}
+						
+						if (closestCursor!=freeCursorList.end()) {
+							TuioCursor *freeCursor = (*closestCursor);
+							c_id = freeCursor->getCursorID();
+							freeCursorList.erase(closestCursor);
+							cursorIndex.removeFree(freeCursor->getTuioSourceID());
+							cursorPool.release(freeCursor);
+						}
+					} else maxCursorID[source_id] = c_id;									
+					
+					frameCursor = cursorPool.make(TuioCursor(currentTime,tcur->getSessionID(),c_id,tcur->getX(),tcur->getY()));
+					if (source_name) frameCursor->setTuioSource(source_id,source_name,source_addr);
+					cursorList.push_back(frameCursor);
+					cursorIndex.add(frameCursor,--cursorList.end());
+					
+					unlockCursorList();
+					
+					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
+						(*listener)->addTuioCursor(frameCursor);
+					
+					break;
+				default:
+					
+					lockCursorList();
+					frameCursor = cursorIndex.find(source_id,tcur->getSessionID());
+					
+					if (frameCursor==NULL) {
+						unlockCursorList();
+						break;
+					}
+					
+					if ( (tcur->getX()!=frameCursor->getX() && tcur->getXSpeed()==0) || (tcur->getY()!=frameCursor->getY() && tcur->getYSpeed()==0) )
+						frameCursor->update(currentTime,tcur->getX(),tcur->getY());
+					else
+						frameCursor->update(currentTime,tcur->getX(),tcur->getY(),tcur->getXSpeed(),tcur->getYSpeed(),tcur->getMotionAccel());
+
+					unlockCursorList();
+
+					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
+						(*listener)->updateTuioCursor(frameCursor);
+
+			}	
+		}
+		
+		for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
+			(*listener)->refresh(currentTime);
+		
+	}
+	
+	frameCursors.clear();
+	cursorPool.resetFrame();
+}
+
+/**
+ * A TUIO 2.0 frame carries the sender's time.  The first frame of a source
+ * ties it to the session time; later frames keep the sender's spacing, so
+ * the cursor speeds follow the input and not the network.  If the two drift
+ * more than a second apart (a restarted sender), they are tied again.
+ */
+TuioTime TuioClient::tuio2FrameTime(uint64 timeTag) {
+	int64_t senderTime = (int64_t)(timeTag>>32)*USEC_SECOND + (int64_t)(((timeTag&0xFFFFFFFFULL)*USEC_SECOND)>>32);
+	int64_t sessionTime = TuioTime::getSessionTime().getTotalMicroseconds();
+	
+	std::map<int,int64_t>::iterator offset = tuio2TimeOffset.find(source_id);
+	if (offset==tuio2TimeOffset.end()) offset = tuio2TimeOffset.insert(std::make_pair(source_id,sessionTime-senderTime)).first;
+	
+	int64_t frameTime = senderTime+offset->second;
+	if (frameTime-sessionTime>USEC_SECOND || sessionTime-frameTime>USEC_SECOND) {
+		offset->second = sessionTime-senderTime;
+		frameTime = sessionTime;
+	}
+	return TuioTime((long)(frameTime/USEC_SECOND),(long)(frameTime%USEC_SECOND));
+}
+
 void TuioClient::processOSC( const ReceivedMessage& msg ) {
 	try {
 		ReceivedMessageArgumentStream args = msg.ArgumentStream();
 		ReceivedMessage::const_iterator arg = msg.ArgumentsBegin();
 		
-		if( strcmp( msg.AddressPattern(), "/tuio/2Dobj" ) == 0 ){
+		int address = addressToken(msg.AddressPattern());
+		
+		if (address==ADDRESS_2DOBJ) {
 			
 			const char* cmd;
 			args >> cmd;
+			int command = commandToken(cmd);
 			
-			if (strcmp(cmd,"source")==0) {
+			if (command==COMMAND_SOURCE) {
 				const char* src;
 				args >> src;
 				
@@ -102,40 +425,25 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 					source_id = sourceList[source_str];
 				}
 				
-			} else if (strcmp(cmd,"set")==0) {	
+			} else if (command==COMMAND_SET) {	
 				int32 s_id, c_id;
 				float xpos, ypos, angle, xspeed, yspeed, rspeed, maccel, raccel;
 				args >> s_id >> c_id >> xpos >> ypos >> angle >> xspeed >> yspeed >> rspeed >> maccel >> raccel;
 
-				lockObjectList();
-				std::list<TuioObject*>::iterator tobj;
-				for (tobj=objectList.begin(); tobj!= objectList.end(); tobj++)
-					if((*tobj)->getSessionID()==(long)s_id) break;
-
-				if (tobj == objectList.end()) {
-					
-					TuioObject *addObject = new TuioObject((long)s_id,(int)c_id,xpos,ypos,angle);
-					frameObjects.push_back(addObject);
-
-				} else if ( ((*tobj)->getX()!=xpos) || ((*tobj)->getY()!=ypos) || ((*tobj)->getAngle()!=angle) || ((*tobj)->getXSpeed()!=xspeed) || ((*tobj)->getYSpeed()!=yspeed) || ((*tobj)->getRotationSpeed()!=rspeed) || ((*tobj)->getMotionAccel()!=maccel) || ((*tobj)->getRotationAccel()!=raccel) ) {
-
-					TuioObject *updateObject = new TuioObject((long)s_id,(*tobj)->getSymbolID(),xpos,ypos,angle);
-					updateObject->update(xpos,ypos,angle,xspeed,yspeed,rspeed,maccel,raccel);
-					frameObjects.push_back(updateObject);
+				setTuioObject(s_id,c_id,xpos,ypos,angle,xspeed,yspeed,rspeed,maccel,raccel);
 
-				}
-				unlockObjectList();
-
-			} else if (strcmp(cmd,"alive")==0) {
+			} else if (command==COMMAND_ALIVE) {
 
 				int32 s_id;
-				aliveObjectList.clear();
+				lockObjectList();
+				objectIndex.beginAlive();
 				while(!args.Eos()) {
 					args >> s_id;
-					aliveObjectList.push_back((long)s_id);
+					objectIndex.markAlive(source_id,(long)s_id);
 				}
+				unlockObjectList();
 
-			} else if (strcmp(cmd,"fseq")==0) {
+			} else if (command==COMMAND_FSEQ) {
 
 				int32 fseq;
 				args >> fseq;
@@ -153,17 +461,14 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 					lockObjectList();
 					//find the removed objects first
 					for (std::list<TuioObject*>::iterator tobj=objectList.begin(); tobj != objectList.end(); tobj++) {
-						if ((*tobj)->getTuioSourceID()==source_id) {
-							std::list<long>::iterator iter = find(aliveObjectList.begin(), aliveObjectList.end(), (*tobj)->getSessionID());
-							if (iter == aliveObjectList.end()) {
-								(*tobj)->remove(currentTime);
-								frameObjects.push_back(*tobj);							
-							}
+						if (((*tobj)->getTuioSourceID()==source_id) && !objectIndex.isAlive(*tobj)) {
+							(*tobj)->remove(currentTime);
+							frameObjects.push_back(*tobj);
 						}
 					}
 					unlockObjectList();
 					
-					for (std::list<TuioObject*>::iterator iter=frameObjects.begin(); iter != frameObjects.end(); iter++) {
+					for (std::vector<TuioObject*>::iterator iter=frameObjects.begin(); iter != frameObjects.end(); iter++) {
 						TuioObject *tobj = (*iter);
 
 						TuioObject *frameObject = NULL;
@@ -177,20 +482,20 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 									(*listener)->removeTuioObject(frameObject);
 
 								lockObjectList();
-								for (std::list<TuioObject*>::iterator delobj=objectList.begin(); delobj!=objectList.end(); delobj++) {
-									if((*delobj)->getSessionID()==frameObject->getSessionID()) {
-										objectList.erase(delobj);
-										break;
-									}
+								{
+									std::list<TuioObject*>::iterator delobj;
+									if (objectIndex.remove(source_id,frameObject->getSessionID(),delobj)) objectList.erase(delobj);
 								}
 								unlockObjectList();
+								objectPool.release(frameObject);
 								break;
 							case TUIO_ADDED:
 
 								lockObjectList();
-								frameObject = new TuioObject(currentTime,tobj->getSessionID(),tobj->getSymbolID(),tobj->getX(),tobj->getY(),tobj->getAngle());
+								frameObject = objectPool.make(TuioObject(currentTime,tobj->getSessionID(),tobj->getSymbolID(),tobj->getX(),tobj->getY(),tobj->getAngle()));
 								if (source_name) frameObject->setTuioSource(source_id,source_name,source_addr);
 								objectList.push_back(frameObject);
+								objectIndex.add(frameObject,--objectList.end());
 								unlockObjectList();
 								
 								for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
@@ -200,15 +505,9 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 							default:
 
 								lockObjectList();
-								std::list<TuioObject*>::iterator iter;
-								for (iter=objectList.begin(); iter != objectList.end(); iter++) {
-									if (((*iter)->getTuioSourceID()==source_id) && ((*iter)->getSessionID()==tobj->getSessionID())) {
-										frameObject = (*iter);
-										break;
-									}
-								}	
+								frameObject = objectIndex.find(source_id,tobj->getSessionID());
 								
-								if (iter==objectList.end()) {
+								if (frameObject==NULL) {
 									unlockObjectList();
 									break;
 								}
@@ -223,26 +522,22 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 								for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
 									(*listener)->updateTuioObject(frameObject);
 						}
-						delete tobj;
 					}
 					
 					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
 						(*listener)->refresh(currentTime);
 					
-				} else {
-					for (std::list<TuioObject*>::iterator iter=frameObjects.begin(); iter != frameObjects.end(); iter++) {
-						TuioObject *tobj = (*iter);
-						delete tobj;
-					}
 				}
 				
 				frameObjects.clear();
+				objectPool.resetFrame();
 			}
-		} else if( strcmp( msg.AddressPattern(), "/tuio/2Dcur" ) == 0 ) {
+		} else if (address==ADDRESS_2DCUR) {
 			const char* cmd;
 			args >> cmd;
+			int command = commandToken(cmd);
 			
-			if (strcmp(cmd,"source")==0) {
+			if (command==COMMAND_SOURCE) {
 				const char* src;
 				args >> src;
 				
@@ -266,41 +561,26 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 					source_id = sourceList[source_str];
 				}
 				
-			} else if (strcmp(cmd,"set")==0) {	
+			} else if (command==COMMAND_SET) {	
 
 				int32 s_id;
 				float xpos, ypos, xspeed, yspeed, maccel;				
 				args >> s_id >> xpos >> ypos >> xspeed >> yspeed >> maccel;
 				
-				lockCursorList();
-				std::list<TuioCursor*>::iterator tcur;
-				for (tcur=cursorList.begin(); tcur!= cursorList.end(); tcur++)
-					if (((*tcur)->getSessionID()==(long)s_id) && ((*tcur)->getTuioSourceID()==source_id)) break;
-				
-				if (tcur==cursorList.end()) {
-									
-					TuioCursor *addCursor = new TuioCursor((long)s_id,-1,xpos,ypos);
-					frameCursors.push_back(addCursor);
-
-				} else if ( ((*tcur)->getX()!=xpos) || ((*tcur)->getY()!=ypos) || ((*tcur)->getXSpeed()!=xspeed) || ((*tcur)->getYSpeed()!=yspeed) || ((*tcur)->getMotionAccel()!=maccel) ) {
-
-					TuioCursor *updateCursor = new TuioCursor((long)s_id,(*tcur)->getCursorID(),xpos,ypos);
-					updateCursor->update(xpos,ypos,xspeed,yspeed,maccel);
-					frameCursors.push_back(updateCursor);
-
-				}
-				unlockCursorList();
+				setTuioCursor(s_id,xpos,ypos,xspeed,yspeed,maccel);
 				
-			} else if (strcmp(cmd,"alive")==0) {
+			} else if (command==COMMAND_ALIVE) {
 				
 				int32 s_id;
-				aliveCursorList.clear();
+				lockCursorList();
+				cursorIndex.beginAlive();
 				while(!args.Eos()) {
 					args >> s_id;
-					aliveCursorList.push_back((long)s_id);
+					cursorIndex.markAlive(source_id,(long)s_id);
 				}
+				unlockCursorList();
 				
-			} else if( strcmp( cmd, "fseq" ) == 0 ) {
+			} else if (command==COMMAND_FSEQ) {
 				int32 fseq;
 				args >> fseq;
 				bool lateFrame = false;
@@ -312,166 +592,74 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 					currentTime = TuioTime::getSessionTime();
 				}
 			
-				if (!lateFrame) {
-					
-					lockCursorList();
-					// find the removed cursors first
-					for (std::list<TuioCursor*>::iterator tcur=cursorList.begin(); tcur != cursorList.end(); tcur++) {
-						if ((*tcur)->getTuioSourceID()==source_id) {
-							std::list<long>::iterator iter = find(aliveCursorList.begin(), aliveCursorList.end(), (*tcur)->getSessionID());
-							
-							if (iter == aliveCursorList.end()) {
-									(*tcur)->remove(currentTime);
-									frameCursors.push_back(*tcur);
-							}
-						}
-					}
-					unlockCursorList();
-					
-					for (std::list<TuioCursor*>::iterator iter=frameCursors.begin(); iter != frameCursors.end(); iter++) {
-						TuioCursor *tcur = (*iter);
-						
-						int c_id = 0;
-						int free_size = 0;
-						TuioCursor *frameCursor = NULL;
-						switch (tcur->getTuioState()) {
-							case TUIO_REMOVED:
-		
-								frameCursor = tcur;
-								frameCursor->remove(currentTime);
-	
-								for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
-									(*listener)->removeTuioCursor(frameCursor);
-
-								lockCursorList();
-								for (std::list<TuioCursor*>::iterator delcur=cursorList.begin(); delcur!=cursorList.end(); delcur++) {
-									if(((*delcur)->getTuioSourceID()==source_id) && ((*delcur)->getSessionID()==frameCursor->getSessionID())) {
-										cursorList.erase(delcur);
-										break;
-									}
-								}
-
-								if (frameCursor->getCursorID()==maxCursorID[source_id]) {
-									maxCursorID[source_id] = -1;
-									delete frameCursor;
-									
-									if (cursorList.size()>0) {
-										std::list<TuioCursor*>::iterator clist;
-										for (clist=cursorList.begin(); clist != cursorList.end(); clist++) {
-											if ((*clist)->getTuioSourceID()==source_id) {
-												c_id = (*clist)->getCursorID();
-												if (c_id>maxCursorID[source_id]) maxCursorID[source_id]=c_id;
-											}
-										}
+				commitCursorFrame(lateFrame);
+			}
+		} else if (address==ADDRESS_TUIO2_FRM) {
+			int32 fseq, dim;
+			TimeTag time;
+			const char* src;
+			args >> fseq >> time >> dim >> src;
 			
-										freeCursorBuffer.clear();
-										for (std::list<TuioCursor*>::iterator flist=freeCursorList.begin(); flist != freeCursorList.end(); flist++) {
-											TuioCursor *freeCursor = (*flist);
-											if (freeCursor->getTuioSourceID()==source_id) {
-												if (freeCursor->getCursorID()>maxCursorID[source_id]) delete freeCursor;
-												else freeCursorBuffer.push_back(freeCursor);
-											} else freeCursorBuffer.push_back(freeCursor);
-										}	
-										freeCursorList = freeCursorBuffer;
-
-									} else {
-										freeCursorBuffer.clear();
-										for (std::list<TuioCursor*>::iterator flist=freeCursorList.begin(); flist != freeCursorList.end(); flist++) {
-											TuioCursor *freeCursor = (*flist);
-											if (freeCursor->getTuioSourceID()==source_id) delete freeCursor;
-											else freeCursorBuffer.push_back(freeCursor);
-										}	
-										freeCursorList = freeCursorBuffer;
-										
-									}
-								} else if (frameCursor->getCursorID()<maxCursorID[source_id]) {
-									freeCursorList.push_back(frameCursor);
-								} 
-								
-								unlockCursorList();
-								break;
-							case TUIO_ADDED:
-								
-								lockCursorList();
-								for(std::list<TuioCursor*>::iterator iter = cursorList.begin();iter!= cursorList.end(); iter++)
-									if ((*iter)->getTuioSourceID()==source_id) c_id++;
-								
-								for(std::list<TuioCursor*>::iterator iter = freeCursorList.begin();iter!= freeCursorList.end(); iter++)
-									if ((*iter)->getTuioSourceID()==source_id) free_size++;
-								
-								if ((free_size<=maxCursorID[source_id]) && (free_size>0)) {
-									std::list<TuioCursor*>::iterator closestCursor = freeCursorList.begin();
-									
-									for(std::list<TuioCursor*>::iterator iter = freeCursorList.begin();iter!= freeCursorList.end(); iter++) {
-										if (((*iter)->getTuioSourceID()==source_id) && ((*iter)->getDistance(tcur)<(*closestCursor)->getDistance(tcur))) closestCursor = iter;
-									}
-									
-									if (closestCursor!=freeCursorList.end()) {
-										TuioCursor *freeCursor = (*closestCursor);
-										c_id = freeCursor->getCursorID();
-										freeCursorList.erase(closestCursor);
-										delete freeCursor;
-									}
-								} else maxCursorID[source_id] = c_id;									
-								
-								frameCursor = new TuioCursor(currentTime,tcur->getSessionID(),c_id,tcur->getX(),tcur->getY());
-								if (source_name) frameCursor->setTuioSource(source_id,source_name,source_addr);
-								cursorList.push_back(frameCursor);
-								
-								delete tcur;
-								unlockCursorList();
-								
-								for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
-									(*listener)->addTuioCursor(frameCursor);
-								
-								break;
-							default:
-								
-								lockCursorList();
-								std::list<TuioCursor*>::iterator iter;
-								for (iter=cursorList.begin(); iter != cursorList.end(); iter++) {
-									if (((*iter)->getTuioSourceID()==source_id) && ((*iter)->getSessionID()==tcur->getSessionID())) {
-										frameCursor = (*iter);
-										break;
-									}
-								}	
-								
-								if (iter==cursorList.end()) {
-									unlockCursorList();
-									break;
-								}
-								
-								if ( (tcur->getX()!=frameCursor->getX() && tcur->getXSpeed()==0) || (tcur->getY()!=frameCursor->getY() && tcur->getYSpeed()==0) )
-									frameCursor->update(currentTime,tcur->getX(),tcur->getY());
-								else
-									frameCursor->update(currentTime,tcur->getX(),tcur->getY(),tcur->getXSpeed(),tcur->getYSpeed(),tcur->getMotionAccel());
+			// "name:instance@address"
+			source_name = strtok((char*)src, "@");
+			char *addr = strtok(NULL, "@");
 			
-								delete tcur;
-								unlockCursorList();
-
-								for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
-									(*listener)->updateTuioCursor(frameCursor);
-
-						}	
-					}
-					
-					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
-						(*listener)->refresh(currentTime);
-					
-				} else {
-					for (std::list<TuioCursor*>::iterator iter=frameCursors.begin(); iter != frameCursors.end(); iter++) {
-						TuioCursor *tcur = (*iter);
-						delete tcur;
-					}
-				}
-				
-				frameCursors.clear();
+			if (addr!=NULL) source_addr = addr;
+			else source_addr = (char*)"localhost";
+			
+			std::string source_str(src);
+			std::map<std::string,int>::iterator iter = sourceList.find(source_str);
+			
+			if (iter==sourceList.end()) {
+				source_id = sourceList.size();
+				sourceList[source_str] = source_id;
+				maxCursorID[source_id] = -1;
+			} else {
+				source_id = iter->second;
 			}
-		} else if( strcmp( msg.AddressPattern(), "/tuio/2Dblb" ) == 0 ){
+			
+			tuio2Frame = fseq;
+			tuio2Time = tuio2FrameTime(time.value);
+			
+		} else if (address==ADDRESS_TUIO2_PTR) {
+			// a pointer of a shape processSetMessage() does not take
+			int32 s_id, tu_id, c_id;
+			float xpos, ypos, angle, shear, radius, press;
+			float xspeed = 0.0f, yspeed = 0.0f, pspeed = 0.0f, maccel = 0.0f;
+			args >> s_id >> tu_id >> c_id >> xpos >> ypos >> angle >> shear >> radius >> press;
+			if (!args.Eos()) args >> xspeed;
+			if (!args.Eos()) args >> yspeed;
+			if (!args.Eos()) args >> pspeed;
+			if (!args.Eos()) args >> maccel;
+			
+			setTuioCursor(s_id,xpos,ypos,xspeed,yspeed,maccel);
+			
+		} else if (address==ADDRESS_TUIO2_ALV) {
+			// the alive message ends a TUIO 2.0 frame
+			int32 s_id;
+			lockCursorList();
+			cursorIndex.beginAlive();
+			while(!args.Eos()) {
+				args >> s_id;
+				cursorIndex.markAlive(source_id,(long)s_id);
+			}
+			unlockCursorList();
+			
+			bool lateFrame = false;
+			if (tuio2Frame>0) {
+				if ((tuio2Frame>=currentFrame) || ((currentFrame-tuio2Frame)>100)) currentFrame = tuio2Frame;
+				else lateFrame = true;
+			}
+			if (!lateFrame) currentTime = tuio2Time;
+			
+			commitCursorFrame(lateFrame);
+			
+		} else if (address==ADDRESS_2DBLB) {
 			const char* cmd;
 			args >> cmd;
+			int command = commandToken(cmd);
 			
-			if (strcmp(cmd,"source")==0) {	
+			if (command==COMMAND_SOURCE) {	
 				const char* src;
 				args >> src;
 				
@@ -495,40 +683,26 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 					source_id = sourceList[source_str];
 				}
 				
-			} else if (strcmp(cmd,"set")==0) {	
+			} else if (command==COMMAND_SET) {	
 				
 				int32 s_id;
 				float xpos, ypos, angle, width, height, area, xspeed, yspeed, rspeed, maccel, raccel;				
 				args >> s_id >> xpos >> ypos >> angle >> width >> height >> area >> xspeed >> yspeed >> rspeed >> maccel >> raccel;
 				
-				lockBlobList();
-				std::list<TuioBlob*>::iterator tblb;
-				for (tblb=blobList.begin(); tblb!= blobList.end(); tblb++)
-					if((*tblb)->getSessionID()==(long)s_id) break;
+				setTuioBlob(s_id,xpos,ypos,angle,width,height,area,xspeed,yspeed,rspeed,maccel,raccel);
 				
-				if (tblb==blobList.end()) {
-					
-					TuioBlob *addBlob = new TuioBlob((long)s_id,-1,xpos,ypos,angle,width,height,area);
-					frameBlobs.push_back(addBlob);
-					
-				} else if ( ((*tblb)->getX()!=xpos) || ((*tblb)->getY()!=ypos) || ((*tblb)->getAngle()!=angle) || ((*tblb)->getWidth()!=width) || ((*tblb)->getHeight()!=height) || ((*tblb)->getArea()!=area) || ((*tblb)->getXSpeed()!=xspeed) || ((*tblb)->getYSpeed()!=yspeed) || ((*tblb)->getMotionAccel()!=maccel) ) {
-					
-					TuioBlob *updateBlob = new TuioBlob((long)s_id,(*tblb)->getBlobID(),xpos,ypos,angle,width,height,area);
-					updateBlob->update(xpos,ypos,angle,width,height,area,xspeed,yspeed,rspeed,maccel,raccel);
-					frameBlobs.push_back(updateBlob);
-				}
-				unlockBlobList();
-				
-			} else if (strcmp(cmd,"alive")==0) {
+			} else if (command==COMMAND_ALIVE) {
 				
 				int32 s_id;
-				aliveBlobList.clear();
+				lockBlobList();
+				blobIndex.beginAlive();
 				while(!args.Eos()) {
 					args >> s_id;
-					aliveBlobList.push_back((long)s_id);
+					blobIndex.markAlive(source_id,(long)s_id);
 				}
+				unlockBlobList();
 				
-			} else if( strcmp( cmd, "fseq" ) == 0 ) {
+			} else if (command==COMMAND_FSEQ) {
 				
 				int32 fseq;
 				args >> fseq;
@@ -546,18 +720,14 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 					lockBlobList();
 					// find the removed blobs first
 					for (std::list<TuioBlob*>::iterator tblb=blobList.begin(); tblb != blobList.end(); tblb++) {
-						if ((*tblb)->getTuioSourceID()==source_id) {
-							std::list<long>::iterator iter = find(aliveBlobList.begin(), aliveBlobList.end(), (*tblb)->getSessionID());
-							
-							if (iter == aliveBlobList.end()) {
-								(*tblb)->remove(currentTime);
-								frameBlobs.push_back(*tblb);
-							}
+						if (((*tblb)->getTuioSourceID()==source_id) && !blobIndex.isAlive(*tblb)) {
+							(*tblb)->remove(currentTime);
+							frameBlobs.push_back(*tblb);
 						}
 					}
 					unlockBlobList();
 					
-					for (std::list<TuioBlob*>::iterator iter=frameBlobs.begin(); iter != frameBlobs.end(); iter++) {
+					for (std::vector<TuioBlob*>::iterator iter=frameBlobs.begin(); iter != frameBlobs.end(); iter++) {
 						TuioBlob *tblb = (*iter);
 						
 						int b_id = 0;
@@ -572,16 +742,14 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 									(*listener)->removeTuioBlob(frameBlob);
 								
 								lockBlobList();
-								for (std::list<TuioBlob*>::iterator delblb=blobList.begin(); delblb!=blobList.end(); delblb++) {
-									if(((*delblb)->getTuioSourceID()==source_id) && ((*delblb)->getSessionID()==frameBlob->getSessionID())) {
-										blobList.erase(delblb);
-										break;
-									}
+								{
+									std::list<TuioBlob*>::iterator delblb;
+									if (blobIndex.remove(source_id,frameBlob->getSessionID(),delblb)) blobList.erase(delblb);
 								}
 								
 								if (frameBlob->getBlobID()==maxBlobID[source_id]) {
 									maxBlobID[source_id] = -1;
-									delete frameBlob;
+									blobPool.release(frameBlob);
 									
 									if (blobList.size()>0) {
 										std::list<TuioBlob*>::iterator clist;
@@ -596,8 +764,10 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 										for (std::list<TuioBlob*>::iterator flist=freeBlobList.begin(); flist != freeBlobList.end(); flist++) {
 											TuioBlob *freeBlob = (*flist);
 											if (freeBlob->getTuioSourceID()==source_id) {
-												if (freeBlob->getBlobID()>maxBlobID[source_id]) delete freeBlob;
-												else freeBlobBuffer.push_back(freeBlob);
+												if (freeBlob->getBlobID()>maxBlobID[source_id]) {
+													blobPool.release(freeBlob);
+													blobIndex.removeFree(source_id);
+												} else freeBlobBuffer.push_back(freeBlob);
 											} else freeBlobBuffer.push_back(freeBlob);
 										}	
 										freeBlobList = freeBlobBuffer;
@@ -606,14 +776,17 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 										freeBlobBuffer.clear();
 										for (std::list<TuioBlob*>::iterator flist=freeBlobList.begin(); flist != freeBlobList.end(); flist++) {
 											TuioBlob *freeBlob = (*flist);
-											if (freeBlob->getTuioSourceID()==source_id) delete freeBlob;
-											else freeBlobBuffer.push_back(freeBlob);
+											if (freeBlob->getTuioSourceID()==source_id) {
+												blobPool.release(freeBlob);
+												blobIndex.removeFree(source_id);
+											} else freeBlobBuffer.push_back(freeBlob);
 										}	
 										freeBlobList = freeBlobBuffer;
 										
 									}
 								} else if (frameBlob->getBlobID()<maxBlobID[source_id]) {
 									freeBlobList.push_back(frameBlob);
+									blobIndex.addFree(source_id);
 								} 
 								
 								unlockBlobList();
@@ -621,11 +794,8 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 							case TUIO_ADDED:
 								
 								lockBlobList();
-								for(std::list<TuioBlob*>::iterator iter = blobList.begin();iter!= blobList.end(); iter++)
-									if ((*iter)->getTuioSourceID()==source_id) b_id++;
-								
-								for(std::list<TuioBlob*>::iterator iter = freeBlobList.begin();iter!= freeBlobList.end(); iter++)
-									if ((*iter)->getTuioSourceID()==source_id) free_size++;
+								b_id = (int)blobIndex.liveCount(source_id);
+								free_size = (int)blobIndex.freeCount(source_id);
 								
 								if ((free_size<=maxBlobID[source_id]) && (free_size>0)) {
 									std::list<TuioBlob*>::iterator closestBlob = freeBlobList.begin();
@@ -638,15 +808,16 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 										TuioBlob *freeBlob = (*closestBlob);
 										b_id = freeBlob->getBlobID();
 										freeBlobList.erase(closestBlob);
-										delete freeBlob;
+										blobIndex.removeFree(freeBlob->getTuioSourceID());
+										blobPool.release(freeBlob);
 									}
 								} else maxBlobID[source_id] = b_id;									
 								
-								frameBlob = new TuioBlob(currentTime,tblb->getSessionID(),b_id,tblb->getX(),tblb->getY(),tblb->getAngle(),tblb->getWidth(),tblb->getHeight(),tblb->getArea());
+								frameBlob = blobPool.make(TuioBlob(currentTime,tblb->getSessionID(),b_id,tblb->getX(),tblb->getY(),tblb->getAngle(),tblb->getWidth(),tblb->getHeight(),tblb->getArea()));
 								if (source_name) frameBlob->setTuioSource(source_id,source_name,source_addr);
 								blobList.push_back(frameBlob);
+								blobIndex.add(frameBlob,--blobList.end());
 								
-								delete tblb;
 								unlockBlobList();
 								
 								for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
@@ -656,15 +827,9 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 							default:
 								
 								lockBlobList();
-								std::list<TuioBlob*>::iterator iter;
-								for (iter=blobList.begin(); iter != blobList.end(); iter++) {
-									if (((*iter)->getTuioSourceID()==source_id) && ((*iter)->getSessionID()==tblb->getSessionID())) {
-										frameBlob = (*iter);
-										break;
-									}
-								}	
+								frameBlob = blobIndex.find(source_id,tblb->getSessionID());
 								
-								if (iter==blobList.end()) {
+								if (frameBlob==NULL) {
 									unlockBlobList();
 									break;
 								}
@@ -674,7 +839,6 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 								else
 									frameBlob->update(currentTime,tblb->getX(),tblb->getY(),tblb->getAngle(),tblb->getWidth(),tblb->getHeight(),tblb->getArea(),tblb->getXSpeed(),tblb->getYSpeed(),tblb->getRotationSpeed(),tblb->getMotionAccel(),tblb->getRotationAccel());
 								
-								delete tblb;
 								unlockBlobList();
 								
 								for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
@@ -685,14 +849,10 @@ void TuioClient::processOSC( const ReceivedMessage& msg ) {
 					for (std::list<TuioListener*>::iterator listener=listenerList.begin(); listener != listenerList.end(); listener++)
 						(*listener)->refresh(currentTime);
 					
-				} else {
-					for (std::list<TuioBlob*>::iterator iter=frameBlobs.begin(); iter != frameBlobs.end(); iter++) {
-						TuioBlob *tblb = (*iter);
-						delete tblb;
-					}
 				}
 				
 				frameBlobs.clear();
+				blobPool.resetFrame();
 			}
 		}
 	} catch( Exception& e ){
@@ -704,6 +864,10 @@ bool TuioClient::isConnected() {
 	return receiver->isConnected();
 }
 
+unsigned long TuioClient::getContainerAllocations() const {
+	return objectPool.allocations()+cursorPool.allocations()+blobPool.allocations();
+}
+
 void TuioClient::connect(bool lock) {
 			
 	TuioTime::initSession();
@@ -720,66 +884,51 @@ void TuioClient::disconnect() {
 	
 	receiver->disconnect();
 	
-	aliveObjectList.clear();
-	aliveCursorList.clear();
-	aliveBlobList.clear();
+	objectIndex.clear();
+	cursorIndex.clear();
+	blobIndex.clear();
 
 	for (std::list<TuioObject*>::iterator iter=objectList.begin(); iter != objectList.end(); iter++)
-		delete (*iter);
+		objectPool.release(*iter);
 	objectList.clear();
 
 	for (std::list<TuioCursor*>::iterator iter=cursorList.begin(); iter != cursorList.end(); iter++)
-		delete (*iter);
+		cursorPool.release(*iter);
 	cursorList.clear();
 
 	for (std::list<TuioBlob*>::iterator iter=blobList.begin(); iter != blobList.end(); iter++)
-		delete (*iter);
+		blobPool.release(*iter);
 	blobList.clear();
 	
 	for (std::list<TuioCursor*>::iterator iter=freeCursorList.begin(); iter != freeCursorList.end(); iter++)
-		delete(*iter);
+		cursorPool.release(*iter);
 	freeCursorList.clear();
 
 	for (std::list<TuioBlob*>::iterator iter=freeBlobList.begin(); iter != freeBlobList.end(); iter++)
-		delete(*iter);
+		blobPool.release(*iter);
 	freeBlobList.clear();
 }
 
 
 TuioObject* TuioClient::getTuioObject(int src_id, long s_id) {
 	lockObjectList();
-	for (std::list<TuioObject*>::iterator iter=objectList.begin(); iter != objectList.end(); iter++) {
-		if (((*iter)->getTuioSourceID()==src_id) && ((*iter)->getSessionID()==s_id)) {
-			unlockObjectList();
-			return (*iter);
-		}
-	}	
+	TuioObject *found = objectIndex.find(src_id,s_id);
 	unlockObjectList();
-	return NULL;
+	return found;
 }
 
 TuioCursor* TuioClient::getTuioCursor(int src_id, long s_id) {
 	lockCursorList();
-	for (std::list<TuioCursor*>::iterator iter=cursorList.begin(); iter != cursorList.end(); iter++) {
-		if (((*iter)->getTuioSourceID()==src_id) && ((*iter)->getSessionID()==s_id)) {
-			unlockCursorList();
-			return (*iter);
-		}
-	}	
+	TuioCursor *found = cursorIndex.find(src_id,s_id);
 	unlockCursorList();
-	return NULL;
+	return found;
 }
 
 TuioBlob* TuioClient::getTuioBlob(int src_id, long s_id) {
 	lockBlobList();
-	for (std::list<TuioBlob*>::iterator iter=blobList.begin(); iter != blobList.end(); iter++) {
-		if (((*iter)->getTuioSourceID()==src_id) && ((*iter)->getSessionID()==s_id)) {
-			unlockBlobList();
-			return (*iter);
-		}
-	}	
+	TuioBlob *found = blobIndex.find(src_id,s_id);
 	unlockBlobList();
-	return NULL;
+	return found;
 }
 
 
@@ -24,6 +24,8 @@
 
 #include "TuioDispatcher.h"
 #include "OscReceiver.h"
+#include "TuioSessionIndex.h"
+#include "TuioContainerPool.h"
 #include "osc/OscReceivedElements.h"
 
 #include <iostream>
@@ -32,6 +34,7 @@
 #include <algorithm>
 #include <string>
 #include <cstring>
+#include <vector>
 
 namespace TUIO {
 	
@@ -95,6 +98,14 @@ namespace TUIO {
 		 * @return	true if this TuioClient is currently connected
 		 */
 		bool isConnected();
+		
+		/**
+		 * Returns how many TuioObjects, TuioCursors and TuioBlobs this TuioClient
+		 * has allocated. The containers are pooled, so this stops growing
+		 * once the largest frame has been received.
+		 * @return	the number of containers allocated
+		 */
+		unsigned long getContainerAllocations() const;
 
 		/**
 		 * Returns a List of all currently active TuioObjects
@@ -273,18 +284,50 @@ namespace TUIO {
 		
 		void processOSC( const osc::ReceivedMessage& message);
 		
+		/**
+		 * Decodes a /tuio/2Dobj, /tuio/2Dcur or /tuio/2Dblb set message, or a
+		 * TUIO 2.0 /tuio2/ptr message, straight from the received data,
+		 * without osc::ReceivedMessage.
+		 *
+		 * @param  message  the message data, as in a bundle element
+		 * @param  size  the size of the message data
+		 * @return  false if it is not exactly a set message of one of these profiles;
+		 *          the caller then hands it to processOSC()
+		 */
+		bool processSetMessage(const char *message, unsigned long size);
+		
 	private:
+		enum { ADDRESS_OTHER, ADDRESS_2DOBJ, ADDRESS_2DCUR, ADDRESS_2DBLB,
+		       ADDRESS_TUIO2_FRM, ADDRESS_TUIO2_PTR, ADDRESS_TUIO2_ALV };
+		enum { COMMAND_OTHER, COMMAND_SOURCE, COMMAND_SET, COMMAND_ALIVE, COMMAND_FSEQ };
+		
 		void initialize();
+		static int addressToken(const char *address);
+		static int commandToken(const char *command);
 		
-		std::list<TuioObject*> frameObjects;
-		std::list<long> aliveObjectList;
-		std::list<TuioCursor*> frameCursors;
-		std::list<long> aliveCursorList;
-		std::list<TuioBlob*> frameBlobs;
-		std::list<long> aliveBlobList;
+		void setTuioObject(osc::int32 s_id, osc::int32 c_id, float xpos, float ypos, float angle, float xspeed, float yspeed, float rspeed, float maccel, float raccel);
+		void setTuioCursor(osc::int32 s_id, float xpos, float ypos, float xspeed, float yspeed, float maccel);
+		void setTuioBlob(osc::int32 s_id, float xpos, float ypos, float angle, float width, float height, float area, float xspeed, float yspeed, float rspeed, float maccel, float raccel);
+		void commitCursorFrame(bool lateFrame);
+		TuioTime tuio2FrameTime(osc::uint64 timeTag);
+		
+		std::vector<TuioObject*> frameObjects;
+		TuioSessionIndex<TuioObject> objectIndex;
+		TuioContainerPool<TuioObject> objectPool;
+		std::vector<TuioCursor*> frameCursors;
+		TuioSessionIndex<TuioCursor> cursorIndex;
+		TuioContainerPool<TuioCursor> cursorPool;
+		std::vector<TuioBlob*> frameBlobs;
+		TuioSessionIndex<TuioBlob> blobIndex;
+		TuioContainerPool<TuioBlob> blobPool;
 		
 		osc::int32 currentFrame;
 		TuioTime currentTime;
+		
+		// from the last /tuio2/frm message, for the /tuio2/alv that ends the frame
+		osc::int32 tuio2Frame;
+		TuioTime tuio2Time;
+		std::map<int,int64_t> tuio2TimeOffset;	// microseconds from each source's time to the session time
 			
 		std::list<TuioCursor*> freeCursorList, freeCursorBuffer;
 		std::map<int,int> maxCursorID;
@@ -23,6 +23,7 @@
 using namespace TUIO;
 
 TuioContainer::TuioContainer (TuioTime ttime, long si, float xp, float yp):TuioPoint(ttime, xp,yp)
+,path(TuioPoint(currentTime,xpos,ypos))
 ,state(TUIO_ADDED)
 ,source_id(0)
 ,source_name("undefined")
@@ -33,12 +34,10 @@ TuioContainer::TuioContainer (TuioTime ttime, long si, float xp, float yp):TuioP
 	y_speed = 0.0f;
 	motion_speed = 0.0f;
 	motion_accel = 0.0f;			
-	TuioPoint p(currentTime,xpos,ypos);
-	path.push_back(p);
-	
 }
 
 TuioContainer::TuioContainer (long si, float xp, float yp):TuioPoint(xp,yp)
+,path(TuioPoint(currentTime,xpos,ypos))
 ,state(TUIO_ADDED)
 ,source_id(0)
 ,source_name("undefined")
@@ -49,11 +48,10 @@ TuioContainer::TuioContainer (long si, float xp, float yp):TuioPoint(xp,yp)
 	y_speed = 0.0f;
 	motion_speed = 0.0f;
 	motion_accel = 0.0f;			
-	TuioPoint p(currentTime,xpos,ypos);
-	path.push_back(p);
 }
 
 TuioContainer::TuioContainer (TuioContainer *tcon):TuioPoint(tcon)
+,path(TuioPoint(currentTime,xpos,ypos))
 ,state(TUIO_ADDED)
 ,source_id(0)
 ,source_name("undefined")
@@ -64,8 +62,6 @@ TuioContainer::TuioContainer (TuioContainer *tcon):TuioPoint(tcon)
 	y_speed = 0.0f;
 	motion_speed = 0.0f;
 	motion_accel = 0.0f;
-	TuioPoint p(currentTime,xpos,ypos);
-	path.push_back(p);
 }
 
 void TuioContainer::setTuioSource(int src_id, const char *src_name, const char *src_addr) {
@@ -91,19 +87,23 @@ void TuioContainer::update (TuioTime ttime, float xp, float yp) {
 	TuioPoint::update(ttime,xp, yp);
 	
 	TuioTime diffTime = currentTime - lastPoint.getTuioTime();
-	float dt = diffTime.getTotalMilliseconds()/1000.0f;
-	float dx = xpos - lastPoint.getX();
-	float dy = ypos - lastPoint.getY();
-	float dist = sqrt(dx*dx+dy*dy);
-	float last_motion_speed = motion_speed;
+	float dt = diffTime.getTotalMicroseconds()/(float)USEC_SECOND;
 	
-	x_speed = dx/dt;
-	y_speed = dy/dt;
-	motion_speed = dist/dt;
-	motion_accel = (motion_speed - last_motion_speed)/dt;
+	// an update at the same time as the last one has no speed of its own, so the last one is kept
+	if (dt>0) {
+		float dx = xpos - lastPoint.getX();
+		float dy = ypos - lastPoint.getY();
+		float dist = sqrt(dx*dx+dy*dy);
+		float last_motion_speed = motion_speed;
+		
+		x_speed = dx/dt;
+		y_speed = dy/dt;
+		motion_speed = dist/dt;
+		motion_accel = (motion_speed - last_motion_speed)/dt;
+	}
 	
 	TuioPoint p(currentTime,xpos,ypos);
-	path.push_back(p);
+	path.push(p);
 	
 	if (motion_accel>0) state = TUIO_ACCELERATING;
 	else if (motion_accel<0) state = TUIO_DECELERATING;
@@ -122,7 +122,7 @@ void TuioContainer::update (TuioTime ttime, float xp, float yp, float xs, float
 	motion_accel = ma;
 	
 	TuioPoint p(currentTime,xpos,ypos);
-	path.push_back(p);
+	path.push(p);
 	
 	if (motion_accel>0) state = TUIO_ACCELERATING;
 	else if (motion_accel<0) state = TUIO_DECELERATING;
@@ -136,9 +136,8 @@ void TuioContainer::update (float xp, float yp, float xs, float ys, float ma) {
 	motion_speed = (float)sqrt(x_speed*x_speed+y_speed*y_speed);
 	motion_accel = ma;
 	
-	path.pop_back();
 	TuioPoint p(currentTime,xpos,ypos);
-	path.push_back(p);
+	path.replaceLast(p);
 	
 	if (motion_accel>0) state = TUIO_ACCELERATING;
 	else if (motion_accel<0) state = TUIO_DECELERATING;
@@ -153,7 +152,7 @@ void TuioContainer::update (TuioContainer *tcon) {
 	motion_accel = tcon->getMotionAccel();
 	
 	TuioPoint p(tcon->getTuioTime(),xpos,ypos);
-	path.push_back(p);
+	path.push(p);
 	
 	if (motion_accel>0) state = TUIO_ACCELERATING;
 	else if (motion_accel<0) state = TUIO_DECELERATING;
@@ -187,9 +186,21 @@ TuioPoint TuioContainer::getPosition() const{
 }
 
 std::list<TuioPoint> TuioContainer::getPath() const{
+	return path.toList();
+}
+
+const TuioPath& TuioContainer::getTuioPath() const{
 	return path;
 }
 
+void TuioContainer::setPathDepth(unsigned int depth) {
+	path.setDepth(depth);
+}
+
+unsigned int TuioContainer::getPathDepth() const{
+	return path.getDepth();
+}
+
 float TuioContainer::getMotionSpeed() const{
 	return motion_speed;
 }
@@ -23,6 +23,7 @@
 #define INCLUDED_TUIOCONTAINER_H
 
 #include "TuioPoint.h"
+#include "TuioPath.h"
 #include <list>
 #include <string>
 
@@ -66,9 +67,9 @@ namespace TUIO {
 		 */ 
 		float motion_accel;
 		/**
-		 * A List of TuioPoints containing all the previous positions of the TUIO component.
+		 * The most recent positions of the TUIO component, see TuioPath.
 		 */ 
-		std::list<TuioPoint> path;
+		TuioPath path;
 		/**
 		 * Reflects the current state of the TuioComponent
 		 */ 
@@ -238,11 +239,29 @@ namespace TUIO {
 		virtual TuioPoint getPosition() const;
 		
 		/**
-		 * Returns the path of this TuioContainer.
+		 * Returns a copy of the path of this TuioContainer.
 		 * @return	the path of this TuioContainer
 		 */
 		virtual std::list<TuioPoint> getPath() const;
 		
+		/**
+		 * Returns the path of this TuioContainer without copying it.
+		 * @return	the path of this TuioContainer
+		 */
+		const TuioPath& getTuioPath() const;
+		
+		/**
+		 * Sets how many of the most recent positions the path keeps; 0 keeps none.
+		 * @param	depth	the number of positions to keep
+		 */
+		void setPathDepth(unsigned int depth);
+		
+		/**
+		 * Returns how many of the most recent positions the path keeps.
+		 * @return	the number of positions the path keeps
+		 */
+		unsigned int getPathDepth() const;
+		
 		/**
 		 * Returns the motion speed of this TuioContainer.
 		 * @return	the motion speed of this TuioContainer
@@ -0,0 +1,115 @@
+/*******************************************************************************
+TuioContainerPool
+
+PURPOSE: Keeps the TuioObjects, TuioCursors or TuioBlobs a TuioClient makes
+         and throws away, so that receiving frames does not allocate once the
+         pool has grown to the largest frame.
+
+NOTES:
+There are two kinds of container.  Frame containers hold the values of a
+set message until the fseq of its frame, and all of them are given back at
+once with resetFrame().  Live containers are the ones in the client's lists;
+they are given back one by one with release() when their session ends, and
+handed out again for the next new session.
+
+A container is reused by assigning the new value to it.  That keeps the
+memory of its path, so a reused live container does not allocate its path
+again either.  Containers are only deleted with the pool.
+
+allocations() counts every container the pool had to allocate; it stops
+going up once the pool is big enough.
+
+Not locked: TuioClient only uses it from the thread that receives.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_TUIOCONTAINERPOOL_H
+#define INCLUDED_TUIOCONTAINERPOOL_H
+
+#include <atomic>
+#include <vector>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * TuioContainerPool<TuioCursor> pool;<br/>
+     * TuioCursor * scratch = pool.frameCopy( TuioCursor( s_id, -1, x, y ) );<br/>
+     * ...<br/>
+     * TuioCursor * tcur = pool.make( TuioCursor( time, s_id, c_id, x, y ) );<br/>
+     * ...<br/>
+     * pool.resetFrame(); // at fseq<br/>
+     * pool.release( tcur ); // when the session ends<br/>
+     * </code></p>
+     */
+    template <class T>
+    class TuioContainerPool
+    {
+    public:
+        TuioContainerPool() : frameUsed_( 0 ), allocations_( 0 ) {}
+
+        ~TuioContainerPool()
+        {
+            for( size_t i = 0; i < frame_.size(); ++i ) {
+                delete frame_[i];
+            }
+            for( size_t i = 0; i < spare_.size(); ++i ) {
+                delete spare_[i];
+            }
+        }
+
+        /**
+         * @return a frame container holding a copy of value, good until
+         *         resetFrame().
+         */
+        T * frameCopy( const T & value )
+        {
+            if( frameUsed_ == frame_.size() ) {
+                frame_.push_back( new T( value ) );
+                allocations_.fetch_add( 1, std::memory_order_relaxed );
+            }
+            else {
+                *frame_[frameUsed_] = value;
+            }
+            return frame_[frameUsed_++];
+        }
+
+        /**
+         * Takes back every frame container.
+         */
+        void resetFrame() { frameUsed_ = 0; }
+
+        /**
+         * @return a live container holding a copy of value.
+         */
+        T * make( const T & value )
+        {
+            if( spare_.empty() ) {
+                allocations_.fetch_add( 1, std::memory_order_relaxed );
+                return new T( value );
+            }
+            T * container = spare_.back();
+            spare_.pop_back();
+            *container = value;
+            return container;
+        }
+
+        /**
+         * Takes back a live container.  The caller must not use it after.
+         */
+        void release( T * container ) { spare_.push_back( container ); }
+
+        unsigned long allocations() const { return allocations_.load( std::memory_order_relaxed ); }
+
+    private:
+        TuioContainerPool( const TuioContainerPool & );
+        TuioContainerPool & operator=( const TuioContainerPool & );
+
+        std::vector<T *> frame_,
+                         spare_;
+        size_t frameUsed_;
+        std::atomic<unsigned long> allocations_;
+    };
+}
+
+#endif /* INCLUDED_TUIOCONTAINERPOOL_H */
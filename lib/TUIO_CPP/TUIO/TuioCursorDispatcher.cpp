@@ -116,10 +116,10 @@ TuioCursor * TuioCursorDispatcher::getTuioCursor( long s_id )
     return NULL;
 }
 
-TuioCursor * TuioCursorDispatcher::getTuioCursorFromMap( long s_id )
+TuioCursor * TuioCursorDispatcher::getTuioCursorFromMap( long uniqueId )
 {
     lockCursorMap();
-    TuioCursor * tcur = cursorMap_[s_id];
+    TuioCursor * tcur = cursorTable_.find( (unsigned int)uniqueId );
     unlockCursorMap();
     return tcur;
 }
@@ -135,7 +135,12 @@ std::list<TuioCursor *> TuioCursorDispatcher::getTuioCursors()
 std::map<long, TuioCursor *> TuioCursorDispatcher::getTuioCursorsFromMap()
 {
     lockCursorMap();
-    std::map<long, TuioCursor *> mapBuffer = cursorMap_;
+    std::map<long, TuioCursor *> mapBuffer;
+
+    for( unsigned int i = 0; i < cursorTable_.size(); ++i ) {
+        TuioCursor * tcur = cursorTable_.at( i );
+        mapBuffer[cursorTable_.uniqueIdOf( tcur )] = tcur;
+    }
     unlockCursorMap();
     return mapBuffer;
 }
@@ -23,6 +23,7 @@
 #define INCLUDED_TUIOCURSORDISPATCHER_H
 
 #include "TuioListener.h"
+#include "TuioCursorTable.h"
 #include <map>
 
 #ifndef WIN32
@@ -79,6 +80,13 @@ namespace TUIO
          * @return  a List of all currently active TuioCursors
          */
         std::list<TuioCursor *> getTuioCursors();
+
+        /**
+         * Returns the currently active TuioCursors that were added by uniqueId,
+         * keyed by that id
+         *
+         * @return  a map of the TuioCursors in the cursor table
+         */
         std::map<long, TuioCursor *> getTuioCursorsFromMap();
 
         /**
@@ -95,7 +103,14 @@ namespace TUIO
          * @return  an active TuioCursor corresponding to the provided Session ID or NULL
          */
         TuioCursor * getTuioCursor( long s_id );
-        TuioCursor * getTuioCursorFromMap( long s_id );
+
+        /**
+         * Returns the TuioCursor that was added with the provided uniqueId
+         * or NULL if there is none
+         *
+         * @return  an active TuioCursor from the cursor table or NULL
+         */
+        TuioCursor * getTuioCursorFromMap( long uniqueId );
 
         /**
          * Locks the TuioCursor list in order to avoid updates during access
@@ -112,7 +127,7 @@ namespace TUIO
     protected:
         std::list<TuioListener *> listenerList_;
         std::list<TuioCursor *> cursorList_;
-        std::map<long, TuioCursor *> cursorMap_;
+        TuioCursorTable cursorTable_;
         
 #ifndef WIN32
         pthread_mutex_t cursorMutex_;
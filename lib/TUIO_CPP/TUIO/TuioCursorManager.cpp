@@ -27,7 +27,9 @@ TuioCursorManager::TuioCursorManager() :
   maxCursorID_( -1 ), 
   sessionID_( -1 ), 
   updateCursor_( false ), 
+  aliveChanged_( false ), 
   verbose_( false ), 
+  pathDepth_( TuioPath::getDefaultDepth() ), 
   invert_x_( false ), 
   invert_y_( false ), 
   invert_a_( false )
@@ -60,8 +62,10 @@ TuioCursor * TuioCursorManager::addTuioCursor( float x, float y )
     else maxCursorID_ = cursorID;
 
     TuioCursor *tcur = new TuioCursor( currentFrameTime_, sessionID_, cursorID, x, y );
+    tcur->setPathDepth( pathDepth_ );
     cursorList_.push_back( tcur );
     updateCursor_ = true;
+    aliveChanged_ = true;
 
     for( std::list<TuioListener*>::iterator listener = listenerList_.begin(); listener != listenerList_.end(); listener++ )
         (*listener)->addTuioCursor( tcur );
@@ -93,9 +97,11 @@ void TuioCursorManager::removeTuioCursor( TuioCursor *tcur )
 {
     if( tcur == NULL ) return;
 
+    removingTuioCursor( tcur, 0 );
     cursorList_.remove( tcur );
     tcur->remove( currentFrameTime_ );
     updateCursor_ = true;
+    aliveChanged_ = true;
 
     for( std::list<TuioListener*>::iterator listener = listenerList_.begin(); listener != listenerList_.end(); listener++ )
         (*listener)->removeTuioCursor( tcur );
@@ -177,6 +183,13 @@ TuioCursor* TuioCursorManager::getClosestTuioCursor( float xp, float yp )
             closestDistance = distance;
         }
     }
+    for( unsigned int i = 0; i < cursorTable_.size(); i++ ) {
+        float distance = cursorTable_.at( i )->getDistance( xp, yp );
+        if( distance < closestDistance ) {
+            closestCursor = cursorTable_.at( i );
+            closestDistance = distance;
+        }
+    }
 
     return closestCursor;
 }
@@ -188,13 +201,17 @@ std::list<TuioCursor*> TuioCursorManager::getUntouchedCursors()
         TuioCursor *tcur = (*tuioCursor);
         if( tcur->getTuioTime() != currentFrameTime_ ) untouched.push_back( tcur );
     }
+    for( unsigned int i = 0; i < cursorTable_.size(); i++ ) {
+        TuioCursor *tcur = cursorTable_.at( i );
+        if( tcur->getTuioTime() != currentFrameTime_ ) untouched.push_back( tcur );
+    }
     return untouched;
 }
 
 void TuioCursorManager::stopUntouchedMovingCursors()
 {
-    std::list<TuioCursor*> untouched;
-    for( std::list<TuioCursor*>::iterator tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); tuioCursor++ ) {
+    std::list<TuioCursor*> untouched = getUntouchedCursors();
+    for( std::list<TuioCursor*>::iterator tuioCursor = untouched.begin(); tuioCursor != untouched.end(); tuioCursor++ ) {
         TuioCursor *tcur = (*tuioCursor);
         if( (tcur->getTuioTime() != currentFrameTime_) && (tcur->isMoving()) ) {
             tcur->stop( currentFrameTime_ );
@@ -218,6 +235,13 @@ void TuioCursorManager::removeUntouchedStoppedCursors()
         }
         else tuioCursor++;
     }
+    unsigned int i = cursorTable_.size();
+    while( i > 0 ) {
+        TuioCursor *tcur = cursorTable_.at( --i );
+        if( (tcur->getTuioTime() != currentFrameTime_) && (!tcur->isMoving()) ) {
+            removeTuioCursor( (int)cursorTable_.uniqueIdOf( tcur ) ); // moves an already checked cursor to i
+        }
+    }
 }
 
 void TuioCursorManager::resetTuioCursors() 
@@ -227,50 +251,57 @@ void TuioCursorManager::resetTuioCursors()
         removeTuioCursor( (*tuioCursor) );
         tuioCursor = cursorList_.begin();
     }
+    while( cursorTable_.size() > 0 ) {
+        removeTuioCursor( (int)cursorTable_.uniqueIdOf( cursorTable_.at( 0 ) ) );
+    }
 }
 
-/*******************************************************************************
-The hash map-based functions below are a work in-progress and are not ready for
-use: the updateTuioCursor( uniqueId, xp, yp ) function will crash the program
-receiving the /tuio/2Dcur message.
-*******************************************************************************/
-TuioCursor * TuioCursorManager::addTuioCursor( int uniqueId, float xp, float yp )
+TuioCursor * TuioCursorManager::addTuioCursor( int uniqueId, float xp, float yp, int typeId )
 {
-    TuioCursor * tcur = new TuioCursor( currentFrameTime_, uniqueId, uniqueId, xp, yp );
-    cursorMap_[uniqueId] = tcur;
+    if( cursorTable_.find( uniqueId ) != NULL ) removeTuioCursor( uniqueId );
+    if( cursorTable_.full() ) return NULL;
+
+    sessionID_++;
+    TuioCursor * tcur = cursorTable_.add( uniqueId, currentFrameTime_, sessionID_, xp, yp, typeId );
+    tcur->setPathDepth( pathDepth_ );
     updateCursor_ = true;
+    aliveChanged_ = true;
+
+    for( std::list<TuioListener*>::iterator listener = listenerList_.begin(); listener != listenerList_.end(); listener++ )
+        (*listener)->addTuioCursor( tcur );
+
+    if( verbose_ )
+        std::cout << "add cur " << tcur->getCursorID() << " (" << tcur->getSessionID() << ") " << tcur->getX() << " " << tcur->getY() << std::endl;
+
     return tcur;
 }
 
 TuioCursor * TuioCursorManager::updateTuioCursor( int uniqueId, float xp, float yp )
 {
-    TuioCursor * tcur = cursorMap_[uniqueId];
-
-    if( tcur != NULL && tcur->getTuioTime() != currentFrameTime_ ) {
-        tcur->update( currentFrameTime_, xp, yp );
-        updateCursor_ = true;
+    TuioCursor * tcur = cursorTable_.find( uniqueId );
 
-        if( tcur->isMoving() ) {
-            for( auto listener = listenerList_.begin(); listener != listenerList_.end(); ++listener ) {
-                (*listener)->updateTuioCursor( tcur );
-            }
-        }
+    if( tcur != NULL ) {
+        updateTuioCursor( tcur, xp, yp );
     }
     return tcur;
 }
 
 void TuioCursorManager::removeTuioCursor( int uniqueId )
 {
-    TuioCursor * tcur = cursorMap_[uniqueId];
+    TuioCursor * tcur = cursorTable_.find( uniqueId );
 
-    if( tcur != NULL ) {
-        cursorMap_.erase( uniqueId );
-        tcur->remove( currentFrameTime_ );
-        updateCursor_ = true;
+    if( tcur == NULL ) return;
 
-        for( auto listener = listenerList_.begin(); listener != listenerList_.end(); ++listener ) {
-            (*listener)->removeTuioCursor( tcur );
-        }
-        delete tcur;
-    }
+    removingTuioCursor( tcur, cursorTable_.typeIdOf( tcur ) );
+    tcur->remove( currentFrameTime_ );
+    updateCursor_ = true;
+    aliveChanged_ = true;
+
+    for( std::list<TuioListener*>::iterator listener = listenerList_.begin(); listener != listenerList_.end(); listener++ )
+        (*listener)->removeTuioCursor( tcur );
+
+    if( verbose_ )
+        std::cout << "del cur " << tcur->getCursorID() << " (" << tcur->getSessionID() << ")" << std::endl;
+
+    cursorTable_.remove( uniqueId );
 }
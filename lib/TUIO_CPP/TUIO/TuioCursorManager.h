@@ -46,6 +46,11 @@ namespace TUIO {
      * server->removeTuioCursor(tcur);<br/>
      * server->commitFrame();<br/>
      * </code></p>
+     * <p>Cursors can also be named by a caller's own uniqueId (such as a Windows
+     * pointer id) instead of by TuioCursor pointer.  Those cursors are kept in a
+     * preallocated TuioCursorTable rather than in the cursor list, so the caller
+     * needs no id-to-cursor map of its own.  Use one style or the other with a
+     * given manager, since each hands out its own cursor IDs.</p>
      *
      * @author Martin Kaltenbrunner
      * @version 1.5
@@ -74,7 +79,18 @@ namespace TUIO {
          * @return	reference to the created TuioCursor
          */
         TuioCursor * addTuioCursor(float xp, float yp);
-        TuioCursor * addTuioCursor( int uniqueId, float xp, float yp );
+
+        /**
+         * Creates a new TuioCursor for the given uniqueId in the cursor table.
+         * A cursor already using that uniqueId is removed first.
+         *
+         * @param	uniqueId	the caller's id for this contact
+         * @param	xp	the X coordinate to assign
+         * @param	yp	the Y coordinate to assign
+         * @param	typeId	the TUIO 2.0 type id of the contact (0: unknown or finger)
+         * @return	the created TuioCursor, or NULL if the table is full
+         */
+        TuioCursor * addTuioCursor( int uniqueId, float xp, float yp, int typeId = 0 );
 
         /**
          * Updates the referenced TuioCursor based on the given arguments.
@@ -84,6 +100,12 @@ namespace TUIO {
          * @param	yp	the Y coordinate to assign
          */
         void updateTuioCursor(TuioCursor *tcur, float xp, float yp);
+
+        /**
+         * Updates the TuioCursor with the given uniqueId.
+         *
+         * @return	the TuioCursor, or NULL if there is none for that uniqueId
+         */
         TuioCursor * updateTuioCursor( int uniqueId, float xp, float yp );
 
         /**
@@ -93,6 +115,11 @@ namespace TUIO {
          * @param	tcur	the TuioCursor to remove
          */
         void removeTuioCursor(TuioCursor *tcur);
+
+        /**
+         * Removes the TuioCursor with the given uniqueId and returns it to the
+         * cursor table's pool.  Unknown ids are ignored.
+         */
         void removeTuioCursor( int uniqueId );
         
         /**
@@ -157,6 +184,14 @@ namespace TUIO {
          */
         void setVerbose(bool verbose) { verbose_ = verbose; }
 
+        /**
+         * Sets how many recent positions each new TuioCursor keeps in its path.
+         * A server that never looks at the paths can set 0.
+         * @param	depth	the path depth for new TuioCursors
+         */
+        void setPathDepth(unsigned int depth) { pathDepth_ = depth; }
+        unsigned int getPathDepth() { return pathDepth_; }
+
         void setInversion(bool ix, bool iy, bool ia) { 
             invert_x_ = ix; 
             invert_y_ = iy; 
@@ -172,6 +207,13 @@ namespace TUIO {
         void resetTuioCursors();	
         
     protected:
+        /**
+         * Called by both removeTuioCursor() overloads just before the
+         * cursor is removed, while it still has its last position and time.
+         * typeId is the one the cursor was added with, 0 for cursorList_.
+         */
+        virtual void removingTuioCursor( TuioCursor * tcur, int typeId ) {}
+
         std::list<TuioCursor*> freeCursorList_;
         std::list<TuioCursor*> freeCursorBuffer_;
 
@@ -181,7 +223,9 @@ namespace TUIO {
         long sessionID_;
 
         bool updateCursor_;
+        bool aliveChanged_;     // a cursor was added or removed in this frame
         bool verbose_;
+        unsigned int pathDepth_;
 
         bool invert_x_;
         bool invert_y_;
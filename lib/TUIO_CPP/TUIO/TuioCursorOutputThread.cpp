@@ -0,0 +1,474 @@
+/*******************************************************************************
+TuioCursorOutputThread
+
+PURPOSE: Runs a TuioCursorServer on its own thread.  See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "TuioCursorOutputThread.h"
+#include "TuioCursorServer.h"
+#include <chrono>
+#include <system_error>
+#ifndef WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace TUIO;
+
+TuioCursorOutputThread::TuioCursorOutputThread( TuioCursorServer * tuioCursorServer ) :
+  tuioCursorServer_( tuioCursorServer ),
+  queue_(),
+  backlog_(),
+  backlogCursors_(),
+  backlogPositions_(),
+  dropped_( 0 ),
+  collapses_( 0 ),
+  maxQueueDepth_( 0 ),
+  framesSent_( 0 ),
+  thread_(),
+  wakeupMutex_(),
+  wakeup_(),
+  sleeping_( false ),
+  running_( false ),
+  cpuAffinitySet_( false ),
+  prioritySet_( false ),
+  cpu_( ANY_CPU ),
+  priority_( 0 )
+{
+}
+
+TuioCursorOutputThread::~TuioCursorOutputThread()
+{
+    stop();
+}
+
+bool TuioCursorOutputThread::start( int cpu /*= ANY_CPU*/, int priority /*= 0*/ )
+{
+    if( running_ ) {
+        return true;
+    }
+    cpu_ = cpu;
+    priority_ = priority;
+
+    try {
+        thread_ = std::thread( &TuioCursorOutputThread::run, this );
+    }
+    catch( const std::system_error & ) {
+        return false;
+    }
+    running_ = true;
+    applyThreadSettings();
+    return true;
+}
+
+void TuioCursorOutputThread::applyThreadSettings()
+{
+#ifdef WIN32
+    HANDLE handle = (HANDLE)thread_.native_handle();
+
+    if( cpu_ >= 0 && cpu_ < (int)(8 * sizeof( DWORD_PTR )) ) {
+        cpuAffinitySet_ = SetThreadAffinityMask( handle, (DWORD_PTR)1 << cpu_ ) != 0;
+    }
+    if( priority_ != 0 ) {
+        int priority = priority_ < -2 ? -2 : (priority_ > 2 ? 2 : priority_);
+        prioritySet_ = SetThreadPriority( handle, priority ) != 0;
+    }
+#else
+    pthread_t handle = thread_.native_handle();
+
+    if( cpu_ >= 0 && cpu_ < CPU_SETSIZE ) {
+        cpu_set_t cpus;
+        CPU_ZERO( &cpus );
+        CPU_SET( cpu_, &cpus );
+        cpuAffinitySet_ = pthread_setaffinity_np( handle, sizeof( cpus ), &cpus ) == 0;
+    }
+    if( priority_ > 0 ) {
+        struct sched_param param;
+        param.sched_priority = sched_get_priority_min( SCHED_FIFO ) + priority_;
+        prioritySet_ = pthread_setschedparam( handle, SCHED_FIFO, &param ) == 0;
+    }
+#endif
+}
+
+void TuioCursorOutputThread::stop()
+{
+    if( !running_ ) {
+        return;
+    }
+    TuioCursorEvent event = TuioCursorEvent();
+    event.type = TuioCursorEvent::STOP;
+
+    while( !backlog_.empty() || !queue_.tryPush( event ) ) {
+        flushBacklog();
+        wakeOutputThread();
+        std::this_thread::yield();
+    }
+    wakeOutputThread();
+    thread_.join();
+    running_ = false;
+}
+
+void TuioCursorOutputThread::initFrame( TuioTime ttime )
+{
+    TuioCursorEvent event = TuioCursorEvent();
+    event.type = TuioCursorEvent::INIT_FRAME;
+    event.seconds = ttime.getSeconds();
+    event.microSeconds = ttime.getMicroseconds();
+    push( event );
+}
+
+void TuioCursorOutputThread::addTuioCursor( unsigned int id, float x, float y, int typeId )
+{
+    TuioCursorEvent event = TuioCursorEvent();
+    event.type = TuioCursorEvent::ADD_CURSOR;
+    event.id = id;
+    event.x = x;
+    event.y = y;
+    event.typeId = typeId;
+    push( event );
+}
+
+void TuioCursorOutputThread::updateTuioCursor( unsigned int id, float x, float y )
+{
+    TuioCursorEvent event = TuioCursorEvent();
+    event.type = TuioCursorEvent::UPDATE_CURSOR;
+    event.id = id;
+    event.x = x;
+    event.y = y;
+    push( event );
+}
+
+void TuioCursorOutputThread::removeTuioCursor( unsigned int id )
+{
+    TuioCursorEvent event = TuioCursorEvent();
+    event.type = TuioCursorEvent::REMOVE_CURSOR;
+    event.id = id;
+    push( event );
+}
+
+void TuioCursorOutputThread::commitFrame()
+{
+    TuioCursorEvent event = TuioCursorEvent();
+    event.type = TuioCursorEvent::COMMIT_FRAME;
+    push( event );
+}
+
+void TuioCursorOutputThread::useSenders( bool firstUdpSender, bool secondUdpSender, bool flashXmlTcpSender )
+{
+    TuioCursorEvent event = TuioCursorEvent();
+    event.type = TuioCursorEvent::USE_SENDERS;
+    event.id = (firstUdpSender ? 1 : 0) | (secondUdpSender ? 2 : 0) | (flashXmlTcpSender ? 4 : 0);
+    push( event );
+}
+
+void TuioCursorOutputThread::push( const TuioCursorEvent & event )
+{
+    if( !running_ ) {
+        process( event );
+        return;
+    }
+    flushBacklog();
+
+    if( !backlog_.empty() || !queue_.tryPush( event ) ) {
+        pushBacklog( event );
+    }
+    unsigned int depth = queueDepth();
+
+    if( depth > maxQueueDepth_ ) {
+        maxQueueDepth_ = depth;
+    }
+    if( event.type != TuioCursorEvent::INIT_FRAME
+     && event.type != TuioCursorEvent::ADD_CURSOR
+     && event.type != TuioCursorEvent::UPDATE_CURSOR
+     && event.type != TuioCursorEvent::REMOVE_CURSOR ) {
+        wakeOutputThread();
+    }
+}
+
+void TuioCursorOutputThread::flushBacklog()
+{
+    bool moved = false;
+
+    while( !backlog_.empty() && queue_.tryPush( backlog_.front() ) ) {
+        forgetPosition( &backlog_.front() );
+        backlog_.pop_front();
+        moved = true;
+    }
+    if( moved && running_ ) {
+        wakeOutputThread();
+    }
+}
+
+/**
+ * An update only overwrites the position of the cursor's add or update
+ * still waiting in the backlog.  After an add or a remove, later updates go
+ * in after it again, so they cannot be moved in front of it.  Records in
+ * a std::deque stay where they are when others are pushed or popped at
+ * the ends, so the pointers in backlogPositions_ remain valid until their
+ * record leaves the backlog.
+ */
+void TuioCursorOutputThread::pushBacklog( const TuioCursorEvent & event )
+{
+    if( event.type == TuioCursorEvent::ADD_CURSOR
+     || event.type == TuioCursorEvent::UPDATE_CURSOR
+     || event.type == TuioCursorEvent::REMOVE_CURSOR ) {
+        size_t i = 0;
+
+        while( i < backlogPositions_.size() && backlogPositions_[i].id != event.id ) {
+            ++i;
+        }
+        if( i < backlogPositions_.size() ) {
+            if( event.type == TuioCursorEvent::UPDATE_CURSOR ) {
+                backlogPositions_[i].record->x = event.x;
+                backlogPositions_[i].record->y = event.y;
+                ++dropped_;
+                return;
+            }
+            backlogPositions_.erase( backlogPositions_.begin() + i );
+        }
+        backlog_.push_back( event );
+
+        if( event.type != TuioCursorEvent::REMOVE_CURSOR ) {
+            BacklogPosition position = { event.id, &backlog_.back() };
+            backlogPositions_.push_back( position );
+        }
+    }
+    else {
+        backlog_.push_back( event );
+    }
+    if( backlog_.size() >= MAX_BACKLOG_SIZE ) {
+        collapseBacklog();
+    }
+}
+
+void TuioCursorOutputThread::forgetPosition( const TuioCursorEvent * record )
+{
+    if( record->type != TuioCursorEvent::ADD_CURSOR && record->type != TuioCursorEvent::UPDATE_CURSOR ) {
+        return;
+    }
+    for( size_t i = 0; i < backlogPositions_.size(); ++i ) {
+        if( backlogPositions_[i].record == record ) {
+            backlogPositions_.erase( backlogPositions_.begin() + i );
+            return;
+        }
+    }
+}
+
+/**
+ * Per cursor, only three things matter: whether the server has it before
+ * the backlog (the first record is a remove or an update), whether the
+ * backlog removes it, and whether the last record leaves it down and where.
+ * A cursor down before and after that was never removed is updated, so it
+ * keeps its session; one removed in between is removed and added again.
+ * The backlog starts a frame only if it started with one (otherwise the
+ * records join the frame already queued), and it ends committed only if
+ * its last frame was.
+ */
+void TuioCursorOutputThread::collapseBacklog()
+{
+    bool startsFrame = backlog_.front().type == TuioCursorEvent::INIT_FRAME,
+         endsCommitted = false,
+         sendersChanged = false;
+    TuioCursorEvent lastInit = TuioCursorEvent(),
+                    lastSenders = TuioCursorEvent();
+    backlogCursors_.clear();
+
+    for( std::deque<TuioCursorEvent>::const_iterator event = backlog_.begin(); event != backlog_.end(); ++event ) {
+        switch( event->type ) {
+            case TuioCursorEvent::INIT_FRAME:
+                lastInit = *event;
+                endsCommitted = false;
+                break;
+
+            case TuioCursorEvent::COMMIT_FRAME:
+                endsCommitted = true;
+                break;
+
+            case TuioCursorEvent::USE_SENDERS:
+                lastSenders = *event;
+                sendersChanged = true;
+                break;
+
+            case TuioCursorEvent::ADD_CURSOR:
+            case TuioCursorEvent::UPDATE_CURSOR:
+            case TuioCursorEvent::REMOVE_CURSOR: {
+                size_t i = 0;
+
+                while( i < backlogCursors_.size() && backlogCursors_[i].id != event->id ) {
+                    ++i;
+                }
+                if( i == backlogCursors_.size() ) {
+                    BacklogCursor cursor = BacklogCursor();
+                    cursor.id = event->id;
+                    cursor.downBefore = event->type != TuioCursorEvent::ADD_CURSOR;
+                    backlogCursors_.push_back( cursor );
+                }
+                BacklogCursor & cursor = backlogCursors_[i];
+
+                if( event->type == TuioCursorEvent::REMOVE_CURSOR ) {
+                    cursor.removed = true;
+                    cursor.downAfter = false;
+                }
+                else {
+                    cursor.downAfter = true;
+                    cursor.x = event->x;
+                    cursor.y = event->y;
+
+                    if( event->type == TuioCursorEvent::ADD_CURSOR ) {
+                        cursor.typeId = event->typeId;
+                    }
+                }
+                break;
+            }
+        }
+    }
+    backlog_.clear();
+    backlogPositions_.clear();
+
+    if( sendersChanged ) {
+        backlog_.push_back( lastSenders );
+    }
+    if( startsFrame ) {
+        backlog_.push_back( lastInit );
+    }
+    for( size_t i = 0; i < backlogCursors_.size(); ++i ) {
+        if( backlogCursors_[i].downBefore && backlogCursors_[i].removed ) {
+            TuioCursorEvent event = TuioCursorEvent();
+            event.type = TuioCursorEvent::REMOVE_CURSOR;
+            event.id = backlogCursors_[i].id;
+            backlog_.push_back( event );
+        }
+    }
+    for( size_t i = 0; i < backlogCursors_.size(); ++i ) {
+        const BacklogCursor & cursor = backlogCursors_[i];
+
+        if( cursor.downAfter ) {
+            TuioCursorEvent event = TuioCursorEvent();
+            event.type = cursor.downBefore && !cursor.removed ? TuioCursorEvent::UPDATE_CURSOR
+                                                              : TuioCursorEvent::ADD_CURSOR;
+            event.id = cursor.id;
+            event.x = cursor.x;
+            event.y = cursor.y;
+            event.typeId = cursor.typeId;
+            backlog_.push_back( event );
+
+            BacklogPosition position = { cursor.id, &backlog_.back() };
+            backlogPositions_.push_back( position );
+        }
+    }
+    if( endsCommitted ) {
+        TuioCursorEvent event = TuioCursorEvent();
+        event.type = TuioCursorEvent::COMMIT_FRAME;
+        backlog_.push_back( event );
+    }
+    ++collapses_;
+}
+
+unsigned int TuioCursorOutputThread::queueDepth()
+{
+    return queue_.size() + (unsigned int)backlog_.size();
+}
+
+/**
+ * The fences pair up with the ones in run(): either the output thread sees
+ * the record that was just queued, or this thread sees that it is asleep.
+ */
+void TuioCursorOutputThread::wakeOutputThread()
+{
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    if( sleeping_.load( std::memory_order_relaxed ) ) {
+        std::lock_guard<std::mutex> lock( wakeupMutex_ );
+        sleeping_.store( false, std::memory_order_relaxed );
+        wakeup_.notify_one();
+    }
+}
+
+/**
+ * While a rate limited channel has cursor changes held back, the thread
+ * sleeps no longer than until that channel's next tick.
+ */
+void TuioCursorOutputThread::run()
+{
+    TuioCursorEvent event;
+
+    for( ;; ) {
+        while( queue_.tryPop( event ) ) {
+            if( event.type == TuioCursorEvent::STOP ) {
+                return;
+            }
+            process( event );
+        }
+        long heldFrameTime = tuioCursorServer_->nextHeldFrameTime(),
+             wait = 0;
+
+        if( heldFrameTime >= 0 ) {
+            TuioTime now = TuioTime::getSessionTime();
+            wait = heldFrameTime - now.getTotalMilliseconds();
+
+            if( wait <= 0 ) {
+                tuioCursorServer_->sendHeldFrames( now );
+                continue;
+            }
+        }
+        std::unique_lock<std::mutex> lock( wakeupMutex_ );
+        sleeping_.store( true, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        if( !queue_.empty() ) {
+            sleeping_.store( false, std::memory_order_relaxed );
+            continue;
+        }
+        if( heldFrameTime >= 0 ) {
+            std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() 
+                                                        + std::chrono::milliseconds( wait );
+
+            while( sleeping_.load( std::memory_order_relaxed ) 
+                && wakeup_.wait_until( lock, until ) == std::cv_status::no_timeout ) {
+            }
+            sleeping_.store( false, std::memory_order_relaxed );
+        }
+        while( sleeping_.load( std::memory_order_relaxed ) ) {
+            wakeup_.wait( lock );
+        }
+    }
+}
+
+/**
+ * Replays one record on the TuioCursorServer.  An update for an unknown id
+ * (its add was dropped) adds the cursor; a remove for an unknown id is ignored.
+ */
+void TuioCursorOutputThread::process( const TuioCursorEvent & event )
+{
+    switch( event.type ) {
+        case TuioCursorEvent::INIT_FRAME:
+            tuioCursorServer_->initFrame( TuioTime( event.seconds, event.microSeconds ) );
+            break;
+
+        case TuioCursorEvent::ADD_CURSOR:
+            tuioCursorServer_->addTuioCursor( (int)event.id, event.x, event.y, event.typeId );
+            break;
+
+        case TuioCursorEvent::UPDATE_CURSOR:
+            if( tuioCursorServer_->updateTuioCursor( (int)event.id, event.x, event.y ) == 0 ) {
+                tuioCursorServer_->addTuioCursor( (int)event.id, event.x, event.y );
+            }
+            break;
+
+        case TuioCursorEvent::REMOVE_CURSOR:
+            tuioCursorServer_->removeTuioCursor( (int)event.id );
+            break;
+
+        case TuioCursorEvent::COMMIT_FRAME:
+            tuioCursorServer_->commitFrame();
+            framesSent_.fetch_add( 1, std::memory_order_relaxed );
+            break;
+
+        case TuioCursorEvent::USE_SENDERS:
+            tuioCursorServer_->useFirstUdpSender( (event.id & 1) != 0 );
+            tuioCursorServer_->useSecondUdpSender( (event.id & 2) != 0 );
+            tuioCursorServer_->useFlashXmlTcpSender( (event.id & 4) != 0 );
+            break;
+    }
+}
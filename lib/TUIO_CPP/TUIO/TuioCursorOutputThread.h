@@ -0,0 +1,208 @@
+/*******************************************************************************
+TuioCursorOutputThread
+
+PURPOSE: Runs a TuioCursorServer on its own thread, so that encoding TUIO
+         messages and writing them to the UDP and TCP sockets never holds up
+         the thread that receives the Windows touch messages.
+
+NOTES:
+The receiving thread (the Qt GUI thread in TouchHooks2Tuio) calls the same
+initFrame, add, update, remove and commitFrame functions it would call on the
+TuioCursorServer, but here they only put a small TuioCursorEvent record into
+a bounded SpscQueue and return.  The output thread takes the records off the
+queue and replays them on the TuioCursorServer, which it then owns until
+stop() is called.  Cursors are named by the caller's own ids (the Windows
+pointer ids) and looked up in the server's cursor table, so TuioCursor
+pointers never cross threads.
+
+The output thread sleeps while the queue is empty and is woken once per
+committed frame, not once per record.  If a rate limited channel of the
+server has cursor changes held back, it also wakes up at that channel's
+next tick to send them (TuioCursorServer::sendHeldFrames()).
+
+If the queue is full, records are held in a backlog on the calling thread
+and moved into the queue as soon as there is room, so the cursor list cannot
+get out of step.  A cursor update is not added to the backlog if the cursor
+already has an add or update waiting there: it only overwrites that
+record's position, so a finger that comes to rest during a stall still ends
+up at its last position.  droppedCount() counts the updates folded away.
+Should the backlog reach MAX_BACKLOG_SIZE records (the output thread has
+been held up for seconds), it is collapsed into a single frame that takes
+the server to the same cursors: a cursor added and removed again within
+the backlog is left out, a cursor that was down before and still is gets
+one update to its last position, a cursor put down is added once at its
+last position, and the frames in between are never sent.
+backlogCollapses() counts how often that happened.
+
+If the thread is not running, every call is applied on the caller's thread,
+just as if the TuioCursorServer were used directly; held back changes then
+go out with the next frame.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_TUIOCURSOROUTPUTTHREAD_H
+#define INCLUDED_TUIOCURSOROUTPUTTHREAD_H
+
+#include "SpscQueue.h"
+#include "TuioTime.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TUIO
+{
+    class TuioCursorServer;
+
+    /**
+     * One cursor change handed from the receiving thread to the output thread.
+     */
+    struct TuioCursorEvent
+    {
+        enum Type { INIT_FRAME, ADD_CURSOR, UPDATE_CURSOR, REMOVE_CURSOR,
+                    COMMIT_FRAME, USE_SENDERS, STOP };
+
+        int type;
+        unsigned int id;
+        float x, y;
+        int typeId;             // of an added cursor, see TuioCursorServer::addTuioCursor()
+        long seconds,
+             microSeconds;
+    };
+
+    /**
+     * <p><code>
+     * TuioCursorOutputThread output( tuioCursorServer );<br/>
+     * output.start( TuioCursorOutputThread::ANY_CPU, 1 );<br/>
+     * ...<br/>
+     * output.initFrame( TuioTime::getSessionTime() );<br/>
+     * output.addTuioCursor( pointerId, xpos, ypos );<br/>
+     * output.commitFrame();<br/>
+     * </code></p>
+     */
+    class LIBDECL TuioCursorOutputThread
+    {
+    public:
+        enum { QUEUE_SIZE = 4096,
+               MAX_BACKLOG_SIZE = 4 * QUEUE_SIZE,
+               ANY_CPU = -1 };
+
+        /**
+         * @param  tuioCursorServer  the server the output thread sends with;
+         *                           it must outlive this object.
+         */
+        TuioCursorOutputThread( TuioCursorServer * tuioCursorServer );
+
+        /**
+         * Stops the output thread after it has sent everything queued.
+         */
+        ~TuioCursorOutputThread();
+
+        /**
+         * Starts the output thread.
+         *
+         * @param  cpu       the CPU the thread is pinned to, or ANY_CPU.
+         * @param  priority  -2 (lowest) to 2 (highest); 0 is normal.  On
+         *                   Windows these are the THREAD_PRIORITY_* values.
+         *                   On Linux, a positive value asks for SCHED_FIFO.
+         * @return true if the thread was started.
+         */
+        bool start( int cpu = ANY_CPU, int priority = 0 );
+
+        /**
+         * Sends whatever is still queued, then ends the output thread.
+         */
+        void stop();
+
+        bool isRunning() const { return running_; }
+        bool cpuAffinitySet() const { return cpuAffinitySet_; }
+        bool prioritySet() const { return prioritySet_; }
+        int cpu() const { return cpu_; }
+        int priority() const { return priority_; }
+
+        // Producer side.  Call these from one thread only.
+        void initFrame( TuioTime ttime );
+        void addTuioCursor( unsigned int id, float x, float y, int typeId = 0 );
+        void updateTuioCursor( unsigned int id, float x, float y );
+        void removeTuioCursor( unsigned int id );
+        void commitFrame();
+        void useSenders( bool firstUdpSender, bool secondUdpSender, bool flashXmlTcpSender );
+
+        /**
+         * Moves backlogged records into the queue if there is room now.
+         */
+        void flushBacklog();
+
+        /**
+         * Returns the number of records waiting to be sent, including the backlog.
+         */
+        unsigned int queueDepth();
+
+        /**
+         * Returns the number of records held back because the queue was
+         * full; flushBacklog() needs calling while it is above zero.
+         */
+        unsigned int backlogSize() const { return (unsigned int)backlog_.size(); }
+        unsigned int maxQueueDepth() { return maxQueueDepth_; }
+        unsigned int droppedCount() { return dropped_; }
+        unsigned int backlogCollapses() const { return collapses_; }
+        unsigned int framesSent() const { return framesSent_.load( std::memory_order_relaxed ); }
+
+    private:
+        // What the collapsed backlog does to one cursor.
+        struct BacklogCursor
+        {
+            unsigned int id;
+            bool downBefore,        // the server has it before the backlog
+                 removed,           // the backlog removes it
+                 downAfter;         // and has it afterwards
+            float x, y;
+            int typeId;
+        };
+
+        // The add or update of a cursor waiting in the backlog that later
+        // updates of that cursor overwrite.
+        struct BacklogPosition
+        {
+            unsigned int id;
+            TuioCursorEvent * record;
+        };
+
+        TuioCursorOutputThread( const TuioCursorOutputThread & );
+        TuioCursorOutputThread & operator=( const TuioCursorOutputThread & );
+
+        void push( const TuioCursorEvent & event );
+        void pushBacklog( const TuioCursorEvent & event );
+        void forgetPosition( const TuioCursorEvent * record );
+        void collapseBacklog();
+        void wakeOutputThread();
+        void run();
+        void process( const TuioCursorEvent & event );
+        void applyThreadSettings();
+
+        TuioCursorServer * tuioCursorServer_;
+
+        SpscQueue<TuioCursorEvent, QUEUE_SIZE> queue_;
+        std::deque<TuioCursorEvent> backlog_;
+        std::vector<BacklogCursor> backlogCursors_;
+        std::vector<BacklogPosition> backlogPositions_;
+        unsigned int dropped_,
+                     collapses_,
+                     maxQueueDepth_;
+        std::atomic<unsigned int> framesSent_;
+
+        std::thread thread_;
+        std::mutex wakeupMutex_;
+        std::condition_variable wakeup_;
+        std::atomic<bool> sleeping_;
+        bool running_,
+             cpuAffinitySet_,
+             prioritySet_;
+        int cpu_,
+            priority_;
+    };
+}
+
+#endif /* INCLUDED_TUIOCURSOROUTPUTTHREAD_H */
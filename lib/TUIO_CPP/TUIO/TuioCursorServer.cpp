@@ -25,35 +25,57 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 #include "TuioCursorServer.h"
-#include "UdpSender.h"
+#include "UdpFanOutSender.h"
 #include "FlashXmlTcpServer.h"
-#include <sstream>
+#include "FlashXmlEncoder.h"
+#include "CursorSnapshotWriter.h"
+#include "osc/OscFixedMessage.h"
 
 using namespace TUIO;
 using namespace osc;
 
+// The per-frame messages, laid out once (see OscFixedMessage.h).
+static const Int32ListMessageTemplate aliveMessage( "/tuio/2Dcur", "alive" );
+static const FixedMessageTemplate<1, 5> setMessage( "/tuio/2Dcur", "set" );
+static const FixedMessageTemplate<1, 0> fseqMessage( "/tuio/2Dcur", "fseq" );
+
+// TUIO 2.0 messages have no command string.  A pointer is s_id, tu_id and
+// c_id, then x, y, angle, shear, radius and pressure, without the speeds.
+static const Int32ListMessageTemplate tuio2AliveMessage( "/tuio2/alv", NULL );
+static const FixedMessageTemplate<3, 6> tuio2PointerMessage( "/tuio2/ptr", NULL );
+
+// Sent in /tuio2/frm if setSourceName() was not called.
+static const char * const TUIO2_DEFAULT_SOURCE = "TouchHooks2Tuio";
+
 TuioCursorServer::TuioCursorServer( const char * host /*= "127.0.0.1"*/, 
                                     int udpPort1 /*= 3333*/, 
                                     int udpPort2 /*= 3334*/, 
                                     int flashXmlTcpPort /*= 3000*/ ) :
-  firstUdpSender_( new UdpSender( host, udpPort1 ) ),
-  secondUdpSender_( new UdpSender( host, udpPort2 ) ),
+  udpSender_( new UdpFanOutSender() ),
+  flashXmlRate_( channelRate( 0 ) ),
   flashXmlTcpSender_( new FlashXmlTcpServer() ),
-  useFirstUdpSender_( true ),
-  useSecondUdpSender_( true ),
+  flashXmlEncoder_( new FlashXmlEncoder( flashXmlTcpPort ) ),
   useFlashXmlTcpSender_( true ),
-  flashXmlTcpPortStr_(),
   oscUdpBuffer_( nullptr ),
   oscUdpPacket_( nullptr ),
   updateInterval_( 1 ),
   fullUpdate_( false ),
   periodicUpdate_( false ),
   cursorUpdateTime_( TuioTime( currentFrameTime_ ) ),
-  sourceName_( nullptr )
+  sourceName_( nullptr ),
+  sourceDimensions_( 0 ),
+  motionPredictor_(),
+  snapshotWriter_( NULL )
 {
+    udpSender_->addEndpoint( host, udpPort1 ); // FIRST_UDP_ENDPOINT
+    udpSender_->addEndpoint( host, udpPort2 ); // SECOND_UDP_ENDPOINT
+    udpEndpointRates_.resize( 2, channelRate( 0 ) );
+    udpEndpointProfiles_.resize( 2, TUIO_1_1 );
+    bundleProfile_ = TUIO_1_1;
+    removedCursors_.reserve( TuioCursorTable::CAPACITY );
     initialize();
+    setPathDepth( 0 ); // the paths are never drawn or sent
 
-    flashXmlTcpPortStr_ = int2Str( flashXmlTcpPort );
     bool ok = flashXmlTcpSender_->setup( flashXmlTcpPort );
 
     if( ok ) {
@@ -76,19 +98,180 @@ TuioCursorServer::~TuioCursorServer()
     if( sourceName_ ) delete [] sourceName_;
     delete oscUdpPacket_;
     delete [] oscUdpBuffer_;
-    delete secondUdpSender_;
-    delete firstUdpSender_;
+    delete udpSender_;
     delete flashXmlTcpSender_;
+    delete flashXmlEncoder_;
+}
+
+/**
+ * Sending starts with the new endpoint.  Endpoints should be added before
+ * the first frame, since a remote host lowers the largest packet size.
+ *
+ * @return  the endpoint's index, or -1 if there are already
+ *          UdpFanOutSender::MAX_ENDPOINTS.
+ */
+int TuioCursorServer::addUdpEndpoint( const char * host, int port, bool enabled /*= true*/ )
+{
+    int i = udpSender_->addEndpoint( host, port, enabled );
+
+    if( i >= 0 ) {
+        udpEndpointRates_.push_back( channelRate( 0 ) );
+        udpEndpointProfiles_.push_back( TUIO_1_1 );
+    }
+    if( udpSender_->getBufferSize() < (int)oscUdpPacket_->Capacity() ) {
+        allocateUdpPacket();
+    }
+    return i;
+}
+
+void TuioCursorServer::useUdpEndpoint( int i, bool b )
+{
+    udpSender_->enableEndpoint( i, b );
+}
+
+bool TuioCursorServer::useUdpEndpoint( int i )
+{
+    return udpSender_->isEndpointEnabled( i );
+}
+
+bool TuioCursorServer::isUdpEndpointRunning( int i )
+{
+    return udpSender_->isEndpointConnected( i );
+}
+
+void TuioCursorServer::setUdpEndpointFrameRate( int i, int framesPerSecond )
+{
+    if( i >= 0 && i < (int)udpEndpointRates_.size() ) {
+        udpEndpointRates_[i] = channelRate( framesPerSecond );
+    }
+}
+
+int TuioCursorServer::getUdpEndpointFrameRate( int i )
+{
+    return i >= 0 && i < (int)udpEndpointRates_.size() ? framesPerSecond( udpEndpointRates_[i] ) : 0;
+}
+
+void TuioCursorServer::setFlashXmlFrameRate( int framesPerSecond )
+{
+    flashXmlRate_ = channelRate( framesPerSecond );
+}
+
+int TuioCursorServer::getFlashXmlFrameRate()
+{
+    return framesPerSecond( flashXmlRate_ );
+}
+
+const char * TuioCursorServer::profileName( Profile profile )
+{
+    return profile == TUIO_2_0 ? "2.0" : "1.1";
+}
+
+bool TuioCursorServer::parseProfile( const std::string & name, Profile & profile )
+{
+    const Profile profiles[] = { TUIO_1_1, TUIO_2_0 };
+
+    for( size_t i = 0; i < sizeof( profiles ) / sizeof( profiles[0] ); ++i ) {
+        if( name == profileName( profiles[i] ) ) {
+            profile = profiles[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void TuioCursorServer::setUdpEndpointProfile( int i, Profile profile )
+{
+    if( i >= 0 && i < (int)udpEndpointProfiles_.size() ) {
+        udpEndpointProfiles_[i] = profile;
+    }
+}
+
+TuioCursorServer::Profile TuioCursorServer::getUdpEndpointProfile( int i )
+{
+    return i >= 0 && i < (int)udpEndpointProfiles_.size() ? udpEndpointProfiles_[i] : TUIO_1_1;
+}
+
+void TuioCursorServer::setSourceDimensions( int width, int height )
+{
+    sourceDimensions_ = (int32)(((uint32)width & 0xFFFF) << 16 | ((uint32)height & 0xFFFF));
+}
+
+TuioCursorServer::ChannelRate TuioCursorServer::channelRate( int framesPerSecond )
+{
+    ChannelRate rate;
+    rate.interval = framesPerSecond > 0 ? USEC_SECOND / framesPerSecond : 0;
+    rate.sentFrame = TuioTime();
+    rate.sentTime = TuioTime();
+    rate.held = false;
+    rate.sending = false;
+    return rate;
+}
+
+int TuioCursorServer::framesPerSecond( const ChannelRate & rate )
+{
+    return rate.interval > 0 ? (int)(USEC_SECOND / rate.interval) : 0;
+}
+
+/**
+ * Ticks are kept on a grid, so that with input frames every 4 ms a 60 Hz
+ * channel gets 60 frames a second and not 50.  A frame sent early, for an
+ * add or remove, leaves the grid where it was; one sent more than a tick
+ * late starts it again.
+ */
+void TuioCursorServer::markSent( ChannelRate & rate, TuioTime now )
+{
+    int64_t nowMicroseconds = now.getTotalMicroseconds(),
+            tick = rate.sentTime.getTotalMicroseconds() + rate.interval;
+
+    if( nowMicroseconds >= tick ) {
+        tick = nowMicroseconds - tick < rate.interval ? tick : nowMicroseconds;
+        rate.sentTime = TuioTime( (long)(tick / USEC_SECOND), (long)(tick % USEC_SECOND) );
+    }
+    rate.sentFrame = currentFrameTime_;
+    rate.held = false;
+}
+
+/**
+ * A frame that adds or removes a cursor is due on every channel.
+ */
+bool TuioCursorServer::isDue( const ChannelRate & rate, TuioTime now )
+{
+    return rate.interval == 0 || aliveChanged_ 
+        || now.getTotalMicroseconds() - rate.sentTime.getTotalMicroseconds() >= rate.interval;
+}
+
+/**
+ * Cursors stamped with the frame time changed in this frame, even if an
+ * earlier frame had the same time.
+ */
+bool TuioCursorServer::changedSince( TuioCursor * tcur, TuioTime since )
+{
+    TuioTime time = tcur->getTuioTime();
+    return time == currentFrameTime_ || time.getTotalMicroseconds() > since.getTotalMicroseconds();
 }
 
-bool TuioCursorServer::isFirstUdpSenderRunning()
+void TuioCursorServer::addOscSender( OscSender * sender, int framesPerSecond /*= 0*/, Profile profile /*= TUIO_1_1*/ )
 {
-    return firstUdpSender_->isConnected ();
+    oscSenders_.push_back( sender );
+    oscSenderRates_.push_back( channelRate( framesPerSecond ) );
+    oscSenderProfiles_.push_back( profile );
+
+    if( sender->getBufferSize() < (int)oscUdpPacket_->Capacity() ) {
+        allocateUdpPacket();
+    }
 }
 
-bool TuioCursorServer::isSecondUdpSenderRunning()
+bool TuioCursorServer::anyOscSenderEnabled()
 {
-    return secondUdpSender_->isConnected ();
+    if( !oscSenders_.empty() ) {
+        return true;
+    }
+    for( int i = 0; i < udpSender_->getEndpointCount(); ++i ) {
+        if( udpSender_->isEndpointEnabled( i ) ) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool TuioCursorServer::isFlashXmlTcpSenderRunning()
@@ -98,9 +281,7 @@ bool TuioCursorServer::isFlashXmlTcpSenderRunning()
 
 void TuioCursorServer::initialize() 
 {
-    int udpBufferSize = firstUdpSender_->getBufferSize();
-    oscUdpBuffer_ = new char[udpBufferSize];
-    oscUdpPacket_ = new osc::OutboundPacketStream( oscUdpBuffer_, udpBufferSize );
+    allocateUdpPacket();
 
     initFrame( TuioTime::getSessionTime() );
     cursorUpdateTime_ = TuioTime( currentFrameTime_ );
@@ -111,54 +292,136 @@ void TuioCursorServer::initialize()
     invert_a_ = false;
 }
 
+void TuioCursorServer::allocateUdpPacket()
+{
+    int udpBufferSize = udpSender_->getBufferSize();
+
+    for( size_t i = 0; i < oscSenders_.size(); ++i ) {
+        if( oscSenders_[i]->getBufferSize() < udpBufferSize ) {
+            udpBufferSize = oscSenders_[i]->getBufferSize();
+        }
+    }
+
+    delete oscUdpPacket_;
+    delete [] oscUdpBuffer_;
+    oscUdpBuffer_ = new char[udpBufferSize];
+    oscUdpPacket_ = new osc::OutboundPacketStream( oscUdpBuffer_, udpBufferSize );
+}
+
 void TuioCursorServer::sendEmptyUdpCursorBundle()
 {
-    oscUdpPacket_->Clear();	
-    (*oscUdpPacket_) << osc::BeginBundleImmediate;
+    selectAllOscChannels();
+
+    if( selectProfile( TUIO_1_1 ) ) {
+        oscUdpPacket_->Clear();	
+        (*oscUdpPacket_) << osc::BeginBundleImmediate;
 
-    if( sourceName_ ) {
-        (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur") 
-                         << "source" << sourceName_ << osc::EndMessage;
+        if( sourceName_ ) {
+            (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur") 
+                             << "source" << sourceName_ << osc::EndMessage;
+        }
+        (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur") << "alive" << osc::EndMessage;	
+        (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << -1 << osc::EndMessage;
+        (*oscUdpPacket_) << osc::EndBundle;
+        deliverOscUdpPacket( oscUdpPacket_ );
+    }
+    if( selectProfile( TUIO_2_0 ) ) {
+        oscUdpPacket_->Clear();
+        (*oscUdpPacket_) << osc::BeginBundleImmediate;
+        addTuio2FrameMessage();
+        tuio2AliveMessage.Write( *oscUdpPacket_, 0 );
+        (*oscUdpPacket_) << osc::EndBundle;
+        deliverOscUdpPacket( oscUdpPacket_ );
     }
-    (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur") << "alive" << osc::EndMessage;	
-    (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << -1 << osc::EndMessage;
-    (*oscUdpPacket_) << osc::EndBundle;
-    deliverOscUdpPacket( oscUdpPacket_ );
 }
 
-void TuioCursorServer::deliverOscUdpPacket( osc::OutboundPacketStream  * packet )
+void TuioCursorServer::selectAllOscChannels()
 {
-    if( useFirstUdpSender_ ) {  
-        firstUdpSender_->sendOscPacket( packet ); 
+    for( size_t i = 0; i < udpEndpointRates_.size(); ++i ) {
+        udpEndpointRates_[i].sending = true;
     }
-    if( useSecondUdpSender_ ) { 
-        secondUdpSender_->sendOscPacket( packet );
+    for( size_t i = 0; i < oscSenderRates_.size(); ++i ) {
+        oscSenderRates_[i].sending = true;
     }
 }
 
-void TuioCursorServer::sendEmptyFlashXmlTcpCursorBundle()
+/**
+ * Makes the bundles that follow of the given profile.
+ *
+ * @return  false if none of the selected channels takes that profile.
+ */
+bool TuioCursorServer::selectProfile( Profile profile )
 {
-    std::stringstream message;
-    message << "<OSCPACKET ADDRESS=\"127.0.0.1\" PORT=\"" << flashXmlTcpPortStr_
-            << "\" TIME=\"" << (currentFrameTime_.getTotalMilliseconds() / 1000.0f) << "\">"
+    bundleProfile_ = profile;
 
-               "<MESSAGE NAME=\"/tuio/2Dcur\">"
-               "<ARGUMENT TYPE=\"s\" VALUE=\"alive\"/>"
-               "</MESSAGE>"
+    for( size_t i = 0; i < udpEndpointRates_.size(); ++i ) {
+        if( udpEndpointRates_[i].sending && udpEndpointProfiles_[i] == profile ) {
+            return true;
+        }
+    }
+    for( size_t i = 0; i < oscSenderRates_.size(); ++i ) {
+        if( oscSenderRates_[i].sending && oscSenderProfiles_[i] == profile ) {
+            return true;
+        }
+    }
+    return false;
+}
 
-               "<MESSAGE NAME=\"/tuio/2Dcur\">"
-               "<ARGUMENT TYPE=\"s\" VALUE=\"fseq\"/>"
-               "<ARGUMENT TYPE=\"i\" VALUE=\"" << currentFrame_  << "\"/>" 
-               "</MESSAGE>"
+/**
+ * Sends the packet to the channels selected for the bundle being built
+ * that take its profile.
+ */
+void TuioCursorServer::deliverOscUdpPacket( osc::OutboundPacketStream  * packet )
+{
+    unsigned int endpoints = 0;
 
-               "</OSCPACKET>";
+    for( size_t i = 0; i < udpEndpointRates_.size(); ++i ) {
+        if( udpEndpointRates_[i].sending && udpEndpointProfiles_[i] == bundleProfile_ ) {
+            endpoints |= 1u << i;
+        }
+    }
+    if( endpoints != 0 ) {
+        // one batched send for all of them
+        udpSender_->sendPacket( packet->Data(), (int)packet->Size(), endpoints );
+    }
+    for( size_t i = 0; i < oscSenders_.size(); ++i ) {
+        if( oscSenderRates_[i].sending && oscSenderProfiles_[i] == bundleProfile_ ) {
+            oscSenders_[i]->sendOscPacket( packet );
+        }
+    }
+}
 
-    std::string msg = message.str();
-    bool ok = flashXmlTcpSender_->sendtoAll( msg );
+/**
+ * Asks every OscSender selected for the bundle being built whether its
+ * receivers need all the cursors (a WebSocketSender that dropped messages
+ * or took a new client).  Each is asked, so none keeps a stale request.
+ */
+bool TuioCursorServer::fullFrameRequested()
+{
+    bool requested = false;
 
-    //if( ok ) {  std::cout << "\nok = true\n"; }
-    //else     {  std::cout << "\nok = false\n"; }
-    //std::cout << "\n\n" << msg.c_str() << "\n\n";
+    for( size_t i = 0; i < oscSenders_.size(); ++i ) {
+        if( oscSenderRates_[i].sending && oscSenderProfiles_[i] == bundleProfile_
+            && oscSenders_[i]->fullFrameRequested() ) {
+            requested = true;
+        }
+    }
+    return requested;
+}
+
+void TuioCursorServer::sendEmptyFlashXmlTcpCursorBundle()
+{
+    flashXmlEncoder_->beginPacket( currentFrameTime_.getTotalMilliseconds() );
+    flashXmlEncoder_->beginAliveMessage();
+    flashXmlEncoder_->endAliveMessage();
+    flashXmlEncoder_->addFseqMessage( currentFrame_ );
+    sendFlashXmlPacket();
+}
+
+void TuioCursorServer::sendFlashXmlPacket()
+{
+    flashXmlEncoder_->endPacket();
+    flashXmlTcpSender_->sendtoAll( flashXmlEncoder_->data(), (int)flashXmlEncoder_->size() );
 }
 
 void TuioCursorServer::commitFrame() 
@@ -166,8 +429,14 @@ void TuioCursorServer::commitFrame()
     // Update any listeners by calling on the superclass.
     TuioCursorManager::commitFrame();
 
+    if( updateCursor_ && motionPredictor_.isEnabled() ) {
+        predictCursors();
+    }
+    if( updateCursor_ && snapshotWriter_ != NULL ) {
+        publishCursorSnapshot();
+    }
     if( updateCursor_ ) {
-        if( useFirstUdpSender_ || useSecondUdpSender_ ) {
+        if( anyOscSenderEnabled() ) {
             processTuioUdpMessages();
         }
         if( useFlashXmlTcpSender_ ) {
@@ -179,142 +448,464 @@ void TuioCursorServer::commitFrame()
 
         if( timeCheck.getSeconds() >= updateInterval_ ) {
             cursorUpdateTime_ = TuioTime( currentFrameTime_ );
-            startUdpCursorBundle();
-
-            if( fullUpdate_ ) {
-                for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
-                    // start a new packet if we exceed the packet capacity
-                    if( (oscUdpPacket_->Capacity() - oscUdpPacket_->Size()) < CUR_MESSAGE_SIZE ) {
-                        sendUdpCursorBundle( currentFrame_ );
-                        startUdpCursorBundle();
+            selectAllOscChannels();
+
+            for( int profile = TUIO_1_1; profile <= TUIO_2_0; ++profile ) {
+                if( !selectProfile( (Profile)profile ) ) {
+                    continue;
+                }
+                startUdpCursorBundle( currentFrameTime_ );
+
+                if( fullUpdate_ ) {
+                    for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
+                        addUpdatedUdpCursorMessage( *tuioCursor, TYPE_UNKNOWN, false, currentFrameTime_ );
+                    }
+                    for( unsigned int i = 0; i < cursorTable_.size(); ++i ) {
+                        addUpdatedUdpCursorMessage( cursorTable_.at( i ), cursorTable_.typeIdOf( cursorTable_.at( i ) ),
+                                                    false, currentFrameTime_ );
                     }
-                    addUdpCursorMessage( *tuioCursor );
                 }
+                sendUdpCursorBundle( currentFrame_ );
             }
-            sendUdpCursorBundle( currentFrame_ );
         }
     }
+    removedCursors_.clear();
     updateCursor_ = false;
+    aliveChanged_ = false;
 }
 
-void TuioCursorServer::processTuioUdpMessages()
+/**
+ * Every active cursor is handed to the predictor, so that it can forget the
+ * ones that were removed.  Only the ones that moved cost a prediction.
+ */
+void TuioCursorServer::predictCursors()
+{
+    for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
+        motionPredictor_.update( *tuioCursor );
+    }
+    for( unsigned int i = 0; i < cursorTable_.size(); ++i ) {
+        motionPredictor_.update( cursorTable_.at( i ) );
+    }
+    motionPredictor_.forgetUnseen();
+}
+
+/**
+ * The whole cursor table goes into the snapshot, each cursor with whether
+ * it changed in this frame.
+ */
+void TuioCursorServer::publishCursorSnapshot()
 {
-    startUdpCursorBundle();
+    float xpos, ypos;
+
+    snapshotWriter_->beginFrame( currentFrame_, currentFrameTime_ );
 
     for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
-        // Start a new packet if we exceed the packet capacity.
-        if( (oscUdpPacket_->Capacity() - oscUdpPacket_->Size()) < CUR_MESSAGE_SIZE ) {
-            sendUdpCursorBundle( currentFrame_ );
-            startUdpCursorBundle();
+        cursorPosition( *tuioCursor, xpos, ypos );
+        snapshotWriter_->addCursor( *tuioCursor, xpos, ypos, changedSince( *tuioCursor, currentFrameTime_ ) );
+    }
+    for( unsigned int i = 0; i < cursorTable_.size(); ++i ) {
+        TuioCursor * tcur = cursorTable_.at( i );
+        cursorPosition( tcur, xpos, ypos );
+        snapshotWriter_->addCursor( tcur, xpos, ypos, changedSince( tcur, currentFrameTime_ ) );
+    }
+    snapshotWriter_->endFrame();
+}
+
+/**
+ * The position to send: the predicted one, if prediction is on.
+ */
+void TuioCursorServer::cursorPosition( TuioCursor * tcur, float & x, float & y )
+{
+    if( motionPredictor_.isEnabled() ) {
+        motionPredictor_.position( tcur, x, y );
+    }
+    else {
+        x = tcur->getX();
+        y = tcur->getY();
+    }
+}
+
+/**
+ * A removed cursor is kept for the rest of the frame if a rate limited
+ * channel has not been sent its last move.  The frame is due on every
+ * channel, since it removes a cursor.
+ */
+void TuioCursorServer::removingTuioCursor( TuioCursor * tcur, int typeId )
+{
+    TuioTime changed = tcur->getTuioTime();
+
+    if( changed == currentFrameTime_ || !heldSince( changed ) ) {
+        return;
+    }
+    RemovedCursor removed;
+    removed.sessionId = tcur->getSessionID();
+    removed.typeId = typeId;
+    cursorPosition( tcur, removed.x, removed.y );
+    removed.xSpeed = tcur->getXSpeed();
+    removed.ySpeed = tcur->getYSpeed();
+    removed.motionAccel = tcur->getMotionAccel();
+    removed.changed = changed;
+    removedCursors_.push_back( removed );
+}
+
+/**
+ * @return  true if a rate limited channel was last sent a frame before
+ *          changed.
+ */
+bool TuioCursorServer::heldSince( TuioTime changed )
+{
+    int64_t time = changed.getTotalMicroseconds();
+
+    for( size_t i = 0; i < udpEndpointRates_.size(); ++i ) {
+        const ChannelRate & rate = udpEndpointRates_[i];
+
+        if( rate.interval > 0 && rate.sentFrame.getTotalMicroseconds() < time ) {
+            return true;
+        }
+    }
+    for( size_t i = 0; i < oscSenderRates_.size(); ++i ) {
+        const ChannelRate & rate = oscSenderRates_[i];
+
+        if( rate.interval > 0 && rate.sentFrame.getTotalMicroseconds() < time ) {
+            return true;
         }
-        TuioCursor * tcur = (*tuioCursor);
+    }
+    return flashXmlRate_.interval > 0 && flashXmlRate_.sentFrame.getTotalMicroseconds() < time;
+}
+
+/**
+ * A channel sent every frame, or the frame before the removal, already has
+ * the cursor's last move.
+ */
+bool TuioCursorServer::removedSince( const RemovedCursor & removed, TuioTime since )
+{
+    return since != currentFrameTime_ 
+        && removed.changed.getTotalMicroseconds() > since.getTotalMicroseconds();
+}
 
-        if( fullUpdate_ || (tcur->getTuioTime() == currentFrameTime_) ) {
-            addUdpCursorMessage( tcur );
+/**
+ * A held channel is due one interval after it was last sent to.
+ */
+long TuioCursorServer::nextHeldFrameTime()
+{
+    long next = -1;
+
+    for( size_t i = 0; i < udpEndpointRates_.size() + oscSenderRates_.size() + 1; ++i ) {
+        bool isEndpoint = i < udpEndpointRates_.size(),
+             isFlashXml = i == udpEndpointRates_.size() + oscSenderRates_.size();
+        const ChannelRate & rate = isEndpoint ? udpEndpointRates_[i]
+                                 : isFlashXml ? flashXmlRate_
+                                 : oscSenderRates_[i - udpEndpointRates_.size()];
+        bool enabled = isEndpoint ? udpSender_->isEndpointEnabled( (int)i )
+                     : isFlashXml ? useFlashXmlTcpSender_ : true;
+
+        if( rate.held && enabled ) {
+            long due = rate.sentTime.getTotalMilliseconds() + (rate.interval + 999) / 1000;
+
+            if( next < 0 || due < next ) {
+                next = due;
+            }
         }
     }
+    return next;
+}
+
+void TuioCursorServer::sendHeldFrames( TuioTime now )
+{
+    sendOscFrames( true, now );
+
+    if( useFlashXmlTcpSender_ && flashXmlRate_.held && isDue( flashXmlRate_, now ) ) {
+        sendFlashXmlFrame( now );
+    }
+}
+
+void TuioCursorServer::processTuioUdpMessages()
+{
+    sendOscFrames( false, currentFrameTime_ );
     cursorUpdateTime_ = TuioTime( currentFrameTime_ );
-    sendUdpCursorBundle( currentFrame_ );
 }
 
-void TuioCursorServer::startUdpCursorBundle()
+/**
+ * The channels that get every frame share one bundle with the cursors
+ * changed in this frame.  Then the due rate limited channels are sent the
+ * cursors changed since the last frame they got, one bundle for each group
+ * of them that got the same last frame.  With heldOnly, only limited
+ * channels with changes held back are looked at.
+ */
+void TuioCursorServer::sendOscFrames( bool heldOnly, TuioTime now )
+{
+    size_t endpoints = udpEndpointRates_.size(),
+           channels = endpoints + oscSenderRates_.size();
+    bool everyFrame = false;
+
+    for( size_t i = 0; i < channels; ++i ) {
+        ChannelRate & rate = i < endpoints ? udpEndpointRates_[i] : oscSenderRates_[i - endpoints];
+        rate.sending = !heldOnly && rate.interval == 0;
+        everyFrame = everyFrame || rate.sending;
+    }
+    if( everyFrame ) {
+        sendOscFrame( currentFrameTime_ );
+    }
+    for( ;; ) {
+        bool found = false;
+        TuioTime since;
+
+        for( size_t i = 0; i < channels; ++i ) {
+            ChannelRate & rate = i < endpoints ? udpEndpointRates_[i] : oscSenderRates_[i - endpoints];
+            bool enabled = i >= endpoints || udpSender_->isEndpointEnabled( (int)i ),
+                 due = rate.interval > 0 && enabled && rate.sentFrame != currentFrameTime_
+                    && (!heldOnly || rate.held) && isDue( rate, now );
+
+            if( !heldOnly && !due && rate.interval > 0 && rate.sentFrame != currentFrameTime_ ) {
+                rate.held = true;
+            }
+            if( due && !found ) {
+                since = rate.sentFrame;
+                found = true;
+            }
+            rate.sending = due && rate.sentFrame == since;
+        }
+        if( !found ) {
+            break;
+        }
+        sendOscFrame( since );
+
+        for( size_t i = 0; i < channels; ++i ) {
+            ChannelRate & rate = i < endpoints ? udpEndpointRates_[i] : oscSenderRates_[i - endpoints];
+
+            if( rate.sending && rate.interval > 0 ) {
+                markSent( rate, now );
+            }
+        }
+    }
+}
+
+/**
+ * Sends a frame to the selected channels, one bundle for each profile
+ * among them.
+ */
+void TuioCursorServer::sendOscFrame( TuioTime since )
+{
+    for( int profile = TUIO_1_1; profile <= TUIO_2_0; ++profile ) {
+        if( !selectProfile( (Profile)profile ) ) {
+            continue;
+        }
+        bool allCursors = fullFrameRequested() || fullUpdate_;
+        startUdpCursorBundle( since );
+
+        for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
+            addUpdatedUdpCursorMessage( *tuioCursor, TYPE_UNKNOWN, !allCursors, since );
+        }
+        for( unsigned int i = 0; i < cursorTable_.size(); ++i ) {
+            addUpdatedUdpCursorMessage( cursorTable_.at( i ), cursorTable_.typeIdOf( cursorTable_.at( i ) ),
+                                        !allCursors, since );
+        }
+        sendUdpCursorBundle( currentFrame_ );
+    }
+}
+
+void TuioCursorServer::addUpdatedUdpCursorMessage( TuioCursor * tcur, int typeId, bool updatedOnly, TuioTime since )
+{
+    if( updatedOnly && !changedSince( tcur, since ) ) {
+        return;
+    }
+    // Start a new packet if we exceed the packet capacity.  A TUIO 2.0
+    // bundle still needs room for its alive message, which comes last.
+    unsigned long needed = CUR_MESSAGE_SIZE;
+
+    if( bundleProfile_ == TUIO_2_0 ) {
+        needed = 4 + tuio2PointerMessage.Size() 
+               + 4 + tuio2AliveMessage.Size( cursorList_.size() + cursorTable_.size() );
+    }
+    if( (oscUdpPacket_->Capacity() - oscUdpPacket_->Size()) < needed ) {
+        sendUdpCursorBundle( currentFrame_ );
+        startUdpCursorBundle( currentFrameTime_ );
+    }
+    addUdpCursorMessage( tcur, typeId );
+}
+
+/**
+ * The moves held back for cursors removed in this frame come first, so a
+ * client applies them before the alive message that ends the cursors.
+ * A bundle started again after a full one passes the frame time, and gets
+ * none.
+ */
+void TuioCursorServer::startUdpCursorBundle( TuioTime since )
 {
     oscUdpPacket_->Clear();
     (*oscUdpPacket_) << osc::BeginBundleImmediate;
 
-    if( sourceName_ ) {
+    if( bundleProfile_ == TUIO_2_0 ) {
+        addTuio2FrameMessage();
+    }
+    else if( sourceName_ ) {
         (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur" ) 
                          << "source" << sourceName_ 
                          << osc::EndMessage;
     }
-    (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+    // Room is kept for the alive message; a held move that does not fit
+    // is left out.
+    size_t alive = cursorList_.size() + cursorTable_.size();
+    unsigned long needed = bundleProfile_ == TUIO_2_0
+                         ? 4 + tuio2PointerMessage.Size() + 4 + tuio2AliveMessage.Size( alive )
+                         : CUR_MESSAGE_SIZE + 4 + aliveMessage.Size( alive );
+
+    for( size_t i = 0; i < removedCursors_.size(); ++i ) {
+        const RemovedCursor & removed = removedCursors_[i];
+
+        if( removedSince( removed, since ) && oscUdpPacket_->Capacity() - oscUdpPacket_->Size() >= needed ) {
+            addUdpCursorMessage( removed.sessionId, removed.typeId, removed.x, removed.y, 
+                                 removed.xSpeed, removed.ySpeed, removed.motionAccel );
+        }
+    }
+    if( bundleProfile_ == TUIO_2_0 ) {
+        return;
+    }
+    char * ids = aliveMessage.Write( *oscUdpPacket_, alive );
 
-    for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
-        (*oscUdpPacket_) << (int32)((*tuioCursor)->getSessionID());
+    for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor, ids += 4 ) {
+        FixedMessageStoreUInt32( ids, (uint32)((*tuioCursor)->getSessionID()) );
+    }
+    for( unsigned int i = 0; i < cursorTable_.size(); ++i, ids += 4 ) {
+        FixedMessageStoreUInt32( ids, (uint32)(cursorTable_.at( i )->getSessionID()) );
     }
-    (*oscUdpPacket_) << osc::EndMessage;
 }
 
-void TuioCursorServer::addUdpCursorMessage( TuioCursor * tcur )
+void TuioCursorServer::addUdpCursorMessage( TuioCursor * tcur, int typeId )
 {
-    float xpos = tcur->getX();
-    float xvel = tcur->getXSpeed();
+    float xpos, ypos;
+    cursorPosition( tcur, xpos, ypos );
+    addUdpCursorMessage( tcur->getSessionID(), typeId, xpos, ypos, 
+                         tcur->getXSpeed(), tcur->getYSpeed(), tcur->getMotionAccel() );
+}
 
+void TuioCursorServer::addUdpCursorMessage( long sessionId, int typeId, float xpos, float ypos, 
+                                            float xvel, float yvel, float motionAccel )
+{
     if( invert_x_ ) {
         xpos = 1 - xpos;
         xvel = -1 * xvel;
     }
-    float ypos = tcur->getY();
-    float yvel = tcur->getYSpeed();
-
     if( invert_y_ ) {
         ypos = 1 - ypos;
         yvel = -1 * yvel;
     }
-    (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur" ) << "set";
-    (*oscUdpPacket_) << (int32)(tcur->getSessionID()) << xpos << ypos;
-    (*oscUdpPacket_) << xvel << yvel << tcur->getMotionAccel();
-    (*oscUdpPacket_) << osc::EndMessage;
+    int32 s_id = (int32)sessionId;
+
+    if( bundleProfile_ == TUIO_2_0 ) {
+        // tu_id is the user ID (none) in the high and the type ID in the low
+        // 16 bits; the component ID is 0 for a lone pointer.
+        int32 ids[3] = { s_id, (int32)(typeId & 0xFFFF), 0 };
+        float values[6] = { xpos, ypos, 0.0f, 0.0f, 0.0f, 0.0f };
+        tuio2PointerMessage.Write( *oscUdpPacket_, ids, values );
+        return;
+    }
+    float values[5] = { xpos, ypos, xvel, yvel, motionAccel };
+    setMessage.Write( *oscUdpPacket_, &s_id, values );
 }
 
 void TuioCursorServer::sendUdpCursorBundle(long fseq) 
 {
-    (*oscUdpPacket_) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << (int32)fseq << osc::EndMessage;
+    if( bundleProfile_ == TUIO_2_0 ) {
+        // The alive message ends a TUIO 2.0 frame.
+        char * alive = tuio2AliveMessage.Write( *oscUdpPacket_, cursorList_.size() + cursorTable_.size() );
+
+        for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor, alive += 4 ) {
+            FixedMessageStoreUInt32( alive, (uint32)((*tuioCursor)->getSessionID()) );
+        }
+        for( unsigned int i = 0; i < cursorTable_.size(); ++i, alive += 4 ) {
+            FixedMessageStoreUInt32( alive, (uint32)(cursorTable_.at( i )->getSessionID()) );
+        }
+    }
+    else {
+        int32 frame = (int32)fseq;
+        fseqMessage.Write( *oscUdpPacket_, &frame, NULL );
+    }
     (*oscUdpPacket_) << osc::EndBundle;
     deliverOscUdpPacket( oscUdpPacket_ );
 }
 
-void TuioCursorServer::processFlashXmlTcpMessages()
+/**
+ * /tuio2/frm f_id time dim source.  The time is the frame's TuioTime (the
+ * input time, since the session start) as an OSC time tag, so a client can
+ * work out the cursor speeds from it.  Written once per bundle, so it is
+ * not worth a template.
+ */
+void TuioCursorServer::addTuio2FrameMessage()
 {
-    std::string setBlobsMsg;
-    std::string aliveBlobsMsg;
-
-    for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
-        TuioCursor * tcur = (*tuioCursor);
+    uint64 seconds = (uint64)currentFrameTime_.getSeconds(),
+           fraction = ((uint64)currentFrameTime_.getMicroseconds() << 32) / USEC_SECOND;
+
+    (*oscUdpPacket_) << osc::BeginMessage( "/tuio2/frm" ) 
+                     << (int32)currentFrame_ 
+                     << osc::TimeTag( seconds << 32 | fraction )
+                     << sourceDimensions_
+                     << (sourceName_ ? sourceName_ : TUIO2_DEFAULT_SOURCE)
+                     << osc::EndMessage;
+}
 
-        if( fullUpdate_ || (tcur->getTuioTime() == currentFrameTime_) ) {
-            addFlashXml2DcurProfile( setBlobsMsg, tcur );
-        }
-        aliveBlobsMsg += "<ARGUMENT TYPE=\"i\" VALUE=\"" + int2Str( tcur->getSessionID() ) + "\"/>";
+void TuioCursorServer::processFlashXmlTcpMessages()
+{
+    if( !isDue( flashXmlRate_, currentFrameTime_ ) ) {
+        flashXmlRate_.held = true;
+        return;
     }
+    sendFlashXmlFrame( currentFrameTime_ );
+}
 
-    std::stringstream message;
-    message << "<OSCPACKET ADDRESS=\"127.0.0.1\" PORT=\"" << flashXmlTcpPortStr_
-            << "\" TIME=\"" << (currentFrameTime_.getTotalMilliseconds() / 1000.0f) << "\">"
+void TuioCursorServer::sendFlashXmlFrame( TuioTime now )
+{
+    // If a slow client had frames dropped, the cursors that moved in them
+    // are sent again in this frame.
+    bool allCursors = flashXmlTcpSender_->fullFrameRequested() || fullUpdate_;
+    TuioTime since = flashXmlRate_.interval > 0 ? flashXmlRate_.sentFrame : currentFrameTime_;
 
-            << setBlobsMsg 
+    flashXmlEncoder_->beginPacket( currentFrameTime_.getTotalMilliseconds() );
 
-            << "<MESSAGE NAME=\"/tuio/2Dcur\">"
-               "<ARGUMENT TYPE=\"s\" VALUE=\"alive\"/>"
-            << aliveBlobsMsg 
-            << "</MESSAGE>"
+    for( size_t i = 0; i < removedCursors_.size(); ++i ) {
+        const RemovedCursor & removed = removedCursors_[i];
 
-               "<MESSAGE NAME=\"/tuio/2Dcur\">"
-               "<ARGUMENT TYPE=\"s\" VALUE=\"fseq\"/>"
-               "<ARGUMENT TYPE=\"i\" VALUE=\"" << currentFrame_ << "\"/>"
-               "</MESSAGE>" 
+        if( removedSince( removed, since ) ) {
+            addFlashXmlSetMessage( removed.sessionId, removed.x, removed.y, 
+                                   removed.xSpeed, removed.ySpeed, removed.motionAccel );
+        }
+    }
+    for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
+        addFlashXmlSetMessage( *tuioCursor, allCursors, since );
+    }
+    for( unsigned int i = 0; i < cursorTable_.size(); ++i ) {
+        addFlashXmlSetMessage( cursorTable_.at( i ), allCursors, since );
+    }
+    flashXmlEncoder_->beginAliveMessage();
 
-               "</OSCPACKET>";
+    for( auto tuioCursor = cursorList_.begin(); tuioCursor != cursorList_.end(); ++tuioCursor ) {
+        flashXmlEncoder_->addAliveId( (*tuioCursor)->getSessionID() );
+    }
+    for( unsigned int i = 0; i < cursorTable_.size(); ++i ) {
+        flashXmlEncoder_->addAliveId( cursorTable_.at( i )->getSessionID() );
+    }
+    flashXmlEncoder_->endAliveMessage();
+    flashXmlEncoder_->addFseqMessage( currentFrame_ );
 
     cursorUpdateTime_ = TuioTime( currentFrameTime_ );
-
-    std::string msg = message.str();
-    bool ok = flashXmlTcpSender_->sendtoAll( msg );
-
-    //if( ok ) {  std::cout << "\nok = true\n"; }
-    //else     {  std::cout << "\nok = false\n"; }
-    //std::cout << "\n\n" << msg.c_str() ;
+    markSent( flashXmlRate_, now );
+    sendFlashXmlPacket();
 }
 
-void TuioCursorServer::addFlashXml2DcurProfile( std::string & blobMessage, TuioCursor * tcur )
+void TuioCursorServer::addFlashXmlSetMessage( TuioCursor * tcur, bool allCursors, TuioTime since )
 {
-    int id = tcur->getSessionID();
-    float xpos = tcur->getX(),
-          xvel = tcur->getXSpeed(),
-          ypos = tcur->getY(),
-          yvel = tcur->getYSpeed(),
-          maccel = tcur->getMotionAccel();
+    if( !allCursors && !changedSince( tcur, since ) ) {
+        return;
+    }
+    float xpos, ypos;
+    cursorPosition( tcur, xpos, ypos );
+    addFlashXmlSetMessage( tcur->getSessionID(), xpos, ypos, 
+                           tcur->getXSpeed(), tcur->getYSpeed(), tcur->getMotionAccel() );
+}
 
+void TuioCursorServer::addFlashXmlSetMessage( long sessionId, float xpos, float ypos, 
+                                              float xvel, float yvel, float motionAccel )
+{
     if( invert_x_ ) {
         xpos = 1 - xpos;
         xvel = -1 * xvel;
@@ -323,26 +914,14 @@ void TuioCursorServer::addFlashXml2DcurProfile( std::string & blobMessage, TuioC
         ypos = 1 - ypos;
         yvel = -1 * yvel;
     }
-
-    std::stringstream ss;
-    ss << "<MESSAGE NAME=\"/tuio/2Dcur\">"
-          "<ARGUMENT TYPE=\"s\" VALUE=\"set\"/>"
-          "<ARGUMENT TYPE=\"i\" VALUE=\"" << id     << "\"/>"  // id (session ID)
-          "<ARGUMENT TYPE=\"f\" VALUE=\"" << xpos   << "\"/>"  // x  (position)
-          "<ARGUMENT TYPE=\"f\" VALUE=\"" << ypos   << "\"/>"  // y  (position)
-          "<ARGUMENT TYPE=\"f\" VALUE=\"" << xvel   << "\"/>"  // dX (velocity vector)
-          "<ARGUMENT TYPE=\"f\" VALUE=\"" << yvel   << "\"/>"  // dY (velocity vector)
-          "<ARGUMENT TYPE=\"f\" VALUE=\"" << maccel << "\"/>"  // m  (motion acceleration)
-          "</MESSAGE>";
-
-    blobMessage += ss.str();
+    flashXmlEncoder_->addSetMessage( sessionId, xpos, ypos, xvel, yvel, motionAccel );
 }
 
 void TuioCursorServer::setSourceName( const char * src ) 
 {
     if( !sourceName_ ) sourceName_ = new char[256];
 
-    if( firstUdpSender_->isLocal() ) {
+    if( udpSender_->isLocal() ) {
         sprintf( sourceName_, "%s", src );
     } 
     else { 
@@ -377,32 +956,3 @@ void TuioCursorServer::setSourceName( const char * src )
     } 
     //std::cout << "source: " << sourceName_ << std::endl;
 }
-
-std::string TuioCursorServer::int2Str( int n )
-{
-    std::stringstream out;
-    out << n;
-    return out.str();
-}
-
-/*******************************************************************************
-The hash map-based functions below is a work in-progress and not ready for
-use.  If will crash the program receiving the /tuio/2Dcur message.
-*******************************************************************************/
-void TuioCursorServer::commitFrame( int uniqueId )
-{
-    TuioCursorManager::commitFrame();
-
-    if( updateCursor_ ) {
-        // TODO: Need version that cranks through cursor map, not cursor list.
-        startUdpCursorBundle();
-        TuioCursor * tcur = cursorMap_[uniqueId];
-
-        if( tcur != NULL && (tcur->getTuioTime() == currentFrameTime_) ) {
-            addUdpCursorMessage( tcur );
-            cursorUpdateTime_ = TuioTime( currentFrameTime_ );
-        }
-        sendUdpCursorBundle( currentFrame_ );
-        updateCursor_ = false;
-    }
-}
@@ -28,7 +28,8 @@
 #define INCLUDED_TUIOCURSORSERVER_H
 
 #include "TuioCursorManager.h"
-#include "UdpSender.h"
+#include "UdpFanOutSender.h"
+#include "MotionPredictor.h"
 #include <memory>
 #include <iostream>
 #include <vector>
@@ -37,12 +38,16 @@
 #ifndef WIN32
 #include <netdb.h>
 #include <arpa/inet.h>
+#include <unistd.h>
 #endif
 
 class FlashXmlTcpServer;
 
 namespace TUIO 
 {
+    class FlashXmlEncoder;
+    class CursorSnapshotWriter;
+
     /**
      * <p>The TuioCursorServer class is a simplfied TUIO protocol encoder 
      * intended for use with the TouchHooks2Tuio program, which intercepts
@@ -60,6 +65,39 @@ namespace TUIO
      * by the server with ADD, UPDATE and REMOVE methods in analogy to the 
      * TuioClient's TuioListener interface.</p>
      *
+     * <p>Each channel (every UDP endpoint, every added OscSender and the
+     * Flash XML channel) can be limited to a frame rate of its own, for a
+     * consumer that renders at 60 Hz or a logger that needs 10 Hz.  A
+     * limited channel is sent a frame when its next tick has come, or at once
+     * if a cursor was added or removed, so adds and removes always reach it
+     * in order and a tap shorter than a tick is still seen.  In between, the
+     * latest state of each cursor is kept: a frame sent to the channel
+     * carries every cursor changed since the last frame it got, and
+     * channels that got the same last frame share one bundle.  Changes still
+     * held back when the input stops are sent by sendHeldFrames(), which
+     * TuioCursorOutputThread calls at nextHeldFrameTime(); a caller driving
+     * the server itself must do the same.  A move still held back when its
+     * cursor is removed goes out in the frame with the removal, before the
+     * alive message that no longer lists the cursor.</p>
+     *
+     * <p>If a model is set on getMotionPredictor(), the cursors are sent
+     * where it predicts they will be a few milliseconds on, on every
+     * channel; the speeds sent stay the measured ones.</p>
+     *
+     * <p>Each UDP endpoint and added OscSender sends either TUIO 1.1
+     * /tuio/2Dcur bundles (the default) or TUIO 2.0 ones: a /tuio2/frm
+     * message with the frame ID, the frame time, the source dimensions
+     * (setSourceDimensions()) and the source name, a /tuio2/ptr message for
+     * each changed cursor with its pointer type (the type id it was added
+     * with; see TuioCursorManager::addTuioCursor()), and a
+     * /tuio2/alv message that ends the frame.  The /tuio2/ptr messages leave
+     * out the optional speeds; a TUIO 2.0 client works them out from the
+     * frame times.</p>
+     *
+     * <p>If a CursorSnapshotWriter is set, each frame that changed a cursor
+     * is also published to it, for readers on the same host, before it is
+     * sent on any other channel.</p>
+     *
      *<p>See the SimpleSimulator example project for further hints on 
      * how to use a TuioServer class and its various methods.
      * <p><code>
@@ -90,11 +128,29 @@ namespace TUIO
     class LIBDECL TuioCursorServer : public TuioCursorManager 
     { 
     public:
+        enum { FIRST_UDP_ENDPOINT = 0,
+               SECOND_UDP_ENDPOINT = 1 };
+
+        enum Profile { TUIO_1_1 = 0,      // /tuio/2Dcur alive, set and fseq
+                       TUIO_2_0 = 1 };    // /tuio2/frm, ptr and alv
+
+        // The TUIO 2.0 type IDs a cursor can be added with.  A touch
+        // screen cannot tell the fingers apart, so a finger is TYPE_UNKNOWN.
+        enum TypeId { TYPE_UNKNOWN = 0,
+                      TYPE_STYLUS = 21,
+                      TYPE_MOUSE = 23 };
+
+        /**
+         * "1.1" or "2.0", as in the settings file.
+         */
+        static const char * profileName( Profile profile );
+        static bool parseProfile( const std::string & name, Profile & profile );
+
         /**
-         * This constructor creates a TuioServer that uses internal UdpSender
-         * and TcpSender objects for sending /tuio/2Dcur messages on ports 3333
-         * and 3334 for TUIO UDP messages and port 3000 for Flash XML TCP 
-         * messages.
+         * This constructor creates a TuioServer that sends TUIO UDP
+         * /tuio/2Dcur messages to ports 3333 and 3334 (the first two UDP
+         * endpoints) and Flash XML TCP messages on port 3000.  More UDP
+         * endpoints can be added with addUdpEndpoint().
          *
          * @param  host      the UDP and TCP host name (usually 127.0.0.1).
          * @param  udpPort1  the first port for sending TUIO UDP messages.
@@ -179,7 +235,12 @@ namespace TUIO
          * Generates and sends TUIO messages of all currently active and updated TuioObjects, TuioCursors and TuioBlobs.
          */
         void commitFrame();
-        void commitFrame( int uniqueId ); // experimental
+
+        /**
+         * Same as commitFrame().  A TUIO frame always carries every active
+         * cursor in its alive message, so there is no per-cursor commit.
+         */
+        void commitFrame( int uniqueId ) { commitFrame(); }
         
         /**
          * Defines the name of this TUIO source, which is transmitted within the /tuio/[profile] source message.
@@ -188,42 +249,172 @@ namespace TUIO
          */
         void setSourceName(const char *src);
 
-        void useFirstUdpSender( bool b ) { useFirstUdpSender_ = b; }
-        bool useFirstUdpSender() { return useFirstUdpSender_; }
+        /**
+         * Adds a TUIO UDP destination.  Each bundle is written once and sent
+         * to all enabled endpoints together.
+         */
+        int addUdpEndpoint( const char * host, int port, bool enabled = true );
+        void useUdpEndpoint( int i, bool b );
+        bool useUdpEndpoint( int i );
+        bool isUdpEndpointRunning( int i );
+
+        /**
+         * Limits a channel to framesPerSecond frames; 0, the default, sends
+         * every frame.  Set the rates before the output thread is started.
+         */
+        void setUdpEndpointFrameRate( int i, int framesPerSecond );
+        int getUdpEndpointFrameRate( int i );
+        void setFlashXmlFrameRate( int framesPerSecond );
+        int getFlashXmlFrameRate();
+
+        /**
+         * Sets the TUIO version a UDP endpoint is sent; TUIO_1_1 by default.
+         */
+        void setUdpEndpointProfile( int i, Profile profile );
+        Profile getUdpEndpointProfile( int i );
+
+        /**
+         * The sensor size in pixels, sent in every /tuio2/frm message.  Each
+         * must be below 65536; 0 by 0, the default, means unknown.
+         */
+        void setSourceDimensions( int width, int height );
+
+        /**
+         * For the endpoint count, host names and per-endpoint send statistics.
+         */
+        const UdpFanOutSender * getUdpSender() const { return udpSender_; }
+
+        /**
+         * Adds another OscSender (e.g. a TcpSender) that gets every TUIO
+         * bundle, as for TuioServer::addOscSender().  The sender is not
+         * deleted by the TuioCursorServer.
+         *
+         * @param  framesPerSecond  the frame rate limit; 0 sends every frame.
+         * @param  profile  the TUIO version the sender is sent.
+         */
+        void addOscSender( OscSender * sender, int framesPerSecond = 0, Profile profile = TUIO_1_1 );
+
+        /**
+         * @return the session time, in milliseconds, at which
+         *         sendHeldFrames() should next be called, or -1 if no
+         *         channel has changes held back.
+         */
+        long nextHeldFrameTime();
+
+        /**
+         * Sends the changes held back for every rate limited channel whose
+         * next tick has come by now.
+         */
+        void sendHeldFrames( TuioTime now );
+
+        void useFirstUdpSender( bool b ) { useUdpEndpoint( FIRST_UDP_ENDPOINT, b ); }
+        bool useFirstUdpSender() { return useUdpEndpoint( FIRST_UDP_ENDPOINT ); }
 
-        void useSecondUdpSender( bool b ) { useSecondUdpSender_ = b; }
-        bool useSecondUdpSender() { return useSecondUdpSender_; }
+        void useSecondUdpSender( bool b ) { useUdpEndpoint( SECOND_UDP_ENDPOINT, b ); }
+        bool useSecondUdpSender() { return useUdpEndpoint( SECOND_UDP_ENDPOINT ); }
 
         void useFlashXmlTcpSender( bool b ) { useFlashXmlTcpSender_ = b; }
         bool useFlashXmlTcpSender() { return useFlashXmlTcpSender_; }
 
-        bool isFirstUdpSenderRunning();
-        bool isSecondUdpSenderRunning();
+        bool isFirstUdpSenderRunning() { return isUdpEndpointRunning( FIRST_UDP_ENDPOINT ); }
+        bool isSecondUdpSenderRunning() { return isUdpEndpointRunning( SECOND_UDP_ENDPOINT ); }
         bool isFlashXmlTcpSenderRunning();
+
+        /**
+         * The Flash XML server, for its per-client lag and dropped frame counts.
+         */
+        FlashXmlTcpServer * getFlashXmlTcpSender() { return flashXmlTcpSender_; }
+
+        /**
+         * The Flash XML encoder, which holds the last frame encoded.
+         */
+        const FlashXmlEncoder * getFlashXmlEncoder() const { return flashXmlEncoder_; }
+
+        /**
+         * Off (MotionPredictor::NONE) by default.  Set it up before the
+         * output thread is started; its stats can be taken from any thread.
+         */
+        MotionPredictor & getMotionPredictor() { return motionPredictor_; }
+
+        /**
+         * Publishes every frame to the writer's shared memory, or stops if
+         * writer is NULL.  The writer is not deleted by the TuioCursorServer.
+         */
+        void setCursorSnapshotWriter( CursorSnapshotWriter * writer ) { snapshotWriter_ = writer; }
+        CursorSnapshotWriter * getCursorSnapshotWriter() { return snapshotWriter_; }
         
     private:
+        struct ChannelRate
+        {
+            long interval;          // microseconds between frames, 0 to send every frame
+            TuioTime sentFrame,     // the time of the last frame sent
+                     sentTime;      // the tick it was sent for
+            bool held,              // changes are waiting for the next tick
+                 sending;           // the bundle being sent goes to this channel
+        };
+
+        // A cursor removed in this frame with a move a limited channel has not had.
+        struct RemovedCursor
+        {
+            long sessionId;
+            int typeId;
+            float x, y,
+                  xSpeed, ySpeed,
+                  motionAccel;
+            TuioTime changed;
+        };
+
+        static ChannelRate channelRate( int framesPerSecond );
+        static int framesPerSecond( const ChannelRate & rate );
+        bool isDue( const ChannelRate & rate, TuioTime now );
+        void markSent( ChannelRate & rate, TuioTime now );
+        bool changedSince( TuioCursor * tcur, TuioTime since );
+        void predictCursors();
+        void publishCursorSnapshot();
+        void cursorPosition( TuioCursor * tcur, float & x, float & y );
+        void removingTuioCursor( TuioCursor * tcur, int typeId );
+        bool heldSince( TuioTime changed );
+        bool removedSince( const RemovedCursor & removed, TuioTime since );
+
         void initialize();
-        std::string int2Str( int n );
+        void allocateUdpPacket();
+        bool anyOscSenderEnabled();
+        bool selectProfile( Profile profile );
 
         void sendEmptyUdpCursorBundle();
         void deliverOscUdpPacket( osc::OutboundPacketStream  * packet );
+        bool fullFrameRequested();
         void sendEmptyFlashXmlTcpCursorBundle();
 
+        void selectAllOscChannels();
         void processTuioUdpMessages();
-        void startUdpCursorBundle();
-        void addUdpCursorMessage( TuioCursor * tcur );
+        void sendOscFrames( bool heldOnly, TuioTime now );
+        void sendOscFrame( TuioTime since );
+        void startUdpCursorBundle( TuioTime since );
+        void addUdpCursorMessage( TuioCursor * tcur, int typeId );
+        void addUdpCursorMessage( long sessionId, int typeId, float x, float y, float xSpeed, float ySpeed, float motionAccel );
+        void addUpdatedUdpCursorMessage( TuioCursor * tcur, int typeId, bool updatedOnly, TuioTime since );
         void sendUdpCursorBundle( long fseq );
+        void addTuio2FrameMessage();
 
         void processFlashXmlTcpMessages();
-        void addFlashXml2DcurProfile( std::string & blobMessage, TuioCursor * tcur );
+        void sendFlashXmlFrame( TuioTime now );
+        void addFlashXmlSetMessage( TuioCursor * tcur, bool allCursors, TuioTime since );
+        void addFlashXmlSetMessage( long sessionId, float x, float y, float xSpeed, float ySpeed, float motionAccel );
+        void sendFlashXmlPacket();
 
-        UdpSender * firstUdpSender_,
-                  * secondUdpSender_;
+        UdpFanOutSender * udpSender_;
+        std::vector<OscSender *> oscSenders_;
+        std::vector<ChannelRate> udpEndpointRates_,    // indexed like the endpoints
+                                 oscSenderRates_;      // and like oscSenders_
+        std::vector<Profile> udpEndpointProfiles_,     // the same
+                             oscSenderProfiles_;
+        Profile bundleProfile_;                        // of the bundle being built
+        ChannelRate flashXmlRate_;
+        std::vector<RemovedCursor> removedCursors_;    // with a move held back
         FlashXmlTcpServer * flashXmlTcpSender_;
-        bool useFirstUdpSender_,
-             useSecondUdpSender_,
-             useFlashXmlTcpSender_;
-        std::string flashXmlTcpPortStr_;
+        FlashXmlEncoder * flashXmlEncoder_;
+        bool useFlashXmlTcpSender_;
 
         char * oscUdpBuffer_; 
         osc::OutboundPacketStream  * oscUdpPacket_;
@@ -233,6 +424,9 @@ namespace TUIO
              periodicUpdate_;
         TuioTime cursorUpdateTime_;	
         char * sourceName_;
+        osc::int32 sourceDimensions_;   // width << 16 | height
+        MotionPredictor motionPredictor_;
+        CursorSnapshotWriter * snapshotWriter_;
     };
 }
 #endif /* INCLUDED_TuioCursorServer_H */
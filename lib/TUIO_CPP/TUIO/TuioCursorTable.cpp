@@ -0,0 +1,151 @@
+/*******************************************************************************
+TuioCursorTable
+
+PURPOSE: Holds the active TuioCursors of a TuioCursorManager.  See the header
+         file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "TuioCursorTable.h"
+#include <new>
+
+using namespace TUIO;
+
+TuioCursorTable::TuioCursorTable() :
+  pool_( new CursorStorage[CAPACITY] ),
+  size_( 0 )
+{
+    for( int i = 0; i < SLOT_COUNT; ++i ) {
+        slots_[i].uniqueId = 0;
+        slots_[i].index = EMPTY_SLOT;
+    }
+    for( int i = 0; i < CAPACITY; ++i ) {
+        active_[i] = 0;
+        activePosition_[i] = -1;
+        uniqueIds_[i] = 0;
+        typeIds_[i] = 0;
+    }
+    for( int i = 0; i < CAPACITY / 32; ++i ) {
+        freeMask_[i] = 0xFFFFFFFFu;
+    }
+}
+
+TuioCursorTable::~TuioCursorTable()
+{
+    clear();
+    delete [] pool_;
+}
+
+TuioCursor * TuioCursorTable::add( unsigned int uniqueId, TuioTime ttime, long sessionId, float xp, float yp,
+                                   int typeId )
+{
+    if( size_ == CAPACITY || findSlot( uniqueId ) != EMPTY_SLOT ) {
+        return 0;
+    }
+    int index = takeLowestFreeIndex();
+    TuioCursor * tcur = new (&pool_[index]) TuioCursor( ttime, sessionId, index, xp, yp );
+
+    unsigned int slot = hash( uniqueId ) & SLOT_MASK;
+
+    while( slots_[slot].index != EMPTY_SLOT ) {
+        slot = (slot + 1) & SLOT_MASK;
+    }
+    slots_[slot].uniqueId = uniqueId;
+    slots_[slot].index = index;
+
+    uniqueIds_[index] = uniqueId;
+    typeIds_[index] = typeId;
+    activePosition_[index] = size_;
+    active_[size_++] = tcur;
+    return tcur;
+}
+
+TuioCursor * TuioCursorTable::find( unsigned int uniqueId ) const
+{
+    int slot = findSlot( uniqueId );
+    return slot == EMPTY_SLOT ? 0 : reinterpret_cast<TuioCursor *>( &pool_[slots_[slot].index] );
+}
+
+/**
+ * Returns the hash slot holding the given id, or EMPTY_SLOT.
+ */
+int TuioCursorTable::findSlot( unsigned int uniqueId ) const
+{
+    unsigned int slot = hash( uniqueId ) & SLOT_MASK;
+
+    while( slots_[slot].index != EMPTY_SLOT ) {
+        if( slots_[slot].uniqueId == uniqueId ) {
+            return (int)slot;
+        }
+        slot = (slot + 1) & SLOT_MASK;
+    }
+    return EMPTY_SLOT;
+}
+
+bool TuioCursorTable::remove( unsigned int uniqueId )
+{
+    int found = findSlot( uniqueId );
+
+    if( found == EMPTY_SLOT ) {
+        return false;
+    }
+    int index = slots_[found].index;
+
+    // Pull later entries of the probe run back, so lookups never need tombstones.
+    unsigned int hole = (unsigned int)found,
+                 next = (hole + 1) & SLOT_MASK;
+
+    while( slots_[next].index != EMPTY_SLOT ) {
+        unsigned int home = hash( slots_[next].uniqueId ) & SLOT_MASK;
+
+        if( ((next - home) & SLOT_MASK) >= ((next - hole) & SLOT_MASK) ) {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+        next = (next + 1) & SLOT_MASK;
+    }
+    slots_[hole].index = EMPTY_SLOT;
+
+    // Keep active_ packed by moving the last cursor into the gap.
+    int position = activePosition_[index];
+    TuioCursor * last = active_[--size_];
+    active_[position] = last;
+    activePosition_[last->getCursorID()] = position;
+    active_[size_] = 0;
+    activePosition_[index] = -1;
+
+    reinterpret_cast<TuioCursor *>( &pool_[index] )->~TuioCursor();
+    freeIndex( index );
+    return true;
+}
+
+void TuioCursorTable::clear()
+{
+    while( size_ > 0 ) {
+        remove( uniqueIds_[active_[size_ - 1]->getCursorID()] );
+    }
+}
+
+int TuioCursorTable::takeLowestFreeIndex()
+{
+    for( int word = 0; word < CAPACITY / 32; ++word ) {
+        unsigned int bits = freeMask_[word];
+
+        if( bits != 0 ) {
+            int bit = 0;
+
+            while( (bits & 1u) == 0 ) {
+                bits >>= 1;
+                ++bit;
+            }
+            freeMask_[word] &= ~(1u << bit);
+            return word * 32 + bit;
+        }
+    }
+    return -1;
+}
+
+void TuioCursorTable::freeIndex( int index )
+{
+    freeMask_[index / 32] |= 1u << (index % 32);
+}
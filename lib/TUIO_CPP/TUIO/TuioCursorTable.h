@@ -0,0 +1,128 @@
+/*******************************************************************************
+TuioCursorTable
+
+PURPOSE: Holds the active TuioCursors of a TuioCursorManager, keyed by the
+         caller's own id for each contact (the Windows pointer id in
+         TouchHooks2Tuio).
+
+NOTES:
+The TuioCursors live in one pool that is allocated when the table is made,
+so adding and removing a contact never allocates a TuioCursor.  A pool
+slot's index is also the TUIO cursor ID of the cursor in it, and a new
+cursor always takes the lowest free slot, which is how TUIO expects cursor
+IDs to be reused.
+
+Lookups go through an open-addressing hash table (linear probing, with
+backward-shift deletion so there are no tombstones) that is twice the size
+of the pool.  The active cursors are also kept packed in one array, so a
+frame can be encoded by walking CAPACITY pointers at most.  Removing a
+cursor moves the last one into its place, so that order is not stable.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_TUIOCURSORTABLE_H
+#define INCLUDED_TUIOCURSORTABLE_H
+
+#include "TuioCursor.h"
+#include <type_traits>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * TuioCursorTable table;<br/>
+     * TuioCursor * tcur = table.add( pointerId, frameTime, sessionId, xpos, ypos );<br/>
+     * ...<br/>
+     * tcur = table.find( pointerId );<br/>
+     * ...<br/>
+     * for( unsigned int i = 0; i < table.size(); ++i ) { table.at( i ); ... }<br/>
+     * ...<br/>
+     * table.remove( pointerId );<br/>
+     * </code></p>
+     */
+    class LIBDECL TuioCursorTable
+    {
+    public:
+        enum { CAPACITY = 256,
+               SLOT_COUNT = 2 * CAPACITY, // must be a power of two
+               SLOT_MASK = SLOT_COUNT - 1,
+               EMPTY_SLOT = -1 };
+
+        TuioCursorTable();
+        ~TuioCursorTable();
+
+        /**
+         * Makes a new TuioCursor for the given id in the lowest free pool slot.
+         * The TUIO 2.0 type id is kept alongside (see typeIdOf()).
+         *
+         * @return the new TuioCursor, or 0 if the id is already in the table
+         *         or all CAPACITY cursors are in use.
+         */
+        TuioCursor * add( unsigned int uniqueId, TuioTime ttime, long sessionId, float xp, float yp,
+                          int typeId = 0 );
+
+        /**
+         * @return the TuioCursor for the given id, or 0.
+         */
+        TuioCursor * find( unsigned int uniqueId ) const;
+
+        /**
+         * Destroys the TuioCursor for the given id and frees its pool slot.
+         *
+         * @return false if the id was not in the table.
+         */
+        bool remove( unsigned int uniqueId );
+
+        /**
+         * Destroys every TuioCursor in the table.
+         */
+        void clear();
+
+        /**
+         * Returns the id the given cursor from this table was added with.
+         */
+        unsigned int uniqueIdOf( const TuioCursor * tcur ) const { return uniqueIds_[tcur->getCursorID()]; }
+
+        /**
+         * Returns the type id the given cursor from this table was added with.
+         */
+        int typeIdOf( const TuioCursor * tcur ) const { return typeIds_[tcur->getCursorID()]; }
+
+        unsigned int size() const { return size_; }
+        bool full() const { return size_ == CAPACITY; }
+
+        /**
+         * Returns the i-th active cursor, for 0 <= i < size().
+         */
+        TuioCursor * at( unsigned int i ) const { return active_[i]; }
+
+    private:
+        TuioCursorTable( const TuioCursorTable & );
+        TuioCursorTable & operator=( const TuioCursorTable & );
+
+        typedef std::aligned_storage<sizeof( TuioCursor ),
+                                     std::alignment_of<TuioCursor>::value>::type CursorStorage;
+
+        static unsigned int hash( unsigned int uniqueId ) { return (uniqueId * 2654435761u) >> 16; }
+        int findSlot( unsigned int uniqueId ) const;
+        int takeLowestFreeIndex();
+        void freeIndex( int index );
+
+        struct Slot
+        {
+            unsigned int uniqueId;
+            int index; // pool index, or EMPTY_SLOT
+        };
+
+        CursorStorage * pool_;
+        Slot slots_[SLOT_COUNT];
+        TuioCursor * active_[CAPACITY];
+        int activePosition_[CAPACITY];   // pool index -> position in active_
+        unsigned int uniqueIds_[CAPACITY]; // pool index -> caller's id
+        int typeIds_[CAPACITY];            // pool index -> TUIO 2.0 type id
+        unsigned int freeMask_[CAPACITY / 32];
+        unsigned int size_;
+    };
+}
+
+#endif /* INCLUDED_TUIOCURSORTABLE_H */
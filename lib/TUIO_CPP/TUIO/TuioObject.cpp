@@ -66,7 +66,7 @@ void TuioObject::update (TuioTime ttime, float xp, float yp, float a) {
 	TuioContainer::update(ttime,xp,yp);
 	
 	TuioTime diffTime = currentTime - lastPoint.getTuioTime();
-	float dt = diffTime.getTotalMilliseconds()/1000.0f;
+	float dt = diffTime.getTotalMicroseconds()/(float)USEC_SECOND;
 	float last_angle = angle;
 	float last_rotation_speed = rotation_speed;
 	angle = a;
@@ -75,8 +75,10 @@ void TuioObject::update (TuioTime ttime, float xp, float yp, float a) {
 	if (da > 0.75f) da-=1.0f;
 	else if (da < -0.75f) da+=1.0f;
 	
-	rotation_speed = (float)da/dt;
-	rotation_accel =  (rotation_speed - last_rotation_speed)/dt;
+	if (dt>0) {
+		rotation_speed = (float)da/dt;
+		rotation_accel =  (rotation_speed - last_rotation_speed)/dt;
+	}
 	
 	if ((rotation_accel!=0) && (state==TUIO_STOPPED)) state = TUIO_ROTATING;
 }
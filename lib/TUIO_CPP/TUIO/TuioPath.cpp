@@ -0,0 +1,91 @@
+/*******************************************************************************
+TuioPath
+
+PURPOSE: The recent positions of a TuioContainer, kept in a fixed-size ring.
+         See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "TuioPath.h"
+
+using namespace TUIO;
+
+unsigned int TuioPath::defaultDepth_ = TuioPath::DEFAULT_DEPTH;
+
+TuioPath::TuioPath( const TuioPoint & first ) :
+  last_( first ),
+  points_(),
+  depth_( defaultDepth_ ),
+  start_( 0 ),
+  size_( defaultDepth_ > 0 ? 1 : 0 )
+{
+}
+
+/**
+ * A path holding a single point keeps it in last_ only, so a cursor that is
+ * never updated, or whose depth is set to 0 right away, never allocates.
+ */
+void TuioPath::push( const TuioPoint & point )
+{
+    if( depth_ > 0 ) {
+        if( points_.empty() ) {
+            points_.assign( depth_, last_ );
+            start_ = 0;
+        }
+        if( size_ < depth_ ) {
+            unsigned int index = start_ + size_;
+            points_[index < depth_ ? index : index - depth_] = point;
+            ++size_;
+        }
+        else {
+            points_[start_] = point;
+            start_ = start_ + 1 < depth_ ? start_ + 1 : 0;
+        }
+    }
+    last_ = point;
+}
+
+void TuioPath::replaceLast( const TuioPoint & point )
+{
+    if( !points_.empty() && size_ > 0 ) {
+        unsigned int index = start_ + size_ - 1;
+        points_[index < depth_ ? index : index - depth_] = point;
+    }
+    last_ = point;
+}
+
+void TuioPath::setDepth( unsigned int depth )
+{
+    if( depth == depth_ ) {
+        return;
+    }
+    unsigned int kept = size_ < depth ? size_ : depth;
+    std::vector<TuioPoint> points;
+
+    if( !points_.empty() && kept > 0 ) {
+        points.assign( depth, last_ );
+
+        for( unsigned int i = 0; i < kept; ++i ) {
+            points[i] = (*this)[size_ - kept + i];
+        }
+    }
+    points_.swap( points );
+    depth_ = depth;
+    start_ = 0;
+    size_ = kept > 0 ? kept : (depth > 0 ? 1 : 0);
+}
+
+std::list<TuioPoint> TuioPath::toList() const
+{
+    return std::list<TuioPoint>( begin(), end() );
+}
+
+void TuioPath::setDefaultDepth( unsigned int depth )
+{
+    defaultDepth_ = depth;
+}
+
+unsigned int TuioPath::getDefaultDepth()
+{
+    return defaultDepth_;
+}
@@ -0,0 +1,138 @@
+/*******************************************************************************
+TuioPath
+
+PURPOSE: The recent positions of a TuioContainer, kept in a fixed-size ring
+         instead of a list that grows on every update.
+
+NOTES:
+The depth is the number of points kept, newest included.  The ring is
+allocated once, on the first update that needs it, and never grows after
+that; the oldest point is overwritten instead.  A depth of 0 keeps no
+history at all, which is what a server that never draws its cursors wants.
+The newest point is always available from back(), whatever the depth, since
+TuioContainer needs it to work out speed and acceleration.
+
+Points are read in place through operator[] or a const_iterator, oldest
+first, so drawing a path does not copy it.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_TUIOPATH_H
+#define INCLUDED_TUIOPATH_H
+
+#include "TuioPoint.h"
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <vector>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * const TuioPath & path = tcur->getTuioPath();<br/>
+     * for( TuioPath::const_iterator point = path.begin(); point != path.end(); ++point ) {<br/>
+     * &nbsp;&nbsp;&nbsp;&nbsp;point->getX(); ...<br/>
+     * }<br/>
+     * </code></p>
+     */
+    class LIBDECL TuioPath
+    {
+    public:
+        enum { DEFAULT_DEPTH = 128 };
+
+        class const_iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef TuioPoint value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const TuioPoint * pointer;
+            typedef const TuioPoint & reference;
+
+            const_iterator( const TuioPath * path, unsigned int i ) : path_( path ), i_( i ) {}
+
+            const TuioPoint & operator*() const { return (*path_)[i_]; }
+            const TuioPoint * operator->() const { return &(*path_)[i_]; }
+            const_iterator & operator++() { ++i_; return *this; }
+            const_iterator operator++( int ) { const_iterator old = *this; ++i_; return old; }
+            bool operator==( const const_iterator & other ) const { return i_ == other.i_ && path_ == other.path_; }
+            bool operator!=( const const_iterator & other ) const { return !(*this == other); }
+
+        private:
+            const TuioPath * path_;
+            unsigned int i_;
+        };
+
+        /**
+         * Starts a path at the given point, with the default depth.
+         */
+        explicit TuioPath( const TuioPoint & first );
+
+        /**
+         * Adds the newest point, dropping the oldest one if the ring is full.
+         */
+        void push( const TuioPoint & point );
+
+        /**
+         * Replaces the newest point.
+         */
+        void replaceLast( const TuioPoint & point );
+
+        /**
+         * Returns the newest point, even when the depth is 0.
+         */
+        const TuioPoint & back() const { return last_; }
+
+        /**
+         * Returns the oldest point kept.  The path must not be empty.
+         */
+        const TuioPoint & front() const { return (*this)[0]; }
+
+        /**
+         * Returns the i-th point kept, oldest first, for 0 <= i < size().
+         */
+        const TuioPoint & operator[]( unsigned int i ) const
+        {
+            if( points_.empty() ) {
+                return last_;
+            }
+            unsigned int index = start_ + i;
+            return points_[index < depth_ ? index : index - depth_];
+        }
+
+        unsigned int size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const_iterator begin() const { return const_iterator( this, 0 ); }
+        const_iterator end() const { return const_iterator( this, size_ ); }
+
+        /**
+         * Changes the number of points kept.  The newest points are kept if
+         * the path gets shorter.
+         */
+        void setDepth( unsigned int depth );
+        unsigned int getDepth() const { return depth_; }
+
+        /**
+         * Returns a copy of the points kept, oldest first.
+         */
+        std::list<TuioPoint> toList() const;
+
+        /**
+         * Sets the depth of paths created from now on.
+         */
+        static void setDefaultDepth( unsigned int depth );
+        static unsigned int getDefaultDepth();
+
+    private:
+        static unsigned int defaultDepth_;
+
+        TuioPoint last_;
+        std::vector<TuioPoint> points_; // empty until there are two points to keep
+        unsigned int depth_,
+                     start_,
+                     size_;
+    };
+}
+
+#endif /* INCLUDED_TUIOPATH_H */
@@ -21,10 +21,22 @@
 
 #include "TuioServer.h"
 #include "UdpSender.h"
+#include "osc/OscFixedMessage.h"
 
 using namespace TUIO;
 using namespace osc;
 
+// The alive, set and fseq messages of each profile, laid out once.
+static const Int32ListMessageTemplate cursorAliveMessage( "/tuio/2Dcur", "alive" ),
+                                      objectAliveMessage( "/tuio/2Dobj", "alive" ),
+                                      blobAliveMessage( "/tuio/2Dblb", "alive" );
+static const FixedMessageTemplate<1,5> cursorSetMessage( "/tuio/2Dcur", "set" );
+static const FixedMessageTemplate<2,8> objectSetMessage( "/tuio/2Dobj", "set" );
+static const FixedMessageTemplate<1,11> blobSetMessage( "/tuio/2Dblb", "set" );
+static const FixedMessageTemplate<1,0> cursorFseqMessage( "/tuio/2Dcur", "fseq" ),
+                                       objectFseqMessage( "/tuio/2Dobj", "fseq" ),
+                                       blobFseqMessage( "/tuio/2Dblb", "fseq" );
+
 TuioServer::TuioServer() 
     :local_sender			(true)
     ,full_update			(false)	
@@ -300,11 +312,10 @@ void TuioServer::startCursorBundle() {
     oscPacket->Clear();	
     (*oscPacket) << osc::BeginBundleImmediate;
     if (source_name) (*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "source" << source_name << osc::EndMessage;
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "alive";
-    for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++) {
-        (*oscPacket) << (int32)((*tuioCursor)->getSessionID());	
+    char *alive = cursorAliveMessage.Write(*oscPacket, cursorList.size());
+    for (std::list<TuioCursor*>::iterator tuioCursor = cursorList.begin(); tuioCursor!=cursorList.end(); tuioCursor++, alive+=4) {
+        FixedMessageStoreUInt32(alive, (uint32)((*tuioCursor)->getSessionID()));
     }
-    (*oscPacket) << osc::EndMessage;	
 }
 
 void TuioServer::addCursorMessage(TuioCursor *tcur) {
@@ -322,14 +333,14 @@ void TuioServer::addCursorMessage(TuioCursor *tcur) {
         yvel = -1 * yvel;
     }
 
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "set";
-    (*oscPacket) << (int32)(tcur->getSessionID()) << xpos << ypos;
-    (*oscPacket) << xvel << yvel << tcur->getMotionAccel();	
-    (*oscPacket) << osc::EndMessage;
+    int32 s_id = (int32)(tcur->getSessionID());
+    float values[5] = { xpos, ypos, xvel, yvel, tcur->getMotionAccel() };
+    cursorSetMessage.Write(*oscPacket, &s_id, values);
 }
 
 void TuioServer::sendCursorBundle(long fseq) {
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dcur") << "fseq" << (int32)fseq << osc::EndMessage;
+    int32 frame = (int32)fseq;
+    cursorFseqMessage.Write(*oscPacket, &frame, NULL);
     (*oscPacket) << osc::EndBundle;
     deliverOscPacket( oscPacket );
 }
@@ -348,11 +359,10 @@ void TuioServer::startObjectBundle() {
     oscPacket->Clear();	
     (*oscPacket) << osc::BeginBundleImmediate;
     if (source_name) (*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "source" << source_name << osc::EndMessage;
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "alive";
-    for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++) {
-        (*oscPacket) << (int32)((*tuioObject)->getSessionID());	
+    char *alive = objectAliveMessage.Write(*oscPacket, objectList.size());
+    for (std::list<TuioObject*>::iterator tuioObject = objectList.begin(); tuioObject!=objectList.end(); tuioObject++, alive+=4) {
+        FixedMessageStoreUInt32(alive, (uint32)((*tuioObject)->getSessionID()));
     }
-    (*oscPacket) << osc::EndMessage;
 }
 
 void TuioServer::addObjectMessage(TuioObject *tobj) {
@@ -376,14 +386,14 @@ void TuioServer::addObjectMessage(TuioObject *tobj) {
         rvel = -1 * rvel;
     }
     
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "set";
-    (*oscPacket) << (int32)(tobj->getSessionID()) << tobj->getSymbolID() << xpos << ypos << angle;
-    (*oscPacket) << xvel << yvel << rvel << tobj->getMotionAccel() << tobj->getRotationAccel();	
-    (*oscPacket) << osc::EndMessage;
+    int32 ids[2] = { (int32)(tobj->getSessionID()), (int32)tobj->getSymbolID() };
+    float values[8] = { xpos, ypos, angle, xvel, yvel, rvel, tobj->getMotionAccel(), tobj->getRotationAccel() };
+    objectSetMessage.Write(*oscPacket, ids, values);
 }
 
 void TuioServer::sendObjectBundle(long fseq) {
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dobj") << "fseq" << (int32)fseq << osc::EndMessage;
+    int32 frame = (int32)fseq;
+    objectFseqMessage.Write(*oscPacket, &frame, NULL);
     (*oscPacket) << osc::EndBundle;
     deliverOscPacket( oscPacket );
 }
@@ -403,11 +413,10 @@ void TuioServer::startBlobBundle() {
     oscPacket->Clear();	
     (*oscPacket) << osc::BeginBundleImmediate;
     if (source_name) (*oscPacket) << osc::BeginMessage( "/tuio/2Dblb") << "source" << source_name << osc::EndMessage;
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dblb") << "alive";
-    for (std::list<TuioBlob*>::iterator tuioBlob = blobList.begin(); tuioBlob!=blobList.end(); tuioBlob++) {
-        (*oscPacket) << (int32)((*tuioBlob)->getSessionID());	
+    char *alive = blobAliveMessage.Write(*oscPacket, blobList.size());
+    for (std::list<TuioBlob*>::iterator tuioBlob = blobList.begin(); tuioBlob!=blobList.end(); tuioBlob++, alive+=4) {
+        FixedMessageStoreUInt32(alive, (uint32)((*tuioBlob)->getSessionID()));
     }
-    (*oscPacket) << osc::EndMessage;	
 }
 
 void TuioServer::addBlobMessage(TuioBlob *tblb) {
@@ -431,14 +440,14 @@ void TuioServer::addBlobMessage(TuioBlob *tblb) {
         rvel = -1 * rvel;
     }
     
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dblb") << "set";
-    (*oscPacket) << (int32)(tblb->getSessionID()) << xpos << ypos << angle << tblb->getWidth() << tblb->getHeight() << tblb->getArea();
-    (*oscPacket) << xvel << yvel  << rvel << tblb->getMotionAccel()  << tblb->getRotationAccel();	
-    (*oscPacket) << osc::EndMessage;
+    int32 s_id = (int32)(tblb->getSessionID());
+    float values[11] = { xpos, ypos, angle, tblb->getWidth(), tblb->getHeight(), tblb->getArea(), xvel, yvel, rvel, tblb->getMotionAccel(), tblb->getRotationAccel() };
+    blobSetMessage.Write(*oscPacket, &s_id, values);
 }
 
 void TuioServer::sendBlobBundle(long fseq) {
-    (*oscPacket) << osc::BeginMessage( "/tuio/2Dblb") << "fseq" << (int32)fseq << osc::EndMessage;
+    int32 frame = (int32)fseq;
+    blobFseqMessage.Write(*oscPacket, &frame, NULL);
     (*oscPacket) << osc::EndBundle;
 
     deliverOscPacket( oscPacket );
@@ -0,0 +1,195 @@
+/*******************************************************************************
+TuioSessionIndex
+
+PURPOSE: Finds the TuioObjects, TuioCursors or TuioBlobs a TuioClient keeps
+         by source and session ID in constant time, and tells which of them
+         the last alive message left out.
+
+NOTES:
+TuioClient keeps each kind of entity in a std::list (the TuioDispatcher
+API hands out copies of those lists), which made every set message and every
+removal a linear search, and the alive check at fseq a std::find over the
+alive list for each entity: O(n^2) per frame.  The index maps the source and
+session ID to the entity's position in its list, so lookups and erasing are
+O(1).
+
+The alive set is not kept as a list.  Each alive message starts a new
+generation and stamps every entity it names that the index knows; at fseq an
+entity of the source is gone if it does not carry the current stamp.  That
+is O(n) per frame.  Entities added at fseq are stamped as they go in, as
+the alive message that named them came before they were known.
+
+The index also counts, per source, the entities it holds and the IDs
+TuioClient keeps in its free list for reuse, which a new session needs to
+pick its ID: counting them by walking both lists made adding n sessions
+O(n^2).  TuioClient reports the free list changes (addFree(), removeFree()).
+
+Not locked: TuioClient holds the list's lock around every call.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_TUIOSESSIONINDEX_H
+#define INCLUDED_TUIOSESSIONINDEX_H
+
+#include <list>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * TuioSessionIndex<TuioCursor> index;<br/>
+     * cursorList.push_back( tcur );<br/>
+     * index.add( tcur, --cursorList.end() );<br/>
+     * ...<br/>
+     * TuioCursor * tcur = index.find( sourceId, sessionId );<br/>
+     * ...<br/>
+     * index.beginAlive();<br/>
+     * index.markAlive( sourceId, sessionId ); // for each alive ID<br/>
+     * ...<br/>
+     * if( !index.isAlive( tcur ) ) { ... }<br/>
+     * </code></p>
+     */
+    template <class T>
+    class TuioSessionIndex
+    {
+    public:
+        typedef typename std::list<T *>::iterator Position;
+
+        TuioSessionIndex() : generation_( 0 ) {}
+
+        /**
+         * The entity's source and session ID must not change while it is
+         * in the index.
+         */
+        void add( T * entity, Position position )
+        {
+            Entry entry;
+            entry.position = position;
+            entry.generation = generation_;
+            std::pair<typename Map::iterator, bool> added = entries_.insert(
+                typename Map::value_type( key( entity->getTuioSourceID(), entity->getSessionID() ), entry ) );
+
+            if( added.second ) {
+                ++counts_[entity->getTuioSourceID()].live;
+            }
+            else {
+                added.first->second = entry;
+            }
+        }
+
+        /**
+         * @return the entity, or NULL if the index does not know it.
+         */
+        T * find( int sourceId, long sessionId ) const
+        {
+            typename Map::const_iterator i = entries_.find( key( sourceId, sessionId ) );
+            return i != entries_.end() ? *i->second.position : NULL;
+        }
+
+        /**
+         * Takes the entity out of the index and gives its list position
+         * back, so the caller can erase it.
+         *
+         * @return false if the index did not know it.
+         */
+        bool remove( int sourceId, long sessionId, Position & position )
+        {
+            typename Map::iterator i = entries_.find( key( sourceId, sessionId ) );
+
+            if( i == entries_.end() ) {
+                return false;
+            }
+            position = i->second.position;
+            entries_.erase( i );
+            --counts_[sourceId].live;
+            return true;
+        }
+
+        /**
+         * @return the number of entities of the source in the index.
+         */
+        size_t liveCount( int sourceId ) const
+        {
+            typename CountMap::const_iterator i = counts_.find( sourceId );
+            return i != counts_.end() ? i->second.live : 0;
+        }
+
+        /**
+         * An ID of the source was put in the free list, or taken out of it.
+         */
+        void addFree( int sourceId ) { ++counts_[sourceId].free; }
+        void removeFree( int sourceId ) { --counts_[sourceId].free; }
+
+        /**
+         * @return the number of free IDs of the source.
+         */
+        size_t freeCount( int sourceId ) const
+        {
+            typename CountMap::const_iterator i = counts_.find( sourceId );
+            return i != counts_.end() ? i->second.free : 0;
+        }
+
+        void beginAlive() { ++generation_; }
+
+        void markAlive( int sourceId, long sessionId )
+        {
+            typename Map::iterator i = entries_.find( key( sourceId, sessionId ) );
+
+            if( i != entries_.end() ) {
+                i->second.generation = generation_;
+            }
+        }
+
+        /**
+         * @return true if the last alive message named the entity, or it
+         *         was added since.
+         */
+        bool isAlive( const T * entity ) const
+        {
+            typename Map::const_iterator i = entries_.find( key( entity->getTuioSourceID(), entity->getSessionID() ) );
+            return i != entries_.end() && i->second.generation == generation_;
+        }
+
+        /**
+         * Forgets the entities and the free IDs.
+         */
+        void clear()
+        {
+            entries_.clear();
+            counts_.clear();
+        }
+        size_t size() const { return entries_.size(); }
+
+    private:
+        struct Entry
+        {
+            Position position;
+            unsigned int generation;
+        };
+
+        struct Counts
+        {
+            Counts() : live( 0 ), free( 0 ) {}
+
+            size_t live,
+                   free;
+        };
+
+        typedef std::unordered_map<uint64_t, Entry> Map;
+        typedef std::unordered_map<int, Counts> CountMap;
+
+        static uint64_t key( int sourceId, long sessionId )
+        {
+            return ((uint64_t)(uint32_t)sourceId << 32) | (uint32_t)sessionId;
+        }
+
+        Map entries_;
+        CountMap counts_;
+        unsigned int generation_;
+    };
+}
+
+#endif /* INCLUDED_TUIOSESSIONINDEX_H */
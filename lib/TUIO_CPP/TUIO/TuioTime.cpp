@@ -24,6 +24,27 @@ using namespace TUIO;
 	
 long TuioTime::start_seconds = 0;
 long TuioTime::start_micro_seconds = 0;
+TuioTime::Clock TuioTime::clock = &TuioTime::getMonotonicTime;
+
+#ifdef WIN32
+// read on first use; it cannot change while the system is running
+static int64_t performanceFrequency = 0;
+#endif
+
+/**
+ * Splits the timestamp into whole seconds first, so that the multiplication cannot overflow.
+ */
+static TuioTime ticksToTime(int64_t ticks, int64_t ticksPerSecond) {
+	int64_t sec = ticks/ticksPerSecond;
+	int64_t usec = (ticks%ticksPerSecond)*USEC_SECOND/ticksPerSecond;
+	
+	if (usec<0) {
+		usec += USEC_SECOND;
+		sec--;
+	}
+	
+	return TuioTime((long)sec,(long)usec);
+}
 
 TuioTime::TuioTime (long msec) {
 	seconds = msec/MSEC_SECOND;
@@ -38,6 +59,8 @@ TuioTime::TuioTime (long sec, long usec) {
 TuioTime TuioTime::operator+(long us) {
 	long sec = seconds + us/USEC_SECOND;
 	long usec = micro_seconds + us%USEC_SECOND;
+	sec += usec/USEC_SECOND;
+	usec = usec%USEC_SECOND;
 	return TuioTime(sec,usec);
 }
 
@@ -105,6 +128,10 @@ long TuioTime::getTotalMilliseconds() const{
 	return seconds*MSEC_SECOND+micro_seconds/MSEC_SECOND;
 }
 
+int64_t TuioTime::getTotalMicroseconds() const{
+	return (int64_t)seconds*USEC_SECOND+micro_seconds;
+}
+
 void TuioTime::initSession() {
 	TuioTime startTime = TuioTime::getSystemTime();
 	start_seconds = startTime.getSeconds();
@@ -120,13 +147,31 @@ TuioTime TuioTime::getStartTime() {
 }
 
 TuioTime TuioTime::getSystemTime() {
+	return ticksToTime(clock(),NSEC_SECOND);
+}
+
+TuioTime TuioTime::getSessionTime(int64_t ticks, int64_t ticksPerSecond) {
+	return (ticksToTime(ticks,ticksPerSecond) - getStartTime());
+}
+
+void TuioTime::setClock(Clock clk) {
+	if (clk) clock = clk;
+	else clock = &TuioTime::getMonotonicTime;
+}
+
+int64_t TuioTime::getMonotonicTime() {
 #ifdef WIN32
-	TuioTime systemTime(GetTickCount());
+	LARGE_INTEGER counter;
+	if (performanceFrequency==0) {
+		QueryPerformanceFrequency(&counter);
+		performanceFrequency = counter.QuadPart;
+	}
+	QueryPerformanceCounter(&counter);
+	int64_t ticks = counter.QuadPart;
+	return ticks/performanceFrequency*NSEC_SECOND + (ticks%performanceFrequency)*NSEC_SECOND/performanceFrequency;
 #else
-	struct timeval tv;
-	struct timezone tz;
-	gettimeofday(&tv,&tz);
-	TuioTime systemTime(tv.tv_sec,tv.tv_usec);
-#endif	
-	return systemTime;
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (int64_t)ts.tv_sec*NSEC_SECOND + ts.tv_nsec;
+#endif
 }
@@ -23,10 +23,12 @@
 #define INCLUDED_TUIOTIME_H
 
 #include "LibExport.h"
+#include <stdint.h>
 
 #ifndef WIN32
 #include <pthread.h>
 #include <sys/time.h>
+#include <time.h>
 #else
 #include <windows.h>
 #include <ctime>
@@ -35,6 +37,7 @@
 #define MSEC_SECOND 1000
 #define USEC_SECOND 1000000
 #define USEC_MILLISECOND 1000
+#define NSEC_SECOND 1000000000
 
 namespace TUIO {
 	
@@ -44,17 +47,27 @@ namespace TUIO {
 	 * Therefore at the beginning of a typical TUIO session the static method initSession() will set the reference time for the session. 
 	 * Another important static method getSessionTime will return a TuioTime object representing the time elapsed since the session start.
 	 * The class also provides various addtional convience method, which allow some simple time arithmetics.
+	 * All times come from a monotonic clock with nanosecond units (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere),
+	 * so they never jump with the wall clock and are fine enough to tell apart input events a few microseconds apart.
+	 * A different clock can be set with setClock(), for instance to replay recorded input.
 	 *
 	 * @author Martin Kaltenbrunner
 	 * @version 1.5
 	 */ 
 	class LIBDECL TuioTime {
 		
+	public:
+		/**
+		 * A clock function returns the present time in nanoseconds since an arbitrary, fixed start.
+		 */
+		typedef int64_t (*Clock)();
+
 	private:
 		long seconds;
 		long micro_seconds;
 		static long start_seconds;
 		static long start_micro_seconds;
+		static Clock clock;
 		
 	public:
 
@@ -164,6 +177,12 @@ namespace TUIO {
 		 * @return the total TuioTime in Milliseconds
 		 */	
 		long getTotalMilliseconds() const;
+
+		/**
+		 * Returns the total TuioTime in Microseconds.
+		 * @return the total TuioTime in Microseconds
+		 */	
+		int64_t getTotalMicroseconds() const;
 		
 		/**
 		 * This static method globally resets the TUIO session time.
@@ -187,6 +206,27 @@ namespace TUIO {
 		 * @return the absolut TuioTime representing the current system time
 		 */	
 		static TuioTime getSystemTime();
+
+		/**
+		 * Converts a timestamp of the clock to the TuioTime since session start.
+		 * The timestamp may be given in any unit, QueryPerformanceCounter ticks for instance.
+		 * @param  ticks	the timestamp
+		 * @param  ticksPerSecond	the units per second of the timestamp
+		 * @return the TuioTime since session start the timestamp stands for
+		 */
+		static TuioTime getSessionTime(int64_t ticks, int64_t ticksPerSecond);
+
+		/**
+		 * Sets the clock that getSystemTime() reads.  The session start is not changed.
+		 * @param  clk	the clock function, or NULL for the monotonic clock
+		 */
+		static void setClock(Clock clk);
+
+		/**
+		 * The default clock: QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere.
+		 * @return the present monotonic time in nanoseconds
+		 */
+		static int64_t getMonotonicTime();
 	};
 }
 #endif /* INCLUDED_TUIOTIME_H */
@@ -0,0 +1,278 @@
+/*******************************************************************************
+UdpFanOutSender
+
+PURPOSE: Sends each OSC packet to a list of UDP endpoints from one socket.
+         See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "UdpFanOutSender.h"
+
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+
+#if defined( __linux__ ) && !defined( TUIO_NO_SENDMMSG )
+#define TUIO_USE_SENDMMSG
+#endif
+
+using namespace TUIO;
+
+#ifdef WIN32
+typedef SOCKET SocketHandle;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+static int lastSocketError() { return WSAGetLastError(); }
+static void closeSocket( SocketHandle s ) { closesocket( s ); }
+#else
+typedef int SocketHandle;
+static const SocketHandle NO_SOCKET = -1;
+static int lastSocketError() { return errno; }
+static void closeSocket( SocketHandle s ) { close( s ); }
+#endif
+
+/**
+ * The socket and the per-endpoint addresses and message headers, kept here
+ * so the header file does not need the platform's socket headers.
+ */
+class UdpFanOutSender::Implementation
+{
+public:
+    Implementation() :
+      socket_( ::socket( AF_INET, SOCK_DGRAM, 0 ) )
+    {
+        memset( addresses_, 0, sizeof( addresses_ ) );
+    }
+
+    ~Implementation()
+    {
+        if( socket_ != NO_SOCKET ) {
+            closeSocket( socket_ );
+        }
+    }
+
+    bool isOpen() const { return socket_ != NO_SOCKET; }
+
+    void setAddress( int i, unsigned long address, int port )
+    {
+        addresses_[i].sin_family = AF_INET;
+        addresses_[i].sin_addr.s_addr = htonl( address );
+        addresses_[i].sin_port = htons( (unsigned short)port );
+    }
+
+    /**
+     * Sends the packet to each of the given endpoints.  errors[k] is set to
+     * the error code for targets[k], or 0 if it was sent.
+     *
+     * @return  the number of system calls made.
+     */
+    int send( const char * data, int size, const int * targets, int count, int * errors )
+    {
+#ifdef TUIO_USE_SENDMMSG
+        struct iovec iov;
+        iov.iov_base = (void *)data;
+        iov.iov_len = (size_t)size;
+
+        for( int k = 0; k < count; ++k ) {
+            struct msghdr & header = messages_[k].msg_hdr;
+            memset( &messages_[k], 0, sizeof( messages_[k] ) );
+            header.msg_name = &addresses_[targets[k]];
+            header.msg_namelen = sizeof( addresses_[0] );
+            header.msg_iov = &iov;
+            header.msg_iovlen = 1;
+            errors[k] = 0;
+        }
+        int done = 0,
+            syscalls = 0;
+
+        while( done < count ) {
+            int sent = sendmmsg( socket_, messages_ + done, (unsigned int)(count - done), 0 );
+            ++syscalls;
+
+            if( sent > 0 ) {
+                done += sent;
+            }
+            else if( errno != EINTR ) {
+                errors[done++] = lastSocketError(); // skip the endpoint that failed
+            }
+        }
+        return syscalls;
+#else
+        for( int k = 0; k < count; ++k ) {
+            int sent = (int)sendto( socket_, data, size, 0,
+                                    (const struct sockaddr *)&addresses_[targets[k]],
+                                    sizeof( addresses_[0] ) );
+            errors[k] = sent < 0 ? lastSocketError() : 0;
+        }
+        return count;
+#endif
+    }
+
+private:
+    SocketHandle socket_;
+    struct sockaddr_in addresses_[MAX_ENDPOINTS];
+#ifdef TUIO_USE_SENDMMSG
+    struct mmsghdr messages_[MAX_ENDPOINTS];
+#endif
+};
+
+UdpFanOutSender::UdpFanOutSender() :
+  networkInitializer_(),
+  impl_( new Implementation() ),
+  endpointCount_( 0 ),
+  packets_( 0 ),
+  syscalls_( 0 )
+{
+    buffer_size = MAX_UDP_SIZE;
+    local = true;
+
+    if( !impl_->isOpen() ) {
+        std::cout << "could not create UDP socket" << std::endl;
+    }
+}
+
+UdpFanOutSender::~UdpFanOutSender()
+{
+    delete impl_;
+}
+
+int UdpFanOutSender::addEndpoint( const char * host, int port, bool enabled /*= true*/ )
+{
+    if( endpointCount_ >= MAX_ENDPOINTS ) {
+        return -1;
+    }
+    int i = endpointCount_++;
+    Endpoint & endpoint = endpoints_[i];
+    unsigned long address = GetHostByName( host );
+
+    endpoint.host = host;
+    endpoint.port = port;
+    endpoint.resolved = address != 0;
+    endpoint.enabled.store( enabled );
+    endpoint.packets.store( 0 );
+    endpoint.errors.store( 0 );
+    endpoint.lastError.store( 0 );
+
+    if( endpoint.resolved ) {
+        impl_->setAddress( i, address, port );
+    }
+    else {
+        std::cout << "could not resolve UDP host " << host << std::endl;
+    }
+    if( strcmp( host, "127.0.0.1" ) != 0 && strcmp( host, "localhost" ) != 0 ) {
+        local = false;
+        buffer_size = IP_MTU_SIZE;
+    }
+    return i;
+}
+
+void UdpFanOutSender::enableEndpoint( int i, bool enabled )
+{
+    if( i >= 0 && i < endpointCount_ ) {
+        endpoints_[i].enabled.store( enabled, std::memory_order_relaxed );
+    }
+}
+
+bool UdpFanOutSender::isEndpointEnabled( int i ) const
+{
+    return i >= 0 && i < endpointCount_ && endpoints_[i].enabled.load( std::memory_order_relaxed );
+}
+
+bool UdpFanOutSender::isEndpointConnected( int i ) const
+{
+    return i >= 0 && i < endpointCount_ && impl_->isOpen() && endpoints_[i].resolved;
+}
+
+unsigned long UdpFanOutSender::getEndpointPacketCount( int i ) const
+{
+    return endpoints_[i].packets.load( std::memory_order_relaxed );
+}
+
+unsigned long UdpFanOutSender::getEndpointErrorCount( int i ) const
+{
+    return endpoints_[i].errors.load( std::memory_order_relaxed );
+}
+
+int UdpFanOutSender::getEndpointLastError( int i ) const
+{
+    return endpoints_[i].lastError.load( std::memory_order_relaxed );
+}
+
+unsigned long UdpFanOutSender::getPacketCount() const
+{
+    return packets_.load( std::memory_order_relaxed );
+}
+
+unsigned long UdpFanOutSender::getSyscallCount() const
+{
+    return syscalls_.load( std::memory_order_relaxed );
+}
+
+bool UdpFanOutSender::usesBatchedSend()
+{
+#ifdef TUIO_USE_SENDMMSG
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool UdpFanOutSender::sendPacket( const char * data, int size )
+{
+    return sendPacket( data, size, ~0u );
+}
+
+bool UdpFanOutSender::sendPacket( const char * data, int size, unsigned int endpointMask )
+{
+    if( !impl_->isOpen() || size <= 0 || size > (int)buffer_size ) {
+        return false;
+    }
+    int targets[MAX_ENDPOINTS],
+        errors[MAX_ENDPOINTS],
+        count = 0;
+
+    for( int i = 0; i < endpointCount_; ++i ) {
+        if( (endpointMask & (1u << i)) != 0
+         && endpoints_[i].resolved && endpoints_[i].enabled.load( std::memory_order_relaxed ) ) {
+            targets[count++] = i;
+        }
+    }
+    if( count == 0 ) {
+        return false;
+    }
+    int syscalls = impl_->send( data, size, targets, count, errors );
+    bool sent = false;
+
+    for( int k = 0; k < count; ++k ) {
+        Endpoint & endpoint = endpoints_[targets[k]];
+
+        if( errors[k] == 0 ) {
+            endpoint.packets.fetch_add( 1, std::memory_order_relaxed );
+            sent = true;
+        }
+        else {
+            endpoint.errors.fetch_add( 1, std::memory_order_relaxed );
+            endpoint.lastError.store( errors[k], std::memory_order_relaxed );
+        }
+    }
+    packets_.fetch_add( 1, std::memory_order_relaxed );
+    syscalls_.fetch_add( (unsigned long)syscalls, std::memory_order_relaxed );
+    return sent;
+}
+
+bool UdpFanOutSender::sendOscPacket( osc::OutboundPacketStream * bundle )
+{
+    return sendPacket( bundle->Data(), (int)bundle->Size() );
+}
+
+bool UdpFanOutSender::isConnected()
+{
+    return impl_->isOpen();
+}
@@ -0,0 +1,153 @@
+/*******************************************************************************
+UdpFanOutSender
+
+PURPOSE: Sends each OSC packet to a list of UDP endpoints from one socket,
+         in as few system calls as the platform allows.
+
+NOTES:
+UdpSender opens one connected socket per destination, so a bundle sent to N
+consumers costs N send() calls.  Here the endpoints share one unconnected
+socket.  On Linux the packet is handed to the kernel once for all enabled
+endpoints with sendmmsg(); the message headers all point at the same packet
+data, so nothing is copied.  Elsewhere (Windows, macOS) it falls back to one
+sendto() per endpoint.
+
+If sendmmsg() stops at an endpoint that fails (e.g. the network for a remote
+host is down), the error is recorded against that endpoint and the rest of
+the list is sent with another call, so one bad endpoint never holds up the
+others.
+
+Endpoints are added before sending starts and are never removed; they can be
+enabled and disabled at any time from the sending thread.  The packet and
+error counts can be read from any thread.
+
+The largest packet sent is the smallest buffer size of the endpoints: 4096
+bytes if they are all on localhost, otherwise the 1500 byte MTU, as for
+UdpSender.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_UDPFANOUTSENDER_H
+#define INCLUDED_UDPFANOUTSENDER_H
+
+#include "UdpSender.h"
+#include <atomic>
+#include <string>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * UdpFanOutSender sender;<br/>
+     * sender.addEndpoint( "127.0.0.1", 3333 );<br/>
+     * sender.addEndpoint( "192.168.1.20", 3333 );<br/>
+     * ...<br/>
+     * sender.sendOscPacket( &packet );<br/>
+     * </code></p>
+     */
+    class LIBDECL UdpFanOutSender : public OscSender
+    {
+    public:
+        enum { MAX_ENDPOINTS = 16 };
+
+        /**
+         * Opens the socket.  isConnected() returns false if that failed.
+         */
+        UdpFanOutSender();
+
+        /**
+         * Closes the socket.
+         */
+        ~UdpFanOutSender();
+
+        /**
+         * Adds a destination.  A host that cannot be resolved is kept in the
+         * list (so the indices stay the same) but is never sent to.
+         *
+         * @return  the index of the new endpoint, or -1 if there are already
+         *          MAX_ENDPOINTS.
+         */
+        int addEndpoint( const char * host, int port, bool enabled = true );
+
+        int getEndpointCount() const { return endpointCount_; }
+        const std::string & getEndpointHost( int i ) const { return endpoints_[i].host; }
+        int getEndpointPort( int i ) const { return endpoints_[i].port; }
+
+        void enableEndpoint( int i, bool enabled );
+        bool isEndpointEnabled( int i ) const;
+
+        /**
+         * Returns true if the socket is open and the endpoint's host was resolved.
+         */
+        bool isEndpointConnected( int i ) const;
+
+        /**
+         * Packets sent to, and send errors for, one endpoint.
+         */
+        unsigned long getEndpointPacketCount( int i ) const;
+        unsigned long getEndpointErrorCount( int i ) const;
+
+        /**
+         * The errno (or WSAGetLastError) value of the endpoint's last failed
+         * send, or 0.
+         */
+        int getEndpointLastError( int i ) const;
+
+        /**
+         * Packets handed to sendPacket() and system calls made to send them.
+         */
+        unsigned long getPacketCount() const;
+        unsigned long getSyscallCount() const;
+
+        /**
+         * Returns true if all endpoints are sent to with one system call.
+         */
+        static bool usesBatchedSend();
+
+        /**
+         * Sends the packet to every enabled endpoint.
+         *
+         * @return  true if at least one endpoint was sent to without error.
+         */
+        bool sendPacket( const char * data, int size );
+
+        /**
+         * Sends the packet to the enabled endpoints whose bit (1 << index)
+         * is set in the mask.
+         */
+        bool sendPacket( const char * data, int size, unsigned int endpointMask );
+
+        bool sendOscPacket( osc::OutboundPacketStream * bundle );
+
+        /**
+         * Returns true if the socket is open.
+         */
+        bool isConnected();
+
+    private:
+        class Implementation;
+
+        struct Endpoint
+        {
+            std::string host;
+            int port;
+            bool resolved;
+            std::atomic<bool> enabled;
+            std::atomic<unsigned long> packets,
+                                       errors;
+            std::atomic<int> lastError;
+        };
+
+        UdpFanOutSender( const UdpFanOutSender & );
+        UdpFanOutSender & operator=( const UdpFanOutSender & );
+
+        OscNetworkInitializer networkInitializer_;
+        Implementation * impl_;
+        Endpoint endpoints_[MAX_ENDPOINTS];
+        int endpointCount_;
+        std::atomic<unsigned long> packets_,
+                                   syscalls_;
+    };
+}
+
+#endif /* INCLUDED_UDPFANOUTSENDER_H */
@@ -84,7 +84,7 @@ void UdpReceiver::disconnect() {
 		locked = false;
 		return;
 	}
-	socket->Break();
+	socket->AsynchronousBreak();
 	
 	if (!locked) {
 #ifdef WIN32
@@ -96,4 +96,10 @@ void UdpReceiver::disconnect() {
 	connected = false;
 }
 
-
+SocketReceiveMultiplexer::ReceiveStats UdpReceiver::takeReceiveStats() {
+	if (socket==NULL) {
+		SocketReceiveMultiplexer::ReceiveStats stats = { 0, 0, 0, 0 };
+		return stats;
+	}
+	return socket->TakeReceiveStats();
+}
@@ -66,6 +66,14 @@ namespace TUIO {
 		 */
 		void disconnect();
 		
+		/**
+		 * Returns the datagrams received, the wakeups of the receiving loop
+		 * and the datagrams dropped since the last call
+		 *
+		 * @return  the counts, see SocketReceiveMultiplexer::ReceiveStats
+		 */
+		SocketReceiveMultiplexer::ReceiveStats takeReceiveStats();
+		
 	private:
 
 #ifndef WIN32
@@ -0,0 +1,1200 @@
+/*******************************************************************************
+WebSocketSender
+
+PURPOSE: A WebSocket server that sends every TUIO bundle, as it is, to the
+         connected browsers in a binary message.  See the header file.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "WebSocketSender.h"
+#include "ip/NetworkingUtils.h"
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+#if defined( __linux__ ) && !defined( TUIO_NO_EPOLL )
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define TUIO_USE_EPOLL
+#endif
+#ifdef TUIO_USE_ZLIB
+#include <zlib.h>
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+using namespace TUIO;
+
+#ifdef WIN32
+typedef SOCKET SocketHandle;
+static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static void closeSocket( SocketHandle s ) { closesocket( s ); }
+static const int SEND_FLAGS = 0;
+
+static void setNonBlocking( SocketHandle s )
+{
+    u_long on = 1;
+    ioctlsocket( s, FIONBIO, &on );
+}
+
+/**
+ * Sends the message header and the payload with one call.
+ *
+ * @return  the number of bytes sent, or -1.
+ */
+static int sendGathered( SocketHandle s, const char * header, size_t headerSize,
+                         const char * data, size_t size )
+{
+    WSABUF buffers[2];
+    buffers[0].buf = (char *)header;
+    buffers[0].len = (ULONG)headerSize;
+    buffers[1].buf = (char *)data;
+    buffers[1].len = (ULONG)size;
+    DWORD sent = 0;
+
+    if( WSASend( s, buffers, 2, &sent, 0, NULL, NULL ) != 0 ) {
+        return -1;
+    }
+    return (int)sent;
+}
+#else
+typedef int SocketHandle;
+static const SocketHandle NO_SOCKET = -1;
+static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+static void closeSocket( SocketHandle s ) { close( s ); }
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL; // a closed client must not raise SIGPIPE
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+static void setNonBlocking( SocketHandle s )
+{
+    fcntl( s, F_SETFL, fcntl( s, F_GETFL, 0 ) | O_NONBLOCK );
+}
+
+static int sendGathered( SocketHandle s, const char * header, size_t headerSize,
+                         const char * data, size_t size )
+{
+    struct iovec buffers[2];
+    buffers[0].iov_base = (void *)header;
+    buffers[0].iov_len = headerSize;
+    buffers[1].iov_base = (void *)data;
+    buffers[1].iov_len = size;
+
+    struct msghdr message;
+    memset( &message, 0, sizeof( message ) );
+    message.msg_iov = buffers;
+    message.msg_iovlen = 2;
+    return (int)sendmsg( s, &message, SEND_FLAGS );
+}
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static long millisecondsSince( Clock::time_point then, Clock::time_point now )
+{
+    return (long)std::chrono::duration_cast<std::chrono::milliseconds>( now - then ).count();
+}
+
+// RFC 6455
+enum { OPCODE_BINARY = 0x2,
+       OPCODE_CLOSE = 0x8,
+       OPCODE_PING = 0x9,
+       OPCODE_PONG = 0xA };
+
+enum { CLOSE_PROTOCOL_ERROR = 1002,
+       CLOSE_TOO_BIG = 1009 };
+
+static const size_t MAX_REQUEST_SIZE = 8192;
+
+static const char * WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static uint32_t rotateLeft( uint32_t x, int n )
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+/**
+ * SHA-1, only for the Sec-WebSocket-Accept header.
+ */
+static void sha1( const std::string & text, unsigned char digest[20] )
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    std::vector<unsigned char> message( text.begin(), text.end() );
+    uint64_t bits = (uint64_t)text.size() * 8;
+    message.push_back( 0x80 );
+
+    while( message.size() % 64 != 56 ) {
+        message.push_back( 0 );
+    }
+    for( int i = 7; i >= 0; --i ) {
+        message.push_back( (unsigned char)(bits >> (i * 8)) );
+    }
+    for( size_t chunk = 0; chunk < message.size(); chunk += 64 ) {
+        uint32_t w[80];
+
+        for( int i = 0; i < 16; ++i ) {
+            const unsigned char * p = &message[chunk + i * 4];
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+        }
+        for( int i = 16; i < 80; ++i ) {
+            w[i] = rotateLeft( w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1 );
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+
+        for( int i = 0; i < 80; ++i ) {
+            uint32_t f, k;
+
+            if( i < 20 )      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if( i < 40 ) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if( i < 60 ) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else              { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+
+            uint32_t temp = rotateLeft( a, 5 ) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotateLeft( b, 30 );
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for( int i = 0; i < 20; ++i ) {
+        digest[i] = (unsigned char)(h[i / 4] >> (24 - (i % 4) * 8));
+    }
+}
+
+static std::string base64( const unsigned char * data, size_t size )
+{
+    static const char * digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+
+    for( size_t i = 0; i < size; i += 3 ) {
+        uint32_t group = (uint32_t)data[i] << 16;
+
+        if( i + 1 < size ) group |= (uint32_t)data[i + 1] << 8;
+        if( i + 2 < size ) group |= (uint32_t)data[i + 2];
+
+        text += digits[(group >> 18) & 63];
+        text += digits[(group >> 12) & 63];
+        text += i + 1 < size ? digits[(group >> 6) & 63] : '=';
+        text += i + 2 < size ? digits[group & 63] : '=';
+    }
+    return text;
+}
+
+static std::string acceptKey( const std::string & key )
+{
+    unsigned char digest[20];
+    sha1( key + WEBSOCKET_GUID, digest );
+    return base64( digest, sizeof( digest ) );
+}
+
+static std::string trim( const std::string & s )
+{
+    size_t first = s.find_first_not_of( " \t" );
+
+    if( first == std::string::npos ) {
+        return std::string();
+    }
+    return s.substr( first, s.find_last_not_of( " \t" ) - first + 1 );
+}
+
+static std::string lowerCase( std::string s )
+{
+    for( size_t i = 0; i < s.size(); ++i ) {
+        if( s[i] >= 'A' && s[i] <= 'Z' ) {
+            s[i] = (char)(s[i] - 'A' + 'a');
+        }
+    }
+    return s;
+}
+
+/**
+ * True if one of the comma separated offers is a permessage-deflate this
+ * server can take: it always compresses with a 32 KB window and never keeps
+ * the context, and it ignores what clients send, so only a smaller
+ * server_max_window_bits or an unknown parameter rules an offer out.
+ */
+static bool acceptsDeflate( const std::string & offers )
+{
+    size_t start = 0;
+
+    while( start < offers.size() ) {
+        size_t end = offers.find( ',', start );
+
+        if( end == std::string::npos ) {
+            end = offers.size();
+        }
+        std::string offer = offers.substr( start, end - start );
+        start = end + 1;
+
+        size_t semicolon = offer.find( ';' );
+
+        if( lowerCase( trim( offer.substr( 0, semicolon ) ) ) != "permessage-deflate" ) {
+            continue;
+        }
+        bool ok = true;
+
+        while( ok && semicolon != std::string::npos ) {
+            size_t next = offer.find( ';', semicolon + 1 );
+            std::string parameter = lowerCase( trim( offer.substr( semicolon + 1, next == std::string::npos
+                                                                                  ? std::string::npos
+                                                                                  : next - semicolon - 1 ) ) );
+            size_t equals = parameter.find( '=' );
+            std::string name = trim( parameter.substr( 0, equals ) ),
+                        value = equals == std::string::npos ? std::string() : trim( parameter.substr( equals + 1 ) );
+
+            if( value.size() >= 2 && value[0] == '"' ) {
+                value = value.substr( 1, value.size() - 2 );
+            }
+            if( name == "server_max_window_bits" ) {
+                ok = value == "15";
+            }
+            else if( name != "server_no_context_takeover" && name != "client_no_context_takeover"
+                     && name != "client_max_window_bits" ) {
+                ok = false;
+            }
+            semicolon = next;
+        }
+        if( ok ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Writes the header of an unmasked, unfragmented message.
+ *
+ * @return  its size, 2 to 10 bytes.
+ */
+static size_t messageHeader( char * header, int opcode, bool compressed, size_t size )
+{
+    header[0] = (char)(0x80 | (compressed ? 0x40 : 0) | opcode);
+
+    if( size < 126 ) {
+        header[1] = (char)size;
+        return 2;
+    }
+    if( size < 65536 ) {
+        header[1] = 126;
+        header[2] = (char)(size >> 8);
+        header[3] = (char)size;
+        return 4;
+    }
+    header[1] = 127;
+
+    for( int i = 0; i < 8; ++i ) {
+        header[2 + i] = (char)((uint64_t)size >> (56 - i * 8));
+    }
+    return 10;
+}
+
+/**
+ * A message waiting to be sent to one client.  The bytes are shared by
+ * every client that queued the same message.
+ */
+struct WebSocketFrame
+{
+    std::shared_ptr< std::vector<char> > bytes;
+    size_t offset;
+    Clock::time_point queued;
+    bool control;       // the handshake response, a pong or a close, never dropped
+};
+
+struct WebSocketClient
+{
+    enum State { HANDSHAKE,     // waiting for the whole HTTP request
+                 OPEN,          // sent every bundle
+                 CLOSING };     // closed once its queue is written
+
+    SocketHandle socket;
+    std::string address;
+    State state;
+    bool deflate;
+    std::string input;          // received, not yet complete
+    std::deque<WebSocketFrame> queue;
+    unsigned long framesSent,
+                  framesDropped,
+                  bytesSent;
+    long maxLagMilliseconds;
+    bool closed;
+};
+
+/**
+ * The sockets, the clients and the event loop, kept here so the header file
+ * does not need the platform's socket headers.
+ */
+class WebSocketSender::Implementation
+{
+public:
+    Implementation( bool deflate ) :
+      networkInitializer_(),
+      listener_( NO_SOCKET ),
+      wake_( NO_SOCKET ),
+#ifdef TUIO_USE_EPOLL
+      poll_( -1 ),
+#else
+      wakeSender_( NO_SOCKET ),
+#endif
+      port_( 0 ),
+      deflate_( false ),
+      running_( false ),
+      fullFrameRequested_( false )
+    {
+#ifdef TUIO_USE_ZLIB
+        memset( &deflater_, 0, sizeof( deflater_ ) );
+        deflate_ = deflate && deflateInit2( &deflater_, Z_BEST_SPEED, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) == Z_OK;
+#endif
+    }
+
+    ~Implementation()
+    {
+        stop();
+#ifdef TUIO_USE_ZLIB
+        if( deflate_ ) {
+            deflateEnd( &deflater_ );
+        }
+#endif
+    }
+
+    bool start( int port );
+    void stop();
+    bool isRunning() const { return running_.load(); }
+    int port() const { return port_; }
+    bool deflate() const { return deflate_; }
+
+    bool sendToAll( const char * data, size_t size );
+
+    int clientCount();
+    std::vector<ClientStats> clientStats();
+    bool takeFullFrameRequest() { return fullFrameRequested_.exchange( false ); }
+
+private:
+    void run();
+    void acceptClients();
+    void readFromClient( WebSocketClient * client, Clock::time_point now );
+    void readHandshake( WebSocketClient * client, Clock::time_point now );
+    void readFrames( WebSocketClient * client, Clock::time_point now );
+    void sendControl( WebSocketClient * client, int opcode, const char * payload, size_t size, Clock::time_point now );
+    void sendClose( WebSocketClient * client, int code, Clock::time_point now );
+    std::shared_ptr< std::vector<char> > compressedMessage( const char * data, size_t size );
+    void writeQueue( WebSocketClient * client, Clock::time_point now );
+    void enqueue( WebSocketClient * client, const std::shared_ptr< std::vector<char> > & bytes,
+                  size_t offset, Clock::time_point now, bool control );
+    void messageSent( WebSocketClient * client, size_t size, long lag );
+    void watchForWrites( WebSocketClient * client, bool on );
+    void removeClosedClients();
+    void wakeUp();
+    void drainWakeUps();
+
+    OscNetworkInitializer networkInitializer_;
+    SocketHandle listener_,
+                 wake_;
+#ifdef TUIO_USE_EPOLL
+    int poll_;
+#else
+    SocketHandle wakeSender_;
+#endif
+    int port_;
+    bool deflate_;
+#ifdef TUIO_USE_ZLIB
+    z_stream deflater_;
+    std::vector<char> compressed_;
+#endif
+    std::atomic<bool> running_,
+                      fullFrameRequested_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<WebSocketClient *> clients_;
+};
+
+bool WebSocketSender::Implementation::start( int port )
+{
+    listener_ = ::socket( AF_INET, SOCK_STREAM, 0 );
+
+    if( listener_ == NO_SOCKET ) {
+        return false;
+    }
+    int on = 1;
+    setsockopt( listener_, SOL_SOCKET, SO_REUSEADDR, (const char *)&on, sizeof( on ) );
+
+    struct sockaddr_in address;
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_ANY );
+    address.sin_port = htons( (unsigned short)port );
+    socklen_t length = sizeof( address );
+
+    if( bind( listener_, (struct sockaddr *)&address, sizeof( address ) ) != 0
+        || listen( listener_, SOMAXCONN ) != 0
+        || getsockname( listener_, (struct sockaddr *)&address, &length ) != 0 ) {
+        closeSocket( listener_ );
+        listener_ = NO_SOCKET;
+        return false;
+    }
+    port_ = ntohs( address.sin_port );
+    setNonBlocking( listener_ );
+
+#ifdef TUIO_USE_EPOLL
+    poll_ = epoll_create1( EPOLL_CLOEXEC );
+    wake_ = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ) );
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; // the listener
+    epoll_ctl( poll_, EPOLL_CTL_ADD, listener_, &event );
+    event.data.ptr = this; // the wake-up event
+    epoll_ctl( poll_, EPOLL_CTL_ADD, wake_, &event );
+#else
+    // select() can only wait on sockets, so the loop is woken up by a
+    // datagram sent to a UDP socket bound to localhost.
+    wake_ = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    wakeSender_ = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    length = sizeof( address );
+    bind( wake_, (struct sockaddr *)&address, sizeof( address ) );
+    getsockname( wake_, (struct sockaddr *)&address, &length );
+    connect( wakeSender_, (struct sockaddr *)&address, sizeof( address ) );
+    setNonBlocking( wake_ );
+    setNonBlocking( wakeSender_ );
+#endif
+    running_.store( true );
+    thread_ = std::thread( &Implementation::run, this );
+    return true;
+}
+
+void WebSocketSender::Implementation::stop()
+{
+    if( running_.exchange( false ) ) {
+        wakeUp();
+        thread_.join();
+    }
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        closeSocket( clients_[i]->socket );
+        delete clients_[i];
+    }
+    clients_.clear();
+
+    if( listener_ != NO_SOCKET ) {
+        closeSocket( listener_ );
+        listener_ = NO_SOCKET;
+    }
+#ifdef TUIO_USE_EPOLL
+    if( wake_ != NO_SOCKET ) {
+        close( wake_ );
+        wake_ = NO_SOCKET;
+    }
+    if( poll_ >= 0 ) {
+        close( poll_ );
+        poll_ = -1;
+    }
+#else
+    if( wake_ != NO_SOCKET ) {
+        closeSocket( wake_ );
+        wake_ = NO_SOCKET;
+    }
+    if( wakeSender_ != NO_SOCKET ) {
+        closeSocket( wakeSender_ );
+        wakeSender_ = NO_SOCKET;
+    }
+#endif
+}
+
+void WebSocketSender::Implementation::wakeUp()
+{
+#ifdef TUIO_USE_EPOLL
+    uint64_t one = 1;
+    ssize_t written = write( wake_, &one, sizeof( one ) );
+    (void)written; // a full counter means the loop is already awake
+#else
+    char byte = 0;
+    send( wakeSender_, &byte, 1, 0 );
+#endif
+}
+
+void WebSocketSender::Implementation::drainWakeUps()
+{
+#ifdef TUIO_USE_EPOLL
+    uint64_t count;
+    ssize_t n = read( wake_, &count, sizeof( count ) );
+    (void)n;
+#else
+    char buffer[64];
+
+    while( recv( wake_, buffer, sizeof( buffer ), 0 ) > 0 ) {
+    }
+#endif
+}
+
+void WebSocketSender::Implementation::run()
+{
+#ifdef TUIO_USE_EPOLL
+    const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+
+    while( running_.load() ) {
+        int count = epoll_wait( poll_, events, MAX_EVENTS, -1 );
+
+        if( count < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            break;
+        }
+        std::lock_guard<std::mutex> lock( mutex_ );
+        Clock::time_point now = Clock::now();
+
+        for( int i = 0; i < count; ++i ) {
+            void * source = events[i].data.ptr;
+
+            if( source == NULL ) {
+                acceptClients();
+            }
+            else if( source == this ) {
+                drainWakeUps();
+            }
+            else {
+                WebSocketClient * client = (WebSocketClient *)source;
+
+                if( events[i].events & (EPOLLERR | EPOLLHUP) ) {
+                    client->closed = true;
+                }
+                if( !client->closed && (events[i].events & EPOLLIN) ) {
+                    readFromClient( client, now );
+                }
+                if( !client->closed && (events[i].events & EPOLLOUT) ) {
+                    writeQueue( client, now );
+                }
+            }
+        }
+        removeClosedClients();
+    }
+#else
+    while( running_.load() ) {
+        fd_set readable,
+               writable;
+        FD_ZERO( &readable );
+        FD_ZERO( &writable );
+        SocketHandle highest = listener_ > wake_ ? listener_ : wake_;
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            FD_SET( listener_, &readable );
+            FD_SET( wake_, &readable );
+
+            for( size_t i = 0; i < clients_.size(); ++i ) {
+                SocketHandle s = clients_[i]->socket;
+                FD_SET( s, &readable );
+
+                if( !clients_[i]->queue.empty() ) {
+                    FD_SET( s, &writable );
+                }
+                if( s > highest ) {
+                    highest = s;
+                }
+            }
+        }
+        if( select( (int)highest + 1, &readable, &writable, NULL, NULL ) < 0 ) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock( mutex_ );
+        Clock::time_point now = Clock::now();
+
+        if( FD_ISSET( wake_, &readable ) ) {
+            drainWakeUps();
+        }
+        if( FD_ISSET( listener_, &readable ) ) {
+            acceptClients();
+        }
+        for( size_t i = 0; i < clients_.size(); ++i ) {
+            WebSocketClient * client = clients_[i];
+
+            if( FD_ISSET( client->socket, &readable ) ) {
+                readFromClient( client, now );
+            }
+            if( !client->closed && FD_ISSET( client->socket, &writable ) ) {
+                writeQueue( client, now );
+            }
+        }
+        removeClosedClients();
+    }
+#endif
+}
+
+void WebSocketSender::Implementation::acceptClients()
+{
+    for( ;; ) {
+        struct sockaddr_in address;
+        socklen_t length = sizeof( address );
+        SocketHandle s = accept( listener_, (struct sockaddr *)&address, &length );
+
+        if( s == NO_SOCKET ) {
+            return;
+        }
+        setNonBlocking( s );
+        int on = 1;
+        setsockopt( s, IPPROTO_TCP, TCP_NODELAY, (const char *)&on, sizeof( on ) );
+
+        WebSocketClient * client = new WebSocketClient();
+        client->socket = s;
+        client->address = inet_ntoa( address.sin_addr );
+        client->state = WebSocketClient::HANDSHAKE;
+        client->deflate = false;
+        client->framesSent = 0;
+        client->framesDropped = 0;
+        client->bytesSent = 0;
+        client->maxLagMilliseconds = 0;
+        client->closed = false;
+        clients_.push_back( client );
+
+#ifdef TUIO_USE_EPOLL
+        struct epoll_event event;
+        memset( &event, 0, sizeof( event ) );
+        event.events = EPOLLIN;
+        event.data.ptr = client;
+        epoll_ctl( poll_, EPOLL_CTL_ADD, s, &event );
+#endif
+    }
+}
+
+void WebSocketSender::Implementation::readFromClient( WebSocketClient * client, Clock::time_point now )
+{
+    char buffer[4096];
+
+    for( ;; ) {
+        int n = (int)recv( client->socket, buffer, sizeof( buffer ), 0 );
+
+        if( n <= 0 ) {
+            if( n == 0 || !wouldBlock() ) {
+                client->closed = true;
+            }
+            return;
+        }
+        if( client->state == WebSocketClient::CLOSING ) {
+            continue; // read only to notice the client going away
+        }
+        client->input.append( buffer, n );
+
+        if( client->state == WebSocketClient::HANDSHAKE ) {
+            readHandshake( client, now );
+        }
+        if( client->state == WebSocketClient::OPEN ) {
+            readFrames( client, now );
+        }
+    }
+}
+
+/**
+ * Answers the HTTP upgrade request once it is all in.
+ */
+void WebSocketSender::Implementation::readHandshake( WebSocketClient * client, Clock::time_point now )
+{
+    size_t end = client->input.find( "\r\n\r\n" );
+
+    if( end == std::string::npos ) {
+        if( client->input.size() > MAX_REQUEST_SIZE ) {
+            client->closed = true;
+        }
+        return;
+    }
+    std::string request = client->input.substr( 0, end + 2 );
+    client->input.erase( 0, end + 4 );
+
+    std::string key,
+                version,
+                upgrade,
+                extensions;
+    size_t line = request.find( "\r\n" ) + 2;
+
+    while( line < request.size() ) {
+        size_t next = request.find( "\r\n", line );
+        std::string header = request.substr( line, next - line );
+        size_t colon = header.find( ':' );
+        line = next + 2;
+
+        if( colon == std::string::npos ) {
+            continue;
+        }
+        std::string name = lowerCase( trim( header.substr( 0, colon ) ) ),
+                    value = trim( header.substr( colon + 1 ) );
+
+        if( name == "sec-websocket-key" ) {
+            key = value;
+        }
+        else if( name == "sec-websocket-version" ) {
+            version = value;
+        }
+        else if( name == "upgrade" ) {
+            upgrade = lowerCase( value );
+        }
+        else if( name == "sec-websocket-extensions" ) {
+            extensions += (extensions.empty() ? "" : ",") + value;
+        }
+    }
+    std::string response;
+
+    if( request.compare( 0, 4, "GET " ) != 0 || key.empty() || upgrade.find( "websocket" ) == std::string::npos ) {
+        response = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+        client->state = WebSocketClient::CLOSING;
+    }
+    else if( version != "13" ) {
+        response = "HTTP/1.1 426 Upgrade Required\r\nSec-WebSocket-Version: 13\r\nConnection: close\r\n\r\n";
+        client->state = WebSocketClient::CLOSING;
+    }
+    else {
+        client->deflate = deflate_ && acceptsDeflate( extensions );
+        response = "HTTP/1.1 101 Switching Protocols\r\n"
+                   "Upgrade: websocket\r\n"
+                   "Connection: Upgrade\r\n"
+                   "Sec-WebSocket-Accept: " + acceptKey( key ) + "\r\n";
+
+        if( client->deflate ) {
+            response += "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover\r\n";
+        }
+        response += "\r\n";
+        client->state = WebSocketClient::OPEN;
+        fullFrameRequested_.store( true ); // it knows none of the cursors yet
+    }
+    std::shared_ptr< std::vector<char> > bytes = std::make_shared< std::vector<char> >( response.begin(), response.end() );
+    enqueue( client, bytes, 0, now, true );
+}
+
+/**
+ * Takes the complete frames from the client's input: pings are answered,
+ * a close is echoed, data is ignored.
+ */
+void WebSocketSender::Implementation::readFrames( WebSocketClient * client, Clock::time_point now )
+{
+    const std::string & input = client->input;
+    size_t position = 0;
+
+    while( client->state == WebSocketClient::OPEN ) {
+        size_t available = input.size() - position;
+
+        if( available < 2 ) {
+            break;
+        }
+        const unsigned char * bytes = (const unsigned char *)input.data() + position;
+        int opcode = bytes[0] & 0x0F;
+        uint64_t size = bytes[1] & 0x7F;
+        size_t headerSize = 2;
+
+        if( size == 126 ) {
+            if( available < 4 ) {
+                break;
+            }
+            size = (uint64_t)bytes[2] << 8 | bytes[3];
+            headerSize = 4;
+        }
+        else if( size == 127 ) {
+            if( available < 10 ) {
+                break;
+            }
+            size = 0;
+
+            for( int i = 0; i < 8; ++i ) {
+                size = size << 8 | bytes[2 + i];
+            }
+            headerSize = 10;
+        }
+        if( (bytes[1] & 0x80) == 0 ) {
+            sendClose( client, CLOSE_PROTOCOL_ERROR, now ); // a client must mask its frames
+            break;
+        }
+        if( size > MAX_MESSAGE_SIZE ) {
+            sendClose( client, CLOSE_TOO_BIG, now );
+            break;
+        }
+        if( available < headerSize + 4 + size ) {
+            break;
+        }
+        const unsigned char * mask = bytes + headerSize;
+        std::string payload( (const char *)mask + 4, (size_t)size );
+
+        for( size_t i = 0; i < payload.size(); ++i ) {
+            payload[i] = (char)(payload[i] ^ mask[i % 4]);
+        }
+        position += headerSize + 4 + (size_t)size;
+
+        if( opcode == OPCODE_CLOSE ) {
+            // echo the status code, then close
+            sendControl( client, OPCODE_CLOSE, payload.data(), payload.size() < 2 ? payload.size() : 2, now );
+            client->state = WebSocketClient::CLOSING;
+        }
+        else if( opcode == OPCODE_PING ) {
+            sendControl( client, OPCODE_PONG, payload.data(), payload.size() < 125 ? payload.size() : 125, now );
+        }
+    }
+    if( client->state == WebSocketClient::OPEN ) {
+        client->input.erase( 0, position );
+    }
+    else {
+        client->input.clear();
+    }
+}
+
+void WebSocketSender::Implementation::sendControl( WebSocketClient * client, int opcode, const char * payload,
+                                                   size_t size, Clock::time_point now )
+{
+    std::shared_ptr< std::vector<char> > bytes = std::make_shared< std::vector<char> >( 2 + size );
+    messageHeader( &(*bytes)[0], opcode, false, size );
+
+    if( size > 0 ) {
+        memcpy( &(*bytes)[2], payload, size );
+    }
+    enqueue( client, bytes, 0, now, true );
+}
+
+void WebSocketSender::Implementation::sendClose( WebSocketClient * client, int code, Clock::time_point now )
+{
+    char status[2] = { (char)(code >> 8), (char)code };
+    sendControl( client, OPCODE_CLOSE, status, sizeof( status ), now );
+    client->state = WebSocketClient::CLOSING;
+}
+
+/**
+ * The whole message (header and payload) compressed as permessage-deflate
+ * with no context kept, or NULL if zlib is not built in or compressing
+ * does not make it smaller; an uncompressed message is as good to a client
+ * that took the extension.
+ */
+std::shared_ptr< std::vector<char> > WebSocketSender::Implementation::compressedMessage( const char * data, size_t size )
+{
+#ifdef TUIO_USE_ZLIB
+    deflateReset( &deflater_ );
+    compressed_.resize( deflateBound( &deflater_, (uLong)size ) + 16 );
+    deflater_.next_in = (Bytef *)data;
+    deflater_.avail_in = (uInt)size;
+    deflater_.next_out = (Bytef *)&compressed_[0];
+    deflater_.avail_out = (uInt)compressed_.size();
+
+    if( ::deflate( &deflater_, Z_SYNC_FLUSH ) != Z_OK || deflater_.avail_in != 0 ) {
+        return std::shared_ptr< std::vector<char> >();
+    }
+    size_t length = compressed_.size() - deflater_.avail_out;
+
+    // the receiver adds back the empty block a sync flush ends with
+    if( length >= 4 && memcmp( &compressed_[length - 4], "\x00\x00\xff\xff", 4 ) == 0 ) {
+        length -= 4;
+    }
+    if( length >= size ) {
+        return std::shared_ptr< std::vector<char> >();
+    }
+    std::shared_ptr< std::vector<char> > message = std::make_shared< std::vector<char> >( 10 + length );
+    size_t headerSize = messageHeader( &(*message)[0], OPCODE_BINARY, true, length );
+    memcpy( &(*message)[headerSize], &compressed_[0], length );
+    message->resize( headerSize + length );
+    return message;
+#else
+    return std::shared_ptr< std::vector<char> >();
+#endif
+}
+
+void WebSocketSender::Implementation::messageSent( WebSocketClient * client, size_t size, long lag )
+{
+    if( lag > client->maxLagMilliseconds ) {
+        client->maxLagMilliseconds = lag;
+    }
+    ++client->framesSent;
+    client->bytesSent += (unsigned long)size;
+}
+
+void WebSocketSender::Implementation::writeQueue( WebSocketClient * client, Clock::time_point now )
+{
+    while( !client->queue.empty() ) {
+        WebSocketFrame & frame = client->queue.front();
+        const std::vector<char> & bytes = *frame.bytes;
+        int n = (int)send( client->socket, &bytes[frame.offset], (int)(bytes.size() - frame.offset), SEND_FLAGS );
+
+        if( n < 0 ) {
+            if( !wouldBlock() ) {
+                client->closed = true;
+            }
+            return;
+        }
+        frame.offset += (size_t)n;
+
+        if( frame.offset < bytes.size() ) {
+            return;
+        }
+        if( !frame.control ) {
+            messageSent( client, bytes.size(), millisecondsSince( frame.queued, now ) );
+        }
+        client->queue.pop_front();
+    }
+    watchForWrites( client, false );
+
+    if( client->state == WebSocketClient::CLOSING ) {
+        client->closed = true;
+    }
+}
+
+void WebSocketSender::Implementation::enqueue( WebSocketClient * client, const std::shared_ptr< std::vector<char> > & bytes,
+                                               size_t offset, Clock::time_point now, bool control )
+{
+    if( !control ) {
+        size_t messages = 0;
+
+        for( size_t i = 0; i < client->queue.size(); ++i ) {
+            messages += client->queue[i].control ? 0 : 1;
+        }
+        if( messages >= MAX_QUEUED_FRAMES ) {
+            // Keep the control frames and a message that is partly written,
+            // drop the rest: the next bundle will carry every cursor.
+            std::deque<WebSocketFrame> kept;
+
+            for( size_t i = 0; i < client->queue.size(); ++i ) {
+                const WebSocketFrame & frame = client->queue[i];
+
+                if( frame.control || (i == 0 && frame.offset > 0) ) {
+                    kept.push_back( frame );
+                }
+                else {
+                    ++client->framesDropped;
+                }
+            }
+            client->queue.swap( kept );
+            fullFrameRequested_.store( true );
+        }
+    }
+    WebSocketFrame frame;
+    frame.bytes = bytes;
+    frame.offset = offset;
+    frame.queued = now;
+    frame.control = control;
+    client->queue.push_back( frame );
+    watchForWrites( client, true );
+}
+
+void WebSocketSender::Implementation::watchForWrites( WebSocketClient * client, bool on )
+{
+#ifdef TUIO_USE_EPOLL
+    struct epoll_event event;
+    memset( &event, 0, sizeof( event ) );
+    event.events = on ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.ptr = client;
+    epoll_ctl( poll_, EPOLL_CTL_MOD, client->socket, &event );
+#else
+    if( on && client->queue.size() == 1 ) {
+        wakeUp(); // select() has to be called again with this socket in the write set
+    }
+#endif
+}
+
+void WebSocketSender::Implementation::removeClosedClients()
+{
+    size_t kept = 0;
+
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        WebSocketClient * client = clients_[i];
+
+        if( client->closed ) {
+#ifdef TUIO_USE_EPOLL
+            epoll_ctl( poll_, EPOLL_CTL_DEL, client->socket, NULL );
+#endif
+            closeSocket( client->socket );
+            delete client;
+        }
+        else {
+            clients_[kept++] = client;
+        }
+    }
+    clients_.resize( kept );
+}
+
+bool WebSocketSender::Implementation::sendToAll( const char * data, size_t size )
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+
+    if( size == 0 || size > MAX_MESSAGE_SIZE ) {
+        return false;
+    }
+    Clock::time_point now = Clock::now();
+    char header[10];
+    size_t headerSize = messageHeader( header, OPCODE_BINARY, false, size );
+    std::shared_ptr< std::vector<char> > plain,         // only copied if some client needs it
+                                         compressed;    // compressed once for all clients
+    bool compressionTried = false,
+         sent = false,
+         closed = false;
+
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        WebSocketClient * client = clients_[i];
+
+        if( client->closed || client->state != WebSocketClient::OPEN ) {
+            continue;
+        }
+        sent = true;
+
+        if( client->deflate && !compressionTried ) {
+            compressed = compressedMessage( data, size );
+            compressionTried = true;
+        }
+        bool compress = client->deflate && compressed;
+        size_t total = compress ? compressed->size() : headerSize + size,
+               offset = 0;
+
+        if( client->queue.empty() ) {
+            int n = compress ? (int)send( client->socket, &(*compressed)[0], (int)total, SEND_FLAGS )
+                             : sendGathered( client->socket, header, headerSize, data, size );
+
+            if( n < 0 && !wouldBlock() ) {
+                client->closed = true;
+                closed = true;
+                continue;
+            }
+            offset = n > 0 ? (size_t)n : 0;
+
+            if( offset == total ) {
+                messageSent( client, total, 0 );
+                continue;
+            }
+        }
+        if( compress ) {
+            enqueue( client, compressed, offset, now, false );
+            continue;
+        }
+        if( !plain ) {
+            plain = std::make_shared< std::vector<char> >( header, header + headerSize );
+            plain->insert( plain->end(), data, data + size );
+        }
+        enqueue( client, plain, offset, now, false );
+    }
+    if( closed ) {
+        wakeUp(); // only the event loop deletes clients
+    }
+    return sent;
+}
+
+int WebSocketSender::Implementation::clientCount()
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    int count = 0;
+
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        if( clients_[i]->state == WebSocketClient::OPEN && !clients_[i]->closed ) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::vector<WebSocketSender::ClientStats> WebSocketSender::Implementation::clientStats()
+{
+    std::lock_guard<std::mutex> lock( mutex_ );
+    Clock::time_point now = Clock::now();
+    std::vector<ClientStats> stats;
+
+    for( size_t i = 0; i < clients_.size(); ++i ) {
+        const WebSocketClient * client = clients_[i];
+
+        if( client->state != WebSocketClient::OPEN || client->closed ) {
+            continue;
+        }
+        ClientStats s;
+        s.address = client->address;
+        s.deflate = client->deflate;
+        s.framesSent = client->framesSent;
+        s.framesDropped = client->framesDropped;
+        s.bytesSent = client->bytesSent;
+        s.queuedFrames = 0;
+
+        for( size_t j = 0; j < client->queue.size(); ++j ) {
+            s.queuedFrames += client->queue[j].control ? 0 : 1;
+        }
+        s.lagMilliseconds = client->queue.empty() ? 0 : millisecondsSince( client->queue.front().queued, now );
+        s.maxLagMilliseconds = client->maxLagMilliseconds > s.lagMilliseconds
+                               ? client->maxLagMilliseconds : s.lagMilliseconds;
+        stats.push_back( s );
+    }
+    return stats;
+}
+
+WebSocketSender::WebSocketSender( int port, bool deflate /*= false*/ ) :
+  impl_( new Implementation( deflate ) )
+{
+    local = false;
+    buffer_size = MAX_MESSAGE_SIZE;
+
+    if( !impl_->start( port ) ) {
+        std::cerr << "could not listen for WebSocket clients on TCP port " << port << std::endl;
+    }
+}
+
+WebSocketSender::~WebSocketSender()
+{
+    delete impl_;
+}
+
+bool WebSocketSender::sendOscPacket( osc::OutboundPacketStream * bundle )
+{
+    return impl_->sendToAll( bundle->Data(), bundle->Size() );
+}
+
+bool WebSocketSender::sendPacket( const char * data, int size )
+{
+    return size > 0 && impl_->sendToAll( data, (size_t)size );
+}
+
+bool WebSocketSender::isConnected()
+{
+    return impl_->clientCount() > 0;
+}
+
+bool WebSocketSender::isRunning()
+{
+    return impl_->isRunning();
+}
+
+int WebSocketSender::getPort()
+{
+    return impl_->isRunning() ? impl_->port() : 0;
+}
+
+bool WebSocketSender::deflateEnabled()
+{
+    return impl_->deflate();
+}
+
+int WebSocketSender::getClientCount()
+{
+    return impl_->clientCount();
+}
+
+std::vector<WebSocketSender::ClientStats> WebSocketSender::getClientStats()
+{
+    return impl_->clientStats();
+}
+
+bool WebSocketSender::fullFrameRequested()
+{
+    return impl_->takeFullFrameRequest();
+}
@@ -0,0 +1,138 @@
+/*******************************************************************************
+WebSocketSender
+
+PURPOSE: A WebSocket server that sends every TUIO bundle, as it is, to the
+         connected browsers in a binary message.
+
+NOTES:
+Browsers can no longer use the Flash XML channel, whose XML text is several
+times the size of the OSC bundle it describes and costly to build and parse.
+A WebSocketSender is an OscSender like the others: the bundle the
+TuioCursorServer wrote for its UDP endpoints is framed (2 to 10 bytes of
+header) and sent, not encoded again.  A browser reads each message as one
+OSC packet (an ArrayBuffer).
+
+The server speaks RFC 6455 version 13.  If it is created with deflate on and
+a client offers permessage-deflate (RFC 7692), the messages to that client
+are compressed, with server_no_context_takeover: every message is
+compressed on its own, once, and the same bytes go to every client that
+took the extension.  Compression needs zlib and is only built in with
+TUIO_USE_ZLIB defined; otherwise the offer is declined.  Deflate takes a
+bundle of moving cursors down to about half its size (the addresses and
+type tags repeat, the floats do not), and a message it would not make
+smaller is sent uncompressed.
+
+Sockets, the event loop (epoll on Linux, select() elsewhere) and the
+per-client queues work as in FlashXmlTcpServer: a client that keeps up is
+written to straight from the sender's thread without a copy, and a client
+that falls behind has at most MAX_QUEUED_FRAMES messages queued.  When its
+queue is full, the messages that have not been started are dropped (a
+message that is partly written is always finished), and
+fullFrameRequested() returns true so that the next bundle carries every
+cursor.  It does so too when a client connects.  The event loop answers
+pings and close frames; anything else a client sends is ignored.
+
+Per-client lag and the sent and dropped message counts are available from
+getClientStats().
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_WEBSOCKETSENDER_H
+#define INCLUDED_WEBSOCKETSENDER_H
+
+#include "OscSender.h"
+#include <string>
+#include <vector>
+
+namespace TUIO
+{
+    /**
+     * <p><code>
+     * WebSocketSender * webSocket = new WebSocketSender( 3335, true );<br/>
+     * tuioCursorServer->addOscSender( webSocket );<br/>
+     * </code></p>
+     */
+    class LIBDECL WebSocketSender : public OscSender
+    {
+    public:
+        enum { MAX_QUEUED_FRAMES = 8,
+               MAX_MESSAGE_SIZE = 65536 };
+
+        struct ClientStats
+        {
+            std::string address;
+            bool deflate;                   // permessage-deflate was agreed on
+            unsigned long framesSent,
+                          framesDropped,
+                          bytesSent;        // message headers and payloads
+            unsigned int queuedFrames;
+            long lagMilliseconds,
+                 maxLagMilliseconds;
+        };
+
+        /**
+         * Listens on the port (0 picks a free one) and starts the event loop.
+         *
+         * @param  deflate  offer permessage-deflate to the clients that ask.
+         */
+        WebSocketSender( int port, bool deflate = false );
+
+        /**
+         * Stops the event loop and closes every connection.
+         */
+        ~WebSocketSender();
+
+        /**
+         * Sends the bundle in a binary message to every client that has
+         * finished its opening handshake.
+         *
+         * @return  false if there are no such clients.
+         */
+        bool sendOscPacket( osc::OutboundPacketStream * bundle );
+
+        /**
+         * Sends the bytes in a binary message, as sendOscPacket() does.
+         */
+        bool sendPacket( const char * data, int size );
+
+        /**
+         * @return  true if at least one client has finished its handshake.
+         */
+        bool isConnected();
+
+        /**
+         * @return  true if the server is listening.
+         */
+        bool isRunning();
+
+        /**
+         * The port being listened on, or 0 if listening failed.
+         */
+        int getPort();
+
+        /**
+         * @return  true if permessage-deflate is offered; false if it was not
+         *          asked for or zlib is not built in.
+         */
+        bool deflateEnabled();
+
+        int getClientCount();
+        std::vector<ClientStats> getClientStats();
+
+        /**
+         * Returns true, once, if a message has been dropped for any client
+         * or a client has connected since the last call.
+         */
+        bool fullFrameRequested();
+
+    private:
+        class Implementation;
+
+        WebSocketSender( const WebSocketSender & );
+        WebSocketSender & operator=( const WebSocketSender & );
+
+        Implementation * impl_;
+    };
+}
+
+#endif
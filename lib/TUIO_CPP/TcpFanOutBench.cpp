@@ -0,0 +1,141 @@
+/*******************************************************************************
+TcpFanOutBench
+
+PURPOSE: Measures what sending a TUIO/TCP frame from one TcpSender to many
+         TuioClients on localhost costs.
+
+NOTES:
+CONSUMERS TuioClients, each with its own TcpReceiver, connect to a
+TcpSender listening on a free port.  Frames with one moving cursor are then
+sent as fast as the sender allows, and the time spent in sendOscPacket()
+is printed per frame and per client once every client has had the last
+frame.  TcpFanOutCheck checks that every client gets every frame and that a
+client that stops reading is disconnected.
+
+Usage: TcpFanOutBench [frames] [consumers]
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TcpReceiver.h"
+#include "TcpSender.h"
+#include "TuioClient.h"
+#include "TuioListener.h"
+#include <unistd.h>
+#include <atomic>
+#include <vector>
+
+using namespace TUIO;
+
+static const unsigned int DEFAULT_CONSUMERS = 64;
+
+/**
+ * Counts the frames a TuioClient delivers.
+ */
+class CountingListener : public TuioListener
+{
+public:
+    CountingListener() : frames( 0 ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioCursor( TuioCursor * ) {}
+    void updateTuioCursor( TuioCursor * ) {}
+    void removeTuioCursor( TuioCursor * ) {}
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+    void refresh( TuioTime ) { frames.fetch_add( 1 ); }
+
+    std::atomic<unsigned long> frames;
+};
+
+static float cursorX( unsigned int frame )
+{
+    return (frame % 1000) / 1000.0f;
+}
+
+/**
+ * A frame as TuioServer writes it: source, alive, set messages and fseq.
+ */
+static void writeFrame( osc::OutboundPacketStream & packet, unsigned int frame, int cursors )
+{
+    packet.Clear();
+    packet << osc::BeginBundleImmediate;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "source" << "TcpFanOutBench" << osc::EndMessage;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << (osc::int32)(i + 1);
+    }
+    packet << osc::EndMessage;
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)(i + 1)
+               << cursorX( frame ) << 0.5f << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+    }
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)(frame + 1) << osc::EndMessage;
+    packet << osc::EndBundle;
+}
+
+static bool waitForClients( TcpSender & sender, int count )
+{
+    for( int i = 0; i < 500 && sender.getClientCount() != count; ++i ) {
+        usleep( 10000 );
+    }
+    return sender.getClientCount() == count;
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int frames = argc > 1 ? (unsigned int)atoi( argv[1] ) : 2000,
+                 consumers = argc > 2 ? (unsigned int)atoi( argv[2] ) : DEFAULT_CONSUMERS;
+
+    if( frames == 0 || consumers == 0 ) {
+        fprintf( stderr, "usage: %s [frames] [consumers]\n", argv[0] );
+        return 2;
+    }
+    TcpSender sender( 0 );
+    std::vector<CountingListener *> listeners;
+    std::vector<TuioClient *> clients;
+
+    for( unsigned int i = 0; i < consumers; ++i ) {
+        listeners.push_back( new CountingListener() );
+        clients.push_back( new TuioClient( new TcpReceiver( "127.0.0.1", sender.getPort() ) ) );
+        clients.back()->addTuioListener( listeners.back() );
+        clients.back()->connect();
+    }
+    if( !waitForClients( sender, (int)consumers ) ) {
+        fprintf( stderr, "%d of %u clients connected\n", sender.getClientCount(), consumers );
+        return 1;
+    }
+    char buffer[MAX_TCP_SIZE];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    double sendTime = 0.0;
+
+    for( unsigned int f = 0; f < frames; ++f ) {
+        writeFrame( packet, f, 1 );
+        double start = seconds();
+        sender.sendOscPacket( &packet );
+        sendTime += seconds() - start;
+    }
+    double deadline = seconds() + 10.0;
+    unsigned int complete = 0;
+
+    while( complete < consumers && seconds() < deadline ) {
+        complete = 0;
+
+        for( unsigned int i = 0; i < consumers; ++i ) {
+            complete += listeners[i]->frames.load() >= frames ? 1 : 0;
+        }
+        usleep( 1000 );
+    }
+    printf( "%u consumers, %u frames of %u bytes: %.1f us/frame, %.2f us/frame/consumer, %u had every frame\n",
+            consumers, frames, (unsigned int)packet.Size() + 4, sendTime * 1e6 / frames,
+            sendTime * 1e6 / frames / consumers, complete );
+
+    // The TuioClients' receiving threads stop when the sender closes the
+    // connections; the clients are left for the process exit to clean up.
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*******************************************************************************
+TcpFanOutCheck
+
+PURPOSE: Checks that one TcpSender gets every TUIO/TCP frame to many
+         TuioClients on localhost, and that a client that stops reading is
+         disconnected without holding up the others.
+
+NOTES:
+CONSUMERS TuioClients, each with its own TcpReceiver, connect to a
+TcpSender listening on a free port, and FRAMES frames with one moving
+cursor are sent.  Each client counts its refresh() calls (one per fseq
+message) and remembers the last position of the cursor; all of them must
+get every frame and end at the last position sent, and none may be
+evicted.
+
+A second TcpSender then serves one client that reads everything and one
+with a small receive buffer that reads nothing.  Large frames are sent until
+the stalled client falls MAX_BACKLOG_BYTES behind; it must be disconnected
+while the reading client still gets every frame.
+
+TcpFanOutBench measures the sending.
+
+Usage: TcpFanOutCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TcpReceiver.h"
+#include "TcpSender.h"
+#include "TuioClient.h"
+#include "TuioListener.h"
+#include <unistd.h>
+#include <atomic>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <thread>
+#include <vector>
+
+using namespace TUIO;
+
+static const unsigned int CONSUMERS = 16,
+                          FRAMES = 500;
+static const int LARGE_FRAME_CURSORS = 1000;
+
+/**
+ * Counts the frames a TuioClient delivers.
+ */
+class CountingListener : public TuioListener
+{
+public:
+    CountingListener() : frames( 0 ), lastX( -1.0f ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioCursor( TuioCursor *tcur ) { lastX.store( tcur->getX() ); }
+    void updateTuioCursor( TuioCursor *tcur ) { lastX.store( tcur->getX() ); }
+    void removeTuioCursor( TuioCursor * ) {}
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+    void refresh( TuioTime ) { frames.fetch_add( 1 ); }
+
+    std::atomic<unsigned long> frames;
+    std::atomic<float> lastX;
+};
+
+static float cursorX( unsigned int frame )
+{
+    return (frame % 1000) / 1000.0f;
+}
+
+/**
+ * A frame as TuioServer writes it: source, alive, set messages and fseq.
+ */
+static void writeFrame( osc::OutboundPacketStream & packet, unsigned int frame, int cursors )
+{
+    packet.Clear();
+    packet << osc::BeginBundleImmediate;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "source" << "TcpFanOutCheck" << osc::EndMessage;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << (osc::int32)(i + 1);
+    }
+    packet << osc::EndMessage;
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)(i + 1)
+               << cursorX( frame ) << 0.5f << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+    }
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)(frame + 1) << osc::EndMessage;
+    packet << osc::EndBundle;
+}
+
+static bool waitForClients( TcpSender & sender, int count )
+{
+    for( int i = 0; i < 500 && sender.getClientCount() != count; ++i ) {
+        usleep( 10000 );
+    }
+    return sender.getClientCount() == count;
+}
+
+static void checkConsumers()
+{
+    TcpSender sender( 0 );
+    std::vector<CountingListener *> listeners;
+    std::vector<TuioClient *> clients;
+
+    for( unsigned int i = 0; i < CONSUMERS; ++i ) {
+        listeners.push_back( new CountingListener() );
+        clients.push_back( new TuioClient( new TcpReceiver( "127.0.0.1", sender.getPort() ) ) );
+        clients.back()->addTuioListener( listeners.back() );
+        clients.back()->connect();
+    }
+    if( !waitForClients( sender, (int)CONSUMERS ) ) {
+        fprintf( stderr, "%d of %u clients connected\n", sender.getClientCount(), CONSUMERS );
+        ++errors;
+        return;
+    }
+    char buffer[MAX_TCP_SIZE];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+
+    for( unsigned int f = 0; f < FRAMES; ++f ) {
+        writeFrame( packet, f, 1 );
+        sender.sendOscPacket( &packet );
+    }
+    double deadline = seconds() + 10.0;
+    unsigned int complete = 0;
+
+    while( complete < CONSUMERS && seconds() < deadline ) {
+        complete = 0;
+
+        for( unsigned int i = 0; i < CONSUMERS; ++i ) {
+            complete += listeners[i]->frames.load() >= FRAMES ? 1 : 0;
+        }
+        usleep( 1000 );
+    }
+    for( unsigned int i = 0; i < CONSUMERS; ++i ) {
+        if( listeners[i]->frames.load() != FRAMES || listeners[i]->lastX.load() != cursorX( FRAMES - 1 ) ) {
+            fprintf( stderr, "consumer %u: %lu of %u frames, last x %f\n", i,
+                     listeners[i]->frames.load(), FRAMES, listeners[i]->lastX.load() );
+            ++errors;
+        }
+    }
+    expect( "consumers: none evicted", sender.getEvictedCount() == 0 );
+
+    // The TuioClients' receiving threads stop when the sender closes the
+    // connections; the clients are left for the process exit to clean up.
+}
+
+static int connectRaw( int port, int receiveBuffer )
+{
+    int s = ::socket( AF_INET, SOCK_STREAM, 0 );
+
+    if( receiveBuffer > 0 ) {
+        setsockopt( s, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof( receiveBuffer ) );
+    }
+    struct sockaddr_in address = sockaddr_in();
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = htons( (unsigned short)port );
+
+    if( connect( s, (struct sockaddr *)&address, sizeof( address ) ) != 0 ) {
+        close( s );
+        return -1;
+    }
+    return s;
+}
+
+/**
+ * Reads length-prefixed packets until the connection closes.
+ */
+static void countPackets( int s, std::atomic<unsigned long> * packets )
+{
+    std::vector<char> buffer( MAX_TCP_SIZE + 4 );
+    size_t filled = 0;
+
+    for( ;; ) {
+        long n = (long)recv( s, &buffer[filled], buffer.size() - filled, 0 );
+
+        if( n <= 0 ) {
+            return;
+        }
+        filled += (size_t)n;
+        size_t start = 0;
+
+        while( filled - start >= 4 ) {
+            const unsigned char * header = (const unsigned char *)&buffer[start];
+            size_t size = ((size_t)header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+
+            if( filled - start < size + 4 ) {
+                break;
+            }
+            start += size + 4;
+            packets->fetch_add( 1 );
+        }
+        memmove( &buffer[0], &buffer[start], filled - start );
+        filled -= start;
+    }
+}
+
+static void checkEviction()
+{
+    TcpSender sender( 0 );
+    std::atomic<unsigned long> packets( 0 );
+    int reading = connectRaw( sender.getPort(), 0 ),
+        stalled = connectRaw( sender.getPort(), 4096 );
+
+    if( reading < 0 || stalled < 0 || !waitForClients( sender, 2 ) ) {
+        expect( "eviction: clients connected", false );
+        return;
+    }
+    std::thread reader( countPackets, reading, &packets );
+    char buffer[MAX_TCP_SIZE];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    writeFrame( packet, 0, LARGE_FRAME_CURSORS );
+    unsigned long sent = 0;
+    double maxSend = 0.0;
+
+    for( ; sent < 5000 && sender.getEvictedCount() == 0; ++sent ) {
+        double start = seconds();
+        sender.sendOscPacket( &packet );
+        double elapsed = seconds() - start;
+        maxSend = elapsed > maxSend ? elapsed : maxSend;
+
+        while( packets.load() + 8 < sent ) { // the reading client keeps up
+            std::this_thread::yield();
+        }
+    }
+    double deadline = seconds() + 5.0;
+
+    while( (packets.load() < sent || sender.getClientCount() != 1) && seconds() < deadline ) {
+        usleep( 1000 );
+    }
+    printf( "stalled consumer evicted after %lu frames of %u bytes, longest send %.3f ms, "
+            "reading consumer got %lu\n", sent, (unsigned int)packet.Size() + 4, maxSend * 1e3, packets.load() );
+
+    expect( "eviction: stalled consumer evicted", sender.getEvictedCount() == 1 && sender.getClientCount() == 1 );
+    expect( "eviction: reading consumer got every frame", packets.load() == sent );
+    shutdown( reading, SHUT_RDWR );
+    reader.join();
+    close( reading );
+    close( stalled );
+}
+
+int main( int argc, char * argv[] )
+{
+    checkConsumers();
+    checkEviction();
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
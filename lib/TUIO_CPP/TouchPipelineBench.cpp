@@ -0,0 +1,135 @@
+/*******************************************************************************
+TouchPipelineBench
+
+PURPOSE: Measures how many synthetic pointer events per second TouchPipeline
+         turns into TUIO frames.
+
+NOTES:
+The measurement puts FINGERS fingers down, moves all of them every input
+frame, lifts and puts each down again every so often, and commits a frame
+after each input frame.  Bundles go to a sink OscSender that only counts
+them; the UDP and Flash XML channels are turned off.  It runs once with the
+server driven from the calling thread and once with the output thread
+started.  Heap allocations are counted as BenchSupport.h does.  With the
+output thread, events come in far faster than any touch screen sends them,
+so the output thread falls behind and cursor updates are folded into the
+ones still waiting, as they are meant to be; frames that lost all their
+updates send no packet.
+
+TouchPipelineCheck checks what the pipeline sends, and prints what the idle
+expiry and the dead band cost and save.
+
+Usage: TouchPipelineBench [events] [fingers]
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "TouchPipeline.h"
+#include "TuioCursorOutputThread.h"
+#include "TuioCursorServer.h"
+
+using namespace TUIO;
+
+static PointerEvent pointerEvent( int type, unsigned int id, int x, int y )
+{
+    PointerEvent event;
+    event.id = id;
+    event.type = type;
+    event.pointerType = POINTER_INPUT_TOUCH;
+    event.x = x;
+    event.y = y;
+    event.timestamp = 0;
+    return event;
+}
+
+struct LoadResult
+{
+    unsigned long events,
+                  frames,
+                  dropped;
+    double seconds;
+    unsigned long long allocations;
+};
+
+/**
+ * The pipeline, and with it the output thread, is gone when this returns,
+ * so everything queued has been sent.
+ */
+static LoadResult runLoad( TuioCursorServer & server, bool outputThread,
+                           unsigned long events, unsigned int fingers )
+{
+    TouchPipeline pipeline( &server );
+    pipeline.setScreenDimensions( 0, 0, 1920, 1080 );
+
+    if( outputThread && !pipeline.startOutputThread( TuioCursorOutputThread::ANY_CPU, 0 ) ) {
+        fprintf( stderr, "output thread did not start\n" );
+    }
+    LoadResult result = LoadResult();
+    unsigned long long allocationsBefore = heapAllocations;
+    double start = seconds();
+
+    while( result.events < events ) {
+        ++result.frames;
+
+        for( unsigned int i = 0; i < fingers; ++i ) {
+            unsigned int id = 1000 + i * 7919;
+            int x = (int)(100 + 150 * i + result.frames % 100),
+                y = (int)(200 + result.frames % 300);
+
+            if( (result.frames + 13 * i) % 120 == 0 ) { // lifted and put down again
+                pipeline.process( pointerEvent( POINTER_UP, id, x, y ) );
+                pipeline.process( pointerEvent( POINTER_DOWN, id, x, y ) );
+                result.events += 2;
+            }
+            else {
+                pipeline.process( pointerEvent( POINTER_UPDATE, id, x, y ) );
+                ++result.events;
+            }
+        }
+        pipeline.commitFrame();
+    }
+    result.seconds = seconds() - start;
+    result.allocations = heapAllocations - allocationsBefore;
+
+    for( unsigned int i = 0; i < fingers; ++i ) {
+        pipeline.process( pointerEvent( POINTER_UP, 1000 + i * 7919, 0, 0 ) );
+    }
+    pipeline.commitFrame();
+    result.dropped = pipeline.outputThread().droppedCount();
+    return result;
+}
+
+static void printLoad( const char * name, const LoadResult & result, unsigned long long packets )
+{
+    printf( "%-8s %10lu events %9lu frames %12.0f events/s %8.1f ns/event %6.2f allocs/event %9llu packets %8lu updates folded\n",
+            name, result.events, result.frames, result.events / result.seconds,
+            result.seconds * 1e9 / result.events, (double)result.allocations / result.events,
+            packets, result.dropped );
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned long events = argc > 1 ? strtoul( argv[1], NULL, 10 ) : 5000000;
+    unsigned int fingers = argc > 2 ? (unsigned int)atoi( argv[2] ) : 10;
+
+    if( events == 0 || fingers == 0 ) {
+        fprintf( stderr, "usage: %s [events] [fingers]\n", argv[0] );
+        return 2;
+    }
+    SinkSender sink;
+    TuioCursorServer server;
+    server.useFirstUdpSender( false );
+    server.useSecondUdpSender( false );
+    server.useFlashXmlTcpSender( false );
+    server.addOscSender( &sink );
+
+    unsigned long long packets = sink.packets;
+    LoadResult direct = runLoad( server, false, events, fingers );
+    printLoad( "direct", direct, sink.packets - packets );
+
+    packets = sink.packets;
+    LoadResult threaded = runLoad( server, true, events, fingers );
+    printLoad( "thread", threaded, sink.packets - packets );
+    return 0;
+}
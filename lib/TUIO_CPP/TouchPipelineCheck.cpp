@@ -0,0 +1,685 @@
+/*******************************************************************************
+TouchPipelineCheck
+
+PURPOSE: Checks what TouchPipeline sends for the pointer event sequences it
+         has to get right.
+
+NOTES:
+The checks attach a TuioListener to the TuioCursorServer and compare the
+add/update/remove/refresh calls it sees with what is expected for: a tap
+that goes down and up before its frame is sent, moves coalesced into the
+last position, a move in the frame that added the cursor, a pointer-up
+after a waiting move, an update whose pointer-down was lost, a pointer-up
+that was lost (the cursor is expired), and the side-by-side screen scaling.
+The pipeline's clock is a counter advanced by the checks, so frame times
+are exact.  The same counter then becomes TuioTime's clock to check frames
+stamped with event timestamps: the frame time, that frame times still go up
+when a timestamp is not newer than the last frame, the speeds and the
+measured latency.
+
+The idle expiry is checked on the same counter: a single-shot timer is
+simulated that is armed for nextExpiryTime() whenever it is not running and
+a cursor is down, as TouchMessageListener does.  For several expiry
+precisions the timer must not wake up with no finger down, must wake up
+less often than the old 100 ms poll with FINGERS fingers moving at 120
+input frames per second, and must remove a cursor whose pointer-up was lost
+within the precision of the maximum idle time.  The wakeups per second and
+how long that cursor stayed are printed; polling every 100 ms took 10
+wakeups per second in every case and kept it for 300 to 400 ms.
+
+The dead band checks: an update within the dead band sends nothing and
+opens no frame, one beyond it is sent, a held position is sent once it
+settles (from expireIdleCursors()) and is then not sent again, a finger
+that keeps sending its position is not expired, a pointer-up sends the held
+position first, and quantized positions are rounded to the grid.  Then
+FINGERS fingers resting with a pixel of jitter, and FINGERS fingers moving
+5 pixels an event, send 250 events a second each for DEAD_BAND_SECONDS
+seconds of the counter, with the filter off and on.  The cursor updates,
+packets and bytes are printed; with a dead band each resting finger is sent
+at most once a settle time, and no moving finger is held back.
+
+The backlog checks hold up the output thread in its first refresh().  First
+eight cursors go down and up, one per frame, until the backlog has been
+collapsed several times; once the thread is let go, the server must have
+exactly the cursors still down at their last positions, with no record
+dropped and every cursor it was sent removed again.  Then a cursor that was
+down before the stall, and one put down during it, are moved while the
+backlog grows and then rest, sending nothing more; the server must end up
+with both at the positions they were last moved to.
+
+TouchPipelineBench measures the throughput.
+
+Usage: TouchPipelineCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TouchPipeline.h"
+#include "TuioCursorOutputThread.h"
+#include "TuioCursorServer.h"
+#include "TuioListener.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace TUIO;
+
+static const unsigned int FINGERS = 10;
+static const int EXPIRY_SECONDS = 5,
+                 DEAD_BAND_SECONDS = 10;
+
+/**
+ * Writes down every cursor callback as "a0.50,0.25 " (add), "u..." (update),
+ * "r..." (remove) and "| " (frame committed).
+ */
+class CallLog : public TuioListener
+{
+public:
+    CallLog() : speed( 0.0f ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+
+    void addTuioCursor( TuioCursor * tcur ) { append( 'a', tcur ); }
+    void updateTuioCursor( TuioCursor * tcur ) { append( 'u', tcur ); }
+    void removeTuioCursor( TuioCursor * tcur ) { append( 'r', tcur ); }
+    void refresh( TuioTime ) { calls += "| "; }
+
+    std::string take()
+    {
+        std::string s = calls;
+        calls.clear();
+        return s;
+    }
+
+    std::string calls;
+    float speed;        // of the last cursor called back
+
+private:
+    void append( char call, TuioCursor * tcur )
+    {
+        speed = tcur->getMotionSpeed();
+        char buffer[32];
+        snprintf( buffer, sizeof( buffer ), "%c%.2f,%.2f ", call, tcur->getX(), tcur->getY() );
+        calls += buffer;
+    }
+};
+
+static long clockMicroSeconds = 1000000;
+
+static TuioTime testClock()
+{
+    return TuioTime( clockMicroSeconds / 1000000, clockMicroSeconds % 1000000 );
+}
+
+static void advanceClock( long milliseconds )
+{
+    clockMicroSeconds += milliseconds * 1000;
+}
+
+static int64_t testNanoseconds()
+{
+    return (int64_t)clockMicroSeconds * 1000;
+}
+
+static PointerEvent pointerEvent( int type, unsigned int id, int x, int y )
+{
+    PointerEvent event;
+    event.id = id;
+    event.type = type;
+    event.pointerType = POINTER_INPUT_TOUCH;
+    event.x = x;
+    event.y = y;
+    event.timestamp = 0;
+    return event;
+}
+
+/**
+ * The screen is 1000 x 1000 pixels, so x = 250 is 0.25.
+ */
+static void runChecks( TuioCursorServer & server )
+{
+    CallLog log;
+    server.addTuioListener( &log );
+
+    TouchPipeline pipeline( &server );
+    pipeline.setScreenDimensions( 0, 0, 1000, 1000 );
+    pipeline.setClock( &testClock );
+
+    advanceClock( 10 );
+    expect( "tap: process", pipeline.process( pointerEvent( POINTER_DOWN, 1, 250, 500 ) ) );
+    pipeline.process( pointerEvent( POINTER_UP, 1, 250, 500 ) );
+    pipeline.commitFrame();
+    expect( "tap", log.take(), "a0.25,0.50 | r0.25,0.50 | " );
+    expect( "tap: no cursors", pipeline.cursorCount() == 0 );
+
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_DOWN, 2, 100, 100 ) );
+    pipeline.commitFrame();
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 2, 200, 200 ) );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 2, 300, 300 ) );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 2, 400, 400 ) );
+    expect( "coalesce: nothing sent yet", log.take(), "a0.10,0.10 | " );
+    pipeline.commitFrame();
+    expect( "coalesce", log.take(), "u0.40,0.40 | " );
+
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_DOWN, 3, 500, 500 ) );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 3, 600, 600 ) );
+    pipeline.commitFrame();
+    expect( "move in add frame: held back", log.take(), "a0.50,0.50 | " );
+    expect( "move in add frame: pending", pipeline.hasPendingMoves() );
+    advanceClock( 1 );
+    pipeline.commitFrame();
+    expect( "move in add frame: next frame", log.take(), "u0.60,0.60 | " );
+
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 2, 700, 700 ) );
+    pipeline.process( pointerEvent( POINTER_UP, 2, 700, 700 ) );
+    pipeline.commitFrame();
+    expect( "up after move", log.take(), "u0.70,0.70 | r0.70,0.70 | " );
+
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 4, 800, 800 ) );
+    pipeline.commitFrame();
+    expect( "lost down", log.take(), "a0.80,0.80 | " );
+    expect( "lost up: ignored", !pipeline.process( pointerEvent( POINTER_UP, 99, 0, 0 ) ) );
+
+    advanceClock( 200 );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 3, 650, 650 ) );
+    pipeline.commitFrame();
+    log.take();
+    expect( "lost up: not yet", pipeline.expireIdleCursors( testClock() ) == 0 );
+    advanceClock( 200 );
+    expect( "lost up: expired", pipeline.expireIdleCursors( testClock() ) == 1 );
+    pipeline.commitFrame();
+    expect( "lost up", log.take(), "r0.80,0.80 | " );
+    expect( "lost up: one left", pipeline.cursorCount() == 1 );
+
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_UP, 3, 650, 650 ) );
+    pipeline.commitFrame();
+    log.take();
+    expect( "counts", pipeline.eventCount() == 13 && pipeline.frameCount() == 12 );
+
+    pipeline.setScreenDimensions( 1000, 0, 1000, 1000 );
+    pipeline.setMirroredMonitors( false );
+    expect( "side by side", pipeline.scaledX( 1500 ) == 0.75f && pipeline.scaledY( 250 ) == 0.25f );
+
+    server.removeTuioListener( &log );
+}
+
+/**
+ * Blocks the thread that calls refresh() until it is opened.
+ */
+class GatedLog : public CallLog
+{
+public:
+    GatedLog() : open( false ), entered( false ) {}
+
+    void refresh( TuioTime ttime )
+    {
+        entered = true;
+
+        while( !open ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+        CallLog::refresh( ttime );
+    }
+
+    std::atomic<bool> open,
+                      entered;
+};
+
+static void runBacklogChecks( TuioCursorServer & server )
+{
+    const unsigned int IDS = 8,
+                       FIRST_ID = 5000,
+                       FRAMES = 4 * TuioCursorOutputThread::MAX_BACKLOG_SIZE + 3;
+    GatedLog log;
+    server.addTuioListener( &log );
+    bool down[IDS] = {};
+    float lastX[IDS] = {};
+    unsigned int collapses = 0,
+                 dropped = 0;
+    {
+        TuioCursorOutputThread output( &server );
+
+        if( !output.start() ) {
+            fprintf( stderr, "output thread did not start\n" );
+            ++errors;
+        }
+        for( unsigned int frame = 0; frame < FRAMES; ++frame ) {
+            unsigned int i = frame % IDS;
+            output.initFrame( TuioTime::getSessionTime() );
+
+            if( down[i] ) {
+                output.removeTuioCursor( FIRST_ID + i );
+            }
+            else {
+                lastX[i] = (frame % 1000) / 1000.0f;
+                output.addTuioCursor( FIRST_ID + i, lastX[i], 0.5f );
+            }
+            down[i] = !down[i];
+            output.commitFrame();
+        }
+        collapses = output.backlogCollapses();
+        log.open = true;
+        output.stop();
+        dropped = output.droppedCount();
+    }
+    std::string calls = log.take();
+    bool sameCursors = true;
+
+    for( unsigned int i = 0; i < IDS; ++i ) {
+        TuioCursor * tcur = server.getTuioCursorFromMap( FIRST_ID + i );
+
+        if( (tcur != NULL) != down[i] || (tcur != NULL && tcur->getX() != lastX[i]) ) {
+            sameCursors = false;
+        }
+    }
+    long stillDown = std::count( down, down + IDS, true );
+    expect( "backlog: collapsed", collapses > 0 );
+    expect( "backlog: nothing dropped", dropped == 0 );
+    expect( "backlog: same cursors", sameCursors );
+    expect( "backlog: adds and removes pair up", stillDown > 0
+            && std::count( calls.begin(), calls.end(), 'a' ) - std::count( calls.begin(), calls.end(), 'r' ) == stillDown );
+
+    server.initFrame( TuioTime::getSessionTime() );
+
+    for( unsigned int i = 0; i < IDS; ++i ) {
+        server.removeTuioCursor( (int)(FIRST_ID + i) );
+    }
+    server.commitFrame();
+    server.removeTuioListener( &log );
+}
+
+/**
+ * Cursor FIRST_ID is down before the output thread is held up and FIRST_ID
+ * + 1 goes down in the first frame of the stall.  Both move every frame
+ * while the backlog is collapsed several times, then rest.
+ */
+static void runRestingChecks( TuioCursorServer & server )
+{
+    const unsigned int FIRST_ID = 6000,
+                       FRAMES = 2 * TuioCursorOutputThread::MAX_BACKLOG_SIZE;
+    GatedLog log;
+    server.addTuioListener( &log );
+    float lastX = 0.0f;
+    long sessionId = -1;
+    unsigned int collapses = 0;
+    {
+        TuioCursorOutputThread output( &server );
+
+        if( !output.start() ) {
+            fprintf( stderr, "output thread did not start\n" );
+            ++errors;
+        }
+        output.initFrame( TuioTime::getSessionTime() );
+        output.addTuioCursor( FIRST_ID, 0.1f, 0.5f );
+        output.commitFrame();
+
+        while( !log.entered ) {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+        TuioCursor * tcur = server.getTuioCursorFromMap( FIRST_ID );
+        sessionId = tcur != NULL ? tcur->getSessionID() : -1;
+
+        for( unsigned int frame = 0; frame < FRAMES; ++frame ) {
+            lastX = (frame % 1000) / 1000.0f;
+            output.initFrame( TuioTime::getSessionTime() );
+            output.updateTuioCursor( FIRST_ID, lastX, 0.5f );
+
+            if( frame == 0 ) {
+                output.addTuioCursor( FIRST_ID + 1, lastX, 0.25f );
+            }
+            else {
+                output.updateTuioCursor( FIRST_ID + 1, lastX, 0.25f );
+            }
+            output.commitFrame();
+        }
+        collapses = output.backlogCollapses();
+        log.open = true;
+        output.stop();
+    }
+    TuioCursor * before = server.getTuioCursorFromMap( FIRST_ID ),
+               * during = server.getTuioCursorFromMap( FIRST_ID + 1 );
+    expect( "resting: collapsed", collapses > 1 );
+    expect( "resting: down before, last position", before != NULL && before->getX() == lastX
+                                                   && before->getY() == 0.5f );
+    expect( "resting: down before, same session", before != NULL && before->getSessionID() == sessionId );
+    expect( "resting: put down, last position", during != NULL && during->getX() == lastX
+                                                && during->getY() == 0.25f );
+
+    server.initFrame( TuioTime::getSessionTime() );
+    server.removeTuioCursor( (int)FIRST_ID );
+    server.removeTuioCursor( (int)(FIRST_ID + 1) );
+    server.commitFrame();
+    server.removeTuioListener( &log );
+}
+
+/**
+ * The event timestamps are in microseconds of the counter.
+ */
+static void runTimestampChecks( TuioCursorServer & server )
+{
+    CallLog log;
+    server.addTuioListener( &log );
+    TuioTime::setClock( &testNanoseconds );
+    TuioTime::initSession();
+    long start = clockMicroSeconds;
+
+    TouchPipeline pipeline( &server );
+    pipeline.setScreenDimensions( 0, 0, 1000, 1000 );
+    pipeline.setTimestampFrequency( 1000000 );
+
+    advanceClock( 10 );
+    PointerEvent event = pointerEvent( POINTER_DOWN, 1, 100, 100 );
+    event.timestamp = clockMicroSeconds - 4000;
+    pipeline.process( event );
+    pipeline.commitFrame();
+    int64_t firstFrame = clockMicroSeconds - 4000 - start;
+    expect( "timestamp: frame time", pipeline.frameTime().getTotalMicroseconds() == firstFrame );
+
+    advanceClock( 10 );
+    event = pointerEvent( POINTER_UPDATE, 1, 200, 100 );
+    event.timestamp = clockMicroSeconds - 4000;
+    pipeline.process( event );
+    pipeline.commitFrame();
+    expect( "timestamp: speed", log.take() == "a0.10,0.10 | u0.20,0.10 | " && fabs( log.speed - 10.0f ) < 0.01f );
+
+    event.x = 300;
+    pipeline.process( event ); // the same timestamp as the last frame
+    pipeline.commitFrame();
+    expect( "timestamp: frame times go up", pipeline.frameTime().getTotalMicroseconds() == firstFrame + 10001 );
+    expect( "timestamp: finite speed", log.take() == "u0.30,0.10 | " && std::isfinite( log.speed ) );
+
+    TouchPipeline::LatencyStats latency = pipeline.takeLatencyStats();
+    expect( "timestamp: latency", latency.frames == 3 && latency.maxMicroseconds == 4000
+                                  && latency.totalMicroseconds == 4000 + 4000 + 3999 );
+
+    pipeline.process( pointerEvent( POINTER_UP, 1, 300, 100 ) );
+    pipeline.commitFrame();
+    log.take();
+    expect( "timestamp: none, clock", pipeline.frameTime().getTotalMicroseconds() == clockMicroSeconds - start
+                                      && pipeline.takeLatencyStats().frames == 0 );
+
+    TuioCursor cursor( TuioTime( 1, 0 ), 1, 1, 0.1f, 0.1f );
+    cursor.update( TuioTime( 1, 0 ), 0.2f, 0.2f );
+    expect( "same time update: finite speed", std::isfinite( cursor.getXSpeed() ) && std::isfinite( cursor.getMotionAccel() ) );
+
+    TuioTime::setClock( NULL );
+    TuioTime::initSession();
+    server.removeTuioListener( &log );
+}
+
+/**
+ * Advances the clock by a millisecond and fires the simulated timer if it
+ * is due.
+ *
+ * @return true if the timer fired.
+ */
+static bool tick( TouchPipeline & pipeline, long & timerAt )
+{
+    advanceClock( 1 );
+
+    if( timerAt < 0 || testClock().getTotalMilliseconds() < timerAt ) {
+        return false;
+    }
+    if( pipeline.expireIdleCursors( testClock() ) > 0 ) {
+        pipeline.commitFrame();
+    }
+    timerAt = pipeline.nextExpiryTime();
+    return true;
+}
+
+/**
+ * Runs the given seconds of of input frames (every 8 ms) from the given fingers,
+ * each lifted and put down again about once a second.
+ *
+ * @return the timer wakeups per second.
+ */
+static double simulateExpiry( TouchPipeline & pipeline, long & timerAt, unsigned int fingers, int seconds )
+{
+    unsigned long wakeups = 0;
+
+    for( long ms = 0; ms < seconds * 1000L; ++ms ) {
+        wakeups += tick( pipeline, timerAt ) ? 1 : 0;
+
+        if( fingers > 0 && ms % 8 == 0 ) {
+            for( unsigned int i = 0; i < fingers; ++i ) {
+                int x = (int)(100 + 80 * i + ms % 50);
+                bool lifted = (ms / 8 + 13 * i) % 120 == 0;
+                pipeline.process( pointerEvent( lifted ? POINTER_UP : POINTER_UPDATE, 1000 + i, x, 500 ) );
+            }
+            pipeline.commitFrame();
+
+            if( timerAt < 0 ) {
+                timerAt = pipeline.nextExpiryTime();
+            }
+        }
+        if( pipeline.cursorCount() == 0 ) {
+            timerAt = -1;
+        }
+    }
+    return (double)wakeups / seconds;
+}
+
+static void checkExpiry( TuioCursorServer & server, unsigned int fingers, unsigned int precision )
+{
+    TouchPipeline pipeline( &server );
+    pipeline.setScreenDimensions( 0, 0, 1920, 1080 );
+    pipeline.setClock( &testClock );
+    pipeline.setExpiryPrecision( precision );
+    long timerAt = -1;
+
+    double idle = simulateExpiry( pipeline, timerAt, 0, EXPIRY_SECONDS ),
+           load = simulateExpiry( pipeline, timerAt, fingers, EXPIRY_SECONDS );
+
+    advanceClock( 1 );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 1000, 100, 500 ) );
+
+    for( unsigned int i = 1; i < fingers; ++i ) { // the pointer-up of finger 0 is lost
+        pipeline.process( pointerEvent( POINTER_UP, 1000 + i, 0, 0 ) );
+    }
+    pipeline.commitFrame();
+    long lastChange = testClock().getTotalMilliseconds(),
+         ghostTime = 0;
+
+    while( pipeline.cursorCount() > 0 && ghostTime < 2000 ) {
+        tick( pipeline, timerAt );
+        ghostTime = testClock().getTotalMilliseconds() - lastChange;
+    }
+    printf( "expiry precision %3u ms: %5.1f wakeups/s idle, %5.1f wakeups/s with %u fingers, lost-up cursor removed after %ld ms\n",
+            precision, idle, load, fingers, ghostTime );
+
+    expect( "expiry: idle", idle == 0.0 );
+    expect( "expiry: fewer wakeups than polling", load < 10.0 );
+    expect( "expiry: on time", ghostTime >= TouchPipeline::DEFAULT_MAX_IDLE_TIME
+                            && ghostTime <= TouchPipeline::DEFAULT_MAX_IDLE_TIME + (long)precision );
+}
+
+/**
+ * The screen is 1000 x 1000 pixels, the dead band 3 pixels and the settle
+ * time 50 ms.
+ */
+static void runDeadBandChecks( TuioCursorServer & server )
+{
+    CallLog log;
+    server.addTuioListener( &log );
+
+    TouchPipeline pipeline( &server );
+    pipeline.setScreenDimensions( 0, 0, 1000, 1000 );
+    pipeline.setClock( &testClock );
+    pipeline.setExpiryPrecision( 1 );
+
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_DOWN, 1, 500, 500 ) );
+    pipeline.commitFrame();
+    advanceClock( 10 );
+    expect( "dead band off: same position sent", pipeline.process( pointerEvent( POINTER_UPDATE, 1, 500, 500 ) ) );
+    pipeline.commitFrame();
+    log.take();
+
+    pipeline.setDeadBand( 3.0f );
+    long heldAt = testClock().getTotalMilliseconds() + 10;
+    advanceClock( 10 );
+    expect( "dead band: held", !pipeline.process( pointerEvent( POINTER_UPDATE, 1, 502, 501 ) ) );
+    expect( "dead band: no frame", !pipeline.isFrameOpen() && pipeline.hasHeldMoves() );
+    expect( "dead band: settle time", pipeline.nextExpiryTime() == heldAt + TouchPipeline::DEFAULT_SETTLE_TIME );
+    advanceClock( 10 );
+    expect( "dead band: held again", !pipeline.process( pointerEvent( POINTER_UPDATE, 1, 501, 501 ) ) );
+    pipeline.commitFrame();
+    expect( "dead band: nothing sent", log.take(), "" );
+
+    advanceClock( 40 );
+    expect( "settle: due", pipeline.nextExpiryTime() <= testClock().getTotalMilliseconds()
+                           && pipeline.expireIdleCursors( testClock() ) == 1 );
+    pipeline.commitFrame();
+    expect( "settle: latest held position sent", log.take(), "u0.50,0.50 | " );
+    advanceClock( 10 );
+    expect( "dead band: beyond sent", pipeline.process( pointerEvent( POINTER_UPDATE, 1, 520, 501 ) ) );
+    pipeline.commitFrame();
+    expect( "dead band: beyond", log.take(), "u0.52,0.50 | " );
+
+    // The position stays, so only the speed is sent once it settles, and
+    // after that nothing.
+    advanceClock( 10 );
+    expect( "standing: held", !pipeline.process( pointerEvent( POINTER_UPDATE, 1, 520, 501 ) ) );
+    advanceClock( 60 );
+    pipeline.expireIdleCursors( testClock() );
+    pipeline.commitFrame();
+    expect( "standing: speed sent", log.take() == "u0.52,0.50 | " && log.speed == 0.0f );
+
+    for( int i = 0; i < 100; ++i ) {
+        advanceClock( 10 );
+        pipeline.process( pointerEvent( POINTER_UPDATE, 1, 520, 501 ) );
+
+        if( pipeline.nextExpiryTime() <= testClock().getTotalMilliseconds()
+            && pipeline.expireIdleCursors( testClock() ) > 0 ) {
+            pipeline.commitFrame();
+        }
+    }
+    expect( "standing: not expired", log.take() == "" && pipeline.cursorCount() == 1 );
+
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 1, 522, 501 ) );
+    pipeline.process( pointerEvent( POINTER_UP, 1, 522, 501 ) );
+    pipeline.commitFrame();
+    expect( "up: held position first", log.take(), "u0.52,0.50 | r0.52,0.50 | " );
+
+    pipeline.setDeadBand( 0.0f );
+    pipeline.setQuantization( 100 );
+    unsigned long suppressed = pipeline.suppressedCount(),
+                  settled = pipeline.settledCount();
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_DOWN, 2, 503, 498 ) );
+    pipeline.commitFrame();
+    advanceClock( 10 );
+    expect( "quantization: same cell held", !pipeline.process( pointerEvent( POINTER_UPDATE, 2, 504, 501 ) ) );
+    advanceClock( 10 );
+    pipeline.process( pointerEvent( POINTER_UPDATE, 2, 507, 501 ) );
+    pipeline.process( pointerEvent( POINTER_UP, 2, 507, 501 ) );
+    pipeline.commitFrame();
+    expect( "quantization", log.take(), "a0.50,0.50 | u0.51,0.50 | r0.51,0.50 | " );
+    expect( "suppressed counts", pipeline.suppressedCount() == suppressed + 1 && pipeline.settledCount() == settled );
+
+    server.removeTuioListener( &log );
+}
+
+/**
+ * The given fingers at 250 events a second each, committed after every
+ * input frame, with the expiry timer simulated as in tick().
+ */
+static void checkDeadBandLoad( TuioCursorServer & server, SinkSender & sink, unsigned int fingers,
+                              bool moving, float deadBand, unsigned int quantization )
+{
+    TouchPipeline pipeline( &server );
+    pipeline.setScreenDimensions( 0, 0, 1920, 1080 );
+    pipeline.setClock( &testClock );
+    pipeline.setDeadBand( deadBand );
+    pipeline.setQuantization( quantization );
+
+    unsigned long long packets = sink.packets,
+                       bytes = sink.bytes;
+    long timerAt = -1;
+
+    for( unsigned int i = 0; i < fingers; ++i ) {
+        pipeline.process( pointerEvent( POINTER_DOWN, 2000 + i, 100 + 150 * i, 500 ) );
+    }
+    pipeline.commitFrame();
+
+    for( long ms = 0; ms < DEAD_BAND_SECONDS * 1000L; ++ms ) {
+        tick( pipeline, timerAt );
+
+        if( ms % 4 == 0 ) {
+            for( unsigned int i = 0; i < fingers; ++i ) {
+                int x = (int)(100 + 150 * i),
+                    y = 500;
+
+                if( moving ) {
+                    x += (int)((ms / 4 + 1) * 5 % 1000);
+                }
+                else {
+                    x += (int)((ms * 7919u + i * 104729u) % 3) - 1;
+                    y += (int)((ms * 104729u + i * 7919u) % 3) - 1;
+                }
+                pipeline.process( pointerEvent( POINTER_UPDATE, 2000 + i, x, y ) );
+            }
+            pipeline.commitFrame();
+            timerAt = pipeline.nextExpiryTime();
+        }
+    }
+    for( unsigned int i = 0; i < fingers; ++i ) {
+        pipeline.process( pointerEvent( POINTER_UP, 2000 + i, 0, 0 ) );
+    }
+    pipeline.commitFrame();
+    unsigned long updates = pipeline.eventCount() - 2 * fingers - pipeline.suppressedCount() + pipeline.settledCount();
+
+    printf( "%-7s dead band %3.1f px, quantization %4u: %7lu events %7lu updates sent %6llu packets %9llu bytes\n",
+            moving ? "moving" : "resting", deadBand, quantization, pipeline.eventCount(), updates,
+            sink.packets - packets, sink.bytes - bytes );
+
+    if( moving ) {
+        expect( "dead band: moving fingers all sent", deadBand <= 5.0f && pipeline.suppressedCount() == 0 );
+    }
+    else if( deadBand >= 2.0f ) {
+        expect( "dead band: resting fingers sent once a settle time", updates <= fingers * (DEAD_BAND_SECONDS * 1000 / TouchPipeline::DEFAULT_SETTLE_TIME + 1) );
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    SinkSender sink;
+    TuioCursorServer server;
+    server.useFirstUdpSender( false );
+    server.useSecondUdpSender( false );
+    server.useFlashXmlTcpSender( false );
+    server.addOscSender( &sink );
+
+    runChecks( server );
+    runTimestampChecks( server );
+    checkExpiry( server, FINGERS, 1 );
+    checkExpiry( server, FINGERS, 10 );
+    checkExpiry( server, FINGERS, 50 );
+    runDeadBandChecks( server );
+    checkDeadBandLoad( server, sink, FINGERS, false, 0.0f, 0 );
+    checkDeadBandLoad( server, sink, FINGERS, false, 3.0f, 0 );
+    checkDeadBandLoad( server, sink, FINGERS, false, 0.0f, 960 );
+    checkDeadBandLoad( server, sink, FINGERS, false, 3.0f, 960 );
+    checkDeadBandLoad( server, sink, FINGERS, true, 0.0f, 0 );
+    checkDeadBandLoad( server, sink, FINGERS, true, 3.0f, 0 );
+    runBacklogChecks( server );
+    runRestingChecks( server );
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/*******************************************************************************
+TuioClientBench
+
+PURPOSE: Measures how long TuioClient takes per /tuio/2Dcur frame with 100
+         to 1000 live cursors.
+
+NOTES:
+Frames are encoded here the way TuioServer sends them (alive, a set per
+cursor, fseq, in one bundle) and handed to the client through the
+LoopbackReceiver of BenchSupport.h.  FRAMES frames are run for each cursor
+count: once with every cursor moving, and once with a tenth of them
+replaced by new sessions each frame.  Before the session index, each set
+searched the cursor list and each fseq searched the alive list for every
+cursor, and each new session counted the cursor and free ID lists, so a
+frame took time quadratic in the cursor count.
+
+Heap allocations are counted as BenchSupport.h does; what new sessions
+still allocate (list and index entries) is printed.
+
+TuioClientCheck checks the callbacks, the cursor IDs and the allocations.
+
+Usage: TuioClientBench
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "TuioClient.h"
+#include "osc/OscOutboundPacketStream.h"
+#include <chrono>
+#include <vector>
+
+using namespace TUIO;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int FRAMES = 1000,
+                 WARM_UP_FRAMES = 20,
+                 BUFFER_SIZE = 128 * 1024;
+
+/**
+ * Encodes one /tuio/2Dcur frame of the given sessions, each at an x that
+ * depends on the frame so that every cursor moves.
+ */
+class FrameEncoder
+{
+public:
+    FrameEncoder() : buffer_( BUFFER_SIZE ), packet_( &buffer_[0], BUFFER_SIZE ), fseq_( 1000 ) {}
+
+    const osc::OutboundPacketStream & encode( const std::vector<int> & sessions, const char * source = NULL,
+                                              int fseq = -1 )
+    {
+        fseq_ = fseq >= 0 ? fseq : fseq_ + 1;
+        packet_.Clear();
+        packet_ << osc::BeginBundleImmediate;
+
+        if( source != NULL ) {
+            packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "source" << source << osc::EndMessage;
+        }
+        packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+        for( size_t i = 0; i < sessions.size(); ++i ) {
+            packet_ << (osc::int32)sessions[i];
+        }
+        packet_ << osc::EndMessage;
+
+        for( size_t i = 0; i < sessions.size(); ++i ) {
+            float x = (float)((sessions[i] * 37 + fseq_) % 1000) / 1000.0f;
+            packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)sessions[i]
+                    << x << 0.5f << 0.1f << 0.0f << 0.0f << osc::EndMessage;
+        }
+        packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)fseq_ << osc::EndMessage;
+        packet_ << osc::EndBundle;
+        return packet_;
+    }
+
+    int fseq() const { return fseq_; }
+
+private:
+    std::vector<char> buffer_;
+    osc::OutboundPacketStream packet_;
+    int fseq_;
+};
+
+static std::vector<int> sessionRange( int first, int count )
+{
+    std::vector<int> sessions;
+
+    for( int i = 0; i < count; ++i ) {
+        sessions.push_back( first + i );
+    }
+    return sessions;
+}
+
+struct Timing
+{
+    double microseconds,          // per frame
+           allocations;           // heap allocations per frame
+};
+
+static Timing timeFrames( int cursors, bool churn )
+{
+    LoopbackReceiver receiver;
+    TuioClient client( &receiver );
+    client.connect();
+    FrameEncoder encoder;
+    Clock::time_point start;
+    unsigned long long allocations = 0;
+
+    std::vector<int> sessions = sessionRange( 1, cursors );
+    int nextSession = cursors + 1;
+    receiver.send( encoder.encode( sessions ) );
+
+    for( int f = -WARM_UP_FRAMES; f < FRAMES; ++f ) {
+        if( f == 0 ) {
+            start = Clock::now();
+            allocations = heapAllocations;
+        }
+        if( churn ) {
+            for( int i = 0; i < cursors / 10; ++i ) {
+                sessions[((f + WARM_UP_FRAMES) * 7 + i * 10) % cursors] = nextSession++;
+            }
+        }
+        receiver.send( encoder.encode( sessions ) );
+    }
+    double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+    allocations = heapAllocations - allocations;
+    client.disconnect();
+
+    Timing timing;
+    timing.microseconds = seconds * 1e6 / FRAMES;
+    timing.allocations = (double)allocations / FRAMES;
+    return timing;
+}
+
+int main( int argc, char * argv[] )
+{
+    const int counts[] = { 100, 300, 1000 };
+    printf( "%d frames, microseconds per frame (encoding included):\n", FRAMES );
+    printf( "%8s %12s %12s %14s %24s\n", "cursors", "moving", "churn 10%", "ns per cursor",
+            "allocations per frame" );
+
+    for( int i = 0; i < 3; ++i ) {
+        Timing moving = timeFrames( counts[i], false ),
+               churn = timeFrames( counts[i], true );
+        printf( "%8d %12.1f %12.1f %14.1f %11.1f %12.1f\n", counts[i], moving.microseconds, churn.microseconds,
+                moving.microseconds * 1000 / counts[i], moving.allocations, churn.allocations );
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*******************************************************************************
+TuioClientCheck
+
+PURPOSE: Checks that TuioClient decodes /tuio/2Dcur frames into the right
+         add/update/remove callbacks, and keeps its cursors and IDs right
+         with many cursors coming and going.
+
+NOTES:
+Frames are encoded here the way TuioServer sends them (alive, a set per
+cursor, fseq, in one bundle) and handed to the client through the
+LoopbackReceiver of BenchSupport.h, which does no networking.  The checks:
+every cursor of a new frame is added and can be looked up by session ID,
+moves are updates, cursors left out of the alive message are removed and
+can no longer be looked up, freed cursor IDs are reused, a late frame is
+dropped, cursors of two sources with the same session IDs are kept apart,
+and unknown addresses and commands are ignored.
+
+Then FRAMES frames are run for 100 to 1000 cursors, once with every cursor
+moving, and once with a tenth of them replaced by new sessions each frame.
+With churn, the cursor IDs must stay below the cursor count plus the
+sessions replaced per frame (a frame's new sessions are added before its
+old ones are removed), as they do when the free IDs are counted right and
+reused.  Once the client's pools have grown (WARM_UP_FRAMES), frames of
+moving cursors must not allocate at all, and new sessions must not allocate
+TuioCursors.
+
+TuioClientBench measures the time per frame.
+
+Usage: TuioClientCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "TuioClient.h"
+#include "TuioListener.h"
+#include "osc/OscOutboundPacketStream.h"
+#include <algorithm>
+#include <vector>
+
+using namespace TUIO;
+
+static const int FRAMES = 100,
+                 WARM_UP_FRAMES = 20,
+                 BUFFER_SIZE = 128 * 1024;
+
+class CountingListener : public TuioListener
+{
+public:
+    CountingListener() : adds( 0 ), updates( 0 ), removes( 0 ), refreshes( 0 ), maxCursorId( -1 ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+
+    void addTuioCursor( TuioCursor * tcur )
+    {
+        ++adds;
+        maxCursorId = std::max( maxCursorId, tcur->getCursorID() );
+    }
+    void updateTuioCursor( TuioCursor * ) { ++updates; }
+    void removeTuioCursor( TuioCursor * ) { ++removes; }
+    void refresh( TuioTime ) { ++refreshes; }
+
+    void reset()
+    {
+        adds = updates = removes = refreshes = 0;
+        maxCursorId = -1;
+    }
+
+    unsigned long adds,
+                  updates,
+                  removes,
+                  refreshes;
+    int maxCursorId;
+};
+
+/**
+ * Encodes one /tuio/2Dcur frame of the given sessions, each at an x that
+ * depends on the frame so that every cursor moves.
+ */
+class FrameEncoder
+{
+public:
+    FrameEncoder() : buffer_( BUFFER_SIZE ), packet_( &buffer_[0], BUFFER_SIZE ), fseq_( 1000 ) {}
+
+    const osc::OutboundPacketStream & encode( const std::vector<int> & sessions, const char * source = NULL,
+                                              int fseq = -1 )
+    {
+        fseq_ = fseq >= 0 ? fseq : fseq_ + 1;
+        packet_.Clear();
+        packet_ << osc::BeginBundleImmediate;
+
+        if( source != NULL ) {
+            packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "source" << source << osc::EndMessage;
+        }
+        packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+        for( size_t i = 0; i < sessions.size(); ++i ) {
+            packet_ << (osc::int32)sessions[i];
+        }
+        packet_ << osc::EndMessage;
+
+        for( size_t i = 0; i < sessions.size(); ++i ) {
+            float x = (float)((sessions[i] * 37 + fseq_) % 1000) / 1000.0f;
+            packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)sessions[i]
+                    << x << 0.5f << 0.1f << 0.0f << 0.0f << osc::EndMessage;
+        }
+        packet_ << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)fseq_ << osc::EndMessage;
+        packet_ << osc::EndBundle;
+        return packet_;
+    }
+
+    int fseq() const { return fseq_; }
+
+private:
+    std::vector<char> buffer_;
+    osc::OutboundPacketStream packet_;
+    int fseq_;
+};
+
+static std::vector<int> sessionRange( int first, int count )
+{
+    std::vector<int> sessions;
+
+    for( int i = 0; i < count; ++i ) {
+        sessions.push_back( first + i );
+    }
+    return sessions;
+}
+
+static void runChecks()
+{
+    const int N = 100;
+    LoopbackReceiver receiver;
+    TuioClient client( &receiver );
+    CountingListener listener;
+    client.addTuioListener( &listener );
+    client.connect();
+    FrameEncoder encoder;
+
+    std::vector<int> sessions = sessionRange( 1000, N );
+    receiver.send( encoder.encode( sessions ) );
+    expect( "add: callbacks", listener.adds == N && listener.refreshes == 1 );
+    expect( "add: cursor IDs", listener.maxCursorId == N - 1 );
+    expect( "add: lookup", client.getTuioCursor( 1000 ) != NULL && client.getTuioCursor( 1000 + N - 1 ) != NULL
+                           && client.getTuioCursors().size() == (size_t)N );
+
+    listener.reset();
+    receiver.send( encoder.encode( sessions ) );
+    expect( "move: updates", listener.updates == N && listener.adds == 0 && listener.removes == 0 );
+    TuioCursor * tcur = client.getTuioCursor( 1005 );
+    expect( "move: position", tcur != NULL && tcur->getX() == (float)((1005 * 37 + encoder.fseq()) % 1000) / 1000.0f );
+
+    std::vector<int> even;
+
+    for( size_t i = 0; i < sessions.size(); i += 2 ) {
+        even.push_back( sessions[i] );
+    }
+    listener.reset();
+    receiver.send( encoder.encode( even ) );
+    expect( "remove: callbacks", listener.removes == N / 2 && listener.updates == N / 2 );
+    expect( "remove: lookup", client.getTuioCursor( 1001 ) == NULL && client.getTuioCursor( 1002 ) != NULL
+                              && client.getTuioCursors().size() == (size_t)N / 2 );
+
+    std::vector<int> refill = even,
+                     added = sessionRange( 5000, N / 2 );
+    refill.insert( refill.end(), added.begin(), added.end() );
+    listener.reset();
+    receiver.send( encoder.encode( refill ) );
+    expect( "reuse: cursor IDs", listener.adds == N / 2 && listener.maxCursorId <= N - 1 );
+
+    listener.reset();
+    receiver.send( encoder.encode( even, NULL, encoder.fseq() - 5 ) );
+    expect( "late frame: dropped", listener.removes == 0 && listener.refreshes == 0
+                                   && client.getTuioCursors().size() == (size_t)N );
+
+    // A frame without a source message counts as the first source named.
+    receiver.send( encoder.encode( refill, "table@10.0.0.1", encoder.fseq() + 10 ) );
+    listener.reset();
+    receiver.send( encoder.encode( sessionRange( 1000, 3 ), "other@10.0.0.2" ) );
+    expect( "sources: apart", listener.adds == 3 && client.getTuioCursors( 0 ).size() == (size_t)N
+                              && client.getTuioCursors( 1 ).size() == 3
+                              && client.getTuioCursor( 1, 1001 ) != NULL && client.getTuioCursor( 0, 1001 ) == NULL );
+
+    char buffer[1024];
+    osc::OutboundPacketStream other( buffer, sizeof( buffer ) );
+    other << osc::BeginBundleImmediate
+          << osc::BeginMessage( "/tuio/2Dcurx" ) << "alive" << osc::EndMessage
+          << osc::BeginMessage( "/tuio/2Dcur" ) << "sets" << (osc::int32)1000 << osc::EndMessage
+          << osc::BeginMessage( "/tuio/2D" ) << "fseq" << (osc::int32)1000000 << osc::EndMessage
+          << osc::EndBundle;
+    listener.reset();
+    receiver.send( other );
+    expect( "unknown: ignored", listener.adds == 0 && listener.removes == 0 && listener.refreshes == 0 );
+
+    client.disconnect();
+    expect( "disconnect: forgotten", client.getTuioCursor( 1002 ) == NULL && client.getTuioCursors().empty() );
+}
+
+static void checkFrames( int cursors, bool churn )
+{
+    LoopbackReceiver receiver;
+    TuioClient client( &receiver );
+    CountingListener listener;
+    client.addTuioListener( &listener );
+    client.connect();
+    FrameEncoder encoder;
+    unsigned long long allocations = 0,
+                       containerAllocations = 0;
+
+    std::vector<int> sessions = sessionRange( 1, cursors );
+    int nextSession = cursors + 1;
+    receiver.send( encoder.encode( sessions ) );
+
+    for( int f = -WARM_UP_FRAMES; f < FRAMES; ++f ) {
+        if( f == 0 ) {
+            listener.reset();
+            allocations = heapAllocations;
+            containerAllocations = client.getContainerAllocations();
+        }
+        if( churn ) {
+            for( int i = 0; i < cursors / 10; ++i ) {
+                sessions[((f + WARM_UP_FRAMES) * 7 + i * 10) % cursors] = nextSession++;
+            }
+        }
+        receiver.send( encoder.encode( sessions ) );
+    }
+    allocations = heapAllocations - allocations;
+
+    expect( "frames: every frame refreshed", listener.refreshes == (unsigned long)FRAMES );
+    expect( "frames: cursors kept", client.getTuioCursors().size() == (size_t)cursors );
+    expect( "frames: no new cursors allocated", client.getContainerAllocations() == containerAllocations );
+
+    if( churn ) {
+        expect( "frames: adds and removes", listener.adds == listener.removes && listener.adds > 0 );
+        expect( "frames: cursor IDs reused", listener.maxCursorId < cursors + cursors / 10 );
+    }
+    else {
+        expect( "frames: moving cursors allocate nothing", allocations == 0 );
+    }
+    client.disconnect();
+}
+
+int main( int argc, char * argv[] )
+{
+    runChecks();
+
+    const int counts[] = { 100, 300, 1000 };
+
+    for( int i = 0; i < 3; ++i ) {
+        checkFrames( counts[i], false );
+        checkFrames( counts[i], true );
+    }
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
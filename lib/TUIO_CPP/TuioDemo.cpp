@@ -92,14 +92,14 @@ void TuioDemo::drawObjects() {
 	tuioClient->lockCursorList();
 	for (std::list<TuioCursor*>::iterator iter = cursorList.begin(); iter!=cursorList.end(); iter++) {
 		TuioCursor *tuioCursor = (*iter);
-		std::list<TuioPoint> path = tuioCursor->getPath();
+		const TuioPath& path = tuioCursor->getTuioPath();
 		if (path.size()>0) {
 			
 			TuioPoint last_point = path.front();
 			glBegin(GL_LINES);
 			glColor3f(0.0, 0.0, 1.0);
 			
-			for (std::list<TuioPoint>::iterator point = path.begin(); point!=path.end(); point++) {
+			for (TuioPath::const_iterator point = path.begin(); point!=path.end(); point++) {
 				glVertex3f(last_point.getScreenX(width), last_point.getScreenY(height), 0.0f);
 				glVertex3f(point->getScreenX(width), point->getScreenY(height), 0.0f);
 				last_point.update(point->getX(),point->getY());
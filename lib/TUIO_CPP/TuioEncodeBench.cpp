@@ -0,0 +1,297 @@
+/*******************************************************************************
+TuioEncodeBench
+
+PURPOSE: Measures what a frame costs in TuioCursorManager, TuioCursorServer
+         and TuioServer, and prints the results as JSON so that two
+         revisions can be compared.
+
+NOTES:
+Each case runs a number of frames of synthetic cursors through one
+component: initFrame(), an add/update/remove for each contact as the mix
+asks for, then commitFrame().  A case is one combination of
+
+  component  "manager"               TuioCursorManager alone (no encoding)
+             "cursorserver-osc"      TuioCursorServer, TUIO/OSC bundles only
+             "cursorserver-flashxml" TuioCursorServer, Flash XML frames only
+             "tuioserver-osc"        the reference TuioServer
+  contacts   1, 10, 50 and 200
+  mix        "move"     every contact moves every frame
+             "partial"  a quarter of the contacts move each frame
+             "churn"    a tenth of the contacts (at least one) are lifted
+                        and put down again each frame, the rest move
+  update     "delta"    only moved cursors get a set message
+             "full"     every cursor gets a set message every frame
+
+OSC bundles go to a sink OscSender that only counts them, and the UDP
+endpoints of TuioCursorServer are turned off, so nothing is sent on a
+socket (TuioCursorServer still opens its sockets).  Flash XML frames are
+encoded as usual and handed to the Flash XML server, which has no clients;
+their size is read from the encoder.
+
+For each case the JSON has ns_per_frame (wall time of the whole frame),
+allocs_per_frame (operator new calls, counted as BenchSupport.h does),
+bytes_per_frame and packets_per_frame.  The first tenth of the frames warm
+up pools and buffers and are not counted.
+
+Usage: TuioEncodeBench [frames] > results.json
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#define BENCH_COUNT_ALLOCATIONS
+#include "BenchSupport.h"
+#include "TuioCursorServer.h"
+#include "TuioServer.h"
+#include "FlashXmlEncoder.h"
+#include <string>
+#include <vector>
+
+using namespace TUIO;
+
+/**
+ * Runs frames through one component.  The contacts are numbered 0 to n-1.
+ */
+class Driver
+{
+public:
+    virtual ~Driver() {}
+    virtual void initFrame( TuioTime time ) = 0;
+    virtual void add( int contact, float x, float y ) = 0;
+    virtual void update( int contact, float x, float y ) = 0;
+    virtual void remove( int contact ) = 0;
+    virtual void commitFrame() = 0;
+
+    /**
+     * Output so far, in bytes and packets.
+     */
+    virtual unsigned long long bytes() = 0;
+    virtual unsigned long long packets() = 0;
+};
+
+/**
+ * TuioCursorManager and TuioCursorServer are driven with the uniqueId API,
+ * as TouchHooks2Tuio drives them.
+ */
+class ManagerDriver : public Driver
+{
+public:
+    ManagerDriver() {}
+
+    void initFrame( TuioTime time ) { manager_.initFrame( time ); }
+    void add( int contact, float x, float y ) { manager_.addTuioCursor( contact, x, y ); }
+    void update( int contact, float x, float y ) { manager_.updateTuioCursor( contact, x, y ); }
+    void remove( int contact ) { manager_.removeTuioCursor( contact ); }
+    void commitFrame() { manager_.commitFrame(); }
+    unsigned long long bytes() { return 0; }
+    unsigned long long packets() { return 0; }
+
+private:
+    TuioCursorManager manager_;
+};
+
+class CursorServerDriver : public Driver
+{
+public:
+    CursorServerDriver( bool osc, bool flashXml, bool full ) :
+      server_( "127.0.0.1", 3333, 3334, 0 ),
+      flashXml_( flashXml ),
+      flashXmlBytes_( 0 ),
+      flashXmlPackets_( 0 )
+    {
+        server_.useFirstUdpSender( false );
+        server_.useSecondUdpSender( false );
+        server_.useFlashXmlTcpSender( flashXml );
+
+        if( osc ) {
+            server_.addOscSender( &sink_ );
+        }
+        if( full ) {
+            server_.enableFullUpdate();
+        }
+    }
+
+    void initFrame( TuioTime time ) { server_.initFrame( time ); }
+    void add( int contact, float x, float y ) { server_.addTuioCursor( contact, x, y ); }
+    void update( int contact, float x, float y ) { server_.updateTuioCursor( contact, x, y ); }
+    void remove( int contact ) { server_.removeTuioCursor( contact ); }
+
+    void commitFrame()
+    {
+        server_.commitFrame();
+
+        if( flashXml_ ) {
+            flashXmlBytes_ += server_.getFlashXmlEncoder()->size();
+            ++flashXmlPackets_;
+        }
+    }
+
+    unsigned long long bytes() { return sink_.bytes + flashXmlBytes_; }
+    unsigned long long packets() { return sink_.packets + flashXmlPackets_; }
+
+private:
+    SinkSender sink_; // outlives the server, which sends a last bundle when it is deleted
+    TuioCursorServer server_;
+    bool flashXml_;
+    unsigned long long flashXmlBytes_,
+                       flashXmlPackets_;
+};
+
+class TuioServerDriver : public Driver
+{
+public:
+    TuioServerDriver( bool full ) :
+      server_( &sink_ ),
+      cursors_( 1024, (TuioCursor *)NULL )
+    {
+        if( full ) {
+            server_.enableFullUpdate();
+        }
+    }
+
+    void initFrame( TuioTime time ) { server_.initFrame( time ); }
+    void add( int contact, float x, float y ) { cursors_[contact] = server_.addTuioCursor( x, y ); }
+    void update( int contact, float x, float y ) { server_.updateTuioCursor( cursors_[contact], x, y ); }
+
+    void remove( int contact )
+    {
+        server_.removeTuioCursor( cursors_[contact] );
+        cursors_[contact] = NULL;
+    }
+
+    void commitFrame() { server_.commitFrame(); }
+    unsigned long long bytes() { return sink_.bytes; }
+    unsigned long long packets() { return sink_.packets; }
+
+private:
+    SinkSender sink_;
+    TuioServer server_;
+    std::vector<TuioCursor *> cursors_;
+};
+
+enum Mix { MOVE, PARTIAL, CHURN };
+
+struct Case
+{
+    const char * component;
+    int contacts;
+    Mix mix;
+    bool full;
+};
+
+static const char * mixName( Mix mix )
+{
+    return mix == MOVE ? "move" : (mix == PARTIAL ? "partial" : "churn");
+}
+
+static Driver * makeDriver( const Case & c )
+{
+    std::string component = c.component;
+
+    if( component == "manager" ) {
+        return new ManagerDriver();
+    }
+    if( component == "cursorserver-osc" ) {
+        return new CursorServerDriver( true, false, c.full );
+    }
+    if( component == "cursorserver-flashxml" ) {
+        return new CursorServerDriver( false, true, c.full );
+    }
+    return new TuioServerDriver( c.full );
+}
+
+static float position( int contact, unsigned int frame, int axis )
+{
+    return 0.1f + 0.8f * (float)((contact * 37 + frame * (axis + 1) * 3) % 1000) / 1000.0f;
+}
+
+/**
+ * Runs one frame.  Frame 0 puts every contact down.
+ */
+static void runFrame( Driver & driver, const Case & c, unsigned int frame )
+{
+    driver.initFrame( TuioTime( frame / 60, (frame % 60) * 16667 ) );
+
+    if( frame == 0 ) {
+        for( int i = 0; i < c.contacts; ++i ) {
+            driver.add( i, position( i, frame, 0 ), position( i, frame, 1 ) );
+        }
+    }
+    else {
+        int churned = c.contacts / 10 > 0 ? c.contacts / 10 : 1,
+            firstChurned = (int)((frame * churned) % c.contacts);
+
+        for( int i = 0; i < c.contacts; ++i ) {
+            float x = position( i, frame, 0 ),
+                  y = position( i, frame, 1 );
+
+            if( c.mix == CHURN && (i - firstChurned + c.contacts) % c.contacts < churned ) {
+                driver.remove( i );
+                driver.add( i, x, y );
+            }
+            else if( c.mix != PARTIAL || (i + frame) % 4 == 0 ) {
+                driver.update( i, x, y );
+            }
+        }
+    }
+    driver.commitFrame();
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int frames = argc > 1 ? (unsigned int)atoi( argv[1] ) : 5000;
+
+    if( frames < 10 ) {
+        fprintf( stderr, "usage: %s [frames (at least 10)]\n", argv[0] );
+        return 2;
+    }
+    const char * components[] = { "manager", "cursorserver-osc", "cursorserver-flashxml", "tuioserver-osc" };
+    int contacts[] = { 1, 10, 50, 200 };
+    Mix mixes[] = { MOVE, PARTIAL, CHURN };
+    unsigned int warmup = frames / 10;
+    bool first = true;
+
+    printf( "{\n  \"benchmark\": \"TuioEncodeBench\",\n  \"frames\": %u,\n  \"warmup_frames\": %u,\n"
+            "  \"results\": [\n", frames, warmup );
+
+    for( size_t k = 0; k < sizeof( components ) / sizeof( components[0] ); ++k ) {
+        for( size_t n = 0; n < sizeof( contacts ) / sizeof( contacts[0] ); ++n ) {
+            for( size_t m = 0; m < sizeof( mixes ) / sizeof( mixes[0] ); ++m ) {
+                for( int full = 0; full <= 1; ++full ) {
+                    Case c = { components[k], contacts[n], mixes[m], full != 0 };
+
+                    if( full && k == 0 ) {
+                        continue; // the manager does not encode
+                    }
+                    Driver * driver = makeDriver( c );
+
+                    for( unsigned int f = 0; f < warmup; ++f ) {
+                        runFrame( *driver, c, f );
+                    }
+                    unsigned long long bytes = driver->bytes(),
+                                       packets = driver->packets(),
+                                       before = heapAllocations;
+                    double start = seconds();
+
+                    for( unsigned int f = warmup; f < frames; ++f ) {
+                        runFrame( *driver, c, f );
+                    }
+                    double elapsed = seconds() - start;
+                    unsigned int counted = frames - warmup;
+
+                    printf( "%s    {\"component\": \"%s\", \"contacts\": %d, \"mix\": \"%s\", \"update\": \"%s\", "
+                            "\"ns_per_frame\": %.1f, \"allocs_per_frame\": %.2f, \"bytes_per_frame\": %.1f, "
+                            "\"packets_per_frame\": %.2f}",
+                            first ? "" : ",\n", c.component, c.contacts, mixName( c.mix ),
+                            c.full ? "full" : "delta", elapsed * 1e9 / counted,
+                            (double)(heapAllocations - before) / counted,
+                            (double)(driver->bytes() - bytes) / counted,
+                            (double)(driver->packets() - packets) / counted );
+                    fflush( stdout );
+                    first = false;
+                    delete driver;
+                }
+            }
+        }
+    }
+    printf( "\n  ]\n}\n" );
+    return 0;
+}
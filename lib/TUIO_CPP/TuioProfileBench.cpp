@@ -0,0 +1,166 @@
+/*******************************************************************************
+TuioProfileBench
+
+PURPOSE: Compares the TUIO 2.0 bundles TuioCursorServer sends with TUIO 1.1,
+         in bytes per frame and in decoding time per frame.
+
+NOTES:
+FRAMES frames of 1 to 250 moving cursors are sent through a TuioClient for
+each version, and the bundle sizes and microseconds per frame printed.
+
+TuioProfileCheck checks the bundles and their decoding.
+
+Usage: TuioProfileBench
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TuioListener.h"
+#include "TuioCursorServer.h"
+#include "TuioClient.h"
+#include "osc/OscFixedMessage.h"
+#include <chrono>
+#include <cmath>
+
+using namespace TUIO;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int FRAMES = 2000,
+                 FRAME_INTERVAL = 10000;      // microseconds between frames
+
+typedef std::vector<std::string> Frame;      // the bundles of one frame
+
+class CountingListener : public TuioListener
+{
+public:
+    CountingListener() : adds( 0 ), updates( 0 ), removes( 0 ), refreshes( 0 ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioCursor( TuioCursor * ) { ++adds; }
+    void updateTuioCursor( TuioCursor * ) { ++updates; }
+    void removeTuioCursor( TuioCursor * ) { ++removes; }
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+    void refresh( TuioTime ) { ++refreshes; }
+
+    unsigned long adds,
+                  updates,
+                  removes,
+                  refreshes;
+};
+
+static float coordinate( int cursor, int frame, int axis )
+{
+    return 0.5f + 0.4f * (float)std::sin( 0.05 * frame + 0.7 * cursor + 1.3 * axis );
+}
+
+/**
+ * The bundles of two frames of moving cursors in the given version, from
+ * a TuioCursorServer.  A frame of many cursors takes more than one bundle.
+ */
+static std::vector<Frame> encodeFrames( int cursors, TuioCursorServer::Profile profile )
+{
+    CapturingSender sender;
+    TuioCursorServer server( "127.0.0.1", 3333, 3334, 0 );
+    server.useFirstUdpSender( false );
+    server.useSecondUdpSender( false );
+    server.useFlashXmlTcpSender( false );
+    server.addOscSender( &sender, 0, profile );
+    server.setSourceDimensions( 1920, 1080 );
+    std::vector<Frame> frames;
+
+    for( int f = 0; f < 3; ++f ) {
+        size_t sent = sender.packets.size();
+        server.initFrame( TuioTime( 1, f * FRAME_INTERVAL ) );
+
+        for( int i = 0; i < cursors; ++i ) {
+            if( f == 0 ) {
+                server.addTuioCursor( i, coordinate( i, f, 0 ), coordinate( i, f, 1 ) );
+            }
+            else {
+                server.updateTuioCursor( i, coordinate( i, f, 0 ), coordinate( i, f, 1 ) );
+            }
+        }
+        server.commitFrame();
+
+        if( f > 0 ) {
+            frames.push_back( Frame( sender.packets.begin() + sent, sender.packets.end() ) );
+        }
+    }
+    return frames;
+}
+
+static size_t frameBytes( const Frame & frame )
+{
+    size_t bytes = 0;
+
+    for( size_t i = 0; i < frame.size(); ++i ) {
+        bytes += frame[i].size();
+    }
+    return bytes;
+}
+
+/**
+ * Microseconds per frame in a TuioClient.  The frame IDs (and, in TUIO 2.0,
+ * the frame times) are written into the bundles as they are sent, so that
+ * none of them is taken for a late frame.
+ */
+static double timeFrames( std::vector<Frame> frames, int cursors, TuioCursorServer::Profile profile )
+{
+    LoopbackReceiver receiver;
+    TuioClient client( &receiver );
+    CountingListener listener;
+    client.addTuioListener( &listener );
+    client.connect();
+    Clock::time_point start = Clock::now();
+
+    for( int f = 1; f <= FRAMES; ++f ) {
+        Frame & frame = frames[f % 2];
+        TuioTime now = TuioTime::getSessionTime();
+
+        for( size_t i = 0; i < frame.size(); ++i ) {
+            char * data = &frame[i][0];
+
+            if( profile == TuioCursorServer::TUIO_2_0 ) {
+                // #bundle, time tag, size, "/tuio2/frm", ",itis", then f_id and the time
+                osc::FixedMessageStoreUInt32( data + 40, (osc::uint32)f );
+                osc::FixedMessageStoreUInt32( data + 44, (osc::uint32)now.getSeconds() );
+                osc::FixedMessageStoreUInt32( data + 48, (osc::uint32)(((osc::uint64)now.getMicroseconds() << 32) / USEC_SECOND) );
+            }
+            else {
+                // fseq is the last argument
+                osc::FixedMessageStoreUInt32( data + frame[i].size() - 4, (osc::uint32)f );
+            }
+            receiver.send( frame[i] );
+        }
+    }
+    double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+    client.disconnect();
+    return seconds * 1e6 / FRAMES;
+}
+
+int main( int argc, char * argv[] )
+{
+    printf( "%d frames of moving cursors through TuioClient:\n", FRAMES );
+    printf( "%8s %10s %10s %10s %10s %10s %10s\n", "", "1.1", "2.0", "1.1", "2.0", "1.1", "2.0" );
+    printf( "%8s %10s %10s %10s %10s %10s %10s\n", "cursors", "bytes", "bytes", "per cursor", "per cursor",
+            "us/frame", "us/frame" );
+    const int counts[] = { 1, 10, 100, 250 };
+
+    for( int i = 0; i < 4; ++i ) {
+        std::vector<Frame> frames11 = encodeFrames( counts[i], TuioCursorServer::TUIO_1_1 ),
+                           frames20 = encodeFrames( counts[i], TuioCursorServer::TUIO_2_0 );
+        double us11 = timeFrames( frames11, counts[i], TuioCursorServer::TUIO_1_1 ),
+               us20 = timeFrames( frames20, counts[i], TuioCursorServer::TUIO_2_0 );
+        size_t bytes11 = frameBytes( frames11[1] ),
+               bytes20 = frameBytes( frames20[1] );
+
+        printf( "%8d %10lu %10lu %10.1f %10.1f %10.2f %10.2f\n", counts[i], (unsigned long)bytes11,
+                (unsigned long)bytes20, (double)bytes11 / counts[i], (double)bytes20 / counts[i], us11, us20 );
+    }
+    return 0;
+}
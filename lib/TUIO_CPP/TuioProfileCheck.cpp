@@ -0,0 +1,367 @@
+/*******************************************************************************
+TuioProfileCheck
+
+PURPOSE: Checks the TUIO 2.0 bundles TuioCursorServer sends and TuioClient's
+         decoding of them against TUIO 1.1.
+
+NOTES:
+The checks:
+
+- the /tuio2/ptr and /tuio2/alv messages written from templates are byte
+  for byte what operator<< writes;
+- a TuioCursorServer with one TUIO 1.1 and one TUIO 2.0 OscSender sends
+  each of them its own bundles, frame for frame: /tuio2/frm with the frame
+  ID, the frame time, the source dimensions and the source name first,
+  a /tuio2/ptr with the pointer type for every changed cursor, /tuio2/alv
+  with every cursor last;
+- a pen and a touch contact put down through TouchPipeline are sent with
+  different type IDs: a stylus and an unknown pointer;
+- a TuioClient fed the TUIO 2.0 bundles ends up with the same cursors, at
+  the same positions, as one fed the TUIO 1.1 bundles, after every frame,
+  and with the same speeds, which it works out from the frame times;
+- /tuio2/ptr messages with the five speeds, decoded by processSetMessage(),
+  and with another shape, decoded by processOSC(), are taken too.
+
+The checks run on a clock they set, so that the sender's frame times and
+the client's session time go in step.
+
+TuioProfileBench compares the two versions in bytes and decoding time per
+frame.
+
+Usage: TuioProfileCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "TouchPipeline.h"
+#include "TuioListener.h"
+#include "TuioCursorServer.h"
+#include "TuioClient.h"
+#include "osc/OscFixedMessage.h"
+#include "osc/OscOutboundPacketStream.h"
+#include "osc/OscReceivedElements.h"
+#include <cmath>
+#include <cstring>
+
+using namespace TUIO;
+
+static const int FRAME_INTERVAL = 10000,      // microseconds between frames
+                 BUFFER_SIZE = 64 * 1024;
+
+static int64_t testTime = 0;       // nanoseconds
+
+static int64_t testClock()
+{
+    return testTime;
+}
+
+static bool closeTo( float a, float b )
+{
+    return fabs( a - b ) <= 1e-3f * (1.0f + fabs( a ) + fabs( b ));
+}
+
+static void checkTemplates()
+{
+    osc::FixedMessageTemplate<3, 6> ptr( "/tuio2/ptr", NULL );
+    osc::Int32ListMessageTemplate alive( "/tuio2/alv", NULL );
+    char bufferA[512], bufferB[512];
+    osc::OutboundPacketStream a( bufferA, sizeof( bufferA ) ),
+                              b( bufferB, sizeof( bufferB ) );
+    osc::int32 ints[3] = { 42, 21, 0 };
+    float floats[6] = { 0.25f, 0.75f, 0.0f, -0.0f, 0.125f, 1.0f };
+
+    a << osc::BeginBundleImmediate << osc::BeginMessage( "/tuio2/ptr" );
+
+    for( int i = 0; i < 3; ++i ) {
+        a << ints[i];
+    }
+    for( int i = 0; i < 6; ++i ) {
+        a << floats[i];
+    }
+    a << osc::EndMessage << osc::BeginMessage( "/tuio2/alv" );
+
+    for( int i = 0; i < 5; ++i ) {
+        a << (osc::int32)(i * 3);
+    }
+    a << osc::EndMessage << osc::BeginMessage( "/tuio2/alv" ) << osc::EndMessage << osc::EndBundle;
+
+    b << osc::BeginBundleImmediate;
+    ptr.Write( b, ints, floats );
+    char * ids = alive.Write( b, 5 );
+
+    for( int i = 0; i < 5; ++i ) {
+        osc::FixedMessageStoreUInt32( ids + i * 4, (osc::uint32)(i * 3) );
+    }
+    alive.Write( b, 0 );
+    b << osc::EndBundle;
+
+    expect( "templates: same bytes", a.Size() == b.Size() && memcmp( a.Data(), b.Data(), a.Size() ) == 0 );
+    expect( "ptr size", ptr.Size() == 12 + 12 + 36 );
+}
+
+class CountingListener : public TuioListener
+{
+public:
+    CountingListener() : adds( 0 ), updates( 0 ), removes( 0 ), refreshes( 0 ) {}
+
+    void addTuioObject( TuioObject * ) {}
+    void updateTuioObject( TuioObject * ) {}
+    void removeTuioObject( TuioObject * ) {}
+    void addTuioCursor( TuioCursor * ) { ++adds; }
+    void updateTuioCursor( TuioCursor * ) { ++updates; }
+    void removeTuioCursor( TuioCursor * ) { ++removes; }
+    void addTuioBlob( TuioBlob * ) {}
+    void updateTuioBlob( TuioBlob * ) {}
+    void removeTuioBlob( TuioBlob * ) {}
+    void refresh( TuioTime ) { ++refreshes; }
+
+    unsigned long adds,
+                  updates,
+                  removes,
+                  refreshes;
+};
+
+static float coordinate( int cursor, int frame, int axis )
+{
+    return 0.5f + 0.4f * (float)std::sin( 0.05 * frame + 0.7 * cursor + 1.3 * axis );
+}
+
+/**
+ * Checks the layout of one TUIO 2.0 bundle.
+ */
+static bool tuio2Bundle( const std::string & packet, long frame, TuioTime time, size_t alive )
+{
+    osc::ReceivedBundle bundle( osc::ReceivedPacket( packet.data(), (osc::int32)packet.size() ) );
+    osc::ReceivedBundle::const_iterator element = bundle.ElementsBegin();
+    osc::ReceivedMessage frm( *element );
+    osc::ReceivedMessageArgumentStream args = frm.ArgumentStream();
+    osc::int32 f_id, dim;
+    osc::TimeTag timeTag;
+    const char * source;
+    args >> f_id >> timeTag >> dim >> source >> osc::EndMessage;
+
+    osc::uint64 expectedTag = ((osc::uint64)time.getSeconds() << 32)
+                            | (((osc::uint64)time.getMicroseconds() << 32) / USEC_SECOND);
+    bool ok = strcmp( frm.AddressPattern(), "/tuio2/frm" ) == 0 && f_id == frame && timeTag.value == expectedTag
+              && dim == (1920 << 16 | 1080) && strcmp( source, "bench" ) == 0;
+
+    for( ++element; ok && element != bundle.ElementsEnd(); ++element ) {
+        osc::ReceivedMessage message( *element );
+        osc::ReceivedMessageArgumentStream messageArgs = message.ArgumentStream();
+        bool last = false;
+        {
+            osc::ReceivedBundle::const_iterator next = element;
+            last = ++next == bundle.ElementsEnd();
+        }
+        if( last ) {
+            ok = strcmp( message.AddressPattern(), "/tuio2/alv" ) == 0 && message.ArgumentCount() == alive;
+        }
+        else {
+            osc::int32 s_id, tu_id, c_id;
+            messageArgs >> s_id >> tu_id >> c_id;
+            ok = strcmp( message.AddressPattern(), "/tuio2/ptr" ) == 0 && message.ArgumentCount() == 9
+                 && (tu_id & 0xFFFF) == TuioCursorServer::TYPE_STYLUS && c_id == 0;
+        }
+    }
+    return ok;
+}
+
+static bool sameCursors( TuioClient & a, TuioClient & b, bool speeds )
+{
+    std::list<TuioCursor *> cursorsA = a.getTuioCursors(), cursorsB = b.getTuioCursors();
+
+    if( cursorsA.size() != cursorsB.size() ) {
+        return false;
+    }
+    for( std::list<TuioCursor *>::iterator i = cursorsA.begin(); i != cursorsA.end(); ++i ) {
+        TuioCursor * other = b.getTuioCursor( (*i)->getSessionID() );
+
+        if( other == NULL || (*i)->getX() != other->getX() || (*i)->getY() != other->getY() ) {
+            return false;
+        }
+        if( speeds && (!closeTo( (*i)->getXSpeed(), other->getXSpeed() )
+                       || !closeTo( (*i)->getYSpeed(), other->getYSpeed() )) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkServerAndClient()
+{
+    TuioTime::setClock( testClock );
+    testTime = 0;
+    TuioTime::initSession();
+
+    CapturingSender tuio11, tuio20;
+    LoopbackReceiver receiver11, receiver20;
+    TuioClient client11( &receiver11 ),
+               client20( &receiver20 );
+    CountingListener listener11, listener20;
+    client11.addTuioListener( &listener11 );
+    client20.addTuioListener( &listener20 );
+    client11.connect();
+    client20.connect();
+    bool layout = true,
+         alike = true,
+         moving = false;
+    {
+        TuioCursorServer server( "127.0.0.1", 3333, 3334, 0 );
+        server.useFirstUdpSender( false );
+        server.useSecondUdpSender( false );
+        server.useFlashXmlTcpSender( false );
+        server.addOscSender( &tuio11 );
+        server.addOscSender( &tuio20, 0, TuioCursorServer::TUIO_2_0 );
+        server.setSourceName( "bench" );
+        server.setSourceDimensions( 1920, 1080 );
+        int live = 0;
+
+        for( int f = 1; f <= 300; ++f ) {
+            testTime = (int64_t)f * FRAME_INTERVAL * 1000;
+            TuioTime frameTime = TuioTime::getSessionTime();
+            size_t sent11 = tuio11.packets.size(),
+                   sent20 = tuio20.packets.size();
+            server.initFrame( frameTime );
+
+            if( f % 50 < 10 ) {
+                server.addTuioCursor( live, coordinate( live, f, 0 ), coordinate( live, f, 1 ),
+                                      TuioCursorServer::TYPE_STYLUS );
+                ++live;
+            }
+            else if( f % 50 >= 40 && live > 0 ) {
+                server.removeTuioCursor( --live );
+            }
+            for( int i = 0; i < live; ++i ) {
+                if( (f + i) % 3 != 0 ) {
+                    server.updateTuioCursor( i, coordinate( i, f, 0 ), coordinate( i, f, 1 ) );
+                }
+            }
+            server.commitFrame();
+
+            if( tuio11.packets.size() == sent11 && tuio20.packets.size() == sent20 ) {
+                continue;       // nothing changed, nothing sent
+            }
+            if( tuio11.packets.size() != sent11 + 1 || tuio20.packets.size() != sent20 + 1 ) {
+                layout = false;
+                continue;
+            }
+            layout = layout && tuio2Bundle( tuio20.packets.back(), server.getFrameID(), frameTime, (size_t)live );
+
+            receiver11.send( tuio11.packets.back() );
+            receiver20.send( tuio20.packets.back() );
+            alike = alike && sameCursors( client11, client20, true );
+            moving = moving || (live > 0 && client20.getTuioCursors().back()->getXSpeed() != 0.0f);
+        }
+    }
+    expect( "server: a bundle per frame in each version", layout );
+    expect( "clients: same cursors", alike );
+    expect( "clients: speeds from the frame times", moving );
+    expect( "clients: same callbacks", listener11.adds == listener20.adds && listener11.removes == listener20.removes
+                                       && listener11.refreshes == listener20.refreshes && listener20.adds == 60 );
+
+    // the speeds sent along, and a shape only processOSC() takes
+    char buffer[1024];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    testTime += (int64_t)FRAME_INTERVAL * 1000;
+    packet << osc::BeginBundleImmediate
+           << osc::BeginMessage( "/tuio2/frm" ) << (osc::int32)100000 << osc::TimeTag( 1000ULL << 32 )
+           << (osc::int32)0 << "other" << osc::EndMessage
+           << osc::BeginMessage( "/tuio2/ptr" ) << (osc::int32)7 << (osc::int32)0 << (osc::int32)0
+           << 0.5f << 0.25f << 0.0f << 0.0f << 0.0f << 0.0f << 2.0f << -1.0f << 0.0f << 3.0f << 0.0f
+           << osc::EndMessage
+           << osc::BeginMessage( "/tuio2/ptr" ) << (osc::int32)8 << (osc::int32)0 << (osc::int32)0
+           << 0.75f << 0.5f << 0.0f << 0.0f << 0.0f << 0.0f << 1.0f << 1.0f << osc::EndMessage
+           << osc::BeginMessage( "/tuio2/alv" ) << (osc::int32)7 << (osc::int32)8 << osc::EndMessage
+           << osc::EndBundle;
+    receiver20.send( packet.Data(), packet.Size() );
+    std::list<TuioCursor *> others = client20.getTuioCursors( 1 );
+    expect( "other source: both pointers", others.size() == 2 );
+
+    testTime += (int64_t)FRAME_INTERVAL * 1000;
+    packet.Clear();
+    packet << osc::BeginBundleImmediate
+           << osc::BeginMessage( "/tuio2/frm" ) << (osc::int32)100001 << osc::TimeTag( 1000ULL << 32 | 42949673 )
+           << (osc::int32)0 << "other" << osc::EndMessage
+           << osc::BeginMessage( "/tuio2/ptr" ) << (osc::int32)7 << (osc::int32)0 << (osc::int32)0
+           << 0.6f << 0.2f << 0.0f << 0.0f << 0.0f << 0.0f << 2.0f << -1.0f << 0.0f << 3.0f << 0.0f
+           << osc::EndMessage
+           << osc::BeginMessage( "/tuio2/alv" ) << (osc::int32)7 << osc::EndMessage
+           << osc::EndBundle;
+    receiver20.send( packet.Data(), packet.Size() );
+    TuioCursor * tcur = client20.getTuioCursor( 1, 7 );
+    expect( "speeds sent: taken", tcur != NULL && tcur->getX() == 0.6f && tcur->getXSpeed() == 2.0f
+                                  && tcur->getYSpeed() == -1.0f && tcur->getMotionAccel() == 3.0f );
+    expect( "speeds sent: removed", client20.getTuioCursors( 1 ).size() == 1 );
+
+    client11.disconnect();
+    client20.disconnect();
+    TuioTime::setClock( NULL );
+    TuioTime::initSession();
+}
+
+static PointerEvent pointerDown( unsigned int id, int pointerType, int x )
+{
+    PointerEvent event;
+    event.id = id;
+    event.type = POINTER_DOWN;
+    event.pointerType = pointerType;
+    event.x = x;
+    event.y = 500;
+    event.timestamp = 0;
+    return event;
+}
+
+/**
+ * The pen is put down at x = 250 and the finger at x = 750 of a 1000 pixel
+ * wide screen, which tells their /tuio2/ptr messages apart.
+ */
+static void checkPointerTypes()
+{
+    CapturingSender tuio20;
+    {
+        TuioCursorServer server( "127.0.0.1", 3333, 3334, 0 );
+        server.useFirstUdpSender( false );
+        server.useSecondUdpSender( false );
+        server.useFlashXmlTcpSender( false );
+        server.addOscSender( &tuio20, 0, TuioCursorServer::TUIO_2_0 );
+
+        TouchPipeline pipeline( &server );
+        pipeline.setScreenDimensions( 0, 0, 1000, 1000 );
+        pipeline.process( pointerDown( 1, POINTER_INPUT_PEN, 250 ) );
+        pipeline.process( pointerDown( 2, POINTER_INPUT_TOUCH, 750 ) );
+        pipeline.commitFrame();
+    }
+    int penType = -1,
+        touchType = -1;
+
+    for( size_t p = 0; p < tuio20.packets.size(); ++p ) {
+        osc::ReceivedBundle bundle( osc::ReceivedPacket( tuio20.packets[p].data(), (osc::int32)tuio20.packets[p].size() ) );
+
+        for( osc::ReceivedBundle::const_iterator element = bundle.ElementsBegin(); element != bundle.ElementsEnd(); ++element ) {
+            osc::ReceivedMessage message( *element );
+
+            if( strcmp( message.AddressPattern(), "/tuio2/ptr" ) != 0 ) {
+                continue;
+            }
+            osc::ReceivedMessageArgumentStream args = message.ArgumentStream();
+            osc::int32 s_id, tu_id, c_id;
+            float x;
+            args >> s_id >> tu_id >> c_id >> x;
+            (x < 0.5f ? penType : touchType) = tu_id & 0xFFFF;
+        }
+    }
+    expect( "pointer types: pen", penType == TuioCursorServer::TYPE_STYLUS );
+    expect( "pointer types: touch", touchType == TuioCursorServer::TYPE_UNKNOWN );
+}
+
+int main( int argc, char * argv[] )
+{
+    checkTemplates();
+    checkServerAndClient();
+    checkPointerTypes();
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
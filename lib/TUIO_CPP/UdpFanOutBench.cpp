@@ -0,0 +1,166 @@
+/*******************************************************************************
+UdpFanOutBench
+
+PURPOSE: Compares sending TUIO bundles to several UDP consumers through one
+         UdpSender per consumer with sending them through UdpFanOutSender.
+
+NOTES:
+For 1 to 8 consumers, a receiving socket is bound to a free port on
+localhost for each one.  The same bundle is then sent a number of times
+through both kinds of sender, and the receivers are drained between batches.
+For each run the time per bundle and the system calls per bundle are
+printed.  UdpSender makes one send() per consumer; UdpFanOutSender should
+make one sendmmsg() per bundle on Linux.
+
+UdpFanOutCheck checks that every consumer gets every bundle.
+
+Usage: UdpFanOutBench [bundles]
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "UdpFanOutSender.h"
+#include "UdpSender.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace TUIO;
+
+static const unsigned int MAX_CONSUMERS = 8;
+
+// Bundles sent between two drains of the consumers.
+static const unsigned int BATCH_SIZE = 32;
+
+/**
+ * Opens a non-blocking UDP socket on a free localhost port, or returns -1.
+ */
+static int openConsumer( int & port )
+{
+    int consumer = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    struct sockaddr_in address = sockaddr_in();
+    socklen_t length = sizeof( address );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = 0;
+    int bufferSize = 1 << 20;
+    setsockopt( consumer, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof( bufferSize ) );
+
+    if( consumer < 0
+        || bind( consumer, (struct sockaddr *)&address, sizeof( address ) ) != 0
+        || getsockname( consumer, (struct sockaddr *)&address, &length ) != 0 ) {
+        return -1;
+    }
+    port = ntohs( address.sin_port );
+    return consumer;
+}
+
+static void drain( const std::vector<int> & consumers )
+{
+    char buffer[MAX_UDP_SIZE];
+
+    for( size_t i = 0; i < consumers.size(); ++i ) {
+        while( recv( consumers[i], buffer, sizeof( buffer ), MSG_DONTWAIT ) >= 0 ) {
+        }
+    }
+}
+
+/**
+ * A typical frame: source, alive list, one set message per cursor and fseq.
+ */
+static void writeBundle( osc::OutboundPacketStream & packet, int cursors )
+{
+    packet.Clear();
+    packet << osc::BeginBundleImmediate;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "source" << "UdpFanOutBench" << osc::EndMessage;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << (osc::int32)i;
+    }
+    packet << osc::EndMessage;
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)i
+               << 0.5f << 0.5f << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+    }
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)1 << osc::EndMessage;
+    packet << osc::EndBundle;
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned int bundles = argc > 1 ? (unsigned int)atoi( argv[1] ) : 20000;
+
+    if( bundles == 0 ) {
+        fprintf( stderr, "usage: %s [bundles]\n", argv[0] );
+        return 2;
+    }
+    char buffer[MAX_UDP_SIZE];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    writeBundle( packet, 10 );
+
+    printf( "bundles: %u of %d bytes, %s\n", bundles, (int)packet.Size(),
+            UdpFanOutSender::usesBatchedSend() ? "sendmmsg" : "sendto per endpoint" );
+    printf( "%10s %16s %16s %16s %16s\n", "consumers", "UdpSender ns", "fan-out ns",
+            "UdpSender calls", "fan-out calls" );
+
+    for( unsigned int n = 1; n <= MAX_CONSUMERS; n *= 2 ) {
+        std::vector<int> consumers( n ), ports( n );
+
+        for( unsigned int i = 0; i < n; ++i ) {
+            if( (consumers[i] = openConsumer( ports[i] )) < 0 ) {
+                fprintf( stderr, "could not open a receiving socket\n" );
+                return 1;
+            }
+        }
+        std::vector<UdpSender *> senders;
+        UdpFanOutSender fanOut;
+
+        for( unsigned int i = 0; i < n; ++i ) {
+            senders.push_back( new UdpSender( "127.0.0.1", ports[i] ) );
+            fanOut.addEndpoint( "127.0.0.1", ports[i] );
+        }
+        double senderTime = 0.0;
+
+        for( unsigned int b = 0; b < bundles; ++b ) {
+            double start = seconds();
+
+            for( unsigned int i = 0; i < n; ++i ) {
+                senders[i]->sendOscPacket( &packet );
+            }
+            senderTime += seconds() - start;
+
+            if( b % BATCH_SIZE == BATCH_SIZE - 1 ) {
+                drain( consumers );
+            }
+        }
+        drain( consumers );
+
+        for( unsigned int i = 0; i < n; ++i ) {
+            delete senders[i];
+        }
+        double fanOutTime = 0.0;
+
+        for( unsigned int b = 0; b < bundles; ++b ) {
+            double start = seconds();
+            fanOut.sendOscPacket( &packet );
+            fanOutTime += seconds() - start;
+
+            if( b % BATCH_SIZE == BATCH_SIZE - 1 ) {
+                drain( consumers );
+            }
+        }
+        drain( consumers );
+
+        printf( "%10u %16.1f %16.1f %16.2f %16.2f\n", n,
+                senderTime * 1e9 / bundles, fanOutTime * 1e9 / bundles,
+                (double)n, (double)fanOut.getSyscallCount() / fanOut.getPacketCount() );
+        for( unsigned int i = 0; i < n; ++i ) {
+            close( consumers[i] );
+        }
+    }
+    return 0;
+}
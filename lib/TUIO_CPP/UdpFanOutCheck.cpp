@@ -0,0 +1,225 @@
+/*******************************************************************************
+UdpFanOutCheck
+
+PURPOSE: Checks that UdpFanOutSender gets every bundle to every UDP consumer,
+         and that an endpoint that fails does not stop the others.
+
+NOTES:
+For 1 to 8 consumers, a receiving socket is bound to a free port on
+localhost for each one, and BUNDLES bundles are sent through one UdpSender
+per consumer and then through a UdpFanOutSender.  Every consumer must get
+every bundle both times, each endpoint must count every bundle and no
+error, and on Linux the fan-out sender must make one sendmmsg() per bundle.
+
+A last run adds an endpoint that cannot be sent to (port 0) in the middle of
+the list: its errors must be counted while the consumers after it still get
+every bundle, and once it is disabled it must not be sent to.
+
+UdpFanOutBench times both kinds of sender.
+
+Usage: UdpFanOutCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "UdpFanOutSender.h"
+#include "UdpSender.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace TUIO;
+
+static const unsigned int BUNDLES = 1000,
+                          MAX_CONSUMERS = 8;
+
+// Bundles sent between two drains of the consumers.
+static const unsigned int BATCH_SIZE = 32;
+
+/**
+ * A non-blocking UDP socket on a free localhost port that counts what it gets.
+ */
+struct Consumer
+{
+    int socket;
+    int port;
+    unsigned long received;
+    int expectedSize;
+};
+
+static bool openConsumer( Consumer & consumer, int expectedSize )
+{
+    consumer.socket = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    consumer.received = 0;
+    consumer.expectedSize = expectedSize;
+
+    struct sockaddr_in address = sockaddr_in();
+    socklen_t length = sizeof( address );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = 0;
+    int bufferSize = 1 << 20;
+    setsockopt( consumer.socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof( bufferSize ) );
+
+    if( consumer.socket < 0
+        || bind( consumer.socket, (struct sockaddr *)&address, sizeof( address ) ) != 0
+        || getsockname( consumer.socket, (struct sockaddr *)&address, &length ) != 0 ) {
+        return false;
+    }
+    consumer.port = ntohs( address.sin_port );
+    return true;
+}
+
+static void drain( std::vector<Consumer> & consumers )
+{
+    char buffer[MAX_UDP_SIZE];
+
+    for( size_t i = 0; i < consumers.size(); ++i ) {
+        for( ;; ) {
+            long n = (long)recv( consumers[i].socket, buffer, sizeof( buffer ), MSG_DONTWAIT );
+
+            if( n < 0 ) {
+                break;
+            }
+            if( n == consumers[i].expectedSize ) {
+                ++consumers[i].received;
+            }
+        }
+    }
+}
+
+static void closeConsumers( std::vector<Consumer> & consumers )
+{
+    for( size_t i = 0; i < consumers.size(); ++i ) {
+        close( consumers[i].socket );
+    }
+}
+
+/**
+ * A typical frame: source, alive list, one set message per cursor and fseq.
+ */
+static void writeBundle( osc::OutboundPacketStream & packet, int cursors )
+{
+    packet.Clear();
+    packet << osc::BeginBundleImmediate;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "source" << "UdpFanOutCheck" << osc::EndMessage;
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "alive";
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << (osc::int32)i;
+    }
+    packet << osc::EndMessage;
+
+    for( int i = 0; i < cursors; ++i ) {
+        packet << osc::BeginMessage( "/tuio/2Dcur" ) << "set" << (osc::int32)i
+               << 0.5f << 0.5f << 0.0f << 0.0f << 0.0f << osc::EndMessage;
+    }
+    packet << osc::BeginMessage( "/tuio/2Dcur" ) << "fseq" << (osc::int32)1 << osc::EndMessage;
+    packet << osc::EndBundle;
+}
+
+static bool receivedAll( const std::vector<Consumer> & consumers, unsigned long expected,
+                         const char * sender )
+{
+    bool all = true;
+
+    for( size_t i = 0; i < consumers.size(); ++i ) {
+        if( consumers[i].received != expected ) {
+            fprintf( stderr, "%s: consumer %u got %lu of %lu bundles\n", sender,
+                     (unsigned int)i, consumers[i].received, expected );
+            all = false;
+        }
+    }
+    return all;
+}
+
+static void send( OscSender & sender, osc::OutboundPacketStream & packet, std::vector<Consumer> & consumers )
+{
+    for( unsigned int b = 0; b < BUNDLES; ++b ) {
+        sender.sendOscPacket( &packet );
+
+        if( b % BATCH_SIZE == BATCH_SIZE - 1 ) {
+            drain( consumers );
+        }
+    }
+    drain( consumers );
+}
+
+static void checkConsumers( osc::OutboundPacketStream & packet, unsigned int n )
+{
+    std::vector<Consumer> consumers( n );
+
+    for( unsigned int i = 0; i < n; ++i ) {
+        if( !openConsumer( consumers[i], (int)packet.Size() ) ) {
+            expect( "open a receiving socket", false );
+            return;
+        }
+    }
+    UdpFanOutSender fanOut;
+
+    for( unsigned int i = 0; i < n; ++i ) {
+        UdpSender sender( "127.0.0.1", consumers[i].port );
+        send( sender, packet, consumers );
+        fanOut.addEndpoint( "127.0.0.1", consumers[i].port );
+    }
+    expect( "UdpSender: every bundle", receivedAll( consumers, BUNDLES, "UdpSender" ) );
+
+    for( unsigned int i = 0; i < n; ++i ) {
+        consumers[i].received = 0;
+    }
+    send( fanOut, packet, consumers );
+    expect( "UdpFanOutSender: every bundle", receivedAll( consumers, BUNDLES, "UdpFanOutSender" ) );
+    expect( "UdpFanOutSender: one sendmmsg per bundle", !UdpFanOutSender::usesBatchedSend()
+                                                        || fanOut.getSyscallCount() == fanOut.getPacketCount() );
+    bool counted = true;
+
+    for( unsigned int i = 0; i < n; ++i ) {
+        counted = counted && fanOut.getEndpointPacketCount( (int)i ) == BUNDLES
+                  && fanOut.getEndpointErrorCount( (int)i ) == 0;
+    }
+    expect( "UdpFanOutSender: endpoint counts", counted );
+    closeConsumers( consumers );
+}
+
+static void checkBadEndpoint( osc::OutboundPacketStream & packet )
+{
+    std::vector<Consumer> consumers( 2 );
+
+    if( !openConsumer( consumers[0], (int)packet.Size() ) || !openConsumer( consumers[1], (int)packet.Size() ) ) {
+        expect( "open a receiving socket", false );
+        return;
+    }
+    UdpFanOutSender fanOut;
+    fanOut.addEndpoint( "127.0.0.1", consumers[0].port );
+    int bad = fanOut.addEndpoint( "127.0.0.1", 0 );
+    fanOut.addEndpoint( "127.0.0.1", consumers[1].port );
+
+    send( fanOut, packet, consumers );
+    expect( "bad endpoint: the others get every bundle", receivedAll( consumers, BUNDLES, "bad endpoint" ) );
+    expect( "bad endpoint: errors counted", fanOut.getEndpointErrorCount( bad ) == BUNDLES
+                                            && fanOut.getEndpointLastError( bad ) != 0 );
+
+    fanOut.enableEndpoint( bad, false );
+    fanOut.sendOscPacket( &packet );
+    expect( "bad endpoint: disabled", fanOut.getEndpointErrorCount( bad ) == BUNDLES );
+    closeConsumers( consumers );
+}
+
+int main( int argc, char * argv[] )
+{
+    char buffer[MAX_UDP_SIZE];
+    osc::OutboundPacketStream packet( buffer, sizeof( buffer ) );
+    writeBundle( packet, 10 );
+
+    for( unsigned int n = 1; n <= MAX_CONSUMERS; n *= 2 ) {
+        checkConsumers( packet, n );
+    }
+    checkBadEndpoint( packet );
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
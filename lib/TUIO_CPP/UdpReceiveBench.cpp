@@ -0,0 +1,280 @@
+/*******************************************************************************
+UdpReceiveBench
+
+PURPOSE: Floods oscpack's SocketReceiveMultiplexer with TUIO-sized datagrams
+         over localhost and measures how many it takes in per second.
+
+NOTES:
+A thread sends FLOOD_PACKETS datagrams of FLOOD_PACKET_SIZE bytes (about a
+bundle of ten cursors) to a socket on a free localhost port as fast as it
+can, while the multiplexer hands them to a listener that only counts them
+and a periodic timer runs.  Whatever the receiving socket's buffer could not
+hold is dropped by the kernel.  The multiplexer's ReceiveStats give the
+datagrams received per wakeup and, on Linux, the number the kernel dropped;
+they are printed with the rates and the receiving thread's CPU time per
+datagram.  On a single core the receiver is woken for nearly every
+datagram, so the rate received mostly shows how fast the sender is.
+
+The backlog runs BACKLOG_ROUNDS times: BACKLOG datagrams are queued on the
+socket while the multiplexer is stopped, then it is started and takes them
+in.  The CPU time the receiving thread spends per datagram shows the cost
+of the receive loop when there is more than one datagram to take.
+
+UdpReceiveCheck checks that every datagram arrives whole and timers keep
+running.
+
+Usage: UdpReceiveBench
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "ip/UdpSocket.h"
+#include "ip/PacketListener.h"
+#include "ip/TimerListener.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int FLOOD_PACKETS = 500000,
+                 FLOOD_PACKET_SIZE = 700,
+                 FLOOD_TIMER_PERIOD = 10,
+                 BACKLOG = 64,
+                 BACKLOG_ROUNDS = 500;
+
+static double secondsSince( Clock::time_point start )
+{
+    return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+static double threadCpuSeconds()
+{
+    struct timespec t;
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &t );
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/**
+ * Also takes the CPU time of the receiving thread at the first datagram
+ * after startCpu() and at a one-byte end marker.
+ */
+class CountingListener : public PacketListener
+{
+public:
+    CountingListener() : packets( 0 ), cpuStart( 0 ), cpuEnd( 0 ), cpuStarting_( true ) {}
+
+    void startCpu() { cpuStarting_ = true; }
+
+    void ProcessPacket( const char * data, int size, const IpEndpointName & remoteEndpoint )
+    {
+        if( size == 1 ) {
+            cpuEnd = threadCpuSeconds();
+        }
+        else if( cpuStarting_ ) {
+            cpuStart = threadCpuSeconds();
+            cpuStarting_ = false;
+        }
+        packets.fetch_add( 1, std::memory_order_release );
+    }
+
+    std::atomic<unsigned long> packets;
+    double cpuStart,
+           cpuEnd;
+
+private:
+    bool cpuStarting_;
+};
+
+class CountingTimer : public TimerListener
+{
+public:
+    CountingTimer() : expired( 0 ) {}
+
+    void TimerExpired() { expired.fetch_add( 1, std::memory_order_relaxed ); }
+
+    std::atomic<unsigned long> expired;
+};
+
+/**
+ * UdpSocket::LocalEndpointFor() cannot tell the port of a socket bound to
+ * any port: on Linux, un-connecting it afterwards gives the port up.
+ */
+static int freePort()
+{
+    int probe = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    struct sockaddr_in address = sockaddr_in();
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    socklen_t length = sizeof( address );
+    bind( probe, (struct sockaddr *)&address, sizeof( address ) );
+    getsockname( probe, (struct sockaddr *)&address, &length );
+    close( probe );
+    return ntohs( address.sin_port );
+}
+
+/**
+ * A receiving socket on a free localhost port, with its multiplexer running
+ * on a thread of its own.
+ */
+class Receiver
+{
+public:
+    Receiver() : port( freePort() ), socket_( IpEndpointName( 127, 0, 0, 1, port ) )
+    {
+        multiplexer.AttachSocketListener( &socket_, &listener );
+    }
+
+    ~Receiver()
+    {
+        stop();
+        multiplexer.DetachSocketListener( &socket_, &listener );
+    }
+
+    void start() { thread_ = std::thread( &SocketReceiveMultiplexer::Run, &multiplexer ); }
+
+    void stop()
+    {
+        if( thread_.joinable() ) {
+            multiplexer.AsynchronousBreak();
+            thread_.join();
+        }
+    }
+
+    SocketReceiveMultiplexer multiplexer;
+    CountingListener listener;
+    int port;
+
+private:
+    UdpReceiveSocket socket_;
+    std::thread thread_;
+};
+
+class Sender
+{
+public:
+    explicit Sender( int port ) : socket_( ::socket( AF_INET, SOCK_DGRAM, 0 ) )
+    {
+        struct sockaddr_in address = sockaddr_in();
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        address.sin_port = htons( (unsigned short)port );
+        connect( socket_, (struct sockaddr *)&address, sizeof( address ) );
+    }
+
+    ~Sender() { close( socket_ ); }
+
+    bool send( const char * data, size_t size ) { return ::send( socket_, data, size, 0 ) == (ssize_t)size; }
+
+private:
+    int socket_;
+};
+
+static bool waitFor( const std::atomic<unsigned long> & count, unsigned long value, double timeout )
+{
+    Clock::time_point start = Clock::now();
+
+    while( count.load() < value ) {
+        if( secondsSince( start ) > timeout ) {
+            return false;
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    return true;
+}
+
+static void runFlood()
+{
+    Receiver receiver;
+    CountingTimer timer;
+    receiver.multiplexer.AttachPeriodicTimerListener( FLOOD_TIMER_PERIOD, &timer );
+    receiver.start();
+
+    Sender sender( receiver.port );
+    std::vector<char> data( FLOOD_PACKET_SIZE, 'x' );
+    unsigned long sent = 0;
+    Clock::time_point start = Clock::now();
+
+    for( int i = 0; i < FLOOD_PACKETS; ++i ) {
+        if( sender.send( &data[0], data.size() ) ) {
+            ++sent;
+        }
+    }
+    double sendSeconds = secondsSince( start );
+
+    // Let the receiver drain the socket, then send one more datagram: the
+    // kernel reports its drop count with the next datagram received.
+    unsigned long received = 0;
+
+    do {
+        received = receiver.listener.packets;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+    } while( receiver.listener.packets != received );
+
+    double seconds = secondsSince( start ) - 0.05;
+    unsigned long timerExpired = timer.expired;
+    sender.send( "!", 1 );
+    waitFor( receiver.listener.packets, received + 1, 1.0 );
+    receiver.stop();
+    receiver.multiplexer.DetachPeriodicTimerListener( &timer );
+
+    SocketReceiveMultiplexer::ReceiveStats stats = receiver.multiplexer.TakeReceiveStats();
+    double perWakeup = stats.wakeups > 0 ? (double)stats.packets / stats.wakeups : 0.0;
+
+    printf( "flood of %d datagrams of %d bytes over localhost:\n", FLOOD_PACKETS, FLOOD_PACKET_SIZE );
+    printf( "  sent        %10lu  (%.0f per second)\n", sent, sent / sendSeconds );
+    printf( "  received    %10lu  (%.0f per second)\n", received, received / seconds );
+    printf( "  dropped     %10lu  (by the kernel, socket buffer full)\n", stats.dropped );
+    printf( "  truncated   %10lu\n", stats.truncated );
+    printf( "  per wakeup  %10.1f\n", perWakeup );
+    printf( "  CPU         %10.2f  (microseconds per datagram received)\n",
+            (receiver.listener.cpuEnd - receiver.listener.cpuStart) * 1e6 / received );
+    printf( "  timer       %10lu  (every %d ms)\n", timerExpired, FLOOD_TIMER_PERIOD );
+}
+
+static void runBacklog()
+{
+    Receiver receiver;
+    Sender sender( receiver.port );
+    std::vector<char> data( FLOOD_PACKET_SIZE, 'x' );
+    double cpu = 0;
+    unsigned long received = 0;
+
+    for( int round = 0; round < BACKLOG_ROUNDS; ++round ) {
+        for( int i = 0; i < BACKLOG - 1; ++i ) {
+            sender.send( &data[0], data.size() );
+        }
+        sender.send( "!", 1 );
+        receiver.listener.startCpu();
+        receiver.start();
+
+        if( !waitFor( receiver.listener.packets, received + BACKLOG, 1.0 ) ) {
+            break;
+        }
+        receiver.stop();
+        received += BACKLOG;
+        cpu += receiver.listener.cpuEnd - receiver.listener.cpuStart;
+    }
+    receiver.stop();
+
+    SocketReceiveMultiplexer::ReceiveStats stats = receiver.multiplexer.TakeReceiveStats();
+    double perWakeup = stats.wakeups > 0 ? (double)stats.packets / stats.wakeups : 0.0;
+
+    printf( "backlog of %d datagrams, %d times:\n", BACKLOG, BACKLOG_ROUNDS );
+    printf( "  per wakeup  %10.1f\n", perWakeup );
+    printf( "  CPU         %10.2f  (microseconds per datagram received)\n", cpu * 1e6 / (BACKLOG - 1) / BACKLOG_ROUNDS );
+
+}
+
+int main( int argc, char * argv[] )
+{
+    runFlood();
+    runBacklog();
+    return 0;
+}
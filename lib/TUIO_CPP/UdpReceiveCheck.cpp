@@ -0,0 +1,291 @@
+/*******************************************************************************
+UdpReceiveCheck
+
+PURPOSE: Checks that oscpack's SocketReceiveMultiplexer takes in every
+         datagram whole, counts what the kernel drops and keeps its timers
+         running.
+
+NOTES:
+The checks: datagrams of 20000 and 65507 bytes (the largest IPv4 allows)
+arrive whole, periodic timers fire at their rate when nothing comes in, and
+AsynchronousBreak() from another thread ends Run().  Then FLOOD_PACKETS
+datagrams of FLOOD_PACKET_SIZE bytes are sent to a socket on a free
+localhost port as fast as possible, with a periodic timer running: on Linux
+received and dropped must add up to sent, none may be truncated and the
+timer must keep firing.  Last, BACKLOG datagrams are queued on the socket
+while the multiplexer is stopped, BACKLOG_ROUNDS times, and must all be
+taken in once it runs again.
+
+UdpReceiveBench measures the rate and the CPU time per datagram.
+
+Usage: UdpReceiveCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "ip/UdpSocket.h"
+#include "ip/PacketListener.h"
+#include "ip/TimerListener.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int FLOOD_PACKETS = 20000,
+                 FLOOD_PACKET_SIZE = 700,
+                 FLOOD_TIMER_PERIOD = 10,
+                 BACKLOG = 64,
+                 BACKLOG_ROUNDS = 20;
+
+static double secondsSince( Clock::time_point start )
+{
+    return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+/**
+ * Also notes a one-byte end marker.
+ */
+class CountingListener : public PacketListener
+{
+public:
+    CountingListener() : packets( 0 ), lastSize( 0 ), endMarker( false ) {}
+
+    void ProcessPacket( const char * data, int size, const IpEndpointName & remoteEndpoint )
+    {
+        if( size == 1 ) {
+            endMarker = true;
+        }
+        lastSize = size;
+        packets.fetch_add( 1, std::memory_order_release );
+    }
+
+    std::atomic<unsigned long> packets;
+    std::atomic<int> lastSize;
+    std::atomic<bool> endMarker;
+};
+
+class CountingTimer : public TimerListener
+{
+public:
+    CountingTimer() : expired( 0 ) {}
+
+    void TimerExpired() { expired.fetch_add( 1, std::memory_order_relaxed ); }
+
+    std::atomic<unsigned long> expired;
+};
+
+/**
+ * UdpSocket::LocalEndpointFor() cannot tell the port of a socket bound to
+ * any port: on Linux, un-connecting it afterwards gives the port up.
+ */
+static int freePort()
+{
+    int probe = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    struct sockaddr_in address = sockaddr_in();
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    socklen_t length = sizeof( address );
+    bind( probe, (struct sockaddr *)&address, sizeof( address ) );
+    getsockname( probe, (struct sockaddr *)&address, &length );
+    close( probe );
+    return ntohs( address.sin_port );
+}
+
+/**
+ * A receiving socket on a free localhost port, with its multiplexer running
+ * on a thread of its own.
+ */
+class Receiver
+{
+public:
+    Receiver() : port( freePort() ), socket_( IpEndpointName( 127, 0, 0, 1, port ) )
+    {
+        multiplexer.AttachSocketListener( &socket_, &listener );
+    }
+
+    ~Receiver()
+    {
+        stop();
+        multiplexer.DetachSocketListener( &socket_, &listener );
+    }
+
+    void start() { thread_ = std::thread( &SocketReceiveMultiplexer::Run, &multiplexer ); }
+
+    void stop()
+    {
+        if( thread_.joinable() ) {
+            multiplexer.AsynchronousBreak();
+            thread_.join();
+        }
+    }
+
+    SocketReceiveMultiplexer multiplexer;
+    CountingListener listener;
+    int port;
+
+private:
+    UdpReceiveSocket socket_;
+    std::thread thread_;
+};
+
+class Sender
+{
+public:
+    explicit Sender( int port ) : socket_( ::socket( AF_INET, SOCK_DGRAM, 0 ) )
+    {
+        struct sockaddr_in address = sockaddr_in();
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        address.sin_port = htons( (unsigned short)port );
+        connect( socket_, (struct sockaddr *)&address, sizeof( address ) );
+    }
+
+    ~Sender() { close( socket_ ); }
+
+    bool send( const char * data, size_t size ) { return ::send( socket_, data, size, 0 ) == (ssize_t)size; }
+
+private:
+    int socket_;
+};
+
+static bool waitFor( const std::atomic<unsigned long> & count, unsigned long value, double timeout )
+{
+    Clock::time_point start = Clock::now();
+
+    while( count.load() < value ) {
+        if( secondsSince( start ) > timeout ) {
+            return false;
+        }
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    return true;
+}
+
+static void checkLargePackets()
+{
+    Receiver receiver;
+    receiver.start();
+    Sender sender( receiver.port );
+    std::vector<char> data( 65507, 'x' );
+
+    sender.send( &data[0], 20000 );
+    expect( "large: 20000 bytes received", waitFor( receiver.listener.packets, 1, 1.0 ) );
+    expect( "large: 20000 bytes whole", receiver.listener.lastSize == 20000 );
+
+    sender.send( &data[0], data.size() );
+    expect( "large: 65507 bytes received", waitFor( receiver.listener.packets, 2, 1.0 ) );
+    expect( "large: 65507 bytes whole", receiver.listener.lastSize == (int)data.size() );
+
+    receiver.stop();
+    SocketReceiveMultiplexer::ReceiveStats stats = receiver.multiplexer.TakeReceiveStats();
+    expect( "large: counted", stats.packets == 2 && stats.truncated == 0 );
+}
+
+static void checkTimers()
+{
+    Receiver receiver;
+    CountingTimer fast, slow;
+    receiver.multiplexer.AttachPeriodicTimerListener( 3, &fast );
+    receiver.multiplexer.AttachPeriodicTimerListener( 20, 5, &slow );
+
+    Clock::time_point start = Clock::now();
+    receiver.start();
+    std::this_thread::sleep_for( std::chrono::milliseconds( 200 ) );
+    receiver.stop();
+    double milliseconds = secondsSince( start ) * 1000;
+
+    expect( "timers: fast rate", fast.expired >= milliseconds / 3 * 0.8 && fast.expired <= milliseconds / 3 + 1 );
+    expect( "timers: slow rate", slow.expired >= (milliseconds - 20) / 5 * 0.8 && slow.expired <= (milliseconds - 20) / 5 + 2 );
+    expect( "break: run returned", secondsSince( start ) < 1.0 );
+
+    receiver.multiplexer.DetachPeriodicTimerListener( &fast );
+    receiver.multiplexer.DetachPeriodicTimerListener( &slow );
+}
+
+static void checkFlood()
+{
+    Receiver receiver;
+    CountingTimer timer;
+    receiver.multiplexer.AttachPeriodicTimerListener( FLOOD_TIMER_PERIOD, &timer );
+    receiver.start();
+
+    Sender sender( receiver.port );
+    std::vector<char> data( FLOOD_PACKET_SIZE, 'x' );
+    unsigned long sent = 0;
+    Clock::time_point start = Clock::now();
+
+    for( int i = 0; i < FLOOD_PACKETS; ++i ) {
+        if( sender.send( &data[0], data.size() ) ) {
+            ++sent;
+        }
+    }
+
+    // Let the receiver drain the socket, then send one more datagram: the
+    // kernel reports its drop count with the next datagram received.
+    unsigned long received = 0;
+
+    do {
+        received = receiver.listener.packets;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+    } while( receiver.listener.packets != received );
+
+    double seconds = secondsSince( start ) - 0.05;
+    unsigned long timerExpired = timer.expired;
+    sender.send( "!", 1 );
+    waitFor( receiver.listener.packets, received + 1, 1.0 );
+    receiver.stop();
+    receiver.multiplexer.DetachPeriodicTimerListener( &timer );
+
+    SocketReceiveMultiplexer::ReceiveStats stats = receiver.multiplexer.TakeReceiveStats();
+
+#if defined(__linux__)
+    expect( "flood: received and dropped add up to sent", received + stats.dropped == sent );
+    expect( "flood: end marker received", receiver.listener.endMarker );
+#endif
+    expect( "flood: none truncated", stats.truncated == 0 );
+    expect( "flood: timer kept running", timerExpired >= seconds * 1000 / FLOOD_TIMER_PERIOD * 0.5 );
+}
+
+static void checkBacklog()
+{
+    Receiver receiver;
+    Sender sender( receiver.port );
+    std::vector<char> data( FLOOD_PACKET_SIZE, 'x' );
+    unsigned long received = 0;
+
+    for( int round = 0; round < BACKLOG_ROUNDS; ++round ) {
+        for( int i = 0; i < BACKLOG; ++i ) {
+            sender.send( &data[0], data.size() );
+        }
+        receiver.start();
+
+        if( !waitFor( receiver.listener.packets, received + BACKLOG, 1.0 ) ) {
+            break;
+        }
+        receiver.stop();
+        received += BACKLOG;
+    }
+    receiver.stop();
+
+    expect( "backlog: every datagram received", receiver.listener.packets == (unsigned long)BACKLOG * BACKLOG_ROUNDS );
+}
+
+int main( int argc, char * argv[] )
+{
+    checkLargePackets();
+    checkTimers();
+    checkFlood();
+    checkBacklog();
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
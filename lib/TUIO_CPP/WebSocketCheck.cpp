@@ -0,0 +1,617 @@
+/*******************************************************************************
+WebSocketCheck
+
+PURPOSE: Checks WebSocketSender against a headless WebSocket client on
+         localhost, and compares its bytes per frame with Flash XML.
+
+NOTES:
+The checks:
+
+- the opening handshake: the Sec-WebSocket-Accept of RFC 6455's example
+  key, 426 for another protocol version, 400 for a request that is not an
+  upgrade, permessage-deflate agreed only if the server offers it;
+- a TuioCursorServer with the WebSocketSender and a capturing OscSender
+  sends each client the very bundles the capturing sender gets, byte for
+  byte, one binary message each, and a TuioClient fed them ends up with the
+  cursors sent;
+- a client with permessage-deflate gets the same bundles once inflated;
+- a client that connects gets every cursor in the next bundle;
+- pings are answered with the same payload, a close is echoed and the
+  connection closed, an unmasked frame is a protocol error;
+- a client that stops reading has messages dropped, never more than
+  MAX_QUEUED_FRAMES queued and a full frame requested, while a client that
+  reads gets every message and no send takes long; once the stalled client
+  reads again it gets whole messages, ending with the newest one.
+
+The comparison sends frames of 1 to 100 moving cursors and prints the bytes
+per frame of Flash XML and of the WebSocket messages, plain and deflated.
+
+Usage: WebSocketCheck
+
+Exits with a non-zero status if any check fails.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#include "BenchSupport.h"
+#include "WebSocketSender.h"
+#include "TuioCursorServer.h"
+#include "TuioClient.h"
+#include "FlashXmlEncoder.h"
+#include "osc/OscReceivedElements.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace TUIO;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int READ_TIMEOUT = 1000,               // milliseconds
+                 BUFFER_SIZE = 64 * 1024;
+static const double MAX_SEND_MILLISECONDS = 50.0;
+
+struct Message
+{
+    int opcode;
+    bool compressed;
+    std::string payload;
+};
+
+/**
+ * A WebSocket client on a blocking socket, as little of one as the checks
+ * need.
+ */
+class HeadlessClient
+{
+public:
+    HeadlessClient() : socket_( -1 ) {}
+    ~HeadlessClient() { disconnect(); }
+
+    bool connectTo( int port, int receiveBuffer = 0 )
+    {
+        socket_ = ::socket( AF_INET, SOCK_STREAM, 0 );
+
+        if( receiveBuffer > 0 ) {
+            setsockopt( socket_, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof( receiveBuffer ) );
+        }
+        struct sockaddr_in address = sockaddr_in();
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        address.sin_port = htons( (unsigned short)port );
+        return connect( socket_, (struct sockaddr *)&address, sizeof( address ) ) == 0;
+    }
+
+    /**
+     * Sends the request and returns the response headers, or "" if none
+     * came.
+     */
+    std::string request( const std::string & text )
+    {
+        sendAll( text );
+
+        while( input_.find( "\r\n\r\n" ) == std::string::npos ) {
+            if( !receive( READ_TIMEOUT ) ) {
+                return std::string();
+            }
+        }
+        size_t end = input_.find( "\r\n\r\n" ) + 4;
+        std::string response = input_.substr( 0, end );
+        input_.erase( 0, end );
+        return response;
+    }
+
+    bool open( int port, const std::string & extensions = "", int receiveBuffer = 0 )
+    {
+        if( !connectTo( port, receiveBuffer ) ) {
+            return false;
+        }
+        response = request( upgradeRequest( "13", extensions ) );
+        return response.compare( 0, 12, "HTTP/1.1 101" ) == 0;
+    }
+
+    static std::string upgradeRequest( const char * version, const std::string & extensions )
+    {
+        std::string text = "GET /tuio HTTP/1.1\r\n"
+                           "Host: 127.0.0.1\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                           "Sec-WebSocket-Version: ";
+        text += version;
+        text += "\r\n";
+
+        if( !extensions.empty() ) {
+            text += "Sec-WebSocket-Extensions: " + extensions + "\r\n";
+        }
+        return text + "\r\n";
+    }
+
+    /**
+     * Reads one message, waiting up to the given milliseconds for it.
+     */
+    bool read( Message & message, int timeout = READ_TIMEOUT )
+    {
+        for( ;; ) {
+            if( input_.size() >= 2 ) {
+                const unsigned char * bytes = (const unsigned char *)input_.data();
+                size_t size = bytes[1] & 0x7F,
+                       headerSize = 2;
+
+                if( size == 126 && input_.size() >= 4 ) {
+                    size = (size_t)bytes[2] << 8 | bytes[3];
+                    headerSize = 4;
+                }
+                else if( size == 127 && input_.size() >= 10 ) {
+                    size = 0;
+
+                    for( int i = 0; i < 8; ++i ) {
+                        size = size << 8 | bytes[2 + i];
+                    }
+                    headerSize = 10;
+                }
+                if( size < 126 || headerSize > 2 ) {
+                    if( input_.size() >= headerSize + size ) {
+                        message.opcode = bytes[0] & 0x0F;
+                        message.compressed = (bytes[0] & 0x40) != 0;
+                        message.payload = input_.substr( headerSize, size );
+                        input_.erase( 0, headerSize + size );
+                        return true;
+                    }
+                }
+            }
+            if( !receive( timeout ) ) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * Sends a frame, masked as a client has to unless told not to.
+     */
+    void write( int opcode, const std::string & payload, bool masked = true )
+    {
+        std::string frame;
+        frame += (char)(0x80 | opcode);
+        frame += (char)((masked ? 0x80 : 0) | payload.size());
+        const char mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+
+        if( masked ) {
+            frame.append( mask, 4 );
+        }
+        for( size_t i = 0; i < payload.size(); ++i ) {
+            frame += masked ? (char)(payload[i] ^ mask[i % 4]) : payload[i];
+        }
+        sendAll( frame );
+    }
+
+    /**
+     * True if the server closes the connection within the timeout.
+     */
+    bool closedByServer()
+    {
+        while( receive( READ_TIMEOUT ) ) {
+        }
+        return closed_;
+    }
+
+    void disconnect()
+    {
+        if( socket_ >= 0 ) {
+            close( socket_ );
+            socket_ = -1;
+        }
+    }
+
+    std::string response;
+
+private:
+    void sendAll( const std::string & text )
+    {
+        size_t sent = 0;
+
+        while( sent < text.size() ) {
+            ssize_t n = send( socket_, text.data() + sent, text.size() - sent, MSG_NOSIGNAL );
+
+            if( n <= 0 ) {
+                return;
+            }
+            sent += (size_t)n;
+        }
+    }
+
+    bool receive( int timeout )
+    {
+        struct pollfd readable;
+        readable.fd = socket_;
+        readable.events = POLLIN;
+        closed_ = false;
+
+        if( poll( &readable, 1, timeout ) <= 0 ) {
+            return false;
+        }
+        char buffer[16384];
+        ssize_t n = recv( socket_, buffer, sizeof( buffer ), 0 );
+
+        if( n <= 0 ) {
+            closed_ = true;
+            return false;
+        }
+        input_.append( buffer, (size_t)n );
+        return true;
+    }
+
+    int socket_;
+    bool closed_;
+    std::string input_;
+};
+
+static bool waitForClients( WebSocketSender & sender, int count )
+{
+    for( int i = 0; i < 200; ++i ) {
+        if( sender.getClientCount() == count ) {
+            return true;
+        }
+        usleep( 10000 );
+    }
+    return false;
+}
+
+static float coordinate( int cursor, int frame, int axis )
+{
+    return 0.5f + 0.4f * (float)std::sin( 0.05 * frame + 0.7 * cursor + 1.3 * axis );
+}
+
+/**
+ * Inflates a permessage-deflate payload, which has no context kept.
+ */
+static std::string inflatePayload( const std::string & payload )
+{
+    z_stream stream;
+    memset( &stream, 0, sizeof( stream ) );
+    inflateInit2( &stream, -15 );
+    std::string input = payload + std::string( "\x00\x00\xff\xff", 4 ),
+                output( BUFFER_SIZE, '\0' );
+    stream.next_in = (Bytef *)&input[0];
+    stream.avail_in = (uInt)input.size();
+    stream.next_out = (Bytef *)&output[0];
+    stream.avail_out = (uInt)output.size();
+    inflate( &stream, Z_SYNC_FLUSH );
+    output.resize( output.size() - stream.avail_out );
+    inflateEnd( &stream );
+    return output;
+}
+
+static int setMessages( const std::string & packet )
+{
+    osc::ReceivedBundle bundle( osc::ReceivedPacket( packet.data(), (osc::int32)packet.size() ) );
+    int count = 0;
+
+    for( osc::ReceivedBundle::const_iterator i = bundle.ElementsBegin(); i != bundle.ElementsEnd(); ++i ) {
+        osc::ReceivedMessage message( *i );
+        osc::ReceivedMessageArgumentStream args = message.ArgumentStream();
+        const char * command;
+        args >> command;
+        count += strcmp( command, "set" ) == 0 ? 1 : 0;
+    }
+    return count;
+}
+
+static void checkHandshakes()
+{
+    WebSocketSender sender( 0, true );
+    expect( "server: listening", sender.isRunning() && sender.getPort() > 0 );
+    expect( "server: deflate offered", sender.deflateEnabled() );
+    int port = sender.getPort();
+
+    HeadlessClient plain;
+    expect( "handshake: switching protocols", plain.open( port ) );
+    expect( "handshake: accept key", plain.response.find( "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n" )
+                                     != std::string::npos );
+    expect( "handshake: no extension unasked", plain.response.find( "permessage-deflate" ) == std::string::npos );
+
+    HeadlessClient deflating;
+    expect( "deflate: switching protocols", deflating.open( port, "permessage-deflate; client_max_window_bits" ) );
+    expect( "deflate: agreed", deflating.response.find( "Sec-WebSocket-Extensions: permessage-deflate; "
+                                                        "server_no_context_takeover\r\n" ) != std::string::npos );
+
+    HeadlessClient narrow;
+    expect( "narrow window: switching protocols", narrow.open( port, "permessage-deflate; server_max_window_bits=10" ) );
+    expect( "narrow window: declined", narrow.response.find( "permessage-deflate" ) == std::string::npos );
+
+    HeadlessClient oldVersion;
+    oldVersion.connectTo( port );
+    std::string response = oldVersion.request( HeadlessClient::upgradeRequest( "8", "" ) );
+    expect( "version 8: 426", response.compare( 0, 12, "HTTP/1.1 426" ) == 0
+                              && response.find( "Sec-WebSocket-Version: 13" ) != std::string::npos );
+    expect( "version 8: closed", oldVersion.closedByServer() );
+
+    HeadlessClient notUpgrade;
+    notUpgrade.connectTo( port );
+    response = notUpgrade.request( "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n" );
+    expect( "plain GET: 400", response.compare( 0, 12, "HTTP/1.1 400" ) == 0 );
+    expect( "plain GET: closed", notUpgrade.closedByServer() );
+
+    expect( "clients: counted", waitForClients( sender, 3 ) );
+    std::vector<WebSocketSender::ClientStats> stats = sender.getClientStats();
+    int deflated = 0;
+
+    for( size_t i = 0; i < stats.size(); ++i ) {
+        deflated += stats[i].deflate ? 1 : 0;
+    }
+    expect( "clients: one deflating", deflated == 1 );
+
+    WebSocketSender noDeflate( 0, false );
+    HeadlessClient offering;
+    expect( "deflate off: switching protocols", offering.open( noDeflate.getPort(), "permessage-deflate" ) );
+    expect( "deflate off: declined", offering.response.find( "permessage-deflate" ) == std::string::npos );
+}
+
+static void checkBundles()
+{
+    const int CURSORS = 10,
+              FRAMES = 200;
+    CapturingSender captured;
+    WebSocketSender sender( 0, true );
+    HeadlessClient plain,
+                   deflating;
+    plain.open( sender.getPort() );
+    deflating.open( sender.getPort(), "permessage-deflate" );
+    waitForClients( sender, 2 );
+
+    LoopbackReceiver receiver;
+    TuioClient client( &receiver );
+    client.connect();
+    bool same = true,
+         inflated = true,
+         compressed = false;
+    float x[CURSORS],
+          y[CURSORS];
+    {
+        TuioCursorServer server( "127.0.0.1", 3333, 3334, 0 );
+        server.useFirstUdpSender( false );
+        server.useSecondUdpSender( false );
+        server.useFlashXmlTcpSender( false );
+        server.addOscSender( &captured );
+        server.addOscSender( &sender );
+
+        for( int f = 0; f < FRAMES; ++f ) {
+            size_t sent = captured.packets.size();
+            server.initFrame( TuioTime( 1, f * 10000 ) );
+
+            for( int i = 0; i < CURSORS; ++i ) {
+                if( f > 0 && (f + i) % 4 == 0 ) {
+                    continue;
+                }
+                x[i] = coordinate( i, f, 0 );
+                y[i] = coordinate( i, f, 1 );
+
+                if( f == 0 ) {
+                    server.addTuioCursor( i, x[i], y[i] );
+                }
+                else {
+                    server.updateTuioCursor( i, x[i], y[i] );
+                }
+            }
+            server.commitFrame();
+
+            for( size_t p = sent; p < captured.packets.size(); ++p ) {
+                Message message;
+                same = same && plain.read( message ) && message.opcode == 2 && !message.compressed
+                       && message.payload == captured.packets[p];
+                receiver.send( message.payload );
+
+                inflated = inflated && deflating.read( message ) && message.opcode == 2
+                           && (message.compressed ? inflatePayload( message.payload ) : message.payload)
+                              == captured.packets[p];
+                compressed = compressed || message.compressed;
+            }
+        }
+        expect( "plain: the same bundles", same );
+        expect( "deflate: the same bundles inflated", inflated );
+        expect( "deflate: compressed", compressed );
+
+        std::list<TuioCursor *> cursors = client.getTuioCursors();
+        bool placed = cursors.size() == CURSORS;
+
+        for( std::list<TuioCursor *>::iterator c = cursors.begin(); placed && c != cursors.end(); ++c ) {
+            int i = (*c)->getCursorID();
+            placed = i >= 0 && i < CURSORS && (*c)->getX() == x[i] && (*c)->getY() == y[i];
+        }
+        expect( "client: the cursors sent", placed );
+
+        // a client that connects is sent every cursor, not only the one moving
+        HeadlessClient late;
+        late.open( sender.getPort() );
+        waitForClients( sender, 3 );
+        size_t sent = captured.packets.size();
+        server.initFrame( TuioTime( 1, FRAMES * 10000 ) );
+        server.updateTuioCursor( 0, 0.5f, 0.5f );
+        server.commitFrame();
+        Message message;
+        expect( "late client: every cursor", captured.packets.size() == sent + 1
+                                             && setMessages( captured.packets.back() ) == CURSORS
+                                             && late.read( message ) && message.payload == captured.packets.back() );
+        sent = captured.packets.size();
+        server.initFrame( TuioTime( 1, (FRAMES + 1) * 10000 ) );
+        server.updateTuioCursor( 0, 0.25f, 0.5f );
+        server.commitFrame();
+        expect( "late client: then the changes", captured.packets.size() == sent + 1
+                                                 && setMessages( captured.packets.back() ) == 1 );
+    }
+    client.disconnect();
+}
+
+static void checkControlFrames()
+{
+    WebSocketSender sender( 0 );
+    HeadlessClient client;
+    client.open( sender.getPort() );
+    Message message;
+
+    client.write( 0x9, "are you there" );
+    expect( "ping: pong", client.read( message ) && message.opcode == 0xA && message.payload == "are you there" );
+
+    client.write( 0x1, "ignored" );
+    client.write( 0x9, "" );
+    expect( "text: ignored", client.read( message ) && message.opcode == 0xA && message.payload.empty() );
+
+    client.write( 0x8, std::string( "\x03\xe8", 2 ) + "bye" );
+    expect( "close: echoed", client.read( message ) && message.opcode == 0x8
+                             && message.payload == std::string( "\x03\xe8", 2 ) );
+    expect( "close: closed", client.closedByServer() );
+
+    HeadlessClient unmasked;
+    unmasked.open( sender.getPort() );
+    unmasked.write( 0x9, "ping", false );
+    expect( "unmasked: protocol error", unmasked.read( message ) && message.opcode == 0x8
+                                        && message.payload == std::string( "\x03\xea", 2 ) );
+    expect( "unmasked: closed", unmasked.closedByServer() );
+    expect( "clients: removed", waitForClients( sender, 0 ) );
+}
+
+static unsigned int messageNumber( const std::string & payload )
+{
+    unsigned int n = 0;
+    memcpy( &n, payload.data(), sizeof( n ) );
+    return n;
+}
+
+static void checkBackpressure()
+{
+    WebSocketSender sender( 0 );
+    HeadlessClient reading,
+                   stalled;
+    reading.open( sender.getPort() );
+    stalled.open( sender.getPort(), "", 4096 );
+    waitForClients( sender, 2 );
+    sender.fullFrameRequested();    // the two connecting
+
+    std::string payload( 2000, 'x' );
+    unsigned int sent = 0,
+                 received = 0;
+    bool inOrder = true,
+         dropped = false;
+    double slowest = 0.0;
+
+    while( sent < 20000 && !(dropped && sent % 100 == 0) ) {
+        memcpy( &payload[0], &sent, sizeof( sent ) );
+        Clock::time_point start = Clock::now();
+        sender.sendPacket( payload.data(), (int)payload.size() );
+        double milliseconds = std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+        slowest = milliseconds > slowest ? milliseconds : slowest;
+        ++sent;
+
+        Message message;
+
+        while( received < sent && reading.read( message ) ) {
+            inOrder = inOrder && messageNumber( message.payload ) == received && message.payload.size() == payload.size();
+            ++received;
+        }
+        if( sent % 100 == 0 ) {
+            std::vector<WebSocketSender::ClientStats> stats = sender.getClientStats();
+
+            for( size_t i = 0; i < stats.size(); ++i ) {
+                dropped = dropped || stats[i].framesDropped > 0;
+                expect( "stalled: queue bounded", stats[i].queuedFrames <= WebSocketSender::MAX_QUEUED_FRAMES );
+            }
+        }
+    }
+    printf( "backpressure: %u messages of %u bytes sent, slowest send %.3f ms\n",
+            sent, (unsigned int)payload.size(), slowest );
+    expect( "stalled: messages dropped", dropped );
+    expect( "stalled: full frame requested", sender.fullFrameRequested() );
+    expect( "stalled: requested once", !sender.fullFrameRequested() );
+    expect( "reading: every message in order", inOrder && received == sent );
+    expect( "sends: never slow", slowest < MAX_SEND_MILLISECONDS );
+
+    Message message;
+    unsigned int last = 0,
+                 count = 0;
+    bool whole = true;
+
+    while( stalled.read( message, 200 ) ) {
+        unsigned int n = messageNumber( message.payload );
+        whole = whole && message.opcode == 2 && message.payload.size() == payload.size() && (count == 0 || n > last);
+        last = n;
+        ++count;
+    }
+    expect( "stalled: whole messages in order", count > 0 && whole );
+    expect( "stalled: ends with the newest", last == sent - 1 );
+}
+
+static void compareSizes()
+{
+    const int COUNTS[] = { 1, 10, 100 },
+              FRAMES = 100;
+    printf( "%8s %16s %16s %16s\n", "cursors", "Flash XML", "WebSocket", "deflated" );
+
+    for( size_t c = 0; c < sizeof( COUNTS ) / sizeof( COUNTS[0] ); ++c ) {
+        int cursors = COUNTS[c];
+        WebSocketSender sender( 0, true );
+        HeadlessClient plain,
+                       deflating;
+        plain.open( sender.getPort() );
+        deflating.open( sender.getPort(), "permessage-deflate" );
+        waitForClients( sender, 2 );
+        unsigned long flashXmlBytes = 0,
+                      plainBytes = 0,
+                      deflatedBytes = 0;
+        {
+            TuioCursorServer server( "127.0.0.1", 3333, 3334, 0 );
+            server.useFirstUdpSender( false );
+            server.useSecondUdpSender( false );
+            server.addOscSender( &sender );
+
+            for( int f = 0; f <= FRAMES; ++f ) {
+                server.initFrame( TuioTime( 1, f * 10000 ) );
+
+                for( int i = 0; i < cursors; ++i ) {
+                    if( f == 0 ) {
+                        server.addTuioCursor( i, coordinate( i, f, 0 ), coordinate( i, f, 1 ) );
+                    }
+                    else {
+                        server.updateTuioCursor( i, coordinate( i, f, 0 ), coordinate( i, f, 1 ) );
+                    }
+                }
+                server.commitFrame();
+                flashXmlBytes += f > 0 ? server.getFlashXmlEncoder()->size() : 0;
+
+                Message message;
+
+                while( plain.read( message, 0 ) ) {
+                }
+                while( deflating.read( message, 0 ) ) {
+                }
+                if( f == 0 || f == FRAMES ) {
+                    // the frames of moving cursors, not the first one, are counted
+                    std::vector<WebSocketSender::ClientStats> stats = sender.getClientStats();
+                    long sign = f == 0 ? -1 : 1;
+
+                    for( size_t i = 0; i < stats.size(); ++i ) {
+                        (stats[i].deflate ? deflatedBytes : plainBytes) += sign * (long)stats[i].bytesSent;
+                    }
+                }
+            }
+        }
+        printf( "%8d %16.0f %16.0f %16.0f\n", cursors, (double)flashXmlBytes / FRAMES,
+                (double)plainBytes / FRAMES, (double)deflatedBytes / FRAMES );
+    }
+}
+
+int main( int argc, char ** argv )
+{
+    checkHandshakes();
+    checkBundles();
+    checkControlFrames();
+    checkBackpressure();
+    compareSizes();
+
+    printf( "%s\n", errors == 0 ? "OK" : "FAILED" );
+    return errors == 0 ? 0 : 1;
+}
@@ -104,6 +104,28 @@ class SocketReceiveMultiplexer{
 
 public:
 
+    // the largest datagram Run() receives whole
+
+    enum { MAX_PACKET_SIZE = 65536 };
+
+
+
+    struct ReceiveStats{
+
+        unsigned long wakeups;      // returns from the wait with data ready
+
+        unsigned long packets;      // datagrams handed to listeners
+
+        unsigned long truncated;    // datagrams too large to receive whole, dropped
+
+        unsigned long dropped;      // datagrams the kernel dropped because the socket
+
+                                    // buffer was full (Linux only, 0 elsewhere)
+
+    };
+
+
+
     SocketReceiveMultiplexer();
 
     ~SocketReceiveMultiplexer();
@@ -140,6 +162,12 @@ public:
 
     void AsynchronousBreak(); // call this from another thread or signal handler to exit the Run() state
 
+
+
+    // counts since the last call, can be called from any thread
+
+    ReceiveStats TakeReceiveStats();
+
 };
 
 
@@ -306,6 +334,8 @@ public:
 
     void AsynchronousBreak() { mux_.AsynchronousBreak(); }
 
+    SocketReceiveMultiplexer::ReceiveStats TakeReceiveStats() { return mux_.TakeReceiveStats(); }
+
 };
 
 
@@ -37,9 +37,9 @@
 
 
 
-NetworkInitializer::NetworkInitializer() {}
+OscNetworkInitializer::OscNetworkInitializer() {}
 
-NetworkInitializer::~NetworkInitializer() {}
+OscNetworkInitializer::~OscNetworkInitializer() {}
 
 
 unsigned long GetHostByName( const char *name )
@@ -31,12 +31,14 @@
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include <stdexcept>
 #include <assert.h>
 #include <signal.h>
 #include <math.h>
 #include <errno.h>
 #include <string.h> // for memset
+#include <stdint.h>
 
 #include <pthread.h>
 #include <unistd.h>
@@ -48,6 +50,13 @@
 #include <sys/time.h>
 #include <netinet/in.h> // for sockaddr_in
 
+#if defined(__linux__)
+// epoll and recvmmsg: wake up once for all ready sockets and take in a
+// batch of datagrams per system call
+#define OSC_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #include "ip/PacketListener.h"
 #include "ip/TimerListener.h"
 
@@ -281,13 +290,67 @@ struct AttachedTimerListener{
 };
 
 
-static bool CompareScheduledTimerCalls( 
+// the timer queue is a heap with the earliest expiry at the front
+static bool LaterScheduledTimerCall( 
 		const std::pair< double, AttachedTimerListener > & lhs, const std::pair< double, AttachedTimerListener > & rhs )
 {
-	return lhs.first < rhs.first;
+	return lhs.first > rhs.first;
 }
 
 
+// Run() takes in up to RECEIVE_BATCH datagrams per system call, and up to
+// MAX_BATCHES_PER_WAKEUP batches from a socket before it looks at the other
+// sockets and the timers again, so a flood cannot starve them.
+static const int RECEIVE_BATCH = 16;
+static const int MAX_BATCHES_PER_WAKEUP = 4;
+static const int MAX_READY_EVENTS = 16;
+
+
+// Full-size receive buffers, so a datagram is never cut short.
+struct ReceiveBatch{
+#if defined(OSC_USE_EPOLL)
+	enum { BUFFERS = RECEIVE_BATCH };
+#else
+	enum { BUFFERS = 1 };
+#endif
+
+	std::vector< char > buffer;
+	char *data[ BUFFERS ];
+
+#if defined(OSC_USE_EPOLL)
+	struct mmsghdr messages[ BUFFERS ];
+	struct iovec vectors[ BUFFERS ];
+	struct sockaddr_in addresses[ BUFFERS ];
+	char control[ BUFFERS ][ CMSG_SPACE( sizeof(uint32_t) ) ];
+#endif
+
+	ReceiveBatch()
+		: buffer( (size_t)BUFFERS * SocketReceiveMultiplexer::MAX_PACKET_SIZE )
+	{
+		for( int i = 0; i < BUFFERS; ++i )
+			data[i] = &buffer[ (size_t)i * SocketReceiveMultiplexer::MAX_PACKET_SIZE ];
+	}
+
+#if defined(OSC_USE_EPOLL)
+	// recvmmsg() overwrites the lengths, so they are set again before each call
+	void Reset()
+	{
+		memset( messages, 0, sizeof(messages) );
+		for( int i = 0; i < BUFFERS; ++i ){
+			vectors[i].iov_base = data[i];
+			vectors[i].iov_len = SocketReceiveMultiplexer::MAX_PACKET_SIZE;
+			messages[i].msg_hdr.msg_name = &addresses[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+			messages[i].msg_hdr.msg_iov = &vectors[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+			messages[i].msg_hdr.msg_control = control[i];
+			messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+		}
+	}
+#endif
+};
+
+
 SocketReceiveMultiplexer *multiplexerInstanceToAbortWithSigInt_ = 0;
 
 extern "C" /*static*/ void InterruptSignalHandler( int );
@@ -305,6 +368,11 @@ class SocketReceiveMultiplexer::Implementation{
 	volatile bool break_;
 	int breakPipe_[2]; // [0] is the reader descriptor and [1] the writer
 
+	std::atomic< unsigned long > wakeups_;
+	std::atomic< unsigned long > packets_;
+	std::atomic< unsigned long > truncated_;
+	std::atomic< unsigned long > dropped_;
+
 	double GetCurrentTimeMs() const
 	{
 		struct timeval t;
@@ -316,6 +384,10 @@ class SocketReceiveMultiplexer::Implementation{
 
 public:
     Implementation()
+		: wakeups_( 0 )
+		, packets_( 0 )
+		, truncated_( 0 )
+		, dropped_( 0 )
 	{
 		if( pipe(breakPipe_) != 0 )
 			throw std::runtime_error( "creation of asynchronous break pipes failed\n" );
@@ -367,19 +439,141 @@ public:
 		timerListeners_.erase( i );
 	}
 
+	// Hands every datagram waiting on the socket to its listener, without
+	// blocking. kernelDrops is the socket's count of datagrams the kernel
+	// dropped, as last reported with a datagram.
+	void ReceivePackets( std::pair< PacketListener*, UdpSocket* >& socketListener, ReceiveBatch& batch, uint32_t& kernelDrops )
+	{
+		int socket = socketListener.second->impl_->Socket();
+
+#if defined(OSC_USE_EPOLL)
+		for( int b = 0; b < MAX_BATCHES_PER_WAKEUP; ++b ){
+			batch.Reset();
+			int count = recvmmsg( socket, batch.messages, RECEIVE_BATCH, MSG_DONTWAIT, 0 );
+			if( count <= 0 )
+				return;
+
+			for( int i = 0; i < count; ++i ){
+				struct msghdr& header = batch.messages[i].msg_hdr;
+
+				for( struct cmsghdr *c = CMSG_FIRSTHDR( &header ); c != 0; c = CMSG_NXTHDR( &header, c ) ){
+					if( c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL ){
+						uint32_t drops;
+						memcpy( &drops, CMSG_DATA( c ), sizeof(drops) );
+						dropped_.fetch_add( drops - kernelDrops, std::memory_order_relaxed );
+						kernelDrops = drops;
+					}
+				}
+
+				if( header.msg_flags & MSG_TRUNC ){
+					truncated_.fetch_add( 1, std::memory_order_relaxed );
+					continue;
+				}
+				if( batch.messages[i].msg_len == 0 )
+					continue;
+
+				IpEndpointName remoteEndpoint( ntohl( batch.addresses[i].sin_addr.s_addr ), ntohs( batch.addresses[i].sin_port ) );
+				packets_.fetch_add( 1, std::memory_order_relaxed );
+				socketListener.first->ProcessPacket( batch.data[i], (int)batch.messages[i].msg_len, remoteEndpoint );
+				if( break_ )
+					return;
+			}
+
+			if( count < RECEIVE_BATCH )
+				return;
+		}
+#else
+		for( int i = 0; i < RECEIVE_BATCH * MAX_BATCHES_PER_WAKEUP; ++i ){
+			struct sockaddr_in fromAddr;
+			socklen_t fromAddrLen = sizeof(fromAddr);
+
+			ssize_t size = recvfrom( socket, batch.data[0], SocketReceiveMultiplexer::MAX_PACKET_SIZE, MSG_DONTWAIT,
+						(struct sockaddr *) &fromAddr, &fromAddrLen );
+			if( size < 0 )
+				return;
+			if( size == 0 )
+				continue;
+
+			IpEndpointName remoteEndpoint( ntohl( fromAddr.sin_addr.s_addr ), ntohs( fromAddr.sin_port ) );
+			packets_.fetch_add( 1, std::memory_order_relaxed );
+			socketListener.first->ProcessPacket( batch.data[0], (int)size, remoteEndpoint );
+			if( break_ )
+				return;
+		}
+		(void)kernelDrops;
+#endif
+	}
+
+	// Runs each expired timer at most once, so a timer that has fallen
+	// behind cannot keep the loop from receiving.
+	void RunExpiredTimers( std::vector< std::pair< double, AttachedTimerListener > >& timerQueue )
+	{
+		double currentTimeMs = GetCurrentTimeMs();
+
+		for( size_t n = timerQueue.size(); n > 0 && timerQueue.front().first <= currentTimeMs; --n ){
+			std::pop_heap( timerQueue.begin(), timerQueue.end(), LaterScheduledTimerCall );
+			std::pair< double, AttachedTimerListener >& expired = timerQueue.back();
+
+			expired.second.listener->TimerExpired();
+			expired.first += expired.second.periodMs;
+			std::push_heap( timerQueue.begin(), timerQueue.end(), LaterScheduledTimerCall );
+
+			if( break_ )
+				break;
+		}
+	}
+
     void Run()
 	{
 		break_ = false;
 
+		// configure the timer queue
+		double currentTimeMs = GetCurrentTimeMs();
+
+		// expiry time ms, listener
+		std::vector< std::pair< double, AttachedTimerListener > > timerQueue_;
+		for( std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
+				i != timerListeners_.end(); ++i )
+			timerQueue_.push_back( std::make_pair( currentTimeMs + i->initialDelayMs, *i ) );
+		std::make_heap( timerQueue_.begin(), timerQueue_.end(), LaterScheduledTimerCall );
+
+		ReceiveBatch batch;
+		std::vector< uint32_t > kernelDrops( socketListeners_.size(), 0 );
+
+		// in addition to listening to the inbound sockets we
+		// also listen to the asynchronous break pipe, so that AsynchronousBreak()
+		// can break us out of the wait from another thread.
+
+#if defined(OSC_USE_EPOLL)
+		int epollFd = epoll_create1( 0 );
+		if( epollFd < 0 )
+			throw std::runtime_error( "epoll_create1 failed\n" );
+
+		struct epoll_event event;
+		memset( &event, 0, sizeof(event) );
+		event.events = EPOLLIN;
+		event.data.u32 = (uint32_t)socketListeners_.size();
+		epoll_ctl( epollFd, EPOLL_CTL_ADD, breakPipe_[0], &event );
+
+		for( size_t i = 0; i < socketListeners_.size(); ++i ){
+			int socket = socketListeners_[i].second->impl_->Socket();
+
+			// have the kernel report the datagrams it drops on a full socket buffer
+			int on = 1;
+			setsockopt( socket, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on) );
+
+			event.data.u32 = (uint32_t)i;
+			epoll_ctl( epollFd, EPOLL_CTL_ADD, socket, &event );
+		}
+
+		struct epoll_event ready[ MAX_READY_EVENTS ];
+#else
 		// configure the master fd_set for select()
 
 		fd_set masterfds, tempfds;
 		FD_ZERO( &masterfds );
 		FD_ZERO( &tempfds );
 		
-		// in addition to listening to the inbound sockets we
-		// also listen to the asynchronous break pipe, so that AsynchronousBreak()
-		// can break us out of select() from another thread.
 		FD_SET( breakPipe_[0], &masterfds );
 		int fdmax = breakPipe_[0];		
 
@@ -391,32 +585,46 @@ public:
 			FD_SET( i->second->impl_->Socket(), &masterfds );
 		}
 
+		struct timeval timeout;
+#endif
 
-		// configure the timer queue
-		double currentTimeMs = GetCurrentTimeMs();
-
-		// expiry time ms, listener
-		std::vector< std::pair< double, AttachedTimerListener > > timerQueue_;
-		for( std::vector< AttachedTimerListener >::iterator i = timerListeners_.begin();
-				i != timerListeners_.end(); ++i )
-			timerQueue_.push_back( std::make_pair( currentTimeMs + i->initialDelayMs, *i ) );
-		std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
+		while( !break_ ){
+			double timeoutMs = -1;
+			if( !timerQueue_.empty() ){
+				timeoutMs = timerQueue_.front().first - GetCurrentTimeMs();
+				if( timeoutMs < 0 )
+					timeoutMs = 0;
+			}
 
-		const int MAX_BUFFER_SIZE = 4098;
-		char *data = new char[ MAX_BUFFER_SIZE ];
-		IpEndpointName remoteEndpoint;
+			bool received = false;
 
-		struct timeval timeout;
+#if defined(OSC_USE_EPOLL)
+			// round up, so the timers are due when epoll_wait() returns
+			int readyCount = epoll_wait( epollFd, ready, MAX_READY_EVENTS, timeoutMs < 0 ? -1 : (int)ceil( timeoutMs ) );
+			if( readyCount < 0 && errno != EINTR ){
+				close( epollFd );
+   				if (!break_) throw std::runtime_error("epoll_wait failed\n");
+				else return;
+			}
 
-		while( !break_ ){
+			for( int i = 0; i < readyCount && !break_; ++i ){
+				uint32_t index = ready[i].data.u32;
+
+				if( index == socketListeners_.size() ){
+					// clear pending data from the asynchronous break pipe
+					char c;
+					ssize_t ret; 
+					ret = read( breakPipe_[0], &c, 1 );
+				}else{
+					ReceivePackets( socketListeners_[index], batch, kernelDrops[index] );
+					received = true;
+				}
+			}
+#else
 			tempfds = masterfds;
 
 			struct timeval *timeoutPtr = 0;
-			if( !timerQueue_.empty() ){
-				double timeoutMs = timerQueue_.front().first - GetCurrentTimeMs();
-				if( timeoutMs < 0 )
-					timeoutMs = 0;
-			
+			if( timeoutMs >= 0 ){
 				// 1000000 microseconds in a second
 				timeout.tv_sec = (long)(timeoutMs * .001);
 				timeout.tv_usec = (long)((timeoutMs - (timeout.tv_sec * 1000)) * 1000);
@@ -435,41 +643,27 @@ public:
 				ret = read( breakPipe_[0], &c, 1 );
 			}
 			
-			if( break_ )
-				break;
-
-			for( std::vector< std::pair< PacketListener*, UdpSocket* > >::iterator i = socketListeners_.begin();
-					i != socketListeners_.end(); ++i ){
-
-				if( FD_ISSET( i->second->impl_->Socket(), &tempfds ) ){
-
-					int size = i->second->ReceiveFrom( remoteEndpoint, data, MAX_BUFFER_SIZE );
-					if( size > 0 ){
-						i->first->ProcessPacket( data, size, remoteEndpoint );
-						if( break_ )
-							break;
-					}
+			for( size_t i = 0; i < socketListeners_.size() && !break_; ++i ){
+				if( FD_ISSET( socketListeners_[i].second->impl_->Socket(), &tempfds ) ){
+					ReceivePackets( socketListeners_[i], batch, kernelDrops[i] );
+					received = true;
 				}
 			}
+#endif
 
-			// execute any expired timers
-			currentTimeMs = GetCurrentTimeMs();
-			bool resort = false;
-			for( std::vector< std::pair< double, AttachedTimerListener > >::iterator i = timerQueue_.begin();
-					i != timerQueue_.end() && i->first <= currentTimeMs; ++i ){
+			if( received )
+				wakeups_.fetch_add( 1, std::memory_order_relaxed );
 
-				i->second.listener->TimerExpired();
-				if( break_ )
-					break;
+			if( break_ )
+				break;
 
-				i->first += i->second.periodMs;
-				resort = true;
-			}
-			if( resort )
-				std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
+			// execute any expired timers
+			RunExpiredTimers( timerQueue_ );
 		}
 
-		delete [] data;
+#if defined(OSC_USE_EPOLL)
+		close( epollFd );
+#endif
 	}
 
     void Break()
@@ -481,10 +675,20 @@ public:
 	{
 		break_ = true;
 
-		// Send a termination message to the asynchronous break pipe, so select() will return
+		// Send a termination message to the asynchronous break pipe, so the wait will return
 		ssize_t ret;
 		ret = write( breakPipe_[1], "!", 1 );
 	}
+
+	SocketReceiveMultiplexer::ReceiveStats TakeReceiveStats()
+	{
+		SocketReceiveMultiplexer::ReceiveStats stats;
+		stats.wakeups = wakeups_.exchange( 0 );
+		stats.packets = packets_.exchange( 0 );
+		stats.truncated = truncated_.exchange( 0 );
+		stats.dropped = dropped_.exchange( 0 );
+		return stats;
+	}
 };
 
 
@@ -549,3 +753,8 @@ void SocketReceiveMultiplexer::AsynchronousBreak()
 	impl_->AsynchronousBreak();
 }
 
+SocketReceiveMultiplexer::ReceiveStats SocketReceiveMultiplexer::TakeReceiveStats()
+{
+	return impl_->TakeReceiveStats();
+}
+
@@ -72,6 +72,8 @@
 
 #include <algorithm>
 
+#include <atomic>
+
 #include <stdexcept>
 
 #include <assert.h>
@@ -544,13 +546,15 @@ struct AttachedTimerListener{
 
 
 
-static bool CompareScheduledTimerCalls( 
+// the timer queue is a heap with the earliest expiry at the front
+
+static bool LaterScheduledTimerCall( 
 
         const std::pair< double, AttachedTimerListener > & lhs, const std::pair< double, AttachedTimerListener > & rhs )
 
 {
 
-    return lhs.first < rhs.first;
+    return lhs.first > rhs.first;
 
 }
 
@@ -558,6 +562,16 @@ static bool CompareScheduledTimerCalls(
 
 
 
+// Run() takes in up to MAX_PACKETS_PER_WAKEUP datagrams from a socket before
+
+// it looks at the other sockets and the timers again.
+
+static const int MAX_PACKETS_PER_WAKEUP = 64;
+
+
+
+
+
 SocketReceiveMultiplexer *multiplexerInstanceToAbortWithSigInt_ = 0;
 
 
@@ -596,6 +610,14 @@ class SocketReceiveMultiplexer::Implementation{
 
 
 
+    std::atomic< unsigned long > wakeups_;
+
+    std::atomic< unsigned long > packets_;
+
+    std::atomic< unsigned long > truncated_;
+
+
+
     double GetCurrentTimeMs() const
 
     {
@@ -610,6 +632,12 @@ public:
 
     Implementation()
 
+        : wakeups_( 0 )
+
+        , packets_( 0 )
+
+        , truncated_( 0 )
+
     {
 
         breakEvent_ = CreateEvent( NULL, FALSE, FALSE, NULL );
@@ -708,6 +736,98 @@ public:
 
 
 
+    // Hands the datagrams waiting on the socket to its listener. The socket
+
+    // is non-blocking while Run() has it.
+
+    void ReceivePackets( std::pair< PacketListener*, UdpSocket* >& socketListener, char *data )
+
+    {
+
+        for( int i = 0; i < MAX_PACKETS_PER_WAKEUP; ++i ){
+
+            struct sockaddr_in fromAddr;
+
+            socklen_t fromAddrLen = sizeof(fromAddr);
+
+
+
+            int size = recvfrom( socketListener.second->impl_->Socket(), data, SocketReceiveMultiplexer::MAX_PACKET_SIZE, 0,
+
+                        (struct sockaddr *) &fromAddr, &fromAddrLen );
+
+            if( size == SOCKET_ERROR ){
+
+                if( WSAGetLastError() != WSAEMSGSIZE )
+
+                    return;
+
+                truncated_.fetch_add( 1, std::memory_order_relaxed );
+
+                continue;
+
+            }
+
+            if( size == 0 )
+
+                continue;
+
+
+
+            IpEndpointName remoteEndpoint( ntohl( fromAddr.sin_addr.s_addr ), ntohs( fromAddr.sin_port ) );
+
+            packets_.fetch_add( 1, std::memory_order_relaxed );
+
+            socketListener.first->ProcessPacket( data, size, remoteEndpoint );
+
+            if( break_ )
+
+                return;
+
+        }
+
+    }
+
+
+
+    // Runs each expired timer at most once, so a timer that has fallen
+
+    // behind cannot keep the loop from receiving.
+
+    void RunExpiredTimers( std::vector< std::pair< double, AttachedTimerListener > >& timerQueue )
+
+    {
+
+        double currentTimeMs = GetCurrentTimeMs();
+
+
+
+        for( size_t n = timerQueue.size(); n > 0 && timerQueue.front().first <= currentTimeMs; --n ){
+
+            std::pop_heap( timerQueue.begin(), timerQueue.end(), LaterScheduledTimerCall );
+
+            std::pair< double, AttachedTimerListener >& expired = timerQueue.back();
+
+
+
+            expired.second.listener->TimerExpired();
+
+            expired.first += expired.second.periodMs;
+
+            std::push_heap( timerQueue.begin(), timerQueue.end(), LaterScheduledTimerCall );
+
+
+
+            if( break_ )
+
+                break;
+
+        }
+
+    }
+
+
+
     void Run()
 
     {
@@ -768,15 +888,13 @@ public:
 
             timerQueue_.push_back( std::make_pair( currentTimeMs + i->initialDelayMs, *i ) );
 
-        std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
+        std::make_heap( timerQueue_.begin(), timerQueue_.end(), LaterScheduledTimerCall );
 
 
 
-        const int MAX_BUFFER_SIZE = 4098;
+        // full size, so a datagram is never cut short
 
-        char *data = new char[ MAX_BUFFER_SIZE ];
-
-        IpEndpointName remoteEndpoint;
+        std::vector< char > data( SocketReceiveMultiplexer::MAX_PACKET_SIZE );
 
 
 
@@ -812,66 +930,34 @@ public:
 
 
 
-            if( waitResult != WAIT_TIMEOUT ){
-
-                for( int i = waitResult - WAIT_OBJECT_0; i < (int)socketListeners_.size(); ++i ){
+            if( waitResult != WAIT_TIMEOUT && waitResult - WAIT_OBJECT_0 < socketListeners_.size() ){
 
-                    int size = socketListeners_[i].second->ReceiveFrom( remoteEndpoint, data, MAX_BUFFER_SIZE );
+                // the wait reports the first socket with data, the others may have some too
 
-                    if( size > 0 ){
+                for( int i = waitResult - WAIT_OBJECT_0; i < (int)socketListeners_.size() && !break_; ++i )
 
-                        socketListeners_[i].first->ProcessPacket( data, size, remoteEndpoint );
+                    ReceivePackets( socketListeners_[i], &data[0] );
 
-                        if( break_ )
-
-                            break;
-
-                    }
-
-                }
+                wakeups_.fetch_add( 1, std::memory_order_relaxed );
 
             }
 
 
 
-            // execute any expired timers
-
-            currentTimeMs = GetCurrentTimeMs();
-
-            bool resort = false;
-
-            for( std::vector< std::pair< double, AttachedTimerListener > >::iterator i = timerQueue_.begin();
-
-                    i != timerQueue_.end() && i->first <= currentTimeMs; ++i ){
-
-
-
-                i->second.listener->TimerExpired();
-
-                if( break_ )
-
-                    break;
-
-
+            if( break_ )
 
-                i->first += i->second.periodMs;
+                break;
 
-                resort = true;
 
-            }
 
-            if( resort )
+            // execute any expired timers
 
-                std::sort( timerQueue_.begin(), timerQueue_.end(), CompareScheduledTimerCalls );
+            RunExpiredTimers( timerQueue_ );
 
         }
 
 
 
-        delete [] data;
-
-
-
         // free events
 
         j = 0;
@@ -916,6 +1002,26 @@ public:
 
     }
 
+
+
+    SocketReceiveMultiplexer::ReceiveStats TakeReceiveStats()
+
+    {
+
+        SocketReceiveMultiplexer::ReceiveStats stats;
+
+        stats.wakeups = wakeups_.exchange( 0 );
+
+        stats.packets = packets_.exchange( 0 );
+
+        stats.truncated = truncated_.exchange( 0 );
+
+        stats.dropped = 0;
+
+        return stats;
+
+    }
+
 };
 
 
@@ -1044,3 +1150,13 @@ void SocketReceiveMultiplexer::AsynchronousBreak()
 
 
 
+SocketReceiveMultiplexer::ReceiveStats SocketReceiveMultiplexer::TakeReceiveStats()
+
+{
+
+    return impl_->TakeReceiveStats();
+
+}
+
+
+
@@ -0,0 +1,335 @@
+/*******************************************************************************
+OscFixedMessage
+
+PURPOSE: Decodes and encodes messages of one known shape (an address, a
+         command string, then a fixed number of int32 and float arguments)
+         in a single pass, without ReceivedMessage or the argument by
+         argument OutboundPacketStream operators.  The command string may
+         be left out (a NULL command), as in TUIO 2.0 messages.
+
+NOTES:
+ReceivedMessage::Init walks the type tags once to check every argument is
+there, and ReceivedMessageArgumentStream then checks the type tag, the bounds
+and swaps the bytes again for each argument it reads.  For a message whose
+shape is known the whole check is: the size is exactly what the shape takes,
+and the address, the type tags and the command are the expected ones.  The
+type tag string is generated at compile time from the argument counts and
+compared with one memcmp; after that every field is at a known offset.
+
+Decode() returns false for anything that is not exactly that shape, without
+throwing: the caller hands those messages to ReceivedMessage, which accepts
+the same messages (and more) and reports the malformed ones.
+
+Encoding with operator<< checks the space, pushes a type tag and swaps the
+bytes for every argument, and EndMessage then moves the arguments to make
+room for the type tags.  FixedMessageTemplate lays out the address, type tags
+and command once; writing a message copies that prefix and stores the
+arguments behind it.  Int32ListMessageTemplate does the same for a command
+followed by any number of int32s (the alive message), its type tags filled
+in for the count.  Both write exactly the bytes operator<< writes.
+
+The floats are one contiguous block, so they are byte-swapped four at a time
+with SSSE3, SSE2 or NEON, whichever the compiler targets, and one by one for
+the rest.
+
+J.R.Weber <joe.weber77@gmail.com>
+*******************************************************************************/
+#ifndef INCLUDED_OSCFIXEDMESSAGE_H
+#define INCLUDED_OSCFIXEDMESSAGE_H
+
+#include <string.h>
+
+#include "OscTypes.h"
+#include "OscHostEndianness.h"
+#include "OscOutboundPacketStream.h"
+
+#if defined(OSC_HOST_LITTLE_ENDIAN)
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define OSC_FIXED_MESSAGE_SSSE3
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OSC_FIXED_MESSAGE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define OSC_FIXED_MESSAGE_NEON
+#endif
+#endif
+
+
+namespace osc{
+
+// The type tag string ',' and TAGS ('s' for a command string, or none)
+// followed by INT_COUNT 'i' and FLOAT_COUNT 'f' tags and its terminating
+// '\0', built from the counts at compile time.
+template< int INT_COUNT, int FLOAT_COUNT, char... TAGS >
+struct FixedMessageTypeTags
+    : FixedMessageTypeTags< INT_COUNT - 1, FLOAT_COUNT, TAGS..., 'i' > {};
+
+template< int FLOAT_COUNT, char... TAGS >
+struct FixedMessageTypeTags< 0, FLOAT_COUNT, TAGS... >
+    : FixedMessageTypeTags< 0, FLOAT_COUNT - 1, TAGS..., 'f' > {};
+
+template< char... TAGS >
+struct FixedMessageTypeTags< 0, 0, TAGS... >{
+    enum { LENGTH = 1 + sizeof...(TAGS) + 1,        // with the '\0'
+           SIZE = (LENGTH + 3) & ~3 };              // with the padding
+    static constexpr char value[ LENGTH ] = { ',', TAGS..., '\0' };
+};
+
+template< char... TAGS >
+constexpr char FixedMessageTypeTags< 0, 0, TAGS... >::value[];
+
+
+inline uint32 FixedMessageLoadUInt32( const char *p )
+{
+    const unsigned char *u = (const unsigned char*)p;
+    return ((uint32)u[0] << 24) | ((uint32)u[1] << 16) | ((uint32)u[2] << 8) | (uint32)u[3];
+}
+
+
+inline void FixedMessageStoreUInt32( char *p, uint32 value )
+{
+    p[0] = (char)(value >> 24);
+    p[1] = (char)(value >> 16);
+    p[2] = (char)(value >> 8);
+    p[3] = (char)value;
+}
+
+
+// Copies count 32 bit words from source to destination, from big-endian to
+// host order or back: the same swap either way.
+inline void FixedMessageCopyWords( const char *source, char *destination, int count )
+{
+    int i = 0;
+
+#if defined(OSC_FIXED_MESSAGE_SSSE3)
+    const __m128i swap = _mm_setr_epi8( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+    for( ; i + 4 <= count; i += 4 ){
+        __m128i v = _mm_loadu_si128( (const __m128i*)(source + i * 4) );
+        _mm_storeu_si128( (__m128i*)(destination + i * 4), _mm_shuffle_epi8( v, swap ) );
+    }
+#elif defined(OSC_FIXED_MESSAGE_SSE2)
+    for( ; i + 4 <= count; i += 4 ){
+        __m128i v = _mm_loadu_si128( (const __m128i*)(source + i * 4) );
+        // swap the bytes of each 16 bit half, then the halves
+        v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+        v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        _mm_storeu_si128( (__m128i*)(destination + i * 4), v );
+    }
+#elif defined(OSC_FIXED_MESSAGE_NEON)
+    for( ; i + 4 <= count; i += 4 ){
+        uint8x16_t v = vld1q_u8( (const uint8_t*)(source + i * 4) );
+        vst1q_u8( (uint8_t*)(destination + i * 4), vrev32q_u8( v ) );
+    }
+#endif
+
+    for( ; i < count; ++i ){
+#if defined(OSC_HOST_LITTLE_ENDIAN)
+        destination[i * 4] = source[i * 4 + 3];
+        destination[i * 4 + 1] = source[i * 4 + 2];
+        destination[i * 4 + 2] = source[i * 4 + 1];
+        destination[i * 4 + 3] = source[i * 4];
+#else
+        memcpy( destination + i * 4, source + i * 4, 4 );
+#endif
+    }
+}
+
+
+// Usage:
+//
+//     FixedMessage< 1, 5 > set;
+//     if( set.Decode( data, size, "/tuio/2Dcur", "set" ) )
+//         ... set.ints[0], set.floats[0] ...
+//     else
+//         ... ReceivedMessage( ... ) ...
+//
+// INT_COUNT and FLOAT_COUNT must both be at least 1.  A NULL command
+// matches a message with no command string.
+template< int INT_COUNT, int FLOAT_COUNT >
+class FixedMessage{
+public:
+    typedef FixedMessageTypeTags< INT_COUNT, FLOAT_COUNT, 's' > TypeTags;
+    typedef FixedMessageTypeTags< INT_COUNT, FLOAT_COUNT > ArgumentTypeTags;
+
+    // The size of a message of this shape with the given address and command.
+    static unsigned long Size( const char *address, const char *command )
+    {
+        unsigned long typeTagsSize = command ? (unsigned long)TypeTags::SIZE : (unsigned long)ArgumentTypeTags::SIZE;
+
+        return PaddedSize( address ) + typeTagsSize + PaddedSize( command )
+                + 4 * (INT_COUNT + FLOAT_COUNT);
+    }
+
+    // Returns false, leaving ints and floats undefined, if the message is
+    // not of this shape or has another address or command.
+    bool Decode( const char *message, unsigned long size, const char *address, const char *command )
+    {
+        unsigned long addressLength = strlen( address ) + 1,
+                      commandLength = command ? strlen( command ) + 1 : 0,
+                      addressSize = (addressLength + 3) & ~3UL,
+                      commandSize = (commandLength + 3) & ~3UL,
+                      typeTagsLength = command ? (unsigned long)TypeTags::LENGTH : (unsigned long)ArgumentTypeTags::LENGTH,
+                      typeTagsSize = command ? (unsigned long)TypeTags::SIZE : (unsigned long)ArgumentTypeTags::SIZE;
+
+        if( size != addressSize + typeTagsSize + commandSize + 4 * (INT_COUNT + FLOAT_COUNT) )
+            return false;
+
+        const char *typeTags = message + addressSize,
+                   *arguments = typeTags + typeTagsSize;
+
+        if( memcmp( message, address, addressLength ) != 0
+                || memcmp( typeTags, command ? TypeTags::value : ArgumentTypeTags::value, typeTagsLength ) != 0
+                || (command && memcmp( arguments, command, commandLength ) != 0) )
+            return false;
+
+        arguments += commandSize;
+        for( int i = 0; i < INT_COUNT; ++i )
+            ints[i] = (int32)FixedMessageLoadUInt32( arguments + i * 4 );
+
+        FixedMessageCopyWords( arguments + 4 * INT_COUNT, (char*)floats, FLOAT_COUNT );
+        return true;
+    }
+
+    int32 ints[ INT_COUNT ];
+    float floats[ FLOAT_COUNT ];
+
+private:
+    static unsigned long PaddedSize( const char *s )
+    {
+        return s ? (strlen( s ) + 1 + 3) & ~3UL : 0;
+    }
+};
+
+
+// Usage:
+//
+//     static const FixedMessageTemplate< 1, 5 > cursorSet( "/tuio/2Dcur", "set" );
+//     ...
+//     int32 id = ...;
+//     float values[5] = { ... };
+//     cursorSet.Write( packet, &id, values );
+//
+// Write() throws OutOfBufferMemoryException like operator<< does.  The
+// command may be NULL, for a message without one.
+template< int INT_COUNT, int FLOAT_COUNT >
+class FixedMessageTemplate{
+public:
+    typedef FixedMessageTypeTags< INT_COUNT, FLOAT_COUNT, 's' > TypeTags;
+    typedef FixedMessageTypeTags< INT_COUNT, FLOAT_COUNT > ArgumentTypeTags;
+
+    FixedMessageTemplate( const char *address, const char *command )
+    {
+        unsigned long addressSize = (strlen( address ) + 1 + 3) & ~3UL,
+                      commandSize = command ? (strlen( command ) + 1 + 3) & ~3UL : 0,
+                      typeTagsSize = command ? (unsigned long)TypeTags::SIZE : (unsigned long)ArgumentTypeTags::SIZE;
+
+        prefixSize_ = addressSize + typeTagsSize + commandSize;
+        prefix_ = new char[ prefixSize_ ];
+        memset( prefix_, 0, prefixSize_ );
+        strcpy( prefix_, address );
+        if( command ){
+            memcpy( prefix_ + addressSize, TypeTags::value, TypeTags::LENGTH );
+            strcpy( prefix_ + addressSize + typeTagsSize, command );
+        }else{
+            memcpy( prefix_ + addressSize, ArgumentTypeTags::value, ArgumentTypeTags::LENGTH );
+        }
+    }
+
+    ~FixedMessageTemplate() { delete [] prefix_; }
+
+    unsigned long Size() const { return prefixSize_ + 4 * (INT_COUNT + FLOAT_COUNT); }
+
+    void Write( OutboundPacketStream& packet, const int32 *ints, const float *floats ) const
+    {
+        char *message = packet.AppendMessage( Size() );
+        memcpy( message, prefix_, prefixSize_ );
+
+        char *arguments = message + prefixSize_;
+        for( int i = 0; i < INT_COUNT; ++i )
+            FixedMessageStoreUInt32( arguments + i * 4, (uint32)ints[i] );
+
+        FixedMessageCopyWords( (const char*)floats, arguments + 4 * INT_COUNT, FLOAT_COUNT );
+    }
+
+private:
+    FixedMessageTemplate( const FixedMessageTemplate& );
+    FixedMessageTemplate& operator=( const FixedMessageTemplate& );
+
+    char *prefix_;
+    unsigned long prefixSize_;
+};
+
+
+// A command (or none, if it is NULL) followed by count int32s, count only
+// known when writing.
+//
+// Usage:
+//
+//     static const Int32ListMessageTemplate alive( "/tuio/2Dcur", "alive" );
+//     ...
+//     char *ids = alive.Write( packet, count );
+//     for( ... )
+//         FixedMessageStoreUInt32( ids + i * 4, (uint32)sessionId );
+//
+// The caller must store all count values.
+class Int32ListMessageTemplate{
+public:
+    Int32ListMessageTemplate( const char *address, const char *command )
+    {
+        addressSize_ = (strlen( address ) + 1 + 3) & ~3UL;
+        commandSize_ = command ? (strlen( command ) + 1 + 3) & ~3UL : 0;
+        leadingTags_ = command ? 2 : 1;
+        address_ = new char[ addressSize_ + commandSize_ ];
+        memset( address_, 0, addressSize_ + commandSize_ );
+        strcpy( address_, address );
+        if( command )
+            strcpy( address_ + addressSize_, command );
+    }
+
+    ~Int32ListMessageTemplate() { delete [] address_; }
+
+    unsigned long Size( unsigned long count ) const
+    {
+        return addressSize_ + TypeTagsSize( count ) + commandSize_ + 4 * count;
+    }
+
+    // Returns where the count int32s go.
+    char *Write( OutboundPacketStream& packet, unsigned long count ) const
+    {
+        unsigned long typeTagsSize = TypeTagsSize( count );
+        char *message = packet.AppendMessage( Size( count ) );
+        char *typeTags = message + addressSize_;
+
+        memcpy( message, address_, addressSize_ );
+        typeTags[0] = ',';
+        typeTags[1] = 's';      // overwritten if there is no command
+        memset( typeTags + leadingTags_, 'i', count );
+        memset( typeTags + leadingTags_ + count, 0, typeTagsSize - leadingTags_ - count );
+        memcpy( typeTags + typeTagsSize, address_ + addressSize_, commandSize_ );
+
+        return typeTags + typeTagsSize + commandSize_;
+    }
+
+private:
+    Int32ListMessageTemplate( const Int32ListMessageTemplate& );
+    Int32ListMessageTemplate& operator=( const Int32ListMessageTemplate& );
+
+    unsigned long TypeTagsSize( unsigned long count ) const
+    {
+        return (leadingTags_ + count + 1 + 3) & ~3UL;
+    }
+
+    char *address_;             // the address, then the command, padded
+    unsigned long addressSize_,
+                  commandSize_,
+                  leadingTags_;         // ",s", or "," with no command
+};
+
+
+} // namespace osc
+
+
+#endif /* INCLUDED_OSCFIXEDMESSAGE_H */
@@ -820,6 +820,48 @@ OutboundPacketStream& OutboundPacketStream::operator<<( const MessageTerminator&
 
 
 
+char *OutboundPacketStream::AppendMessage( unsigned long size )
+
+{
+
+    if( IsMessageInProgress() )
+
+        throw MessageInProgressException();
+
+
+
+    unsigned long required = Size() + ((ElementSizeSlotRequired())?4:0) + size;
+
+
+
+    if( required > Capacity() )
+
+        throw OutOfBufferMemoryException();
+
+
+
+    char *message = BeginElement( messageCursor_ );
+
+
+
+    messageCursor_ = message + size;
+
+    argumentCurrent_ = messageCursor_;
+
+
+
+    EndElement( messageCursor_ );
+
+
+
+    return message;
+
+}
+
+
+
+
+
 OutboundPacketStream& OutboundPacketStream::operator<<( bool rhs )
 
 {
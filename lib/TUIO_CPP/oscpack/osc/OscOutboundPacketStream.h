@@ -226,6 +226,16 @@ public:
 
 
 
+    // Appends a message element of size bytes (a multiple of four) and
+
+    // returns where it starts; the caller writes the whole message there.
+
+    // For encoders that lay out messages of a known shape themselves.
+
+    char *AppendMessage( unsigned long size );
+
+
+
 private:
 
 